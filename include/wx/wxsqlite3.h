@@ -22,11 +22,57 @@
 #include <wx/buffer.h>
 #include <wx/hashmap.h>
 #include <wx/regex.h>
+#include <wx/stream.h>
 #include <wx/string.h>
 
 #include "wx/wxsqlite3def.h"
 #include "wx/wxsqlite3_version.h"
 
+// Detect the C++ language level, used to enable the template based interfaces
+#if defined(_MSVC_LANG)
+#define WXSQLITE3_CPLUSPLUS _MSVC_LANG
+#else
+#define WXSQLITE3_CPLUSPLUS __cplusplus
+#endif
+
+#if WXSQLITE3_CPLUSPLUS >= 201103L
+#define WXSQLITE3_HAVE_CXX11 1
+#else
+#define WXSQLITE3_HAVE_CXX11 0
+#endif
+
+#if WXSQLITE3_CPLUSPLUS >= 201703L
+#define WXSQLITE3_HAVE_CXX17 1
+#else
+#define WXSQLITE3_HAVE_CXX17 0
+#endif
+
+#if WXSQLITE3_HAVE_CXX11
+#include <exception>
+#include <limits>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#endif
+
+#if WXSQLITE3_HAVE_CXX17
+#include <optional>
+#include <string_view>
+#endif
+
+#if WXSQLITE3_HAVE_CXX17
+/// Selects the utf-8 text overloads for std::string_view, std::string and other types convertible to std::string_view (internal use only)
+/**
+* Character pointers and wxString keep using the existing overloads.
+*/
+template <typename S>
+using wxSQLite3IfUtf8Text = typename std::enable_if<std::is_convertible<const S&, std::string_view>::value &&
+                                                    !std::is_convertible<const S&, const char*>::value &&
+                                                    !std::is_same<S, wxString>::value, int>::type;
+#endif
+
 /// wxSQLite3 version string
 #define wxSQLITE3_VERSION_STRING   wxS(WXSQLITE3_VERSION_STRING)
 
@@ -141,6 +187,13 @@ enum wxSQLite3DbConfig
   WXSQLITE_DBCONFIG_ENABLE_COMMENTS       = 1022
 };
 
+/// Enumeration of the ways arrays are bound to carray parameters
+enum wxSQLite3ArrayBinding
+{
+  WXSQLITE_ARRAY_COPY   = 0, ///< SQLite makes a private copy of the array
+  WXSQLITE_ARRAY_STATIC = 1  ///< The array is used in place and must stay valid and unchanged while bound
+};
+
 #define WXSQLITE_OPEN_READONLY         0x00000001
 #define WXSQLITE_OPEN_READWRITE        0x00000002
 #define WXSQLITE_OPEN_CREATE           0x00000004
@@ -198,6 +251,89 @@ private:
   wxString m_errorMessage;    ///< SQLite3 error message associated with this exception
 };
 
+/// Result of an operation of the non-throwing API
+/**
+* The methods TryBind, TryStep, TryReset and TryExecuteUpdate of wxSQLite3Statement and
+* wxSQLite3Database report errors, like SQLITE_BUSY or constraint violations, by returning a
+* result instead of throwing a wxSQLite3Exception. A result is a compact value: in case of an
+* error it holds the error code and a copy of the raw SQLite error message (truncated to
+* MESSAGE_SIZE bytes); the error message is formatted only if GetMessage is called.
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3Result
+{
+public:
+  /// Maximum size of the raw error message in bytes
+  enum { MESSAGE_SIZE = 112 };
+
+  /// Default constructor
+  wxSQLite3Result() : m_errorCode(0), m_changes(0) { m_message[0] = '\0'; }
+
+  /// Check whether the operation succeeded
+  /**
+  * \return TRUE for the result codes SQLITE_OK, SQLITE_ROW and SQLITE_DONE, FALSE otherwise
+  */
+  bool IsOk() const;
+
+  /// Check whether a step produced a result row
+  bool HasRow() const;
+
+  /// Check whether the operation failed because the database was busy or locked
+  bool IsBusy() const;
+
+  /// Check whether the operation failed because of a constraint violation
+  bool IsConstraint() const;
+
+  /// Get the primary result code
+  int GetErrorCode() const { return (m_errorCode & 0xff); }
+
+  /// Get the extended result code
+  int GetExtendedErrorCode() const { return m_errorCode; }
+
+  /// Get the number of rows changed by TryExecuteUpdate
+  int GetChanges() const { return m_changes; }
+
+  /// Get the error message
+  /**
+  * \return the error message formatted like wxSQLite3Exception::GetMessage
+  */
+  wxString GetMessage() const;
+
+  /// Throw a wxSQLite3Exception if the operation failed
+  void ThrowIfFailed() const;
+
+  /// Get the result for a text exceeding the maximum length SQLite accepts (internal use only)
+  /**
+  * \return a result with error code SQLITE_TOOBIG
+  */
+  static wxSQLite3Result TextTooBig();
+
+private:
+  /// Record an error together with its raw message (UTF-8)
+  void SetError(int errorCode, const char* message);
+
+  int  m_errorCode;             ///< SQLite result code
+  int  m_changes;               ///< Number of rows changed
+  char m_message[MESSAGE_SIZE]; ///< Raw error message (truncated UTF-8)
+
+  friend class WXDLLIMPEXP_FWD_SQLITE3 wxSQLite3Statement;
+  friend class WXDLLIMPEXP_FWD_SQLITE3 wxSQLite3Database;
+};
+
+#if WXSQLITE3_HAVE_CXX11
+/// Get the length of a utf-8 text as passed to SQLite (internal use only)
+/**
+* SQLite takes text lengths as int; an exception (SQLITE_TOOBIG) is thrown for longer texts.
+*/
+inline int wxSQLite3TextLength(size_t length)
+{
+  if (length > (size_t) (std::numeric_limits<int>::max)())
+  {
+    wxSQLite3Result::TextTooBig().ThrowIfFailed();
+  }
+  return (int) length;
+}
+#endif
+
 /// SQL statement buffer for use with SQLite3's printf method
 class WXDLLIMPEXP_SQLITE3 wxSQLite3StatementBuffer
 {
@@ -281,6 +417,16 @@ public:
   /// Execute the user defined commit hook (internal use only)
   static void ExecLoggerHook(void* logger, int errorCode, const char* errorMsg);
 
+protected:
+  /// Dispatch a raw log message
+  /**
+  * Called on the thread that raised the message. The default implementation converts
+  * the message and calls HandleLogMessage immediately.
+  * \param errorCode SQLite error code of the message
+  * \param errorMessage log message (UTF-8)
+  */
+  virtual void DispatchLogMessage(int errorCode, const char* errorMessage);
+
 private:
   /// Copy constructor
   wxSQLite3Logger(const wxSQLite3Logger&  logger);
@@ -288,6 +434,68 @@ private:
   bool m_isActive;
 };
 
+class wxSQLite3AsyncLoggerState;
+
+/// Asynchronous SQLite logging hook
+/**
+* SQLite raises log messages on the thread executing the statement, possibly while it
+* holds locks, for example in the middle of a commit. The asynchronous logger only copies
+* the raw message into a lock-free ring buffer; the messages are converted and passed to
+* HandleLogMessage on a background thread. Frequent warnings, like the notices about
+* automatic indexes, therefore never add latency to the statements raising them.
+*
+* If the ring buffer is full, new messages are dropped and counted. Messages raised before
+* the background thread is started are kept in the ring buffer until it runs.
+*
+* Derived classes overriding HandleLogMessage should call Stop in their destructor, so that
+* no message is dispatched to a partially destroyed object.
+*
+* \note Without thread support in wxWidgets the messages are dispatched synchronously.
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3AsyncLogger : public wxSQLite3Logger
+{
+public:
+  /// Constructor
+  /**
+  * \param capacity number of messages the ring buffer can hold (rounded up to a power of 2)
+  */
+  wxSQLite3AsyncLogger(size_t capacity = 1024);
+
+  /// Destructor, stops the background thread
+  virtual ~wxSQLite3AsyncLogger();
+
+  /// Start the background thread dispatching the messages
+  /**
+  * \return TRUE if the thread was started, FALSE otherwise
+  */
+  bool Start();
+
+  /// Stop the background thread after dispatching all queued messages
+  void Stop();
+
+  /// Check whether the background thread is running
+  bool IsRunning() const;
+
+  /// Get the capacity of the ring buffer
+  size_t GetCapacity() const;
+
+  /// Get the number of messages dropped because the ring buffer was full
+  wxUint64 GetDroppedMessageCount() const;
+
+protected:
+  /// Queue a raw log message
+  virtual void DispatchLogMessage(int errorCode, const char* errorMessage);
+
+private:
+  /// Private copy constructor
+  wxSQLite3AsyncLogger(const wxSQLite3AsyncLogger& logger);
+
+  /// Private assignment constructor
+  wxSQLite3AsyncLogger& operator=(const wxSQLite3AsyncLogger& logger);
+
+  wxSQLite3AsyncLoggerState* m_state; ///< Internal state of the logger
+};
+
 
 /// Context for user defined scalar or aggregate functions
 /**
@@ -370,6 +578,34 @@ public:
   */
   wxMemoryBuffer& GetBlob(int argIndex, wxMemoryBuffer& buffer) const;
 
+  /// Get a function argument as utf-8 text without conversion
+  /**
+  * The returned pointer is only valid during the function call.
+  * \param argIndex index of the function argument. Indices start with 0.
+  * \param[out] len length of the text argument in bytes
+  * \return pointer to the utf-8 text, or NULL if the argument is NULL or argIndex is out of bounds
+  */
+  const char* GetText(int argIndex, int& len) const;
+
+  /// Get the auxiliary data associated with a function argument
+  /**
+  * SQLite keeps auxiliary data across invocations of a function as long as the
+  * argument value is a constant of the prepared statement, for example a
+  * regular expression pattern given as a literal.
+  * \param argIndex index of the function argument. Indices start with 0.
+  * \return pointer to the auxiliary data, or NULL if no data is associated
+  */
+  void* GetAuxData(int argIndex) const;
+
+  /// Associate auxiliary data with a function argument
+  /**
+  * \param argIndex index of the function argument. Indices start with 0.
+  * \param auxData pointer to the auxiliary data
+  * \param DeleteAuxData pointer to a function for deleting the auxiliary data, if it is discarded by SQLite.
+  * Note that SQLite may invoke this function before this method returns.
+  */
+  void SetAuxData(int argIndex, void* auxData, void(*DeleteAuxData)(void*));
+
   /// Get a function argument as a pointer value
   /**
   * \param argIndex index of the function argument. Indices start with 0.
@@ -1494,559 +1730,998 @@ private:
   wxSQLite3Database* m_db;
 };
 
-/// Interface for a user defined backup progress function
+class wxSQLite3ChangeFeed;
+
+/// Row change captured by the change data capture feed
 /**
+* Instances are owned by the change feed of a database connection and are valid only
+* during the invocation of wxSQLite3ChangeListener::CommitCallback.
+*
+* Database and table names are interned, that is, all changes of the same table refer
+* to the same wxString instances. Column values are passed as native value handles which
+* can be accessed with the methods of class wxSQLite3NativeValue.
 */
-class WXDLLIMPEXP_SQLITE3 wxSQLite3BackupProgress
+class WXDLLIMPEXP_SQLITE3 wxSQLite3RowChange
 {
 public:
-  /// Default constructor
-  wxSQLite3BackupProgress() {}
+  /// Get the kind of the operation
+  /**
+  * \note Incremental BLOB writes are reported as updates without new column values.
+  */
+  wxSQLite3Hook::wxUpdateType GetOperation() const { return m_operation; }
 
-  /// Virtual destructor
-  virtual ~wxSQLite3BackupProgress() {}
+  /// Get the name of the database ("main", "temp" or the name of an attached database)
+  const wxString& GetDatabaseName() const { return *m_database; }
 
-  /// Execute the backup progress callback
+  /// Get the name of the table
+  const wxString& GetTableName() const { return *m_table; }
+
+  /// Get the rowid of the row before the change (not defined for inserts and WITHOUT ROWID tables)
+  wxsqlite_int64 GetOldRowId() const { return m_oldRowId; }
+
+  /// Get the rowid of the row after the change (not defined for deletes and WITHOUT ROWID tables)
+  wxsqlite_int64 GetNewRowId() const { return m_newRowId; }
+
+  /// Get the trigger nesting depth (0 for direct changes, 1 for changes by top-level triggers, ...)
+  int GetDepth() const { return m_depth; }
+
+  /// Get the number of columns (0 if column values are not captured)
+  int GetColumnCount() const { return m_columnCount; }
+
+  /// Get the value of a column before the change
   /**
-  * This method allows an application to display information about the progress of a backup
-  * operation to the user.
-  * \param totalPages total number of pages to copy
-  * \param remainingPages number of pages remaining to be copied
-  * \return TRUE if backup should continue, FALSE otherwise
+  * \param column index of the column (0-based)
+  * \return native value handle, or NULL for inserts or if the column index is out of range
   */
-  virtual bool Progress(int WXUNUSED(totalPages), int WXUNUSED(remainingPages)) { return true; }
+  void* GetOldValue(int column) const;
+
+  /// Get the value of a column after the change
+  /**
+  * \param column index of the column (0-based)
+  * \return native value handle, or NULL for deletes or if the column index is out of range
+  */
+  void* GetNewValue(int column) const;
+
+  /// Check whether the value of a column was changed
+  /**
+  * For inserts and deletes all columns are considered as changed.
+  * \param column index of the column (0-based)
+  * \return TRUE if type or content of the column value differ, FALSE otherwise
+  */
+  bool IsColumnChanged(int column) const;
+
+private:
+  wxSQLite3Hook::wxUpdateType m_operation; ///< Kind of operation
+  const wxString* m_database;              ///< Interned database name
+  const wxString* m_table;                 ///< Interned table name
+  wxsqlite_int64  m_oldRowId;              ///< Rowid before the change
+  wxsqlite_int64  m_newRowId;              ///< Rowid after the change
+  int             m_depth;                 ///< Trigger nesting depth
+  int             m_columnCount;           ///< Number of captured columns
+  size_t          m_valueIndex;            ///< Index of the first value in the value pool of the feed
+  void* const*    m_values;                ///< Old values followed by new values
+
+  friend class wxSQLite3ChangeFeed;
 };
 
-/// Interface for a user defined collation sequence
+/// Changes of a transaction delivered by the change data capture feed
+class WXDLLIMPEXP_SQLITE3 wxSQLite3ChangeBatch
+{
+public:
+  /// Constructor (internal)
+  wxSQLite3ChangeBatch(const wxSQLite3RowChange* changes, size_t count)
+    : m_changes(changes), m_count(count) {}
+
+  /// Get the number of changes
+  size_t GetCount() const { return m_count; }
+
+  /// Get a change by index (in the order the changes were made)
+  const wxSQLite3RowChange& Item(size_t index) const { return m_changes[index]; }
+
+  /// Get a change by index (in the order the changes were made)
+  const wxSQLite3RowChange& operator[](size_t index) const { return m_changes[index]; }
+
+private:
+  const wxSQLite3RowChange* m_changes; ///< Array of changes
+  size_t                    m_count;   ///< Number of changes
+};
+
+/// Interface for a consumer of the change data capture feed
 /**
+* Changes are captured by the pre-update hook of SQLite, buffered per transaction, and
+* delivered as a single batch when the transaction commits. Nothing is delivered for
+* transactions that are rolled back.
+*
+* Changes undone by ROLLBACK TO a savepoint or by a statement failing within an explicit
+* transaction are removed from the batch (see wxSQLite3Database::SetChangeListener).
 */
-class WXDLLIMPEXP_SQLITE3 wxSQLite3Collation
+class WXDLLIMPEXP_SQLITE3 wxSQLite3ChangeListener
 {
 public:
   /// Virtual destructor
-  virtual ~wxSQLite3Collation() {}
+  virtual ~wxSQLite3ChangeListener() {}
 
-  /// Execute a comparison using a user-defined collation sequence
+  /// Decide whether the changes of a table should be captured
   /**
-  * Please refer to the SQLite documentation for further information.
-  * \param text1 first text string
-  * \param text2 second text string
-  * \return an integer < 0, = 0, or > 0 depending on whether text1 is less than, equal to, or greater than text2.
+  * The method is called only once per table, when the table is modified for the first time
+  * after the listener was registered. The default implementation captures all tables.
+  * \param database name of the database
+  * \param table name of the table
+  * \return TRUE if changes of the table should be captured, FALSE otherwise
   */
-  virtual int Compare(const wxString& text1, const wxString& text2) { return text1.Cmp(text2); }
+  virtual bool CaptureTable(const wxString& WXUNUSED(database), const wxString& WXUNUSED(table)) { return true; }
+
+  /// Receive the changes of a transaction about to be committed
+  /**
+  * The method is called from the commit hook of SQLite and must not modify the database
+  * connection. An exception thrown by the method causes the transaction to be rolled back.
+  * If the commit fails afterwards (for example, because the database is busy), the changes
+  * have been delivered nevertheless.
+  * \param changes the changes of the transaction
+  * \return TRUE to request rollback of the transaction, FALSE to continue with commit
+  */
+  virtual bool CommitCallback(const wxSQLite3ChangeBatch& changes) = 0;
 };
 
-/// Result set of a SQL query
-class WXDLLIMPEXP_SQLITE3 wxSQLite3ResultSet
+/// Latency histogram with logarithmic buckets
+/**
+* Values are recorded in nanoseconds. Similar to HDR histograms the buckets are organized
+* in powers of two, each subdivided into 16 linear sub-buckets, so that the relative error
+* of a recorded value is at most 1/16, independent of its magnitude. Values larger than
+* about 73 minutes are recorded in the highest bucket.
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3LatencyHistogram
 {
 public:
-  /// Constructor
-  wxSQLite3ResultSet();
+  /// Number of buckets
+  enum { BUCKET_COUNT = 624 };
 
-  /// Copy constructor
-  wxSQLite3ResultSet(const wxSQLite3ResultSet& resultSet);
+  /// Default constructor
+  wxSQLite3LatencyHistogram();
 
-  /// Constructor for internal use
-  wxSQLite3ResultSet(wxSQLite3DatabaseReference* db, 
-                     wxSQLite3StatementReference* stmt,
-                     bool eof, bool first = true);
+  /// Record a value
+  /**
+  * \param nanoseconds the value to be recorded
+  */
+  void Record(wxUint64 nanoseconds);
 
-  /// Assignment constructor
-  wxSQLite3ResultSet& operator=(const wxSQLite3ResultSet& resultSet);
+  /// Add the values recorded by another histogram
+  void Merge(const wxSQLite3LatencyHistogram& histogram);
 
-  /// Destructor
+  /// Remove all recorded values
+  void Reset();
+
+  /// Get the number of recorded values
+  wxUint64 GetCount() const { return m_count; }
+
+  /// Get the sum of all recorded values in nanoseconds
+  wxUint64 GetTotal() const { return m_total; }
+
+  /// Get the smallest recorded value in nanoseconds (0 if the histogram is empty)
+  wxUint64 GetMin() const { return (m_count > 0) ? m_min : 0; }
+
+  /// Get the largest recorded value in nanoseconds
+  wxUint64 GetMax() const { return m_max; }
+
+  /// Get the mean of the recorded values in nanoseconds
+  double GetMean() const { return (m_count > 0) ? (double) m_total / (double) m_count : 0.0; }
+
+  /// Get the value at a given percentile
   /**
+  * \param percentile percentile in the range 0 to 100
+  * \return value in nanoseconds, approximated by the midpoint of the bucket containing the percentile
   */
-  virtual ~wxSQLite3ResultSet();
+  wxUint64 GetPercentile(double percentile) const;
 
-  /// Get the number of columns in the result set
+  /// Get the number of values recorded in a bucket
+  wxUint64 GetBucketCount(int bucket) const { return (bucket >= 0 && bucket < BUCKET_COUNT) ? m_buckets[bucket] : 0; }
+
+  /// Get the index of the bucket a value is recorded in
+  static int GetBucketIndex(wxUint64 nanoseconds);
+
+  /// Get the lowest value recorded in a bucket
+  static wxUint64 GetBucketLowerBound(int bucket);
+
+  /// Get the highest value recorded in a bucket
+  static wxUint64 GetBucketUpperBound(int bucket);
+
+private:
+  wxUint64 m_buckets[BUCKET_COUNT]; ///< Number of values per bucket
+  wxUint64 m_count;                 ///< Number of recorded values
+  wxUint64 m_total;                 ///< Sum of recorded values
+  wxUint64 m_min;                   ///< Smallest recorded value
+  wxUint64 m_max;                   ///< Largest recorded value
+
+  friend class wxSQLite3StatementTracer;
+};
+
+/// Execution statistics of statements sharing a fingerprint
+class WXDLLIMPEXP_SQLITE3 wxSQLite3StatementProfile
+{
+public:
+  /// Default constructor
+  wxSQLite3StatementProfile() : m_executions(0), m_rows(0) {}
+
+  /// Get the fingerprint, i.e. the normalized SQL text
+  const wxString& GetFingerprint() const { return m_fingerprint; }
+
+  /// Get the number of executions
+  wxUint64 GetExecutionCount() const { return m_executions; }
+
+  /// Get the number of result rows of all executions (0 if rows are not counted)
+  wxUint64 GetRowCount() const { return m_rows; }
+
+  /// Get the histogram of the execution times
+  const wxSQLite3LatencyHistogram& GetLatency() const { return m_latency; }
+
+private:
+  wxString                  m_fingerprint; ///< Normalized SQL text
+  wxUint64                  m_executions;  ///< Number of executions
+  wxUint64                  m_rows;        ///< Number of result rows
+  wxSQLite3LatencyHistogram m_latency;     ///< Execution times
+
+  friend class wxSQLite3StatementTracer;
+};
+
+/// Statement execution exceeding the slow query threshold of a statement tracer
+class WXDLLIMPEXP_SQLITE3 wxSQLite3SlowQuery
+{
+public:
+  /// Default constructor
+  wxSQLite3SlowQuery() : m_duration(0), m_rows(0) {}
+
+  /// Get the SQL text with bound parameters expanded (possibly truncated)
+  const wxString& GetSQL() const { return m_sql; }
+
+  /// Get the fingerprint of the statement
+  const wxString& GetFingerprint() const { return m_fingerprint; }
+
+  /// Get the execution time in nanoseconds
+  wxUint64 GetDuration() const { return m_duration; }
+
+  /// Get the number of result rows (0 if rows are not counted)
+  wxUint64 GetRowCount() const { return m_rows; }
+
+  /// Get the time the execution finished
+  const wxDateTime& GetTimestamp() const { return m_timestamp; }
+
+private:
+  wxString   m_sql;         ///< Expanded SQL text
+  wxString   m_fingerprint; ///< Fingerprint of the statement
+  wxUint64   m_duration;    ///< Execution time in nanoseconds
+  wxUint64   m_rows;        ///< Number of result rows
+  wxDateTime m_timestamp;   ///< Time the execution finished
+
+  friend class wxSQLite3StatementTracer;
+};
+
+class wxSQLite3TracerState;
+
+/// Statement tracer collecting execution statistics and a log of slow queries
+/**
+* A statement tracer is attached to a database connection with
+* wxSQLite3Database::SetStatementTracer. It measures the wall time of each statement
+* execution from its first step until it is reset or finalized, and attributes it to
+* the fingerprint of the statement. The fingerprint is the SQL text with literals and
+* parameters replaced by '?', comments removed, whitespace collapsed and unquoted text
+* converted to lower case; lists of literals or parameters are collapsed to '...'.
+* The SQL text of a prepared statement is normalized only once.
+*
+* Executions exceeding the slow query threshold are recorded with their expanded SQL text
+* in a ring buffer of fixed capacity.
+*
+* A tracer instance can be attached to only one database connection at a time. The
+* statistics can be read from any thread while the connection is in use: the ring buffer
+* of slow queries is read without locking, and statistics read concurrently may lag behind
+* by the executions in progress.
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3StatementTracer
+{
+public:
+  /// Constructor
   /**
-  * \return number of columns in result set
+  * \param slowQueryThreshold execution time in microseconds from which on executions are logged as slow queries
+  * \param slowQueryCapacity maximum number of slow queries kept in the log
+  * \param maxFingerprints maximum number of distinct fingerprints; executions of further statements are accounted to the fingerprint "(other)"
+  * \param countRows flag whether the result rows should be counted (requires a callback per row)
   */
-  int GetColumnCount() const;
+  wxSQLite3StatementTracer(wxUint64 slowQueryThreshold = 100000, size_t slowQueryCapacity = 128,
+                           size_t maxFingerprints = 512, bool countRows = false);
 
-  /// Find the index of a column by name
+  /// Virtual destructor
+  virtual ~wxSQLite3StatementTracer();
+
+  /// Set the slow query threshold
   /**
-  * \param columnName name of the column
-  * \return index of the column. Indices start with 0.
+  * \param slowQueryThreshold execution time in microseconds
   */
-  int FindColumnIndex(const wxString& columnName) const;
+  void SetSlowQueryThreshold(wxUint64 slowQueryThreshold);
 
-  /// Get the name of a column
+  /// Get the slow query threshold in microseconds
+  wxUint64 GetSlowQueryThreshold() const;
+
+  /// Check whether result rows are counted
+  bool IsCountingRows() const;
+
+  /// Get the number of fingerprints
+  size_t GetProfileCount() const;
+
+  /// Get a snapshot of the statistics of a fingerprint
   /**
-  * \param columnIndex index of the column. Indices start with 0.
-  * \return column name as string
+  * \param index index of the fingerprint (in the order the fingerprints were first seen)
+  * \param profile the statistics
+  * \return TRUE if the index is valid, FALSE otherwise
   */
-  wxString GetColumnName(int columnIndex) const;
+  bool GetProfile(size_t index, wxSQLite3StatementProfile& profile) const;
 
-  /// Get the declared type of a column
+  /// Get the number of slow queries in the log
+  size_t GetSlowQueryCount() const;
+
+  /// Get a slow query from the log
   /**
-  * \param columnIndex index of the column. Indices start with 0.
-  * \return type string as specified in the table definition
+  * \param index index of the slow query (0 denotes the most recent slow query)
+  * \param query the slow query
+  * \return TRUE if the slow query could be retrieved, FALSE if the index is invalid or the
+  * entry has been overwritten in the meantime
   */
-  wxString GetDeclaredColumnType(int columnIndex) const;
+  bool GetSlowQuery(size_t index, wxSQLite3SlowQuery& query) const;
 
-  /// Get the actual type of a column
+  /// Reset statistics and slow query log
   /**
-  * \param columnIndex index of the column. Indices start with 0.
-  * \return column type as one of the values WXSQLITE_INTEGER, WXSQLITE_FLOAT, WXSQLITE_TEXT, WXSQLITE_BLOB, or WXSQLITE_NULL
+  * The reset is performed by the database connection on completion of the next statement,
+  * so that the method can safely be called from any thread.
   */
-  int GetColumnType(int columnIndex) const;
+  void Reset();
 
-  /// Get the database name of a column
+  /// Get the fingerprint of a SQL statement
+  static wxString GetFingerprint(const wxString& sql);
+
+  /// Execute the trace callback (internal)
+  static int ExecTraceCallback(unsigned int type, void* tracer, void* p, void* x);
+
+protected:
+  /// Callback invoked when a slow query has been logged
   /**
-  * \param columnIndex index of the column. Indices start with 0.
-  * \return database name the column belongs to or empty string
-  *
-  * This method is only available if SQLite has been compiled with SQLITE_ENABLE_COLUMN_METADATA defined.
+  * The method is called on the thread executing the statement and must not use the
+  * database connection. The default implementation does nothing.
+  * \param query the slow query
   */
-  wxString GetDatabaseName(int columnIndex) const;
+  virtual void OnSlowQuery(const wxSQLite3SlowQuery& WXUNUSED(query)) {}
 
-  /// Get the table name of a column
-  /**
-  * \param columnIndex index of the column. Indices start with 0.
-  * \return table name the column belongs to or empty string
-  *
-  * This method is only available if SQLite has been compiled with SQLITE_ENABLE_COLUMN_METADATA defined.
-  */
-  wxString GetTableName(int columnIndex) const;
+private:
+  /// Private copy constructor
+  wxSQLite3StatementTracer(const wxSQLite3StatementTracer& tracer);
 
-  /// Get the origin name of a column
-  /**
-  * \param columnIndex index of the column. Indices start with 0.
-  * \return origin name the column belongs to or empty string
-  *
-  * This method is only available if SQLite has been compiled with SQLITE_ENABLE_COLUMN_METADATA defined.
-  */
-  wxString GetOriginName(int columnIndex) const;
+  /// Private assignment constructor
+  wxSQLite3StatementTracer& operator=(const wxSQLite3StatementTracer& tracer);
 
-  /// Get a column as a string using the column index
-  /**
-  * \param columnIndex index of the column. Indices start with 0.
-  * \return value of the column as string
-  */
-  wxString GetAsString(int columnIndex) const;
+  wxSQLite3TracerState* m_state; ///< Internal state of the tracer
+};
 
-  /// Get a column as a string using the column name
-  /**
-  * \param columnName name of the column
-  * \return value of the column
-  */
-  wxString GetAsString(const wxString& columnName) const;
+class wxSQLite3RecorderState;
 
-  /// Get a column as an integer using the column index
+/// Recorder of database activity events for timeline analysis
+/**
+* An event recorder is attached to one or more database connections with
+* wxSQLite3Database::SetEventRecorder. While recording, it captures timed events of
+* statement preparation and execution steps, transactions, checkpoints, backup and restore
+* steps, busy waits and the invocations of the wxSQLite3Hook callbacks. The events can be
+* exported in the Chrome trace event format, which can be viewed with Perfetto
+* (https://ui.perfetto.dev) or chrome://tracing, showing one timeline per thread.
+*
+* Each thread records into its own buffer of fixed capacity without locking; when a buffer
+* is full, the oldest events of the thread are overwritten. Events should be exported after
+* recording has been stopped; events recorded concurrently with an export may be missing
+* or incomplete.
+*
+* Applications can add their own events with Record and RecordInstant to put the
+* database activity into context.
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3EventRecorder
+{
+public:
+  /// Constructor
   /**
-  * \param columnIndex index of the column. Indices start with 0.
-  * \param nullValue value to be returned in case the column is NULL
-  * \return value of the column
+  * \param eventsPerThread capacity of the event buffer of each thread
   */
-  int GetInt(int columnIndex, int nullValue = 0) const;
+  wxSQLite3EventRecorder(size_t eventsPerThread = 16384);
 
-  /// Get a column as an integer using the column name
-  /**
-  * \param columnName name of the column
-  * \param nullValue value to be returned in case the column is NULL
-  * \return value of the column
-  */
-  int GetInt(const wxString& columnName, int nullValue = 0) const;
+  /// Virtual destructor
+  virtual ~wxSQLite3EventRecorder();
 
-  /// Get a column as a 64-bit integer using the column index
-  /**
-  * \param columnIndex index of the column. Indices start with 0.
-  * \param nullValue value to be returned in case the column is NULL
-  * \return value of the column
-  */
-  wxLongLong GetInt64(int columnIndex, wxLongLong nullValue = 0) const;
+  /// Start recording
+  void Start();
 
-  /// Get a column as a 64-bit integer using the column name
-  /**
-  * \param columnName name of the column
-  * \param nullValue value to be returned in case the column is NULL
-  * \return value of the column
-  */
-  wxLongLong GetInt64(const wxString& columnName, wxLongLong nullValue = 0) const;
+  /// Stop recording
+  void Stop();
 
-  /// Get a column as a double using the column index
-  /**
-  * \param columnIndex index of the column. Indices start with 0.
-  * \param nullValue value to be returned in case the column is NULL
-  * \return value of the column
-  */
-  double GetDouble(int columnIndex, double nullValue = 0.0) const;
+  /// Check whether events are being recorded
+  bool IsRecording() const;
 
-  /// Get a column as a double using the column name
+  /// Discard all recorded events
   /**
-  * \param columnName name of the column
-  * \param nullValue value to be returned in case the column is NULL
-  * \return value of the column
+  * The event buffers of all threads are released; they are allocated again
+  * when the threads record their next event.
+  * Must not be called while events are being recorded.
   */
-  double GetDouble(const wxString& columnName, double nullValue = 0.0) const;
+  void Clear();
 
-  /// Get a column as a string using the column index
-  /**
-  * \param columnIndex index of the column. Indices start with 0.
-  * \param nullValue value to be returned in case the column is NULL
-  * \return value of the column
-  */
-  wxString GetString(int columnIndex, const wxString& nullValue = wxEmptyString) const;
+  /// Get the number of events available for export
+  size_t GetEventCount() const;
 
-  /// Get a column as a string using the column name
-  /**
-  * \param columnName name of the column
-  * \param nullValue value to be returned in case the column is NULL
-  * \return value of the column
-  */
-  wxString GetString(const wxString& columnName, const wxString& nullValue = wxEmptyString) const;
+  /// Get the number of events overwritten because a thread buffer was full
+  wxUint64 GetDroppedEventCount() const;
 
-  /// Get a column as a BLOB using the column index
+  /// Record an event with a duration
   /**
-  * \param columnIndex index of the column. Indices start with 0.
-  * \param[out] len length of the blob in bytes
-  * \return value of the column
+  * The category, name, detail name and argument name are not copied; they have to be
+  * string literals or otherwise remain valid for the lifetime of the recorder. The detail
+  * text (UTF-8) is copied and truncated if necessary.
+  * \param category category of the event
+  * \param name name of the event
+  * \param start start time as returned by GetTimestamp
+  * \param end end time as returned by GetTimestamp
+  * \param detailName name of the detail text argument, or NULL
+  * \param detail detail text, or NULL
+  * \param argName name of the numeric argument, or NULL
+  * \param argValue value of the numeric argument
   */
-  const unsigned char* GetBlob(int columnIndex, int& len) const;
+  void Record(const char* category, const char* name, wxUint64 start, wxUint64 end,
+              const char* detailName = NULL, const char* detail = NULL,
+              const char* argName = NULL, wxInt64 argValue = 0);
 
-  /// Get a column as a BLOB using the column name
+  /// Record an event without duration
   /**
-  * \param columnName name of the column
-  * \param[out] len length of the blob in bytes
-  * \return value of the column
+  * \param category category of the event
+  * \param name name of the event
+  * \param detailName name of the detail text argument, or NULL
+  * \param detail detail text, or NULL
   */
-  const unsigned char* GetBlob(const wxString& columnName, int& len) const;
+  void RecordInstant(const char* category, const char* name,
+                     const char* detailName = NULL, const char* detail = NULL);
 
-  /// Get a column as a BLOB using the column index and append to memory buffer
-  /**
-  * \param columnIndex index of the column. Indices start with 0.
-  * \param[out] buffer the memory buffer to which the BLOB value is appended
-  * \return reference to the memory buffer
-  */
-  wxMemoryBuffer& GetBlob(int columnIndex, wxMemoryBuffer& buffer) const;
+  /// Get the trace in Chrome trace event format (JSON)
+  wxString GetTraceJSON() const;
 
-  /// Get a column as a BLOB using the column index and append to memory buffer
+  /// Write the trace in Chrome trace event format to a file
   /**
-  * \param columnName name of the column
-  * \param[out] buffer the memory buffer to which the BLOB value is appended
-  * \return reference to the memory buffer
+  * \param fileName name of the trace file
+  * \return TRUE if the trace was written successfully, FALSE otherwise
   */
-  wxMemoryBuffer& GetBlob(const wxString& columnName, wxMemoryBuffer& buffer) const;
+  bool WriteTrace(const wxString& fileName) const;
 
-  /// Get a column as a date value using the column index
-  /**
-  * Date value is expected to be in format 'YYYY-MM-DD'.
-  * \param columnIndex index of the column. Indices start with 0.
-  * \return value of the column
-  */
-  wxDateTime GetDate(int columnIndex) const;
+  /// Get the current time of the monotonic clock used for events in nanoseconds
+  static wxUint64 GetTimestamp();
 
-  /// Get a column as a date value using the column name
-  /**
-  * Date value is expected to be in format 'YYYY-MM-DD'.
-  * \param columnName name of the column
-  * \return value of the column
-  */
-  wxDateTime GetDate(const wxString& columnName) const;
+private:
+  /// Private copy constructor
+  wxSQLite3EventRecorder(const wxSQLite3EventRecorder& recorder);
 
-  /// Get a column as a time value using the column index
+  /// Private assignment constructor
+  wxSQLite3EventRecorder& operator=(const wxSQLite3EventRecorder& recorder);
+
+  wxSQLite3RecorderState* m_state; ///< Internal state of the recorder
+};
+
+/// Flat profile entry of a sampling profiler
+/**
+* Aggregates the samples of all statements sharing a fingerprint (see
+* wxSQLite3StatementTracer::GetFingerprint). If wxSQLite3 has scan status support
+* (see wxSQLite3Database::HasScanStatusSupport), the samples are additionally attributed
+* to the loop of the query plan that was running, identified by its EXPLAIN QUERY PLAN text.
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3SampleProfile
+{
+public:
+  /// Maximum number of loops per fingerprint
+  enum { MAX_LOOPS = 16 };
+
+  /// Default constructor
+  wxSQLite3SampleProfile() : m_samples(0), m_loopCount(0) {}
+
+  /// Get the fingerprint, i.e. the normalized SQL text
+  const wxString& GetFingerprint() const { return m_fingerprint; }
+
+  /// Get the number of samples
+  wxUint64 GetSampleCount() const { return m_samples; }
+
+  /// Get the number of loops samples were attributed to
+  size_t GetLoopCount() const { return m_loopCount; }
+
+  /// Get the query plan text of a loop
+  const wxString& GetLoopDetail(size_t index) const { return m_loopDetails[index]; }
+
+  /// Get the number of samples attributed to a loop
+  wxUint64 GetLoopSampleCount(size_t index) const { return m_loopSamples[index]; }
+
+private:
+  wxString m_fingerprint;            ///< Normalized SQL text
+  wxUint64 m_samples;                ///< Number of samples
+  size_t   m_loopCount;              ///< Number of loops
+  wxString m_loopDetails[MAX_LOOPS]; ///< Query plan text of the loops
+  wxUint64 m_loopSamples[MAX_LOOPS]; ///< Number of samples of the loops
+
+  friend class wxSQLite3SamplingProfiler;
+};
+
+class wxSQLite3SamplerState;
+
+/// Sampling SQL profiler driven by the SQLite progress handler
+/**
+* A sampling profiler is attached to a database connection with
+* wxSQLite3Database::SetSamplingProfiler. SQLite invokes the progress handler every
+* given number of virtual machine instructions; each invocation takes a sample of the
+* statement currently running and, if scan status is supported, of the query plan loop
+* that advanced most since the previous sample of the statement. The samples are
+* aggregated into a flat profile by statement fingerprint, so that the share of samples
+* approximates the share of the CPU time spent in SQLite.
+*
+* Taking a sample costs about as much as executing a few hundred VM instructions; with
+* the default interval of 100000 instructions the overhead is well below 1%, so that the
+* profiler can be enabled on live systems. The profile can be read from any thread while
+* the connection is in use.
+*
+* The profiler occupies the progress handler of the connection. A profiler instance can be
+* attached to only one database connection at a time; it is released when it is detached
+* or the connection is closed.
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3SamplingProfiler
+{
+public:
+  /// Constructor
   /**
-  * Date value is expected to be in format 'HH:MM:SS'.
-  * \param columnIndex index of the column. Indices start with 0.
-  * \return value of the column
+  * \param interval number of virtual machine instructions between samples
+  * \param maxFingerprints maximum number of distinct fingerprints; samples of further statements are accounted to the fingerprint "(other)"
   */
-  wxDateTime GetTime(int columnIndex) const;
+  wxSQLite3SamplingProfiler(int interval = 100000, size_t maxFingerprints = 512);
 
-  /// Get a column as a time value using the column name
+  /// Virtual destructor
+  virtual ~wxSQLite3SamplingProfiler();
+
+  /// Get the number of virtual machine instructions between samples
+  int GetInterval() const;
+
+  /// Get the total number of samples
+  wxUint64 GetSampleCount() const;
+
+  /// Get the number of fingerprints
+  size_t GetProfileCount() const;
+
+  /// Get a snapshot of the samples of a fingerprint
   /**
-  * Date value is expected to be in format 'HH:MM:SS'.
-  * \param columnName name of the column
-  * \return value of the column
+  * \param index index of the fingerprint (in the order the fingerprints were first seen)
+  * \param profile the samples
+  * \return TRUE if the index is valid, FALSE otherwise
   */
-  wxDateTime GetTime(const wxString& columnName) const;
+  bool GetProfile(size_t index, wxSQLite3SampleProfile& profile) const;
 
-  /// Get a column as a date and time value using the column index
+  /// Get the flat profile as text
   /**
-  * Date value is expected to be in format 'YYYY-MM-DD HH:MM:SS'.
-  * \param columnIndex index of the column. Indices start with 0.
-  * \return value of the column
+  * Lists the fingerprints sorted by descending number of samples together with their
+  * share of all samples, each followed by the loops of its query plan.
+  * \return the flat profile
   */
-  wxDateTime GetDateTime(int columnIndex) const;
+  wxString GetReport() const;
 
-  /// Get a column as a date and time value using the column name
+  /// Reset the profile
   /**
-  * Date value is expected to be in format 'YYYY-MM-DD HH:MM:SS'.
-  * \param columnName name of the column
-  * \return value of the column
+  * The reset is performed by the database connection when taking the next sample,
+  * so that the method can safely be called from any thread.
   */
-  wxDateTime GetDateTime(const wxString& columnName) const;
+  void Reset();
 
-  /// Get a column as a timestamp value using the column index
+  /// Execute the progress handler (internal)
+  static int ExecProgressHandler(void* profiler);
+
+private:
+  /// Private copy constructor
+  wxSQLite3SamplingProfiler(const wxSQLite3SamplingProfiler& profiler);
+
+  /// Private assignment constructor
+  wxSQLite3SamplingProfiler& operator=(const wxSQLite3SamplingProfiler& profiler);
+
+  wxSQLite3SamplerState* m_state; ///< Internal state of the profiler
+
+  friend class WXDLLIMPEXP_FWD_SQLITE3 wxSQLite3Database;
+  friend class wxSQLite3DatabaseReference;
+};
+
+/// Current value and high-water mark of a status value
+struct wxSQLite3StatusValue
+{
+  wxSQLite3StatusValue() : current(0), highwater(0) {}
+
+  wxsqlite_int64 current;   ///< current value
+  wxsqlite_int64 highwater; ///< highest value since the high-water mark was reset
+};
+
+/// Snapshot of the status values of a database connection
+/**
+* The snapshot is taken with sqlite3_db_status. Counters (hits, misses, writes and spills)
+* accumulate since the connection was opened or since they were reset. The memory values
+* are given in bytes.
+*/
+struct WXDLLIMPEXP_SQLITE3 wxSQLite3DatabaseStatus
+{
+  /// Constructor
+  wxSQLite3DatabaseStatus();
+
+  /// Compute the difference to an earlier snapshot
+  /**
+  * Counters and current values of the result are the differences between this snapshot
+  * and the earlier one; high-water marks are taken from this snapshot.
+  * \param previous earlier snapshot
+  * \return the difference
+  */
+  wxSQLite3DatabaseStatus Delta(const wxSQLite3DatabaseStatus& previous) const;
+
+  /// Get the ratio of page cache hits to all page cache lookups (0 if no lookups)
+  double GetCacheHitRatio() const;
+
+  /// Get the ratio of lookaside allocations to all allocations attempted from the lookaside (0 if none)
+  double GetLookasideHitRatio() const;
+
+  wxLongLong           timestamp;         ///< time of the snapshot in milliseconds since the epoch
+  wxSQLite3StatusValue lookasideUsed;     ///< number of lookaside memory slots in use
+  wxsqlite_int64       lookasideHit;      ///< number of allocations satisfied from the lookaside
+  wxsqlite_int64       lookasideMissSize; ///< number of allocations too large for a lookaside slot
+  wxsqlite_int64       lookasideMissFull; ///< number of allocations failed because the lookaside was full
+  wxsqlite_int64       cacheUsed;         ///< memory used by the page caches
+  wxsqlite_int64       cacheUsedShared;   ///< memory used by the page caches, shared caches accounted proportionally
+  wxsqlite_int64       cacheHit;          ///< number of page cache hits
+  wxsqlite_int64       cacheMiss;         ///< number of page cache misses
+  wxsqlite_int64       cacheWrite;        ///< number of dirty pages written to disk
+  wxsqlite_int64       cacheSpill;        ///< number of dirty pages written to disk in the middle of a transaction
+  wxsqlite_int64       tempBufferSpill;   ///< number of bytes written to temporary files because memory buffers were exceeded
+  wxsqlite_int64       schemaUsed;        ///< memory used to store the schemas
+  wxsqlite_int64       stmtUsed;          ///< memory used by prepared statements
+  wxsqlite_int64       deferredForeignKeys; ///< number of outstanding deferred foreign key violations (non-zero means violations exist)
+};
+
+/// Snapshot of the process-wide status values of SQLite
+/**
+* The snapshot is taken with sqlite3_status64. The memory values are given in bytes.
+*/
+struct WXDLLIMPEXP_SQLITE3 wxSQLite3GlobalStatus
+{
+  /// Constructor
+  wxSQLite3GlobalStatus();
+
+  /// Compute the difference to an earlier snapshot
   /**
-  * Date value is expected to be in format 'YYYY-MM-DD HH:MM:SS.mmm'.
-  * \param columnIndex index of the column. Indices start with 0.
-  * \return value of the column
+  * Current values of the result are the differences between this snapshot and the earlier
+  * one; high-water marks are taken from this snapshot.
+  * \param previous earlier snapshot
+  * \return the difference
   */
-  wxDateTime GetTimestamp(int columnIndex) const;
+  wxSQLite3GlobalStatus Delta(const wxSQLite3GlobalStatus& previous) const;
 
-  /// Get a column as a timestamp value using the column name
+  wxLongLong           timestamp;         ///< time of the snapshot in milliseconds since the epoch
+  wxSQLite3StatusValue memoryUsed;        ///< memory allocated by SQLite's memory allocator
+  wxSQLite3StatusValue mallocCount;       ///< number of outstanding memory allocations
+  wxSQLite3StatusValue mallocSize;        ///< size of the largest memory allocation request (current value is meaningless)
+  wxSQLite3StatusValue pageCacheUsed;     ///< number of pages used from the page cache memory pool (SQLITE_CONFIG_PAGECACHE)
+  wxSQLite3StatusValue pageCacheOverflow; ///< memory of page cache allocations not satisfied from the memory pool
+  wxSQLite3StatusValue pageCacheSize;     ///< size of the largest page cache allocation request (current value is meaningless)
+  wxSQLite3StatusValue parserStack;       ///< deepest parser stack (current value is meaningless)
+};
+
+/// Sample of status values taken by a status sampler
+struct wxSQLite3StatusSample
+{
+  bool                    hasDatabase;   ///< flag whether the database status values are valid
+  wxSQLite3DatabaseStatus database;      ///< status of the database connection
+  wxSQLite3DatabaseStatus databaseDelta; ///< difference to the previous sample of the database connection
+  wxSQLite3GlobalStatus   global;        ///< process-wide status
+  wxSQLite3GlobalStatus   globalDelta;   ///< difference to the previous sample of the process-wide status
+};
+
+/// Interface for a sink receiving the samples of a status sampler
+class WXDLLIMPEXP_SQLITE3 wxSQLite3StatusSink
+{
+public:
+  /// Virtual destructor
+  virtual ~wxSQLite3StatusSink() {}
+
+  /// Callback receiving a sample
   /**
-  * Date value is expected to be in format 'YYYY-MM-DD HH:MM:SS.mmm'.
-  * \param columnName name of the column
-  * \return value of the column
+  * The callback is invoked on the thread of the sampler.
+  * Exceptions thrown by the callback are ignored.
+  * \param sample the status sample
   */
-  wxDateTime GetTimestamp(const wxString& columnName) const;
+  virtual void OnStatusSample(const wxSQLite3StatusSample& sample) = 0;
+};
 
-  /// Get a column as a date and time value using the column index
+class wxSQLite3StatusSamplerThread;
+
+/// Periodic sampler of status values
+/**
+* A status sampler takes snapshots of the status values of a database connection and of the
+* process-wide status values in a background thread at a fixed interval, and pushes them to a
+* sink. Sampling the database connection from another thread requires the connection to
+* be opened in serialized threading mode (the default).
+* The sampler keeps the database connection alive while it is running.
+*
+* \note The sampler is only available if wxWidgets was built with thread support.
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3StatusSampler
+{
+public:
+  /// Constructor
   /**
-  * The date/time value is expected to be stored in the database as a numeric value (i.e. int64),
-  * measured in milliseconds since 1970-01-01.
-  *
-  * \param columnIndex index of the column. Indices start with 0.
-  * \return value of the column
+  * \param sink address of the sink receiving the samples
   */
-  wxDateTime GetNumericDateTime(int columnIndex) const;
+  wxSQLite3StatusSampler(wxSQLite3StatusSink* sink);
 
-  /// Get a column as a date and time value using the column name
+  /// Destructor, stops the sampler
+  virtual ~wxSQLite3StatusSampler();
+
+  /// Start sampling
   /**
-  * The date/time value is expected to be stored in the database as a numeric value (i.e. int64),
-  * measured in milliseconds since 1970-01-01.
-  *
-  * \param columnName name of the column
-  * \return value of the column
+  * \param db database connection to be sampled (NULL to sample only the process-wide status)
+  * \param interval sampling interval in milliseconds
+  * \return TRUE if the sampler thread was started, FALSE otherwise
   */
-  wxDateTime GetNumericDateTime(const wxString& columnName) const;
+  bool Start(wxSQLite3Database* db, unsigned int interval = 1000);
 
-  /// Get a column as a date and time value using the column index
-  /**
-  * The date/time value is expected to be stored in the database as an integer value (i.e. int64),
-  * measured in seconds since 1970-01-01.
-  *
-  * \param columnIndex index of the column. Indices start with 0.
-  * \return value of the column
-  */
-  wxDateTime GetUnixDateTime(int columnIndex) const;
+  /// Stop sampling and wait for the sampler thread to terminate
+  void Stop();
 
-  /// Get a column as a date and time value using the column name
-  /**
-  * The date/time value is expected to be stored in the database as an integer value (i.e. int64),
-  * measured in seconds since 1970-01-01.
-  *
-  * \param columnName name of the column
-  * \return value of the column
-  */
-  wxDateTime GetUnixDateTime(const wxString& columnName) const;
+  /// Check whether the sampler is running
+  bool IsRunning() const;
 
-  /// Get a column as a date and time value using the column index
-  /**
-  * The date/time value is expected to be stored in the database as a Julian Day Number (i.e. double).
-  *
-  * \param columnIndex index of the column. Indices start with 0.
-  * \return value of the column
-  */
-  wxDateTime GetJulianDayNumber(int columnIndex) const;
+private:
+  /// Private copy constructor
+  wxSQLite3StatusSampler(const wxSQLite3StatusSampler& sampler);
 
-  /// Get a column as a date and time value using the column name
-  /**
-  * The date/time value is expected to be stored in the database as a Julian Day Number (i.e. double).
-  *
-  * \param columnName name of the column
-  * \return value of the column
-  */
-  wxDateTime GetJulianDayNumber(const wxString& columnName) const;
+  /// Private assignment constructor
+  wxSQLite3StatusSampler& operator=(const wxSQLite3StatusSampler& sampler);
 
-  /// Get a column as a date and time value using the column index
-  /**
-  * The date/time value is interpreted based on the type of column value.
-  *
-  * \param columnIndex index of the column. Indices start with 0.
-  * \param milliSeconds interpret integer value as milliseconds since 1970-01-01, default: false
-  * \return value of the column
-  */
-  wxDateTime GetAutomaticDateTime(int columnIndex, bool milliSeconds = false) const;
+  wxSQLite3StatusSink*          m_sink;   ///< Sink receiving the samples
+  wxSQLite3StatusSamplerThread* m_thread; ///< Sampler thread
+};
 
-  /// Get a column as a date and time value using the column name
-  /**
-  * The date/time value is interpreted based on the type of column value.
-  *
-  * \param columnName name of the column
-  * \param milliSeconds interpret integer value as milliseconds since 1970-01-01, default: false
-  * \return value of the column
-  */
-  wxDateTime GetAutomaticDateTime(const wxString& columnName, bool milliSeconds = false) const;
+/// Interface for a user defined backup progress function
+/**
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3BackupProgress
+{
+public:
+  /// Default constructor
+  wxSQLite3BackupProgress() {}
 
-  /// Get a column as a boolean value using the column index
-  /**
-  * \param columnIndex index of the column. Indices start with 0.
-  * \return value of the column
-  */
-  bool GetBool(int columnIndex) const;
+  /// Virtual destructor
+  virtual ~wxSQLite3BackupProgress() {}
 
-  /// Get a column as a boolean value using the column name
+  /// Execute the backup progress callback
   /**
-  * \param columnName name of the column
-  * \return value of the column
+  * This method allows an application to display information about the progress of a backup
+  * operation to the user.
+  * \param totalPages total number of pages to copy
+  * \param remainingPages number of pages remaining to be copied
+  * \return TRUE if backup should continue, FALSE otherwise
   */
-  bool GetBool(const wxString& columnName) const;
+  virtual bool Progress(int WXUNUSED(totalPages), int WXUNUSED(remainingPages)) { return true; }
+};
 
-  /// Check whether a column has a NULL value using the column index
-  /**
-  * \param columnIndex index of the column. Indices start with 0.
-  * \return TRUE if the value is NULL, FALSE otherwise
-  */
-  bool IsNull(int columnIndex) const;
+/// Interface for a user defined collation sequence
+/**
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3Collation
+{
+public:
+  /// Virtual destructor
+  virtual ~wxSQLite3Collation() {}
 
-  /// Check whether a column has a NULL value using the column name
+  /// Execute a comparison using a user-defined collation sequence
   /**
-  * \param columnName name of the column
-  * \return TRUE if the value is NULL, FALSE otherwise
+  * Please refer to the SQLite documentation for further information.
+  * \param text1 first text string
+  * \param text2 second text string
+  * \return an integer < 0, = 0, or > 0 depending on whether text1 is less than, equal to, or greater than text2.
   */
-  bool IsNull(const wxString& columnName) const;
+  virtual int Compare(const wxString& text1, const wxString& text2) { return text1.Cmp(text2); }
+};
 
-  /// Check whether all rows of the result set have been processed
-  /**
-  * \return TRUE if all rows of the result have been processed, FALSE otherwise
-  */
-  bool Eof() const;
+/// Interface for a user defined collation sequence operating on UTF-8 byte spans
+/**
+* In contrast to wxSQLite3Collation the strings to be compared are passed as they are
+* stored by SQLite, that is, as UTF-8 encoded byte spans which are not NUL terminated.
+* No conversion to wxString takes place, making this interface suitable for collations
+* used in sorting large result sets.
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3Utf8Collation
+{
+public:
+  /// Virtual destructor
+  virtual ~wxSQLite3Utf8Collation() {}
 
-  /// Check whether the cursor has been moved
+  /// Execute a comparison using a user-defined collation sequence
   /**
-  * \return TRUE if the cursor has been moved using method NextRow, FALSE otherwise
+  * The default implementation compares the byte spans in binary order.
+  * \param text1 first UTF-8 encoded text (not NUL terminated)
+  * \param len1 length of the first text in bytes
+  * \param text2 second UTF-8 encoded text (not NUL terminated)
+  * \param len2 length of the second text in bytes
+  * \return an integer < 0, = 0, or > 0 depending on whether text1 is less than, equal to, or greater than text2.
   */
-  bool CursorMoved() const;
+  virtual int Compare(const char* text1, size_t len1, const char* text2, size_t len2);
+};
 
-  /// Retrieve next row of the result set
-  /**
-  * Advances the cursor to the next row.
-  * On creation of the result set the cursor is positioned BEFORE the first row, i.e.
-  * the first call to this method makes the first row available for processing.
-  * \return TRUE while there are still rows to process, FALSE otherwise
-  */
-  bool NextRow();
+class wxSQLite3SortKeyCache;
 
-  /// Finalize the result set
+/// Interface for a user defined collation sequence based on sort keys
+/**
+* A sort key is a byte sequence generated from a text such that comparing the sort keys
+* of two texts bytewise yields the collation order of the texts. Generating a sort key
+* may be expensive (for example for locale-aware collations), but it has to be done
+* only once per text value.
+*
+* Comparisons look up the sort keys in a cache of recently used values, so that sorting
+* a result set generates each sort key only once, as long as the cache is large enough.
+* Alternatively, the sort keys can be materialized in an (indexed) column by registering
+* a SQL function returning the sort key as a BLOB (see wxSQLite3Database::CreateSortKeyFunction).
+*
+* \note An instance holds mutable cache state; it must not be used by several threads
+* concurrently.
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3SortKeyCollation : public wxSQLite3Utf8Collation
+{
+public:
+  /// Constructor
   /**
+  * \param cacheSize number of cached sort keys (0 disables caching)
   */
-  void Finalize();
+  wxSQLite3SortKeyCollation(size_t cacheSize = 1024);
 
-  /// Get the original SQL string for preparing the query statement
-  /**
-  * \return the original SQL string used to prepare the query statement
-  */
-  wxString GetSQL() const;
+  /// Virtual destructor
+  virtual ~wxSQLite3SortKeyCollation();
 
-  /// Get the original SQL string for preparing the query statement with expanded bound parameters
+  /// Generate the sort key of a text
   /**
-  * \return the original SQL string used to prepare the statement with expanded bound parameters
+  * \param text UTF-8 encoded text (not NUL terminated)
+  * \param len length of the text in bytes
+  * \param[out] sortKey buffer receiving the sort key; it is empty on entry
   */
-  wxString GetExpandedSQL() const;
+  virtual void GenerateSortKey(const char* text, size_t len, wxMemoryBuffer& sortKey) = 0;
 
-  /// Validate associated SQLite database and statement
-  /**
-  * \return TRUE if both, a SQLite database and a SQLite statement, are associated, FALSE otherwise
-  */
-  bool IsOk() const;
+  /// Execute a comparison by comparing the sort keys of the texts
+  virtual int Compare(const char* text1, size_t len1, const char* text2, size_t len2);
+
+  /// Discard all cached sort keys
+  void ClearCache();
 
 private:
-  /// Check the validity of the associated statement
-  void CheckStmt() const;
+  /// Private copy constructor
+  wxSQLite3SortKeyCollation(const wxSQLite3SortKeyCollation& collation);
 
-  /// Finalize the result set (internal)
-  void Finalize(wxSQLite3DatabaseReference* db,wxSQLite3StatementReference* stmt);
+  /// Private assignment constructor
+  wxSQLite3SortKeyCollation& operator=(const wxSQLite3SortKeyCollation& collation);
 
-  wxSQLite3DatabaseReference*  m_db;   ///< associated database
-  wxSQLite3StatementReference* m_stmt; ///< associated statement
-  bool  m_eof;      ///< Flag for end of result set
-  bool  m_first;    ///< Flag for first row of the result set
-  int   m_cols;     ///< Number of columns in row set
+  wxSQLite3SortKeyCache* m_cache; ///< Cache of sort keys
 };
 
-
-/// Holds the complete result set of a SQL query
-class WXDLLIMPEXP_SQLITE3 wxSQLite3Table
+/// Result set of a SQL query
+class WXDLLIMPEXP_SQLITE3 wxSQLite3ResultSet
 {
 public:
   /// Constructor
-  wxSQLite3Table();
+  wxSQLite3ResultSet();
 
-  wxSQLite3Table(const wxSQLite3Table& table);
+  /// Copy constructor
+  wxSQLite3ResultSet(const wxSQLite3ResultSet& resultSet);
 
-  wxSQLite3Table(char** results, int rows, int cols);
+  /// Constructor for internal use
+  wxSQLite3ResultSet(wxSQLite3DatabaseReference* db, 
+                     wxSQLite3StatementReference* stmt,
+                     bool eof, bool first = true);
 
-  virtual ~wxSQLite3Table();
+  /// Assignment constructor
+  wxSQLite3ResultSet& operator=(const wxSQLite3ResultSet& resultSet);
 
-  wxSQLite3Table& operator=(const wxSQLite3Table& table);
+  /// Destructor
+  /**
+  */
+  virtual ~wxSQLite3ResultSet();
 
   /// Get the number of columns in the result set
   /**
-  * \return the number of columns
+  * \return number of columns in result set
   */
   int GetColumnCount() const;
 
-  /// Get the number of rows in the result set
+  /// Find the index of a column by name
   /**
-  * \return the number of rows
+  * \param columnName name of the column
+  * \return index of the column. Indices start with 0.
   */
-  int GetRowCount() const;
+  int FindColumnIndex(const wxString& columnName) const;
 
-  /// Find the index of a column by name
+#if WXSQLITE3_HAVE_CXX17
+  /// Find the index of a column by utf-8 name (std::string_view, std::string)
   /**
+  * The column value getters accept the column name as wxString only; for utf-8 names
+  * pass the index returned by this method instead, which avoids the conversion.
   * \param columnName name of the column
-  * \return the index of the column
+  * \return index of the column. Indices start with 0.
   */
-  int FindColumnIndex(const wxString& columnName) const;
+  template <typename S, wxSQLite3IfUtf8Text<S> = 0>
+  int FindColumnIndex(const S& columnName) const
+  {
+    std::string_view name(columnName);
+    return FindColumnIndexUtf8(name.data(), name.size());
+  }
+#endif
 
   /// Get the name of a column
   /**
   * \param columnIndex index of the column. Indices start with 0.
-  * \return name of the column
+  * \return column name as string
   */
   wxString GetColumnName(int columnIndex) const;
 
-  /// Get a column as a string using the column index
+  /// Get the declared type of a column
   /**
   * \param columnIndex index of the column. Indices start with 0.
-  * \return value of the column as a string
-  *
-  * \note This method returns values of type <code>double</code>
-  * always using the point character as the decimal separator.
-  * This is SQLite default behaviour. Use method wxSQLite3Table::GetDouble
-  * to apply correct conversion from <code>string</code> to <code>double</code>.
+  * \return type string as specified in the table definition
   */
-  wxString GetAsString(int columnIndex) const;
+  wxString GetDeclaredColumnType(int columnIndex) const;
 
-  /// Get a column as a string using the column name
+  /// Get the actual type of a column
   /**
-  * \param columnName name of the column
-  * \return value of the column as a string
-  *
-  * \note This method returns values of type <code>double</code>
-  * always using the point character as the decimal separator.
-  * This is SQLite default behaviour. Use method wxSQLite3Table::GetDouble
-  * to apply correct conversion from <code>string</code> to <code>double</code>.
+  * \param columnIndex index of the column. Indices start with 0.
+  * \return column type as one of the values WXSQLITE_INTEGER, WXSQLITE_FLOAT, WXSQLITE_TEXT, WXSQLITE_BLOB, or WXSQLITE_NULL
   */
-  wxString GetAsString(const wxString& columnName) const;
+  int GetColumnType(int columnIndex) const;
 
-  /// Get a column as an integer using the column index
+  /// Get the database name of a column
   /**
   * \param columnIndex index of the column. Indices start with 0.
-  * \param nullValue value to be returned in case the column is NULL
-  * \return value of the column
+  * \return database name the column belongs to or empty string
+  *
+  * This method is only available if SQLite has been compiled with SQLITE_ENABLE_COLUMN_METADATA defined.
   */
-  int GetInt(int columnIndex, int nullValue = 0) const;
+  wxString GetDatabaseName(int columnIndex) const;
 
-  /// Get a column as an integer using the column name
+  /// Get the table name of a column
   /**
-  * \param columnName name of the column
-  * \param nullValue value to be returned in case the column is NULL
-  * \return value of the column
+  * \param columnIndex index of the column. Indices start with 0.
+  * \return table name the column belongs to or empty string
+  *
+  * This method is only available if SQLite has been compiled with SQLITE_ENABLE_COLUMN_METADATA defined.
   */
-  int GetInt(const wxString& columnName, int nullValue = 0) const;
+  wxString GetTableName(int columnIndex) const;
 
-  /// Get a column as a 64-bit integer using the column index
+  /// Get the origin name of a column
   /**
   * \param columnIndex index of the column. Indices start with 0.
-  * \param nullValue value to be returned in case the column is NULL
-  * \return value of the column
-  */
-  wxLongLong GetInt64(int columnIndex, wxLongLong nullValue = 0) const;
+  * \return origin name the column belongs to or empty string
+  *
+  * This method is only available if SQLite has been compiled with SQLITE_ENABLE_COLUMN_METADATA defined.
+  */
+  wxString GetOriginName(int columnIndex) const;
+
+  /// Get a column as a string using the column index
+  /**
+  * \param columnIndex index of the column. Indices start with 0.
+  * \return value of the column as string
+  */
+  wxString GetAsString(int columnIndex) const;
+
+  /// Get a column as a string using the column name
+  /**
+  * \param columnName name of the column
+  * \return value of the column
+  */
+  wxString GetAsString(const wxString& columnName) const;
+
+  /// Get a column as an integer using the column index
+  /**
+  * \param columnIndex index of the column. Indices start with 0.
+  * \param nullValue value to be returned in case the column is NULL
+  * \return value of the column
+  */
+  int GetInt(int columnIndex, int nullValue = 0) const;
 
   /// Get a column as an integer using the column name
   /**
@@ -2054,6 +2729,22 @@ public:
   * \param nullValue value to be returned in case the column is NULL
   * \return value of the column
   */
+  int GetInt(const wxString& columnName, int nullValue = 0) const;
+
+  /// Get a column as a 64-bit integer using the column index
+  /**
+  * \param columnIndex index of the column. Indices start with 0.
+  * \param nullValue value to be returned in case the column is NULL
+  * \return value of the column
+  */
+  wxLongLong GetInt64(int columnIndex, wxLongLong nullValue = 0) const;
+
+  /// Get a column as a 64-bit integer using the column name
+  /**
+  * \param columnName name of the column
+  * \param nullValue value to be returned in case the column is NULL
+  * \return value of the column
+  */
   wxLongLong GetInt64(const wxString& columnName, wxLongLong nullValue = 0) const;
 
   /// Get a column as a double using the column index
@@ -2088,8 +2779,41 @@ public:
   */
   wxString GetString(const wxString& columnName, const wxString& nullValue = wxEmptyString) const;
 
+  /// Get a column as a BLOB using the column index
+  /**
+  * \param columnIndex index of the column. Indices start with 0.
+  * \param[out] len length of the blob in bytes
+  * \return value of the column
+  */
+  const unsigned char* GetBlob(int columnIndex, int& len) const;
+
+  /// Get a column as a BLOB using the column name
+  /**
+  * \param columnName name of the column
+  * \param[out] len length of the blob in bytes
+  * \return value of the column
+  */
+  const unsigned char* GetBlob(const wxString& columnName, int& len) const;
+
+  /// Get a column as a BLOB using the column index and append to memory buffer
+  /**
+  * \param columnIndex index of the column. Indices start with 0.
+  * \param[out] buffer the memory buffer to which the BLOB value is appended
+  * \return reference to the memory buffer
+  */
+  wxMemoryBuffer& GetBlob(int columnIndex, wxMemoryBuffer& buffer) const;
+
+  /// Get a column as a BLOB using the column index and append to memory buffer
+  /**
+  * \param columnName name of the column
+  * \param[out] buffer the memory buffer to which the BLOB value is appended
+  * \return reference to the memory buffer
+  */
+  wxMemoryBuffer& GetBlob(const wxString& columnName, wxMemoryBuffer& buffer) const;
+
   /// Get a column as a date value using the column index
   /**
+  * Date value is expected to be in format 'YYYY-MM-DD'.
   * \param columnIndex index of the column. Indices start with 0.
   * \return value of the column
   */
@@ -2097,6 +2821,7 @@ public:
 
   /// Get a column as a date value using the column name
   /**
+  * Date value is expected to be in format 'YYYY-MM-DD'.
   * \param columnName name of the column
   * \return value of the column
   */
@@ -2104,6 +2829,7 @@ public:
 
   /// Get a column as a time value using the column index
   /**
+  * Date value is expected to be in format 'HH:MM:SS'.
   * \param columnIndex index of the column. Indices start with 0.
   * \return value of the column
   */
@@ -2111,370 +2837,2075 @@ public:
 
   /// Get a column as a time value using the column name
   /**
+  * Date value is expected to be in format 'HH:MM:SS'.
   * \param columnName name of the column
   * \return value of the column
   */
   wxDateTime GetTime(const wxString& columnName) const;
 
-  /// Get a column as a date/time value using the column index
+  /// Get a column as a date and time value using the column index
   /**
+  * Date value is expected to be in format 'YYYY-MM-DD HH:MM:SS'.
   * \param columnIndex index of the column. Indices start with 0.
   * \return value of the column
   */
   wxDateTime GetDateTime(int columnIndex) const;
 
-  /// Get a column as a date/time value using the column name
+  /// Get a column as a date and time value using the column name
   /**
+  * Date value is expected to be in format 'YYYY-MM-DD HH:MM:SS'.
   * \param columnName name of the column
   * \return value of the column
   */
   wxDateTime GetDateTime(const wxString& columnName) const;
 
-  /// Get a column as a boolean using the column index
+  /// Get a column as a timestamp value using the column index
   /**
+  * Date value is expected to be in format 'YYYY-MM-DD HH:MM:SS.mmm'.
   * \param columnIndex index of the column. Indices start with 0.
   * \return value of the column
   */
-  bool GetBool(int columnIndex) const;
+  wxDateTime GetTimestamp(int columnIndex) const;
 
-  /// Get a column as a boolean using the column name
+  /// Get a column as a timestamp value using the column name
   /**
+  * Date value is expected to be in format 'YYYY-MM-DD HH:MM:SS.mmm'.
   * \param columnName name of the column
   * \return value of the column
   */
-  bool GetBool(const wxString& columnName) const;
+  wxDateTime GetTimestamp(const wxString& columnName) const;
 
-  /// Check whether the column selected by index is a NULL value
+  /// Get a column as a date and time value using the column index
   /**
+  * The date/time value is expected to be stored in the database as a numeric value (i.e. int64),
+  * measured in milliseconds since 1970-01-01.
+  *
   * \param columnIndex index of the column. Indices start with 0.
-  * \return TRUE if the value is NULL, FALSE otherwise
+  * \return value of the column
   */
-  bool IsNull(int columnIndex) const;
+  wxDateTime GetNumericDateTime(int columnIndex) const;
 
-  /// Check whether the column selected by name is a NULL value
+  /// Get a column as a date and time value using the column name
   /**
+  * The date/time value is expected to be stored in the database as a numeric value (i.e. int64),
+  * measured in milliseconds since 1970-01-01.
+  *
   * \param columnName name of the column
-  * \return TRUE if the value is NULL, FALSE otherwise
+  * \return value of the column
   */
-  bool IsNull(const wxString& columnName) const;
+  wxDateTime GetNumericDateTime(const wxString& columnName) const;
 
-  /// Set the current row
+  /// Get a column as a date and time value using the column index
   /**
-  * \param row index of the requested row. Indices start with 0.
+  * The date/time value is expected to be stored in the database as an integer value (i.e. int64),
+  * measured in seconds since 1970-01-01.
+  *
+  * \param columnIndex index of the column. Indices start with 0.
+  * \return value of the column
   */
-  void SetRow(int row);
+  wxDateTime GetUnixDateTime(int columnIndex) const;
 
-  /// Finalize the result set
+  /// Get a column as a date and time value using the column name
   /**
+  * The date/time value is expected to be stored in the database as an integer value (i.e. int64),
+  * measured in seconds since 1970-01-01.
+  *
+  * \param columnName name of the column
+  * \return value of the column
   */
-  void Finalize();
+  wxDateTime GetUnixDateTime(const wxString& columnName) const;
 
-  /// Validate associated SQLite resultset
+  /// Get a column as a date and time value using the column index
   /**
-  * \return TRUE if SQLite resultset is associated, FALSE otherwise
+  * The date/time value is expected to be stored in the database as a Julian Day Number (i.e. double).
+  *
+  * \param columnIndex index of the column. Indices start with 0.
+  * \return value of the column
   */
-  bool IsOk() const;
-
-private:
-    /// Check for valid results
-    void CheckResults() const;
-
-    int m_cols;        ///< Number of columns
-    int m_rows;        ///< Number of rows
-    int m_currentRow;  ///< Index of the current row
-    char** m_results;  ///< SQLite3 result buffer
-};
-
+  wxDateTime GetJulianDayNumber(int columnIndex) const;
 
-/// Represents a prepared SQL statement
-class WXDLLIMPEXP_SQLITE3 wxSQLite3Statement
-{
-public:
-  /// Constructor
+  /// Get a column as a date and time value using the column name
   /**
+  * The date/time value is expected to be stored in the database as a Julian Day Number (i.e. double).
+  *
+  * \param columnName name of the column
+  * \return value of the column
   */
-  wxSQLite3Statement();
+  wxDateTime GetJulianDayNumber(const wxString& columnName) const;
 
-  /// Copy constructor
+  /// Get a column as a date and time value using the column index
   /**
+  * The date/time value is interpreted based on the type of column value.
+  *
+  * \param columnIndex index of the column. Indices start with 0.
+  * \param milliSeconds interpret integer value as milliseconds since 1970-01-01, default: false
+  * \return value of the column
   */
-  wxSQLite3Statement(const wxSQLite3Statement& statement);
+  wxDateTime GetAutomaticDateTime(int columnIndex, bool milliSeconds = false) const;
 
-  /// Assignment constructor
+  /// Get a column as a date and time value using the column name
   /**
+  * The date/time value is interpreted based on the type of column value.
+  *
+  * \param columnName name of the column
+  * \param milliSeconds interpret integer value as milliseconds since 1970-01-01, default: false
+  * \return value of the column
   */
-  wxSQLite3Statement& operator=(const wxSQLite3Statement& statement);
+  wxDateTime GetAutomaticDateTime(const wxString& columnName, bool milliSeconds = false) const;
 
-  /// Constructor (internal use only)
+  /// Get a column as a boolean value using the column index
   /**
+  * \param columnIndex index of the column. Indices start with 0.
+  * \return value of the column
   */
-  wxSQLite3Statement(wxSQLite3DatabaseReference* db, wxSQLite3StatementReference* stmt);
+  bool GetBool(int columnIndex) const;
 
-  /// Destructor
+  /// Get a column as a boolean value using the column name
   /**
+  * \param columnName name of the column
+  * \return value of the column
   */
-  virtual ~wxSQLite3Statement();
+  bool GetBool(const wxString& columnName) const;
 
-  /// Execute the database update represented by this statement
+  /// Check whether a column has a NULL value using the column index
   /**
-  * \return the number of database rows that were changed (or inserted or deleted)
+  * \param columnIndex index of the column. Indices start with 0.
+  * \return TRUE if the value is NULL, FALSE otherwise
   */
-  int ExecuteUpdate();
+  bool IsNull(int columnIndex) const;
 
-  /// Execute the query represented by this statement
+  /// Check whether a column has a NULL value using the column name
   /**
-  * \return result set instance
+  * \param columnName name of the column
+  * \return TRUE if the value is NULL, FALSE otherwise
   */
-  wxSQLite3ResultSet ExecuteQuery();
+  bool IsNull(const wxString& columnName) const;
 
-  /// Execute a scalar SQL query statement given as a wxString
+  /// Check whether all rows of the result set have been processed
   /**
-  * Allows to easily retrieve the result of queries returning a single integer result
-  * like SELECT COUNT(*) FROM table WHERE condition.
-  * \return first column of first row as an int
+  * \return TRUE if all rows of the result have been processed, FALSE otherwise
   */
-  int ExecuteScalar();
+  bool Eof() const;
 
-  /// Get the number of statement parameters
+  /// Check whether the cursor has been moved
   /**
-  * \return the number of parameters in the prepared statement
+  * \return TRUE if the cursor has been moved using method NextRow, FALSE otherwise
   */
-  int GetParamCount() const;
+  bool CursorMoved() const;
 
-  /// Get the index of a parameter with a given name
+  /// Retrieve next row of the result set
   /**
-  * \param paramName
-  * \return the index of the parameter with the given name. The name must match exactly.
-  * If there is no parameter with the given name, return 0.
+  * Advances the cursor to the next row.
+  * On creation of the result set the cursor is positioned BEFORE the first row, i.e.
+  * the first call to this method makes the first row available for processing.
+  * \return TRUE while there are still rows to process, FALSE otherwise
   */
-  int GetParamIndex(const wxString& paramName) const;
+  bool NextRow();
 
-  /// Get the name of a paramater at the given position
+  /// Finalize the result set
   /**
-  * \param paramIndex index of the parameter. The first parameter has an index of 1.
-  * \return the name of the paramIndex-th parameter in the precompiled statement.
-  * Parameters of the form ":AAA" or "$VVV" have a name which is the string ":AAA" or "$VVV".
-  * Parameters of the form "?" have no name.
   */
-  wxString GetParamName(int paramIndex) const;
+  void Finalize();
 
-  /// Bind parameter to a string value
+  /// Get the original SQL string for preparing the query statement
   /**
-  * \param paramIndex index of the parameter. The first parameter has an index of 1.
-  * \param stringValue value of the parameter
+  * \return the original SQL string used to prepare the query statement
   */
-  void Bind(int paramIndex, const wxString& stringValue);
+  wxString GetSQL() const;
 
-  /// Bind parameter to a integer value
+  /// Get the original SQL string for preparing the query statement with expanded bound parameters
   /**
-  * \param paramIndex index of the parameter. The first parameter has an index of 1.
-  * \param intValue value of the parameter
+  * \return the original SQL string used to prepare the statement with expanded bound parameters
   */
-  void Bind(int paramIndex, int intValue);
+  wxString GetExpandedSQL() const;
 
-  /// Bind parameter to a 64-bit integer value
+  /// Validate associated SQLite database and statement
   /**
-  * \param paramIndex index of the parameter. The first parameter has an index of 1.
-  * \param int64Value value of the parameter
+  * \return TRUE if both, a SQLite database and a SQLite statement, are associated, FALSE otherwise
   */
-  void Bind(int paramIndex, wxLongLong int64Value);
+  bool IsOk() const;
 
-  /// Bind parameter to a double value
+private:
+  /// Check the validity of the associated statement
+  void CheckStmt() const;
+
+  /// Find the index of a column by utf-8 name of the given length (internal use only)
+  int FindColumnIndexUtf8(const char* columnName, size_t length) const;
+
+  /// Finalize the result set (internal)
+  void Finalize(wxSQLite3DatabaseReference* db,wxSQLite3StatementReference* stmt);
+
+  wxSQLite3DatabaseReference*  m_db;   ///< associated database
+  wxSQLite3StatementReference* m_stmt; ///< associated statement
+  bool  m_eof;      ///< Flag for end of result set
+  bool  m_first;    ///< Flag for first row of the result set
+  int   m_cols;     ///< Number of columns in row set
+};
+
+
+/// Holds the complete result set of a SQL query
+class WXDLLIMPEXP_SQLITE3 wxSQLite3Table
+{
+public:
+  /// Constructor
+  wxSQLite3Table();
+
+  wxSQLite3Table(const wxSQLite3Table& table);
+
+  wxSQLite3Table(char** results, int rows, int cols);
+
+  virtual ~wxSQLite3Table();
+
+  wxSQLite3Table& operator=(const wxSQLite3Table& table);
+
+  /// Get the number of columns in the result set
   /**
-  * \param paramIndex index of the parameter. The first parameter has an index of 1.
-  * \param doubleValue value of the parameter
+  * \return the number of columns
   */
-  void Bind(int paramIndex, double doubleValue);
+  int GetColumnCount() const;
 
-  /// Bind parameter to a utf-8 character string value
+  /// Get the number of rows in the result set
   /**
-  * \param paramIndex index of the parameter. The first parameter has an index of 1.
-  * \param charValue value of the parameter
+  * \return the number of rows
   */
-  void Bind(int paramIndex, const char* charValue);
+  int GetRowCount() const;
 
-  /// Bind parameter to a BLOB value
+  /// Find the index of a column by name
   /**
-  * \param paramIndex index of the parameter. The first parameter has an index of 1.
-  * \param blobValue value of the parameter
-  * \param blobLen length of the blob in bytes
+  * \param columnName name of the column
+  * \return the index of the column
   */
-  void Bind(int paramIndex, const unsigned char* blobValue, int blobLen);
+  int FindColumnIndex(const wxString& columnName) const;
 
-  /// Bind parameter to a BLOB value
+#if WXSQLITE3_HAVE_CXX17
+  /// Find the index of a column by utf-8 name (std::string_view, std::string)
   /**
-  * \param paramIndex index of the parameter. The first parameter has an index of 1.
-  * \param blobValue value of the parameter
+  * The column value getters accept the column name as wxString only; for utf-8 names
+  * pass the index returned by this method instead, which avoids the conversion.
+  * \param columnName name of the column
+  * \return the index of the column
   */
-  void Bind(int paramIndex, const wxMemoryBuffer& blobValue);
+  template <typename S, wxSQLite3IfUtf8Text<S> = 0>
+  int FindColumnIndex(const S& columnName) const
+  {
+    std::string_view name(columnName);
+    return FindColumnIndexUtf8(name.data(), name.size());
+  }
+#endif
 
-  /// Bind parameter to a pointer value
+  /// Get the name of a column
   /**
-  * \param paramIndex index of the parameter. The first parameter has an index of 1.
-  * \param pointer pointer value of the parameter
-  * \param pointerType descriptive name of the pointer type as expected by the extension module
-  * \param DeletePointer pointer to a function for deleting the object pointed to by the pointer after use in SQLite (default: NULL)
+  * \param columnIndex index of the column. Indices start with 0.
+  * \return name of the column
   */
-  void Bind(int paramIndex, void* pointer, const wxString& pointerType, void(*DeletePointer)(void*) = NULL);
+  wxString GetColumnName(int columnIndex) const;
 
-  /// Bind parameter to a date value
+  /// Get a column as a string using the column index
   /**
-  * Only the date part is stored in format 'YYYY-MM-DD'.
-  * \param paramIndex index of the parameter. The first parameter has an index of 1.
-  * \param date value of the parameter
+  * \param columnIndex index of the column. Indices start with 0.
+  * \return value of the column as a string
+  *
+  * \note This method returns values of type <code>double</code>
+  * always using the point character as the decimal separator.
+  * This is SQLite default behaviour. Use method wxSQLite3Table::GetDouble
+  * to apply correct conversion from <code>string</code> to <code>double</code>.
   */
-  void BindDate(int paramIndex, const wxDateTime& date);
+  wxString GetAsString(int columnIndex) const;
 
-  /// Bind parameter to a time value
+  /// Get a column as a string using the column name
   /**
-  * Only the time part is stored in format 'HH:MM:SS'.
-  * \param paramIndex index of the parameter. The first parameter has an index of 1.
-  * \param time value of the parameter
+  * \param columnName name of the column
+  * \return value of the column as a string
+  *
+  * \note This method returns values of type <code>double</code>
+  * always using the point character as the decimal separator.
+  * This is SQLite default behaviour. Use method wxSQLite3Table::GetDouble
+  * to apply correct conversion from <code>string</code> to <code>double</code>.
   */
-  void BindTime(int paramIndex, const wxDateTime& time);
+  wxString GetAsString(const wxString& columnName) const;
 
-  /// Bind parameter to a date and time value
+  /// Get a column as an integer using the column index
   /**
-  * Date and time are stored in format 'YYYY-MM-DD HH:MM:SS'.
-  * \param paramIndex index of the parameter. The first parameter has an index of 1.
-  * \param datetime value of the parameter
+  * \param columnIndex index of the column. Indices start with 0.
+  * \param nullValue value to be returned in case the column is NULL
+  * \return value of the column
   */
-  void BindDateTime(int paramIndex, const wxDateTime& datetime);
+  int GetInt(int columnIndex, int nullValue = 0) const;
 
-  /// Bind parameter to a timestamp value
+  /// Get a column as an integer using the column name
   /**
-  * Timestamp is stored in format 'YYYY-MM-DD HH:MM:SS.mmm'.
-  * \param paramIndex index of the parameter. The first parameter has an index of 1.
-  * \param timestamp value of the parameter
+  * \param columnName name of the column
+  * \param nullValue value to be returned in case the column is NULL
+  * \return value of the column
   */
-  void BindTimestamp(int paramIndex, const wxDateTime& timestamp);
+  int GetInt(const wxString& columnName, int nullValue = 0) const;
 
-  /// Bind parameter to a date and time value
+  /// Get a column as a 64-bit integer using the column index
   /**
-  * The date/time value is transferred to the database as a numeric value (i.e. int64).
-  * The value is measured in milliseconds since 1970-01-01.
-  *
-  * \param paramIndex index of the parameter. The first parameter has an index of 1.
-  * \param datetime value of the parameter
+  * \param columnIndex index of the column. Indices start with 0.
+  * \param nullValue value to be returned in case the column is NULL
+  * \return value of the column
   */
-  void BindNumericDateTime(int paramIndex, const wxDateTime& datetime);
+  wxLongLong GetInt64(int columnIndex, wxLongLong nullValue = 0) const;
 
-  /// Bind parameter to a date and time value
+  /// Get a column as an integer using the column name
   /**
-  * The date/time value is transferred to the database as an integer value.
-  * The value is measured in seconds since 1970-01-01.
-  *
-  * \param paramIndex index of the parameter. The first parameter has an index of 1.
-  * \param datetime value of the parameter
+  * \param columnName name of the column
+  * \param nullValue value to be returned in case the column is NULL
+  * \return value of the column
   */
-  void BindUnixDateTime(int paramIndex, const wxDateTime& datetime);
+  wxLongLong GetInt64(const wxString& columnName, wxLongLong nullValue = 0) const;
 
-  /// Bind parameter to a date and time value
+  /// Get a column as a double using the column index
   /**
-  * The date/time value is transferred to the database as a Julian Day Number value (i.e. double).
-  *
-  * \param paramIndex index of the parameter. The first parameter has an index of 1.
-  * \param datetime value of the parameter
+  * \param columnIndex index of the column. Indices start with 0.
+  * \param nullValue value to be returned in case the column is NULL
+  * \return value of the column
   */
-  void BindJulianDayNumber(int paramIndex, const wxDateTime& datetime);
+  double GetDouble(int columnIndex, double nullValue = 0.0) const;
 
-  /// Bind parameter to a boolean value
+  /// Get a column as a double using the column name
   /**
-  * \param paramIndex index of the parameter. The first parameter has an index of 1.
-  * \param value value of the parameter
+  * \param columnName name of the column
+  * \param nullValue value to be returned in case the column is NULL
+  * \return value of the column
   */
-  void BindBool(int paramIndex, bool value);
+  double GetDouble(const wxString& columnName, double nullValue = 0.0) const;
 
-  /// Bind parameter to a NULL value
+  /// Get a column as a string using the column index
   /**
-  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param columnIndex index of the column. Indices start with 0.
+  * \param nullValue value to be returned in case the column is NULL
+  * \return value of the column
   */
-  void BindNull(int paramIndex);
+  wxString GetString(int columnIndex, const wxString& nullValue = wxEmptyString) const;
 
-  /// Bind parameter to a Zero BLOB value
+  /// Get a column as a string using the column name
   /**
-  * Space for a BLOB is reserved and filled with binary zeros for later reference
-  * through a BLOB handle.
-  *
-  * \param paramIndex index of the parameter. The first parameter has an index of 1.
-  * \param blobSize size of the BLOB
+  * \param columnName name of the column
+  * \param nullValue value to be returned in case the column is NULL
+  * \return value of the column
   */
-  void BindZeroBlob(int paramIndex, int blobSize);
+  wxString GetString(const wxString& columnName, const wxString& nullValue = wxEmptyString) const;
 
-  /// Clear all parameter bindings
+  /// Get a column as a date value using the column index
   /**
-  * Sets all the parameters in the prepared SQL statement back to NULL.
+  * \param columnIndex index of the column. Indices start with 0.
+  * \return value of the column
   */
-  void ClearBindings();
+  wxDateTime GetDate(int columnIndex) const;
 
-  /// Get the original SQL string for the prepared statement
+  /// Get a column as a date value using the column name
   /**
-  * \return the original SQL string used to prepare the statement
+  * \param columnName name of the column
+  * \return value of the column
   */
-  wxString GetSQL() const;
+  wxDateTime GetDate(const wxString& columnName) const;
+
+  /// Get a column as a time value using the column index
+  /**
+  * \param columnIndex index of the column. Indices start with 0.
+  * \return value of the column
+  */
+  wxDateTime GetTime(int columnIndex) const;
+
+  /// Get a column as a time value using the column name
+  /**
+  * \param columnName name of the column
+  * \return value of the column
+  */
+  wxDateTime GetTime(const wxString& columnName) const;
+
+  /// Get a column as a date/time value using the column index
+  /**
+  * \param columnIndex index of the column. Indices start with 0.
+  * \return value of the column
+  */
+  wxDateTime GetDateTime(int columnIndex) const;
+
+  /// Get a column as a date/time value using the column name
+  /**
+  * \param columnName name of the column
+  * \return value of the column
+  */
+  wxDateTime GetDateTime(const wxString& columnName) const;
+
+  /// Get a column as a boolean using the column index
+  /**
+  * \param columnIndex index of the column. Indices start with 0.
+  * \return value of the column
+  */
+  bool GetBool(int columnIndex) const;
+
+  /// Get a column as a boolean using the column name
+  /**
+  * \param columnName name of the column
+  * \return value of the column
+  */
+  bool GetBool(const wxString& columnName) const;
+
+  /// Check whether the column selected by index is a NULL value
+  /**
+  * \param columnIndex index of the column. Indices start with 0.
+  * \return TRUE if the value is NULL, FALSE otherwise
+  */
+  bool IsNull(int columnIndex) const;
+
+  /// Check whether the column selected by name is a NULL value
+  /**
+  * \param columnName name of the column
+  * \return TRUE if the value is NULL, FALSE otherwise
+  */
+  bool IsNull(const wxString& columnName) const;
+
+  /// Set the current row
+  /**
+  * \param row index of the requested row. Indices start with 0.
+  */
+  void SetRow(int row);
+
+  /// Finalize the result set
+  /**
+  */
+  void Finalize();
+
+  /// Validate associated SQLite resultset
+  /**
+  * \return TRUE if SQLite resultset is associated, FALSE otherwise
+  */
+  bool IsOk() const;
+
+private:
+    /// Check for valid results
+    void CheckResults() const;
+
+    /// Find the index of a column by utf-8 name of the given length (internal use only)
+    int FindColumnIndexUtf8(const char* columnName, size_t length) const;
+
+    int m_cols;        ///< Number of columns
+    int m_rows;        ///< Number of rows
+    int m_currentRow;  ///< Index of the current row
+    char** m_results;  ///< SQLite3 result buffer
+};
+
+
+/// Element of the query plan of a prepared statement with its runtime statistics
+/**
+* Elements correspond to the lines of the EXPLAIN QUERY PLAN output. Loop elements
+* (SCAN and SEARCH) carry the measured number of loops and visited rows as well as the
+* number of rows estimated by the query planner.
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3QueryPlanNode
+{
+public:
+  /// Constructor
+  wxSQLite3QueryPlanNode();
+
+  /// Get the identifier of the element
+  int GetId() const { return m_id; }
+
+  /// Get the identifier of the parent element (0 for top level elements)
+  int GetParentId() const { return m_parentId; }
+
+  /// Get the nesting depth of the element (0 for top level elements)
+  int GetDepth() const { return m_depth; }
+
+  /// Get the description of the element as shown by EXPLAIN QUERY PLAN
+  const wxString& GetDetail() const { return m_detail; }
+
+  /// Get the name of the table or index scanned by a loop element
+  const wxString& GetName() const { return m_name; }
+
+  /// Check whether the element is a loop (SCAN or SEARCH)
+  bool IsLoop() const { return m_loops >= 0; }
+
+  /// Check whether the element is a full scan of a table or index
+  bool IsFullScan() const;
+
+  /// Get the number of times the loop was started (-1 if not a loop)
+  wxsqlite_int64 GetLoopCount() const { return m_loops; }
+
+  /// Get the number of rows visited by the loop over all its runs (-1 if not a loop)
+  wxsqlite_int64 GetVisitCount() const { return m_visits; }
+
+  /// Get the number of rows per run of the loop estimated by the query planner
+  double GetEstimatedRows() const { return m_estimatedRows; }
+
+  /// Get the measured average number of rows per run of the loop
+  double GetActualRows() const { return (m_loops > 0) ? (double) m_visits / (double) m_loops : 0.0; }
+
+  /// Get the ratio between the larger and the smaller of the actual and the estimated number of rows
+  /**
+  * \return the misestimation factor (1.0 for an exact estimate or if the loop was not run)
+  */
+  double GetEstimateRatio() const;
+
+  /// Get the number of CPU cycles spent in the element (0 if not measured)
+  wxsqlite_int64 GetCycleCount() const { return m_cycles; }
+
+private:
+  int            m_id;            ///< Identifier of the element
+  int            m_parentId;      ///< Identifier of the parent element
+  int            m_depth;         ///< Nesting depth
+  wxString       m_detail;        ///< Description of the element
+  wxString       m_name;          ///< Name of the scanned table or index
+  wxsqlite_int64 m_loops;         ///< Number of loop runs
+  wxsqlite_int64 m_visits;        ///< Number of visited rows
+  double         m_estimatedRows; ///< Estimated number of rows per loop run
+  wxsqlite_int64 m_cycles;        ///< Number of CPU cycles
+
+  friend class wxSQLite3Statement;
+};
+
+/// Query plan of a prepared statement with per-loop runtime statistics
+/**
+* The statistics are taken from sqlite3_stmt_scanstatus_v2 and accumulate over all
+* executions of the statement since it was prepared or since the scan status was reset.
+* This requires SQLite to be compiled with SQLITE_ENABLE_STMT_SCANSTATUS
+* (see wxSQLite3Database::HasScanStatusSupport). The number of CPU cycles is only measured
+* on platforms providing a hardware cycle counter.
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3QueryPlan
+{
+public:
+  /// Constructor
+  wxSQLite3QueryPlan();
+
+  /// Copy constructor
+  wxSQLite3QueryPlan(const wxSQLite3QueryPlan& plan);
+
+  /// Assignment constructor
+  wxSQLite3QueryPlan& operator=(const wxSQLite3QueryPlan& plan);
+
+  /// Destructor
+  ~wxSQLite3QueryPlan();
+
+  /// Get the number of plan elements
+  size_t GetCount() const { return m_count; }
+
+  /// Get a plan element by index (in the order of the EXPLAIN QUERY PLAN output)
+  const wxSQLite3QueryPlanNode& Item(size_t index) const { return m_nodes[index]; }
+
+  /// Get a plan element by index (in the order of the EXPLAIN QUERY PLAN output)
+  const wxSQLite3QueryPlanNode& operator[](size_t index) const { return m_nodes[index]; }
+
+  /// Get the number of CPU cycles spent in the whole statement (0 if not measured)
+  wxsqlite_int64 GetCycleCount() const { return m_cycles; }
+
+  /// Check whether the plan contains a full scan of a table or index
+  bool HasFullScan() const;
+
+  /// Render the plan as indented text tree
+  /**
+  * Each element is followed by its statistics. Full scans and loops whose actual number
+  * of rows differs from the estimate by at least the given factor are marked.
+  * \param misestimateFactor factor from which on a loop is marked as misestimated
+  * \return the plan as text
+  */
+  wxString ToText(double misestimateFactor = 10.0) const;
+
+  /// Render the plan as JSON object
+  /**
+  * The object has the members "cycles" and "plan"; the latter is an array of the top level
+  * elements, each with the members "id", "detail", "name", "loops", "visits", "estimatedRows",
+  * "actualRows", "cycles", "fullScan" and "children".
+  * \return the plan as JSON text
+  */
+  wxString ToJSON() const;
+
+private:
+  wxSQLite3QueryPlanNode* m_nodes;  ///< Plan elements
+  size_t                  m_count;  ///< Number of plan elements
+  wxsqlite_int64          m_cycles; ///< Number of CPU cycles of the whole statement
+
+  friend class wxSQLite3Statement;
+};
+
+/// Interface for a listener notified about query plan changes
+/**
+* A plan change listener is registered with wxSQLite3Database::SetPlanChangeListener.
+* It is notified whenever the query plan of a persistent statement prepared with plan
+* capture enabled differs from the plan captured previously.
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3PlanChangeListener
+{
+public:
+  /// Virtual destructor
+  virtual ~wxSQLite3PlanChangeListener() {}
+
+  /// Callback invoked after the query plan of a statement changed
+  /**
+  * The callback is invoked on the thread executing the statement while the statement is
+  * being executed. It should not execute statements on the same database connection.
+  * Exceptions thrown by the callback are ignored.
+  * \param sql the SQL text of the statement
+  * \param oldPlan the fingerprint of the previous query plan
+  * \param newPlan the fingerprint of the new query plan
+  */
+  virtual void OnPlanChanged(const wxString& sql, const wxString& oldPlan, const wxString& newPlan) = 0;
+};
+
+/// Represents a prepared SQL statement
+class WXDLLIMPEXP_SQLITE3 wxSQLite3Statement
+{
+public:
+  /// Constructor
+  /**
+  */
+  wxSQLite3Statement();
+
+  /// Copy constructor
+  /**
+  */
+  wxSQLite3Statement(const wxSQLite3Statement& statement);
+
+  /// Assignment constructor
+  /**
+  */
+  wxSQLite3Statement& operator=(const wxSQLite3Statement& statement);
+
+  /// Constructor (internal use only)
+  /**
+  */
+  wxSQLite3Statement(wxSQLite3DatabaseReference* db, wxSQLite3StatementReference* stmt);
+
+  /// Destructor
+  /**
+  */
+  virtual ~wxSQLite3Statement();
+
+  /// Execute the database update represented by this statement
+  /**
+  * \return the number of database rows that were changed (or inserted or deleted)
+  */
+  int ExecuteUpdate();
+
+  /// Execute the query represented by this statement
+  /**
+  * \return result set instance
+  */
+  wxSQLite3ResultSet ExecuteQuery();
+
+  /// Execute a scalar SQL query statement given as a wxString
+  /**
+  * Allows to easily retrieve the result of queries returning a single integer result
+  * like SELECT COUNT(*) FROM table WHERE condition.
+  * \return first column of first row as an int
+  */
+  int ExecuteScalar();
+
+  /// Get the number of statement parameters
+  /**
+  * \return the number of parameters in the prepared statement
+  */
+  int GetParamCount() const;
+
+  /// Get the index of a parameter with a given name
+  /**
+  * \param paramName
+  * \return the index of the parameter with the given name. The name must match exactly.
+  * If there is no parameter with the given name, return 0.
+  */
+  int GetParamIndex(const wxString& paramName) const;
+
+  /// Get the name of a paramater at the given position
+  /**
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \return the name of the paramIndex-th parameter in the precompiled statement.
+  * Parameters of the form ":AAA" or "$VVV" have a name which is the string ":AAA" or "$VVV".
+  * Parameters of the form "?" have no name.
+  */
+  wxString GetParamName(int paramIndex) const;
+
+  /// Bind parameter to a string value
+  /**
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param stringValue value of the parameter
+  */
+  void Bind(int paramIndex, const wxString& stringValue);
+
+  /// Bind parameter to a integer value
+  /**
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param intValue value of the parameter
+  */
+  void Bind(int paramIndex, int intValue);
+
+  /// Bind parameter to a 64-bit integer value
+  /**
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param int64Value value of the parameter
+  */
+  void Bind(int paramIndex, wxLongLong int64Value);
+
+  /// Bind parameter to a double value
+  /**
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param doubleValue value of the parameter
+  */
+  void Bind(int paramIndex, double doubleValue);
+
+  /// Bind parameter to a utf-8 character string value
+  /**
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param charValue value of the parameter
+  */
+  void Bind(int paramIndex, const char* charValue);
+
+  /// Bind parameter to a BLOB value
+  /**
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param blobValue value of the parameter
+  * \param blobLen length of the blob in bytes
+  */
+  void Bind(int paramIndex, const unsigned char* blobValue, int blobLen);
+
+  /// Bind parameter to a BLOB value
+  /**
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param blobValue value of the parameter
+  */
+  void Bind(int paramIndex, const wxMemoryBuffer& blobValue);
+
+  /// Bind parameter to a pointer value
+  /**
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param pointer pointer value of the parameter
+  * \param pointerType descriptive name of the pointer type as expected by the extension module
+  * \param DeletePointer pointer to a function for deleting the object pointed to by the pointer after use in SQLite (default: NULL)
+  */
+  void Bind(int paramIndex, void* pointer, const wxString& pointerType, void(*DeletePointer)(void*) = NULL);
+
+  /// Bind parameter to an array of 32-bit integer values
+  /**
+  * The array is bound through the carray table-valued function. The parameter has to be
+  * the first and only argument of carray, as in "SELECT ... WHERE id IN carray(?)";
+  * see wxSQLite3Database::RewriteArrayParams for converting "IN (?)" lists.
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param values pointer to the array values
+  * \param count number of array elements
+  * \param binding whether SQLite copies the array or uses it in place (default: copy)
+  */
+  void BindArray(int paramIndex, const wxInt32* values, int count, wxSQLite3ArrayBinding binding = WXSQLITE_ARRAY_COPY);
+
+  /// Bind parameter to an array of 64-bit integer values
+  /**
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param values pointer to the array values
+  * \param count number of array elements
+  * \param binding whether SQLite copies the array or uses it in place (default: copy)
+  */
+  void BindArray(int paramIndex, const wxLongLong_t* values, int count, wxSQLite3ArrayBinding binding = WXSQLITE_ARRAY_COPY);
+
+  /// Bind parameter to an array of double values
+  /**
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param values pointer to the array values
+  * \param count number of array elements
+  * \param binding whether SQLite copies the array or uses it in place (default: copy)
+  */
+  void BindArray(int paramIndex, const double* values, int count, wxSQLite3ArrayBinding binding = WXSQLITE_ARRAY_COPY);
+
+  /// Bind parameter to an array of utf-8 character strings
+  /**
+  * When copied, the strings themselves are copied, too.
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param values pointer to the array of NUL terminated strings
+  * \param count number of array elements
+  * \param binding whether SQLite copies the array or uses it in place (default: copy)
+  */
+  void BindArray(int paramIndex, const char* const* values, int count, wxSQLite3ArrayBinding binding = WXSQLITE_ARRAY_COPY);
+
+  /// Bind parameter to an array of integer values
+  /**
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param values array of integer values
+  */
+  void BindArray(int paramIndex, const wxArrayInt& values);
+
+  /// Bind parameter to an array of string values
+  /**
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param values array of string values
+  */
+  void BindArray(int paramIndex, const wxArrayString& values);
+
+#if WXSQLITE3_HAVE_CXX11
+  /// Bind parameter to an array of numeric values, taking ownership of the vector
+  /**
+  * The elements (32- or 64-bit signed integers or doubles) are used in place without
+  * copying; the vector is released when SQLite no longer needs it.
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param values vector of values, moved into the statement
+  */
+  template <typename T>
+  void BindArray(int paramIndex, std::vector<T>&& values)
+  {
+    static_assert(std::is_same<T, double>::value ||
+                  (std::is_integral<T>::value && std::is_signed<T>::value && (sizeof(T) == 4 || sizeof(T) == 8)),
+                  "BindArray supports vectors of 32- or 64-bit signed integers and doubles only");
+    std::vector<T>* owned = new std::vector<T>(std::move(values));
+    int arrayType = std::is_floating_point<T>::value ? 2 : (sizeof(T) == 8) ? 1 : 0;
+    BindArrayOwned(paramIndex, owned->data(), (int) owned->size(), arrayType, &DeleteOwnedArray<T>, owned);
+  }
+#endif
+
+  /// Bind parameter to a date value
+  /**
+  * Only the date part is stored in format 'YYYY-MM-DD'.
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param date value of the parameter
+  */
+  void BindDate(int paramIndex, const wxDateTime& date);
+
+  /// Bind parameter to a time value
+  /**
+  * Only the time part is stored in format 'HH:MM:SS'.
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param time value of the parameter
+  */
+  void BindTime(int paramIndex, const wxDateTime& time);
+
+  /// Bind parameter to a date and time value
+  /**
+  * Date and time are stored in format 'YYYY-MM-DD HH:MM:SS'.
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param datetime value of the parameter
+  */
+  void BindDateTime(int paramIndex, const wxDateTime& datetime);
+
+  /// Bind parameter to a timestamp value
+  /**
+  * Timestamp is stored in format 'YYYY-MM-DD HH:MM:SS.mmm'.
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param timestamp value of the parameter
+  */
+  void BindTimestamp(int paramIndex, const wxDateTime& timestamp);
+
+  /// Bind parameter to a date and time value
+  /**
+  * The date/time value is transferred to the database as a numeric value (i.e. int64).
+  * The value is measured in milliseconds since 1970-01-01.
+  *
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param datetime value of the parameter
+  */
+  void BindNumericDateTime(int paramIndex, const wxDateTime& datetime);
+
+  /// Bind parameter to a date and time value
+  /**
+  * The date/time value is transferred to the database as an integer value.
+  * The value is measured in seconds since 1970-01-01.
+  *
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param datetime value of the parameter
+  */
+  void BindUnixDateTime(int paramIndex, const wxDateTime& datetime);
+
+  /// Bind parameter to a date and time value
+  /**
+  * The date/time value is transferred to the database as a Julian Day Number value (i.e. double).
+  *
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param datetime value of the parameter
+  */
+  void BindJulianDayNumber(int paramIndex, const wxDateTime& datetime);
+
+  /// Bind parameter to a boolean value
+  /**
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param value value of the parameter
+  */
+  void BindBool(int paramIndex, bool value);
+
+  /// Bind parameter to a NULL value
+  /**
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  */
+  void BindNull(int paramIndex);
+
+  /// Bind parameter to a Zero BLOB value
+  /**
+  * Space for a BLOB is reserved and filled with binary zeros for later reference
+  * through a BLOB handle.
+  *
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param blobSize size of the BLOB
+  */
+  void BindZeroBlob(int paramIndex, int blobSize);
+
+  /// Clear all parameter bindings
+  /**
+  * Sets all the parameters in the prepared SQL statement back to NULL.
+  */
+  void ClearBindings();
+
+  /// Get the original SQL string for the prepared statement
+  /**
+  * \return the original SQL string used to prepare the statement
+  */
+  wxString GetSQL() const;
+
+  /// Get the original SQL string for the prepared statement with expanded bound parameters
+  /**
+  * \return the original SQL string used to prepare the statement with expanded bound parameters
+  */
+  wxString GetExpandedSQL() const;
+
+  /// Reset the prepared statement
+  /**
+  * Resets the statement back to it's initial state, ready to be re-executed.
+  * Any SQL statement variables that had values bound to them retain their values.
+  */
+  void Reset();
+
+  /// Determine whether the statement is read-only
+  /**
+  * \return TRUE if the statement is read-only, FALSE otherwise
+  * \since SQLite3 version 3.7.4
+  * \note For SQLite3 version before version 3.7.4 this method returns always FALSE.
+  */
+  bool IsReadOnly() const;
+
+  /// Finalize the prepared statement
+  /**
+  */
+  void Finalize();
+
+  /// Validate associated SQLite database and statement
+  /**
+  * \return TRUE if both, a SQLite database and a SQLite statement, are associated, FALSE otherwise
+  */
+  bool IsOk() const;
+
+  /// Determine if a prepared statement has been reset
+  /**
+  * \return TRUE if the prepared statement has been stepped at least once but has not run to completion and/or has not been reset, FALSE otherwise
+  */
+  bool IsBusy() const;
+
+  /// Determine internal operation counters of the underlying prepared statement
+  /**
+  * Prepared statements maintain various counters to measure the performance of specific operations.
+  * This method allows to monitor the performance characteristics of the prepared statement.
+  * \param opCode operation code of the operation to be queried
+  * \param resetFlag flag whether the associated counter should be reset to zero (default: false)
+  * \return the counter value for the requested counter
+  */
+  int Status(wxSQLite3StatementStatus opCode, bool resetFlag = false) const;
+
+  /// Bind parameter to a utf-8 character string value of known length
+  /**
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param charValue value of the parameter (need not be NUL terminated)
+  * \param charLen length of the value in bytes
+  */
+  void BindText(int paramIndex, const char* charValue, int charLen);
+
+  /// Advance the statement to the next result row
+  /**
+  * Low level access to the statement, primarily used by wxSQLite3TypedStatement.
+  * In case of an error the statement is reset and an exception is thrown.
+  * \return TRUE if a result row is available, FALSE if the statement has run to completion
+  */
+  bool Step();
+
+  /// Bind parameter to an integer value without throwing an exception
+  /**
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param intValue value of the parameter
+  * \return the result of the operation
+  */
+  wxSQLite3Result TryBind(int paramIndex, int intValue);
+
+  /// Bind parameter to a 64-bit integer value without throwing an exception
+  /**
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param int64Value value of the parameter
+  * \return the result of the operation
+  */
+  wxSQLite3Result TryBind(int paramIndex, wxLongLong int64Value);
+
+  /// Bind parameter to a double value without throwing an exception
+  /**
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param doubleValue value of the parameter
+  * \return the result of the operation
+  */
+  wxSQLite3Result TryBind(int paramIndex, double doubleValue);
+
+  /// Bind parameter to a string value without throwing an exception
+  /**
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param stringValue value of the parameter
+  * \return the result of the operation
+  */
+  wxSQLite3Result TryBind(int paramIndex, const wxString& stringValue);
+
+  /// Bind parameter to a utf-8 character string value without throwing an exception
+  /**
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param charValue value of the parameter
+  * \param charLen length of the value in bytes, or -1 if the value is NUL terminated
+  * \return the result of the operation
+  */
+  wxSQLite3Result TryBind(int paramIndex, const char* charValue, int charLen = -1);
+
+  /// Bind parameter to a blob value without throwing an exception
+  /**
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param blobValue value of the parameter
+  * \param blobLen length of the blob in bytes
+  * \return the result of the operation
+  */
+  wxSQLite3Result TryBind(int paramIndex, const unsigned char* blobValue, int blobLen);
+
+  /// Bind parameter to a NULL value without throwing an exception
+  /**
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \return the result of the operation
+  */
+  wxSQLite3Result TryBindNull(int paramIndex);
+
+  /// Advance the statement to the next result row without throwing an exception
+  /**
+  * In case of an error the statement is reset.
+  * \return the result of the operation; HasRow tells whether a result row is available
+  */
+  wxSQLite3Result TryStep();
+
+  /// Execute the prepared statement without throwing an exception
+  /**
+  * Steps the statement to completion and resets it, like ExecuteUpdate.
+  * A statement returning rows fails with error code SQLITE_MISUSE.
+  * \return the result of the operation; GetChanges returns the number of rows changed
+  */
+  wxSQLite3Result TryExecuteUpdate();
+
+  /// Reset the prepared statement without throwing an exception
+  /**
+  * \return the result of the operation
+  */
+  wxSQLite3Result TryReset();
+
+#if WXSQLITE3_HAVE_CXX17
+  /// Bind parameter to a utf-8 string value (std::string_view, std::string)
+  /**
+  * The value is passed to SQLite without conversion.
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param stringValue value of the parameter
+  */
+  template <typename S, wxSQLite3IfUtf8Text<S> = 0>
+  void Bind(int paramIndex, const S& stringValue)
+  {
+    std::string_view text(stringValue);
+    // A default constructed view has no data, but is an empty string, not NULL
+    BindText(paramIndex, (text.data() != NULL) ? text.data() : "", wxSQLite3TextLength(text.size()));
+  }
+
+  /// Bind parameter to a utf-8 string value (std::string_view, std::string) without throwing an exception
+  /**
+  * \param paramIndex index of the parameter. The first parameter has an index of 1.
+  * \param stringValue value of the parameter
+  * \return the result of the operation
+  */
+  template <typename S, wxSQLite3IfUtf8Text<S> = 0>
+  wxSQLite3Result TryBind(int paramIndex, const S& stringValue)
+  {
+    std::string_view text(stringValue);
+    if (text.size() > (size_t) (std::numeric_limits<int>::max)())
+    {
+      return wxSQLite3Result::TextTooBig();
+    }
+    return TryBind(paramIndex, (text.data() != NULL) ? text.data() : "", (int) text.size());
+  }
+
+  /// Get the index of a parameter with a given utf-8 name (std::string_view, std::string)
+  /**
+  * \param paramName the name of the parameter
+  * \return the index of the parameter, 0 if not found
+  */
+  template <typename S, wxSQLite3IfUtf8Text<S> = 0>
+  int GetParamIndex(const S& paramName) const
+  {
+    // SQLite requires a NUL terminated name
+    return GetParamIndexUtf8(std::string(std::string_view(paramName)).c_str());
+  }
+#endif
+
+  /// Get the number of result columns of the prepared statement
+  /**
+  * \return number of columns in the result set (0 for statements not returning data)
+  */
+  int GetColumnCount() const;
+
+  /// Get the actual type of a column of the current result row
+  /**
+  * \param columnIndex index of the column. Indices start with 0.
+  * \return column type as one of the values WXSQLITE_INTEGER, WXSQLITE_FLOAT, WXSQLITE_TEXT, WXSQLITE_BLOB, or WXSQLITE_NULL
+  */
+  int GetColumnType(int columnIndex) const;
+
+  /// Get a column of the current result row as a 64-bit integer
+  /**
+  * \param columnIndex index of the column. Indices start with 0.
+  * \return column value (0 for NULL)
+  */
+  wxsqlite_int64 GetColumnInt64(int columnIndex) const;
+
+  /// Get a column of the current result row as a double
+  /**
+  * \param columnIndex index of the column. Indices start with 0.
+  * \return column value (0.0 for NULL)
+  */
+  double GetColumnDouble(int columnIndex) const;
+
+  /// Get a column of the current result row as utf-8 text
+  /**
+  * The returned pointer is valid until the statement is stepped, reset or finalized.
+  * \param columnIndex index of the column. Indices start with 0.
+  * \param len length of the text in bytes
+  * \return pointer to the utf-8 text (NULL for NULL)
+  */
+  const char* GetColumnText(int columnIndex, int& len) const;
+
+  /// Get a column of the current result row as a BLOB
+  /**
+  * The returned pointer is valid until the statement is stepped, reset or finalized.
+  * \param columnIndex index of the column. Indices start with 0.
+  * \param len length of the BLOB in bytes
+  * \return pointer to the BLOB data (NULL for NULL or empty BLOB)
+  */
+  const unsigned char* GetColumnBlob(int columnIndex, int& len) const;
+
+  /// Check the number of parameters and result columns of the prepared statement
+  /**
+  * Used by wxSQLite3TypedStatement to validate its signature once at prepare time.
+  * An exception is thrown if the counts do not match.
+  * \param paramCount expected number of parameters
+  * \param columnCount expected number of result columns
+  */
+  void CheckSignature(int paramCount, int columnCount) const;
+
+  /// Get the query plan of the prepared statement with its runtime statistics
+  /**
+  * The plan reports for each loop how often it was run, how many rows it visited and
+  * how many rows the query planner estimated, accumulated over all executions since the
+  * statement was prepared or the scan status was reset. Call this method after the
+  * statement has been executed.
+  * 
+eturn the query plan
+  */
+  wxSQLite3QueryPlan GetQueryPlan() const;
+
+  /// Reset the runtime statistics reported by GetQueryPlan
+  void ResetScanStatus();
+
+  /// Check whether the query plan of the statement is captured and monitored
+  bool IsCapturingQueryPlan() const;
+
+  /// Get the captured query plan fingerprint
+  /**
+  * The fingerprint is captured when the statement is prepared and whenever SQLite
+  * re-prepares the statement (see wxSQLite3Database::GetQueryPlanFingerprint for the format).
+  * \return the captured fingerprint (empty if plan capture is not enabled for the statement)
+  */
+  wxString GetCapturedQueryPlan() const;
+
+  /// Assert that the statement is executed with the expected query plan
+  /**
+  * The current query plan fingerprint of the statement is compared with the expected plan
+  * line by line; trailing whitespace and empty lines are ignored. Primarily intended
+  * for tests guarding against plan regressions.
+  * An exception listing the expected and the actual plan is thrown if they differ.
+  * \param expectedPlan the expected query plan fingerprint
+  */
+  void AssertQueryPlan(const wxString& expectedPlan) const;
+
+private:
+  /// Check whether the statement was re-prepared and its query plan changed
+  void CheckQueryPlan();
+
+  /// Check for valid database connection
+  void CheckDatabase() const;
+
+  /// Check for valid statement
+  void CheckStmt() const;
+
+  /// Check for valid statement (and database), recording an error in the result instead of throwing
+  bool TryCheckStmt(wxSQLite3Result& result, bool checkDatabase) const;
+
+  /// Get the index of a parameter with a given utf-8 name (internal use only)
+  int GetParamIndexUtf8(const char* paramName) const;
+
+  /// Bind an array to a carray parameter, releasing it via DeleteArray(deleteArg) (internal use only)
+  void BindArrayOwned(int paramIndex, void* values, int count, int arrayType, void(*DeleteArray)(void*), void* deleteArg);
+
+#if WXSQLITE3_HAVE_CXX11
+  /// Delete a vector owned by a carray binding (internal use only)
+  template <typename T>
+  static void DeleteOwnedArray(void* values)
+  {
+    delete static_cast<std::vector<T>*>(values);
+  }
+#endif
+
+  /// Finalize the result set (internal)
+  void Finalize(wxSQLite3DatabaseReference* db,wxSQLite3StatementReference* stmt);
+
+  wxSQLite3DatabaseReference*  m_db;    ///< associated SQLite3 database
+  wxSQLite3StatementReference* m_stmt;  ///< associated SQLite3 statement
+};
+
+/// Low level access to SQLite values and function results
+/**
+* The static methods operate directly on the SQLite value and context handles
+* passed to user defined functions. They are used by the template based function
+* registration methods of wxSQLite3Database. The value accessors can also be applied
+* to the column values delivered by the change data capture feed (see wxSQLite3RowChange).
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3NativeValue
+{
+public:
+  /// Get the type of a value (one of WXSQLITE_INTEGER, WXSQLITE_FLOAT, WXSQLITE_TEXT, WXSQLITE_BLOB, or WXSQLITE_NULL)
+  static int GetType(void* value);
+
+  /// Get a value as a 64-bit integer
+  static wxsqlite_int64 GetInt64(void* value);
+
+  /// Get a value as a double
+  static double GetDouble(void* value);
+
+  /// Get a value as utf-8 text (NULL for a NULL value)
+  static const char* GetText(void* value, int& len);
+
+  /// Get a value as a BLOB (NULL for a NULL value or an empty BLOB)
+  static const unsigned char* GetBlob(void* value, int& len);
+
+  /// Set the function result to NULL
+  static void SetResultNull(void* ctx);
+
+  /// Set the function result to a 64-bit integer
+  static void SetResultInt64(void* ctx, wxsqlite_int64 value);
+
+  /// Set the function result to a double
+  static void SetResultDouble(void* ctx, double value);
+
+  /// Set the function result to utf-8 text (a negative length denotes a NUL terminated string)
+  static void SetResultText(void* ctx, const char* value, int len);
+
+  /// Set the function result to a BLOB
+  static void SetResultBlob(void* ctx, const void* value, int len);
+
+  /// Set the function result to an error
+  static void SetResultError(void* ctx, const char* errmsg);
+
+  /// Get the user data pointer the function was registered with
+  static void* GetUserData(void* ctx);
+
+  /// Get the aggregate context of the function call (see sqlite3_aggregate_context)
+  static void* GetAggregateContext(void* ctx, int len);
+
+  /// Throw an exception for an integer value outside the range of a signed 64-bit integer (internal use only)
+  static void ThrowInt64Range();
+};
+
+#if WXSQLITE3_HAVE_CXX11
+
+/// Type list describing the parameters of a typed statement
+template <typename... Types> struct wxSQLite3Params {};
+
+/// Type list describing the result columns of a typed statement
+template <typename... Types> struct wxSQLite3Columns {};
+
+/// Compile time list of indices (internal use only)
+template <int... Indices> struct wxSQLite3IndexList {};
+
+/// Generator of a compile time list of indices 0..N-1 (internal use only)
+template <int N, int... Indices>
+struct wxSQLite3MakeIndexList : wxSQLite3MakeIndexList<N-1, N-1, Indices...> {};
+
+template <int... Indices>
+struct wxSQLite3MakeIndexList<0, Indices...>
+{
+  typedef wxSQLite3IndexList<Indices...> type;
+};
+
+/// Read-only view of a utf-8 encoded text value
+/**
+* The view refers to memory owned by SQLite; it is only valid during the
+* user defined function call resp. until the statement is stepped, reset or finalized.
+*/
+struct wxSQLite3TextView
+{
+  wxSQLite3TextView() : data(NULL), size(0) {}
+  wxSQLite3TextView(const char* textData, size_t textSize) : data(textData), size(textSize) {}
+  bool IsNull() const { return data == NULL; }
+
+  const char* data;  ///< pointer to the utf-8 text (NULL for a NULL value)
+  size_t      size;  ///< length of the text in bytes
+};
+
+/// Read-only view of a BLOB value
+/**
+* The view refers to memory owned by SQLite; it is only valid during the
+* user defined function call resp. until the statement is stepped, reset or finalized.
+*/
+struct wxSQLite3BlobView
+{
+  wxSQLite3BlobView() : data(NULL), size(0) {}
+  wxSQLite3BlobView(const unsigned char* blobData, size_t blobSize) : data(blobData), size(blobSize) {}
+  bool IsNull() const { return data == NULL; }
+
+  const unsigned char* data;  ///< pointer to the BLOB data (NULL for a NULL value)
+  size_t               size;  ///< length of the BLOB in bytes
+};
+
+/// Binding and decoding of values of a C++ type
+/**
+* Each specialization provides the static methods
+* - Bind, which binds a value to a statement parameter,
+* - Get, which decodes a column of the current result row of a statement,
+* - GetArg, which decodes an argument of a user defined function, and
+* - SetResult, which sets the result of a user defined function.
+*
+* Applications may add specializations for their own types.
+*/
+template <typename T, typename Enable = void>
+struct wxSQLite3ValueTraits;
+
+/// Value traits for integral types (except bool)
+/**
+* SQLite stores integers as signed 64-bit values. Unsigned 64-bit values
+* (like wxUint64) above the maximum signed 64-bit value can't be stored
+* without loss, and negative values can't be decoded into an unsigned
+* 64-bit type. In both cases an exception (WXSQLITE_ERROR) is thrown,
+* instead of silently wrapping the value. Applications requiring the full
+* unsigned range should store such values as text or as BLOB.
+*/
+template <typename T>
+struct wxSQLite3ValueTraits<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type>
+{
+  static void Bind(wxSQLite3Statement& stmt, int paramIndex, T value)
+  {
+    if (sizeof(T) < sizeof(int) || (sizeof(T) == sizeof(int) && std::is_signed<T>::value))
+      stmt.Bind(paramIndex, (int) value);
+    else
+      stmt.Bind(paramIndex, wxLongLong((wxLongLong_t) ToInt64(value)));
+  }
+  static T Get(const wxSQLite3Statement& stmt, int columnIndex)
+  {
+    return FromInt64(stmt.GetColumnInt64(columnIndex));
+  }
+  static T GetArg(void* value)
+  {
+    return FromInt64(wxSQLite3NativeValue::GetInt64(value));
+  }
+  static void SetResult(void* ctx, T value)
+  {
+    wxSQLite3NativeValue::SetResultInt64(ctx, ToInt64(value));
+  }
+
+private:
+  /// Flag whether the type exceeds the range of a signed 64-bit integer
+  static const bool IsWideUnsigned = std::is_unsigned<T>::value && sizeof(T) >= sizeof(wxsqlite_int64);
+
+  static wxsqlite_int64 ToInt64(T value)
+  {
+    if (IsWideUnsigned && (unsigned long long) value > (unsigned long long) (std::numeric_limits<wxsqlite_int64>::max)())
+    {
+      wxSQLite3NativeValue::ThrowInt64Range();
+    }
+    return (wxsqlite_int64) value;
+  }
+  static T FromInt64(wxsqlite_int64 value)
+  {
+    if (IsWideUnsigned && value < 0)
+    {
+      wxSQLite3NativeValue::ThrowInt64Range();
+    }
+    return (T) value;
+  }
+};
+
+/// Value traits for bool
+template <>
+struct wxSQLite3ValueTraits<bool>
+{
+  static void Bind(wxSQLite3Statement& stmt, int paramIndex, bool value)
+  {
+    stmt.Bind(paramIndex, value ? 1 : 0);
+  }
+  static bool Get(const wxSQLite3Statement& stmt, int columnIndex)
+  {
+    return stmt.GetColumnInt64(columnIndex) != 0;
+  }
+  static bool GetArg(void* value)
+  {
+    return wxSQLite3NativeValue::GetInt64(value) != 0;
+  }
+  static void SetResult(void* ctx, bool value)
+  {
+    wxSQLite3NativeValue::SetResultInt64(ctx, value ? 1 : 0);
+  }
+};
+
+/// Value traits for floating point types
+template <typename T>
+struct wxSQLite3ValueTraits<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+  static void Bind(wxSQLite3Statement& stmt, int paramIndex, T value)
+  {
+    stmt.Bind(paramIndex, (double) value);
+  }
+  static T Get(const wxSQLite3Statement& stmt, int columnIndex)
+  {
+    return (T) stmt.GetColumnDouble(columnIndex);
+  }
+  static T GetArg(void* value)
+  {
+    return (T) wxSQLite3NativeValue::GetDouble(value);
+  }
+  static void SetResult(void* ctx, T value)
+  {
+    wxSQLite3NativeValue::SetResultDouble(ctx, (double) value);
+  }
+};
+
+/// Value traits for wxLongLong
+template <>
+struct wxSQLite3ValueTraits<wxLongLong>
+{
+  static void Bind(wxSQLite3Statement& stmt, int paramIndex, const wxLongLong& value)
+  {
+    stmt.Bind(paramIndex, value);
+  }
+  static wxLongLong Get(const wxSQLite3Statement& stmt, int columnIndex)
+  {
+    return wxLongLong((wxLongLong_t) stmt.GetColumnInt64(columnIndex));
+  }
+  static wxLongLong GetArg(void* value)
+  {
+    return wxLongLong((wxLongLong_t) wxSQLite3NativeValue::GetInt64(value));
+  }
+  static void SetResult(void* ctx, const wxLongLong& value)
+  {
+    wxSQLite3NativeValue::SetResultInt64(ctx, value.GetValue());
+  }
+};
+
+/// Value traits for utf-8 encoded std::string
+template <>
+struct wxSQLite3ValueTraits<std::string>
+{
+  static void Bind(wxSQLite3Statement& stmt, int paramIndex, const std::string& value)
+  {
+    stmt.BindText(paramIndex, value.data(), wxSQLite3TextLength(value.size()));
+  }
+  static std::string Get(const wxSQLite3Statement& stmt, int columnIndex)
+  {
+    int len = 0;
+    const char* text = stmt.GetColumnText(columnIndex, len);
+    return (text != NULL) ? std::string(text, (size_t) len) : std::string();
+  }
+  static std::string GetArg(void* value)
+  {
+    int len = 0;
+    const char* text = wxSQLite3NativeValue::GetText(value, len);
+    return (text != NULL) ? std::string(text, (size_t) len) : std::string();
+  }
+  static void SetResult(void* ctx, const std::string& value)
+  {
+    wxSQLite3NativeValue::SetResultText(ctx, value.data(), wxSQLite3TextLength(value.size()));
+  }
+};
+
+/// Value traits for NUL terminated utf-8 strings
+/**
+* A decoded pointer refers to memory owned by SQLite.
+*/
+template <>
+struct wxSQLite3ValueTraits<const char*>
+{
+  static void Bind(wxSQLite3Statement& stmt, int paramIndex, const char* value)
+  {
+    if (value != NULL)
+      stmt.Bind(paramIndex, value);
+    else
+      stmt.BindNull(paramIndex);
+  }
+  static const char* GetArg(void* value)
+  {
+    int len = 0;
+    return wxSQLite3NativeValue::GetText(value, len);
+  }
+  static void SetResult(void* ctx, const char* value)
+  {
+    if (value != NULL)
+      wxSQLite3NativeValue::SetResultText(ctx, value, -1);
+    else
+      wxSQLite3NativeValue::SetResultNull(ctx);
+  }
+};
+
+/// Value traits for wxString
+template <>
+struct wxSQLite3ValueTraits<wxString>
+{
+  static void Bind(wxSQLite3Statement& stmt, int paramIndex, const wxString& value)
+  {
+    stmt.Bind(paramIndex, value);
+  }
+  static wxString Get(const wxSQLite3Statement& stmt, int columnIndex)
+  {
+    int len = 0;
+    const char* text = stmt.GetColumnText(columnIndex, len);
+    return (text != NULL) ? wxString::FromUTF8(text, (size_t) len) : wxString();
+  }
+  static wxString GetArg(void* value)
+  {
+    int len = 0;
+    const char* text = wxSQLite3NativeValue::GetText(value, len);
+    return (text != NULL) ? wxString::FromUTF8(text, (size_t) len) : wxString();
+  }
+  static void SetResult(void* ctx, const wxString& value)
+  {
+    wxCharBuffer strValue = value.ToUTF8();
+    const char* localValue = strValue;
+    wxSQLite3NativeValue::SetResultText(ctx, localValue, -1);
+  }
+};
+
+/// Value traits for utf-8 text views
+template <>
+struct wxSQLite3ValueTraits<wxSQLite3TextView>
+{
+  static void Bind(wxSQLite3Statement& stmt, int paramIndex, const wxSQLite3TextView& value)
+  {
+    if (value.data != NULL)
+      stmt.BindText(paramIndex, value.data, (int) value.size);
+    else
+      stmt.BindNull(paramIndex);
+  }
+  static wxSQLite3TextView Get(const wxSQLite3Statement& stmt, int columnIndex)
+  {
+    int len = 0;
+    const char* text = stmt.GetColumnText(columnIndex, len);
+    return wxSQLite3TextView(text, (size_t) len);
+  }
+  static wxSQLite3TextView GetArg(void* value)
+  {
+    int len = 0;
+    const char* text = wxSQLite3NativeValue::GetText(value, len);
+    return wxSQLite3TextView(text, (size_t) len);
+  }
+  static void SetResult(void* ctx, const wxSQLite3TextView& value)
+  {
+    if (value.data != NULL)
+      wxSQLite3NativeValue::SetResultText(ctx, value.data, (int) value.size);
+    else
+      wxSQLite3NativeValue::SetResultNull(ctx);
+  }
+};
+
+/// Value traits for BLOB views
+template <>
+struct wxSQLite3ValueTraits<wxSQLite3BlobView>
+{
+  static void Bind(wxSQLite3Statement& stmt, int paramIndex, const wxSQLite3BlobView& value)
+  {
+    if (value.data != NULL)
+      stmt.Bind(paramIndex, value.data, (int) value.size);
+    else
+      stmt.BindNull(paramIndex);
+  }
+  static wxSQLite3BlobView Get(const wxSQLite3Statement& stmt, int columnIndex)
+  {
+    int len = 0;
+    const unsigned char* blob = stmt.GetColumnBlob(columnIndex, len);
+    // SQLite returns NULL for an empty BLOB, too; keep it distinguishable from a NULL value
+    if (blob == NULL && stmt.GetColumnType(columnIndex) != WXSQLITE_NULL)
+      blob = (const unsigned char*) "";
+    return wxSQLite3BlobView(blob, (size_t) len);
+  }
+  static wxSQLite3BlobView GetArg(void* value)
+  {
+    int len = 0;
+    const unsigned char* blob = wxSQLite3NativeValue::GetBlob(value, len);
+    if (blob == NULL && wxSQLite3NativeValue::GetType(value) != WXSQLITE_NULL)
+      blob = (const unsigned char*) "";
+    return wxSQLite3BlobView(blob, (size_t) len);
+  }
+  static void SetResult(void* ctx, const wxSQLite3BlobView& value)
+  {
+    if (value.data != NULL)
+      wxSQLite3NativeValue::SetResultBlob(ctx, value.data, (int) value.size);
+    else
+      wxSQLite3NativeValue::SetResultNull(ctx);
+  }
+};
+
+/// Value traits for BLOBs held in a std::vector
+template <>
+struct wxSQLite3ValueTraits< std::vector<unsigned char> >
+{
+  static void Bind(wxSQLite3Statement& stmt, int paramIndex, const std::vector<unsigned char>& value)
+  {
+    stmt.Bind(paramIndex, value.empty() ? (const unsigned char*) "" : &value[0], (int) value.size());
+  }
+  static std::vector<unsigned char> Get(const wxSQLite3Statement& stmt, int columnIndex)
+  {
+    int len = 0;
+    const unsigned char* blob = stmt.GetColumnBlob(columnIndex, len);
+    return (blob != NULL) ? std::vector<unsigned char>(blob, blob + len) : std::vector<unsigned char>();
+  }
+  static std::vector<unsigned char> GetArg(void* value)
+  {
+    int len = 0;
+    const unsigned char* blob = wxSQLite3NativeValue::GetBlob(value, len);
+    return (blob != NULL) ? std::vector<unsigned char>(blob, blob + len) : std::vector<unsigned char>();
+  }
+  static void SetResult(void* ctx, const std::vector<unsigned char>& value)
+  {
+    wxSQLite3NativeValue::SetResultBlob(ctx, value.empty() ? NULL : &value[0], (int) value.size());
+  }
+};
+
+/// Value traits for BLOBs held in a wxMemoryBuffer
+template <>
+struct wxSQLite3ValueTraits<wxMemoryBuffer>
+{
+  static void Bind(wxSQLite3Statement& stmt, int paramIndex, const wxMemoryBuffer& value)
+  {
+    stmt.Bind(paramIndex, value);
+  }
+  static wxMemoryBuffer Get(const wxSQLite3Statement& stmt, int columnIndex)
+  {
+    int len = 0;
+    const unsigned char* blob = stmt.GetColumnBlob(columnIndex, len);
+    wxMemoryBuffer buffer;
+    if (blob != NULL)
+    {
+      buffer.AppendData(blob, (size_t) len);
+    }
+    return buffer;
+  }
+  static wxMemoryBuffer GetArg(void* value)
+  {
+    int len = 0;
+    const unsigned char* blob = wxSQLite3NativeValue::GetBlob(value, len);
+    wxMemoryBuffer buffer;
+    if (blob != NULL)
+    {
+      buffer.AppendData(blob, (size_t) len);
+    }
+    return buffer;
+  }
+  static void SetResult(void* ctx, const wxMemoryBuffer& value)
+  {
+    wxSQLite3NativeValue::SetResultBlob(ctx, value.GetData(), (int) value.GetDataLen());
+  }
+};
+
+#if WXSQLITE3_HAVE_CXX17
+
+/// Value traits for utf-8 encoded std::string_view
+/**
+* A decoded view refers to memory owned by SQLite; it is only valid during the
+* user defined function call resp. until the statement is stepped, reset or finalized.
+*/
+template <>
+struct wxSQLite3ValueTraits<std::string_view>
+{
+  static void Bind(wxSQLite3Statement& stmt, int paramIndex, std::string_view value)
+  {
+    stmt.BindText(paramIndex, (value.data() != NULL) ? value.data() : "", wxSQLite3TextLength(value.size()));
+  }
+  static std::string_view Get(const wxSQLite3Statement& stmt, int columnIndex)
+  {
+    int len = 0;
+    const char* text = stmt.GetColumnText(columnIndex, len);
+    return (text != NULL) ? std::string_view(text, (size_t) len) : std::string_view();
+  }
+  static std::string_view GetArg(void* value)
+  {
+    int len = 0;
+    const char* text = wxSQLite3NativeValue::GetText(value, len);
+    return (text != NULL) ? std::string_view(text, (size_t) len) : std::string_view();
+  }
+  static void SetResult(void* ctx, std::string_view value)
+  {
+    wxSQLite3NativeValue::SetResultText(ctx, (value.data() != NULL) ? value.data() : "", wxSQLite3TextLength(value.size()));
+  }
+};
+
+/// Value traits for nullable values
+template <typename T>
+struct wxSQLite3ValueTraits< std::optional<T> >
+{
+  static void Bind(wxSQLite3Statement& stmt, int paramIndex, const std::optional<T>& value)
+  {
+    if (value.has_value())
+      wxSQLite3ValueTraits<T>::Bind(stmt, paramIndex, *value);
+    else
+      stmt.BindNull(paramIndex);
+  }
+  static std::optional<T> Get(const wxSQLite3Statement& stmt, int columnIndex)
+  {
+    if (stmt.GetColumnType(columnIndex) == WXSQLITE_NULL)
+      return std::nullopt;
+    return wxSQLite3ValueTraits<T>::Get(stmt, columnIndex);
+  }
+  static std::optional<T> GetArg(void* value)
+  {
+    if (wxSQLite3NativeValue::GetType(value) == WXSQLITE_NULL)
+      return std::nullopt;
+    return wxSQLite3ValueTraits<T>::GetArg(value);
+  }
+  static void SetResult(void* ctx, const std::optional<T>& value)
+  {
+    if (value.has_value())
+      wxSQLite3ValueTraits<T>::SetResult(ctx, *value);
+    else
+      wxSQLite3NativeValue::SetResultNull(ctx);
+  }
+};
+
+#endif // WXSQLITE3_HAVE_CXX17
+
+/// Prepared statement with parameter and result column types fixed at compile time
+/**
+* The template is layered on top of wxSQLite3Statement. Parameters are bound through
+* the wxSQLite3ValueTraits specialization of the respective type, selected at compile time,
+* and result rows are decoded into std::tuple instances.
+* The number of parameters and result columns is validated once, when the typed statement
+* is constructed from a prepared statement.
+*
+* Example:
+* \code
+* wxSQLite3TypedStatement< wxSQLite3Params<int>, wxSQLite3Columns<std::string, double> >
+*   stmt(db.PrepareStatement("SELECT name, salary FROM emp WHERE dept = ?;"));
+* std::tuple<std::string, double> row;
+* stmt.Bind(42);
+* while (stmt.Next(row)) { ... }
+* \endcode
+*/
+template <typename ParamList, typename ColumnList = wxSQLite3Columns<> >
+class wxSQLite3TypedStatement;
+
+template <typename... P, typename... R>
+class wxSQLite3TypedStatement< wxSQLite3Params<P...>, wxSQLite3Columns<R...> >
+{
+public:
+  /// Type of a decoded result row
+  typedef std::tuple<R...> RowType;
+
+  /// Default constructor
+  wxSQLite3TypedStatement()
+  {
+  }
+
+  /// Constructor
+  /**
+  * \param statement prepared statement
+  * An exception is thrown if the number of parameters or result columns does not match.
+  */
+  explicit wxSQLite3TypedStatement(const wxSQLite3Statement& statement)
+    : m_stmt(statement)
+  {
+    m_stmt.CheckSignature((int) sizeof...(P), (int) sizeof...(R));
+  }
+
+  /// Reset the statement and bind all parameters
+  /**
+  * \param args parameter values
+  */
+  void Bind(const P&... args)
+  {
+    m_stmt.Reset();
+    BindAll(typename wxSQLite3MakeIndexList<(int) sizeof...(P)>::type(), args...);
+  }
+
+  /// Execute a statement not returning data
+  /**
+  * \param args parameter values
+  * \return the number of database rows that were changed (or inserted or deleted)
+  */
+  int Execute(const P&... args)
+  {
+    Bind(args...);
+    return m_stmt.ExecuteUpdate();
+  }
+
+  /// Fetch the next result row
+  /**
+  * \param row tuple receiving the decoded column values
+  * \return TRUE if a row was fetched, FALSE if no more rows are available
+  */
+  bool Next(RowType& row)
+  {
+    if (!m_stmt.Step())
+    {
+      return false;
+    }
+    row = GetRow(typename wxSQLite3MakeIndexList<(int) sizeof...(R)>::type());
+    return true;
+  }
+
+  /// Execute a query and fetch the first result row only
+  /**
+  * \param row tuple receiving the decoded column values
+  * \param args parameter values
+  * \return TRUE if a row was fetched, FALSE if the query returned no rows
+  */
+  bool QuerySingle(RowType& row, const P&... args)
+  {
+    Bind(args...);
+    bool found = Next(row);
+    m_stmt.Reset();
+    return found;
+  }
+
+  /// Execute a query and fetch all result rows
+  /**
+  * \param args parameter values
+  * \return vector of all decoded result rows
+  */
+  std::vector<RowType> Query(const P&... args)
+  {
+    std::vector<RowType> rows;
+    RowType row;
+    Bind(args...);
+    while (Next(row))
+    {
+      rows.push_back(row);
+    }
+    return rows;
+  }
+
+  /// Get the underlying prepared statement
+  wxSQLite3Statement& GetStatement() { return m_stmt; }
+
+  /// Validate the underlying prepared statement
+  bool IsOk() const { return m_stmt.IsOk(); }
+
+private:
+  template <int... I>
+  void BindAll(wxSQLite3IndexList<I...>, const P&... args)
+  {
+    int expand[] = { 0, (wxSQLite3ValueTraits<P>::Bind(m_stmt, I + 1, args), 0)... };
+    wxUnusedVar(expand);
+  }
+
+  template <int... I>
+  RowType GetRow(wxSQLite3IndexList<I...>) const
+  {
+    return RowType(wxSQLite3ValueTraits<R>::Get(m_stmt, I)...);
+  }
+
+  wxSQLite3Statement m_stmt; ///< associated prepared statement
+};
+
+/// Compile time list of types (internal use only)
+template <typename... Types> struct wxSQLite3TypeList {};
+
+/// Signature of a callable: result type and argument types (internal use only)
+template <typename F>
+struct wxSQLite3CallableTraits : wxSQLite3CallableTraits<decltype(&F::operator())> {};
+
+template <typename R, typename... A>
+struct wxSQLite3CallableTraits<R(*)(A...)>
+{
+  typedef R ResultType;
+  typedef wxSQLite3TypeList<A...> ArgList;
+};
+
+template <typename C, typename R, typename... A>
+struct wxSQLite3CallableTraits<R(C::*)(A...)>
+{
+  typedef R ResultType;
+  typedef wxSQLite3TypeList<A...> ArgList;
+};
+
+template <typename C, typename R, typename... A>
+struct wxSQLite3CallableTraits<R(C::*)(A...) const>
+{
+  typedef R ResultType;
+  typedef wxSQLite3TypeList<A...> ArgList;
+};
+
+/// Invocation of a callable and transfer of its result (internal use only)
+template <typename R>
+struct wxSQLite3ResultInvoker
+{
+  template <typename F, typename... X>
+  static void Call(void* ctx, F& func, X&&... args)
+  {
+    wxSQLite3ValueTraits<typename std::decay<R>::type>::SetResult(ctx, func(std::forward<X>(args)...));
+  }
+};
+
+template <>
+struct wxSQLite3ResultInvoker<void>
+{
+  template <typename F, typename... X>
+  static void Call(void*, F& func, X&&... args)
+  {
+    func(std::forward<X>(args)...);
+  }
+};
+
+/// Report an exception thrown by a user defined function as SQL error (internal use only)
+#define WXSQLITE3_CATCH_FUNCTION_EXCEPTION(ctx) \
+  catch (const wxSQLite3Exception& e) \
+  { \
+    wxCharBuffer strErrmsg = e.GetMessage().ToUTF8(); \
+    const char* localErrmsg = strErrmsg; \
+    wxSQLite3NativeValue::SetResultError(ctx, localErrmsg); \
+  } \
+  catch (const std::exception& e) \
+  { \
+    wxSQLite3NativeValue::SetResultError(ctx, e.what()); \
+  } \
+  catch (...) \
+  { \
+    wxSQLite3NativeValue::SetResultError(ctx, "Unknown exception in user defined function"); \
+  }
+
+/// Adapter between SQLite and a callable implementing a scalar function (internal use only)
+template <typename F, typename ArgList = typename wxSQLite3CallableTraits<F>::ArgList>
+struct wxSQLite3ScalarFunctionAdapter;
+
+template <typename F, typename... A>
+struct wxSQLite3ScalarFunctionAdapter< F, wxSQLite3TypeList<A...> >
+{
+  typedef typename wxSQLite3CallableTraits<F>::ResultType ResultType;
+
+  static int GetArgCount() { return (int) sizeof...(A); }
+
+  static void Exec(void* ctx, int argc, void** argv)
+  {
+    wxUnusedVar(argc);
+    F* func = (F*) wxSQLite3NativeValue::GetUserData(ctx);
+    try
+    {
+      Dispatch(ctx, *func, argv, typename wxSQLite3MakeIndexList<(int) sizeof...(A)>::type());
+    }
+    WXSQLITE3_CATCH_FUNCTION_EXCEPTION(ctx)
+  }
+
+  static void Destroy(void* func)
+  {
+    delete (F*) func;
+  }
+
+private:
+  template <int... I>
+  static void Dispatch(void* ctx, F& func, void** argv, wxSQLite3IndexList<I...>)
+  {
+    wxUnusedVar(argv);
+    wxSQLite3ResultInvoker<ResultType>::Call(ctx, func, wxSQLite3ValueTraits<typename std::decay<A>::type>::GetArg(argv[I])...);
+  }
+};
 
-  /// Get the original SQL string for the prepared statement with expanded bound parameters
-  /**
-  * \return the original SQL string used to prepare the statement with expanded bound parameters
-  */
-  wxString GetExpandedSQL() const;
+/// Adapter between SQLite and a pair of callables implementing an aggregate function (internal use only)
+/**
+* The step callable receives a reference to the aggregate state as its first argument,
+* followed by the function arguments. The final callable receives the state and returns the result.
+* A state object is default constructed on the first step of each group and destroyed after finalization.
+*/
+template <typename StepF, typename FinalF, typename ArgList = typename wxSQLite3CallableTraits<StepF>::ArgList>
+struct wxSQLite3AggregateFunctionAdapter;
 
-  /// Reset the prepared statement
-  /**
-  * Resets the statement back to it's initial state, ready to be re-executed.
-  * Any SQL statement variables that had values bound to them retain their values.
-  */
-  void Reset();
+template <typename StepF, typename FinalF, typename S, typename... A>
+struct wxSQLite3AggregateFunctionAdapter< StepF, FinalF, wxSQLite3TypeList<S, A...> >
+{
+  typedef typename std::decay<S>::type StateType;
+  typedef typename wxSQLite3CallableTraits<FinalF>::ResultType ResultType;
 
-  /// Determine whether the statement is read-only
-  /**
-  * \return TRUE if the statement is read-only, FALSE otherwise
-  * \since SQLite3 version 3.7.4
-  * \note For SQLite3 version before version 3.7.4 this method returns always FALSE.
-  */
-  bool IsReadOnly() const;
+  wxSQLite3AggregateFunctionAdapter(const StepF& step, const FinalF& final)
+    : m_step(step), m_final(final)
+  {
+  }
 
-  /// Finalize the prepared statement
-  /**
-  */
-  void Finalize();
+  static int GetArgCount() { return (int) sizeof...(A); }
 
-  /// Validate associated SQLite database and statement
-  /**
-  * \return TRUE if both, a SQLite database and a SQLite statement, are associated, FALSE otherwise
-  */
-  bool IsOk() const;
+  static void ExecStep(void* ctx, int argc, void** argv)
+  {
+    wxUnusedVar(argc);
+    wxSQLite3AggregateFunctionAdapter* adapter = (wxSQLite3AggregateFunctionAdapter*) wxSQLite3NativeValue::GetUserData(ctx);
+    StateType** state = (StateType**) wxSQLite3NativeValue::GetAggregateContext(ctx, (int) sizeof(StateType*));
+    if (state == NULL)
+    {
+      wxSQLite3NativeValue::SetResultError(ctx, "Out of memory");
+      return;
+    }
+    try
+    {
+      if (*state == NULL)
+      {
+        *state = new StateType();
+      }
+      Dispatch(adapter->m_step, **state, argv, typename wxSQLite3MakeIndexList<(int) sizeof...(A)>::type());
+    }
+    WXSQLITE3_CATCH_FUNCTION_EXCEPTION(ctx)
+  }
 
-  /// Determine if a prepared statement has been reset
-  /**
-  * \return TRUE if the prepared statement has been stepped at least once but has not run to completion and/or has not been reset, FALSE otherwise
-  */
-  bool IsBusy() const;
+  static void ExecFinal(void* ctx)
+  {
+    wxSQLite3AggregateFunctionAdapter* adapter = (wxSQLite3AggregateFunctionAdapter*) wxSQLite3NativeValue::GetUserData(ctx);
+    StateType** state = (StateType**) wxSQLite3NativeValue::GetAggregateContext(ctx, 0);
+    StateGuard guard(state);
+    try
+    {
+      if (state != NULL && *state != NULL)
+      {
+        wxSQLite3ResultInvoker<ResultType>::Call(ctx, adapter->m_final, **state);
+      }
+      else
+      {
+        // No rows were aggregated
+        StateType empty;
+        wxSQLite3ResultInvoker<ResultType>::Call(ctx, adapter->m_final, empty);
+      }
+    }
+    WXSQLITE3_CATCH_FUNCTION_EXCEPTION(ctx)
+  }
 
-  /// Determine internal operation counters of the underlying prepared statement
-  /**
-  * Prepared statements maintain various counters to measure the performance of specific operations.
-  * This method allows to monitor the performance characteristics of the prepared statement.
-  * \param opCode operation code of the operation to be queried
-  * \param resetFlag flag whether the associated counter should be reset to zero (default: false)
-  * \return the counter value for the requested counter
-  */
-  int Status(wxSQLite3StatementStatus opCode, bool resetFlag = false) const;
+  static void Destroy(void* adapter)
+  {
+    delete (wxSQLite3AggregateFunctionAdapter*) adapter;
+  }
 
 private:
-  /// Check for valid database connection
-  void CheckDatabase() const;
-
-  /// Check for valid statement
-  void CheckStmt() const;
+  /// Destroys the aggregate state when finalization is complete
+  struct StateGuard
+  {
+    explicit StateGuard(StateType** state) : m_state(state) {}
+    ~StateGuard()
+    {
+      if (m_state != NULL && *m_state != NULL)
+      {
+        delete *m_state;
+        *m_state = NULL;
+      }
+    }
+    StateType** m_state;
+  };
 
-  /// Finalize the result set (internal)
-  void Finalize(wxSQLite3DatabaseReference* db,wxSQLite3StatementReference* stmt);
+  template <int... I>
+  static void Dispatch(StepF& step, StateType& state, void** argv, wxSQLite3IndexList<I...>)
+  {
+    wxUnusedVar(argv);
+    step(state, wxSQLite3ValueTraits<typename std::decay<A>::type>::GetArg(argv[I])...);
+  }
 
-  wxSQLite3DatabaseReference*  m_db;    ///< associated SQLite3 database
-  wxSQLite3StatementReference* m_stmt;  ///< associated SQLite3 statement
+  StepF  m_step;   ///< step callable
+  FinalF m_final;  ///< final callable
 };
 
+#endif // WXSQLITE3_HAVE_CXX11
+
 
 /// Represents a SQLite BLOB handle
 class WXDLLIMPEXP_SQLITE3 wxSQLite3Blob
@@ -2514,6 +4945,14 @@ public:
   */
   wxMemoryBuffer& Read(wxMemoryBuffer& blobValue, int length, int offset) const;
 
+  /// Read partial BLOB value into a caller provided buffer
+  /**
+   * \param buffer buffer receiving the partial content of the BLOB
+   * \param length length of BLOB content to be read
+   * \param offset offset within BLOB where the read starts
+  */
+  void Read(void* buffer, int length, int offset) const;
+
   /// Write partial BLOB value
   /**
    * \param blobValue memory buffer receiving the partial content of the BLOB
@@ -2521,6 +4960,14 @@ public:
   */
   void Write(const wxMemoryBuffer& blobValue, int offset);
 
+  /// Write partial BLOB value from a caller provided buffer
+  /**
+   * \param buffer buffer containing the data to be written
+   * \param length length of the data
+   * \param offset offset within BLOB where the write starts
+  */
+  void Write(const void* buffer, int length, int offset);
+
   /// Check whether the BLOB handle is correctly initialized
   /**
    * \return TRUE if the BLOB handle is correctly initialized, FALSE otherwise
@@ -2564,6 +5011,193 @@ private:
   bool  m_writable; ///< flag whether the BLOB is writable or read only
 };
 
+#if wxUSE_STREAMS
+
+/// Input stream reading the content of a BLOB incrementally
+/**
+* The stream reads the BLOB in place via the incremental BLOB I/O of SQLite,
+* without loading the whole value into memory.
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3BlobInputStream : public wxInputStream
+{
+public:
+  /// Constructor
+  /**
+  * \param blob BLOB handle (see wxSQLite3Database::GetReadOnlyBlob)
+  */
+  wxSQLite3BlobInputStream(const wxSQLite3Blob& blob);
+
+  /// Virtual destructor
+  virtual ~wxSQLite3BlobInputStream();
+
+  /// Get the size of the BLOB
+  virtual wxFileOffset GetLength() const;
+
+  /// Check whether the stream is seekable
+  virtual bool IsSeekable() const { return true; }
+
+protected:
+  virtual size_t OnSysRead(void* buffer, size_t size);
+  virtual wxFileOffset OnSysSeek(wxFileOffset pos, wxSeekMode mode);
+  virtual wxFileOffset OnSysTell() const;
+
+private:
+  wxSQLite3Blob m_blob;     ///< BLOB handle
+  int           m_size;     ///< Size of the BLOB
+  int           m_position; ///< Current read position
+};
+
+/// Output stream writing the content of a BLOB incrementally
+/**
+* The size of a BLOB can not be changed by incremental BLOB I/O, that is, the BLOB
+* has to be created with sufficient size (for example by binding a zero BLOB).
+* Writing beyond the end of the BLOB results in a write error.
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3BlobOutputStream : public wxOutputStream
+{
+public:
+  /// Constructor
+  /**
+  * \param blob writable BLOB handle (see wxSQLite3Database::GetWritableBlob)
+  */
+  wxSQLite3BlobOutputStream(const wxSQLite3Blob& blob);
+
+  /// Virtual destructor
+  virtual ~wxSQLite3BlobOutputStream();
+
+  /// Get the size of the BLOB
+  virtual wxFileOffset GetLength() const;
+
+  /// Check whether the stream is seekable
+  virtual bool IsSeekable() const { return true; }
+
+protected:
+  virtual size_t OnSysWrite(const void* buffer, size_t size);
+  virtual wxFileOffset OnSysSeek(wxFileOffset pos, wxSeekMode mode);
+  virtual wxFileOffset OnSysTell() const;
+
+private:
+  wxSQLite3Blob m_blob;     ///< BLOB handle
+  int           m_size;     ///< Size of the BLOB
+  int           m_position; ///< Current write position
+};
+
+#if wxUSE_ZLIB
+
+class WXDLLIMPEXP_FWD_BASE wxZlibInputStream;
+class WXDLLIMPEXP_FWD_BASE wxZlibOutputStream;
+
+/// Output stream compressing data into a BLOB
+/**
+* The data are deflated incrementally into the BLOB in the format of the SQL function
+* compress (see wxSQLite3Database::CreateCompressionFunctions), so that neither the
+* uncompressed nor the compressed value has to be held in memory as a whole.
+* The BLOB has to be created with sufficient size, for example a zero BLOB of the size
+* returned by GetMaxBlobSize. Trailing unused bytes are ignored on decompression;
+* they can be removed afterwards by UPDATE ... SET col=substr(col,1,GetCompressedSize()).
+* The frame header recording the original size is written when the stream is closed.
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3CompressedBlobOutputStream : public wxOutputStream
+{
+public:
+  /// Constructor
+  /**
+  * \param blob writable BLOB handle (see wxSQLite3Database::GetWritableBlob)
+  * \param isText flag whether the data are UTF-8 text, returned as TEXT by the SQL function uncompress
+  * \param level compression level 1 (fastest) to 9 (best), or -1 for the zlib default
+  */
+  wxSQLite3CompressedBlobOutputStream(const wxSQLite3Blob& blob, bool isText = false, int level = -1);
+
+  /// Virtual destructor, closes the stream
+  virtual ~wxSQLite3CompressedBlobOutputStream();
+
+  /// Finish the compression and write the frame header
+  /**
+  * \return TRUE if all data were compressed and written successfully, FALSE otherwise
+  */
+  virtual bool Close();
+
+  /// Get the number of BLOB bytes used by the compressed data including the frame header
+  /**
+  * The value is final after the stream was closed.
+  */
+  wxFileOffset GetCompressedSize() const;
+
+  /// Get the BLOB size sufficient for compressing data of the given size in the worst case
+  /**
+  * \param originalSize size of the uncompressed data
+  * \return required BLOB size
+  */
+  static wxFileOffset GetMaxBlobSize(wxFileOffset originalSize);
+
+protected:
+  virtual size_t OnSysWrite(const void* buffer, size_t size);
+  virtual wxFileOffset OnSysTell() const;
+
+private:
+  /// Private copy constructor
+  wxSQLite3CompressedBlobOutputStream(const wxSQLite3CompressedBlobOutputStream& stream);
+
+  /// Private assignment constructor
+  wxSQLite3CompressedBlobOutputStream& operator=(const wxSQLite3CompressedBlobOutputStream& stream);
+
+  wxSQLite3Blob             m_blob;         ///< BLOB handle
+  wxSQLite3BlobOutputStream m_blobStream;   ///< Stream receiving the compressed data
+  wxZlibOutputStream*       m_zlibStream;   ///< Compressing stream
+  wxFileOffset              m_originalSize; ///< Number of uncompressed bytes written
+  bool                      m_isText;       ///< Flag whether the data are text
+  bool                      m_closed;       ///< Flag whether the stream was closed
+};
+
+/// Input stream decompressing data from a BLOB
+/**
+* Reads BLOBs in the format of the SQL function compress incrementally. BLOBs not in
+* that format are read unchanged, like the SQL function uncompress returns them.
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3CompressedBlobInputStream : public wxInputStream
+{
+public:
+  /// Constructor
+  /**
+  * \param blob BLOB handle (see wxSQLite3Database::GetReadOnlyBlob)
+  */
+  wxSQLite3CompressedBlobInputStream(const wxSQLite3Blob& blob);
+
+  /// Virtual destructor
+  virtual ~wxSQLite3CompressedBlobInputStream();
+
+  /// Get the size of the uncompressed data
+  virtual wxFileOffset GetLength() const;
+
+  /// Check whether the BLOB contains compressed data
+  bool IsCompressed() const { return m_compressed; }
+
+  /// Check whether the compressed data were marked as text
+  bool IsText() const { return m_isText; }
+
+protected:
+  virtual size_t OnSysRead(void* buffer, size_t size);
+  virtual wxFileOffset OnSysTell() const;
+
+private:
+  /// Private copy constructor
+  wxSQLite3CompressedBlobInputStream(const wxSQLite3CompressedBlobInputStream& stream);
+
+  /// Private assignment constructor
+  wxSQLite3CompressedBlobInputStream& operator=(const wxSQLite3CompressedBlobInputStream& stream);
+
+  wxSQLite3BlobInputStream m_blobStream;   ///< Stream providing the compressed data
+  wxZlibInputStream*       m_zlibStream;   ///< Decompressing stream (NULL for uncompressed data)
+  wxFileOffset             m_originalSize; ///< Size of the uncompressed data
+  wxFileOffset             m_position;     ///< Number of uncompressed bytes read
+  bool                     m_compressed;   ///< Flag whether the BLOB contains a compression frame
+  bool                     m_isText;       ///< Flag whether the data are text
+};
+
+#endif // wxUSE_ZLIB
+
+#endif // wxUSE_STREAMS
+
 /// Represents a named collection
 /**
 * A named collection is designed to facilitate using an array of
@@ -3265,6 +5899,161 @@ public:
   */
   int ExecuteUpdate(const char* sql, bool saveRC = false);
 
+  /// Execute a data defining or manipulating SQL statement without throwing an exception
+  /**
+  * \param sql query string
+  * \return the result of the operation; GetChanges returns the number of rows changed
+  */
+  wxSQLite3Result TryExecuteUpdate(const wxString& sql);
+
+  /// Execute a data defining or manipulating SQL statement given as a utf-8 character string without throwing an exception
+  /**
+  * \param sql query string
+  * \return the result of the operation; GetChanges returns the number of rows changed
+  */
+  wxSQLite3Result TryExecuteUpdate(const char* sql);
+
+#if WXSQLITE3_HAVE_CXX17
+  /// Execute data defining or manipulating SQL statements given as utf-8 text (std::string_view, std::string)
+  /**
+  * The SQL text need not be NUL terminated and is passed to SQLite without conversion.
+  * Like for the other variants, the text may consist of several statements.
+  * \param sql query string
+  * \return the number of database rows that were changed (or inserted or deleted) by the last statement
+  */
+  template <typename S, wxSQLite3IfUtf8Text<S> = 0>
+  int ExecuteUpdate(const S& sql)
+  {
+    std::string_view text(sql);
+    return ExecuteUpdateUtf8(text.data(), wxSQLite3TextLength(text.size()));
+  }
+
+  /// Execute data defining or manipulating SQL statements given as utf-8 text without throwing an exception
+  /**
+  * \param sql query string
+  * \return the result of the operation; GetChanges returns the number of rows changed
+  */
+  template <typename S, wxSQLite3IfUtf8Text<S> = 0>
+  wxSQLite3Result TryExecuteUpdate(const S& sql)
+  {
+    std::string_view text(sql);
+    if (text.size() > (size_t) (std::numeric_limits<int>::max)())
+    {
+      return wxSQLite3Result::TextTooBig();
+    }
+    return TryExecuteUpdateUtf8(text.data(), (int) text.size());
+  }
+
+  /// Execute a SQL query statement given as utf-8 text (std::string_view, std::string)
+  /**
+  * \param sql query string
+  * \return result set instance
+  */
+  template <typename S, wxSQLite3IfUtf8Text<S> = 0>
+  wxSQLite3ResultSet ExecuteQuery(const S& sql)
+  {
+    std::string_view text(sql);
+    return ExecuteQueryUtf8(text.data(), wxSQLite3TextLength(text.size()));
+  }
+
+  /// Execute a scalar SQL query statement given as utf-8 text (std::string_view, std::string)
+  /**
+  * \param sql query string
+  * \return first column of first row as an int
+  */
+  template <typename S, wxSQLite3IfUtf8Text<S> = 0>
+  int ExecuteScalar(const S& sql)
+  {
+    std::string_view text(sql);
+    return ExecuteScalarUtf8(text.data(), wxSQLite3TextLength(text.size()));
+  }
+
+  /// Get the result table for a SQL query statement given as utf-8 text (std::string_view, std::string)
+  /**
+  * \param sql query string
+  * \return table instance
+  */
+  template <typename S, wxSQLite3IfUtf8Text<S> = 0>
+  wxSQLite3Table GetTable(const S& sql)
+  {
+    // sqlite3_get_table requires a NUL terminated string
+    return GetTable(std::string(std::string_view(sql)).c_str());
+  }
+
+  /// Prepare a SQL query statement given as utf-8 text (std::string_view, std::string)
+  /**
+  * \param sql query string
+  * \return statement instance
+  */
+  template <typename S, wxSQLite3IfUtf8Text<S> = 0>
+  wxSQLite3Statement PrepareStatement(const S& sql)
+  {
+    std::string_view text(sql);
+    return PrepareStatementUtf8(text.data(), wxSQLite3TextLength(text.size()), false, false);
+  }
+
+  /// Prepare a long-lasting SQL query statement given as utf-8 text (std::string_view, std::string)
+  /**
+  * \param sql query string
+  * \param capturePlan flag whether the query plan should be captured
+  * \return statement instance
+  */
+  template <typename S, wxSQLite3IfUtf8Text<S> = 0>
+  wxSQLite3Statement PreparePersistentStatement(const S& sql, bool capturePlan = false)
+  {
+    std::string_view text(sql);
+    return PrepareStatementUtf8(text.data(), wxSQLite3TextLength(text.size()), true, capturePlan);
+  }
+
+  /// Check SQL text given as utf-8 text (std::string_view, std::string) for completeness
+  /**
+  * \param sql query string
+  * \return TRUE if the text ends with a complete SQL statement, FALSE otherwise
+  */
+  template <typename S, wxSQLite3IfUtf8Text<S> = 0>
+  bool CheckSyntax(const S& sql) const
+  {
+    // sqlite3_complete requires a NUL terminated string
+    return CheckSyntax(std::string(std::string_view(sql)).c_str());
+  }
+
+  /// Check whether a table exists, given its utf-8 name (std::string_view, std::string)
+  /**
+  * \param tableName name of the table
+  * \param databaseName optional name of the schema to be searched
+  * \return TRUE if the table exists, FALSE otherwise
+  */
+  template <typename S, wxSQLite3IfUtf8Text<S> = 0>
+  bool TableExists(const S& tableName, std::string_view databaseName = std::string_view())
+  {
+    std::string_view text(tableName);
+    return TableExistsUtf8(text.data(), wxSQLite3TextLength(text.size()), databaseName.data(), wxSQLite3TextLength(databaseName.size()));
+  }
+
+  /// Attach a database file, given its utf-8 file and schema names (std::string_view, std::string)
+  /**
+  * \param fileName name of the database file to be attached
+  * \param schemaName name of the schema the database is attached as
+  */
+  template <typename S, wxSQLite3IfUtf8Text<S> = 0>
+  void AttachDatabase(const S& fileName, std::string_view schemaName)
+  {
+    std::string_view text(fileName);
+    AttachDatabaseUtf8(text.data(), wxSQLite3TextLength(text.size()), schemaName.data(), wxSQLite3TextLength(schemaName.size()));
+  }
+
+  /// Detach a database, given its utf-8 schema name (std::string_view, std::string)
+  /**
+  * \param schemaName name of the schema of the attached database
+  */
+  template <typename S, wxSQLite3IfUtf8Text<S> = 0>
+  void DetachDatabase(const S& schemaName)
+  {
+    std::string_view text(schemaName);
+    DetachDatabaseUtf8(text.data(), wxSQLite3TextLength(text.size()));
+  }
+#endif
+
   /// Execute a SQL query statement given as a wxString
   /**
   * \param sql query string
@@ -3337,6 +6126,25 @@ public:
   */
   wxSQLite3Table GetTable(const char* sql);
 
+  /// Rewrite single parameter IN lists for binding arrays
+  /**
+  * Each list consisting of a single parameter, like "IN (?)", "IN (?2)" or "IN (:ids)",
+  * is replaced by "IN carray(...)" with the same parameter, which can then be bound to an
+  * array of any size via wxSQLite3Statement::BindArray. Parameter numbering is not affected.
+  * String literals, quoted identifiers and comments are left untouched.
+  *
+  * Example:
+  * \code
+  * wxSQLite3Statement stmt = db.PrepareStatement(
+  *   wxSQLite3Database::RewriteArrayParams("DELETE FROM t WHERE id IN (?)"));
+  * stmt.BindArray(1, ids);
+  * stmt.ExecuteUpdate();
+  * \endcode
+  * \param sql SQL statement text
+  * \return rewritten SQL statement text
+  */
+  static wxString RewriteArrayParams(const wxString& sql);
+
   /// Prepare a SQL query statement given as a wxString for parameter binding
   /**
   * \param sql query string
@@ -3361,29 +6169,32 @@ public:
   /// Prepare a (long-lasting) SQL query statement given as a wxString for parameter binding
   /**
   * \param sql query string
+  * \param capturePlan flag whether the query plan should be captured and monitored (see wxSQLite3PlanChangeListener)
   * \return statement instance
   *
   * SQLite3 assumes that this prepared statement will be retained for a long time and probably reused many times.
   */
-  wxSQLite3Statement PreparePersistentStatement(const wxString& sql);
+  wxSQLite3Statement PreparePersistentStatement(const wxString& sql, bool capturePlan = false);
 
   /// Prepare a (long-lasting) SQL query statement given as a statement buffer for parameter binding
   /**
   * \param sql query string
+  * \param capturePlan flag whether the query plan should be captured and monitored (see wxSQLite3PlanChangeListener)
   * \return statement instance
   *
   * SQLite3 assumes that this prepared statement will be retained for a long time and probably reused many times.
   */
-  wxSQLite3Statement PreparePersistentStatement(const wxSQLite3StatementBuffer& sql);
+  wxSQLite3Statement PreparePersistentStatement(const wxSQLite3StatementBuffer& sql, bool capturePlan = false);
 
   /// Prepare a (long-lasting) SQL query statement given as a utf-8 character string for parameter binding
   /**
   * \param sql query string
+  * \param capturePlan flag whether the query plan should be captured and monitored (see wxSQLite3PlanChangeListener)
   * \return statement instance
   *
   * SQLite3 assumes that this prepared statement will be retained for a long time and probably reused many times.
   */
-  wxSQLite3Statement PreparePersistentStatement(const char* sql);
+  wxSQLite3Statement PreparePersistentStatement(const char* sql, bool capturePlan = false);
 
   /// Get the row id of last inserted row
   /**
@@ -3565,10 +6376,59 @@ public:
   * \param function instance of an aggregate window function
   * \param flags    specifies a combination of function flags (WXSQLITE_DETERMINISTIC, WXSQLITE_DIRECTONLY,
   *                 WXSQLITE_SUBTYPE, WXSQLITE_INNOCUOUS). (Default: none)
-  *                 (see https://www.sqlite.org/c3ref/c_deterministic.html for detailed explanations
+  *                 (see https://www.sqlite.org/c3ref/c_deterministic.html for detailed explanations
+  * \return TRUE on successful registration, FALSE otherwise
+  */
+  bool CreateFunction(const wxString& funcName, int argCount, wxSQLite3WindowFunction& function, int flags = 0);
+
+#if WXSQLITE3_HAVE_CXX11
+  /// Create a user-defined scalar function from a callable
+  /**
+  * Registers a SQL scalar function implemented by a lambda, function object or function pointer.
+  * The number and types of the arguments are deduced at compile time from the signature
+  * of the callable; arguments are decoded directly from the SQLite values and the return value
+  * is set as function result, both via wxSQLite3ValueTraits. Supported argument types include
+  * integral and floating point types, wxSQLite3TextView and wxSQLite3BlobView (zero-copy),
+  * std::string, wxString and std::vector<unsigned char>. A void return value results in NULL.
+  * Exceptions thrown by the callable are reported as SQL errors.
+  * The callable is copied and owned by the database connection.
+  * \param funcName name of the scalar function
+  * \param func callable implementing the function (must not be a generic lambda)
+  * \param flags    specifies a combination of function flags (WXSQLITE_DETERMINISTIC, WXSQLITE_DIRECTONLY,
+  *                 WXSQLITE_SUBTYPE, WXSQLITE_INNOCUOUS). (Default: none)
+  * \return TRUE on successful registration, FALSE otherwise
+  */
+  template <typename Func, typename = typename std::enable_if<!std::is_integral<Func>::value>::type>
+  bool CreateFunction(const wxString& funcName, Func func, int flags = 0)
+  {
+    typedef wxSQLite3ScalarFunctionAdapter<Func> Adapter;
+    return CreateNativeFunction(funcName, Adapter::GetArgCount(), flags, new Func(func),
+                                Adapter::Exec, NULL, NULL, Adapter::Destroy);
+  }
+
+  /// Create a user-defined aggregate function from a pair of callables
+  /**
+  * Registers a SQL aggregate function implemented by a step and a final callable.
+  * The step callable takes a reference to the aggregate state as its first argument,
+  * followed by the function arguments; the final callable takes the state and returns
+  * the function result. The state type is deduced from the step callable and must be
+  * default constructible; one instance is created per aggregation group.
+  * \param funcName name of the aggregate function
+  * \param stepFunc callable invoked for each row
+  * \param finalFunc callable computing the result
+  * \param flags    specifies a combination of function flags (WXSQLITE_DETERMINISTIC, WXSQLITE_DIRECTONLY,
+  *                 WXSQLITE_SUBTYPE, WXSQLITE_INNOCUOUS). (Default: none)
   * \return TRUE on successful registration, FALSE otherwise
   */
-  bool CreateFunction(const wxString& funcName, int argCount, wxSQLite3WindowFunction& function, int flags = 0);
+  template <typename StepFunc, typename FinalFunc,
+            typename = typename std::enable_if<!std::is_integral<StepFunc>::value && !std::is_integral<FinalFunc>::value>::type>
+  bool CreateFunction(const wxString& funcName, StepFunc stepFunc, FinalFunc finalFunc, int flags = 0)
+  {
+    typedef wxSQLite3AggregateFunctionAdapter<StepFunc, FinalFunc> Adapter;
+    return CreateNativeFunction(funcName, Adapter::GetArgCount(), flags, new Adapter(stepFunc, finalFunc),
+                                NULL, Adapter::ExecStep, Adapter::ExecFinal, Adapter::Destroy);
+  }
+#endif
 
   /// Create a user-defined authorizer function
   /**
@@ -3631,6 +6491,83 @@ public:
   */
   void SetWriteAheadLogHook(wxSQLite3Hook* walHook);
 
+  /// Register a consumer of the change data capture feed
+  /**
+  * Registers a listener object to receive the row changes of each committed transaction
+  * as a single batch. The changes are captured by the pre-update hook of SQLite, including
+  * the old and new column values, if requested. Registering a NULL listener disables change
+  * data capture and discards changes of the current transaction not yet delivered.
+  *
+  * Commit and rollback hooks set with SetCommitHook and SetRollbackHook continue to be
+  * invoked while change data capture is active; the commit hook is invoked before the
+  * changes are delivered. If a change cannot be buffered for lack of memory, the transaction
+  * is rolled back on commit instead of delivering an incomplete batch.
+  *
+  * Changes undone by ROLLBACK TO or by a statement failing with an error are removed
+  * from the batch. Statement boundaries and savepoints are only tracked for statements
+  * executed through wxSQLite3, not for statements stepped by other code using the
+  * same SQLite connection.
+  * \param listener address of an instance of a change listener
+  * \param captureValues flag whether the old and new column values should be captured
+  * \note Requires SQLite to be compiled with SQLITE_ENABLE_PREUPDATE_HOOK
+  * (see HasPreUpdateHookSupport).
+  */
+  void SetChangeListener(wxSQLite3ChangeListener* listener, bool captureValues = true);
+
+  /// Attach a statement tracer
+  /**
+  * Attaches a tracer collecting execution statistics per statement fingerprint and a log of
+  * slow queries (see wxSQLite3StatementTracer). Attaching a NULL tracer detaches the current
+  * tracer; while no tracer is attached, SQLite does not invoke any trace callbacks.
+  * \param tracer address of an instance of a statement tracer
+  */
+  void SetStatementTracer(wxSQLite3StatementTracer* tracer);
+
+  /// Attach an event recorder
+  /**
+  * Attaches a recorder capturing the activity of this connection as timeline events
+  * (see wxSQLite3EventRecorder). The same recorder may be attached to several connections.
+  * While a recorder is attached, the busy timeout is implemented by a busy handler recording
+  * each wait. Attaching a NULL recorder detaches the current recorder. The recorder has to be
+  * attached after the database has been opened, and must not be destroyed while attached.
+  * \param recorder address of an instance of an event recorder
+  */
+  void SetEventRecorder(wxSQLite3EventRecorder* recorder);
+
+  /// Get the attached event recorder
+  /**
+  * \return the event recorder attached to this connection, or NULL
+  */
+  wxSQLite3EventRecorder* GetEventRecorder() const;
+
+  /// Attach a sampling profiler
+  /**
+  * Attaches a profiler taking samples of the running statements via the progress handler
+  * (see wxSQLite3SamplingProfiler). Attaching a NULL profiler detaches the current profiler
+  * and removes the progress handler. An exception is thrown if the profiler is attached
+  * to another connection.
+  * \param profiler address of an instance of a sampling profiler
+  */
+  void SetSamplingProfiler(wxSQLite3SamplingProfiler* profiler);
+
+  /// Set the listener for query plan changes
+  /**
+  * The listener is notified when the query plan of a persistent statement prepared with plan
+  * capture enabled changes after the statement was re-prepared by SQLite, for example due to a
+  * schema change or after running ANALYZE.
+  * \param listener address of an instance of a plan change listener (NULL to remove the listener)
+  */
+  void SetPlanChangeListener(wxSQLite3PlanChangeListener* listener);
+
+  /// Get the query plan fingerprint of a SQL statement
+  /**
+  * The fingerprint consists of the lines of the EXPLAIN QUERY PLAN output, one line per plan
+  * element, indented by two blanks per nesting level.
+  * \param sql SQL statement
+  * \return the query plan fingerprint
+  */
+  wxString GetQueryPlanFingerprint(const wxString& sql);
+
   /// Checkpoint database in write-ahead log mode
   /**
   * Causes an optionally named database to be checkpointed.
@@ -3667,6 +6604,102 @@ public:
   */
   void SetCollation(const wxString& name, wxSQLite3Collation* collation);
 
+  /// Create a user-defined collation sequence operating on UTF-8 byte spans
+  /**
+  * Registers a collation object which compares the texts without converting them to wxString.
+  * Registering a NULL collation object disables the specified collation sequence.
+  * \param name name of a user-defined collation sequence
+  * \param collation address of an instance of a user-defined collation sequence
+  */
+  void SetUtf8Collation(const wxString& name, wxSQLite3Utf8Collation* collation);
+
+  /// Create a SQL function returning the sort key of a text
+  /**
+  * Registers a deterministic scalar function with one argument, which returns the sort key
+  * generated by the given collation as a BLOB (or NULL for a NULL argument). Ordering by the
+  * function result gives the same order as the collation, so that sort keys can be
+  * materialized in an indexed column or used in an index on an expression:
+  * \code
+  * db.CreateSortKeyFunction(wxS("sortkey_de"), &germanCollation);
+  * db.ExecuteUpdate(wxS("CREATE INDEX idx_name ON person(sortkey_de(name))"));
+  * \endcode
+  * \param funcName name of the SQL function
+  * \param collation address of an instance of a sort key collation (no ownership)
+  * \return TRUE on successful registration, FALSE otherwise
+  */
+  bool CreateSortKeyFunction(const wxString& funcName, wxSQLite3SortKeyCollation* collation);
+
+  /// Create the built-in Unicode case-insensitive collation sequence
+  /**
+  * The collation compares texts after applying Unicode simple case folding to each character,
+  * whereas the SQLite collation NOCASE folds only ASCII characters. Runs of ASCII characters
+  * are compared in blocks using SIMD instructions, if available.
+  * \param collationName name of the collation sequence
+  */
+  void SetUnicodeNoCaseCollation(const wxString& collationName = wxS("UNICODE_NOCASE"));
+
+  /// Replace the LIKE and GLOB operators by Unicode-aware implementations
+  /**
+  * LIKE becomes case-insensitive for all Unicode characters, not only for ASCII characters.
+  * GLOB stays case-sensitive unless requested otherwise. Otherwise the semantics of the
+  * SQLite built-in functions are preserved.
+  * \note Overriding the built-in functions disables the LIKE optimization of SQLite,
+  * that is, LIKE and GLOB expressions can not be evaluated by means of an index.
+  * \param caseInsensitiveGlob flag whether GLOB should be case-insensitive, too
+  */
+  void SetUnicodeLikeFunctions(bool caseInsensitiveGlob = false);
+
+  /// Create the natively implemented statistical aggregate and window functions
+  /**
+  * Registers the following functions, which ignore NULL and non-numeric values:
+  * - var_samp(x), variance(x), var_pop(x), stddev_samp(x), stddev(x), stddev_pop(x):
+  *   sample and population variance and standard deviation (Welford's algorithm)
+  * - median(x), percentile_cont(x, f), percentile_disc(x, f): exact percentiles for
+  *   a fraction f between 0.0 and 1.0, interpolated resp. discrete
+  * - percentile_approx(x, f [, compression]): approximate percentile based on a t-digest
+  *   (compression between 10 and 10000, default 100); aggregate function only
+  * - mode(x): most frequent value (on ties the smallest value)
+  * - wma(x): linearly weighted moving average (the most recent row has the largest weight)
+  * - ema(x, alpha): exponential moving average with smoothing factor alpha (0 < alpha <= 1),
+  *   normalized over the rows of the window frame
+  *
+  * Except for percentile_approx all functions can be used as window functions; they implement
+  * the removal of rows from the window frame, so that the variance, moving average and
+  * exponential moving average of sliding window frames are calculated in constant time per row.
+  * Functions of the same name provided by SQLite extensions are replaced.
+  */
+  void CreateStatisticsFunctions();
+
+  /// Create the natively implemented hash, checksum and encoding functions
+  /**
+  * Registers the following deterministic scalar functions. BLOB arguments are hashed or
+  * encoded as is, all other values as their UTF-8 text representation; NULL yields NULL.
+  * - xxh64(x [, seed]), xxh3(x [, seed]): 64-bit xxHash (XXH64 resp. XXH3) as signed integer
+  * - crc32c(x [, crc]): CRC-32C (Castagnoli) checksum; passing the checksum of the preceding
+  *   data as crc allows to checksum data in pieces. SSE4.2 or ARMv8 CRC instructions are used if available.
+  * - sha256(x): SHA-256 digest as 32 byte BLOB
+  * - hex_encode(x), hex_decode(x): lower case hexadecimal text; decoding accepts both cases
+  * - base64_encode(x), base64_decode(x): Base64 (RFC 4648) text with padding; decoding
+  *   accepts missing padding, but no whitespace
+  *
+  * Decoding functions return NULL for malformed input.
+  */
+  void CreateHashFunctions();
+
+  /// Create the SQL functions compress and uncompress
+  /**
+  * compress(x [, level]) compresses a value with zlib (level 1 to 9, default -1 for the zlib
+  * default) and returns a BLOB consisting of a frame header, which records the codec, the type
+  * (BLOB or TEXT) and the size of the original value, followed by the compressed data.
+  * If compression does not reduce the size, the value is stored uncompressed within the frame.
+  * uncompress(x) restores the original value; values not in this format are returned unchanged,
+  * so that compressed and uncompressed values can be mixed in a column.
+  * Functions of the same name provided by SQLite extensions are replaced.
+  * wxSQLite3CompressedBlobOutputStream and wxSQLite3CompressedBlobInputStream
+  * read and write the same format incrementally.
+  */
+  void CreateCompressionFunctions();
+
   /// Return meta information about a specific column of a specific database table
   /**
   * \param dbName is either the name of the database (i.e. "main", "temp" or an attached database) or an empty string. If it is an empty string all attached databases are searched for the table.
@@ -3817,6 +6850,32 @@ public:
   */
   void ReleaseMemory();
 
+  /// Get a snapshot of the status values of the database connection
+  /**
+  * \param resetFlag flag whether high-water marks and counters should be reset after taking the snapshot
+  * \return the status snapshot
+  */
+  wxSQLite3DatabaseStatus GetStatus(bool resetFlag = false);
+
+  /// Get a snapshot of the process-wide status values of SQLite
+  /**
+  * \param resetFlag flag whether the high-water marks should be reset after taking the snapshot
+  * \return the status snapshot
+  */
+  static wxSQLite3GlobalStatus GetGlobalStatus(bool resetFlag = false);
+
+  /// Get the wrapper overhead profile
+  /**
+  * Requires wxSQLite3 to be compiled with WXSQLITE3_PROFILE_WRAPPER defined as 1.
+  * For each wxSQLite3 entry point called so far the report lists the number of calls,
+  * the inclusive time, the time spent in SQLite API functions, and the remaining wrapper time,
+  * sorted by descending wrapper time. Time is measured in CPU cycles where the time stamp counter
+  * is available, in nanoseconds otherwise.
+  * \param resetFlag flag whether the counters should be reset after creating the report
+  * \return the profile report, or an empty string if profiling is not compiled in
+  */
+  static wxString GetWrapperProfile(bool resetFlag = false);
+
   /// Get system error code
   /**
   * Get the underlying system error code after a SQLite function has failed, i.e. a file couldn't be opened
@@ -4012,6 +7071,30 @@ public:
   */
   static bool HasPointerParamsSupport();
 
+  /// Check whether wxSQLite3 has support for binding arrays via carray
+  /**
+  * \return TRUE if wxSQLite3Statement::BindArray is supported, FALSE otherwise
+  */
+  static bool HasArrayParamsSupport();
+
+  /// Check whether wxSQLite3 has support for the SQLite pre-update hook
+  /**
+  * \return TRUE if the pre-update hook (and thus change data capture) is supported, FALSE otherwise
+  */
+  static bool HasPreUpdateHookSupport();
+
+  /// Check whether wxSQLite3 has support for statement scan status
+  /**
+  * \return TRUE if per-loop query plan statistics (see wxSQLite3Statement::GetQueryPlan) are supported, FALSE otherwise
+  */
+  static bool HasScanStatusSupport();
+
+  /// Check whether wxSQLite3 was compiled with wrapper overhead profiling
+  /**
+  * \return TRUE if the wrapper profile (see GetWrapperProfile) is collected, FALSE otherwise
+  */
+  static bool HasWrapperProfileSupport();
+
 protected:
   /// Access SQLite's internal database handle
   void* GetDatabaseHandle() const;
@@ -4036,6 +7119,12 @@ protected:
   /// Execute a comparison using a user-defined collation
   static int ExecComparisonWithCollation(void* collation, int len1, const void* txt1, int len2, const void* txt2);
 
+  /// Execute a comparison using a user-defined UTF-8 collation
+  static int ExecUtf8Comparison(void* collation, int len1, const void* txt1, int len2, const void* txt2);
+
+  /// Execute a sort key function
+  static void ExecSortKeyFunction(void* ctx, int argc, void** argv);
+
   /// Execute callback for needed collation sequences
   static void ExecCollationNeeded(void* db, void* internalDb, int eTextRep, const char* name);
 
@@ -4047,10 +7136,38 @@ private:
   wxSQLite3Database& operator=(const wxSQLite3Database& db);
 
   /// Prepare a SQL statement (internal use only)
-  void* Prepare(const char* sql);
+  /**
+  * \param sql utf-8 SQL text
+  * \param sqlLen length of the SQL text in bytes, or -1 if it is NUL terminated
+  */
+  void* Prepare(const char* sql, int sqlLen = -1);
 
   /// Prepare a (long-lasting) SQL statement (internal use only)
-  void* PreparePersistent(const char* sql);
+  void* PreparePersistent(const char* sql, int sqlLen = -1);
+
+  /// Execute SQL statements given as utf-8 text of known length (internal use only)
+  int ExecuteUpdateUtf8(const char* sql, int sqlLen);
+
+  /// Execute SQL statements given as utf-8 text of known length without throwing an exception (internal use only)
+  wxSQLite3Result TryExecuteUpdateUtf8(const char* sql, int sqlLen);
+
+  /// Execute a SQL query given as utf-8 text of known length (internal use only)
+  wxSQLite3ResultSet ExecuteQueryUtf8(const char* sql, int sqlLen);
+
+  /// Execute a scalar SQL query given as utf-8 text of known length (internal use only)
+  int ExecuteScalarUtf8(const char* sql, int sqlLen);
+
+  /// Prepare a SQL statement given as utf-8 text of known length (internal use only)
+  wxSQLite3Statement PrepareStatementUtf8(const char* sql, int sqlLen, bool persistent, bool capturePlan);
+
+  /// Check whether a table exists, given its utf-8 name (internal use only)
+  bool TableExistsUtf8(const char* tableName, int tableNameLen, const char* databaseName, int databaseNameLen);
+
+  /// Attach a database, given utf-8 file and schema names (internal use only)
+  void AttachDatabaseUtf8(const char* fileName, int fileNameLen, const char* schemaName, int schemaNameLen);
+
+  /// Detach a database, given its utf-8 schema name (internal use only)
+  void DetachDatabaseUtf8(const char* schemaName, int schemaNameLen);
 
   /// Check for valid database connection
   void CheckDatabase() const;
@@ -4058,6 +7175,16 @@ private:
   /// Close associated database
   void Close(wxSQLite3DatabaseReference* db);
 
+  /// Register a function with native callbacks (internal use only)
+  /**
+  * The user data is released through the destroy callback, also if the registration fails.
+  */
+  bool CreateNativeFunction(const wxString& funcName, int argCount, int flags, void* userData,
+                            void (*xFunc)(void*, int, void**),
+                            void (*xStep)(void*, int, void**),
+                            void (*xFinal)(void*),
+                            void (*xDestroy)(void*));
+
   wxSQLite3DatabaseReference* m_db;  ///< associated SQLite3 database
   bool  m_isOpen;          ///< Flag whether the database is opened or not
   int   m_busyTimeoutMs;   ///< Busy timeout in milli seconds
@@ -4076,8 +7203,13 @@ private:
   static bool  ms_hasBackupSupport;          ///< Flag whether wxSQLite3 has support for SQLite backup/restore
   static bool  ms_hasWriteAheadLogSupport;   ///< Flag whether wxSQLite3 has support for SQLite write-ahead log
   static bool  ms_hasPointerParamsSupport;   ///< Flag whether wxSQLite3 has support for SQLite pointer parameters
+  static bool  ms_hasArrayParamsSupport;     ///< Flag whether wxSQLite3 has support for binding arrays via carray
+  static bool  ms_hasPreUpdateHookSupport;   ///< Flag whether wxSQLite3 has support for the SQLite pre-update hook
+  static bool  ms_hasScanStatusSupport;      ///< Flag whether wxSQLite3 has support for SQLite statement scan status
+  static bool  ms_hasWrapperProfileSupport;  ///< Flag whether wxSQLite3 collects the wrapper overhead profile
 
   friend class wxSQLite3Cipher;
+  friend class wxSQLite3StatusSampler;
 };
 
 /// RAII class for managing transactions
@@ -4158,17 +7290,203 @@ private:
   wxSQLite3Database* m_database; ///< Pointer to the associated database (no ownership)
 };
 
+/// Aggregate function building a HyperLogLog sketch for estimating the number of distinct values
+/**
+* hll_sketch(value [, precision]) returns a sketch (BLOB) of the non-NULL values.
+* In merge mode, hll_union(sketch) returns the union of the sketches of all rows.
+* Values comparing equal in SQL (like 1 and 1.0) are counted as one value.
+* The precision p (4 to 18, default 12) determines the sketch size of 2^p bytes
+* and the standard error 1.04/sqrt(2^p), that is 1.6% for p = 12.
+* The number of distinct values is estimated by the scalar function hll_count(sketch).
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3HyperLogLogAggregate : public wxSQLite3AggregateFunction
+{
+public:
+  /// Constructor
+  /**
+  * \param mergeSketches flag whether the function merges sketches (instead of values)
+  */
+  wxSQLite3HyperLogLogAggregate(bool mergeSketches = false);
+
+  /// Virtual destructor
+  virtual ~wxSQLite3HyperLogLogAggregate();
+
+  /// Add a value (or sketch) to the sketch
+  virtual void Aggregate(wxSQLite3FunctionContext& ctx);
+
+  /// Return the sketch
+  virtual void Finalize(wxSQLite3FunctionContext& ctx);
+
+private:
+  bool m_mergeSketches; ///< Flag whether the function merges sketches
+};
+
+/// Aggregate function building a count-min sketch for estimating value frequencies
+/**
+* cms_sketch(value [, width [, depth]]) returns a sketch (BLOB) of the non-NULL values.
+* In merge mode, cms_union(sketch) returns the sum of the sketches of all rows.
+* The estimated frequency of a value, as returned by the scalar function
+* cms_estimate(sketch, value), never underestimates the real frequency and
+* overestimates it by at most e/width times the total count with probability 1-exp(-depth).
+* Defaults are width 1024 and depth 4 (32 KB).
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3CountMinAggregate : public wxSQLite3AggregateFunction
+{
+public:
+  /// Constructor
+  /**
+  * \param mergeSketches flag whether the function merges sketches (instead of values)
+  */
+  wxSQLite3CountMinAggregate(bool mergeSketches = false);
+
+  /// Virtual destructor
+  virtual ~wxSQLite3CountMinAggregate();
+
+  /// Add a value (or sketch) to the sketch
+  virtual void Aggregate(wxSQLite3FunctionContext& ctx);
+
+  /// Return the sketch
+  virtual void Finalize(wxSQLite3FunctionContext& ctx);
+
+private:
+  bool m_mergeSketches; ///< Flag whether the function merges sketches
+};
+
+/// Aggregate function building a t-digest for estimating quantiles
+/**
+* tdigest_sketch(value [, compression]) returns a t-digest (BLOB) of the numeric values.
+* In merge mode, tdigest_union(sketch) returns the union of the digests of all rows.
+* The compression (10 to 10000, default 100) limits the number of centroids of the digest.
+* Quantiles are estimated by the scalar function tdigest_quantile(sketch, fraction).
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3TDigestAggregate : public wxSQLite3AggregateFunction
+{
+public:
+  /// Constructor
+  /**
+  * \param mergeSketches flag whether the function merges sketches (instead of values)
+  */
+  wxSQLite3TDigestAggregate(bool mergeSketches = false);
+
+  /// Virtual destructor
+  virtual ~wxSQLite3TDigestAggregate();
+
+  /// Add a value (or sketch) to the digest
+  virtual void Aggregate(wxSQLite3FunctionContext& ctx);
+
+  /// Return the digest
+  virtual void Finalize(wxSQLite3FunctionContext& ctx);
+
+private:
+  bool m_mergeSketches; ///< Flag whether the function merges sketches
+};
+
+/// Types of sketch scalar functions
+enum wxSQLite3SketchFunctionType
+{
+  WXSQLITE_SKETCH_HLL_COUNT,        ///< hll_count(sketch): estimated number of distinct values
+  WXSQLITE_SKETCH_HLL_MERGE,        ///< hll_merge(sketch, ...): union of HyperLogLog sketches
+  WXSQLITE_SKETCH_CMS_ESTIMATE,     ///< cms_estimate(sketch, value): estimated frequency of a value
+  WXSQLITE_SKETCH_CMS_MERGE,        ///< cms_merge(sketch, ...): sum of count-min sketches
+  WXSQLITE_SKETCH_TDIGEST_QUANTILE, ///< tdigest_quantile(sketch, fraction): estimated quantile
+  WXSQLITE_SKETCH_TDIGEST_MERGE     ///< tdigest_merge(sketch, ...): union of t-digests
+};
+
+/// Scalar functions for merging and evaluating sketches
+/**
+* NULL arguments of the merge functions are ignored. Sketches of different
+* precision (HyperLogLog) or dimensions (count-min) can not be merged.
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3SketchFunction : public wxSQLite3ScalarFunction
+{
+public:
+  /// Constructor
+  /**
+  * \param type type of the sketch function
+  */
+  wxSQLite3SketchFunction(wxSQLite3SketchFunctionType type);
+
+  /// Virtual destructor
+  virtual ~wxSQLite3SketchFunction();
+
+  /// Execute the scalar function
+  virtual void Execute(wxSQLite3FunctionContext& ctx);
+
+private:
+  wxSQLite3SketchFunctionType m_type; ///< Type of the sketch function
+};
+
+/// Set of all sketch aggregate and scalar functions
+/**
+* Registers the functions hll_sketch, hll_union, hll_count, hll_merge, cms_sketch,
+* cms_union, cms_estimate, cms_merge, tdigest_sketch, tdigest_union, tdigest_quantile
+* and tdigest_merge. The instance has to live as long as the database connections
+* it is registered with.
+* \code
+* wxSQLite3SketchFunctions sketches;
+* sketches.Register(db);
+* db.ExecuteUpdate(wxS("INSERT INTO daily_users SELECT day, hll_sketch(user_id) FROM events GROUP BY day"));
+* db.ExecuteQuery(wxS("SELECT hll_count(hll_union(users)) FROM daily_users WHERE day >= '2026-10-01'"));
+* \endcode
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3SketchFunctions
+{
+public:
+  /// Constructor
+  wxSQLite3SketchFunctions();
+
+  /// Virtual destructor
+  virtual ~wxSQLite3SketchFunctions();
+
+  /// Register the sketch functions with a database connection
+  /**
+  * \param db database connection
+  * \return TRUE if all functions were registered successfully, FALSE otherwise
+  */
+  bool Register(wxSQLite3Database& db);
+
+private:
+  wxSQLite3HyperLogLogAggregate m_hllSketch;       ///< hll_sketch
+  wxSQLite3HyperLogLogAggregate m_hllUnion;        ///< hll_union
+  wxSQLite3SketchFunction       m_hllCount;        ///< hll_count
+  wxSQLite3SketchFunction       m_hllMerge;        ///< hll_merge
+  wxSQLite3CountMinAggregate    m_cmsSketch;       ///< cms_sketch
+  wxSQLite3CountMinAggregate    m_cmsUnion;        ///< cms_union
+  wxSQLite3SketchFunction       m_cmsEstimate;     ///< cms_estimate
+  wxSQLite3SketchFunction       m_cmsMerge;        ///< cms_merge
+  wxSQLite3TDigestAggregate     m_tdigestSketch;   ///< tdigest_sketch
+  wxSQLite3TDigestAggregate     m_tdigestUnion;    ///< tdigest_union
+  wxSQLite3SketchFunction       m_tdigestQuantile; ///< tdigest_quantile
+  wxSQLite3SketchFunction       m_tdigestMerge;    ///< tdigest_merge
+};
+
 
 #if wxUSE_REGEX
 
+class wxSQLite3RegExpCache;
+
 /// User defined function for REGEXP operator
 /**
+* Compiled regular expressions are attached to the prepared statement as auxiliary data,
+* so that a constant pattern is compiled only once per statement. Non-constant patterns
+* are looked up in a bounded cache of recently used compiled expressions.
+* The text argument is matched without creating intermediate wxString instances.
+*
+* The function expects 2 arguments: the pattern and the text, as for "text REGEXP pattern".
+* It should be registered as
+* \code
+* db.CreateFunction(wxS("regexp"), 2, regExpOperator, WXSQLITE_DETERMINISTIC);
+* \endcode
 */
 class WXDLLIMPEXP_SQLITE3 wxSQLite3RegExpOperator : public wxSQLite3ScalarFunction
 {
 public:
   /// Constructor
-  wxSQLite3RegExpOperator(int flags = wxRE_DEFAULT);
+  /**
+  * \param flags flags for compiling regular expressions (see wxRegEx::Compile)
+  * \param cacheSize maximum number of compiled regular expressions kept for non-constant patterns
+  */
+  wxSQLite3RegExpOperator(int flags = wxRE_DEFAULT, int cacheSize = 16);
 
   /// Virtual destructor
   virtual ~wxSQLite3RegExpOperator();
@@ -4180,10 +7498,180 @@ public:
   */
   virtual void Execute(wxSQLite3FunctionContext& ctx);
 
+protected:
+  /// Get the compiled regular expression for a function argument
+  /**
+  * \param ctx function context
+  * \param argIndex index of the argument holding the pattern
+  * \return pointer to the compiled regular expression, or NULL if the pattern is invalid.
+  * In the latter case an error result has already been set.
+  */
+  wxRegEx* GetRegExp(wxSQLite3FunctionContext& ctx, int argIndex);
+
+  /// Decode a utf-8 function argument into a reusable buffer
+  /**
+  * \param ctx function context
+  * \param argIndex index of the argument holding the text
+  * \param[out] textLen length of the decoded text in characters
+  * \return pointer to the decoded text, valid until the next call, or NULL on a decoding error
+  */
+  const wxChar* GetDecodedText(wxSQLite3FunctionContext& ctx, int argIndex, size_t& textLen);
+
+private:
+  /// Private copy constructor
+  wxSQLite3RegExpOperator(const wxSQLite3RegExpOperator& op);
+
+  /// Private assignment constructor
+  wxSQLite3RegExpOperator& operator=(const wxSQLite3RegExpOperator& op);
+
+  wxSQLite3RegExpCache* m_cache; ///< Cache of compiled regular expressions
+  int                   m_flags; ///< Flags for regular expression
+};
+
+/// User defined function regexp_replace
+/**
+* regexp_replace(text, pattern, replacement [, maxMatches]) replaces the matches of
+* pattern in text by replacement (see wxRegEx::Replace for the replacement syntax).
+* If maxMatches is omitted or 0, all matches are replaced. NULL text results in NULL.
+* It should be registered as
+* \code
+* db.CreateFunction(wxS("regexp_replace"), -1, regExpReplace, WXSQLITE_DETERMINISTIC);
+* \endcode
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3RegExpReplaceFunction : public wxSQLite3RegExpOperator
+{
+public:
+  /// Constructor
+  wxSQLite3RegExpReplaceFunction(int flags = wxRE_DEFAULT, int cacheSize = 16);
+
+  /// Virtual destructor
+  virtual ~wxSQLite3RegExpReplaceFunction();
+
+  /// Execute the scalar function
+  virtual void Execute(wxSQLite3FunctionContext& ctx);
+};
+
+/// User defined function regexp_extract
+/**
+* regexp_extract(text, pattern [, group]) returns the part of text matched by the
+* given group of pattern (default: 0, the whole match), or NULL if text does not match.
+* It should be registered as
+* \code
+* db.CreateFunction(wxS("regexp_extract"), -1, regExpExtract, WXSQLITE_DETERMINISTIC);
+* \endcode
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3RegExpExtractFunction : public wxSQLite3RegExpOperator
+{
+public:
+  /// Constructor
+  wxSQLite3RegExpExtractFunction(int flags = wxRE_DEFAULT, int cacheSize = 16);
+
+  /// Virtual destructor
+  virtual ~wxSQLite3RegExpExtractFunction();
+
+  /// Execute the scalar function
+  virtual void Execute(wxSQLite3FunctionContext& ctx);
+};
+
+/// Trigram index accelerating REGEXP searches on a text column
+/**
+* The index is an FTS5 table using the trigram tokenizer, which takes its content from
+* the indexed table itself (external content table). Triggers on the indexed table keep
+* the index up-to-date. The index is named <table>_<column>_trigram.
+*
+* A search extracts the literal strings any match of the pattern must contain. If at least
+* one of them consists of 3 or more characters, the candidate rows are preselected via the
+* trigram index, and the REGEXP operator is only evaluated for the candidate rows.
+* Otherwise the search falls back to a full scan using the REGEXP operator.
+*
+* The REGEXP operator (see wxSQLite3RegExpOperator) has to be registered for the database
+* connection. The trigram tokenizer requires SQLite 3.34.0 or higher with FTS5 enabled.
+*
+* \note Since the trigram index is case-insensitive, it preselects a superset of the
+* matching rows for case-sensitive as well as for case-insensitive patterns.
+*/
+class WXDLLIMPEXP_SQLITE3 wxSQLite3TrigramIndex
+{
+public:
+  /// Constructor
+  /**
+  * \param db database connection holding the table (no ownership)
+  * \param tableName name of the indexed table
+  * \param columnName name of the indexed text column
+  */
+  wxSQLite3TrigramIndex(wxSQLite3Database* db, const wxString& tableName, const wxString& columnName);
+
+  /// Destructor
+  virtual ~wxSQLite3TrigramIndex();
+
+  /// Get the name of the trigram index table
+  const wxString& GetIndexName() const { return m_indexName; }
+
+  /// Check whether the trigram index exists
+  bool Exists();
+
+  /// Create the trigram index and its maintenance triggers
+  /**
+  * \param populate flag whether the index should be populated from the existing table rows
+  */
+  void Create(bool populate = true);
+
+  /// Rebuild the trigram index from the content of the indexed table
+  void Rebuild();
+
+  /// Drop the trigram index and its maintenance triggers
+  void Drop();
+
+  /// Get the SQL statement for searching the indexed column
+  /**
+  * The statement has one parameter for the regular expression and, if the index
+  * can be used for the pattern, a second parameter for the FTS5 match expression.
+  * \param pattern regular expression
+  * \param resultColumns list of result columns (inserted verbatim into the statement)
+  * \param flags flags for compiling regular expressions (see wxRegEx::Compile)
+  * \return SQL statement
+  */
+  wxString GetSearchSQL(const wxString& pattern, const wxString& resultColumns = wxS("rowid"), int flags = wxRE_DEFAULT) const;
+
+  /// Search the indexed column for rows matching a regular expression
+  /**
+  * \param pattern regular expression
+  * \param resultColumns list of result columns (inserted verbatim into the statement)
+  * \param flags flags for compiling regular expressions (see wxRegEx::Compile)
+  * \return result set of the matching rows
+  */
+  wxSQLite3ResultSet Search(const wxString& pattern, const wxString& resultColumns = wxS("rowid"), int flags = wxRE_DEFAULT);
+
+  /// Extract the literal strings any match of a regular expression must contain
+  /**
+  * The analysis is conservative: parts of the pattern which are not understood
+  * (groups, bracket expressions, escapes denoting character classes) are skipped.
+  * \param pattern regular expression
+  * \param[out] literals array of literal strings of at least 3 characters
+  * \param flags flags for compiling regular expressions (see wxRegEx::Compile)
+  * \return TRUE if at least one literal string was found, FALSE otherwise
+  */
+  static bool ExtractLiterals(const wxString& pattern, wxArrayString& literals, int flags = wxRE_DEFAULT);
+
+  /// Get the FTS5 match expression preselecting candidate rows for a regular expression
+  /**
+  * \param pattern regular expression
+  * \param flags flags for compiling regular expressions (see wxRegEx::Compile)
+  * \return FTS5 match expression, or an empty string if the trigram index can not be used
+  */
+  static wxString GetMatchExpression(const wxString& pattern, int flags = wxRE_DEFAULT);
+
 private:
-  wxString m_exprStr; ///< Last regular expression string
-  wxRegEx  m_regEx;   ///< Regular expression cache (currently only 1 instance)
-  int      m_flags;   ///< Flags for regular expression
+  /// Private copy constructor
+  wxSQLite3TrigramIndex(const wxSQLite3TrigramIndex& index);
+
+  /// Private assignment constructor
+  wxSQLite3TrigramIndex& operator=(const wxSQLite3TrigramIndex& index);
+
+  wxSQLite3Database* m_database;   ///< Pointer to the associated database (no ownership)
+  wxString           m_tableName;  ///< Name of the indexed table
+  wxString           m_columnName; ///< Name of the indexed column
+  wxString           m_indexName;  ///< Name of the trigram index table
 };
 
 #endif // wxUSE_REGEX
@@ -28,4 +28,11 @@
 #define WXSQLITE3_USE_NAMED_COLLECTIONS 1
 #endif
 
+//! To collect per entry point call counts and timings of the wrapper define WXSQLITE3_PROFILE_WRAPPER as 1 here.
+//! The report is available through wxSQLite3Database::GetWrapperProfile().
+//! Attention: this requires a C++11 compiler and adds measurable overhead; not intended for production builds
+#ifndef WXSQLITE3_PROFILE_WRAPPER
+#define WXSQLITE3_PROFILE_WRAPPER 0
+#endif
+
 #endif // WX_SQLITE3_OPT_H_
@@ -8,6 +8,34 @@ dofile "premake/wxwidgets.lua"
 
 BUILDDIR = _OPTIONS["builddir"] or "build"
 
+-- Console benchmark or stress test program in samples/bench
+function bench_project(name, source)
+  project(name)
+  location(BUILDDIR)
+  language "C++"
+  kind "ConsoleApp"
+
+  if (is_msvc) then
+    local prj = project()
+    prj.filename = "wxsqlite3_" .. vc_with_ver .. "_" .. name
+  end
+  if wxMonolithic then
+    local prj = project()
+    prj.filename = name .. "_mono"
+  end
+
+  use_filters( "WXSQLITE3", "samples", "core" )
+
+  files { "samples/bench/" .. source }
+  vpaths {
+    ["Header Files"] = { "**.h" },
+    ["Source Files"] = { "**.cpp", "**.rc" }
+  }
+  includedirs { "samples/bench", "include" }
+  characterset "Unicode"
+  links { "wxsqlite3" }
+end
+
 workspace "wxsqlite3"
   configurations { "Debug", "Release", "Debug_wxDLL", "Release_wxDLL", "Debug_DLL", "Release_DLL" }
   platforms { "Win32", "Win64" }
@@ -55,6 +83,8 @@ project "wxsqlite3"
     "SQLITE_ENABLE_EXPLAIN_COMMENTS=1",
     "SQLITE_SOUNDEX=1",
     "SQLITE_ENABLE_COLUMN_METADATA=1",
+    "SQLITE_ENABLE_PREUPDATE_HOOK=1",
+    "SQLITE_ENABLE_STMT_SCANSTATUS=1",
     "SQLITE_SECURE_DELETE=1",
     "SQLITE_ENABLE_DESERIALIZE=1",
     "SQLITE_ENABLE_FTS3=1",
@@ -114,6 +144,27 @@ project "minimal"
   characterset "Unicode"
   links { "wxsqlite3" }
 
+-- REGEXP trigram index benchmark
+bench_project("regexpbench", "regexpbench.cpp")
+
+-- Unicode collation benchmark
+bench_project("collationbench", "collationbench.cpp")
+
+-- Cipher throughput and open latency benchmark
+bench_project("cipherbench", "cipherbench.cpp")
+
+-- Multi-threaded WAL concurrency stress test
+bench_project("walstress", "walstress.cpp")
+
+-- Wrapper benchmark suite (raw SQLite API as baseline)
+bench_project("wxsqlite3_bench", "wxsqlite3bench.cpp")
+  includedirs { "src" }
+
+  -- The raw SQLite baseline needs the SQLite API, which the wxSQLite3 DLL does not export
+  filter { "configurations:Release_DLL or Debug_DLL" }
+    kind "None"
+  filter {}
+
 -- Minimal wxSQLite3 sample
 project "treeview"
   location(BUILDDIR)
@@ -0,0 +1,466 @@
+/*
+** Name:        cipherbench.cpp
+** Purpose:     Benchmark for the throughput and open latency of the wxSQLite3 ciphers
+** Author:      Ulrich Telle
+** Created:     2026-10-18
+** Copyright:   (c) 2026 Ulrich Telle
+** License:     LGPL-3.0+ WITH WxWindows-exception-3.1
+*/
+
+/*
+** For each page size, the benchmark first runs an unencrypted baseline and then
+** all cipher schemes with their relevant tunables (KDF iterations, HMAC use,
+** legacy mode). Each configuration measures
+**
+** - the latency of opening the database including key derivation and
+**   verification of the first page (Open with cipher and key),
+** - the write throughput when filling a new database in a single transaction,
+** - the scan throughput with a cold page cache (freshly opened connection).
+**
+** Page encryption and decryption throughput are derived from the difference
+** to the unencrypted baseline of the same page size, isolating the cost of the
+** cipher from the cost of SQLite itself. Synchronous writes are switched off to
+** keep disk flushes out of the measurements. The results are written as a single
+** JSON document to stdout (or to the file given with --output).
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+#ifdef __BORLANDC__
+#pragma hdrstop
+#endif
+
+#ifndef WX_PRECOMP
+#include "wx/wx.h"
+#endif
+
+#include <wx/cmdline.h>
+#include <wx/ffile.h>
+#include <wx/filefn.h>
+#include <wx/stopwatch.h>
+
+#include "wx/wxsqlite3.h"
+#include <iostream>
+
+using namespace std;
+
+class CipherBench : public wxAppConsole
+{
+public:
+  bool OnInit();
+  int OnExit();
+  int OnRun();
+
+private:
+  bool ParseList(const wxString& list, wxArrayInt& values);
+  wxLongLong Elapsed();
+  void OpenDatabase(wxSQLite3Database& db, const wxSQLite3Cipher* cipher);
+  void RunPageSize(long pageSize);
+  void RunCipher(const wxSQLite3Cipher* cipher, long pageSize, long kdfIter, int hmac, bool legacy);
+  bool IsValidKdfIter(wxSQLite3CipherType cipherType, long kdfIter);
+
+  wxString   m_dbName;
+  wxString   m_key;
+  wxString   m_output;
+  wxString   m_results;
+  wxArrayInt m_pageSizes;
+  wxArrayInt m_kdfIters;
+  wxStopWatch m_stopWatch;
+  wxLongLong m_plainWrite;
+  wxLongLong m_plainScan;
+  wxMemoryBuffer m_payload;
+  long m_rows;
+  long m_rowSize;
+  long m_opens;
+  int  m_rc;
+};
+
+static const wxCmdLineEntryDesc cmdLineDesc[] =
+{
+#if wxCHECK_VERSION(2,9,0)
+  { wxCMD_LINE_OPTION, "r", "rows",      "Number of rows (default: 20000)",                                wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "s", "rowsize",   "Payload size per row in bytes (default: 200)",                   wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "n", "opens",     "Number of timed Open calls per configuration (default: 5)",      wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "p", "pagesizes", "Comma separated list of page sizes (default: 4096)",             wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "k", "kdf",       "Comma separated list of KDF iterations, 0 = default (default: 0,1000)", wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "d", "database",  "Database file name (default: cipherbench.db)",                   wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "o", "output",    "JSON output file (default: stdout)",                             wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+#else
+  { wxCMD_LINE_OPTION, wxS("r"), wxS("rows"),      wxS("Number of rows (default: 20000)"),                                wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("s"), wxS("rowsize"),   wxS("Payload size per row in bytes (default: 200)"),                   wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("n"), wxS("opens"),     wxS("Number of timed Open calls per configuration (default: 5)"),      wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("p"), wxS("pagesizes"), wxS("Comma separated list of page sizes (default: 4096)"),             wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("k"), wxS("kdf"),       wxS("Comma separated list of KDF iterations, 0 = default (default: 0,1000)"), wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("d"), wxS("database"),  wxS("Database file name (default: cipherbench.db)"),                   wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("o"), wxS("output"),    wxS("JSON output file (default: stdout)"),                             wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+#endif
+  { wxCMD_LINE_NONE }
+};
+
+// Escapes a string for use as JSON string value
+static wxString JsonString(const wxString& value)
+{
+  wxString result = wxS("\"");
+  size_t j;
+  for (j = 0; j < value.Len(); ++j)
+  {
+    wxChar ch = value[j];
+    if (ch == wxS('"') || ch == wxS('\\'))
+    {
+      result += wxS('\\');
+      result += ch;
+    }
+    else if (ch < 0x20)
+    {
+      result += wxString::Format(wxS("\\u%04x"), (int) ch);
+    }
+    else
+    {
+      result += ch;
+    }
+  }
+  result += wxS("\"");
+  return result;
+}
+
+// Formats a throughput in MB/s, or null if the time difference is not measurable
+static wxString JsonThroughput(double bytes, wxLongLong usec)
+{
+  return (usec > 0) ? wxString::Format(wxS("%.2f"), bytes / usec.ToDouble()) : wxString(wxS("null"));
+}
+
+bool CipherBench::OnInit()
+{
+  m_rc = 0;
+  m_rows = 20000;
+  m_rowSize = 200;
+  m_opens = 5;
+  m_dbName = wxS("cipherbench.db");
+  m_key = wxS("cipherbench-key");
+  wxString pageSizes = wxS("4096");
+  wxString kdfIters = wxS("0,1000");
+  wxCmdLineParser parser(cmdLineDesc, argc, argv);
+  parser.SetLogo(wxS("wxSQLite3 Cipher Benchmark\n"));
+  bool ok = parser.Parse() == 0;
+  if (ok)
+  {
+    parser.Found(wxS("rows"), &m_rows);
+    parser.Found(wxS("rowsize"), &m_rowSize);
+    parser.Found(wxS("opens"), &m_opens);
+    parser.Found(wxS("pagesizes"), &pageSizes);
+    parser.Found(wxS("kdf"), &kdfIters);
+    parser.Found(wxS("database"), &m_dbName);
+    parser.Found(wxS("output"), &m_output);
+    if (m_rows < 1 || m_rowSize < 1 || m_opens < 1 ||
+        !ParseList(pageSizes, m_pageSizes) || !ParseList(kdfIters, m_kdfIters))
+    {
+      cerr << "Invalid benchmark parameters" << endl;
+      ok = false;
+    }
+  }
+  if (!ok)
+  {
+    m_rc = -1;
+  }
+  return ok;
+}
+
+int CipherBench::OnExit()
+{
+  return m_rc;
+}
+
+bool CipherBench::ParseList(const wxString& list, wxArrayInt& values)
+{
+  wxString rest = list;
+  while (!rest.IsEmpty())
+  {
+    int pos = rest.Find(wxS(','));
+    wxString item = (pos == wxNOT_FOUND) ? rest : rest.Left(pos);
+    rest = (pos == wxNOT_FOUND) ? wxString() : rest.Mid(pos + 1);
+    long value;
+    if (!item.Trim().Trim(false).ToLong(&value) || value < 0)
+    {
+      return false;
+    }
+    values.Add((int) value);
+  }
+  return values.GetCount() > 0;
+}
+
+wxLongLong CipherBench::Elapsed()
+{
+#if wxCHECK_VERSION(2,9,3)
+  return m_stopWatch.TimeInMicro();
+#else
+  return wxLongLong(m_stopWatch.Time()) * 1000;
+#endif
+}
+
+void CipherBench::OpenDatabase(wxSQLite3Database& db, const wxSQLite3Cipher* cipher)
+{
+  if (cipher != NULL)
+  {
+    db.Open(m_dbName, *cipher, m_key);
+  }
+  else
+  {
+    db.Open(m_dbName);
+  }
+  // Reading the schema forces the key derivation to complete and page 1 to be decrypted
+  db.ExecuteScalar("SELECT count(*) FROM sqlite_master");
+}
+
+bool CipherBench::IsValidKdfIter(wxSQLite3CipherType cipherType, long kdfIter)
+{
+  if (kdfIter == 0)
+  {
+    return true;
+  }
+  wxString cipherName = wxSQLite3Cipher::GetCipherName(cipherType);
+  return kdfIter >= wxSQLite3Cipher::GetCipherParameterMin(cipherName, wxS("kdf_iter")) &&
+         kdfIter <= wxSQLite3Cipher::GetCipherParameterMax(cipherName, wxS("kdf_iter"));
+}
+
+void CipherBench::RunCipher(const wxSQLite3Cipher* cipher, long pageSize, long kdfIter, int hmac, bool legacy)
+{
+  wxString cipherName = (cipher != NULL) ? wxSQLite3Cipher::GetCipherName(cipher->GetCipherType()) : wxString(wxS("none"));
+  cerr << "Running " << (const char*) cipherName.mb_str() << ", page size " << pageSize
+       << ", KDF iterations " << kdfIter << ", HMAC " << hmac << ", legacy " << legacy << endl;
+
+  wxString result = wxS("    { \"cipher\": ") + JsonString(cipherName);
+  result += wxString::Format(wxS(", \"page_size\": %ld, \"kdf_iter\": "), pageSize);
+  result += (kdfIter > 0) ? wxString::Format(wxS("%ld"), kdfIter) : wxString(wxS("null"));
+  result += wxS(", \"hmac\": ");
+  result += (hmac < 0) ? wxString(wxS("null")) : wxString((hmac != 0) ? wxS("true") : wxS("false"));
+  result += wxS(", \"legacy\": ");
+  result += (legacy) ? wxS("true") : wxS("false");
+
+  wxSQLite3Database db;
+  try
+  {
+    wxRemoveFile(m_dbName);
+
+    // Create and fill the database
+    OpenDatabase(db, cipher);
+    db.ExecuteUpdate(wxString::Format(wxS("PRAGMA page_size=%ld;"), pageSize));
+    db.ExecuteUpdate("PRAGMA synchronous=OFF;");
+    db.ExecuteUpdate("CREATE TABLE t (id INTEGER PRIMARY KEY, v BLOB);");
+    wxSQLite3Statement stmt = db.PrepareStatement("INSERT INTO t (v) VALUES (?)");
+    m_stopWatch.Start();
+    db.Begin();
+    long row;
+    for (row = 0; row < m_rows; ++row)
+    {
+      stmt.Bind(1, m_payload);
+      stmt.ExecuteUpdate();
+      stmt.Reset();
+    }
+    db.Commit();
+    wxLongLong writeTime = Elapsed();
+    stmt.Finalize();
+    double dbBytes = (double) db.ExecuteScalar("PRAGMA page_count") * db.ExecuteScalar("PRAGMA page_size");
+    long actualPageSize = db.ExecuteScalar("PRAGMA page_size");
+    db.Close();
+
+    // Open latency, including key derivation
+    wxLongLong openTotal = 0;
+    wxLongLong openMin = 0;
+    long j;
+    for (j = 0; j < m_opens; ++j)
+    {
+      m_stopWatch.Start();
+      OpenDatabase(db, cipher);
+      wxLongLong openTime = Elapsed();
+      db.Close();
+      openTotal += openTime;
+      if (j == 0 || openTime < openMin)
+      {
+        openMin = openTime;
+      }
+    }
+
+    // Scan with a cold page cache, every page is read and decrypted once
+    OpenDatabase(db, cipher);
+    m_stopWatch.Start();
+    db.ExecuteScalar("SELECT sum(length(v)) FROM t");
+    wxLongLong scanTime = Elapsed();
+    db.Close();
+
+    if (cipher == NULL)
+    {
+      m_plainWrite = writeTime;
+      m_plainScan = scanTime;
+    }
+
+    result += wxString::Format(wxS(", \"actual_page_size\": %ld, \"db_bytes\": %.0f"), actualPageSize, dbBytes);
+    result += wxS(", \"open_usec_avg\": ") + (openTotal / m_opens).ToString();
+    result += wxS(", \"open_usec_min\": ") + openMin.ToString();
+    result += wxS(", \"write_usec\": ") + writeTime.ToString();
+    result += wxS(", \"write_mb_per_sec\": ") + JsonThroughput(dbBytes, writeTime);
+    result += wxS(", \"scan_usec\": ") + scanTime.ToString();
+    result += wxS(", \"scan_mb_per_sec\": ") + JsonThroughput(dbBytes, scanTime);
+    result += wxS(", \"encrypt_mb_per_sec\": ") + ((cipher != NULL) ? JsonThroughput(dbBytes, writeTime - m_plainWrite) : wxString(wxS("null")));
+    result += wxS(", \"decrypt_mb_per_sec\": ") + ((cipher != NULL) ? JsonThroughput(dbBytes, scanTime - m_plainScan) : wxString(wxS("null")));
+  }
+  catch (wxSQLite3Exception& e)
+  {
+    if (db.IsOpen())
+    {
+      db.Close();
+    }
+    result += wxS(", \"error\": ") + JsonString(e.GetMessage());
+  }
+  result += wxS(" }");
+
+  if (!m_results.IsEmpty())
+  {
+    m_results += wxS(",\n");
+  }
+  m_results += result;
+}
+
+void CipherBench::RunPageSize(long pageSize)
+{
+  size_t k;
+
+  // Unencrypted baseline
+  RunCipher(NULL, pageSize, 0, -1, false);
+
+  // AES 128 bit CBC, no KDF iterations
+  int legacy;
+  for (legacy = 0; legacy < 2; ++legacy)
+  {
+    wxSQLite3CipherAes128 aes128;
+    aes128.SetLegacy(legacy != 0);
+    aes128.SetLegacyPageSize((legacy != 0) ? pageSize : 0);
+    RunCipher(&aes128, pageSize, 0, -1, legacy != 0);
+  }
+
+  for (k = 0; k < m_kdfIters.GetCount(); ++k)
+  {
+    int kdfIter = m_kdfIters[k];
+    for (legacy = 0; legacy < 2; ++legacy)
+    {
+      if (IsValidKdfIter(WXSQLITE_CIPHER_AES256, kdfIter))
+      {
+        wxSQLite3CipherAes256 aes256;
+        aes256.SetLegacy(legacy != 0);
+        aes256.SetLegacyPageSize((legacy != 0) ? pageSize : 0);
+        if (kdfIter > 0) aes256.SetKdfIter(kdfIter);
+        RunCipher(&aes256, pageSize, aes256.GetKdfIter(), -1, legacy != 0);
+      }
+      if (IsValidKdfIter(WXSQLITE_CIPHER_CHACHA20, kdfIter))
+      {
+        wxSQLite3CipherChaCha20 chacha20;
+        chacha20.SetLegacy(legacy != 0);
+        chacha20.SetLegacyPageSize((legacy != 0) ? pageSize : 0);
+        if (kdfIter > 0) chacha20.SetKdfIter(kdfIter);
+        RunCipher(&chacha20, pageSize, chacha20.GetKdfIter(), -1, legacy != 0);
+      }
+    }
+
+    // SQLCipher with and without HMAC, and in the original SQLCipher 4 format
+    if (IsValidKdfIter(WXSQLITE_CIPHER_SQLCIPHER, kdfIter))
+    {
+      int hmac;
+      for (hmac = 1; hmac >= 0; --hmac)
+      {
+        wxSQLite3CipherSQLCipher sqlCipher;
+        sqlCipher.SetHmacUse(hmac != 0);
+        if (kdfIter > 0) sqlCipher.SetKdfIter(kdfIter);
+        RunCipher(&sqlCipher, pageSize, sqlCipher.GetKdfIter(), hmac, false);
+      }
+      wxSQLite3CipherSQLCipher sqlCipher4;
+      sqlCipher4.InitializeVersionDefault(4);
+      sqlCipher4.SetLegacyPageSize(pageSize);
+      if (kdfIter > 0) sqlCipher4.SetKdfIter(kdfIter);
+      RunCipher(&sqlCipher4, pageSize, sqlCipher4.GetKdfIter(), sqlCipher4.GetHmacUse() ? 1 : 0, true);
+    }
+
+    if (IsValidKdfIter(WXSQLITE_CIPHER_ASCON128, kdfIter))
+    {
+      wxSQLite3CipherAscon128 ascon128;
+      if (kdfIter > 0) ascon128.SetKdfIter(kdfIter);
+      RunCipher(&ascon128, pageSize, ascon128.GetKdfIter(), -1, false);
+    }
+  }
+
+  // RC4 (legacy only, no KDF iterations)
+  wxSQLite3CipherRC4 rc4;
+  rc4.SetLegacyPageSize(pageSize);
+  RunCipher(&rc4, pageSize, 0, -1, true);
+
+  // Aegis, key derivation by Argon2 with default cost parameters
+  wxSQLite3CipherAegis aegis;
+  RunCipher(&aegis, pageSize, 0, -1, false);
+}
+
+int CipherBench::OnRun()
+{
+  wxString json;
+  try
+  {
+    wxSQLite3Database::InitializeSQLite();
+    if (!wxSQLite3Database::HasEncryptionSupport())
+    {
+      cerr << "wxSQLite3 was built without encryption support" << endl;
+      m_rc = 1;
+      return m_rc;
+    }
+
+    // Pseudo random payload, so that page contents are not trivially compressible
+    unsigned char* data = (unsigned char*) m_payload.GetWriteBuf(m_rowSize);
+    unsigned long seed = 4711;
+    long j;
+    for (j = 0; j < m_rowSize; ++j)
+    {
+      seed = seed * 1103515245UL + 12345UL;
+      data[j] = (unsigned char) ((seed >> 16) & 0xff);
+    }
+    m_payload.UngetWriteBuf(m_rowSize);
+
+    size_t k;
+    for (k = 0; k < m_pageSizes.GetCount(); ++k)
+    {
+      RunPageSize(m_pageSizes[k]);
+    }
+    wxRemoveFile(m_dbName);
+
+    json = wxS("{\n");
+    json += wxS("  \"benchmark\": \"cipherbench\",\n");
+    json += wxS("  \"wxsqlite3_version\": \"") + wxSQLite3Database::GetWrapperVersion() + wxS("\",\n");
+    json += wxS("  \"sqlite_version\": \"") + wxSQLite3Database::GetVersion() + wxS("\",\n");
+    json += wxString::Format(wxS("  \"parameters\": { \"rows\": %ld, \"row_size\": %ld, \"opens\": %ld },\n"),
+                             m_rows, m_rowSize, m_opens);
+    json += wxS("  \"results\": [\n") + m_results + wxS("\n  ]\n");
+    json += wxS("}\n");
+
+    wxSQLite3Database::ShutdownSQLite();
+  }
+  catch (wxSQLite3Exception& e)
+  {
+    cerr << e.GetErrorCode() << ":" << (const char*)(e.GetMessage().mb_str()) << endl;
+    m_rc = 1;
+    return m_rc;
+  }
+
+  if (m_output.IsEmpty())
+  {
+    cout << (const char*) json.utf8_str();
+  }
+  else
+  {
+    wxFFile file(m_output, wxS("w"));
+    if (!file.IsOpened() || !file.Write(json, wxConvUTF8))
+    {
+      cerr << "Writing the results to '" << (const char*) m_output.mb_str() << "' failed" << endl;
+      m_rc = 1;
+    }
+  }
+  return m_rc;
+}
+
+DECLARE_APP(CipherBench)
+IMPLEMENT_APP_CONSOLE(CipherBench)
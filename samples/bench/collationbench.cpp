@@ -0,0 +1,189 @@
+/*
+** Name:        collationbench.cpp
+** Purpose:     Benchmark for the Unicode case-insensitive collation and LIKE
+** Author:      Ulrich Telle
+** Created:     2026-10-18
+** Copyright:   (c) 2026 Ulrich Telle
+** License:     LGPL-3.0+ WITH WxWindows-exception-3.1
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+#ifdef __BORLANDC__
+#pragma hdrstop
+#endif
+
+#ifndef WX_PRECOMP
+#include "wx/wx.h"
+#endif
+
+#include <wx/cmdline.h>
+#include <wx/stopwatch.h>
+
+#include "wx/wxsqlite3.h"
+#include <iostream>
+
+using namespace std;
+
+// Case-insensitive collation based on wxString, as used before the native collation was available
+class WxStringNoCaseCollation : public wxSQLite3Collation
+{
+public:
+  virtual int Compare(const wxString& text1, const wxString& text2)
+  {
+    return text1.CmpNoCase(text2);
+  }
+};
+
+class CollationBench : public wxAppConsole
+{
+public:
+  bool OnInit();
+  int OnExit();
+  int OnRun();
+
+private:
+  void CreateData(wxSQLite3Database& db);
+  long TimeQuery(wxSQLite3Database& db, const wxString& sql, wxString& result);
+
+  long m_rows;
+  long m_wordLength;
+  int  m_rc;
+};
+
+static const wxCmdLineEntryDesc cmdLineDesc[] =
+{
+#if wxCHECK_VERSION(2,9,0)
+  { wxCMD_LINE_OPTION, "r", "rows",   "Number of rows (default: 200000)",       wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "l", "length", "Approximate text length (default: 40)",  wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+#else
+  { wxCMD_LINE_OPTION, wxS("r"), wxS("rows"),   wxS("Number of rows (default: 200000)"),      wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("l"), wxS("length"), wxS("Approximate text length (default: 40)"), wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+#endif
+  { wxCMD_LINE_NONE }
+};
+
+// Words (UTF-8) used to compose the test data, mostly ASCII with some non-ASCII text
+static const char* words[] =
+{
+  "Alpha", "bravo", "CHARLIE", "delta", "Echo", "foxtrot", "Golf", "hotel", "INDIA", "juliett",
+  "Kilo", "lima", "MIKE", "november", "Oscar", "papa", "Quebec", "romeo", "Sierra", "tango",
+  "\xc3\x84rger", "\xc3\xa4rger", "Stra\xc3\x9f" "e", "\xce\xa3\xce\x99\xce\x93\xce\x9c\xce\x91", "\xcf\x83\xce\xb9\xce\xb3\xce\xbc\xce\xb1"
+};
+
+bool CollationBench::OnInit()
+{
+  m_rc = 0;
+  m_rows = 200000;
+  m_wordLength = 40;
+  wxCmdLineParser parser(cmdLineDesc, argc, argv);
+  parser.SetLogo(wxS("wxSQLite3 Unicode Collation Benchmark\n"));
+  bool ok = parser.Parse() == 0;
+  if (ok)
+  {
+    parser.Found(wxS("rows"), &m_rows);
+    parser.Found(wxS("length"), &m_wordLength);
+  }
+  else
+  {
+    m_rc = -1;
+  }
+  return ok;
+}
+
+int CollationBench::OnExit()
+{
+  return m_rc;
+}
+
+void CollationBench::CreateData(wxSQLite3Database& db)
+{
+  const size_t numWords = sizeof(words) / sizeof(words[0]);
+  unsigned long seed = 4711;
+  db.ExecuteUpdate(wxS("CREATE TABLE names (id INTEGER PRIMARY KEY, name TEXT)"));
+  wxSQLite3Statement stmt = db.PrepareStatement(wxS("INSERT INTO names (name) VALUES (?)"));
+  db.Begin();
+  long row;
+  for (row = 0; row < m_rows; ++row)
+  {
+    wxString text;
+    while ((long) text.Len() < m_wordLength)
+    {
+      // Simple linear congruential generator for reproducible data
+      seed = seed * 1103515245UL + 12345UL;
+      text += wxString::FromUTF8(words[((seed >> 16) & 0x7fff) % numWords]);
+      text += wxS(" ");
+    }
+    stmt.Bind(1, text);
+    stmt.ExecuteUpdate();
+    stmt.Reset();
+  }
+  db.Commit();
+}
+
+long CollationBench::TimeQuery(wxSQLite3Database& db, const wxString& sql, wxString& result)
+{
+  wxStopWatch sw;
+  wxSQLite3ResultSet rs = db.ExecuteQuery(sql);
+  long rows = 0;
+  while (rs.NextRow())
+  {
+    if (rows == 0)
+    {
+      result = rs.GetAsString(0);
+    }
+    ++rows;
+  }
+  long elapsed = sw.Time();
+  cout << "  " << (const char*) sql.mb_str(wxConvUTF8) << endl;
+  cout << "    " << elapsed << " ms, first result: " << (const char*) result.mb_str(wxConvUTF8) << endl;
+  return elapsed;
+}
+
+int CollationBench::OnRun()
+{
+  WxStringNoCaseCollation wxNoCase;
+  try
+  {
+    wxSQLite3Database::InitializeSQLite();
+    wxSQLite3Database db;
+    db.Open(wxS(":memory:"));
+    CreateData(db);
+    db.SetCollation(wxS("WXNOCASE"), &wxNoCase);
+    db.SetUnicodeNoCaseCollation();
+
+    wxString result;
+    cout << "Sorting " << m_rows << " rows" << endl;
+    long timeWx = TimeQuery(db, wxS("SELECT name FROM names ORDER BY name COLLATE WXNOCASE"), result);
+    long timeNative = TimeQuery(db, wxS("SELECT name FROM names ORDER BY name COLLATE UNICODE_NOCASE"), result);
+    TimeQuery(db, wxS("SELECT name FROM names ORDER BY name COLLATE NOCASE"), result);
+    if (timeNative > 0)
+    {
+      cout << "  Speedup over wxString collation: " << (double) timeWx / timeNative << endl;
+    }
+
+    cout << endl << "LIKE with built-in functions (ASCII case folding)" << endl;
+    TimeQuery(db, wxS("SELECT count(*) FROM names WHERE name LIKE '%oscar%'"), result);
+    TimeQuery(db, wxString::FromUTF8("SELECT count(*) FROM names WHERE name LIKE '%\xc3\xa4rger%'"), result);
+    TimeQuery(db, wxS("SELECT count(*) FROM names WHERE name GLOB '*Oscar*'"), result);
+
+    db.SetUnicodeLikeFunctions();
+    cout << endl << "LIKE with Unicode functions" << endl;
+    TimeQuery(db, wxS("SELECT count(*) FROM names WHERE name LIKE '%oscar%'"), result);
+    TimeQuery(db, wxString::FromUTF8("SELECT count(*) FROM names WHERE name LIKE '%\xc3\xa4rger%'"), result);
+    TimeQuery(db, wxS("SELECT count(*) FROM names WHERE name GLOB '*Oscar*'"), result);
+
+    db.Close();
+    wxSQLite3Database::ShutdownSQLite();
+  }
+  catch (wxSQLite3Exception& e)
+  {
+    cerr << e.GetErrorCode() << ":" << (const char*)(e.GetMessage().mb_str()) << endl;
+    m_rc = 1;
+  }
+  return m_rc;
+}
+
+DECLARE_APP(CollationBench)
+IMPLEMENT_APP_CONSOLE(CollationBench)
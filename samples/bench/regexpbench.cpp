@@ -0,0 +1,225 @@
+/*
+** Name:        regexpbench.cpp
+** Purpose:     Benchmark for REGEXP searches with and without trigram index
+** Author:      Ulrich Telle
+** Created:     2026-10-18
+** Copyright:   (c) 2026 Ulrich Telle
+** License:     LGPL-3.0+ WITH WxWindows-exception-3.1
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+#ifdef __BORLANDC__
+#pragma hdrstop
+#endif
+
+#ifndef WX_PRECOMP
+#include "wx/wx.h"
+#endif
+
+#include <wx/cmdline.h>
+#include <wx/stopwatch.h>
+
+#include "wx/wxsqlite3.h"
+#include <iostream>
+
+using namespace std;
+
+class RegExpBench : public wxAppConsole
+{
+public:
+  bool OnInit();
+  int OnExit();
+  int OnRun();
+
+private:
+  void CreateData(wxSQLite3Database& db);
+#if wxUSE_REGEX
+  void RunPattern(wxSQLite3Database& db, wxSQLite3TrigramIndex& index, const wxString& pattern);
+#endif
+
+  wxString m_dbFile;
+  long     m_rows;
+  long     m_lineLength;
+  long     m_plainTotal;
+  long     m_indexTotal;
+  int      m_rc;
+};
+
+static const wxCmdLineEntryDesc cmdLineDesc[] =
+{
+#if wxCHECK_VERSION(2,9,0)
+  { wxCMD_LINE_OPTION, "d", "database", "Database file (default: regexpbench.db)", wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "r", "rows",     "Number of rows (default: 200000)",        wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "l", "length",   "Approximate line length (default: 200)",  wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+#else
+  { wxCMD_LINE_OPTION, wxS("d"), wxS("database"), wxS("Database file (default: regexpbench.db)"), wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("r"), wxS("rows"),     wxS("Number of rows (default: 200000)"),        wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("l"), wxS("length"),   wxS("Approximate line length (default: 200)"),  wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+#endif
+  { wxCMD_LINE_NONE }
+};
+
+// Words used to compose the log lines of the test data
+static const char* words[] =
+{
+  "connection", "request", "timeout", "user", "session", "started", "finished", "error",
+  "warning", "info", "database", "query", "cache", "miss", "hit", "retry", "socket", "closed",
+  "handler", "worker", "thread", "queue", "payload", "checksum", "invalid", "token", "expired"
+};
+
+// Patterns used for the benchmark; the last one can not use the trigram index
+static const char* patterns[] =
+{
+  "timeout after [0-9]+ ms",
+  "checksum invalid.*retry",
+  "^error socket",
+  "sess(ion)? expired",
+  "[0-9]{3}-[0-9]{4}"
+};
+
+bool RegExpBench::OnInit()
+{
+  m_rc = 0;
+  m_dbFile = wxS("regexpbench.db");
+  m_rows = 200000;
+  m_lineLength = 200;
+  m_plainTotal = 0;
+  m_indexTotal = 0;
+  wxCmdLineParser parser(cmdLineDesc, argc, argv);
+  parser.SetLogo(wxS("wxSQLite3 REGEXP Trigram Index Benchmark\n"));
+  bool ok = parser.Parse() == 0;
+  if (ok)
+  {
+    parser.Found(wxS("database"), &m_dbFile);
+    parser.Found(wxS("rows"), &m_rows);
+    parser.Found(wxS("length"), &m_lineLength);
+  }
+  else
+  {
+    m_rc = -1;
+  }
+  return ok;
+}
+
+int RegExpBench::OnExit()
+{
+  return m_rc;
+}
+
+void RegExpBench::CreateData(wxSQLite3Database& db)
+{
+  const size_t numWords = sizeof(words) / sizeof(words[0]);
+  unsigned long seed = 4711;
+  db.ExecuteUpdate(wxS("CREATE TABLE logs (id INTEGER PRIMARY KEY, line TEXT)"));
+  wxSQLite3Statement stmt = db.PrepareStatement(wxS("INSERT INTO logs (line) VALUES (?)"));
+  wxStopWatch sw;
+  db.Begin();
+  long row;
+  for (row = 0; row < m_rows; ++row)
+  {
+    wxString line;
+    while ((long) line.Len() < m_lineLength)
+    {
+      // Simple linear congruential generator for reproducible data
+      seed = seed * 1103515245UL + 12345UL;
+      unsigned long r = (seed >> 16) & 0x7fff;
+      line += wxString::FromAscii(words[r % numWords]);
+      if (r % 97 == 0)
+      {
+        line += wxString::Format(wxS(" after %lu ms"), r % 5000);
+      }
+      line += wxS(" ");
+    }
+    stmt.Bind(1, line);
+    stmt.ExecuteUpdate();
+    stmt.Reset();
+  }
+  db.Commit();
+  cout << "Inserted " << m_rows << " rows in " << sw.Time() << " ms" << endl;
+}
+
+#if wxUSE_REGEX
+void RegExpBench::RunPattern(wxSQLite3Database& db, wxSQLite3TrigramIndex& index, const wxString& pattern)
+{
+  long plainCount = 0;
+  long indexCount = 0;
+  wxStopWatch sw;
+
+  wxSQLite3Statement stmt = db.PrepareStatement(wxS("SELECT count(*) FROM logs WHERE line REGEXP ?"));
+  stmt.Bind(1, pattern);
+  wxSQLite3ResultSet plain = stmt.ExecuteQuery();
+  plainCount = plain.GetInt(0);
+  long plainTime = sw.Time();
+
+  sw.Start();
+  wxSQLite3ResultSet indexed = index.Search(pattern, wxS("count(*)"));
+  indexCount = indexed.GetInt(0);
+  long indexTime = sw.Time();
+
+  wxString matchExpression = wxSQLite3TrigramIndex::GetMatchExpression(pattern);
+  cout << "Pattern: " << (const char*) pattern.mb_str(wxConvUTF8) << endl;
+  cout << "  Match expression: " << (matchExpression.IsEmpty() ? "(none)" : (const char*) matchExpression.mb_str(wxConvUTF8)) << endl;
+  cout << "  Full scan:     " << plainCount << " rows, " << plainTime << " ms" << endl;
+  cout << "  Trigram index: " << indexCount << " rows, " << indexTime << " ms" << endl;
+  if (indexTime > 0)
+  {
+    cout << "  Speedup over full scan: " << (double) plainTime / indexTime << endl;
+  }
+  m_plainTotal += plainTime;
+  m_indexTotal += indexTime;
+  if (plainCount != indexCount)
+  {
+    cout << "  *** Result mismatch ***" << endl;
+    m_rc = 1;
+  }
+}
+#endif
+
+int RegExpBench::OnRun()
+{
+#if wxUSE_REGEX
+  wxSQLite3RegExpOperator regExpOp;
+  try
+  {
+    wxSQLite3Database::InitializeSQLite();
+    if (wxFileExists(m_dbFile))
+    {
+      wxRemoveFile(m_dbFile);
+    }
+    wxSQLite3Database db;
+    db.Open(m_dbFile);
+    db.CreateFunction(wxS("regexp"), 2, regExpOp, WXSQLITE_DETERMINISTIC);
+    CreateData(db);
+
+    wxSQLite3TrigramIndex index(&db, wxS("logs"), wxS("line"));
+    wxStopWatch sw;
+    index.Create();
+    cout << "Created trigram index in " << sw.Time() << " ms" << endl << endl;
+
+    size_t j;
+    for (j = 0; j < sizeof(patterns) / sizeof(patterns[0]); ++j)
+    {
+      RunPattern(db, index, wxString::FromUTF8(patterns[j]));
+    }
+    if (m_indexTotal > 0)
+    {
+      cout << endl << "Overall speedup over full scan: " << (double) m_plainTotal / m_indexTotal << endl;
+    }
+    db.Close();
+    wxSQLite3Database::ShutdownSQLite();
+  }
+  catch (wxSQLite3Exception& e)
+  {
+    cerr << e.GetErrorCode() << ":" << (const char*)(e.GetMessage().mb_str()) << endl;
+    m_rc = 1;
+  }
+#else
+  cout << "Regular expression support not available" << endl;
+#endif
+  return m_rc;
+}
+
+DECLARE_APP(RegExpBench)
+IMPLEMENT_APP_CONSOLE(RegExpBench)
@@ -0,0 +1,788 @@
+/*
+** Name:        walstress.cpp
+** Purpose:     Multi-threaded concurrency stress and latency benchmark in WAL mode
+** Author:      Ulrich Telle
+** Created:     2026-10-18
+** Copyright:   (c) 2026 Ulrich Telle
+** License:     LGPL-3.0+ WITH WxWindows-exception-3.1
+*/
+
+/*
+** The stress test runs a configurable number of reader and writer threads for a
+** fixed duration. Each thread uses its own wxSQLite3Database connection to a shared
+** database in WAL mode. Readers execute short range scans; writers execute
+** transactions of configurable size (BEGIN IMMEDIATE, mix of updates and inserts),
+** optionally interleaved with reads.
+**
+** Checkpoint policies:
+** - auto:     the committing writer runs a passive checkpoint as soon as the WAL
+**             contains at least --autocheckpoint frames (like SQLite's built-in
+**             auto-checkpoint, but timed)
+** - none:     no checkpoints at all, the WAL grows unbounded
+** - passive, full, restart, truncate:
+**             a dedicated thread runs checkpoints of the given mode every
+**             --interval milliseconds
+**
+** The report contains latency percentiles for reads and writes, the number of
+** SQLITE_BUSY/SQLITE_LOCKED failures, checkpoint statistics (duration percentiles
+** as a measure of checkpoint stalls) and the size of the WAL file sampled over
+** time. The results are written as a single JSON document to stdout (or to the
+** file given with --output). The default duration keeps a run within a CI time budget.
+** With --trace the activity of all connections (statement steps, transactions,
+** checkpoints, busy waits, WAL hook invocations) is additionally written as a
+** Chrome trace event file, which can be opened in Perfetto (https://ui.perfetto.dev).
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+#ifdef __BORLANDC__
+#pragma hdrstop
+#endif
+
+#ifndef WX_PRECOMP
+#include "wx/wx.h"
+#endif
+
+#include <wx/cmdline.h>
+#include <wx/ffile.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/stopwatch.h>
+#include <wx/thread.h>
+
+#include "wx/wxsqlite3.h"
+#include <iostream>
+
+using namespace std;
+
+// SQLite result codes counted as contention
+enum
+{
+  STRESS_SQLITE_BUSY   = 5,
+  STRESS_SQLITE_LOCKED = 6
+};
+
+// Log-linear latency histogram (8 sub-buckets per power of two, about 12% resolution)
+class LatencyHistogram
+{
+public:
+  LatencyHistogram() : m_count(0), m_max(0)
+  {
+    memset(m_buckets, 0, sizeof(m_buckets));
+  }
+
+  void Record(wxLongLong usec)
+  {
+    wxLongLong_t value = (usec > 0) ? usec.GetValue() : 0;
+    ++m_buckets[BucketIndex(value)];
+    ++m_count;
+    if (value > m_max) m_max = value;
+  }
+
+  void Merge(const LatencyHistogram& other)
+  {
+    int j;
+    for (j = 0; j < NUM_BUCKETS; ++j)
+    {
+      m_buckets[j] += other.m_buckets[j];
+    }
+    m_count += other.m_count;
+    if (other.m_max > m_max) m_max = other.m_max;
+  }
+
+  // Returns the upper bound of the bucket containing the requested percentile
+  wxLongLong_t Percentile(double percentile) const
+  {
+    if (m_count == 0) return 0;
+    wxLongLong_t rank = (wxLongLong_t) (percentile / 100.0 * m_count + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank >= m_count) return m_max;
+    wxLongLong_t seen = 0;
+    int j;
+    for (j = 0; j < NUM_BUCKETS; ++j)
+    {
+      seen += m_buckets[j];
+      if (seen >= rank)
+      {
+        wxLongLong_t upper = BucketUpperBound(j);
+        return (upper < m_max) ? upper : m_max;
+      }
+    }
+    return m_max;
+  }
+
+  wxLongLong_t GetCount() const { return m_count; }
+
+  wxString ToJSON() const
+  {
+    return wxString::Format(wxS("{ \"count\": %s, \"p50\": %s, \"p90\": %s, \"p99\": %s, \"p999\": %s, \"max\": %s }"),
+                            wxLongLong(m_count).ToString().c_str(),
+                            wxLongLong(Percentile(50)).ToString().c_str(),
+                            wxLongLong(Percentile(90)).ToString().c_str(),
+                            wxLongLong(Percentile(99)).ToString().c_str(),
+                            wxLongLong(Percentile(99.9)).ToString().c_str(),
+                            wxLongLong(m_max).ToString().c_str());
+  }
+
+private:
+  enum { NUM_BUCKETS = 8 * 61 };
+
+  static int BucketIndex(wxLongLong_t value)
+  {
+    if (value < 8) return (int) value;
+    int msb = 0;
+    while ((value >> (msb + 1)) != 0) ++msb;
+    int sub = (int) ((value >> (msb - 3)) & 7);
+    return (msb - 2) * 8 + sub;
+  }
+
+  static wxLongLong_t BucketUpperBound(int index)
+  {
+    if (index < 8) return index;
+    int msb = index / 8 + 2;
+    int sub = index % 8;
+    return ((wxLongLong_t) (9 + sub) << (msb - 3)) - 1;
+  }
+
+  wxLongLong_t m_buckets[NUM_BUCKETS];
+  wxLongLong_t m_count;
+  wxLongLong_t m_max;
+};
+
+// Shared state of a stress run
+class StressContext
+{
+public:
+  StressContext() : m_stopped(false), m_checkpointBusy(0), m_checkpointErrors(0), m_checkpointFrames(0) {}
+
+  bool IsStopped()
+  {
+    wxCriticalSectionLocker lock(m_lock);
+    return m_stopped;
+  }
+
+  void Stop()
+  {
+    wxCriticalSectionLocker lock(m_lock);
+    m_stopped = true;
+  }
+
+  // Runs a timed checkpoint and records its statistics
+  void Checkpoint(wxSQLite3Database& db, int mode)
+  {
+    int logFrames = 0;
+    int checkpointedFrames = 0;
+    bool busy = false;
+    bool failed = false;
+    wxStopWatch sw;
+    try
+    {
+      db.WriteAheadLogCheckpoint(wxEmptyString, mode, &logFrames, &checkpointedFrames);
+    }
+    catch (wxSQLite3Exception& e)
+    {
+      busy = e.GetErrorCode() == STRESS_SQLITE_BUSY || e.GetErrorCode() == STRESS_SQLITE_LOCKED;
+      failed = !busy;
+    }
+#if wxCHECK_VERSION(2,9,3)
+    wxLongLong elapsed = sw.TimeInMicro();
+#else
+    wxLongLong elapsed = wxLongLong(sw.Time()) * 1000;
+#endif
+    wxCriticalSectionLocker lock(m_lock);
+    m_checkpointTimes.Record(elapsed);
+    if (busy) ++m_checkpointBusy;
+    if (failed) ++m_checkpointErrors;
+    if (checkpointedFrames > 0) m_checkpointFrames += checkpointedFrames;
+  }
+
+  wxString CheckpointsToJSON()
+  {
+    wxCriticalSectionLocker lock(m_lock);
+    return wxString::Format(wxS("{ \"busy\": %ld, \"errors\": %ld, \"frames\": %s, \"duration_usec\": %s }"),
+                            m_checkpointBusy, m_checkpointErrors,
+                            wxLongLong(m_checkpointFrames).ToString().c_str(), m_checkpointTimes.ToJSON().c_str());
+  }
+
+private:
+  wxCriticalSection m_lock;
+  bool              m_stopped;
+  LatencyHistogram  m_checkpointTimes;
+  long              m_checkpointBusy;
+  long              m_checkpointErrors;
+  wxLongLong_t      m_checkpointFrames;
+};
+
+// WAL hook running timed passive checkpoints, replacing SQLite's built-in auto-checkpoint
+class AutoCheckpointHook : public wxSQLite3Hook
+{
+public:
+  AutoCheckpointHook(StressContext& context, int threshold) : m_context(context), m_threshold(threshold) {}
+
+  virtual int WriteAheadLogCallback(const wxString& WXUNUSED(database), int numPages)
+  {
+    if (numPages >= m_threshold)
+    {
+      m_context.Checkpoint(*GetDatabase(), WXSQLITE_CHECKPOINT_PASSIVE);
+    }
+    return 0;
+  }
+
+private:
+  StressContext& m_context;
+  int            m_threshold;
+};
+
+// Parameters of a stress run
+struct StressParameters
+{
+  wxString dbName;
+  long     rows;
+  long     txSize;
+  long     writePercent;
+  long     busyTimeout;
+  long     autoCheckpoint;
+  bool     autoPolicy;
+  wxSQLite3EventRecorder* recorder;
+};
+
+// Worker thread executing reads and write transactions on its own connection
+class StressWorker : public wxThread
+{
+public:
+  StressWorker(StressContext& context, const StressParameters& params, bool writer, unsigned long seed)
+    : wxThread(wxTHREAD_JOINABLE), m_context(context), m_params(params), m_writer(writer), m_seed(seed),
+      m_reads(0), m_writes(0), m_busy(0), m_errors(0)
+  {
+  }
+
+  virtual ExitCode Entry();
+
+  bool IsWriter() const { return m_writer; }
+  const LatencyHistogram& GetReadLatency() const { return m_readLatency; }
+  const LatencyHistogram& GetWriteLatency() const { return m_writeLatency; }
+  long GetBusyCount() const { return m_busy; }
+  long GetErrorCount() const { return m_errors; }
+  const wxString& GetFirstError() const { return m_firstError; }
+
+private:
+  long NextRandom(long range)
+  {
+    m_seed = m_seed * 1103515245UL + 12345UL;
+    return (long) (((m_seed >> 8) & 0xffffff) % range);
+  }
+
+  void Read(wxSQLite3Statement& stmt);
+  void Write(wxSQLite3Database& db, wxSQLite3Statement& update, wxSQLite3Statement& insert);
+
+  StressContext&          m_context;
+  const StressParameters& m_params;
+  bool                    m_writer;
+  unsigned long           m_seed;
+  LatencyHistogram        m_readLatency;
+  LatencyHistogram        m_writeLatency;
+  long                    m_reads;
+  long                    m_writes;
+  long                    m_busy;
+  long                    m_errors;
+  wxString                m_firstError;
+};
+
+void StressWorker::Read(wxSQLite3Statement& stmt)
+{
+  stmt.Bind(1, (int) (NextRandom(m_params.rows) + 1));
+  wxSQLite3ResultSet rs = stmt.ExecuteQuery();
+  while (rs.NextRow())
+  {
+    rs.GetInt(0);
+  }
+  stmt.Reset();
+}
+
+void StressWorker::Write(wxSQLite3Database& db, wxSQLite3Statement& update, wxSQLite3Statement& insert)
+{
+  db.Begin(WXSQLITE_TRANSACTION_IMMEDIATE);
+  long j;
+  for (j = 0; j < m_params.txSize; ++j)
+  {
+    wxString text = wxString::Format(wxS("value %ld"), NextRandom(1000000));
+    wxSQLite3Statement& stmt = (NextRandom(2) == 0) ? update : insert;
+    stmt.Bind(1, text);
+    stmt.Bind(2, (int) (NextRandom(m_params.rows) + 1));
+    stmt.ExecuteUpdate();
+    stmt.Reset();
+  }
+  db.Commit();
+}
+
+wxThread::ExitCode StressWorker::Entry()
+{
+  wxSQLite3Database db;
+  AutoCheckpointHook hook(m_context, (int) m_params.autoCheckpoint);
+  try
+  {
+    db.Open(m_params.dbName);
+    db.SetBusyTimeout((int) m_params.busyTimeout);
+    if (m_params.recorder != NULL)
+    {
+      db.SetEventRecorder(m_params.recorder);
+    }
+    // Checkpoints are either run by the timed WAL hook, the checkpoint thread or not at all
+    db.AutoWriteAheadLogCheckpoint(0);
+    if (m_writer && m_params.autoPolicy)
+    {
+      db.SetWriteAheadLogHook(&hook);
+    }
+    wxSQLite3Statement read = db.PrepareStatement("SELECT id, v FROM kv WHERE id BETWEEN ?1 AND ?1 + 19");
+    wxSQLite3Statement update = db.PrepareStatement("UPDATE kv SET v = ?1 WHERE id = ?2");
+    wxSQLite3Statement insert = db.PrepareStatement("INSERT INTO kv (v, k) VALUES (?1, ?2)");
+
+    while (!m_context.IsStopped())
+    {
+      bool isWrite = m_writer && NextRandom(100) < m_params.writePercent;
+      wxStopWatch sw;
+      try
+      {
+        if (isWrite)
+        {
+          Write(db, update, insert);
+        }
+        else
+        {
+          Read(read);
+        }
+#if wxCHECK_VERSION(2,9,3)
+        wxLongLong elapsed = sw.TimeInMicro();
+#else
+        wxLongLong elapsed = wxLongLong(sw.Time()) * 1000;
+#endif
+        if (isWrite)
+        {
+          m_writeLatency.Record(elapsed);
+        }
+        else
+        {
+          m_readLatency.Record(elapsed);
+        }
+      }
+      catch (wxSQLite3Exception& e)
+      {
+        if (db.IsOpen() && !db.GetAutoCommit())
+        {
+          db.Rollback();
+        }
+        if (isWrite)
+        {
+          update.Reset();
+          insert.Reset();
+        }
+        else
+        {
+          read.Reset();
+        }
+        if (e.GetErrorCode() == STRESS_SQLITE_BUSY || e.GetErrorCode() == STRESS_SQLITE_LOCKED)
+        {
+          ++m_busy;
+        }
+        else
+        {
+          if (m_errors++ == 0) m_firstError = e.GetMessage();
+        }
+      }
+    }
+    read.Finalize();
+    update.Finalize();
+    insert.Finalize();
+    if (m_writer && m_params.autoPolicy)
+    {
+      db.SetWriteAheadLogHook(NULL);
+    }
+    db.Close();
+  }
+  catch (wxSQLite3Exception& e)
+  {
+    if (m_errors++ == 0) m_firstError = e.GetMessage();
+  }
+  return 0;
+}
+
+// Thread running checkpoints of a given mode in fixed intervals
+class CheckpointThread : public wxThread
+{
+public:
+  CheckpointThread(StressContext& context, const StressParameters& params, int mode, long interval)
+    : wxThread(wxTHREAD_JOINABLE), m_context(context), m_params(params), m_mode(mode), m_interval(interval)
+  {
+  }
+
+  virtual ExitCode Entry()
+  {
+    wxSQLite3Database db;
+    try
+    {
+      db.Open(m_params.dbName);
+      db.SetBusyTimeout((int) m_params.busyTimeout);
+      if (m_params.recorder != NULL)
+      {
+        db.SetEventRecorder(m_params.recorder);
+      }
+      db.AutoWriteAheadLogCheckpoint(0);
+      while (!m_context.IsStopped())
+      {
+        // Sleep in small steps to stop in time
+        long slept;
+        for (slept = 0; slept < m_interval && !m_context.IsStopped(); slept += 10)
+        {
+          wxThread::Sleep(10);
+        }
+        if (!m_context.IsStopped())
+        {
+          m_context.Checkpoint(db, m_mode);
+        }
+      }
+      db.Close();
+    }
+    catch (wxSQLite3Exception& e)
+    {
+      cerr << "Checkpoint thread: " << (const char*) e.GetMessage().mb_str() << endl;
+    }
+    return 0;
+  }
+
+private:
+  StressContext&          m_context;
+  const StressParameters& m_params;
+  int                     m_mode;
+  long                    m_interval;
+};
+
+class WalStress : public wxAppConsole
+{
+public:
+  bool OnInit();
+  int OnExit();
+  int OnRun();
+
+private:
+  void CreateDatabase();
+  wxLongLong WalSize();
+
+  StressParameters m_params;
+  wxString m_policy;
+  wxString m_output;
+  wxString m_trace;
+  long m_readers;
+  long m_writers;
+  long m_duration;
+  long m_interval;
+  long m_sampleInterval;
+  int  m_checkpointMode;
+  int  m_rc;
+};
+
+static const wxCmdLineEntryDesc cmdLineDesc[] =
+{
+#if wxCHECK_VERSION(2,9,0)
+  { wxCMD_LINE_OPTION, "r", "readers",        "Number of reader threads (default: 4)",                              wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "w", "writers",        "Number of writer threads (default: 2)",                              wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "p", "writepct",       "Percentage of write transactions of writer threads (default: 100)",  wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "x", "txsize",         "Statements per write transaction (default: 10)",                     wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "n", "rows",           "Number of initial rows (default: 10000)",                            wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "t", "duration",       "Duration in seconds (default: 10)",                                  wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "c", "checkpoint",     "Checkpoint policy: auto, none, passive, full, restart, truncate (default: auto)", wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "a", "autocheckpoint", "WAL frames triggering a checkpoint in policy auto (default: 1000)",   wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "i", "interval",       "Checkpoint interval in milliseconds for explicit policies (default: 500)", wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "b", "busytimeout",    "Busy timeout in milliseconds (default: 1000)",                       wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "s", "sample",         "WAL size sample interval in milliseconds (default: 250)",            wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "d", "database",       "Database file name (default: walstress.db)",                         wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "o", "output",         "JSON output file (default: stdout)",                                 wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "T", "trace",          "Chrome trace event file of the database activity (view with Perfetto)", wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+#else
+  { wxCMD_LINE_OPTION, wxS("r"), wxS("readers"),        wxS("Number of reader threads (default: 4)"),                              wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("w"), wxS("writers"),        wxS("Number of writer threads (default: 2)"),                              wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("p"), wxS("writepct"),       wxS("Percentage of write transactions of writer threads (default: 100)"),  wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("x"), wxS("txsize"),         wxS("Statements per write transaction (default: 10)"),                     wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("n"), wxS("rows"),           wxS("Number of initial rows (default: 10000)"),                            wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("t"), wxS("duration"),       wxS("Duration in seconds (default: 10)"),                                  wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("c"), wxS("checkpoint"),     wxS("Checkpoint policy: auto, none, passive, full, restart, truncate (default: auto)"), wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("a"), wxS("autocheckpoint"), wxS("WAL frames triggering a checkpoint in policy auto (default: 1000)"),   wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("i"), wxS("interval"),       wxS("Checkpoint interval in milliseconds for explicit policies (default: 500)"), wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("b"), wxS("busytimeout"),    wxS("Busy timeout in milliseconds (default: 1000)"),                       wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("s"), wxS("sample"),         wxS("WAL size sample interval in milliseconds (default: 250)"),            wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("d"), wxS("database"),       wxS("Database file name (default: walstress.db)"),                         wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("o"), wxS("output"),         wxS("JSON output file (default: stdout)"),                                 wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("T"), wxS("trace"),          wxS("Chrome trace event file of the database activity (view with Perfetto)"), wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+#endif
+  { wxCMD_LINE_NONE }
+};
+
+bool WalStress::OnInit()
+{
+  m_rc = 0;
+  m_readers = 4;
+  m_writers = 2;
+  m_duration = 10;
+  m_interval = 500;
+  m_sampleInterval = 250;
+  m_policy = wxS("auto");
+  m_params.dbName = wxS("walstress.db");
+  m_params.rows = 10000;
+  m_params.txSize = 10;
+  m_params.writePercent = 100;
+  m_params.busyTimeout = 1000;
+  m_params.autoCheckpoint = 1000;
+  m_params.recorder = NULL;
+  wxCmdLineParser parser(cmdLineDesc, argc, argv);
+  parser.SetLogo(wxS("wxSQLite3 WAL Concurrency Stress Test\n"));
+  bool ok = parser.Parse() == 0;
+  if (ok)
+  {
+    parser.Found(wxS("readers"), &m_readers);
+    parser.Found(wxS("writers"), &m_writers);
+    parser.Found(wxS("writepct"), &m_params.writePercent);
+    parser.Found(wxS("txsize"), &m_params.txSize);
+    parser.Found(wxS("rows"), &m_params.rows);
+    parser.Found(wxS("duration"), &m_duration);
+    parser.Found(wxS("checkpoint"), &m_policy);
+    parser.Found(wxS("autocheckpoint"), &m_params.autoCheckpoint);
+    parser.Found(wxS("interval"), &m_interval);
+    parser.Found(wxS("busytimeout"), &m_params.busyTimeout);
+    parser.Found(wxS("sample"), &m_sampleInterval);
+    parser.Found(wxS("database"), &m_params.dbName);
+    parser.Found(wxS("output"), &m_output);
+    parser.Found(wxS("trace"), &m_trace);
+
+    m_policy.MakeLower();
+    m_params.autoPolicy = (m_policy == wxS("auto"));
+    m_checkpointMode = -1;
+    if (m_policy == wxS("passive"))       m_checkpointMode = WXSQLITE_CHECKPOINT_PASSIVE;
+    else if (m_policy == wxS("full"))     m_checkpointMode = WXSQLITE_CHECKPOINT_FULL;
+    else if (m_policy == wxS("restart"))  m_checkpointMode = WXSQLITE_CHECKPOINT_RESTART;
+    else if (m_policy == wxS("truncate")) m_checkpointMode = WXSQLITE_CHECKPOINT_TRUNCATE;
+    else if (!m_params.autoPolicy && m_policy != wxS("none"))
+    {
+      cerr << "Unknown checkpoint policy '" << (const char*) m_policy.mb_str() << "'" << endl;
+      ok = false;
+    }
+    if (m_readers < 0 || m_writers < 0 || m_readers + m_writers < 1 ||
+        m_params.writePercent < 0 || m_params.writePercent > 100 || m_params.txSize < 1 ||
+        m_params.rows < 1 || m_duration < 1 || m_params.autoCheckpoint < 1 || m_interval < 1 ||
+        m_params.busyTimeout < 0 || m_sampleInterval < 10)
+    {
+      cerr << "Invalid stress test parameters" << endl;
+      ok = false;
+    }
+  }
+  if (!ok)
+  {
+    m_rc = -1;
+  }
+  return ok;
+}
+
+int WalStress::OnExit()
+{
+  return m_rc;
+}
+
+void WalStress::CreateDatabase()
+{
+  wxRemoveFile(m_params.dbName);
+  wxRemoveFile(m_params.dbName + wxS("-wal"));
+  wxRemoveFile(m_params.dbName + wxS("-shm"));
+  wxSQLite3Database db;
+  db.Open(m_params.dbName);
+  db.SetJournalMode(WXSQLITE_JOURNALMODE_WAL);
+  db.ExecuteUpdate("PRAGMA synchronous=NORMAL;");
+  db.ExecuteUpdate("CREATE TABLE kv (id INTEGER PRIMARY KEY, k INTEGER, v TEXT);");
+  wxSQLite3Statement stmt = db.PrepareStatement("INSERT INTO kv (k, v) VALUES (?, ?)");
+  db.Begin();
+  long row;
+  for (row = 1; row <= m_params.rows; ++row)
+  {
+    stmt.Bind(1, (int) row);
+    stmt.Bind(2, wxString::Format(wxS("value %ld"), row));
+    stmt.ExecuteUpdate();
+    stmt.Reset();
+  }
+  db.Commit();
+  db.ExecuteUpdate("CREATE INDEX kv_k ON kv (k);");
+  stmt.Finalize();
+  db.WriteAheadLogCheckpoint(wxEmptyString, WXSQLITE_CHECKPOINT_TRUNCATE);
+  db.Close();
+}
+
+wxLongLong WalStress::WalSize()
+{
+  wxString walName = m_params.dbName + wxS("-wal");
+  if (!wxFileExists(walName))
+  {
+    return 0;
+  }
+  wxULongLong size = wxFileName::GetSize(walName);
+  return (size == wxInvalidSize) ? wxLongLong(0) : wxLongLong(size.GetHi(), size.GetLo());
+}
+
+int WalStress::OnRun()
+{
+  StressContext context;
+  wxString json;
+  try
+  {
+    wxSQLite3Database::InitializeSQLite();
+    CreateDatabase();
+  }
+  catch (wxSQLite3Exception& e)
+  {
+    cerr << e.GetErrorCode() << ":" << (const char*)(e.GetMessage().mb_str()) << endl;
+    m_rc = 1;
+    return m_rc;
+  }
+
+  // Record the activity of all connections on a per-thread timeline
+  wxSQLite3EventRecorder* recorder = NULL;
+  if (!m_trace.IsEmpty())
+  {
+    recorder = new wxSQLite3EventRecorder(65536);
+    recorder->Start();
+    m_params.recorder = recorder;
+  }
+
+  // Start the worker threads
+  StressWorker** workers = new StressWorker*[m_readers + m_writers];
+  long numWorkers = 0;
+  long j;
+  for (j = 0; j < m_readers + m_writers; ++j)
+  {
+    StressWorker* worker = new StressWorker(context, m_params, j >= m_readers, 4711 + 17 * j);
+    if (worker->Create() != wxTHREAD_NO_ERROR || worker->Run() != wxTHREAD_NO_ERROR)
+    {
+      cerr << "Failed to start worker thread" << endl;
+      delete worker;
+      m_rc = 1;
+      break;
+    }
+    workers[numWorkers++] = worker;
+  }
+  CheckpointThread* checkpointer = NULL;
+  if (m_rc == 0 && m_checkpointMode >= 0)
+  {
+    checkpointer = new CheckpointThread(context, m_params, m_checkpointMode, m_interval);
+    if (checkpointer->Create() != wxTHREAD_NO_ERROR || checkpointer->Run() != wxTHREAD_NO_ERROR)
+    {
+      cerr << "Failed to start checkpoint thread" << endl;
+      delete checkpointer;
+      checkpointer = NULL;
+      m_rc = 1;
+    }
+  }
+
+  // Sample the WAL size until the duration has elapsed
+  wxString samples;
+  wxLongLong walMax = 0;
+  wxStopWatch sw;
+  while (m_rc == 0 && sw.Time() < m_duration * 1000)
+  {
+    wxThread::Sleep(m_sampleInterval);
+    wxLongLong walSize = WalSize();
+    if (walSize > walMax) walMax = walSize;
+    if (!samples.IsEmpty()) samples += wxS(", ");
+    samples += wxString::Format(wxS("[%ld, %s]"), sw.Time(), walSize.ToString().c_str());
+  }
+  long elapsedMs = sw.Time();
+  context.Stop();
+
+  // Wait for all threads and merge their statistics
+  LatencyHistogram readLatency;
+  LatencyHistogram writeLatency;
+  long busy = 0;
+  long errors = 0;
+  wxString firstError;
+  for (j = 0; j < numWorkers; ++j)
+  {
+    workers[j]->Wait();
+    readLatency.Merge(workers[j]->GetReadLatency());
+    writeLatency.Merge(workers[j]->GetWriteLatency());
+    busy += workers[j]->GetBusyCount();
+    if (errors == 0 && workers[j]->GetErrorCount() > 0)
+    {
+      firstError = workers[j]->GetFirstError();
+    }
+    errors += workers[j]->GetErrorCount();
+    delete workers[j];
+  }
+  delete [] workers;
+  if (checkpointer != NULL)
+  {
+    checkpointer->Wait();
+    delete checkpointer;
+  }
+  if (recorder != NULL)
+  {
+    recorder->Stop();
+    if (recorder->GetDroppedEventCount() > 0)
+    {
+      cerr << "Trace buffers overflowed, the earliest events are missing" << endl;
+    }
+    if (!recorder->WriteTrace(m_trace))
+    {
+      cerr << "Writing the trace to '" << (const char*) m_trace.mb_str() << "' failed" << endl;
+      m_rc = 1;
+    }
+    m_params.recorder = NULL;
+    delete recorder;
+  }
+  if (m_rc != 0)
+  {
+    return m_rc;
+  }
+
+  double seconds = elapsedMs / 1000.0;
+  json = wxS("{\n");
+  json += wxS("  \"benchmark\": \"walstress\",\n");
+  json += wxS("  \"wxsqlite3_version\": \"") + wxSQLite3Database::GetWrapperVersion() + wxS("\",\n");
+  json += wxS("  \"sqlite_version\": \"") + wxSQLite3Database::GetVersion() + wxS("\",\n");
+  json += wxString::Format(wxS("  \"parameters\": { \"readers\": %ld, \"writers\": %ld, \"write_percent\": %ld, \"tx_size\": %ld, ")
+                           wxS("\"rows\": %ld, \"duration_sec\": %ld, \"checkpoint\": \"%s\", \"autocheckpoint\": %ld, ")
+                           wxS("\"interval_ms\": %ld, \"busy_timeout_ms\": %ld },\n"),
+                           m_readers, m_writers, m_params.writePercent, m_params.txSize,
+                           m_params.rows, m_duration, m_policy.c_str(), m_params.autoCheckpoint,
+                           m_interval, m_params.busyTimeout);
+  json += wxString::Format(wxS("  \"elapsed_ms\": %ld,\n"), elapsedMs);
+  json += wxString::Format(wxS("  \"reads_per_sec\": %.1f,\n"), readLatency.GetCount() / seconds);
+  json += wxString::Format(wxS("  \"writes_per_sec\": %.1f,\n"), writeLatency.GetCount() / seconds);
+  json += wxS("  \"read_latency_usec\": ") + readLatency.ToJSON() + wxS(",\n");
+  json += wxS("  \"write_latency_usec\": ") + writeLatency.ToJSON() + wxS(",\n");
+  json += wxString::Format(wxS("  \"busy\": %ld,\n  \"errors\": %ld,\n"), busy, errors);
+  if (!firstError.IsEmpty())
+  {
+    firstError.Replace(wxS("\\"), wxS("\\\\"));
+    firstError.Replace(wxS("\""), wxS("\\\""));
+    json += wxS("  \"first_error\": \"") + firstError + wxS("\",\n");
+  }
+  json += wxS("  \"checkpoints\": ") + context.CheckpointsToJSON() + wxS(",\n");
+  json += wxS("  \"wal\": { \"max_bytes\": ") + walMax.ToString() + wxS(", \"final_bytes\": ") + WalSize().ToString();
+  json += wxS(", \"samples\": [") + samples + wxS("] }\n");
+  json += wxS("}\n");
+
+  wxSQLite3Database::ShutdownSQLite();
+
+  if (m_output.IsEmpty())
+  {
+    cout << (const char*) json.utf8_str();
+  }
+  else
+  {
+    wxFFile file(m_output, wxS("w"));
+    if (!file.IsOpened() || !file.Write(json, wxConvUTF8))
+    {
+      cerr << "Writing the results to '" << (const char*) m_output.mb_str() << "' failed" << endl;
+      m_rc = 1;
+    }
+  }
+  return m_rc;
+}
+
+DECLARE_APP(WalStress)
+IMPLEMENT_APP_CONSOLE(WalStress)
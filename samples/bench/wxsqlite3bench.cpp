@@ -0,0 +1,859 @@
+/*
+** Name:        wxsqlite3bench.cpp
+** Purpose:     Benchmark suite for the hot paths of the wxSQLite3 wrapper
+** Author:      Ulrich Telle
+** Created:     2026-10-18
+** Copyright:   (c) 2026 Ulrich Telle
+** License:     LGPL-3.0+ WITH WxWindows-exception-3.1
+*/
+
+/*
+** Every benchmark case is executed twice: once through the wxSQLite3 classes
+** and once through the plain SQLite C API on a separate connection with identical
+** settings. The raw timings serve as baseline to quantify the wrapper overhead.
+** The results are written as a single JSON document to stdout (or to the file
+** given with --output), suitable for regression tracking.
+**
+** Note: the raw baseline calls the SQLite API contained in the wxSQLite3 library.
+** On Windows this requires linking against the static wxSQLite3 library, because
+** the wxSQLite3 DLL does not export the SQLite API.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+#ifdef __BORLANDC__
+#pragma hdrstop
+#endif
+
+#ifndef WX_PRECOMP
+#include "wx/wx.h"
+#endif
+
+#include <wx/cmdline.h>
+#include <wx/ffile.h>
+#include <wx/filefn.h>
+#include <wx/stopwatch.h>
+
+#include "wx/wxsqlite3.h"
+#include "sqlite3mc_amalgamation.h"
+
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+
+// Scalar function used to measure the user-function call overhead of the wrapper
+class AddOneFunction : public wxSQLite3ScalarFunction
+{
+public:
+  virtual void Execute(wxSQLite3FunctionContext& ctx)
+  {
+    ctx.SetResult(ctx.GetInt64(0) + 1);
+  }
+};
+
+// Scalar function used to measure the user-function call overhead of the C API
+static void RawAddOneFunction(sqlite3_context* ctx, int WXUNUSED(argc), sqlite3_value** argv)
+{
+  sqlite3_result_int64(ctx, sqlite3_value_int64(argv[0]) + 1);
+}
+
+class SQLite3Bench : public wxAppConsole
+{
+public:
+  bool OnInit();
+  int OnExit();
+  int OnRun();
+
+private:
+  // Timing and reporting
+  void StartTimer();
+  wxLongLong StopTimer();
+  void Report(const char* benchCase, const char* api, long ops, wxLongLong usec);
+  void RunCase(const char* benchCase, long ops, void (SQLite3Bench::*wrapperFunc)(), void (SQLite3Bench::*rawFunc)());
+
+  // Helpers
+  void RawExec(const char* sql);
+  sqlite3_stmt* RawPrepare(const char* sql);
+  void RawCheck(int rc, int expected);
+  wxLongLong_t NextKey();
+  void CreateTables();
+  void CreateIndexes();
+
+  // Wrapper cases
+  void WxInsertAutocommit();
+  void WxInsertTransaction();
+  void WxInsertBatched();
+  void WxLookupRowid();
+  void WxLookupIndex();
+  void WxRangeScan();
+  void WxGetTable();
+  void WxInsertConflict();
+  void WxInsertConflictTry();
+  void WxBlobWrite();
+  void WxBlobRead();
+  void WxFunctionCall();
+#if WXSQLITE3_HAVE_CXX11
+  void WxFunctionCallTyped();
+#endif
+
+  // Raw SQLite baseline cases
+  void RawInsertAutocommit();
+  void RawInsertTransaction();
+  void RawInsertBatched();
+  void RawLookupRowid();
+  void RawLookupIndex();
+  void RawRangeScan();
+  void RawGetTable();
+  void RawInsertConflict();
+  void RawBlobWrite();
+  void RawBlobRead();
+  void RawFunctionCall();
+
+  wxSQLite3Database m_db;
+  sqlite3*   m_raw;
+  wxString   m_dbName;
+  wxString   m_rawName;
+  wxString   m_output;
+  wxString   m_results;
+  wxString   m_overhead;
+  wxStopWatch m_stopWatch;
+  wxLongLong m_best[2];
+  unsigned long m_seed;
+  long m_rows;
+  long m_autocommitRows;
+  long m_batchSize;
+  long m_lookups;
+  long m_blobCount;
+  long m_blobSize;
+  long m_repeat;
+  long m_checksum;
+  int  m_rc;
+};
+
+static const wxCmdLineEntryDesc cmdLineDesc[] =
+{
+#if wxCHECK_VERSION(2,9,0)
+  { wxCMD_LINE_OPTION, "r", "rows",     "Number of rows (default: 100000)",                       wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "a", "autocommit", "Number of rows inserted in autocommit mode (default: 1000)", wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "b", "batch",    "Rows per multi-row INSERT statement (default: 50)",      wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "l", "lookups",  "Number of point lookups (default: 100000)",              wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "n", "blobs",    "Number of blobs (default: 1000)",                        wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "s", "blobsize", "Blob size in bytes (default: 65536)",                    wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "t", "repeat",   "Repetitions per case, the best run counts (default: 3)", wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "d", "database", "Database file name prefix (default: wxsqlite3bench)",   wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, "o", "output",   "JSON output file (default: stdout)",                     wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+#else
+  { wxCMD_LINE_OPTION, wxS("r"), wxS("rows"),     wxS("Number of rows (default: 100000)"),                       wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("a"), wxS("autocommit"), wxS("Number of rows inserted in autocommit mode (default: 1000)"), wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("b"), wxS("batch"),    wxS("Rows per multi-row INSERT statement (default: 50)"),      wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("l"), wxS("lookups"),  wxS("Number of point lookups (default: 100000)"),              wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("n"), wxS("blobs"),    wxS("Number of blobs (default: 1000)"),                        wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("s"), wxS("blobsize"), wxS("Blob size in bytes (default: 65536)"),                    wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("t"), wxS("repeat"),   wxS("Repetitions per case, the best run counts (default: 3)"), wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("d"), wxS("database"), wxS("Database file name prefix (default: wxsqlite3bench)"),   wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+  { wxCMD_LINE_OPTION, wxS("o"), wxS("output"),   wxS("JSON output file (default: stdout)"),                     wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+#endif
+  { wxCMD_LINE_NONE }
+};
+
+static const char* payload   = "payload text of a benchmark row";
+static const char* insertSQL = "INSERT INTO t (k, v, d) VALUES (?, ?, ?)";
+static const char* tableSQL  = "DROP TABLE IF EXISTS t; DROP TABLE IF EXISTS b;"
+                               "CREATE TABLE t (id INTEGER PRIMARY KEY, k INTEGER, v TEXT, d REAL);"
+                               "CREATE TABLE b (id INTEGER PRIMARY KEY, data BLOB);";
+static const char* indexSQL  = "CREATE INDEX IF NOT EXISTS t_k ON t (k)";
+static const char* scanSQL   = "SELECT id, k, v, d FROM t";
+static const char* conflictSQL = "INSERT INTO t (id, d) VALUES (?, ?)";
+static const char* funcSQL   = "WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x+1 FROM c WHERE x < ?) "
+                               "SELECT sum(%s(x)) FROM c";
+
+bool SQLite3Bench::OnInit()
+{
+  m_rc = 0;
+  m_raw = NULL;
+  m_rows = 100000;
+  m_autocommitRows = 1000;
+  m_batchSize = 50;
+  m_lookups = 100000;
+  m_blobCount = 1000;
+  m_blobSize = 65536;
+  m_repeat = 3;
+  wxString prefix = wxS("wxsqlite3bench");
+  wxCmdLineParser parser(cmdLineDesc, argc, argv);
+  parser.SetLogo(wxS("wxSQLite3 Wrapper Benchmark\n"));
+  bool ok = parser.Parse() == 0;
+  if (ok)
+  {
+    parser.Found(wxS("rows"), &m_rows);
+    parser.Found(wxS("autocommit"), &m_autocommitRows);
+    parser.Found(wxS("batch"), &m_batchSize);
+    parser.Found(wxS("lookups"), &m_lookups);
+    parser.Found(wxS("blobs"), &m_blobCount);
+    parser.Found(wxS("blobsize"), &m_blobSize);
+    parser.Found(wxS("repeat"), &m_repeat);
+    parser.Found(wxS("database"), &prefix);
+    parser.Found(wxS("output"), &m_output);
+    if (m_rows < 1 || m_autocommitRows < 1 || m_batchSize < 1 || m_batchSize > 1000 ||
+        m_lookups < 1 || m_blobCount < 1 || m_blobSize < 1 || m_repeat < 1)
+    {
+      cerr << "Invalid benchmark parameters" << endl;
+      ok = false;
+    }
+    m_dbName = prefix + wxS("-wx.db");
+    m_rawName = prefix + wxS("-raw.db");
+  }
+  if (!ok)
+  {
+    m_rc = -1;
+  }
+  return ok;
+}
+
+int SQLite3Bench::OnExit()
+{
+  return m_rc;
+}
+
+void SQLite3Bench::StartTimer()
+{
+  m_stopWatch.Start();
+}
+
+wxLongLong SQLite3Bench::StopTimer()
+{
+#if wxCHECK_VERSION(2,9,3)
+  return m_stopWatch.TimeInMicro();
+#else
+  return wxLongLong(m_stopWatch.Time()) * 1000;
+#endif
+}
+
+void SQLite3Bench::Report(const char* benchCase, const char* api, long ops, wxLongLong usec)
+{
+  double seconds = usec.ToDouble() / 1.0e6;
+  if (!m_results.IsEmpty())
+  {
+    m_results += wxS(",\n");
+  }
+  m_results += wxString::Format(wxS("    { \"case\": \"%s\", \"api\": \"%s\", \"ops\": %ld, \"usec\": %s, \"ops_per_sec\": %.1f, \"ns_per_op\": %.1f }"),
+                                wxString::FromUTF8(benchCase).c_str(), wxString::FromUTF8(api).c_str(), ops, usec.ToString().c_str(),
+                                (seconds > 0) ? ops / seconds : 0.0, usec.ToDouble() * 1000.0 / ops);
+}
+
+void SQLite3Bench::RunCase(const char* benchCase, long ops, void (SQLite3Bench::*wrapperFunc)(), void (SQLite3Bench::*rawFunc)())
+{
+  cerr << "Running " << benchCase << endl;
+  void (SQLite3Bench::*funcs[2])() = { rawFunc, wrapperFunc };
+  int api;
+  for (api = 0; api < 2; ++api)
+  {
+    long run;
+    for (run = 0; run < m_repeat; ++run)
+    {
+      // Both variants see the same key sequence
+      m_seed = 4711;
+      StartTimer();
+      (this->*funcs[api])();
+      wxLongLong elapsed = StopTimer();
+      if (run == 0 || elapsed < m_best[api])
+      {
+        m_best[api] = elapsed;
+      }
+    }
+    Report(benchCase, (api == 0) ? "raw" : "wxsqlite3", ops, m_best[api]);
+  }
+  if (!m_overhead.IsEmpty())
+  {
+    m_overhead += wxS(",\n");
+  }
+  double ratio = (m_best[0] > 0) ? m_best[1].ToDouble() / m_best[0].ToDouble() : 0.0;
+  m_overhead += wxString::Format(wxS("    \"%s\": %.3f"), wxString::FromUTF8(benchCase).c_str(), ratio);
+}
+
+void SQLite3Bench::RawCheck(int rc, int expected)
+{
+  if (rc != expected)
+  {
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(sqlite3_errmsg(m_raw)));
+  }
+}
+
+void SQLite3Bench::RawExec(const char* sql)
+{
+  RawCheck(sqlite3_exec(m_raw, sql, NULL, NULL, NULL), SQLITE_OK);
+}
+
+sqlite3_stmt* SQLite3Bench::RawPrepare(const char* sql)
+{
+  sqlite3_stmt* stmt = NULL;
+  RawCheck(sqlite3_prepare_v2(m_raw, sql, -1, &stmt, NULL), SQLITE_OK);
+  return stmt;
+}
+
+wxLongLong_t SQLite3Bench::NextKey()
+{
+  // Simple linear congruential generator for reproducible keys in the range 1..m_rows
+  m_seed = m_seed * 1103515245UL + 12345UL;
+  return (wxLongLong_t) (((m_seed >> 8) & 0xffffff) % m_rows) + 1;
+}
+
+void SQLite3Bench::CreateTables()
+{
+  m_db.ExecuteUpdate(tableSQL);
+  RawExec(tableSQL);
+}
+
+void SQLite3Bench::CreateIndexes()
+{
+  m_db.ExecuteUpdate(indexSQL);
+  RawExec(indexSQL);
+}
+
+// --- Inserts
+
+void SQLite3Bench::WxInsertAutocommit()
+{
+  m_db.ExecuteUpdate("DELETE FROM t");
+  wxSQLite3Statement stmt = m_db.PrepareStatement(insertSQL);
+  wxString text = wxString::FromUTF8(payload);
+  long row;
+  for (row = 0; row < m_autocommitRows; ++row)
+  {
+    stmt.Bind(1, (int) row);
+    stmt.Bind(2, text);
+    stmt.Bind(3, row * 0.5);
+    stmt.ExecuteUpdate();
+    stmt.Reset();
+  }
+}
+
+void SQLite3Bench::RawInsertAutocommit()
+{
+  RawExec("DELETE FROM t");
+  sqlite3_stmt* stmt = RawPrepare(insertSQL);
+  long row;
+  for (row = 0; row < m_autocommitRows; ++row)
+  {
+    sqlite3_bind_int(stmt, 1, (int) row);
+    sqlite3_bind_text(stmt, 2, payload, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_double(stmt, 3, row * 0.5);
+    RawCheck(sqlite3_step(stmt), SQLITE_DONE);
+    sqlite3_reset(stmt);
+  }
+  sqlite3_finalize(stmt);
+}
+
+void SQLite3Bench::WxInsertTransaction()
+{
+  m_db.ExecuteUpdate("DELETE FROM t");
+  wxSQLite3Statement stmt = m_db.PrepareStatement(insertSQL);
+  wxString text = wxString::FromUTF8(payload);
+  wxSQLite3Transaction transaction(&m_db);
+  long row;
+  for (row = 0; row < m_rows; ++row)
+  {
+    stmt.Bind(1, wxLongLong(NextKey()));
+    stmt.Bind(2, text);
+    stmt.Bind(3, row * 0.5);
+    stmt.ExecuteUpdate();
+    stmt.Reset();
+  }
+  transaction.Commit();
+}
+
+void SQLite3Bench::RawInsertTransaction()
+{
+  RawExec("DELETE FROM t");
+  sqlite3_stmt* stmt = RawPrepare(insertSQL);
+  RawExec("BEGIN");
+  long row;
+  for (row = 0; row < m_rows; ++row)
+  {
+    sqlite3_bind_int64(stmt, 1, NextKey());
+    sqlite3_bind_text(stmt, 2, payload, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_double(stmt, 3, row * 0.5);
+    RawCheck(sqlite3_step(stmt), SQLITE_DONE);
+    sqlite3_reset(stmt);
+  }
+  RawExec("COMMIT");
+  sqlite3_finalize(stmt);
+}
+
+// Builds a multi-row INSERT statement for the given number of rows
+static wxString BatchInsertSQL(long batchSize)
+{
+  wxString sql = wxS("INSERT INTO t (k, v, d) VALUES (?, ?, ?)");
+  long j;
+  for (j = 1; j < batchSize; ++j)
+  {
+    sql += wxS(", (?, ?, ?)");
+  }
+  return sql;
+}
+
+void SQLite3Bench::WxInsertBatched()
+{
+  m_db.ExecuteUpdate("DELETE FROM t");
+  wxSQLite3Statement batch = m_db.PrepareStatement(BatchInsertSQL(m_batchSize));
+  wxSQLite3Statement single = m_db.PrepareStatement(insertSQL);
+  wxString text = wxString::FromUTF8(payload);
+  wxSQLite3Transaction transaction(&m_db);
+  long row = 0;
+  while (row < m_rows)
+  {
+    bool full = m_rows - row >= m_batchSize;
+    wxSQLite3Statement& stmt = full ? batch : single;
+    long count = full ? m_batchSize : 1;
+    long j;
+    for (j = 0; j < count; ++j, ++row)
+    {
+      stmt.Bind(3 * j + 1, wxLongLong(NextKey()));
+      stmt.Bind(3 * j + 2, text);
+      stmt.Bind(3 * j + 3, row * 0.5);
+    }
+    stmt.ExecuteUpdate();
+    stmt.Reset();
+  }
+  transaction.Commit();
+}
+
+void SQLite3Bench::RawInsertBatched()
+{
+  RawExec("DELETE FROM t");
+  sqlite3_stmt* batch = RawPrepare(BatchInsertSQL(m_batchSize).utf8_str());
+  sqlite3_stmt* single = RawPrepare(insertSQL);
+  RawExec("BEGIN");
+  long row = 0;
+  while (row < m_rows)
+  {
+    bool full = m_rows - row >= m_batchSize;
+    sqlite3_stmt* stmt = full ? batch : single;
+    long count = full ? m_batchSize : 1;
+    long j;
+    for (j = 0; j < count; ++j, ++row)
+    {
+      sqlite3_bind_int64(stmt, 3 * j + 1, NextKey());
+      sqlite3_bind_text(stmt, 3 * j + 2, payload, -1, SQLITE_TRANSIENT);
+      sqlite3_bind_double(stmt, 3 * j + 3, row * 0.5);
+    }
+    RawCheck(sqlite3_step(stmt), SQLITE_DONE);
+    sqlite3_reset(stmt);
+  }
+  RawExec("COMMIT");
+  sqlite3_finalize(batch);
+  sqlite3_finalize(single);
+}
+
+// --- Point lookups
+
+void SQLite3Bench::WxLookupRowid()
+{
+  wxSQLite3Statement stmt = m_db.PrepareStatement("SELECT v FROM t WHERE id = ?");
+  long j;
+  for (j = 0; j < m_lookups; ++j)
+  {
+    stmt.Bind(1, wxLongLong(NextKey()));
+    wxSQLite3ResultSet rs = stmt.ExecuteQuery();
+    if (rs.NextRow())
+    {
+      m_checksum += (long) rs.GetString(0).Len();
+    }
+    stmt.Reset();
+  }
+}
+
+void SQLite3Bench::RawLookupRowid()
+{
+  sqlite3_stmt* stmt = RawPrepare("SELECT v FROM t WHERE id = ?");
+  long j;
+  for (j = 0; j < m_lookups; ++j)
+  {
+    sqlite3_bind_int64(stmt, 1, NextKey());
+    if (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+      sqlite3_column_text(stmt, 0);
+      m_checksum += sqlite3_column_bytes(stmt, 0);
+    }
+    sqlite3_reset(stmt);
+  }
+  sqlite3_finalize(stmt);
+}
+
+void SQLite3Bench::WxLookupIndex()
+{
+  wxSQLite3Statement stmt = m_db.PrepareStatement("SELECT id, v FROM t WHERE k = ?");
+  long j;
+  for (j = 0; j < m_lookups; ++j)
+  {
+    stmt.Bind(1, wxLongLong(NextKey()));
+    wxSQLite3ResultSet rs = stmt.ExecuteQuery();
+    while (rs.NextRow())
+    {
+      m_checksum += (long) rs.GetInt64(0).ToLong() + (long) rs.GetString(1).Len();
+    }
+    stmt.Reset();
+  }
+}
+
+void SQLite3Bench::RawLookupIndex()
+{
+  sqlite3_stmt* stmt = RawPrepare("SELECT id, v FROM t WHERE k = ?");
+  long j;
+  for (j = 0; j < m_lookups; ++j)
+  {
+    sqlite3_bind_int64(stmt, 1, NextKey());
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+      sqlite3_column_text(stmt, 1);
+      m_checksum += (long) sqlite3_column_int64(stmt, 0) + sqlite3_column_bytes(stmt, 1);
+    }
+    sqlite3_reset(stmt);
+  }
+  sqlite3_finalize(stmt);
+}
+
+// --- Range scans and table materialization
+
+void SQLite3Bench::WxRangeScan()
+{
+  wxSQLite3ResultSet rs = m_db.ExecuteQuery(scanSQL);
+  while (rs.NextRow())
+  {
+    m_checksum += (long) rs.GetInt64(0).ToLong() + rs.GetInt(1) + (long) rs.GetString(2).Len() + (long) rs.GetDouble(3);
+  }
+}
+
+void SQLite3Bench::RawRangeScan()
+{
+  sqlite3_stmt* stmt = RawPrepare(scanSQL);
+  while (sqlite3_step(stmt) == SQLITE_ROW)
+  {
+    sqlite3_column_text(stmt, 2);
+    m_checksum += (long) sqlite3_column_int64(stmt, 0) + sqlite3_column_int(stmt, 1) +
+                  sqlite3_column_bytes(stmt, 2) + (long) sqlite3_column_double(stmt, 3);
+  }
+  sqlite3_finalize(stmt);
+}
+
+void SQLite3Bench::WxGetTable()
+{
+  wxSQLite3Table table = m_db.GetTable(scanSQL);
+  int rows = table.GetRowCount();
+  int row;
+  for (row = 0; row < rows; ++row)
+  {
+    table.SetRow(row);
+    m_checksum += (long) table.GetInt64(0).ToLong() + table.GetInt(1) + (long) table.GetString(2).Len() + (long) table.GetDouble(3);
+  }
+}
+
+void SQLite3Bench::RawGetTable()
+{
+  char** results = NULL;
+  int rows = 0;
+  int cols = 0;
+  RawCheck(sqlite3_get_table(m_raw, scanSQL, &results, &rows, &cols, NULL), SQLITE_OK);
+  int row;
+  for (row = 1; row <= rows; ++row)
+  {
+    char** values = results + row * cols;
+    m_checksum += atol(values[0]) + atoi(values[1]) + (long) strlen(values[2]) + (long) atof(values[3]);
+  }
+  sqlite3_free_table(results);
+}
+
+// --- Constraint violations
+// The inserted keys partly collide with existing rows (half of them with the default sizes);
+// the changes are rolled back, so that every repetition sees the same table.
+
+void SQLite3Bench::WxInsertConflict()
+{
+  wxSQLite3Statement stmt = m_db.PrepareStatement(conflictSQL);
+  wxSQLite3Transaction transaction(&m_db);
+  long row;
+  for (row = 0; row < m_lookups; ++row)
+  {
+    stmt.Bind(1, wxLongLong(m_lookups / 2 + row + 1));
+    stmt.Bind(2, row * 0.5);
+    try
+    {
+      stmt.ExecuteUpdate();
+    }
+    catch (wxSQLite3Exception& e)
+    {
+      if (e.GetErrorCode() != SQLITE_CONSTRAINT)
+      {
+        throw;
+      }
+      ++m_checksum;
+    }
+  }
+  transaction.Rollback();
+}
+
+void SQLite3Bench::WxInsertConflictTry()
+{
+  wxSQLite3Statement stmt = m_db.PrepareStatement(conflictSQL);
+  wxSQLite3Transaction transaction(&m_db);
+  long row;
+  for (row = 0; row < m_lookups; ++row)
+  {
+    stmt.TryBind(1, wxLongLong(m_lookups / 2 + row + 1));
+    stmt.TryBind(2, row * 0.5);
+    wxSQLite3Result result = stmt.TryExecuteUpdate();
+    if (result.IsConstraint())
+    {
+      ++m_checksum;
+    }
+    else
+    {
+      result.ThrowIfFailed();
+    }
+  }
+  transaction.Rollback();
+}
+
+void SQLite3Bench::RawInsertConflict()
+{
+  sqlite3_stmt* stmt = RawPrepare(conflictSQL);
+  RawExec("BEGIN");
+  long row;
+  for (row = 0; row < m_lookups; ++row)
+  {
+    sqlite3_bind_int64(stmt, 1, m_lookups / 2 + row + 1);
+    sqlite3_bind_double(stmt, 2, row * 0.5);
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_CONSTRAINT)
+    {
+      ++m_checksum;
+    }
+    else
+    {
+      RawCheck(rc, SQLITE_DONE);
+    }
+    sqlite3_reset(stmt);
+  }
+  RawExec("ROLLBACK");
+  sqlite3_finalize(stmt);
+}
+
+// --- Blob I/O
+
+void SQLite3Bench::WxBlobWrite()
+{
+  wxMemoryBuffer buffer;
+  memset(buffer.GetWriteBuf(m_blobSize), 'w', m_blobSize);
+  buffer.UngetWriteBuf(m_blobSize);
+  wxSQLite3Transaction transaction(&m_db);
+  wxSQLite3Blob blob = m_db.GetWritableBlob(1, wxS("data"), wxS("b"));
+  long j;
+  for (j = 1; j <= m_blobCount; ++j)
+  {
+    if (j > 1)
+    {
+      blob.Rebind(j);
+    }
+    blob.Write(buffer.GetData(), (int) m_blobSize, 0);
+  }
+  blob.Finalize();
+  transaction.Commit();
+}
+
+void SQLite3Bench::RawBlobWrite()
+{
+  char* buffer = new char[m_blobSize];
+  memset(buffer, 'w', m_blobSize);
+  sqlite3_blob* blob = NULL;
+  RawExec("BEGIN");
+  RawCheck(sqlite3_blob_open(m_raw, "main", "b", "data", 1, 1, &blob), SQLITE_OK);
+  long j;
+  for (j = 1; j <= m_blobCount; ++j)
+  {
+    if (j > 1)
+    {
+      RawCheck(sqlite3_blob_reopen(blob, j), SQLITE_OK);
+    }
+    RawCheck(sqlite3_blob_write(blob, buffer, (int) m_blobSize, 0), SQLITE_OK);
+  }
+  sqlite3_blob_close(blob);
+  RawExec("COMMIT");
+  delete [] buffer;
+}
+
+void SQLite3Bench::WxBlobRead()
+{
+  wxMemoryBuffer buffer;
+  char* data = (char*) buffer.GetWriteBuf(m_blobSize);
+  wxSQLite3Blob blob = m_db.GetReadOnlyBlob(1, wxS("data"), wxS("b"));
+  long j;
+  for (j = 1; j <= m_blobCount; ++j)
+  {
+    if (j > 1)
+    {
+      blob.Rebind(j);
+    }
+    blob.Read(data, (int) m_blobSize, 0);
+    m_checksum += data[m_blobSize - 1];
+  }
+  buffer.UngetWriteBuf(m_blobSize);
+  blob.Finalize();
+}
+
+void SQLite3Bench::RawBlobRead()
+{
+  char* buffer = new char[m_blobSize];
+  sqlite3_blob* blob = NULL;
+  RawCheck(sqlite3_blob_open(m_raw, "main", "b", "data", 1, 0, &blob), SQLITE_OK);
+  long j;
+  for (j = 1; j <= m_blobCount; ++j)
+  {
+    if (j > 1)
+    {
+      RawCheck(sqlite3_blob_reopen(blob, j), SQLITE_OK);
+    }
+    RawCheck(sqlite3_blob_read(blob, buffer, (int) m_blobSize, 0), SQLITE_OK);
+    m_checksum += buffer[m_blobSize - 1];
+  }
+  sqlite3_blob_close(blob);
+  delete [] buffer;
+}
+
+// --- User-defined functions
+
+void SQLite3Bench::WxFunctionCall()
+{
+  wxSQLite3Statement stmt = m_db.PrepareStatement(wxString::Format(wxString::FromUTF8(funcSQL), wxS("addone")));
+  stmt.Bind(1, (int) m_rows);
+  wxSQLite3ResultSet rs = stmt.ExecuteQuery();
+  if (rs.NextRow())
+  {
+    m_checksum += rs.GetInt64(0).ToLong();
+  }
+}
+
+#if WXSQLITE3_HAVE_CXX11
+void SQLite3Bench::WxFunctionCallTyped()
+{
+  wxSQLite3Statement stmt = m_db.PrepareStatement(wxString::Format(wxString::FromUTF8(funcSQL), wxS("addone_typed")));
+  stmt.Bind(1, (int) m_rows);
+  wxSQLite3ResultSet rs = stmt.ExecuteQuery();
+  if (rs.NextRow())
+  {
+    m_checksum += rs.GetInt64(0).ToLong();
+  }
+}
+#endif
+
+void SQLite3Bench::RawFunctionCall()
+{
+  char* sql = sqlite3_mprintf(funcSQL, "addone");
+  sqlite3_stmt* stmt = RawPrepare(sql);
+  sqlite3_free(sql);
+  sqlite3_bind_int(stmt, 1, (int) m_rows);
+  RawCheck(sqlite3_step(stmt), SQLITE_ROW);
+  m_checksum += (long) sqlite3_column_int64(stmt, 0);
+  sqlite3_finalize(stmt);
+}
+
+int SQLite3Bench::OnRun()
+{
+  AddOneFunction addOne;
+  wxString json;
+  try
+  {
+    wxSQLite3Database::InitializeSQLite();
+    wxRemoveFile(m_dbName);
+    wxRemoveFile(m_rawName);
+
+    m_db.Open(m_dbName);
+    m_db.ExecuteUpdate("PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL;");
+    m_db.CreateFunction(wxS("addone"), 1, addOne, WXSQLITE_DETERMINISTIC);
+#if WXSQLITE3_HAVE_CXX11
+    m_db.CreateFunction(wxS("addone_typed"), [](wxLongLong_t x) { return x + 1; }, WXSQLITE_DETERMINISTIC);
+#endif
+
+    RawCheck(sqlite3_open_v2(m_rawName.utf8_str(), &m_raw, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL), SQLITE_OK);
+    RawExec("PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL;");
+    RawCheck(sqlite3_create_function_v2(m_raw, "addone", 1, SQLITE_UTF8 | SQLITE_DETERMINISTIC, NULL,
+                                        RawAddOneFunction, NULL, NULL, NULL), SQLITE_OK);
+
+    m_checksum = 0;
+    CreateTables();
+    RunCase("insert_autocommit", m_autocommitRows, &SQLite3Bench::WxInsertAutocommit, &SQLite3Bench::RawInsertAutocommit);
+    RunCase("insert_transaction", m_rows, &SQLite3Bench::WxInsertTransaction, &SQLite3Bench::RawInsertTransaction);
+    RunCase("insert_batched", m_rows, &SQLite3Bench::WxInsertBatched, &SQLite3Bench::RawInsertBatched);
+
+    CreateIndexes();
+    RunCase("lookup_rowid", m_lookups, &SQLite3Bench::WxLookupRowid, &SQLite3Bench::RawLookupRowid);
+    RunCase("lookup_index", m_lookups, &SQLite3Bench::WxLookupIndex, &SQLite3Bench::RawLookupIndex);
+    RunCase("range_scan", m_rows, &SQLite3Bench::WxRangeScan, &SQLite3Bench::RawRangeScan);
+    RunCase("get_table", m_rows, &SQLite3Bench::WxGetTable, &SQLite3Bench::RawGetTable);
+    RunCase("insert_conflict", m_lookups, &SQLite3Bench::WxInsertConflict, &SQLite3Bench::RawInsertConflict);
+    RunCase("insert_conflict_try", m_lookups, &SQLite3Bench::WxInsertConflictTry, &SQLite3Bench::RawInsertConflict);
+
+    wxString blobSQL = wxString::Format(wxS("WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x+1 FROM c WHERE x < %ld) ")
+                                        wxS("INSERT INTO b (id, data) SELECT x, zeroblob(%ld) FROM c"), m_blobCount, m_blobSize);
+    m_db.ExecuteUpdate(blobSQL);
+    RawExec(blobSQL.utf8_str());
+    RunCase("blob_write", m_blobCount, &SQLite3Bench::WxBlobWrite, &SQLite3Bench::RawBlobWrite);
+    RunCase("blob_read", m_blobCount, &SQLite3Bench::WxBlobRead, &SQLite3Bench::RawBlobRead);
+
+    RunCase("function_call", m_rows, &SQLite3Bench::WxFunctionCall, &SQLite3Bench::RawFunctionCall);
+#if WXSQLITE3_HAVE_CXX11
+    RunCase("function_call_typed", m_rows, &SQLite3Bench::WxFunctionCallTyped, &SQLite3Bench::RawFunctionCall);
+#endif
+
+    json = wxS("{\n");
+    json += wxS("  \"benchmark\": \"wxsqlite3_bench\",\n");
+    json += wxS("  \"wxsqlite3_version\": \"") + wxSQLite3Database::GetWrapperVersion() + wxS("\",\n");
+    json += wxS("  \"sqlite_version\": \"") + wxSQLite3Database::GetVersion() + wxS("\",\n");
+    json += wxString::Format(wxS("  \"parameters\": { \"rows\": %ld, \"autocommit_rows\": %ld, \"batch_size\": %ld, \"lookups\": %ld, ")
+                             wxS("\"blobs\": %ld, \"blob_size\": %ld, \"repeat\": %ld },\n"),
+                             m_rows, m_autocommitRows, m_batchSize, m_lookups, m_blobCount, m_blobSize, m_repeat);
+    json += wxS("  \"results\": [\n") + m_results + wxS("\n  ],\n");
+    json += wxS("  \"overhead\": {\n") + m_overhead + wxS("\n  },\n");
+    json += wxString::Format(wxS("  \"checksum\": %ld\n"), m_checksum);
+    json += wxS("}\n");
+
+    sqlite3_close(m_raw);
+    m_raw = NULL;
+    m_db.Close();
+    if (wxSQLite3Database::HasWrapperProfileSupport())
+    {
+      // Where the time outside of SQLite goes (wxSQLite3 built with WXSQLITE3_PROFILE_WRAPPER)
+      cerr << (const char*) wxSQLite3Database::GetWrapperProfile().mb_str();
+    }
+    wxSQLite3Database::ShutdownSQLite();
+  }
+  catch (wxSQLite3Exception& e)
+  {
+    cerr << e.GetErrorCode() << ":" << (const char*)(e.GetMessage().mb_str()) << endl;
+    if (m_raw != NULL)
+    {
+      sqlite3_close(m_raw);
+      m_raw = NULL;
+    }
+    m_rc = 1;
+    return m_rc;
+  }
+
+  if (m_output.IsEmpty())
+  {
+    cout << (const char*) json.utf8_str();
+  }
+  else
+  {
+    wxFFile file(m_output, wxS("w"));
+    if (!file.IsOpened() || !file.Write(json, wxConvUTF8))
+    {
+      cerr << "Writing the results to '" << (const char*) m_output.mb_str() << "' failed" << endl;
+      m_rc = 1;
+    }
+  }
+  return m_rc;
+}
+
+DECLARE_APP(SQLite3Bench)
+IMPLEMENT_APP_CONSOLE(SQLite3Bench)
@@ -27,8 +27,10 @@
 #include <wx/cmdline.h>
 
 #include "wx/wxsqlite3.h"
+#include <cstring>
 #include <ctime>
 #include <iostream>
+#include <string>
 
 using namespace std;
 
@@ -242,6 +244,19 @@ public:
   }
 };
 
+class MyReversedSortKeyCollation : public wxSQLite3SortKeyCollation
+{
+public:
+  // The sort key consists of the bytes in reversed order (sufficient for ASCII text)
+  virtual void GenerateSortKey(const char* text, size_t len, wxMemoryBuffer& sortKey)
+  {
+    char* key = (char*) sortKey.GetWriteBuf(len);
+    size_t j;
+    for (j = 0; j < len; j++) key[j] = text[len-1-j];
+    sortKey.UngetWriteBuf(len);
+  }
+};
+
 class MyProgress : public wxSQLite3BackupProgress
 {
 public:
@@ -254,6 +269,288 @@ public:
   }
 };
 
+// Test of the asynchronous logger
+
+#if wxUSE_THREADS
+
+class MyAsyncLogger : public wxSQLite3AsyncLogger
+{
+public:
+  MyAsyncLogger(size_t capacity) : wxSQLite3AsyncLogger(capacity), m_count(0) {}
+  virtual ~MyAsyncLogger() { Stop(); }
+
+  virtual void HandleLogMessage(int errorCode, const wxString& errorMessage)
+  {
+    ++m_count;
+    m_lastMessage = errorMessage;
+  }
+
+  int      m_count;
+  wxString m_lastMessage;
+};
+
+static void testAsyncLogger()
+{
+  // The messages are passed through the hook SQLite itself calls, since
+  // the global log configuration can only be changed before SQLite is initialized
+  MyAsyncLogger logger(4);
+  cout << "Capacity == 4? " << (logger.GetCapacity() == 4) << endl;
+
+  // Long messages are truncated at a UTF-8 character boundary
+  std::string longMessage;
+  int j;
+  for (j = 0; j < 150; ++j)
+  {
+    longMessage += "\xc3\xa4";
+  }
+
+  // Messages raised before the thread runs are queued, the overflow is dropped
+  for (j = 0; j < 3; ++j)
+  {
+    wxSQLite3Logger::ExecLoggerHook(&logger, 27 /* SQLITE_NOTICE */, "queued message");
+  }
+  wxSQLite3Logger::ExecLoggerHook(&logger, 28 /* SQLITE_WARNING */, longMessage.c_str());
+  for (j = 0; j < 2; ++j)
+  {
+    wxSQLite3Logger::ExecLoggerHook(&logger, 27 /* SQLITE_NOTICE */, "dropped message");
+  }
+  cout << "Dropped == 2? " << (logger.GetDroppedMessageCount() == 2) << endl;
+
+  cout << "Thread started? " << logger.Start() << endl;
+  cout << "Is running? " << logger.IsRunning() << endl;
+
+  // Stop dispatches all pending messages before it returns
+  logger.Stop();
+  cout << "Is stopped? " << !logger.IsRunning() << endl;
+  cout << "Count == 4? " << (logger.m_count == 4) << endl;
+  cout << "Truncated to 127 characters? " << (logger.m_lastMessage.length() == 127) << endl;
+  cout << "Valid UTF-8? " << (logger.m_lastMessage == wxString::FromUTF8(longMessage.c_str(), 254)) << endl;
+}
+
+#endif
+
+// Test of the change data capture feed
+
+class MyChangeListener : public wxSQLite3ChangeListener
+{
+public:
+  MyChangeListener() : m_batchCount(0), m_lastCount(0), m_lastRowId(0) {}
+
+  virtual bool CommitCallback(const wxSQLite3ChangeBatch& changes)
+  {
+    ++m_batchCount;
+    m_lastCount = changes.GetCount();
+    m_lastRowId = (m_lastCount > 0) ? changes[m_lastCount-1].GetNewRowId() : 0;
+    return false;
+  }
+
+  int            m_batchCount;
+  size_t         m_lastCount;
+  wxsqlite_int64 m_lastRowId;
+};
+
+static void testChangeFeed()
+{
+  if (!wxSQLite3Database::HasPreUpdateHookSupport())
+  {
+    cout << "Pre-update hook not supported" << endl;
+    return;
+  }
+  wxSQLite3Database db;
+  db.Open(wxS(":memory:"));
+  db.ExecuteUpdate(wxS("CREATE TABLE feed (id INTEGER PRIMARY KEY, name TEXT)"));
+  MyChangeListener listener;
+  db.SetChangeListener(&listener);
+
+  db.ExecuteUpdate(wxS("BEGIN; INSERT INTO feed VALUES (1, 'one'); COMMIT;"));
+  cout << "One batch on commit? " << (listener.m_batchCount == 1 && listener.m_lastCount == 1) << endl;
+
+  db.ExecuteUpdate(wxS("BEGIN; INSERT INTO feed VALUES (2, 'two'); ROLLBACK;"));
+  cout << "Nothing on rollback? " << (listener.m_batchCount == 1) << endl;
+
+  db.ExecuteUpdate(wxS("BEGIN; INSERT INTO feed VALUES (3, 'three'); SAVEPOINT sp; INSERT INTO feed VALUES (4, 'four');"
+                       " ROLLBACK TO sp; RELEASE sp; COMMIT;"));
+  cout << "ROLLBACK TO retracted? " << (listener.m_batchCount == 2 && listener.m_lastCount == 1 && listener.m_lastRowId == 3) << endl;
+
+  // The second row violates the primary key, the statement is rolled back as a whole
+  db.Begin();
+  db.ExecuteUpdate(wxS("INSERT INTO feed VALUES (5, 'five');"));
+  try
+  {
+    db.ExecuteUpdate(wxS("INSERT INTO feed VALUES (6, 'six'), (5, 'duplicate');"));
+  }
+  catch (wxSQLite3Exception&)
+  {
+  }
+  db.Commit();
+  cout << "Failed statement retracted? " << (listener.m_batchCount == 3 && listener.m_lastCount == 1 && listener.m_lastRowId == 5) << endl;
+
+  db.SetChangeListener(NULL);
+  db.Close();
+}
+
+#if wxUSE_STREAMS && wxUSE_ZLIB
+
+// Test of the compression functions and streams
+
+static void testCompression()
+{
+  wxSQLite3Database db;
+  db.Open(wxS(":memory:"));
+  db.CreateCompressionFunctions();
+  db.ExecuteUpdate(wxS("CREATE TABLE packed (id INTEGER PRIMARY KEY, data BLOB)"));
+
+  wxString text;
+  int j;
+  for (j = 0; j < 100; ++j)
+  {
+    text += wxS("wxSQLite3 compression test ");
+  }
+  wxSQLite3Statement stmt = db.PrepareStatement(wxS("INSERT INTO packed VALUES (1, compress(?));"));
+  stmt.Bind(1, text);
+  stmt.ExecuteUpdate();
+  cout << "Compressed smaller? " << db.ExecuteScalar(wxS("SELECT length(data) < 2700 FROM packed WHERE id = 1;")) << endl;
+  wxSQLite3ResultSet rs = db.ExecuteQuery(wxS("SELECT uncompress(data) FROM packed WHERE id = 1;"));
+  cout << "Text restored? " << (rs.NextRow() && rs.GetString(0) == text) << endl;
+  rs.Finalize();
+
+  // A frame header claiming more data than the payload can inflate to is rejected
+  bool exceptionCaught = false;
+  try
+  {
+    db.ExecuteScalar(wxS("SELECT uncompress(X'57585A0101000000000000010000000078DA0300');"));
+  }
+  catch (wxSQLite3Exception&)
+  {
+    exceptionCaught = true;
+  }
+  cout << "Oversized frame rejected? " << exceptionCaught << endl;
+
+  // Round trip through the compressing streams
+  const size_t dataSize = 10000;
+  wxMemoryBuffer data;
+  unsigned char* bytes = (unsigned char*) data.GetWriteBuf(dataSize);
+  for (j = 0; j < (int) dataSize; ++j)
+  {
+    bytes[j] = (unsigned char) (j % 7);
+  }
+  data.UngetWriteBuf(dataSize);
+  db.ExecuteUpdate(wxString::Format(wxS("INSERT INTO packed VALUES (2, zeroblob(%d));"),
+                                    (int) wxSQLite3CompressedBlobOutputStream::GetMaxBlobSize(dataSize)));
+  {
+    wxSQLite3CompressedBlobOutputStream out(db.GetWritableBlob(2, wxS("data"), wxS("packed")));
+    out.Write(data.GetData(), dataSize);
+    cout << "Stream closed? " << out.Close() << endl;
+  }
+  wxMemoryBuffer restored;
+  {
+    wxSQLite3CompressedBlobInputStream in(db.GetReadOnlyBlob(2, wxS("data"), wxS("packed")));
+    cout << "Stream compressed? " << in.IsCompressed() << endl;
+    cout << "Length == 10000? " << (in.GetLength() == (wxFileOffset) dataSize) << endl;
+    size_t got = in.Read(restored.GetWriteBuf(dataSize), dataSize).LastRead();
+    restored.UngetWriteBuf(got);
+  }
+  cout << "Stream data restored? " << (restored.GetDataLen() == dataSize && memcmp(restored.GetData(), data.GetData(), dataSize) == 0) << endl;
+  cout << "Stream readable by uncompress? " << db.ExecuteScalar(wxS("SELECT length(uncompress(data)) = 10000 FROM packed WHERE id = 2;")) << endl;
+  db.Close();
+}
+
+#endif
+
+#if WXSQLITE3_HAVE_CXX11
+
+// Test of typed statements
+
+static void testTypedStatement()
+{
+  wxSQLite3Database db;
+  db.Open(wxS(":memory:"));
+  db.ExecuteUpdate(wxS("CREATE TABLE typed (id INTEGER, name TEXT, size INTEGER)"));
+
+  wxSQLite3TypedStatement< wxSQLite3Params<int, std::string, wxUint64> >
+    insert(db.PrepareStatement("INSERT INTO typed VALUES (?, ?, ?);"));
+  insert.Execute(1, "first", 42);
+  insert.Execute(2, "second", wxUint64(wxLL(9223372036854775807)));
+
+  wxSQLite3TypedStatement< wxSQLite3Params<int>, wxSQLite3Columns<std::string, wxUint64> >
+    select(db.PrepareStatement("SELECT name, size FROM typed WHERE id = ?;"));
+  std::tuple<std::string, wxUint64> row;
+  cout << "Row found? " << select.QuerySingle(row, 2) << endl;
+  cout << "Name == second? " << (std::get<0>(row) == "second") << endl;
+  cout << "Size == INT64_MAX? " << (std::get<1>(row) == wxUint64(wxLL(9223372036854775807))) << endl;
+
+  // Unsigned values above the signed 64-bit range are rejected instead of wrapping
+  bool exceptionCaught = false;
+  try
+  {
+    insert.Execute(3, "third", wxUint64(wxLL(9223372036854775807)) + 1);
+  }
+  catch (wxSQLite3Exception& e)
+  {
+    exceptionCaught = (e.GetErrorCode() == WXSQLITE_ERROR);
+  }
+  cout << "Out of range value rejected? " << exceptionCaught << endl;
+
+  // Negative values can't be decoded into an unsigned 64-bit type
+  db.ExecuteUpdate(wxS("INSERT INTO typed VALUES (4, 'fourth', -1)"));
+  exceptionCaught = false;
+  try
+  {
+    select.QuerySingle(row, 4);
+  }
+  catch (wxSQLite3Exception& e)
+  {
+    exceptionCaught = (e.GetErrorCode() == WXSQLITE_ERROR);
+  }
+  cout << "Negative value rejected? " << exceptionCaught << endl;
+
+  std::vector< std::tuple<std::string, wxUint64> > rows = select.Query(1);
+  cout << "Count == 1? " << (rows.size() == 1) << endl;
+  db.Close();
+}
+
+// Test of text and BLOB views
+
+static void testViewTypes()
+{
+  wxSQLite3Database db;
+  db.Open(wxS(":memory:"));
+  db.ExecuteUpdate(wxS("CREATE TABLE views (id INTEGER, name TEXT, data BLOB)"));
+
+  const unsigned char blobData[] = { 1, 2, 3 };
+  wxSQLite3TypedStatement< wxSQLite3Params<int, wxSQLite3TextView, wxSQLite3BlobView> >
+    insert(db.PrepareStatement("INSERT INTO views VALUES (?, ?, ?);"));
+  insert.Execute(1, wxSQLite3TextView("abc", 3), wxSQLite3BlobView(blobData, sizeof(blobData)));
+  // Views without data are bound as NULL, an empty BLOB needs a non-NULL pointer
+  insert.Execute(2, wxSQLite3TextView(), wxSQLite3BlobView());
+  insert.Execute(3, wxSQLite3TextView("", 0), wxSQLite3BlobView(blobData, 0));
+
+  wxSQLite3TypedStatement< wxSQLite3Params<int>, wxSQLite3Columns<wxSQLite3TextView, wxSQLite3BlobView> >
+    select(db.PrepareStatement("SELECT name, data FROM views WHERE id = ?;"));
+  std::tuple<wxSQLite3TextView, wxSQLite3BlobView> row;
+  select.Bind(1);
+  select.Next(row);
+  cout << "Text size == 3? " << (std::get<0>(row).size == 3) << endl;
+  cout << "BLOB size == 3? " << (std::get<1>(row).size == 3 && std::get<1>(row).data[2] == 3) << endl;
+  select.Bind(2);
+  select.Next(row);
+  cout << "Text is NULL? " << std::get<0>(row).IsNull() << endl;
+  cout << "BLOB is NULL? " << std::get<1>(row).IsNull() << endl;
+  select.Bind(3);
+  select.Next(row);
+  cout << "Empty text not NULL? " << !std::get<0>(row).IsNull() << endl;
+  cout << "Empty BLOB not NULL? " << (!std::get<1>(row).IsNull() && std::get<1>(row).size == 0) << endl;
+  select.GetStatement().Reset();
+
+  // A function passing a BLOB view through keeps NULL values and empty BLOBs apart
+  db.CreateFunction(wxS("blob_echo"), [](wxSQLite3BlobView value) { return value; });
+  cout << "NULL echoed as NULL? " << db.ExecuteScalar("SELECT blob_echo(NULL) IS NULL;") << endl;
+  cout << "Empty BLOB echoed as BLOB? " << db.ExecuteScalar("SELECT typeof(blob_echo(zeroblob(0))) = 'blob';") << endl;
+  db.Close();
+}
+
+#endif
+
 class Minimal : public wxAppConsole
 {
 public:
@@ -333,8 +630,10 @@ int Minimal::OnRun()
   MyAuthorizer myAuthorizer;
   MyCallback myCallback;
   MyCollation myCollation;
+  MyReversedSortKeyCollation myReversedCollation;
 #if wxUSE_REGEX
   wxSQLite3RegExpOperator myRegExpOp;
+  wxSQLite3RegExpReplaceFunction myRegExpReplace;
 #endif
 
   try
@@ -626,6 +925,23 @@ int Minimal::OnRun()
       cout << (const char*)(q2.GetString(0).mb_str()) << endl;
     }
 
+    db.CreateStatisticsFunctions();
+    cout << endl << "Statistics functions test" << endl;
+    wxSQLite3ResultSet q2s = db.ExecuteQuery("select median(empno), stddev(empno), percentile_cont(empno, 0.9) from emp;");
+    if (q2s.NextRow())
+    {
+      cout << q2s.GetDouble(0) << " " << q2s.GetDouble(1) << " " << q2s.GetDouble(2) << endl;
+    }
+
+    wxSQLite3SketchFunctions sketches;
+    sketches.Register(db);
+    cout << endl << "Sketch functions test" << endl;
+    wxSQLite3ResultSet q2k = db.ExecuteQuery("select hll_count(hll_sketch(empname)), tdigest_quantile(tdigest_sketch(empno), 0.5) from emp;");
+    if (q2k.NextRow())
+    {
+      cout << q2k.GetInt(0) << " " << q2k.GetDouble(1) << endl;
+    }
+
 #if wxUSE_REGEX
     db.CreateFunction(wxS("regexp"), 2, myRegExpOp);
 
@@ -636,6 +952,14 @@ int Minimal::OnRun()
     {
       cout << (const char*)(q3.GetString(0).mb_str()) << endl;
     }
+
+    db.CreateFunction(wxS("regexp_replace"), -1, myRegExpReplace, WXSQLITE_DETERMINISTIC);
+    wxSQLite3ResultSet q3r = db.ExecuteQuery("select regexp_replace(empname, '[aeiou]', '*') from emp order by 1;");
+
+    while (q3r.NextRow())
+    {
+      cout << (const char*)(q3r.GetString(0).mb_str()) << endl;
+    }
 #endif
 
     // Test storing/retrieving some binary data, checking
@@ -696,6 +1020,29 @@ int Minimal::OnRun()
       cout << "Is count == 5? " << (count == 5) << endl;
     }
 
+    if (wxSQLite3Database::HasArrayParamsSupport())
+    {
+      static wxInt32 aY[] = { 53, 9, 17, 2231, 4, 99 };
+      cout << endl << "Array parameter test" << endl;
+      wxSQLite3Statement stmt = db.PrepareStatement(wxSQLite3Database::RewriteArrayParams(wxS("SELECT value FROM carray(?) WHERE value IN (?);")));
+      stmt.BindArray(1, aY, 6, WXSQLITE_ARRAY_STATIC);
+      wxArrayInt filter;
+      filter.Add(9);
+      filter.Add(4);
+      filter.Add(100);
+      stmt.BindArray(2, filter);
+      wxSQLite3ResultSet set = stmt.ExecuteQuery();
+
+      int count = 0;
+      while (set.NextRow())
+      {
+        cout << "value[" << count << "] = " << set.GetInt(0) << endl;
+        count++;
+      }
+      set.Finalize();
+      cout << "Is count == 2? " << (count == 2) << endl;
+    }
+
     // Activate authorizer
     db.SetAuthorizer(myAuthorizer);
 
@@ -743,6 +1090,16 @@ int Minimal::OnRun()
       cout << (const char*)(q4.GetString(0).mb_str()) << endl;
     }
 
+    cout << endl << "Sort key collation" << endl;
+    db.SetUtf8Collation(wxS("reversedkey"), &myReversedCollation);
+    db.CreateSortKeyFunction(wxS("reversedkey"), &myReversedCollation);
+    wxSQLite3ResultSet q4k = db.ExecuteQuery("select textcol, hex(reversedkey(textcol)) from testcol order by textcol collate reversedkey desc;");
+
+    while (q4k.NextRow())
+    {
+      cout << (const char*)(q4k.GetString(0).mb_str()) << " " << (const char*)(q4k.GetString(1).mb_str()) << endl;
+    }
+
     if (wxSQLite3Database::HasBackupSupport())
     {
       db.SetBackupRestorePageCount(100);
@@ -809,6 +1166,27 @@ int Minimal::OnRun()
     cout << endl << "Test of RAII transactions" << endl;
     testTransaction();
 
+#if wxUSE_THREADS
+    cout << endl << "Test of the asynchronous logger" << endl;
+    testAsyncLogger();
+#endif
+
+    cout << endl << "Test of the change feed" << endl;
+    testChangeFeed();
+
+#if wxUSE_STREAMS && wxUSE_ZLIB
+    cout << endl << "Test of compression" << endl;
+    testCompression();
+#endif
+
+#if WXSQLITE3_HAVE_CXX11
+    cout << endl << "Test of typed statements" << endl;
+    testTypedStatement();
+
+    cout << endl << "Test of text and BLOB views" << endl;
+    testViewTypes();
+#endif
+
     // Test accessing encrypted database files (currently SQLCipher only)
     TestCiphers();
 
@@ -24,6 +24,8 @@
 #include <wx/imaglist.h>
 #include <wx/tokenzr.h>
 
+#include <vector>
+
 #include "foldertree.h"
 
 #include "folder_blue.xpm"
@@ -184,30 +186,60 @@ FolderTreeCtrl::HandleDraggedProjects(int sourceFolder, int targetFolder, const
   bool ok = true;
 
   // Prepare collection of references
-  wxString references = wxT("(");
+  bool useArray = wxSQLite3Database::HasArrayParamsSupport();
   size_t n = projectReferences.Count();
   size_t j;
+  std::vector<wxLongLong_t> references(n);
+  wxString referenceList = wxT("(");
   for (j = 0; j < n; ++j)
   {
-    if (j > 0) references.Append(wxT(","));
-    references.Append(wxString::Format(wxT("%ld"), projectReferences[j]));
+    references[j] = projectReferences[j];
+    if (!useArray)
+    {
+      if (j > 0) referenceList.Append(wxT(","));
+      referenceList.Append(wxString::Format(wxT("%ld"), projectReferences[j]));
+    }
   }
-  references.Append(wxT(")"));
+  referenceList.Append(wxT(")"));
+  const wxLongLong_t* referenceValues = (n > 0) ? &references[0] : NULL;
 
-  // Prepare SQL commands
-  wxString sqlRemoveTargetReferences = wxString::Format(wxT("delete from folderprojects where fid=%d and pid in "), targetFolder) + references;
-  wxString sqlInsertTargetReferences = wxString::Format(wxT("insert into folderprojects (fid,pid) select %d, pid from projects where pid in "), targetFolder) + references;
-  wxString sqlRemoveSourceReferences = wxString::Format(wxT("delete from folderprojects where fid=%d and pid in "), sourceFolder) + references;
+  // Prepare SQL commands; if supported, the references are bound as an array,
+  // keeping the SQL text independent of their number
+  wxString sqlRemoveReferences = wxT("delete from folderprojects where fid=? and pid in ");
+  wxString sqlInsertTargetReferences = wxT("insert into folderprojects (fid,pid) select ?, pid from projects where pid in ");
+  if (useArray)
+  {
+    sqlRemoveReferences = wxSQLite3Database::RewriteArrayParams(sqlRemoveReferences + wxT("(?)"));
+    sqlInsertTargetReferences = wxSQLite3Database::RewriteArrayParams(sqlInsertTargetReferences + wxT("(?)"));
+  }
+  else
+  {
+    sqlRemoveReferences += referenceList;
+    sqlInsertTargetReferences += referenceList;
+  }
 
   // Perform SQL commands in transaction
   try
   {
     m_db->Begin();
-    m_db->ExecuteUpdate(sqlRemoveTargetReferences);
-    m_db->ExecuteUpdate(sqlInsertTargetReferences);
+    wxSQLite3Statement removeStatement = m_db->PrepareStatement(sqlRemoveReferences);
+    removeStatement.Bind(1, targetFolder);
+    if (useArray)
+    {
+      removeStatement.BindArray(2, referenceValues, (int) n, WXSQLITE_ARRAY_STATIC);
+    }
+    removeStatement.ExecuteUpdate();
+    wxSQLite3Statement insertStatement = m_db->PrepareStatement(sqlInsertTargetReferences);
+    insertStatement.Bind(1, targetFolder);
+    if (useArray)
+    {
+      insertStatement.BindArray(2, referenceValues, (int) n, WXSQLITE_ARRAY_STATIC);
+    }
+    insertStatement.ExecuteUpdate();
     if (!doCopy)
     {
-      m_db->ExecuteUpdate(sqlRemoveSourceReferences);
+      removeStatement.Bind(1, sourceFolder);
+      removeStatement.ExecuteUpdate();
     }
     m_db->Commit();
   }
@@ -29,6 +29,13 @@
 #include "wx/dynarray.h"
 #include "wx/regex.h"
 #include "wx/thread.h"
+#include "wx/stopwatch.h"
+#include "wx/ffile.h"
+
+#if wxUSE_ZLIB && wxUSE_STREAMS
+#include "wx/mstream.h"
+#include "wx/zstream.h"
+#endif
 
 #include "wx/wxsqlite3.h"
 #include "wx/wxsqlite3opt.h"
@@ -43,11 +50,292 @@
 #include "sqlite3mc_config.h"
 #include "sqlite3mc_amalgamation.h"
 
+#include <math.h>
+#include <stdlib.h>
+
 // Check for minimal required SQLite version
 #if SQLITE_VERSION_NUMBER < 3032000
 #error SQLite version 3.32.0 or higher required.
 #endif
 
+// Binding arrays requires the carray extension with its binding interface
+#if defined(SQLITE_ENABLE_CARRAY) && defined(SQLITE_CARRAY_INT32)
+#define WXSQLITE3_HAVE_CARRAY_BIND 1
+#else
+#define WXSQLITE3_HAVE_CARRAY_BIND 0
+#endif
+
+// SIMD support for ASCII fast paths of text comparisons
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WXSQLITE3_HAVE_SSE2 1
+#include <emmintrin.h>
+#else
+#define WXSQLITE3_HAVE_SSE2 0
+#endif
+
+#if defined(__AVX2__)
+#define WXSQLITE3_HAVE_AVX2 1
+#include <immintrin.h>
+#else
+#define WXSQLITE3_HAVE_AVX2 0
+#endif
+
+#if defined(__SSSE3__) || defined(__AVX2__)
+#define WXSQLITE3_HAVE_SSSE3 1
+#include <tmmintrin.h>
+#else
+#define WXSQLITE3_HAVE_SSSE3 0
+#endif
+
+// Hardware CRC-32C: SSE4.2 on x86-64 (detected at run time), CRC extension on ARMv8
+#if (defined(__x86_64__) && defined(__GNUC__)) || (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_AMD64)))
+#define WXSQLITE3_HAVE_CRC32C_SSE42 1
+#include <nmmintrin.h>
+#else
+#define WXSQLITE3_HAVE_CRC32C_SSE42 0
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define WXSQLITE3_HAVE_CRC32C_ARM 1
+#include <arm_acle.h>
+#else
+#define WXSQLITE3_HAVE_CRC32C_ARM 0
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if WXSQLITE3_HAVE_CXX11
+#include <atomic>
+#include <chrono>
+#endif
+
+// --- Wrapper overhead profiling
+
+#if WXSQLITE3_PROFILE_WRAPPER
+
+#if !WXSQLITE3_HAVE_CXX11
+#error Wrapper profiling (WXSQLITE3_PROFILE_WRAPPER) requires C++11
+#endif
+
+#include <algorithm>
+#include <vector>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define WXSQLITE3_PROFILE_RDTSC 1
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_AMD64) || defined(_M_IX86))
+#define WXSQLITE3_PROFILE_RDTSC 1
+#else
+#define WXSQLITE3_PROFILE_RDTSC 0
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define WXSQLITE3_PROFILE_FUNCTION __PRETTY_FUNCTION__
+#elif defined(_MSC_VER)
+#define WXSQLITE3_PROFILE_FUNCTION __FUNCSIG__
+#else
+#define WXSQLITE3_PROFILE_FUNCTION __func__
+#endif
+
+// Time stamp counter (CPU cycles) where available, nanoseconds otherwise
+static inline wxUint64 wxSQLite3ProfileTicks()
+{
+#if WXSQLITE3_PROFILE_RDTSC
+  return (wxUint64) __rdtsc();
+#else
+  return (wxUint64) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+static const char* wxSQLite3ProfileUnit()
+{
+  return (WXSQLITE3_PROFILE_RDTSC) ? "cycles" : "ns";
+}
+
+/// Profile counters of a single wrapper entry point (internal)
+class wxSQLite3ProfileEntry
+{
+public:
+  explicit wxSQLite3ProfileEntry(const char* name);
+
+  const char*           m_name;      ///< Function signature
+  std::atomic<wxUint64> m_calls;     ///< Number of calls
+  std::atomic<wxUint64> m_inclusive; ///< Accumulated ticks including SQLite
+  std::atomic<wxUint64> m_sqlite;    ///< Accumulated ticks spent in SQLite
+  wxSQLite3ProfileEntry* m_next;     ///< Next registered entry point
+};
+
+// List of all entry points called at least once
+static std::atomic<wxSQLite3ProfileEntry*> gs_profileEntries(NULL);
+
+wxSQLite3ProfileEntry::wxSQLite3ProfileEntry(const char* name)
+  : m_name(name), m_calls(0), m_inclusive(0), m_sqlite(0), m_next(gs_profileEntries.load())
+{
+  while (!gs_profileEntries.compare_exchange_weak(m_next, this))
+  {
+  }
+}
+
+/// Measures a single call of a wrapper entry point (internal)
+class wxSQLite3ProfileScope
+{
+public:
+  explicit wxSQLite3ProfileScope(wxSQLite3ProfileEntry& entry);
+  ~wxSQLite3ProfileScope();
+
+  /// Add ticks spent in SQLite
+  void AddSQLiteTicks(wxUint64 ticks) { m_sqlite += ticks; }
+
+private:
+  wxSQLite3ProfileEntry& m_entry;  ///< Counters of the entry point
+  wxSQLite3ProfileScope* m_parent; ///< Enclosing entry point of the same thread
+  wxUint64               m_start;  ///< Ticks at entry
+  wxUint64               m_sqlite; ///< Ticks spent in SQLite so far
+};
+
+// Innermost active entry point of the current thread
+static thread_local wxSQLite3ProfileScope* gs_profileScope = NULL;
+
+wxSQLite3ProfileScope::wxSQLite3ProfileScope(wxSQLite3ProfileEntry& entry)
+  : m_entry(entry), m_parent(gs_profileScope), m_sqlite(0)
+{
+  gs_profileScope = this;
+  m_start = wxSQLite3ProfileTicks();
+}
+
+wxSQLite3ProfileScope::~wxSQLite3ProfileScope()
+{
+  wxUint64 elapsed = wxSQLite3ProfileTicks() - m_start;
+  m_entry.m_calls.fetch_add(1, std::memory_order_relaxed);
+  m_entry.m_inclusive.fetch_add(elapsed, std::memory_order_relaxed);
+  m_entry.m_sqlite.fetch_add(m_sqlite, std::memory_order_relaxed);
+  gs_profileScope = m_parent;
+  if (m_parent != NULL)
+  {
+    m_parent->AddSQLiteTicks(m_sqlite);
+  }
+}
+
+/// Attributes the duration of a SQLite API call to the active entry point (internal)
+/**
+* Entry points invoked from within SQLite (user-defined functions, hooks) are measured
+* as top level entry points; their time counts as SQLite time of the calling entry point.
+*/
+class wxSQLite3ProfileSQLiteCall
+{
+public:
+  wxSQLite3ProfileSQLiteCall() : m_scope(gs_profileScope)
+  {
+    gs_profileScope = NULL;
+    m_start = wxSQLite3ProfileTicks();
+  }
+
+  ~wxSQLite3ProfileSQLiteCall()
+  {
+    wxUint64 elapsed = wxSQLite3ProfileTicks() - m_start;
+    gs_profileScope = m_scope;
+    if (m_scope != NULL)
+    {
+      m_scope->AddSQLiteTicks(elapsed);
+    }
+  }
+
+private:
+  wxSQLite3ProfileScope* m_scope;
+  wxUint64               m_start;
+};
+
+/// Function object wrapping a SQLite API function with timing (internal)
+template <typename R, typename... A>
+class wxSQLite3ProfiledFunction
+{
+public:
+  explicit wxSQLite3ProfiledFunction(R (*func)(A...)) : m_func(func) {}
+
+  R operator()(A... args) const
+  {
+    wxSQLite3ProfileSQLiteCall call;
+    return m_func(args...);
+  }
+
+private:
+  R (*m_func)(A...);
+};
+
+template <typename R, typename... A>
+static inline wxSQLite3ProfiledFunction<R, A...> wxSQLite3Profiled(R (*func)(A...))
+{
+  return wxSQLite3ProfiledFunction<R, A...>(func);
+}
+
+#define WXSQLITE3_PROFILE() \
+  static wxSQLite3ProfileEntry wxsqlite3ProfileEntry(WXSQLITE3_PROFILE_FUNCTION); \
+  wxSQLite3ProfileScope wxsqlite3ProfileScope(wxsqlite3ProfileEntry)
+
+// SQLite API functions used on the hot paths of the wrapper are timed;
+// the remaining (mostly variadic or rarely used) functions count as wrapper time
+#define sqlite3_step                 wxSQLite3Profiled(&::sqlite3_step)
+#define sqlite3_reset                wxSQLite3Profiled(&::sqlite3_reset)
+#define sqlite3_finalize             wxSQLite3Profiled(&::sqlite3_finalize)
+#define sqlite3_prepare_v2           wxSQLite3Profiled(&::sqlite3_prepare_v2)
+#define sqlite3_prepare_v3           wxSQLite3Profiled(&::sqlite3_prepare_v3)
+#define sqlite3_exec                 wxSQLite3Profiled(&::sqlite3_exec)
+#define sqlite3_get_table            wxSQLite3Profiled(&::sqlite3_get_table)
+#define sqlite3_free_table           wxSQLite3Profiled(&::sqlite3_free_table)
+#define sqlite3_changes              wxSQLite3Profiled(&::sqlite3_changes)
+#define sqlite3_last_insert_rowid    wxSQLite3Profiled(&::sqlite3_last_insert_rowid)
+#define sqlite3_get_autocommit       wxSQLite3Profiled(&::sqlite3_get_autocommit)
+#define sqlite3_clear_bindings       wxSQLite3Profiled(&::sqlite3_clear_bindings)
+#define sqlite3_bind_int             wxSQLite3Profiled(&::sqlite3_bind_int)
+#define sqlite3_bind_int64           wxSQLite3Profiled(&::sqlite3_bind_int64)
+#define sqlite3_bind_double          wxSQLite3Profiled(&::sqlite3_bind_double)
+#define sqlite3_bind_text            wxSQLite3Profiled(&::sqlite3_bind_text)
+#define sqlite3_bind_blob            wxSQLite3Profiled(&::sqlite3_bind_blob)
+#define sqlite3_bind_null            wxSQLite3Profiled(&::sqlite3_bind_null)
+#define sqlite3_bind_zeroblob        wxSQLite3Profiled(&::sqlite3_bind_zeroblob)
+#define sqlite3_bind_parameter_index wxSQLite3Profiled(&::sqlite3_bind_parameter_index)
+#define sqlite3_bind_parameter_count wxSQLite3Profiled(&::sqlite3_bind_parameter_count)
+#define sqlite3_column_count         wxSQLite3Profiled(&::sqlite3_column_count)
+#define sqlite3_column_type          wxSQLite3Profiled(&::sqlite3_column_type)
+#define sqlite3_column_int           wxSQLite3Profiled(&::sqlite3_column_int)
+#define sqlite3_column_int64         wxSQLite3Profiled(&::sqlite3_column_int64)
+#define sqlite3_column_double        wxSQLite3Profiled(&::sqlite3_column_double)
+#define sqlite3_column_text          wxSQLite3Profiled(&::sqlite3_column_text)
+#define sqlite3_column_blob          wxSQLite3Profiled(&::sqlite3_column_blob)
+#define sqlite3_column_bytes         wxSQLite3Profiled(&::sqlite3_column_bytes)
+#define sqlite3_column_name          wxSQLite3Profiled(&::sqlite3_column_name)
+#define sqlite3_column_decltype      wxSQLite3Profiled(&::sqlite3_column_decltype)
+#define sqlite3_value_type           wxSQLite3Profiled(&::sqlite3_value_type)
+#define sqlite3_value_int            wxSQLite3Profiled(&::sqlite3_value_int)
+#define sqlite3_value_int64          wxSQLite3Profiled(&::sqlite3_value_int64)
+#define sqlite3_value_double         wxSQLite3Profiled(&::sqlite3_value_double)
+#define sqlite3_value_text           wxSQLite3Profiled(&::sqlite3_value_text)
+#define sqlite3_value_blob           wxSQLite3Profiled(&::sqlite3_value_blob)
+#define sqlite3_value_bytes          wxSQLite3Profiled(&::sqlite3_value_bytes)
+#define sqlite3_result_int           wxSQLite3Profiled(&::sqlite3_result_int)
+#define sqlite3_result_int64         wxSQLite3Profiled(&::sqlite3_result_int64)
+#define sqlite3_result_double        wxSQLite3Profiled(&::sqlite3_result_double)
+#define sqlite3_result_text          wxSQLite3Profiled(&::sqlite3_result_text)
+#define sqlite3_result_blob          wxSQLite3Profiled(&::sqlite3_result_blob)
+#define sqlite3_result_null          wxSQLite3Profiled(&::sqlite3_result_null)
+#define sqlite3_blob_open            wxSQLite3Profiled(&::sqlite3_blob_open)
+#define sqlite3_blob_read            wxSQLite3Profiled(&::sqlite3_blob_read)
+#define sqlite3_blob_write           wxSQLite3Profiled(&::sqlite3_blob_write)
+#define sqlite3_blob_reopen          wxSQLite3Profiled(&::sqlite3_blob_reopen)
+#define sqlite3_blob_close           wxSQLite3Profiled(&::sqlite3_blob_close)
+#define sqlite3_blob_bytes           wxSQLite3Profiled(&::sqlite3_blob_bytes)
+#define sqlite3_open_v2              wxSQLite3Profiled(&::sqlite3_open_v2)
+#define sqlite3_close                wxSQLite3Profiled(&::sqlite3_close)
+#define sqlite3_errmsg               wxSQLite3Profiled(&::sqlite3_errmsg)
+
+#else
+
+#define WXSQLITE3_PROFILE()
+
+#endif
+
 typedef int (*sqlite3_xauth)(void*,int,const char*,const char*,const char*,const char*);
 
 // Local declaration of the ExecAuthorizer function
@@ -65,6 +353,14 @@ typedef char err_char_t;
 typedef wxChar err_char_t;
 #endif
 
+// UTF-8 representation of a wxString; in wxUSE_UNICODE_UTF8 builds it refers to
+// the string data itself, while a wxCharBuffer would make a copy
+#if wxCHECK_VERSION(3,0,0)
+typedef wxScopedCharBuffer wxSQLite3Utf8Buffer;
+#else
+typedef wxCharBuffer wxSQLite3Utf8Buffer;
+#endif
+
 const err_char_t* wxERRMSG_NODB = wxTRANSLATE("No Database opened");
 const err_char_t* wxERRMSG_NOSTMT = wxTRANSLATE("Statement not accessible");
 const err_char_t* wxERRMSG_NOMEM = wxTRANSLATE("Out of memory");
@@ -85,7 +381,13 @@ const err_char_t* wxERRMSG_BIND_DATETIME = wxTRANSLATE("Error binding date/time
 const err_char_t* wxERRMSG_BIND_NULL = wxTRANSLATE("Error binding NULL param");
 const err_char_t* wxERRMSG_BIND_ZEROBLOB = wxTRANSLATE("Error binding zero blob param");
 const err_char_t* wxERRMSG_BIND_POINTER = wxTRANSLATE("Error binding pointer param");
+const err_char_t* wxERRMSG_BIND_ARRAY = wxTRANSLATE("Error binding array param");
 const err_char_t* wxERRMSG_BIND_CLEAR = wxTRANSLATE("Error clearing bindings");
+const err_char_t* wxERRMSG_PARAM_COUNT = wxTRANSLATE("Number of statement parameters does not match");
+const err_char_t* wxERRMSG_COLUMN_COUNT = wxTRANSLATE("Number of result columns does not match");
+const err_char_t* wxERRMSG_RETURNS_ROWS = wxTRANSLATE("Statement returns rows, use a query instead");
+const err_char_t* wxERRMSG_TEXT_TOOBIG = wxTRANSLATE("Text exceeds the maximum length of 2147483647 bytes");
+const err_char_t* wxERRMSG_INT64_RANGE = wxTRANSLATE("Integer value out of the range of a signed 64-bit integer");
 
 const err_char_t* wxERRMSG_NOMETADATA = wxTRANSLATE("Meta data support not available");
 const err_char_t* wxERRMSG_NOCODEC = wxTRANSLATE("Encryption support not available");
@@ -93,10 +395,19 @@ const err_char_t* wxERRMSG_NOLOADEXT = wxTRANSLATE("Loadable extension support n
 const err_char_t* wxERRMSG_NOINCBLOB = wxTRANSLATE("Incremental BLOB support not available");
 const err_char_t* wxERRMSG_NOBLOBREBIND = wxTRANSLATE("Rebind BLOB support not available");
 const err_char_t* wxERRMSG_NOPOINTER = wxTRANSLATE("Pointer parameter support not available");
+const err_char_t* wxERRMSG_NOARRAY = wxTRANSLATE("Array parameter support (carray) not available");
 const err_char_t* wxERRMSG_NOSAVEPOINT = wxTRANSLATE("Savepoint support not available");
 const err_char_t* wxERRMSG_NOBACKUP = wxTRANSLATE("Backup/restore support not available");
 const err_char_t* wxERRMSG_NOWAL = wxTRANSLATE("Write Ahead Log support not available");
 const err_char_t* wxERRMSG_NOCOLLECTIONS = wxTRANSLATE("Named collection support not available");
+const err_char_t* wxERRMSG_NOTRIGRAM = wxTRANSLATE("Trigram index support not available");
+const err_char_t* wxERRMSG_NOZLIB = wxTRANSLATE("Compression support not available");
+const err_char_t* wxERRMSG_NOPREUPDATEHOOK = wxTRANSLATE("Pre-update hook support not available");
+const err_char_t* wxERRMSG_NOSCANSTATUS = wxTRANSLATE("Statement scan status support not available");
+const err_char_t* wxERRMSG_PLAN_MISMATCH = wxTRANSLATE("Query plan differs from the expected plan");
+const err_char_t* wxERRMSG_PLAN_EXPECTED = wxTRANSLATE("Expected:");
+const err_char_t* wxERRMSG_PLAN_ACTUAL = wxTRANSLATE("Actual:");
+const err_char_t* wxERRMSG_PROFILER_ATTACHED = wxTRANSLATE("Sampling profiler is attached to another database connection");
 
 const err_char_t* wxERRMSG_SHARED_CACHE = wxTRANSLATE("Setting SQLite shared cache mode failed");
 
@@ -158,13 +469,119 @@ static wxCriticalSection gs_csStatment;
 static wxCriticalSection gs_csBlob;
 #endif
 
+/// Change data capture feed of a database connection (internal)
+class wxSQLite3ChangeFeed
+{
+public:
+  /// Constructor
+  wxSQLite3ChangeFeed(wxSQLite3DatabaseReference* db, wxSQLite3ChangeListener* listener, bool captureValues);
+
+  /// Destructor
+  ~wxSQLite3ChangeFeed();
+
+  /// Replace the listener of the feed
+  void SetListener(wxSQLite3ChangeListener* listener, bool captureValues);
+
+  /// Discard all buffered changes
+  void Clear();
+
+  /// Get the number of buffered changes
+  size_t GetChangeCount() const { return m_changeCount; }
+
+  /// Process the end of the first step of a statement
+  /**
+  * Discards the changes of a statement that was rolled back because of an error,
+  * and tracks the savepoints, discarding the changes undone by ROLLBACK TO.
+  * \param db SQLite database connection
+  * \param stmt statement that was stepped
+  * \param rc result code of the step
+  * \param changeCount number of buffered changes before the step
+  * \param totalChanges total number of changes of the connection before the step
+  */
+  void EndStatement(sqlite3* db, sqlite3_stmt* stmt, int rc, size_t changeCount, int totalChanges);
+
+  /// Execute the pre-update hook
+  static void ExecPreUpdateHook(void* feed, sqlite3* db, int op,
+                                const char* database, const char* table,
+                                sqlite3_int64 oldRowId, sqlite3_int64 newRowId);
+
+  /// Execute the commit hook
+  static int ExecCommitHook(void* feed);
+
+  /// Execute the rollback hook
+  static void ExecRollbackHook(void* feed);
+
+private:
+  /// Interned table name
+  struct TableEntry
+  {
+    char*     m_databaseName; ///< UTF-8 database name
+    char*     m_tableName;    ///< UTF-8 table name
+    wxString* m_database;     ///< Interned database name
+    wxString* m_table;        ///< Interned table name
+    bool      m_capture;      ///< Flag whether changes of the table are captured
+  };
+
+  /// Find or add the entry of a table, returning -1 if memory is exhausted
+  int FindTable(const char* database, const char* table);
+
+  /// Ask the listener whether the changes of a table should be captured
+  bool CaptureTable(const TableEntry& entry);
+
+  /// Kind of savepoint statement
+  enum { SAVEPOINT_BEGIN, SAVEPOINT_RELEASE, SAVEPOINT_ROLLBACK };
+
+  /// Active savepoint
+  struct SavepointEntry
+  {
+    char*  m_name;        ///< UTF-8 name of the savepoint (unquoted)
+    size_t m_changeCount; ///< Number of buffered changes when the savepoint was started
+  };
+
+  /// Capture a single row change
+  bool AddChange(sqlite3* db, int op, const TableEntry& entry,
+                 sqlite3_int64 oldRowId, sqlite3_int64 newRowId);
+
+  /// Discard the buffered changes beyond the given number of changes
+  void Truncate(size_t changeCount);
+
+  /// Find the most recent savepoint of the given name, returning -1 if there is none
+  int FindSavepoint(const char* name) const;
+
+  /// Remove the savepoints beyond the given number of savepoints
+  void PopSavepoints(int savepointCount);
+
+  /// Track SAVEPOINT, RELEASE and ROLLBACK TO statements
+  void ProcessSavepoint(const char* sql);
+
+  wxSQLite3DatabaseReference* m_db;         ///< Database connection, chaining to its user defined hooks
+  wxSQLite3ChangeListener* m_listener;      ///< Consumer of the feed
+  bool                     m_captureValues; ///< Flag whether column values are captured
+  bool                     m_failed;        ///< Flag whether capturing a change failed
+  TableEntry*              m_tables;        ///< Interned table names
+  int                      m_tableCount;    ///< Number of interned table names
+  int                      m_tableAlloc;    ///< Capacity of the table array
+  int                      m_lastTable;     ///< Index of the most recently modified table
+  wxSQLite3RowChange*      m_changes;       ///< Buffered changes
+  size_t                   m_changeCount;   ///< Number of buffered changes
+  size_t                   m_changeAlloc;   ///< Capacity of the change array
+  void**                   m_values;        ///< Pool of captured column values
+  size_t                   m_valueCount;    ///< Number of captured column values
+  size_t                   m_valueAlloc;    ///< Capacity of the value pool
+  SavepointEntry*          m_savepoints;    ///< Active savepoints, innermost last
+  int                      m_savepointCount; ///< Number of active savepoints
+  int                      m_savepointAlloc; ///< Capacity of the savepoint array
+};
+
 /// Reference counted database object (internal)
 class wxSQLite3DatabaseReference
 {
 public:
   /// Default constructor
   wxSQLite3DatabaseReference(sqlite3* db = NULL)
-    : m_db(db)
+    : m_db(db), m_changeFeed(NULL), m_planListener(NULL), m_recorder(NULL), m_busyTimeoutMs(0),
+      m_samplingProfiler(NULL), m_commitHook(NULL), m_rollbackHook(NULL), m_updateHook(NULL), m_walHook(NULL),
+      m_currentStmt(NULL)
   {
     m_db = db;
     if (m_db != NULL)
@@ -182,12 +599,18 @@ public:
   /// Default destructor
   virtual ~wxSQLite3DatabaseReference()
   {
+    delete m_changeFeed;
+    DetachSamplingProfiler();
   }
 
+  /// Release the attached sampling profiler, without touching the progress handler
+  void DetachSamplingProfiler();
+
 private:
   /// Thread safe increment of the reference count
   int IncrementRefCount()
   {
+    WXSQLITE3_PROFILE();
 #if wxUSE_THREADS
     wxCriticalSectionLocker locker(gs_csDatabase);
 #endif
@@ -206,6 +629,7 @@ private:
   /// Thread safe decrement of the reference count
   int DecrementRefCount()
   {
+    WXSQLITE3_PROFILE();
 #if wxUSE_THREADS
     wxCriticalSectionLocker locker(gs_csDatabase);
 #endif
@@ -216,11 +640,56 @@ private:
   sqlite3* m_db;        ///< SQLite database reference
   int      m_refCount;  ///< Reference count
   bool     m_isValid;   ///< SQLite database reference is valid
+  wxSQLite3ChangeFeed* m_changeFeed; ///< Change data capture feed
+  wxSQLite3PlanChangeListener* m_planListener; ///< Listener for query plan changes
+  wxSQLite3EventRecorder* m_recorder; ///< Attached event recorder
+  int      m_busyTimeoutMs; ///< Busy timeout implemented by the recording busy handler
+  wxSQLite3SamplingProfiler* m_samplingProfiler; ///< Attached sampling profiler
+  wxSQLite3Hook* m_commitHook;   ///< User defined commit hook
+  wxSQLite3Hook* m_rollbackHook; ///< User defined rollback hook
+  wxSQLite3Hook* m_updateHook;   ///< User defined update hook
+  wxSQLite3Hook* m_walHook;      ///< User defined write-ahead log hook
+
+public:
+  sqlite3_stmt* m_currentStmt; ///< Statement being stepped while a sampling profiler is attached
+
+  /// Check whether a sampling profiler is attached
+  bool IsSampling() const { return m_samplingProfiler != NULL; }
+
+  /// Get the attached event recorder if it is recording
+  wxSQLite3EventRecorder* GetActiveRecorder() const
+  {
+    return (m_recorder != NULL && m_recorder->IsRecording()) ? m_recorder : NULL;
+  }
+
+  /// Get the SQLite database handle
+  sqlite3* GetHandle() const { return m_db; }
+
+  /// Get the change data capture feed, if one is active
+  wxSQLite3ChangeFeed* GetChangeFeed() const { return m_changeFeed; }
+
+  /// Busy handler recording the busy waits (internal)
+  static int ExecBusyHandler(void* dbRef, int count);
+
+  /// Execute the user defined commit hook, recording it if an event recorder is active (internal)
+  static int ExecCommitHook(void* dbRef);
+
+  /// Execute the user defined rollback hook, recording it if an event recorder is active (internal)
+  static void ExecRollbackHook(void* dbRef);
+
+  /// Execute the user defined update hook, recording it if an event recorder is active (internal)
+  static void ExecUpdateHook(void* dbRef, int type, const char* database, const char* table, sqlite3_int64 rowid);
+
+  /// Execute the user defined write-ahead log hook, recording it if an event recorder is active (internal)
+  static int ExecWriteAheadLogHook(void* dbRef, sqlite3* dbHandle, const char* database, int numPages);
 
   friend class WXDLLIMPEXP_FWD_SQLITE3 wxSQLite3Database;
   friend class WXDLLIMPEXP_FWD_SQLITE3 wxSQLite3ResultSet;
   friend class WXDLLIMPEXP_FWD_SQLITE3 wxSQLite3Statement;
   friend class WXDLLIMPEXP_FWD_SQLITE3 wxSQLite3Blob;
+  friend class WXDLLIMPEXP_FWD_SQLITE3 wxSQLite3StatusSampler;
+  friend class wxSQLite3StatusSamplerThread;
+  friend class wxSQLite3SamplerState;
 };
 
 /// Reference counted statement object (internal)
@@ -229,7 +698,7 @@ class wxSQLite3StatementReference
 public:
   /// Default constructor
   wxSQLite3StatementReference(sqlite3_stmt* stmt = NULL)
-    : m_stmt(stmt), m_ptrTypes(NULL)
+    : m_stmt(stmt), m_ptrTypes(NULL), m_capturePlan(false), m_prepareCount(0)
   {
     m_stmt = stmt;
     if (m_stmt != NULL)
@@ -262,6 +731,7 @@ private:
   /// Thread safe increment of the reference count
   int IncrementRefCount()
   {
+    WXSQLITE3_PROFILE();
 #if wxUSE_THREADS
     wxCriticalSectionLocker locker(gs_csStatment);
 #endif
@@ -271,6 +741,7 @@ private:
   /// Thread safe decrement of the reference count
   int DecrementRefCount()
   {
+    WXSQLITE3_PROFILE();
 #if wxUSE_THREADS
     wxCriticalSectionLocker locker(gs_csStatment);
 #endif
@@ -304,9 +775,13 @@ private:
   int             m_refCount;       ///< Reference count
   bool            m_isValid;        ///< SQLite statement reference is valid
   wxArrayPtrVoid* m_ptrTypes;       ///< Keeping track of pointer types
+  bool            m_capturePlan;    ///< Flag whether the query plan is monitored
+  int             m_prepareCount;   ///< Number of re-prepares at the time the query plan was captured
+  wxString        m_plan;           ///< Captured query plan fingerprint
 
   friend class WXDLLIMPEXP_FWD_SQLITE3 wxSQLite3ResultSet;
   friend class WXDLLIMPEXP_FWD_SQLITE3 wxSQLite3Statement;
+  friend class WXDLLIMPEXP_FWD_SQLITE3 wxSQLite3Database;
 };
 
 /// Reference counted blob object (internal)
@@ -339,6 +814,7 @@ private:
   /// Thread safe increment of the reference count
   int IncrementRefCount()
   {
+    WXSQLITE3_PROFILE();
 #if wxUSE_THREADS
     wxCriticalSectionLocker locker(gs_csBlob);
 #endif
@@ -348,6 +824,7 @@ private:
   /// Thread safe decrement of the reference count
   int DecrementRefCount()
   {
+    WXSQLITE3_PROFILE();
 #if wxUSE_THREADS
     wxCriticalSectionLocker locker(gs_csBlob);
 #endif
@@ -371,6 +848,151 @@ private:
   friend class WXDLLIMPEXP_FWD_SQLITE3 wxSQLite3Blob;
 };
 
+// Execute a step of a statement, recording it if an event recorder is active
+static int wxSQLite3StepStatement(wxSQLite3DatabaseReference* db, sqlite3_stmt* stmt)
+{
+  // The sampling profiler attributes samples to the statement being stepped. Statements may be
+  // nested, i.e. stepped from within a user defined function. The connection mutex keeps other
+  // threads using the same connection from stepping their statements in between.
+  bool sampling = db->IsSampling();
+  sqlite3_mutex* mutex = NULL;
+  sqlite3_stmt* outerStmt = NULL;
+  if (sampling)
+  {
+    mutex = sqlite3_db_mutex(db->GetHandle());
+    sqlite3_mutex_enter(mutex);
+    outerStmt = db->m_currentStmt;
+    db->m_currentStmt = stmt;
+  }
+
+  // The change feed needs to know where a statement starts to undo its changes on error
+  wxSQLite3ChangeFeed* feed = (!sqlite3_stmt_busy(stmt)) ? db->GetChangeFeed() : NULL;
+  size_t changeCount = 0;
+  int totalChanges = 0;
+  if (feed != NULL)
+  {
+    changeCount = feed->GetChangeCount();
+    totalChanges = sqlite3_total_changes(db->GetHandle());
+  }
+
+  wxSQLite3EventRecorder* recorder = db->GetActiveRecorder();
+  int rc;
+  if (recorder == NULL)
+  {
+    rc = sqlite3_step(stmt);
+  }
+  else
+  {
+    wxUint64 start = wxSQLite3EventRecorder::GetTimestamp();
+    rc = sqlite3_step(stmt);
+    recorder->Record("statement", "step", start, wxSQLite3EventRecorder::GetTimestamp(), "sql", sqlite3_sql(stmt), "rc", rc);
+  }
+
+  // The feed may have been removed by a hook during the step
+  if (feed != NULL && feed == db->GetChangeFeed())
+  {
+    feed->EndStatement(db->GetHandle(), stmt, rc, changeCount, totalChanges);
+  }
+  if (sampling)
+  {
+    db->m_currentStmt = outerStmt;
+    sqlite3_mutex_leave(mutex);
+  }
+  return rc;
+}
+
+// Execute SQL text consisting of one or more statements
+// Unlike sqlite3_exec each statement is stepped by wxSQLite3StepStatement.
+static int wxSQLite3ExecuteStatements(wxSQLite3DatabaseReference* db, const char* sql, int sqlLen)
+{
+  const char* tail = sql;
+  const char* end = sql + sqlLen;
+  int rc = SQLITE_OK;
+  while (rc == SQLITE_OK && tail < end)
+  {
+    sqlite3_stmt* stmt = NULL;
+    rc = sqlite3_prepare_v2(db->GetHandle(), tail, (int) (end - tail), &stmt, &tail);
+    if (rc != SQLITE_OK || stmt == NULL)
+    {
+      // Error, or only whitespace or comments remaining
+      break;
+    }
+    do
+    {
+      rc = wxSQLite3StepStatement(db, stmt);
+    }
+    while (rc == SQLITE_ROW);
+    sqlite3_finalize(stmt);
+    if (rc == SQLITE_DONE)
+    {
+      rc = SQLITE_OK;
+    }
+  }
+  return rc;
+}
+
+// Execute NUL terminated SQL text like sqlite3_exec
+// While a change feed is active the statements are stepped individually,
+// so that the feed sees the statement boundaries.
+static int wxSQLite3ExecuteUpdate(wxSQLite3DatabaseReference* db, const char* sql, char** errmsg)
+{
+  if (db->GetChangeFeed() == NULL)
+  {
+    return sqlite3_exec(db->GetHandle(), sql, 0, 0, errmsg);
+  }
+  int rc = wxSQLite3ExecuteStatements(db, sql, (int) strlen(sql));
+  if (rc != SQLITE_OK)
+  {
+    *errmsg = sqlite3_mprintf("%s", sqlite3_errmsg(db->GetHandle()));
+  }
+  return rc;
+}
+
+/// Records the duration of a database operation if an event recorder is active (internal)
+class wxSQLite3RecorderScope
+{
+public:
+  wxSQLite3RecorderScope(wxSQLite3EventRecorder* recorder, const char* category, const char* name)
+    : m_recorder((recorder != NULL && recorder->IsRecording()) ? recorder : NULL),
+      m_category(category), m_name(name), m_detailName(NULL), m_detail(NULL), m_argName(NULL), m_argValue(0)
+  {
+    m_start = (m_recorder != NULL) ? wxSQLite3EventRecorder::GetTimestamp() : 0;
+  }
+
+  ~wxSQLite3RecorderScope()
+  {
+    if (m_recorder != NULL)
+    {
+      m_recorder->Record(m_category, m_name, m_start, wxSQLite3EventRecorder::GetTimestamp(),
+                         m_detailName, m_detail, m_argName, m_argValue);
+    }
+  }
+
+  /// Set the detail text (has to remain valid until the end of the scope)
+  void SetDetail(const char* detailName, const char* detail)
+  {
+    m_detailName = detailName;
+    m_detail = detail;
+  }
+
+  /// Set the numeric argument
+  void SetArg(const char* argName, wxInt64 argValue)
+  {
+    m_argName = argName;
+    m_argValue = argValue;
+  }
+
+private:
+  wxSQLite3EventRecorder* m_recorder;
+  const char* m_category;
+  const char* m_name;
+  const char* m_detailName;
+  const char* m_detail;
+  const char* m_argName;
+  wxInt64     m_argValue;
+  wxUint64    m_start;
+};
+
 // ----------------------------------------------------------------------------
 // inline conversion from wxString to wxLongLong
 // ----------------------------------------------------------------------------
@@ -409,6 +1031,7 @@ inline wxLongLong ConvertStringToLongLong(const wxString& str, wxLongLong defVal
 wxSQLite3Exception::wxSQLite3Exception(int errorCode, const wxString& errorMsg)
   : m_errorCode(errorCode)
 {
+  WXSQLITE3_PROFILE();
   m_errorMessage = ErrorCodeAsString(errorCode) + wxS("[") +
                    wxString::Format(wxS("%d"), errorCode) + wxS("]: ") +
                    wxGetTranslation(errorMsg);
@@ -417,6 +1040,7 @@ wxSQLite3Exception::wxSQLite3Exception(int errorCode, const wxString& errorMsg)
 wxSQLite3Exception::wxSQLite3Exception(const wxSQLite3Exception&  e)
   : m_errorCode(e.m_errorCode), m_errorMessage(e.m_errorMessage)
 {
+  WXSQLITE3_PROFILE();
 }
 
 const wxString wxSQLite3Exception::ErrorCodeAsString(int errorCode)
@@ -515,6 +1139,76 @@ wxSQLite3Exception::~wxSQLite3Exception()
 {
 }
 
+// ----------------------------------------------------------------------------
+// wxSQLite3Result: result of an operation of the non-throwing API
+// ----------------------------------------------------------------------------
+
+bool wxSQLite3Result::IsOk() const
+{
+  return m_errorCode == SQLITE_OK || m_errorCode == SQLITE_ROW || m_errorCode == SQLITE_DONE;
+}
+
+bool wxSQLite3Result::HasRow() const
+{
+  return m_errorCode == SQLITE_ROW;
+}
+
+bool wxSQLite3Result::IsBusy() const
+{
+  int errorCode = GetErrorCode();
+  return errorCode == SQLITE_BUSY || errorCode == SQLITE_LOCKED;
+}
+
+bool wxSQLite3Result::IsConstraint() const
+{
+  return GetErrorCode() == SQLITE_CONSTRAINT;
+}
+
+wxString wxSQLite3Result::GetMessage() const
+{
+  if (IsOk())
+  {
+    return wxEmptyString;
+  }
+  return wxSQLite3Exception(m_errorCode, wxString::FromUTF8(m_message)).GetMessage();
+}
+
+void wxSQLite3Result::ThrowIfFailed() const
+{
+  if (!IsOk())
+  {
+    throw wxSQLite3Exception(m_errorCode, wxString::FromUTF8(m_message));
+  }
+}
+
+/* static */
+wxSQLite3Result wxSQLite3Result::TextTooBig()
+{
+  wxSQLite3Result result;
+  result.SetError(SQLITE_TOOBIG, wxString(wxERRMSG_TEXT_TOOBIG).ToUTF8());
+  return result;
+}
+
+void wxSQLite3Result::SetError(int errorCode, const char* message)
+{
+  m_errorCode = errorCode;
+  size_t length = (message != NULL) ? strlen(message) : 0;
+  if (length >= (size_t) MESSAGE_SIZE)
+  {
+    // Truncate at a character boundary
+    length = MESSAGE_SIZE - 1;
+    while (length > 0 && (((unsigned char) message[length]) & 0xC0) == 0x80)
+    {
+      --length;
+    }
+  }
+  if (length > 0)
+  {
+    memcpy(m_message, message, length);
+  }
+  m_message[length] = '\0';
+}
+
 // ----------------------------------------------------------------------------
 // wxSQLite3StatementBuffer: class providing a statement buffer
 //                           for use with the SQLite3 vmprintf function
@@ -667,12 +1361,14 @@ wxSQLite3ResultSet& wxSQLite3ResultSet::operator=(const wxSQLite3ResultSet& resu
 
 int wxSQLite3ResultSet::GetColumnCount() const
 {
+  WXSQLITE3_PROFILE();
   CheckStmt();
   return m_cols;
 }
 
 wxString wxSQLite3ResultSet::GetAsString(int columnIndex) const
 {
+  WXSQLITE3_PROFILE();
   CheckStmt();
 
   if (columnIndex < 0 || columnIndex > m_cols-1)
@@ -686,6 +1382,7 @@ wxString wxSQLite3ResultSet::GetAsString(int columnIndex) const
 
 wxString wxSQLite3ResultSet::GetAsString(const wxString& columnName) const
 {
+  WXSQLITE3_PROFILE();
   int columnIndex = FindColumnIndex(columnName);
   const char* localValue = (const char*) sqlite3_column_text(m_stmt->m_stmt, columnIndex);
   return wxString::FromUTF8(localValue);
@@ -693,6 +1390,7 @@ wxString wxSQLite3ResultSet::GetAsString(const wxString& columnName) const
 
 int wxSQLite3ResultSet::GetInt(int columnIndex, int nullValue /* = 0 */) const
 {
+  WXSQLITE3_PROFILE();
   if (GetColumnType(columnIndex) == SQLITE_NULL)
   {
     return nullValue;
@@ -706,12 +1404,14 @@ int wxSQLite3ResultSet::GetInt(int columnIndex, int nullValue /* = 0 */) const
 
 int wxSQLite3ResultSet::GetInt(const wxString& columnName, int nullValue /* = 0 */) const
 {
+  WXSQLITE3_PROFILE();
   int columnIndex = FindColumnIndex(columnName);
   return GetInt(columnIndex, nullValue);
 }
 
 wxLongLong wxSQLite3ResultSet::GetInt64(int columnIndex, wxLongLong nullValue /* = 0 */) const
 {
+  WXSQLITE3_PROFILE();
   if (GetColumnType(columnIndex) == SQLITE_NULL)
   {
     return nullValue;
@@ -724,12 +1424,14 @@ wxLongLong wxSQLite3ResultSet::GetInt64(int columnIndex, wxLongLong nullValue /*
 
 wxLongLong wxSQLite3ResultSet::GetInt64(const wxString& columnName, wxLongLong nullValue /* = 0 */) const
 {
+  WXSQLITE3_PROFILE();
   int columnIndex = FindColumnIndex(columnName);
   return GetInt64(columnIndex, nullValue);
 }
 
 double wxSQLite3ResultSet::GetDouble(int columnIndex, double nullValue /* = 0.0 */) const
 {
+  WXSQLITE3_PROFILE();
   if (GetColumnType(columnIndex) == SQLITE_NULL)
   {
     return nullValue;
@@ -742,12 +1444,14 @@ double wxSQLite3ResultSet::GetDouble(int columnIndex, double nullValue /* = 0.0
 
 double wxSQLite3ResultSet::GetDouble(const wxString& columnName, double nullValue /* = 0.0 */) const
 {
+  WXSQLITE3_PROFILE();
   int columnIndex = FindColumnIndex(columnName);
   return GetDouble(columnIndex, nullValue);
 }
 
 wxString wxSQLite3ResultSet::GetString(int columnIndex, const wxString& nullValue /* = wxEmptyString */) const
 {
+  WXSQLITE3_PROFILE();
   if (GetColumnType(columnIndex) == SQLITE_NULL)
   {
     return nullValue;
@@ -761,12 +1465,14 @@ wxString wxSQLite3ResultSet::GetString(int columnIndex, const wxString& nullValu
 
 wxString wxSQLite3ResultSet::GetString(const wxString& columnName, const wxString& nullValue /* = wxEmptyString */) const
 {
+  WXSQLITE3_PROFILE();
   int columnIndex = FindColumnIndex(columnName);
   return GetString(columnIndex, nullValue);
 }
 
 const unsigned char* wxSQLite3ResultSet::GetBlob(int columnIndex, int& len) const
 {
+  WXSQLITE3_PROFILE();
   CheckStmt();
 
   if (columnIndex < 0 || columnIndex > m_cols-1)
@@ -780,12 +1486,14 @@ const unsigned char* wxSQLite3ResultSet::GetBlob(int columnIndex, int& len) cons
 
 const unsigned char* wxSQLite3ResultSet::GetBlob(const wxString& columnName, int& len) const
 {
+  WXSQLITE3_PROFILE();
   int columnIndex = FindColumnIndex(columnName);
   return GetBlob(columnIndex, len);
 }
 
 wxMemoryBuffer& wxSQLite3ResultSet::GetBlob(int columnIndex, wxMemoryBuffer& buffer) const
 {
+  WXSQLITE3_PROFILE();
   CheckStmt();
 
   if (columnIndex < 0 || columnIndex > m_cols-1)
@@ -801,12 +1509,14 @@ wxMemoryBuffer& wxSQLite3ResultSet::GetBlob(int columnIndex, wxMemoryBuffer& buf
 
 wxMemoryBuffer& wxSQLite3ResultSet::GetBlob(const wxString& columnName, wxMemoryBuffer& buffer) const
 {
+  WXSQLITE3_PROFILE();
   int columnIndex = FindColumnIndex(columnName);
   return GetBlob(columnIndex, buffer);
 }
 
 wxDateTime wxSQLite3ResultSet::GetDate(int columnIndex) const
 {
+  WXSQLITE3_PROFILE();
   if (GetColumnType(columnIndex) == SQLITE_NULL)
   {
     return wxInvalidDateTime;
@@ -828,6 +1538,7 @@ wxDateTime wxSQLite3ResultSet::GetDate(int columnIndex) const
 
 wxDateTime wxSQLite3ResultSet::GetDate(const wxString& columnName) const
 {
+  WXSQLITE3_PROFILE();
   int columnIndex = FindColumnIndex(columnName);
   return GetDate(columnIndex);
 }
@@ -835,6 +1546,7 @@ wxDateTime wxSQLite3ResultSet::GetDate(const wxString& columnName) const
 
 wxDateTime wxSQLite3ResultSet::GetTime(int columnIndex) const
 {
+  WXSQLITE3_PROFILE();
   if (GetColumnType(columnIndex) == SQLITE_NULL)
   {
     return wxInvalidDateTime;
@@ -856,12 +1568,14 @@ wxDateTime wxSQLite3ResultSet::GetTime(int columnIndex) const
 
 wxDateTime wxSQLite3ResultSet::GetTime(const wxString& columnName) const
 {
+  WXSQLITE3_PROFILE();
   int columnIndex = FindColumnIndex(columnName);
   return GetTime(columnIndex);
 }
 
 wxDateTime wxSQLite3ResultSet::GetDateTime(int columnIndex) const
 {
+  WXSQLITE3_PROFILE();
   if (GetColumnType(columnIndex) == SQLITE_NULL)
   {
     return wxInvalidDateTime;
@@ -884,12 +1598,14 @@ wxDateTime wxSQLite3ResultSet::GetDateTime(int columnIndex) const
 
 wxDateTime wxSQLite3ResultSet::GetDateTime(const wxString& columnName) const
 {
+  WXSQLITE3_PROFILE();
   int columnIndex = FindColumnIndex(columnName);
   return GetDateTime(columnIndex);
 }
 
 wxDateTime wxSQLite3ResultSet::GetTimestamp(int columnIndex) const
 {
+  WXSQLITE3_PROFILE();
   if (GetColumnType(columnIndex) == SQLITE_NULL)
   {
     return wxInvalidDateTime;
@@ -911,12 +1627,14 @@ wxDateTime wxSQLite3ResultSet::GetTimestamp(int columnIndex) const
 
 wxDateTime wxSQLite3ResultSet::GetTimestamp(const wxString& columnName) const
 {
+  WXSQLITE3_PROFILE();
   int columnIndex = FindColumnIndex(columnName);
   return GetTimestamp(columnIndex);
 }
 
 wxDateTime wxSQLite3ResultSet::GetNumericDateTime(int columnIndex) const
 {
+  WXSQLITE3_PROFILE();
   if (GetColumnType(columnIndex) == SQLITE_NULL)
   {
     return wxInvalidDateTime;
@@ -930,12 +1648,14 @@ wxDateTime wxSQLite3ResultSet::GetNumericDateTime(int columnIndex) const
 
 wxDateTime wxSQLite3ResultSet::GetNumericDateTime(const wxString& columnName) const
 {
+  WXSQLITE3_PROFILE();
   int columnIndex = FindColumnIndex(columnName);
   return GetNumericDateTime(columnIndex);
 }
 
 wxDateTime wxSQLite3ResultSet::GetUnixDateTime(int columnIndex) const
 {
+  WXSQLITE3_PROFILE();
   if (GetColumnType(columnIndex) == SQLITE_NULL)
   {
     return wxInvalidDateTime;
@@ -949,12 +1669,14 @@ wxDateTime wxSQLite3ResultSet::GetUnixDateTime(int columnIndex) const
 
 wxDateTime wxSQLite3ResultSet::GetUnixDateTime(const wxString& columnName) const
 {
+  WXSQLITE3_PROFILE();
   int columnIndex = FindColumnIndex(columnName);
   return GetUnixDateTime(columnIndex);
 }
 
 wxDateTime wxSQLite3ResultSet::GetJulianDayNumber(int columnIndex) const
 {
+  WXSQLITE3_PROFILE();
   if (GetColumnType(columnIndex) == SQLITE_NULL)
   {
     return wxInvalidDateTime;
@@ -968,17 +1690,20 @@ wxDateTime wxSQLite3ResultSet::GetJulianDayNumber(int columnIndex) const
 
 wxDateTime wxSQLite3ResultSet::GetJulianDayNumber(const wxString& columnName) const
 {
+  WXSQLITE3_PROFILE();
   int columnIndex = FindColumnIndex(columnName);
   return GetJulianDayNumber(columnIndex);
 }
 
 bool wxSQLite3ResultSet::GetBool(int columnIndex) const
 {
+  WXSQLITE3_PROFILE();
   return GetInt(columnIndex) != 0;
 }
 
 wxDateTime wxSQLite3ResultSet::GetAutomaticDateTime(int columnIndex, bool milliSeconds) const
 {
+  WXSQLITE3_PROFILE();
   wxDateTime result;
   int columnType = GetColumnType(columnIndex);
   switch (columnType)
@@ -1011,41 +1736,50 @@ wxDateTime wxSQLite3ResultSet::GetAutomaticDateTime(int columnIndex, bool milliS
 
 wxDateTime wxSQLite3ResultSet::GetAutomaticDateTime(const wxString& columnName, bool milliSeconds) const
 {
+  WXSQLITE3_PROFILE();
   int columnIndex = FindColumnIndex(columnName);
   return GetAutomaticDateTime(columnIndex, milliSeconds);
 }
 
 bool wxSQLite3ResultSet::GetBool(const wxString& columnName) const
 {
+  WXSQLITE3_PROFILE();
   int columnIndex = FindColumnIndex(columnName);
   return GetBool(columnIndex);
 }
 
 bool wxSQLite3ResultSet::IsNull(int columnIndex) const
 {
+  WXSQLITE3_PROFILE();
   return (GetColumnType(columnIndex) == SQLITE_NULL);
 }
 
 bool wxSQLite3ResultSet::IsNull(const wxString& columnName) const
 {
+  WXSQLITE3_PROFILE();
   int columnIndex = FindColumnIndex(columnName);
   return (GetColumnType(columnIndex) == SQLITE_NULL);
 }
 
 int wxSQLite3ResultSet::FindColumnIndex(const wxString& columnName) const
 {
-  CheckStmt();
-
+  WXSQLITE3_PROFILE();
   wxCharBuffer strColumnName = columnName.ToUTF8();
   const char* localColumnName = strColumnName;
+  return FindColumnIndexUtf8(localColumnName, strlen(localColumnName));
+}
+
+int wxSQLite3ResultSet::FindColumnIndexUtf8(const char* columnName, size_t length) const
+{
+  CheckStmt();
 
-  if (columnName.Len() > 0)
+  if (length > 0)
   {
     for (int columnIndex = 0; columnIndex < m_cols; columnIndex++)
     {
       const char* temp = sqlite3_column_name(m_stmt->m_stmt, columnIndex);
 
-      if (strcmp(localColumnName, temp) == 0)
+      if (temp != NULL && strlen(temp) == length && memcmp(columnName, temp, length) == 0)
       {
         return columnIndex;
       }
@@ -1057,6 +1791,7 @@ int wxSQLite3ResultSet::FindColumnIndex(const wxString& columnName) const
 
 wxString wxSQLite3ResultSet::GetColumnName(int columnIndex) const
 {
+  WXSQLITE3_PROFILE();
   CheckStmt();
 
   if (columnIndex < 0 || columnIndex > m_cols-1)
@@ -1070,6 +1805,7 @@ wxString wxSQLite3ResultSet::GetColumnName(int columnIndex) const
 
 wxString wxSQLite3ResultSet::GetDeclaredColumnType(int columnIndex) const
 {
+  WXSQLITE3_PROFILE();
   CheckStmt();
 
   if (columnIndex < 0 || columnIndex > m_cols-1)
@@ -1083,6 +1819,7 @@ wxString wxSQLite3ResultSet::GetDeclaredColumnType(int columnIndex) const
 
 int wxSQLite3ResultSet::GetColumnType(int columnIndex) const
 {
+  WXSQLITE3_PROFILE();
   CheckStmt();
 
   if (columnIndex < 0 || columnIndex > m_cols-1)
@@ -1095,18 +1832,21 @@ int wxSQLite3ResultSet::GetColumnType(int columnIndex) const
 
 bool wxSQLite3ResultSet::Eof() const
 {
+  WXSQLITE3_PROFILE();
   CheckStmt();
   return m_eof;
 }
 
 bool wxSQLite3ResultSet::CursorMoved() const
 {
+  WXSQLITE3_PROFILE();
   CheckStmt();
   return !m_first;
 }
 
 bool wxSQLite3ResultSet::NextRow()
 {
+  WXSQLITE3_PROFILE();
   CheckStmt();
 
   int rc;
@@ -1117,7 +1857,7 @@ bool wxSQLite3ResultSet::NextRow()
   }
   else
   {
-    rc = sqlite3_step(m_stmt->m_stmt);
+    rc = wxSQLite3StepStatement(m_db, m_stmt->m_stmt);
   }
 
   if (rc == SQLITE_DONE) // no more rows
@@ -1140,6 +1880,7 @@ bool wxSQLite3ResultSet::NextRow()
 
 void wxSQLite3ResultSet::Finalize()
 {
+  WXSQLITE3_PROFILE();
   Finalize(m_db, m_stmt);
   if (m_stmt != NULL && m_stmt->DecrementRefCount() == 0)
   {
@@ -1159,6 +1900,7 @@ void wxSQLite3ResultSet::Finalize()
 
 void wxSQLite3ResultSet::Finalize(wxSQLite3DatabaseReference* db,wxSQLite3StatementReference* stmt)
 {
+  WXSQLITE3_PROFILE();
   if (stmt != NULL && stmt->m_isValid)
   {
     int rc = sqlite3_finalize(stmt->m_stmt);
@@ -1180,6 +1922,7 @@ void wxSQLite3ResultSet::Finalize(wxSQLite3DatabaseReference* db,wxSQLite3Statem
 
 wxString wxSQLite3ResultSet::GetSQL() const
 {
+  WXSQLITE3_PROFILE();
   wxString sqlString = wxEmptyString;
 #if SQLITE_VERSION_NUMBER >= 3005003
   CheckStmt();
@@ -1191,6 +1934,7 @@ wxString wxSQLite3ResultSet::GetSQL() const
 
 wxString wxSQLite3ResultSet::GetExpandedSQL() const
 {
+  WXSQLITE3_PROFILE();
   wxString sqlString = wxEmptyString;
 #if SQLITE_VERSION_NUMBER >= 3014000
   CheckStmt();
@@ -1211,6 +1955,7 @@ bool wxSQLite3ResultSet::IsOk() const
 
 void wxSQLite3ResultSet::CheckStmt() const
 {
+  WXSQLITE3_PROFILE();
   if (m_stmt == NULL || m_stmt->m_stmt == NULL || !m_stmt->m_isValid)
   {
     throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOSTMT);
@@ -1219,6 +1964,7 @@ void wxSQLite3ResultSet::CheckStmt() const
 
 wxString wxSQLite3ResultSet::GetDatabaseName(int columnIndex) const
 {
+  WXSQLITE3_PROFILE();
 #if SQLITE_ENABLE_COLUMN_METADATA
   CheckStmt();
   if (columnIndex < 0 || columnIndex > m_cols-1)
@@ -1239,6 +1985,7 @@ wxString wxSQLite3ResultSet::GetDatabaseName(int columnIndex) const
 
 wxString wxSQLite3ResultSet::GetTableName(int columnIndex) const
 {
+  WXSQLITE3_PROFILE();
 #if SQLITE_ENABLE_COLUMN_METADATA
   CheckStmt();
   if (columnIndex < 0 || columnIndex > m_cols-1)
@@ -1259,6 +2006,7 @@ wxString wxSQLite3ResultSet::GetTableName(int columnIndex) const
 
 wxString wxSQLite3ResultSet::GetOriginName(int columnIndex) const
 {
+  WXSQLITE3_PROFILE();
 #if SQLITE_ENABLE_COLUMN_METADATA
   CheckStmt();
   if (columnIndex < 0 || columnIndex > m_cols-1)
@@ -1341,6 +2089,7 @@ wxSQLite3Table& wxSQLite3Table::operator=(const wxSQLite3Table& table)
 
 void wxSQLite3Table::Finalize()
 {
+  WXSQLITE3_PROFILE();
   if (m_results)
   {
     sqlite3_free_table(m_results);
@@ -1350,28 +2099,37 @@ void wxSQLite3Table::Finalize()
 
 int wxSQLite3Table::GetColumnCount() const
 {
+  WXSQLITE3_PROFILE();
   CheckResults();
   return m_cols;
 }
 
 int wxSQLite3Table::GetRowCount() const
 {
+  WXSQLITE3_PROFILE();
   CheckResults();
   return m_rows;
 }
 
 int wxSQLite3Table::FindColumnIndex(const wxString& columnName) const
 {
-  CheckResults();
-
+  WXSQLITE3_PROFILE();
   wxCharBuffer strColumnName = columnName.ToUTF8();
   const char* localColumnName = strColumnName;
+  return FindColumnIndexUtf8(localColumnName, strlen(localColumnName));
+}
+
+int wxSQLite3Table::FindColumnIndexUtf8(const char* columnName, size_t length) const
+{
+  CheckResults();
 
-  if (columnName.Len() > 0)
+  if (length > 0)
   {
     for (int columnIndex = 0; columnIndex < m_cols; columnIndex++)
     {
-      if (strcmp(localColumnName, m_results[columnIndex]) == 0)
+      const char* temp = m_results[columnIndex];
+
+      if (temp != NULL && strlen(temp) == length && memcmp(columnName, temp, length) == 0)
       {
         return columnIndex;
       }
@@ -1383,6 +2141,7 @@ int wxSQLite3Table::FindColumnIndex(const wxString& columnName) const
 
 wxString wxSQLite3Table::GetAsString(int columnIndex) const
 {
+  WXSQLITE3_PROFILE();
   if (columnIndex < 0 || columnIndex > m_cols-1)
   {
     throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_INVALID_INDEX);
@@ -1395,12 +2154,14 @@ wxString wxSQLite3Table::GetAsString(int columnIndex) const
 
 wxString wxSQLite3Table::GetAsString(const wxString& columnName) const
 {
+  WXSQLITE3_PROFILE();
   int index = FindColumnIndex(columnName);
   return GetAsString(index);
 }
 
 int wxSQLite3Table::GetInt(int columnIndex, int nullValue /* = 0 */) const
 {
+  WXSQLITE3_PROFILE();
   if (IsNull(columnIndex))
   {
     return nullValue;
@@ -1415,6 +2176,7 @@ int wxSQLite3Table::GetInt(int columnIndex, int nullValue /* = 0 */) const
 
 int wxSQLite3Table::GetInt(const wxString& columnName, int nullValue /* = 0 */) const
 {
+  WXSQLITE3_PROFILE();
   if (IsNull(columnName))
   {
     return nullValue;
@@ -1429,6 +2191,7 @@ int wxSQLite3Table::GetInt(const wxString& columnName, int nullValue /* = 0 */)
 
 wxLongLong wxSQLite3Table::GetInt64(int columnIndex, wxLongLong nullValue /* = 0 */) const
 {
+  WXSQLITE3_PROFILE();
   if (IsNull(columnIndex))
   {
     return nullValue;
@@ -1441,6 +2204,7 @@ wxLongLong wxSQLite3Table::GetInt64(int columnIndex, wxLongLong nullValue /* = 0
 
 wxLongLong wxSQLite3Table::GetInt64(const wxString& columnName, wxLongLong nullValue /* = 0 */) const
 {
+  WXSQLITE3_PROFILE();
   if (IsNull(columnName))
   {
     return nullValue;
@@ -1546,6 +2310,7 @@ static double wxSQLite3AtoF(const char *z)
 
 double wxSQLite3Table::GetDouble(int columnIndex, double nullValue /* = 0.0 */) const
 {
+  WXSQLITE3_PROFILE();
   if (IsNull(columnIndex))
   {
     return nullValue;
@@ -1563,12 +2328,14 @@ double wxSQLite3Table::GetDouble(int columnIndex, double nullValue /* = 0.0 */)
 
 double wxSQLite3Table::GetDouble(const wxString& columnName, double nullValue /* = 0.0 */) const
 {
+  WXSQLITE3_PROFILE();
   int index = FindColumnIndex(columnName);
   return GetDouble(index, nullValue);
 }
 
 wxString wxSQLite3Table::GetString(int columnIndex, const wxString& nullValue /* = wxEmptyString */) const
 {
+  WXSQLITE3_PROFILE();
   if (IsNull(columnIndex))
   {
     return nullValue;
@@ -1581,6 +2348,7 @@ wxString wxSQLite3Table::GetString(int columnIndex, const wxString& nullValue /*
 
 wxString wxSQLite3Table::GetString(const wxString& columnName, const wxString& nullValue /* = wxEmptyString */) const
 {
+  WXSQLITE3_PROFILE();
   if (IsNull(columnName))
   {
     return nullValue;
@@ -1593,6 +2361,7 @@ wxString wxSQLite3Table::GetString(const wxString& columnName, const wxString& n
 
 wxDateTime wxSQLite3Table::GetDate(int columnIndex) const
 {
+  WXSQLITE3_PROFILE();
   wxDateTime date;
   const wxChar* result = date.ParseDate(GetString(columnIndex));
   if (result != NULL)
@@ -1607,12 +2376,14 @@ wxDateTime wxSQLite3Table::GetDate(int columnIndex) const
 
 wxDateTime wxSQLite3Table::GetDate(const wxString& columnName) const
 {
+  WXSQLITE3_PROFILE();
   int columnIndex = FindColumnIndex(columnName);
   return GetDate(columnIndex);
 }
 
 wxDateTime wxSQLite3Table::GetTime(int columnIndex) const
 {
+  WXSQLITE3_PROFILE();
   wxDateTime date;
   const wxChar* result = date.ParseTime(GetString(columnIndex));
   if (result != NULL)
@@ -1627,12 +2398,14 @@ wxDateTime wxSQLite3Table::GetTime(int columnIndex) const
 
 wxDateTime wxSQLite3Table::GetTime(const wxString& columnName) const
 {
+  WXSQLITE3_PROFILE();
   int columnIndex = FindColumnIndex(columnName);
   return GetTime(columnIndex);
 }
 
 wxDateTime wxSQLite3Table::GetDateTime(int columnIndex) const
 {
+  WXSQLITE3_PROFILE();
   wxDateTime date;
   const wxChar* result = date.ParseDateTime(GetString(columnIndex));
   if (result != NULL)
@@ -1647,23 +2420,27 @@ wxDateTime wxSQLite3Table::GetDateTime(int columnIndex) const
 
 wxDateTime wxSQLite3Table::GetDateTime(const wxString& columnName) const
 {
+  WXSQLITE3_PROFILE();
   int columnIndex = FindColumnIndex(columnName);
   return GetDateTime(columnIndex);
 }
 
 bool wxSQLite3Table::GetBool(int columnIndex) const
 {
+  WXSQLITE3_PROFILE();
   return GetInt(columnIndex) != 0;
 }
 
 bool wxSQLite3Table::GetBool(const wxString& columnName) const
 {
+  WXSQLITE3_PROFILE();
   int columnIndex = FindColumnIndex(columnName);
   return GetBool(columnIndex);
 }
 
 bool wxSQLite3Table::IsNull(int columnIndex) const
 {
+  WXSQLITE3_PROFILE();
   CheckResults();
 
   if (columnIndex < 0 || columnIndex > m_cols-1)
@@ -1678,12 +2455,14 @@ bool wxSQLite3Table::IsNull(int columnIndex) const
 
 bool wxSQLite3Table::IsNull(const wxString& columnName) const
 {
+  WXSQLITE3_PROFILE();
   int index = FindColumnIndex(columnName);
   return IsNull(index);
 }
 
 wxString wxSQLite3Table::GetColumnName(int columnIndex) const
 {
+  WXSQLITE3_PROFILE();
   CheckResults();
 
   if (columnIndex < 0 || columnIndex > m_cols-1)
@@ -1697,6 +2476,7 @@ wxString wxSQLite3Table::GetColumnName(int columnIndex) const
 
 void wxSQLite3Table::SetRow(int row)
 {
+  WXSQLITE3_PROFILE();
   CheckResults();
 
   if (row < 0 || row > m_rows-1)
@@ -1714,6 +2494,7 @@ bool wxSQLite3Table::IsOk() const
 
 void wxSQLite3Table::CheckResults() const
 {
+  WXSQLITE3_PROFILE();
   if (m_results == 0)
   {
     throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NORESULT);
@@ -1721,19 +2502,394 @@ void wxSQLite3Table::CheckResults() const
 }
 
 // ----------------------------------------------------------------------------
-// wxSQLite3Statement: class holding a prepared statement
+// wxSQLite3QueryPlan: query plan of a prepared statement with runtime statistics
 // ----------------------------------------------------------------------------
 
-wxSQLite3Statement::wxSQLite3Statement()
+wxSQLite3QueryPlanNode::wxSQLite3QueryPlanNode()
+  : m_id(0), m_parentId(0), m_depth(0), m_loops(-1), m_visits(-1), m_estimatedRows(0), m_cycles(0)
 {
-  m_db = 0;
-  m_stmt = 0;
 }
 
-wxSQLite3Statement::wxSQLite3Statement(const wxSQLite3Statement& statement)
+bool wxSQLite3QueryPlanNode::IsFullScan() const
 {
-  m_db = statement.m_db;
-  if (m_db != NULL)
+  return m_detail.StartsWith(wxS("SCAN ")) &&
+         !m_detail.StartsWith(wxS("SCAN CONSTANT ROW")) &&
+         m_detail.Find(wxS(" VIRTUAL TABLE ")) == wxNOT_FOUND;
+}
+
+double wxSQLite3QueryPlanNode::GetEstimateRatio() const
+{
+  if (m_loops <= 0)
+  {
+    return 1.0;
+  }
+  // Estimates below one row are treated as one row to avoid meaningless huge ratios
+  double actual = GetActualRows();
+  double estimated = m_estimatedRows;
+  if (actual < 1.0) actual = 1.0;
+  if (estimated < 1.0) estimated = 1.0;
+  return (actual > estimated) ? actual / estimated : estimated / actual;
+}
+
+wxSQLite3QueryPlan::wxSQLite3QueryPlan()
+  : m_nodes(NULL), m_count(0), m_cycles(0)
+{
+}
+
+wxSQLite3QueryPlan::wxSQLite3QueryPlan(const wxSQLite3QueryPlan& plan)
+  : m_nodes(NULL), m_count(0), m_cycles(plan.m_cycles)
+{
+  if (plan.m_count > 0)
+  {
+    m_nodes = new wxSQLite3QueryPlanNode[plan.m_count];
+    m_count = plan.m_count;
+    size_t j;
+    for (j = 0; j < m_count; ++j)
+    {
+      m_nodes[j] = plan.m_nodes[j];
+    }
+  }
+}
+
+wxSQLite3QueryPlan& wxSQLite3QueryPlan::operator=(const wxSQLite3QueryPlan& plan)
+{
+  if (&plan != this)
+  {
+    wxSQLite3QueryPlan copy(plan);
+    wxSQLite3QueryPlanNode* nodes = m_nodes;
+    m_nodes = copy.m_nodes;
+    m_count = copy.m_count;
+    m_cycles = copy.m_cycles;
+    copy.m_nodes = nodes;
+  }
+  return *this;
+}
+
+wxSQLite3QueryPlan::~wxSQLite3QueryPlan()
+{
+  delete [] m_nodes;
+}
+
+bool wxSQLite3QueryPlan::HasFullScan() const
+{
+  size_t j;
+  for (j = 0; j < m_count; ++j)
+  {
+    if (m_nodes[j].IsFullScan())
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Check whether an element is a child of the given parent (-1 denotes the top level)
+static bool wxSQLite3IsPlanChild(const wxSQLite3QueryPlan& plan, size_t index, int parent)
+{
+  const wxSQLite3QueryPlanNode& node = plan[index];
+  if (parent >= 0)
+  {
+    return node.GetParentId() == parent && node.GetId() != parent;
+  }
+  size_t j;
+  for (j = 0; j < plan.GetCount(); ++j)
+  {
+    if (j != index && plan[j].GetId() == node.GetParentId())
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void wxSQLite3AppendPlanText(sqlite3_str* out, const wxSQLite3QueryPlan& plan, int parent,
+                                    const char* prefix, double misestimateFactor, size_t level)
+{
+  size_t count = plan.GetCount();
+  if (level > count)
+  {
+    return;
+  }
+  size_t j;
+  for (j = 0; j < count; ++j)
+  {
+    if (!wxSQLite3IsPlanChild(plan, j, parent))
+    {
+      continue;
+    }
+    size_t next = j + 1;
+    while (next < count && !wxSQLite3IsPlanChild(plan, next, parent))
+    {
+      ++next;
+    }
+    bool isLast = (next >= count);
+    const wxSQLite3QueryPlanNode& node = plan[j];
+    wxCharBuffer detail = node.GetDetail().IsEmpty() ? node.GetName().ToUTF8() : node.GetDetail().ToUTF8();
+    sqlite3_str_appendf(out, "%s%s%s", prefix, (isLast) ? "`--" : "|--", (const char*) detail);
+    if (node.IsLoop())
+    {
+      sqlite3_str_appendf(out, " (loops=%lld visits=%lld est=%.4g actual=%.4g",
+                          (sqlite3_int64) node.GetLoopCount(), (sqlite3_int64) node.GetVisitCount(),
+                          node.GetEstimatedRows(), node.GetActualRows());
+      if (node.GetCycleCount() > 0)
+      {
+        sqlite3_str_appendf(out, " cycles=%lld", (sqlite3_int64) node.GetCycleCount());
+      }
+      sqlite3_str_appendall(out, ")");
+      if (node.IsFullScan())
+      {
+        sqlite3_str_appendall(out, " [full scan]");
+      }
+      if (node.GetLoopCount() > 0 && node.GetEstimateRatio() >= misestimateFactor)
+      {
+        sqlite3_str_appendf(out, " [misestimate x%.1f]", node.GetEstimateRatio());
+      }
+    }
+    else if (node.GetCycleCount() > 0)
+    {
+      sqlite3_str_appendf(out, " (cycles=%lld)", (sqlite3_int64) node.GetCycleCount());
+    }
+    sqlite3_str_appendall(out, "\n");
+    char* childPrefix = sqlite3_mprintf("%s%s", prefix, (isLast) ? "   " : "|  ");
+    if (childPrefix != NULL)
+    {
+      wxSQLite3AppendPlanText(out, plan, node.GetId(), childPrefix, misestimateFactor, level + 1);
+      sqlite3_free(childPrefix);
+    }
+  }
+}
+
+static void wxSQLite3AppendJSONString(sqlite3_str* out, const char* value)
+{
+  const unsigned char* text = (const unsigned char*) value;
+  sqlite3_str_appendchar(out, 1, '"');
+  for (; *text != 0; ++text)
+  {
+    if (*text == '"' || *text == '\\')
+    {
+      sqlite3_str_appendf(out, "\\%c", *text);
+    }
+    else if (*text < 0x20)
+    {
+      sqlite3_str_appendf(out, "\\u%04x", *text);
+    }
+    else
+    {
+      sqlite3_str_appendchar(out, 1, (char) *text);
+    }
+  }
+  sqlite3_str_appendchar(out, 1, '"');
+}
+
+static void wxSQLite3AppendJSONString(sqlite3_str* out, const wxString& value)
+{
+  wxCharBuffer strValue = value.ToUTF8();
+  wxSQLite3AppendJSONString(out, (const char*) strValue);
+}
+
+static void wxSQLite3AppendPlanJSON(sqlite3_str* out, const wxSQLite3QueryPlan& plan, int parent, size_t level)
+{
+  size_t count = plan.GetCount();
+  sqlite3_str_appendchar(out, 1, '[');
+  if (level <= count)
+  {
+    bool first = true;
+    size_t j;
+    for (j = 0; j < count; ++j)
+    {
+      if (!wxSQLite3IsPlanChild(plan, j, parent))
+      {
+        continue;
+      }
+      const wxSQLite3QueryPlanNode& node = plan[j];
+      sqlite3_str_appendf(out, "%s{\"id\":%d,\"detail\":", (first) ? "" : ",", node.GetId());
+      wxSQLite3AppendJSONString(out, node.GetDetail());
+      sqlite3_str_appendall(out, ",\"name\":");
+      if (node.GetName().IsEmpty())
+      {
+        sqlite3_str_appendall(out, "null");
+      }
+      else
+      {
+        wxSQLite3AppendJSONString(out, node.GetName());
+      }
+      if (node.IsLoop())
+      {
+        sqlite3_str_appendf(out, ",\"loops\":%lld,\"visits\":%lld,\"estimatedRows\":%.6g,\"actualRows\":%.6g",
+                            (sqlite3_int64) node.GetLoopCount(), (sqlite3_int64) node.GetVisitCount(),
+                            node.GetEstimatedRows(), node.GetActualRows());
+      }
+      else
+      {
+        sqlite3_str_appendall(out, ",\"loops\":null,\"visits\":null,\"estimatedRows\":null,\"actualRows\":null");
+      }
+      sqlite3_str_appendf(out, ",\"cycles\":%lld,\"fullScan\":%s,\"children\":",
+                          (sqlite3_int64) node.GetCycleCount(), (node.IsFullScan()) ? "true" : "false");
+      wxSQLite3AppendPlanJSON(out, plan, node.GetId(), level + 1);
+      sqlite3_str_appendchar(out, 1, '}');
+      first = false;
+    }
+  }
+  sqlite3_str_appendchar(out, 1, ']');
+}
+
+// Convert the content of a dynamic string to a wxString and release it
+static wxString wxSQLite3FinishString(sqlite3_str* out)
+{
+  int rc = sqlite3_str_errcode(out);
+  char* text = sqlite3_str_finish(out);
+  if (rc != SQLITE_OK)
+  {
+    sqlite3_free(text);
+    throw wxSQLite3Exception(rc, wxERRMSG_NOMEM);
+  }
+  wxString result = (text != NULL) ? wxString::FromUTF8(text) : wxString();
+  sqlite3_free(text);
+  return result;
+}
+
+wxString wxSQLite3QueryPlan::ToText(double misestimateFactor) const
+{
+  sqlite3_str* out = sqlite3_str_new(NULL);
+  sqlite3_str_appendall(out, "QUERY PLAN");
+  if (m_cycles > 0)
+  {
+    sqlite3_str_appendf(out, " (cycles=%lld)", (sqlite3_int64) m_cycles);
+  }
+  sqlite3_str_appendall(out, "\n");
+  wxSQLite3AppendPlanText(out, *this, -1, "", misestimateFactor, 0);
+  return wxSQLite3FinishString(out);
+}
+
+wxString wxSQLite3QueryPlan::ToJSON() const
+{
+  sqlite3_str* out = sqlite3_str_new(NULL);
+  sqlite3_str_appendf(out, "{\"cycles\":%lld,\"plan\":", (sqlite3_int64) m_cycles);
+  wxSQLite3AppendPlanJSON(out, *this, -1, 0);
+  sqlite3_str_appendchar(out, 1, '}');
+  return wxSQLite3FinishString(out);
+}
+
+// Determine the query plan fingerprint of a SQL statement
+static int wxSQLite3ExplainQueryPlan(sqlite3* db, const char* sql, wxString& plan)
+{
+  char* explainSql = sqlite3_mprintf("EXPLAIN QUERY PLAN %s", sql);
+  if (explainSql == NULL)
+  {
+    return SQLITE_NOMEM;
+  }
+  sqlite3_stmt* stmt = NULL;
+  int rc = sqlite3_prepare_v2(db, explainSql, -1, &stmt, NULL);
+  sqlite3_free(explainSql);
+  if (rc != SQLITE_OK)
+  {
+    return rc;
+  }
+
+  // Parent elements always precede their children
+  sqlite3_str* out = sqlite3_str_new(db);
+  int* ids = NULL;
+  int* depths = NULL;
+  int count = 0;
+  int alloc = 0;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+  {
+    int id = sqlite3_column_int(stmt, 0);
+    int parentId = sqlite3_column_int(stmt, 1);
+    const char* detail = (const char*) sqlite3_column_text(stmt, 3);
+    int depth = 0;
+    int j;
+    for (j = count; j > 0; --j)
+    {
+      if (ids[j - 1] == parentId)
+      {
+        depth = depths[j - 1] + 1;
+        break;
+      }
+    }
+    if (count == alloc)
+    {
+      int newAlloc = (alloc > 0) ? 2 * alloc : 16;
+      int* newIds = (int*) sqlite3_realloc64(ids, newAlloc * sizeof(int));
+      if (newIds != NULL) ids = newIds;
+      int* newDepths = (int*) sqlite3_realloc64(depths, newAlloc * sizeof(int));
+      if (newDepths != NULL) depths = newDepths;
+      if (newIds == NULL || newDepths == NULL)
+      {
+        rc = SQLITE_NOMEM;
+        break;
+      }
+      alloc = newAlloc;
+    }
+    ids[count] = id;
+    depths[count] = depth;
+    ++count;
+    if (count > 1)
+    {
+      sqlite3_str_appendchar(out, 1, '\n');
+    }
+    sqlite3_str_appendchar(out, 2 * depth, ' ');
+    sqlite3_str_appendall(out, (detail != NULL) ? detail : "");
+  }
+  sqlite3_free(ids);
+  sqlite3_free(depths);
+  sqlite3_finalize(stmt);
+  if (rc == SQLITE_DONE)
+  {
+    rc = sqlite3_str_errcode(out);
+  }
+  char* text = sqlite3_str_finish(out);
+  if (rc == SQLITE_DONE || rc == SQLITE_OK)
+  {
+    plan = (text != NULL) ? wxString::FromUTF8(text) : wxString();
+    rc = SQLITE_OK;
+  }
+  sqlite3_free(text);
+  return rc;
+}
+
+// Normalize a query plan fingerprint for comparison
+static wxString wxSQLite3NormalizeQueryPlan(const wxString& plan)
+{
+  wxCharBuffer strPlan = plan.ToUTF8();
+  const char* text = strPlan;
+  sqlite3_str* out = sqlite3_str_new(NULL);
+  while (*text != 0)
+  {
+    const char* end = strchr(text, '\n');
+    size_t len = (end != NULL) ? (size_t) (end - text) : strlen(text);
+    size_t trimmed = len;
+    while (trimmed > 0 && (text[trimmed - 1] == ' ' || text[trimmed - 1] == '\t' || text[trimmed - 1] == '\r'))
+    {
+      --trimmed;
+    }
+    if (trimmed > 0)
+    {
+      if (sqlite3_str_length(out) > 0)
+      {
+        sqlite3_str_appendchar(out, 1, '\n');
+      }
+      sqlite3_str_append(out, text, (int) trimmed);
+    }
+    text += (end != NULL) ? len + 1 : len;
+  }
+  return wxSQLite3FinishString(out);
+}
+
+// ----------------------------------------------------------------------------
+// wxSQLite3Statement: class holding a prepared statement
+// ----------------------------------------------------------------------------
+
+wxSQLite3Statement::wxSQLite3Statement()
+{
+  m_db = 0;
+  m_stmt = 0;
+}
+
+wxSQLite3Statement::wxSQLite3Statement(const wxSQLite3Statement& statement)
+{
+  m_db = statement.m_db;
+  if (m_db != NULL)
   {
     m_db->IncrementRefCount();
   }
@@ -1815,12 +2971,17 @@ wxSQLite3Statement& wxSQLite3Statement::operator=(const wxSQLite3Statement& stat
 
 int wxSQLite3Statement::ExecuteUpdate()
 {
+  WXSQLITE3_PROFILE();
   CheckDatabase();
   CheckStmt();
 
   const char* localError=0;
 
-  int rc = sqlite3_step(m_stmt->m_stmt);
+  int rc = wxSQLite3StepStatement(m_db, m_stmt->m_stmt);
+  if (m_stmt->m_capturePlan && (rc == SQLITE_ROW || rc == SQLITE_DONE))
+  {
+    CheckQueryPlan();
+  }
 
   if (rc == SQLITE_DONE)
   {
@@ -1846,10 +3007,15 @@ int wxSQLite3Statement::ExecuteUpdate()
 
 wxSQLite3ResultSet wxSQLite3Statement::ExecuteQuery()
 {
+  WXSQLITE3_PROFILE();
   CheckDatabase();
   CheckStmt();
 
-  int rc = sqlite3_step(m_stmt->m_stmt);
+  int rc = wxSQLite3StepStatement(m_db, m_stmt->m_stmt);
+  if (m_stmt->m_capturePlan && (rc == SQLITE_ROW || rc == SQLITE_DONE))
+  {
+    CheckQueryPlan();
+  }
 
   if (rc == SQLITE_DONE)  // no more rows
   {
@@ -1869,6 +3035,7 @@ wxSQLite3ResultSet wxSQLite3Statement::ExecuteQuery()
 
 int wxSQLite3Statement::ExecuteScalar()
 {
+  WXSQLITE3_PROFILE();
   wxSQLite3ResultSet resultSet = ExecuteQuery();
 
   if (resultSet.Eof() || resultSet.GetColumnCount() < 1)
@@ -1883,22 +3050,30 @@ int wxSQLite3Statement::ExecuteScalar()
 
 int wxSQLite3Statement::GetParamCount() const
 {
+  WXSQLITE3_PROFILE();
   CheckStmt();
   return sqlite3_bind_parameter_count(m_stmt->m_stmt);
 }
 
 int wxSQLite3Statement::GetParamIndex(const wxString& paramName) const
 {
-  CheckStmt();
-
-  wxCharBuffer strParamName = paramName.ToUTF8();
+  WXSQLITE3_PROFILE();
+  wxSQLite3Utf8Buffer strParamName = paramName.ToUTF8();
   const char* localParamName = strParamName;
 
-  return sqlite3_bind_parameter_index(m_stmt->m_stmt, localParamName);
+  return GetParamIndexUtf8(localParamName);
+}
+
+int wxSQLite3Statement::GetParamIndexUtf8(const char* paramName) const
+{
+  WXSQLITE3_PROFILE();
+  CheckStmt();
+  return sqlite3_bind_parameter_index(m_stmt->m_stmt, paramName);
 }
 
 wxString wxSQLite3Statement::GetParamName(int paramIndex) const
 {
+  WXSQLITE3_PROFILE();
   CheckStmt();
   const char* localParamName = sqlite3_bind_parameter_name(m_stmt->m_stmt, paramIndex);
   return wxString::FromUTF8(localParamName);
@@ -1906,9 +3081,10 @@ wxString wxSQLite3Statement::GetParamName(int paramIndex) const
 
 void wxSQLite3Statement::Bind(int paramIndex, const wxString& stringValue)
 {
+  WXSQLITE3_PROFILE();
   CheckStmt();
 
-  wxCharBuffer strStringValue = stringValue.ToUTF8();
+  wxSQLite3Utf8Buffer strStringValue = stringValue.ToUTF8();
   const char* localStringValue = strStringValue;
 
   int rc = sqlite3_bind_text(m_stmt->m_stmt, paramIndex, localStringValue, -1, SQLITE_TRANSIENT);
@@ -1921,6 +3097,7 @@ void wxSQLite3Statement::Bind(int paramIndex, const wxString& stringValue)
 
 void wxSQLite3Statement::Bind(int paramIndex, int intValue)
 {
+  WXSQLITE3_PROFILE();
   CheckStmt();
   int rc = sqlite3_bind_int(m_stmt->m_stmt, paramIndex, intValue);
 
@@ -1932,6 +3109,7 @@ void wxSQLite3Statement::Bind(int paramIndex, int intValue)
 
 void wxSQLite3Statement::Bind(int paramIndex, wxLongLong int64Value)
 {
+  WXSQLITE3_PROFILE();
   CheckStmt();
   int rc = sqlite3_bind_int64(m_stmt->m_stmt, paramIndex, int64Value.GetValue());
 
@@ -1943,6 +3121,7 @@ void wxSQLite3Statement::Bind(int paramIndex, wxLongLong int64Value)
 
 void wxSQLite3Statement::Bind(int paramIndex, double doubleValue)
 {
+  WXSQLITE3_PROFILE();
   CheckStmt();
   int rc = sqlite3_bind_double(m_stmt->m_stmt, paramIndex, doubleValue);
 
@@ -1954,6 +3133,7 @@ void wxSQLite3Statement::Bind(int paramIndex, double doubleValue)
 
 void wxSQLite3Statement::Bind(int paramIndex, const char* charValue)
 {
+  WXSQLITE3_PROFILE();
   CheckStmt();
   int rc = sqlite3_bind_text(m_stmt->m_stmt, paramIndex, charValue, -1, SQLITE_TRANSIENT);
 
@@ -1965,6 +3145,7 @@ void wxSQLite3Statement::Bind(int paramIndex, const char* charValue)
 
 void wxSQLite3Statement::Bind(int paramIndex, const unsigned char* blobValue, int blobLen)
 {
+  WXSQLITE3_PROFILE();
   CheckStmt();
   int rc = sqlite3_bind_blob(m_stmt->m_stmt, paramIndex,
                              (const void*)blobValue, blobLen, SQLITE_TRANSIENT);
@@ -1977,6 +3158,7 @@ void wxSQLite3Statement::Bind(int paramIndex, const unsigned char* blobValue, in
 
 void wxSQLite3Statement::Bind(int paramIndex, const wxMemoryBuffer& blobValue)
 {
+  WXSQLITE3_PROFILE();
   CheckStmt();
   int blobLen = (int) blobValue.GetDataLen();
   int rc = sqlite3_bind_blob(m_stmt->m_stmt, paramIndex,
@@ -1990,6 +3172,7 @@ void wxSQLite3Statement::Bind(int paramIndex, const wxMemoryBuffer& blobValue)
 
 void wxSQLite3Statement::Bind(int paramIndex, void* pointer, const wxString& pointerType, void(*DeletePointer)(void*))
 {
+  WXSQLITE3_PROFILE();
 #if SQLITE_VERSION_NUMBER >= 3020000
   CheckStmt();
 
@@ -2009,8 +3192,129 @@ void wxSQLite3Statement::Bind(int paramIndex, void* pointer, const wxString& poi
 #endif
 }
 
+void wxSQLite3Statement::BindArray(int paramIndex, const wxInt32* values, int count, wxSQLite3ArrayBinding binding)
+{
+  WXSQLITE3_PROFILE();
+  BindArrayOwned(paramIndex, (void*) values, count, 0, (binding == WXSQLITE_ARRAY_STATIC) ? NULL : SQLITE_TRANSIENT, NULL);
+}
+
+void wxSQLite3Statement::BindArray(int paramIndex, const wxLongLong_t* values, int count, wxSQLite3ArrayBinding binding)
+{
+  WXSQLITE3_PROFILE();
+  BindArrayOwned(paramIndex, (void*) values, count, 1, (binding == WXSQLITE_ARRAY_STATIC) ? NULL : SQLITE_TRANSIENT, NULL);
+}
+
+void wxSQLite3Statement::BindArray(int paramIndex, const double* values, int count, wxSQLite3ArrayBinding binding)
+{
+  WXSQLITE3_PROFILE();
+  BindArrayOwned(paramIndex, (void*) values, count, 2, (binding == WXSQLITE_ARRAY_STATIC) ? NULL : SQLITE_TRANSIENT, NULL);
+}
+
+void wxSQLite3Statement::BindArray(int paramIndex, const char* const* values, int count, wxSQLite3ArrayBinding binding)
+{
+  WXSQLITE3_PROFILE();
+  BindArrayOwned(paramIndex, (void*) values, count, 3, (binding == WXSQLITE_ARRAY_STATIC) ? NULL : SQLITE_TRANSIENT, NULL);
+}
+
+void wxSQLite3Statement::BindArray(int paramIndex, const wxArrayInt& values)
+{
+  WXSQLITE3_PROFILE();
+  // Copy into memory handed over to SQLite, avoiding a second copy
+  int count = (int) values.GetCount();
+  wxInt32* data = (wxInt32*) sqlite3_malloc64(sizeof(wxInt32) * (count > 0 ? count : 1));
+  if (data == NULL)
+  {
+    throw wxSQLite3Exception(SQLITE_NOMEM, wxERRMSG_NOMEM);
+  }
+  for (int j = 0; j < count; ++j)
+  {
+    data[j] = values[j];
+  }
+  BindArrayOwned(paramIndex, data, count, 0, sqlite3_free, data);
+}
+
+void wxSQLite3Statement::BindArray(int paramIndex, const wxArrayString& values)
+{
+  WXSQLITE3_PROFILE();
+  // The pointer table and the utf-8 strings share a single allocation
+  size_t count = values.GetCount();
+  size_t j;
+  size_t textSize = 0;
+  for (j = 0; j < count; ++j)
+  {
+    textSize += strlen(values[j].ToUTF8()) + 1;
+  }
+  char* data = (char*) sqlite3_malloc64(sizeof(char*) * (count > 0 ? count : 1) + textSize);
+  if (data == NULL)
+  {
+    throw wxSQLite3Exception(SQLITE_NOMEM, wxERRMSG_NOMEM);
+  }
+  char** table = (char**) data;
+  char* text = data + sizeof(char*) * (count > 0 ? count : 1);
+  for (j = 0; j < count; ++j)
+  {
+    wxSQLite3Utf8Buffer strValue = values[j].ToUTF8();
+    const char* localValue = strValue;
+    size_t len = strlen(localValue) + 1;
+    memcpy(text, localValue, len);
+    table[j] = text;
+    text += len;
+  }
+  BindArrayOwned(paramIndex, data, (int) count, 3, sqlite3_free, data);
+}
+
+void wxSQLite3Statement::BindArrayOwned(int paramIndex, void* values, int count, int arrayType, void(*DeleteArray)(void*), void* deleteArg)
+{
+  WXSQLITE3_PROFILE();
+#if WXSQLITE3_HAVE_CARRAY_BIND
+  try
+  {
+    CheckStmt();
+  }
+  catch (...)
+  {
+    if (DeleteArray != NULL && DeleteArray != SQLITE_TRANSIENT)
+    {
+      DeleteArray(deleteArg);
+    }
+    throw;
+  }
+
+  // SQLite can't copy an empty array; an empty array is used in place instead
+  static wxLongLong_t emptyArray[1] = { 0 };
+  if (count <= 0 && DeleteArray == SQLITE_TRANSIENT)
+  {
+    values = emptyArray;
+    DeleteArray = NULL;
+  }
+  else if (values == NULL)
+  {
+    values = emptyArray;
+  }
+  // The destructor is invoked even if binding fails
+  int rc = sqlite3_carray_bind_v2(m_stmt->m_stmt, paramIndex, values, (count > 0) ? count : 0, arrayType,
+                                  (DeleteArray != NULL) ? DeleteArray : SQLITE_STATIC, deleteArg);
+
+  if (rc != SQLITE_OK)
+  {
+    throw wxSQLite3Exception(rc, wxERRMSG_BIND_ARRAY);
+  }
+#else
+  wxUnusedVar(paramIndex);
+  wxUnusedVar(values);
+  wxUnusedVar(count);
+  wxUnusedVar(arrayType);
+  if (DeleteArray != NULL && DeleteArray != SQLITE_TRANSIENT)
+  {
+    DeleteArray(deleteArg);
+  }
+  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOARRAY);
+#endif
+}
+
 void wxSQLite3Statement::BindDate(int paramIndex, const wxDateTime& date)
 {
+  WXSQLITE3_PROFILE();
   if (date.IsValid())
   {
     Bind(paramIndex,date.FormatISODate());
@@ -2023,6 +3327,7 @@ void wxSQLite3Statement::BindDate(int paramIndex, const wxDateTime& date)
 
 void wxSQLite3Statement::BindTime(int paramIndex, const wxDateTime& time)
 {
+  WXSQLITE3_PROFILE();
   if (time.IsValid())
   {
     Bind(paramIndex,time.FormatISOTime());
@@ -2035,6 +3340,7 @@ void wxSQLite3Statement::BindTime(int paramIndex, const wxDateTime& time)
 
 void wxSQLite3Statement::BindDateTime(int paramIndex, const wxDateTime& datetime)
 {
+  WXSQLITE3_PROFILE();
   if (datetime.IsValid())
   {
     Bind(paramIndex,datetime.Format(wxS("%Y-%m-%d %H:%M:%S")));
@@ -2047,6 +3353,7 @@ void wxSQLite3Statement::BindDateTime(int paramIndex, const wxDateTime& datetime
 
 void wxSQLite3Statement::BindTimestamp(int paramIndex, const wxDateTime& timestamp)
 {
+  WXSQLITE3_PROFILE();
   if (timestamp.IsValid())
   {
     Bind(paramIndex,timestamp.Format(wxS("%Y-%m-%d %H:%M:%S.%l")));
@@ -2059,6 +3366,7 @@ void wxSQLite3Statement::BindTimestamp(int paramIndex, const wxDateTime& timesta
 
 void wxSQLite3Statement::BindNumericDateTime(int paramIndex, const wxDateTime& datetime)
 {
+  WXSQLITE3_PROFILE();
   if (datetime.IsValid())
   {
     Bind(paramIndex, datetime.GetValue());
@@ -2071,6 +3379,7 @@ void wxSQLite3Statement::BindNumericDateTime(int paramIndex, const wxDateTime& d
 
 void wxSQLite3Statement::BindUnixDateTime(int paramIndex, const wxDateTime& datetime)
 {
+  WXSQLITE3_PROFILE();
   if (datetime.IsValid())
   {
     wxLongLong ticks = datetime.GetTicks();
@@ -2084,6 +3393,7 @@ void wxSQLite3Statement::BindUnixDateTime(int paramIndex, const wxDateTime& date
 
 void wxSQLite3Statement::BindJulianDayNumber(int paramIndex, const wxDateTime& datetime)
 {
+  WXSQLITE3_PROFILE();
   if (datetime.IsValid())
   {
     Bind(paramIndex, datetime.GetJulianDayNumber());
@@ -2096,11 +3406,13 @@ void wxSQLite3Statement::BindJulianDayNumber(int paramIndex, const wxDateTime& d
 
 void wxSQLite3Statement::BindBool(int paramIndex, bool value)
 {
+  WXSQLITE3_PROFILE();
   Bind(paramIndex, value ? 1 : 0);
 }
 
 void wxSQLite3Statement::BindNull(int paramIndex)
 {
+  WXSQLITE3_PROFILE();
   CheckStmt();
   int rc = sqlite3_bind_null(m_stmt->m_stmt, paramIndex);
 
@@ -2112,6 +3424,7 @@ void wxSQLite3Statement::BindNull(int paramIndex)
 
 void wxSQLite3Statement::BindZeroBlob(int paramIndex, int blobSize)
 {
+  WXSQLITE3_PROFILE();
 #if SQLITE_VERSION_NUMBER >= 3004000
   CheckStmt();
   int rc = sqlite3_bind_zeroblob(m_stmt->m_stmt, paramIndex, blobSize);
@@ -2128,6 +3441,7 @@ void wxSQLite3Statement::BindZeroBlob(int paramIndex, int blobSize)
 
 void wxSQLite3Statement::ClearBindings()
 {
+  WXSQLITE3_PROFILE();
   CheckStmt();
 #if 0 // missing in SQLite DLL
   int rc = sqlite3_clear_bindings(m_stmt->m_stmt);
@@ -2146,6 +3460,7 @@ void wxSQLite3Statement::ClearBindings()
 
 wxString wxSQLite3Statement::GetSQL() const
 {
+  WXSQLITE3_PROFILE();
   wxString sqlString = wxEmptyString;
 #if SQLITE_VERSION_NUMBER >= 3005003
   CheckStmt();
@@ -2157,6 +3472,7 @@ wxString wxSQLite3Statement::GetSQL() const
 
 wxString wxSQLite3Statement::GetExpandedSQL() const
 {
+  WXSQLITE3_PROFILE();
   wxString sqlString = wxEmptyString;
 #if SQLITE_VERSION_NUMBER >= 3014000
   CheckStmt();
@@ -2172,6 +3488,7 @@ wxString wxSQLite3Statement::GetExpandedSQL() const
 
 void wxSQLite3Statement::Reset()
 {
+  WXSQLITE3_PROFILE();
   if (m_stmt != NULL && m_stmt->m_isValid)
   {
     int rc = sqlite3_reset(m_stmt->m_stmt);
@@ -2186,6 +3503,7 @@ void wxSQLite3Statement::Reset()
 
 bool wxSQLite3Statement::IsReadOnly() const
 {
+  WXSQLITE3_PROFILE();
 #if SQLITE_VERSION_NUMBER >= 3007004
   CheckStmt();
   return sqlite3_stmt_readonly(m_stmt->m_stmt) != 0;
@@ -2196,6 +3514,7 @@ bool wxSQLite3Statement::IsReadOnly() const
 
 void wxSQLite3Statement::Finalize()
 {
+  WXSQLITE3_PROFILE();
   Finalize(m_db, m_stmt);
   if (m_stmt != NULL && m_stmt->DecrementRefCount() == 0)
   {
@@ -2215,6 +3534,7 @@ void wxSQLite3Statement::Finalize()
 
 void wxSQLite3Statement::Finalize(wxSQLite3DatabaseReference* db,wxSQLite3StatementReference* stmt)
 {
+  WXSQLITE3_PROFILE();
   if (stmt != NULL && stmt->m_isValid)
   {
     int rc = sqlite3_finalize(stmt->m_stmt);
@@ -2241,6 +3561,7 @@ bool wxSQLite3Statement::IsOk() const
 
 bool wxSQLite3Statement::IsBusy() const
 {
+  WXSQLITE3_PROFILE();
 #if SQLITE_VERSION_NUMBER >= 3007010
   CheckStmt();
   int rc = sqlite3_stmt_busy(m_stmt->m_stmt);
@@ -2252,6 +3573,7 @@ bool wxSQLite3Statement::IsBusy() const
 
 int wxSQLite3Statement::Status(wxSQLite3StatementStatus opCode, bool resetFlag) const
 {
+  WXSQLITE3_PROFILE();
   int count = 0;
 #if SQLITE_VERSION_NUMBER >= 3007000
   CheckStmt();
@@ -2260,2696 +3582,12051 @@ int wxSQLite3Statement::Status(wxSQLite3StatementStatus opCode, bool resetFlag)
   return count;
 }
 
-void wxSQLite3Statement::CheckDatabase() const
+void wxSQLite3Statement::BindText(int paramIndex, const char* charValue, int charLen)
 {
-  if (m_db == NULL || m_db->m_db == NULL || !m_db->m_isValid)
+  WXSQLITE3_PROFILE();
+  CheckStmt();
+  int rc = sqlite3_bind_text(m_stmt->m_stmt, paramIndex, charValue, charLen, SQLITE_TRANSIENT);
+
+  if (rc != SQLITE_OK)
   {
-    throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NODB);
+    throw wxSQLite3Exception(rc, wxERRMSG_BIND_STR);
   }
 }
 
-void wxSQLite3Statement::CheckStmt() const
+bool wxSQLite3Statement::Step()
 {
-  if (m_stmt == NULL || m_stmt->m_stmt == NULL || !m_stmt->m_isValid)
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  CheckStmt();
+
+  int rc = wxSQLite3StepStatement(m_db, m_stmt->m_stmt);
+  if (m_stmt->m_capturePlan && (rc == SQLITE_ROW || rc == SQLITE_DONE))
   {
-    throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOSTMT);
+    CheckQueryPlan();
   }
-}
-
-//
 
-wxSQLite3Blob::wxSQLite3Blob()
-{
-  m_db   = NULL;
-  m_blob = NULL;
-  m_writable = false;
+  if (rc == SQLITE_ROW)
+  {
+    return true;
+  }
+  else if (rc == SQLITE_DONE)
+  {
+    return false;
+  }
+  else
+  {
+    rc = sqlite3_reset(m_stmt->m_stmt);
+    const char* localError = sqlite3_errmsg(m_db->m_db);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
 }
 
-wxSQLite3Blob::wxSQLite3Blob(const wxSQLite3Blob& blob)
+bool wxSQLite3Statement::TryCheckStmt(wxSQLite3Result& result, bool checkDatabase) const
 {
-  m_db   = blob.m_db;
-  if (m_db != NULL)
+  if (checkDatabase && (m_db == NULL || m_db->m_db == NULL || !m_db->m_isValid))
   {
-    m_db->IncrementRefCount();
+    result.SetError(WXSQLITE_ERROR, wxString(wxERRMSG_NODB).ToUTF8());
+    return false;
   }
-  m_blob = blob.m_blob;
-  if (m_blob != NULL)
+  if (m_stmt == NULL || m_stmt->m_stmt == NULL || !m_stmt->m_isValid)
   {
-    m_blob->IncrementRefCount();
+    result.SetError(WXSQLITE_ERROR, wxString(wxERRMSG_NOSTMT).ToUTF8());
+    return false;
   }
-  m_writable = blob.m_writable;
+  return true;
 }
 
-wxSQLite3Blob& wxSQLite3Blob::operator=(const wxSQLite3Blob& blob)
+wxSQLite3Result wxSQLite3Statement::TryBind(int paramIndex, int intValue)
 {
-  if (this != &blob)
+  WXSQLITE3_PROFILE();
+  wxSQLite3Result result;
+  if (TryCheckStmt(result, false))
   {
-    wxSQLite3DatabaseReference* dbPrev = m_db;
-    wxSQLite3BlobReference* blobPrev = m_blob;
-    m_db   = blob.m_db;
-    if (m_db != NULL)
-    {
-      m_db->IncrementRefCount();
-    }
-    m_blob = blob.m_blob;
-    if (m_blob != NULL)
+    int rc = sqlite3_bind_int(m_stmt->m_stmt, paramIndex, intValue);
+    if (rc != SQLITE_OK)
     {
-      m_blob->IncrementRefCount();
+      result.SetError(rc, sqlite3_errmsg(sqlite3_db_handle(m_stmt->m_stmt)));
     }
-    m_writable = blob.m_writable;
-    if (blobPrev != NULL && blobPrev->DecrementRefCount() == 0)
+  }
+  return result;
+}
+
+wxSQLite3Result wxSQLite3Statement::TryBind(int paramIndex, wxLongLong int64Value)
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3Result result;
+  if (TryCheckStmt(result, false))
+  {
+    int rc = sqlite3_bind_int64(m_stmt->m_stmt, paramIndex, int64Value.GetValue());
+    if (rc != SQLITE_OK)
     {
-      Finalize(dbPrev, blobPrev);
-      delete blobPrev;
+      result.SetError(rc, sqlite3_errmsg(sqlite3_db_handle(m_stmt->m_stmt)));
     }
-    if (dbPrev != NULL && dbPrev->DecrementRefCount() == 0)
+  }
+  return result;
+}
+
+wxSQLite3Result wxSQLite3Statement::TryBind(int paramIndex, double doubleValue)
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3Result result;
+  if (TryCheckStmt(result, false))
+  {
+    int rc = sqlite3_bind_double(m_stmt->m_stmt, paramIndex, doubleValue);
+    if (rc != SQLITE_OK)
     {
-      delete dbPrev;
+      result.SetError(rc, sqlite3_errmsg(sqlite3_db_handle(m_stmt->m_stmt)));
     }
   }
-  return *this;
+  return result;
 }
 
-wxSQLite3Blob::wxSQLite3Blob(wxSQLite3DatabaseReference* db, wxSQLite3BlobReference* blob, bool writable)
+wxSQLite3Result wxSQLite3Statement::TryBind(int paramIndex, const wxString& stringValue)
 {
-  m_db   = db;
-  if (m_db != NULL)
+  WXSQLITE3_PROFILE();
+  wxSQLite3Result result;
+  if (TryCheckStmt(result, false))
   {
-    m_db->IncrementRefCount();
+    wxSQLite3Utf8Buffer strStringValue = stringValue.ToUTF8();
+    const char* localStringValue = strStringValue;
+    int rc = sqlite3_bind_text(m_stmt->m_stmt, paramIndex, localStringValue, -1, SQLITE_TRANSIENT);
+    if (rc != SQLITE_OK)
+    {
+      result.SetError(rc, sqlite3_errmsg(sqlite3_db_handle(m_stmt->m_stmt)));
+    }
   }
-  m_blob = blob;
-  if (m_blob != NULL)
+  return result;
+}
+
+wxSQLite3Result wxSQLite3Statement::TryBind(int paramIndex, const char* charValue, int charLen)
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3Result result;
+  if (TryCheckStmt(result, false))
   {
-    m_blob->IncrementRefCount();
+    int rc = sqlite3_bind_text(m_stmt->m_stmt, paramIndex, charValue, charLen, SQLITE_TRANSIENT);
+    if (rc != SQLITE_OK)
+    {
+      result.SetError(rc, sqlite3_errmsg(sqlite3_db_handle(m_stmt->m_stmt)));
+    }
   }
-  m_writable = writable;
+  return result;
 }
 
-wxSQLite3Blob::~wxSQLite3Blob()
+wxSQLite3Result wxSQLite3Statement::TryBind(int paramIndex, const unsigned char* blobValue, int blobLen)
 {
-  if (m_blob != NULL && m_blob->DecrementRefCount() == 0)
+  WXSQLITE3_PROFILE();
+  wxSQLite3Result result;
+  if (TryCheckStmt(result, false))
   {
-    Finalize(m_db, m_blob);
-    delete m_blob;
+    int rc = sqlite3_bind_blob(m_stmt->m_stmt, paramIndex, (const void*) blobValue, blobLen, SQLITE_TRANSIENT);
+    if (rc != SQLITE_OK)
+    {
+      result.SetError(rc, sqlite3_errmsg(sqlite3_db_handle(m_stmt->m_stmt)));
+    }
   }
-  if (m_db != NULL && m_db->DecrementRefCount() == 0)
+  return result;
+}
+
+wxSQLite3Result wxSQLite3Statement::TryBindNull(int paramIndex)
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3Result result;
+  if (TryCheckStmt(result, false))
   {
-    if (m_db->m_isValid)
+    int rc = sqlite3_bind_null(m_stmt->m_stmt, paramIndex);
+    if (rc != SQLITE_OK)
     {
-      sqlite3_close(m_db->m_db);
+      result.SetError(rc, sqlite3_errmsg(sqlite3_db_handle(m_stmt->m_stmt)));
     }
-    delete m_db;
   }
+  return result;
 }
 
-wxMemoryBuffer& wxSQLite3Blob::Read(wxMemoryBuffer& blobValue, int length, int offset) const
+wxSQLite3Result wxSQLite3Statement::TryStep()
 {
-#if SQLITE_VERSION_NUMBER >= 3004000
-  CheckBlob();
-  char* localBuffer = (char*) blobValue.GetAppendBuf((size_t) length);
-  int rc = sqlite3_blob_read(m_blob->m_blob, localBuffer, length, offset);
+  WXSQLITE3_PROFILE();
+  wxSQLite3Result result;
+  if (!TryCheckStmt(result, true))
+  {
+    return result;
+  }
 
-  if (rc != SQLITE_OK)
+  int rc = wxSQLite3StepStatement(m_db, m_stmt->m_stmt);
+  if (m_stmt->m_capturePlan && (rc == SQLITE_ROW || rc == SQLITE_DONE))
   {
-    const char* localError = sqlite3_errmsg(m_db->m_db);
-    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+    CheckQueryPlan();
   }
 
-  blobValue.UngetAppendBuf((size_t) length);
-#else
-  wxUnusedVar(blobValue);
-  wxUnusedVar(length);
-  wxUnusedVar(offset);
-  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOINCBLOB);
-#endif
-  return blobValue;
+  if (rc == SQLITE_ROW || rc == SQLITE_DONE)
+  {
+    result.m_errorCode = rc;
+  }
+  else
+  {
+    rc = sqlite3_reset(m_stmt->m_stmt);
+    result.SetError(rc, sqlite3_errmsg(m_db->m_db));
+  }
+  return result;
 }
 
-void wxSQLite3Blob::Write(const wxMemoryBuffer& blobValue, int offset)
+wxSQLite3Result wxSQLite3Statement::TryExecuteUpdate()
 {
-#if SQLITE_VERSION_NUMBER >= 3004000
-  CheckBlob();
-  if (m_writable)
+  WXSQLITE3_PROFILE();
+  wxSQLite3Result result;
+  if (!TryCheckStmt(result, true))
   {
-    int blobLen = (int) blobValue.GetDataLen();
-    int rc = sqlite3_blob_write(m_blob->m_blob,
-                                (const void*) blobValue.GetData(), blobLen, offset);
+    return result;
+  }
 
-    if (rc != SQLITE_OK)
+  int rc = wxSQLite3StepStatement(m_db, m_stmt->m_stmt);
+  if (m_stmt->m_capturePlan && (rc == SQLITE_ROW || rc == SQLITE_DONE))
+  {
+    CheckQueryPlan();
+  }
+
+  if (rc == SQLITE_DONE)
+  {
+    result.m_changes = sqlite3_changes(m_db->m_db);
+    rc = sqlite3_reset(m_stmt->m_stmt);
+  }
+  else
+  {
+    // A statement returning rows is an error, like for ExecuteUpdate
+    rc = sqlite3_reset(m_stmt->m_stmt);
+    if (rc == SQLITE_OK)
     {
-      const char* localError = sqlite3_errmsg(m_db->m_db);
-      throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+      result.SetError(SQLITE_MISUSE, wxString(wxERRMSG_RETURNS_ROWS).ToUTF8());
+      return result;
     }
   }
-  else
+  if (rc != SQLITE_OK)
   {
-    throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_INVALID_BLOB);
+    result.SetError(rc, sqlite3_errmsg(m_db->m_db));
   }
-#else
-  wxUnusedVar(blobValue);
-  wxUnusedVar(offset);
-  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOINCBLOB);
-#endif
+  return result;
 }
 
-bool wxSQLite3Blob::IsOk() const
+wxSQLite3Result wxSQLite3Statement::TryReset()
 {
-  return (m_blob != NULL && m_blob->m_isValid);
+  WXSQLITE3_PROFILE();
+  wxSQLite3Result result;
+  if (m_stmt != NULL && m_stmt->m_isValid)
+  {
+    int rc = sqlite3_reset(m_stmt->m_stmt);
+    if (rc != SQLITE_OK)
+    {
+      result.SetError(rc, sqlite3_errmsg(sqlite3_db_handle(m_stmt->m_stmt)));
+    }
+  }
+  return result;
 }
 
-bool wxSQLite3Blob::IsReadOnly() const
+int wxSQLite3Statement::GetColumnCount() const
 {
-  return !m_writable;
+  WXSQLITE3_PROFILE();
+  CheckStmt();
+  return sqlite3_column_count(m_stmt->m_stmt);
 }
 
-int wxSQLite3Blob::GetSize() const
+int wxSQLite3Statement::GetColumnType(int columnIndex) const
 {
-#if SQLITE_VERSION_NUMBER >= 3004000
-  CheckBlob();
-  return sqlite3_blob_bytes(m_blob->m_blob);
-#else
-  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOINCBLOB);
-  return 0;
-#endif
+  WXSQLITE3_PROFILE();
+  CheckStmt();
+  return sqlite3_column_type(m_stmt->m_stmt, columnIndex);
 }
 
-void wxSQLite3Blob::Rebind(wxLongLong rowid)
+wxsqlite_int64 wxSQLite3Statement::GetColumnInt64(int columnIndex) const
 {
-#if SQLITE_VERSION_NUMBER >= 3007004
-  CheckBlob();
-  int rc = sqlite3_blob_reopen(m_blob->m_blob, rowid.GetValue());
-  if (rc != SQLITE_OK)
-  {
-    const char* localError = sqlite3_errmsg(m_db->m_db);
-    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
-  }
-#else
-  wxUnusedVar(rowid);
-  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOBLOBREBIND);
-#endif
+  WXSQLITE3_PROFILE();
+  CheckStmt();
+  return sqlite3_column_int64(m_stmt->m_stmt, columnIndex);
 }
 
-void wxSQLite3Blob::Finalize()
+double wxSQLite3Statement::GetColumnDouble(int columnIndex) const
 {
-  Finalize(m_db, m_blob);
+  WXSQLITE3_PROFILE();
+  CheckStmt();
+  return sqlite3_column_double(m_stmt->m_stmt, columnIndex);
 }
 
-void wxSQLite3Blob::Finalize(wxSQLite3DatabaseReference* db, wxSQLite3BlobReference* blob)
+const char* wxSQLite3Statement::GetColumnText(int columnIndex, int& len) const
 {
-#if SQLITE_VERSION_NUMBER >= 3004000
-  if (blob != NULL && blob->m_isValid)
+  WXSQLITE3_PROFILE();
+  CheckStmt();
+  // sqlite3_column_text must be called before sqlite3_column_bytes
+  const char* localValue = (const char*) sqlite3_column_text(m_stmt->m_stmt, columnIndex);
+  len = sqlite3_column_bytes(m_stmt->m_stmt, columnIndex);
+  return localValue;
+}
+
+const unsigned char* wxSQLite3Statement::GetColumnBlob(int columnIndex, int& len) const
+{
+  WXSQLITE3_PROFILE();
+  CheckStmt();
+  const unsigned char* localValue = (const unsigned char*) sqlite3_column_blob(m_stmt->m_stmt, columnIndex);
+  len = sqlite3_column_bytes(m_stmt->m_stmt, columnIndex);
+  return localValue;
+}
+
+void wxSQLite3Statement::CheckSignature(int paramCount, int columnCount) const
+{
+  WXSQLITE3_PROFILE();
+  CheckStmt();
+  if (sqlite3_bind_parameter_count(m_stmt->m_stmt) != paramCount)
   {
-    int rc = sqlite3_blob_close(blob->m_blob);
-    blob->Invalidate();
-    if (rc != SQLITE_OK)
+    throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_PARAM_COUNT);
+  }
+  if (sqlite3_column_count(m_stmt->m_stmt) != columnCount)
+  {
+    throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_COLUMN_COUNT);
+  }
+}
+
+wxSQLite3QueryPlan wxSQLite3Statement::GetQueryPlan() const
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3QueryPlan plan;
+#if defined(SQLITE_ENABLE_STMT_SCANSTATUS)
+  CheckStmt();
+  sqlite3_stmt* stmt = m_stmt->m_stmt;
+  int count = 0;
+  int id;
+  while (sqlite3_stmt_scanstatus_v2(stmt, count, SQLITE_SCANSTAT_SELECTID, SQLITE_SCANSTAT_COMPLEX, &id) == 0)
+  {
+    ++count;
+  }
+  if (count > 0)
+  {
+    plan.m_nodes = new wxSQLite3QueryPlanNode[count];
+    plan.m_count = count;
+    int j;
+    for (j = 0; j < count; ++j)
     {
-      if (db != NULL && db->m_isValid)
+      wxSQLite3QueryPlanNode& node = plan.m_nodes[j];
+      int parentId = 0;
+      const char* detail = NULL;
+      const char* name = NULL;
+      sqlite3_int64 loops = -1;
+      sqlite3_int64 visits = -1;
+      sqlite3_int64 cycles = 0;
+      double estimatedRows = 0;
+      sqlite3_stmt_scanstatus_v2(stmt, j, SQLITE_SCANSTAT_SELECTID, SQLITE_SCANSTAT_COMPLEX, &id);
+      sqlite3_stmt_scanstatus_v2(stmt, j, SQLITE_SCANSTAT_PARENTID, SQLITE_SCANSTAT_COMPLEX, &parentId);
+      sqlite3_stmt_scanstatus_v2(stmt, j, SQLITE_SCANSTAT_EXPLAIN, SQLITE_SCANSTAT_COMPLEX, (void*) &detail);
+      sqlite3_stmt_scanstatus_v2(stmt, j, SQLITE_SCANSTAT_NAME, SQLITE_SCANSTAT_COMPLEX, (void*) &name);
+      sqlite3_stmt_scanstatus_v2(stmt, j, SQLITE_SCANSTAT_NLOOP, SQLITE_SCANSTAT_COMPLEX, &loops);
+      sqlite3_stmt_scanstatus_v2(stmt, j, SQLITE_SCANSTAT_NVISIT, SQLITE_SCANSTAT_COMPLEX, &visits);
+      sqlite3_stmt_scanstatus_v2(stmt, j, SQLITE_SCANSTAT_EST, SQLITE_SCANSTAT_COMPLEX, &estimatedRows);
+      sqlite3_stmt_scanstatus_v2(stmt, j, SQLITE_SCANSTAT_NCYCLE, SQLITE_SCANSTAT_COMPLEX, &cycles);
+      node.m_id = id;
+      node.m_parentId = parentId;
+      node.m_detail = (detail != NULL) ? wxString::FromUTF8(detail) : wxString();
+      node.m_name = (name != NULL) ? wxString::FromUTF8(name) : wxString();
+      node.m_loops = loops;
+      node.m_visits = (loops >= 0) ? visits : -1;
+      node.m_estimatedRows = (loops >= 0) ? estimatedRows : 0;
+      node.m_cycles = (cycles > 0) ? cycles : 0;
+    }
+
+    // Bring the elements into the order of the EXPLAIN QUERY PLAN output,
+    // elements without EXPLAIN information go last
+    for (j = 1; j < count; ++j)
+    {
+      wxSQLite3QueryPlanNode node = plan.m_nodes[j];
+      unsigned int key = (unsigned int) node.m_id;
+      int k = j;
+      while (k > 0 && (unsigned int) plan.m_nodes[k - 1].m_id > key)
       {
-        const char* localError = sqlite3_errmsg(db->m_db);
-        throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+        plan.m_nodes[k] = plan.m_nodes[k - 1];
+        --k;
       }
-      else
+      plan.m_nodes[k] = node;
+    }
+
+    // Determine the nesting depth
+    for (j = 0; j < count; ++j)
+    {
+      int depth = 0;
+      int parentId = plan.m_nodes[j].m_parentId;
+      while (depth < count)
       {
-        throw wxSQLite3Exception(rc, wxERRMSG_FINALIZE_FAILED);
+        int k;
+        for (k = 0; k < count && plan.m_nodes[k].m_id != parentId; ++k) {}
+        if (k == count || k == j)
+        {
+          break;
+        }
+        ++depth;
+        parentId = plan.m_nodes[k].m_parentId;
       }
+      plan.m_nodes[j].m_depth = depth;
     }
   }
+  sqlite3_int64 totalCycles = 0;
+  sqlite3_stmt_scanstatus_v2(stmt, -1, SQLITE_SCANSTAT_NCYCLE, SQLITE_SCANSTAT_COMPLEX, &totalCycles);
+  plan.m_cycles = (totalCycles > 0) ? totalCycles : 0;
 #else
-  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOINCBLOB);
+  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOSCANSTATUS);
 #endif
+  return plan;
 }
 
-void wxSQLite3Blob::CheckBlob() const
+void wxSQLite3Statement::ResetScanStatus()
 {
-  if (m_db == NULL || !m_db->m_isValid || m_blob == NULL || !m_blob->m_isValid)
-  {
-    throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_INVALID_BLOB);
-  }
+  WXSQLITE3_PROFILE();
+#if defined(SQLITE_ENABLE_STMT_SCANSTATUS)
+  CheckStmt();
+  sqlite3_stmt_scanstatus_reset(m_stmt->m_stmt);
+#else
+  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOSCANSTATUS);
+#endif
 }
 
-// ----------------------------------------------------------------------------
-// wxSQLite3Database: class holding a SQLite3 database object
-// ----------------------------------------------------------------------------
+bool wxSQLite3Statement::IsCapturingQueryPlan() const
+{
+  WXSQLITE3_PROFILE();
+  CheckStmt();
+  return m_stmt->m_capturePlan;
+}
 
-bool wxSQLite3Database::ms_sharedCacheEnabled = false;
+wxString wxSQLite3Statement::GetCapturedQueryPlan() const
+{
+  WXSQLITE3_PROFILE();
+  CheckStmt();
+  return m_stmt->m_plan;
+}
 
-void
-wxSQLite3Database::SetSharedCache(bool enable)
+void wxSQLite3Statement::AssertQueryPlan(const wxString& expectedPlan) const
 {
-  int flag = (enable) ? 1 : 0;
-  int rc = sqlite3_enable_shared_cache(flag);
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  CheckStmt();
+  wxString plan;
+  int rc = wxSQLite3ExplainQueryPlan(m_db->m_db, sqlite3_sql(m_stmt->m_stmt), plan);
   if (rc != SQLITE_OK)
   {
-    throw wxSQLite3Exception(rc, wxERRMSG_SHARED_CACHE);
+    const char* localError = sqlite3_errmsg(m_db->m_db);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
+  wxString expected = wxSQLite3NormalizeQueryPlan(expectedPlan);
+  wxString actual = wxSQLite3NormalizeQueryPlan(plan);
+  if (expected != actual)
+  {
+    wxString msg = wxGetTranslation(wxERRMSG_PLAN_MISMATCH);
+    msg += wxS("\n") + wxGetTranslation(wxERRMSG_PLAN_EXPECTED) + wxS("\n") + expected;
+    msg += wxS("\n") + wxGetTranslation(wxERRMSG_PLAN_ACTUAL) + wxS("\n") + actual;
+    throw wxSQLite3Exception(WXSQLITE_ERROR, msg);
   }
-  ms_sharedCacheEnabled = enable;
 }
 
-bool wxSQLite3Database::ms_hasEncryptionSupport = true;
+void wxSQLite3Statement::CheckQueryPlan()
+{
+  WXSQLITE3_PROFILE();
+  // SQLite re-prepares a statement transparently; the counter tells whether this happened
+  int prepareCount = sqlite3_stmt_status(m_stmt->m_stmt, SQLITE_STMTSTATUS_REPREPARE, 0);
+  if (prepareCount == m_stmt->m_prepareCount)
+  {
+    return;
+  }
+  m_stmt->m_prepareCount = prepareCount;
+  wxString plan;
+  if (wxSQLite3ExplainQueryPlan(m_db->m_db, sqlite3_sql(m_stmt->m_stmt), plan) != SQLITE_OK || plan == m_stmt->m_plan)
+  {
+    return;
+  }
+  wxString oldPlan = m_stmt->m_plan;
+  m_stmt->m_plan = plan;
+  if (m_db->m_planListener != NULL)
+  {
+    try
+    {
+      m_db->m_planListener->OnPlanChanged(wxString::FromUTF8(sqlite3_sql(m_stmt->m_stmt)), oldPlan, plan);
+    }
+    catch (...)
+    {
+      // The statement is in the middle of its execution
+    }
+  }
+}
 
-#if SQLITE_ENABLE_COLUMN_METADATA
-bool wxSQLite3Database::ms_hasMetaDataSupport = true;
+void wxSQLite3Statement::CheckDatabase() const
+{
+  WXSQLITE3_PROFILE();
+  if (m_db == NULL || m_db->m_db == NULL || !m_db->m_isValid)
+  {
+    throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NODB);
+  }
+}
+
+void wxSQLite3Statement::CheckStmt() const
+{
+  WXSQLITE3_PROFILE();
+  if (m_stmt == NULL || m_stmt->m_stmt == NULL || !m_stmt->m_isValid)
+  {
+    throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOSTMT);
+  }
+}
+
+//
+
+wxSQLite3Blob::wxSQLite3Blob()
+{
+  m_db   = NULL;
+  m_blob = NULL;
+  m_writable = false;
+}
+
+wxSQLite3Blob::wxSQLite3Blob(const wxSQLite3Blob& blob)
+{
+  m_db   = blob.m_db;
+  if (m_db != NULL)
+  {
+    m_db->IncrementRefCount();
+  }
+  m_blob = blob.m_blob;
+  if (m_blob != NULL)
+  {
+    m_blob->IncrementRefCount();
+  }
+  m_writable = blob.m_writable;
+}
+
+wxSQLite3Blob& wxSQLite3Blob::operator=(const wxSQLite3Blob& blob)
+{
+  if (this != &blob)
+  {
+    wxSQLite3DatabaseReference* dbPrev = m_db;
+    wxSQLite3BlobReference* blobPrev = m_blob;
+    m_db   = blob.m_db;
+    if (m_db != NULL)
+    {
+      m_db->IncrementRefCount();
+    }
+    m_blob = blob.m_blob;
+    if (m_blob != NULL)
+    {
+      m_blob->IncrementRefCount();
+    }
+    m_writable = blob.m_writable;
+    if (blobPrev != NULL && blobPrev->DecrementRefCount() == 0)
+    {
+      Finalize(dbPrev, blobPrev);
+      delete blobPrev;
+    }
+    if (dbPrev != NULL && dbPrev->DecrementRefCount() == 0)
+    {
+      delete dbPrev;
+    }
+  }
+  return *this;
+}
+
+wxSQLite3Blob::wxSQLite3Blob(wxSQLite3DatabaseReference* db, wxSQLite3BlobReference* blob, bool writable)
+{
+  m_db   = db;
+  if (m_db != NULL)
+  {
+    m_db->IncrementRefCount();
+  }
+  m_blob = blob;
+  if (m_blob != NULL)
+  {
+    m_blob->IncrementRefCount();
+  }
+  m_writable = writable;
+}
+
+wxSQLite3Blob::~wxSQLite3Blob()
+{
+  if (m_blob != NULL && m_blob->DecrementRefCount() == 0)
+  {
+    Finalize(m_db, m_blob);
+    delete m_blob;
+  }
+  if (m_db != NULL && m_db->DecrementRefCount() == 0)
+  {
+    if (m_db->m_isValid)
+    {
+      sqlite3_close(m_db->m_db);
+    }
+    delete m_db;
+  }
+}
+
+wxMemoryBuffer& wxSQLite3Blob::Read(wxMemoryBuffer& blobValue, int length, int offset) const
+{
+  WXSQLITE3_PROFILE();
+  char* localBuffer = (char*) blobValue.GetAppendBuf((size_t) length);
+  Read(localBuffer, length, offset);
+  blobValue.UngetAppendBuf((size_t) length);
+  return blobValue;
+}
+
+void wxSQLite3Blob::Read(void* buffer, int length, int offset) const
+{
+  WXSQLITE3_PROFILE();
+#if SQLITE_VERSION_NUMBER >= 3004000
+  CheckBlob();
+  int rc = sqlite3_blob_read(m_blob->m_blob, buffer, length, offset);
+
+  if (rc != SQLITE_OK)
+  {
+    const char* localError = sqlite3_errmsg(m_db->m_db);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
 #else
-bool wxSQLite3Database::ms_hasMetaDataSupport = false;
+  wxUnusedVar(buffer);
+  wxUnusedVar(length);
+  wxUnusedVar(offset);
+  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOINCBLOB);
 #endif
+}
 
-bool wxSQLite3Database::ms_hasUserAuthentication = false;
+void wxSQLite3Blob::Write(const wxMemoryBuffer& blobValue, int offset)
+{
+  WXSQLITE3_PROFILE();
+  Write(blobValue.GetData(), (int) blobValue.GetDataLen(), offset);
+}
 
-#if WXSQLITE3_HAVE_LOAD_EXTENSION
-bool wxSQLite3Database::ms_hasLoadExtSupport = true;
+void wxSQLite3Blob::Write(const void* buffer, int length, int offset)
+{
+  WXSQLITE3_PROFILE();
+#if SQLITE_VERSION_NUMBER >= 3004000
+  CheckBlob();
+  if (m_writable)
+  {
+    int rc = sqlite3_blob_write(m_blob->m_blob, buffer, length, offset);
+
+    if (rc != SQLITE_OK)
+    {
+      const char* localError = sqlite3_errmsg(m_db->m_db);
+      throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+    }
+  }
+  else
+  {
+    throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_INVALID_BLOB);
+  }
 #else
-bool wxSQLite3Database::ms_hasLoadExtSupport = false;
+  wxUnusedVar(buffer);
+  wxUnusedVar(length);
+  wxUnusedVar(offset);
+  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOINCBLOB);
 #endif
+}
 
-#if WXSQLITE3_USE_NAMED_COLLECTIONS
-bool wxSQLite3Database::ms_hasNamedCollectionSupport = true;
+bool wxSQLite3Blob::IsOk() const
+{
+  return (m_blob != NULL && m_blob->m_isValid);
+}
+
+bool wxSQLite3Blob::IsReadOnly() const
+{
+  WXSQLITE3_PROFILE();
+  return !m_writable;
+}
+
+int wxSQLite3Blob::GetSize() const
+{
+  WXSQLITE3_PROFILE();
+#if SQLITE_VERSION_NUMBER >= 3004000
+  CheckBlob();
+  return sqlite3_blob_bytes(m_blob->m_blob);
 #else
-bool wxSQLite3Database::ms_hasNamedCollectionSupport = false;
+  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOINCBLOB);
+  return 0;
 #endif
+}
+
+void wxSQLite3Blob::Rebind(wxLongLong rowid)
+{
+  WXSQLITE3_PROFILE();
+#if SQLITE_VERSION_NUMBER >= 3007004
+  CheckBlob();
+  int rc = sqlite3_blob_reopen(m_blob->m_blob, rowid.GetValue());
+  if (rc != SQLITE_OK)
+  {
+    const char* localError = sqlite3_errmsg(m_db->m_db);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
+#else
+  wxUnusedVar(rowid);
+  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOBLOBREBIND);
+#endif
+}
+
+void wxSQLite3Blob::Finalize()
+{
+  WXSQLITE3_PROFILE();
+  Finalize(m_db, m_blob);
+}
+
+void wxSQLite3Blob::Finalize(wxSQLite3DatabaseReference* db, wxSQLite3BlobReference* blob)
+{
+  WXSQLITE3_PROFILE();
+#if SQLITE_VERSION_NUMBER >= 3004000
+  if (blob != NULL && blob->m_isValid)
+  {
+    int rc = sqlite3_blob_close(blob->m_blob);
+    blob->Invalidate();
+    if (rc != SQLITE_OK)
+    {
+      if (db != NULL && db->m_isValid)
+      {
+        const char* localError = sqlite3_errmsg(db->m_db);
+        throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+      }
+      else
+      {
+        throw wxSQLite3Exception(rc, wxERRMSG_FINALIZE_FAILED);
+      }
+    }
+  }
+#else
+  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOINCBLOB);
+#endif
+}
+
+void wxSQLite3Blob::CheckBlob() const
+{
+  WXSQLITE3_PROFILE();
+  if (m_db == NULL || !m_db->m_isValid || m_blob == NULL || !m_blob->m_isValid)
+  {
+    throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_INVALID_BLOB);
+  }
+}
+
+// ----------------------------------------------------------------------------
+// wxSQLite3BlobInputStream, wxSQLite3BlobOutputStream: incremental BLOB streams
+// ----------------------------------------------------------------------------
+
+#if wxUSE_STREAMS
+
+// Compute the new position of a seek operation, wxInvalidOffset if out of range
+static wxFileOffset wxSQLite3BlobSeekPosition(wxFileOffset pos, wxSeekMode mode, int position, int size)
+{
+  wxFileOffset newPosition;
+  switch (mode)
+  {
+    case wxFromCurrent:
+      newPosition = position + pos;
+      break;
+    case wxFromEnd:
+      newPosition = size + pos;
+      break;
+    case wxFromStart:
+    default:
+      newPosition = pos;
+      break;
+  }
+  return (newPosition >= 0 && newPosition <= size) ? newPosition : wxInvalidOffset;
+}
+
+wxSQLite3BlobInputStream::wxSQLite3BlobInputStream(const wxSQLite3Blob& blob)
+  : m_blob(blob), m_size(0), m_position(0)
+{
+  try
+  {
+    m_size = m_blob.GetSize();
+  }
+  catch (wxSQLite3Exception&)
+  {
+    m_lasterror = wxSTREAM_READ_ERROR;
+  }
+}
+
+wxSQLite3BlobInputStream::~wxSQLite3BlobInputStream()
+{
+}
+
+wxFileOffset wxSQLite3BlobInputStream::GetLength() const
+{
+  return m_size;
+}
+
+size_t wxSQLite3BlobInputStream::OnSysRead(void* buffer, size_t size)
+{
+  size_t remaining = (size_t) (m_size - m_position);
+  if (remaining == 0)
+  {
+    m_lasterror = wxSTREAM_EOF;
+    return 0;
+  }
+  int length = (int) ((size < remaining) ? size : remaining);
+  try
+  {
+    m_blob.Read(buffer, length, m_position);
+  }
+  catch (wxSQLite3Exception&)
+  {
+    m_lasterror = wxSTREAM_READ_ERROR;
+    return 0;
+  }
+  m_position += length;
+  return (size_t) length;
+}
+
+wxFileOffset wxSQLite3BlobInputStream::OnSysSeek(wxFileOffset pos, wxSeekMode mode)
+{
+  wxFileOffset newPosition = wxSQLite3BlobSeekPosition(pos, mode, m_position, m_size);
+  if (newPosition != wxInvalidOffset)
+  {
+    m_position = (int) newPosition;
+  }
+  return newPosition;
+}
+
+wxFileOffset wxSQLite3BlobInputStream::OnSysTell() const
+{
+  return m_position;
+}
+
+wxSQLite3BlobOutputStream::wxSQLite3BlobOutputStream(const wxSQLite3Blob& blob)
+  : m_blob(blob), m_size(0), m_position(0)
+{
+  try
+  {
+    m_size = m_blob.GetSize();
+  }
+  catch (wxSQLite3Exception&)
+  {
+    m_lasterror = wxSTREAM_WRITE_ERROR;
+  }
+}
+
+wxSQLite3BlobOutputStream::~wxSQLite3BlobOutputStream()
+{
+}
+
+wxFileOffset wxSQLite3BlobOutputStream::GetLength() const
+{
+  return m_size;
+}
+
+size_t wxSQLite3BlobOutputStream::OnSysWrite(const void* buffer, size_t size)
+{
+  size_t remaining = (size_t) (m_size - m_position);
+  int length = (int) ((size < remaining) ? size : remaining);
+  if (length > 0)
+  {
+    try
+    {
+      m_blob.Write(buffer, length, m_position);
+    }
+    catch (wxSQLite3Exception&)
+    {
+      m_lasterror = wxSTREAM_WRITE_ERROR;
+      return 0;
+    }
+    m_position += length;
+  }
+  if ((size_t) length < size)
+  {
+    // The size of a BLOB is fixed
+    m_lasterror = wxSTREAM_WRITE_ERROR;
+  }
+  return (size_t) length;
+}
+
+wxFileOffset wxSQLite3BlobOutputStream::OnSysSeek(wxFileOffset pos, wxSeekMode mode)
+{
+  wxFileOffset newPosition = wxSQLite3BlobSeekPosition(pos, mode, m_position, m_size);
+  if (newPosition != wxInvalidOffset)
+  {
+    m_position = (int) newPosition;
+  }
+  return newPosition;
+}
+
+wxFileOffset wxSQLite3BlobOutputStream::OnSysTell() const
+{
+  return m_position;
+}
+
+#endif // wxUSE_STREAMS
+
+// --- Compression frame format
+
+// Frame header: 'W', 'X', 'Z', version 1, codec, flags, 2 reserved bytes,
+// original size (8 bytes little endian), followed by the (compressed) data
+static const int gs_compressHeaderSize = 16;
+static const int gs_compressCodecStored = 0;
+static const int gs_compressCodecZlib = 1;
+static const int gs_compressFlagText = 0x01;
+
+// Deflate can not expand data by more than a factor of 1032
+static const sqlite3_uint64 gs_compressMaxRatio = 1032;
+
+static bool wxSQLite3ReadCompressHeader(const unsigned char* data, size_t len, int& codec, bool& isText, sqlite3_uint64& originalSize)
+{
+  if (data == NULL || len < (size_t) gs_compressHeaderSize ||
+      data[0] != 'W' || data[1] != 'X' || data[2] != 'Z' || data[3] != 1 ||
+      (data[4] != gs_compressCodecStored && data[4] != gs_compressCodecZlib))
+  {
+    return false;
+  }
+  codec = data[4];
+  isText = (data[5] & gs_compressFlagText) != 0;
+  originalSize = 0;
+  int j;
+  for (j = 7; j >= 0; --j)
+  {
+    originalSize = (originalSize << 8) | data[8 + j];
+  }
+  // Stored data must be complete
+  return codec != gs_compressCodecStored || len - gs_compressHeaderSize >= originalSize;
+}
+
+static void wxSQLite3WriteCompressHeader(unsigned char* data, int codec, bool isText, sqlite3_uint64 originalSize)
+{
+  data[0] = 'W';
+  data[1] = 'X';
+  data[2] = 'Z';
+  data[3] = 1;
+  data[4] = (unsigned char) codec;
+  data[5] = (unsigned char) (isText ? gs_compressFlagText : 0);
+  data[6] = 0;
+  data[7] = 0;
+  int j;
+  for (j = 0; j < 8; ++j)
+  {
+    data[8 + j] = (unsigned char) (originalSize >> (8 * j));
+  }
+}
+
+// Worst case size of zlib compressed data (like compressBound of zlib, plus room for flushes)
+static sqlite3_uint64 wxSQLite3CompressBound(sqlite3_uint64 len)
+{
+  return len + (len >> 12) + (len >> 14) + (len >> 25) + 13 + 64;
+}
+
+#if wxUSE_ZLIB && wxUSE_STREAMS
+
+wxSQLite3CompressedBlobOutputStream::wxSQLite3CompressedBlobOutputStream(const wxSQLite3Blob& blob, bool isText, int level)
+  : m_blob(blob), m_blobStream(blob), m_zlibStream(NULL), m_originalSize(0), m_isText(isText), m_closed(false)
+{
+  if (m_blobStream.IsOk() && m_blobStream.SeekO(gs_compressHeaderSize) != wxInvalidOffset)
+  {
+    m_zlibStream = new wxZlibOutputStream(m_blobStream, level, wxZLIB_ZLIB);
+  }
+  else
+  {
+    m_lasterror = wxSTREAM_WRITE_ERROR;
+  }
+}
+
+wxSQLite3CompressedBlobOutputStream::~wxSQLite3CompressedBlobOutputStream()
+{
+  Close();
+  delete m_zlibStream;
+}
+
+bool wxSQLite3CompressedBlobOutputStream::Close()
+{
+  if (m_closed)
+  {
+    return IsOk();
+  }
+  m_closed = true;
+  if (m_zlibStream == NULL)
+  {
+    return false;
+  }
+  if (!m_zlibStream->Close() || !m_blobStream.IsOk())
+  {
+    m_lasterror = wxSTREAM_WRITE_ERROR;
+    return false;
+  }
+  unsigned char header[gs_compressHeaderSize];
+  wxSQLite3WriteCompressHeader(header, gs_compressCodecZlib, m_isText, (sqlite3_uint64) m_originalSize);
+  try
+  {
+    m_blob.Write(header, gs_compressHeaderSize, 0);
+  }
+  catch (wxSQLite3Exception&)
+  {
+    m_lasterror = wxSTREAM_WRITE_ERROR;
+  }
+  return IsOk();
+}
+
+wxFileOffset wxSQLite3CompressedBlobOutputStream::GetCompressedSize() const
+{
+  return m_blobStream.TellO();
+}
+
+/* static */
+wxFileOffset wxSQLite3CompressedBlobOutputStream::GetMaxBlobSize(wxFileOffset originalSize)
+{
+  return gs_compressHeaderSize + (wxFileOffset) wxSQLite3CompressBound((sqlite3_uint64) originalSize);
+}
+
+size_t wxSQLite3CompressedBlobOutputStream::OnSysWrite(const void* buffer, size_t size)
+{
+  if (m_zlibStream == NULL || m_closed)
+  {
+    m_lasterror = wxSTREAM_WRITE_ERROR;
+    return 0;
+  }
+  size_t written = m_zlibStream->Write(buffer, size).LastWrite();
+  m_originalSize += written;
+  if (written < size)
+  {
+    m_lasterror = wxSTREAM_WRITE_ERROR;
+  }
+  return written;
+}
+
+wxFileOffset wxSQLite3CompressedBlobOutputStream::OnSysTell() const
+{
+  return m_originalSize;
+}
+
+wxSQLite3CompressedBlobInputStream::wxSQLite3CompressedBlobInputStream(const wxSQLite3Blob& blob)
+  : m_blobStream(blob), m_zlibStream(NULL), m_originalSize(0), m_position(0), m_compressed(false), m_isText(false)
+{
+  if (!m_blobStream.IsOk())
+  {
+    m_lasterror = wxSTREAM_READ_ERROR;
+    return;
+  }
+  m_originalSize = m_blobStream.GetLength();
+  unsigned char header[gs_compressHeaderSize];
+  int codec;
+  sqlite3_uint64 originalSize;
+  if (m_originalSize >= gs_compressHeaderSize &&
+      m_blobStream.Read(header, gs_compressHeaderSize).LastRead() == (size_t) gs_compressHeaderSize &&
+      wxSQLite3ReadCompressHeader(header, (size_t) m_originalSize, codec, m_isText, originalSize))
+  {
+    m_compressed = true;
+    m_originalSize = (wxFileOffset) originalSize;
+    if (codec == gs_compressCodecZlib)
+    {
+      m_zlibStream = new wxZlibInputStream(m_blobStream, wxZLIB_ZLIB);
+    }
+  }
+  else
+  {
+    // Not compressed, the BLOB is read as is
+    m_isText = false;
+    m_blobStream.SeekI(0);
+  }
+}
+
+wxSQLite3CompressedBlobInputStream::~wxSQLite3CompressedBlobInputStream()
+{
+  delete m_zlibStream;
+}
+
+wxFileOffset wxSQLite3CompressedBlobInputStream::GetLength() const
+{
+  return m_originalSize;
+}
+
+size_t wxSQLite3CompressedBlobInputStream::OnSysRead(void* buffer, size_t size)
+{
+  wxFileOffset remaining = m_originalSize - m_position;
+  if (remaining <= 0)
+  {
+    m_lasterror = wxSTREAM_EOF;
+    return 0;
+  }
+  if ((wxFileOffset) size > remaining)
+  {
+    size = (size_t) remaining;
+  }
+  wxInputStream& source = (m_zlibStream != NULL) ? (wxInputStream&) *m_zlibStream : (wxInputStream&) m_blobStream;
+  size_t count = source.Read(buffer, size).LastRead();
+  m_position += count;
+  if (count < size)
+  {
+    // The data ended prematurely
+    m_lasterror = wxSTREAM_READ_ERROR;
+  }
+  return count;
+}
+
+wxFileOffset wxSQLite3CompressedBlobInputStream::OnSysTell() const
+{
+  return m_position;
+}
+
+#endif // wxUSE_ZLIB && wxUSE_STREAMS
+
+// ----------------------------------------------------------------------------
+// wxSQLite3Database: class holding a SQLite3 database object
+// ----------------------------------------------------------------------------
+
+bool wxSQLite3Database::ms_sharedCacheEnabled = false;
+
+void
+wxSQLite3Database::SetSharedCache(bool enable)
+{
+  WXSQLITE3_PROFILE();
+  int flag = (enable) ? 1 : 0;
+  int rc = sqlite3_enable_shared_cache(flag);
+  if (rc != SQLITE_OK)
+  {
+    throw wxSQLite3Exception(rc, wxERRMSG_SHARED_CACHE);
+  }
+  ms_sharedCacheEnabled = enable;
+}
+
+bool wxSQLite3Database::ms_hasEncryptionSupport = true;
+
+#if SQLITE_ENABLE_COLUMN_METADATA
+bool wxSQLite3Database::ms_hasMetaDataSupport = true;
+#else
+bool wxSQLite3Database::ms_hasMetaDataSupport = false;
+#endif
+
+bool wxSQLite3Database::ms_hasUserAuthentication = false;
+
+#if WXSQLITE3_HAVE_LOAD_EXTENSION
+bool wxSQLite3Database::ms_hasLoadExtSupport = true;
+#else
+bool wxSQLite3Database::ms_hasLoadExtSupport = false;
+#endif
+
+#if WXSQLITE3_USE_NAMED_COLLECTIONS
+bool wxSQLite3Database::ms_hasNamedCollectionSupport = true;
+#else
+bool wxSQLite3Database::ms_hasNamedCollectionSupport = false;
+#endif
+
+bool wxSQLite3Database::ms_hasIncrementalBlobSupport = true;
+
+bool wxSQLite3Database::ms_hasSavepointSupport = true;
+
+bool wxSQLite3Database::ms_hasBackupSupport = true;
+
+bool wxSQLite3Database::ms_hasWriteAheadLogSupport = true;
+
+bool wxSQLite3Database::ms_hasPointerParamsSupport = true;
+
+#if WXSQLITE3_HAVE_CARRAY_BIND
+bool wxSQLite3Database::ms_hasArrayParamsSupport = true;
+#else
+bool wxSQLite3Database::ms_hasArrayParamsSupport = false;
+#endif
+
+#if defined(SQLITE_ENABLE_PREUPDATE_HOOK)
+bool wxSQLite3Database::ms_hasPreUpdateHookSupport = true;
+#else
+bool wxSQLite3Database::ms_hasPreUpdateHookSupport = false;
+#endif
+
+#if defined(SQLITE_ENABLE_STMT_SCANSTATUS)
+bool wxSQLite3Database::ms_hasScanStatusSupport = true;
+#else
+bool wxSQLite3Database::ms_hasScanStatusSupport = false;
+#endif
+
+#if WXSQLITE3_PROFILE_WRAPPER
+bool wxSQLite3Database::ms_hasWrapperProfileSupport = true;
+#else
+bool wxSQLite3Database::ms_hasWrapperProfileSupport = false;
+#endif
+
+bool
+wxSQLite3Database::HasEncryptionSupport()
+{
+  return ms_hasEncryptionSupport;
+}
+
+bool
+wxSQLite3Database::HasMetaDataSupport()
+{
+  return ms_hasMetaDataSupport;
+}
+
+bool
+wxSQLite3Database::HasUserAuthenticationSupport()
+{
+  return ms_hasUserAuthentication;
+}
+
+bool
+wxSQLite3Database::HasLoadExtSupport()
+{
+  return ms_hasLoadExtSupport;
+}
+
+bool
+wxSQLite3Database::HasNamedCollectionSupport()
+{
+  return ms_hasNamedCollectionSupport;
+}
+
+bool
+wxSQLite3Database::HasIncrementalBlobSupport()
+{
+  return ms_hasIncrementalBlobSupport;
+}
+
+bool
+wxSQLite3Database::HasSavepointSupport()
+{
+  return ms_hasSavepointSupport;
+}
+
+bool
+wxSQLite3Database::HasBackupSupport()
+{
+  return ms_hasBackupSupport;
+}
+
+bool
+wxSQLite3Database::HasWriteAheadLogSupport()
+{
+  return ms_hasWriteAheadLogSupport;
+}
+
+bool
+wxSQLite3Database::HasPointerParamsSupport()
+{
+  return ms_hasPointerParamsSupport;
+}
+
+bool
+wxSQLite3Database::HasArrayParamsSupport()
+{
+  return ms_hasArrayParamsSupport;
+}
+
+bool
+wxSQLite3Database::HasPreUpdateHookSupport()
+{
+  return ms_hasPreUpdateHookSupport;
+}
+
+bool
+wxSQLite3Database::HasScanStatusSupport()
+{
+  return ms_hasScanStatusSupport;
+}
+
+bool
+wxSQLite3Database::HasWrapperProfileSupport()
+{
+  return ms_hasWrapperProfileSupport;
+}
+
+wxSQLite3Database::wxSQLite3Database()
+{
+  m_db = 0;
+  m_isOpen = false;
+  m_busyTimeoutMs = 60000; // 60 seconds
+  m_isEncrypted = false;
+  m_lastRollbackRC = 0;
+  m_backupPageCount = 10;
+}
+
+wxSQLite3Database::wxSQLite3Database(const wxSQLite3Database& db)
+{
+  m_db = db.m_db;
+  if (m_db != NULL)
+  {
+    m_db->IncrementRefCount();
+  }
+  m_isOpen = db.m_isOpen;
+  m_busyTimeoutMs = 60000; // 60 seconds
+  m_isEncrypted = db.m_isEncrypted;
+  m_lastRollbackRC = db.m_lastRollbackRC;
+  m_backupPageCount = db.m_backupPageCount;
+}
+
+wxSQLite3Database::~wxSQLite3Database()
+{
+  if (m_db != NULL && m_db->DecrementRefCount() == 0)
+  {
+    if (m_db->m_isValid)
+    {
+      Close(m_db);
+    }
+    delete m_db;
+  }
+}
+
+wxSQLite3Database& wxSQLite3Database::operator=(const wxSQLite3Database& db)
+{
+  if (this != &db)
+  {
+    wxSQLite3DatabaseReference* dbPrev = m_db;
+    m_db = db.m_db;
+    if (m_db != NULL)
+    {
+      m_db->IncrementRefCount();
+      m_isOpen = db.m_isOpen;
+      m_busyTimeoutMs = 60000; // 60 seconds
+      m_isEncrypted = db.m_isEncrypted;
+      m_lastRollbackRC = db.m_lastRollbackRC;
+      m_backupPageCount = db.m_backupPageCount;
+    }
+    if (dbPrev != NULL && dbPrev->DecrementRefCount() == 0)
+    {
+      Close(dbPrev);
+      delete dbPrev;
+    }
+
+    if (m_db == NULL)
+    {
+      throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_DBASSIGN_FAILED);
+    }
+  }
+  return *this;
+}
+
+void wxSQLite3Database::Open(const wxString& fileName, const wxString& key, int flags, const wxString& vfs)
+{
+  WXSQLITE3_PROFILE();
+  wxCharBuffer strLocalKey = key.ToUTF8();
+  const char* localKey = strLocalKey;
+  wxMemoryBuffer binaryKey;
+  if (key.Length() > 0)
+  {
+    binaryKey.AppendData((void*) localKey, strlen(localKey));
+  }
+  Open(fileName, binaryKey, flags, vfs);
+}
+
+void wxSQLite3Database::Open(const wxString& fileName, const wxMemoryBuffer& key, int flags, const wxString& vfs)
+{
+  WXSQLITE3_PROFILE();
+  wxCharBuffer strFileName = fileName.ToUTF8();
+  const char* localFileName = strFileName;
+  wxCharBuffer strVfs = vfs.ToUTF8();
+  const char* localVfs = (!vfs.IsEmpty()) ? (const char*) strVfs : (const char*) NULL;
+  sqlite3* db;
+
+  int rc = sqlite3_open_v2((const char*) localFileName, &db, flags, localVfs);
+
+  if (rc != SQLITE_OK)
+  {
+    const char* localError = "Out of memory";
+    if (db != NULL)
+    {
+      localError = sqlite3_errmsg(db);
+      sqlite3_close(db);
+    }
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
+
+  rc = sqlite3_extended_result_codes(db, 1);
+  if (rc != SQLITE_OK)
+  {
+    const char* localError = sqlite3_errmsg(db);
+    sqlite3_close(db);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
+
+  if (key.GetDataLen() > 0)
+  {
+    rc = sqlite3_key(db, key.GetData(), (int) key.GetDataLen());
+    if (rc != SQLITE_OK)
+    {
+      const char* localError = sqlite3_errmsg(db);
+      sqlite3_close(db);
+      throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+    }
+    m_isEncrypted = true;
+  }
+
+  wxSQLite3DatabaseReference* dbPrev = m_db;
+  m_db = new wxSQLite3DatabaseReference(db);
+  m_isOpen = true;
+  SetBusyTimeout(m_busyTimeoutMs);
+  if (dbPrev != NULL && dbPrev->DecrementRefCount() == 0)
+  {
+    delete dbPrev;
+  }
+}
+
+void wxSQLite3Database::Open(const wxString& fileName, const wxSQLite3Cipher& cipher, const wxString& key, int flags, const wxString& vfs)
+{
+  WXSQLITE3_PROFILE();
+  wxCharBuffer strLocalKey = key.ToUTF8();
+  const char* localKey = strLocalKey;
+  wxMemoryBuffer binaryKey;
+  if (key.Length() > 0)
+  {
+    binaryKey.AppendData((void*)localKey, strlen(localKey));
+  }
+  Open(fileName, cipher, binaryKey, flags, vfs);
+}
+
+void wxSQLite3Database::Open(const wxString& fileName, const wxSQLite3Cipher& cipher, const wxMemoryBuffer& key, int flags, const wxString& vfs)
+{
+  WXSQLITE3_PROFILE();
+  wxCharBuffer strFileName = fileName.ToUTF8();
+  const char* localFileName = strFileName;
+  wxCharBuffer strVfs = vfs.ToUTF8();
+  const char* localVfs = (!vfs.IsEmpty()) ? (const char*) strVfs : (const char*) NULL;
+  sqlite3* db;
+
+  int rc = sqlite3_open_v2((const char*) localFileName, &db, flags, localVfs);
+
+  if (rc != SQLITE_OK)
+  {
+    const char* localError = "Out of memory";
+    if (db != NULL)
+    {
+      localError = sqlite3_errmsg(db);
+      sqlite3_close(db);
+    }
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
+
+  rc = sqlite3_extended_result_codes(db, 1);
+  if (rc != SQLITE_OK)
+  {
+    const char* localError = sqlite3_errmsg(db);
+    sqlite3_close(db);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
+
+  if (cipher.IsOk())
+  {
+    if (!cipher.Apply(db))
+    {
+      throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_CIPHER_APPLY_FAILED);
+    }
+  }
+
+  if (key.GetDataLen() > 0)
+  {
+    rc = sqlite3_key(db, key.GetData(), (int)key.GetDataLen());
+    if (rc != SQLITE_OK)
+    {
+      const char* localError = sqlite3_errmsg(db);
+      sqlite3_close(db);
+      throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+    }
+    m_isEncrypted = true;
+  }
+
+  wxSQLite3DatabaseReference* dbPrev = m_db;
+  m_db = new wxSQLite3DatabaseReference(db);
+  m_isOpen = true;
+  SetBusyTimeout(m_busyTimeoutMs);
+  if (dbPrev != NULL && dbPrev->DecrementRefCount() == 0)
+  {
+    delete dbPrev;
+  }
+}
+
+bool wxSQLite3Database::IsOpen() const
+{
+  WXSQLITE3_PROFILE();
+  return (m_db != NULL && m_db->m_isValid && m_isOpen);
+}
+
+bool wxSQLite3Database::IsReadOnly(const wxString& databaseName) const
+{
+  WXSQLITE3_PROFILE();
+#if SQLITE_VERSION_NUMBER >= 3007011
+  CheckDatabase();
+  wxCharBuffer strDatabaseName = databaseName.ToUTF8();
+  const char* localDatabaseName = strDatabaseName;
+  return sqlite3_db_readonly(m_db->m_db, localDatabaseName) > 0;
+#else
+  return false;
+#endif
+}
+
+void wxSQLite3Database::Close()
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  Close(m_db);
+}
+
+void wxSQLite3Database::Close(wxSQLite3DatabaseReference* db)
+{
+  WXSQLITE3_PROFILE();
+  if (db != NULL && db->m_isValid)
+  {
+#if SQLITE_VERSION_NUMBER >= 3006000
+// Unfortunately the following code leads to a crash if the RTree module is used
+// therefore it is disabled for now
+#if 0
+    // Finalize all unfinalized prepared statements
+    sqlite3_stmt *pStmt;
+    while( (pStmt = sqlite3_next_stmt(db->m_db, 0))!=0 )
+    {
+      sqlite3_finalize(pStmt);
+    }
+#endif
+#endif
+    if (db->m_refCount <= 1)
+    {
+      sqlite3_close(db->m_db);
+      db->Invalidate();
+      db->DetachSamplingProfiler();
+      m_isEncrypted = false;
+    }
+    m_isOpen = false;
+  }
+}
+
+void wxSQLite3Database::AttachDatabase(const wxString& fileName, const wxString& schemaName)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  wxSQLite3Statement attachStmt = PrepareStatement("ATTACH DATABASE ? AS ?");
+  attachStmt.Bind(1, fileName);
+  attachStmt.Bind(2, schemaName);
+  int rc = attachStmt.ExecuteUpdate();
+}
+
+void wxSQLite3Database::AttachDatabase(const wxString& fileName, const wxString& schemaName, const wxString& key)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  wxSQLite3Statement attachStmt = PrepareStatement("ATTACH DATABASE ? AS ? KEY ?");
+  attachStmt.Bind(1, fileName);
+  attachStmt.Bind(2, schemaName);
+  attachStmt.Bind(3, key);
+  int rc = attachStmt.ExecuteUpdate();
+}
+
+void wxSQLite3Database::AttachDatabase(const wxString& fileName, const wxString& schemaName, const wxSQLite3Cipher& cipher, const wxString& key)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  if (cipher.IsOk())
+  {
+    if (!cipher.Apply(m_db->m_db))
+    {
+      throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_CIPHER_APPLY_FAILED);
+    }
+  }
+
+  wxSQLite3Statement attachStmt = PrepareStatement("ATTACH DATABASE ? AS ? KEY ?");
+  attachStmt.Bind(1, fileName);
+  attachStmt.Bind(2, schemaName);
+  attachStmt.Bind(3, key);
+  int rc = attachStmt.ExecuteUpdate();
+}
+
+void wxSQLite3Database::DetachDatabase(const wxString& schemaName)
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3Statement detachStmt = PrepareStatement("DETACH DATABASE ?");
+  detachStmt.Bind(1, schemaName);
+  int rc = detachStmt.ExecuteUpdate();
+}
+
+void wxSQLite3Database::AttachDatabaseUtf8(const char* fileName, int fileNameLen, const char* schemaName, int schemaNameLen)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  wxSQLite3Statement attachStmt = PrepareStatement("ATTACH DATABASE ? AS ?");
+  attachStmt.BindText(1, fileName, fileNameLen);
+  attachStmt.BindText(2, schemaName, schemaNameLen);
+  attachStmt.ExecuteUpdate();
+}
+
+void wxSQLite3Database::DetachDatabaseUtf8(const char* schemaName, int schemaNameLen)
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3Statement detachStmt = PrepareStatement("DETACH DATABASE ?");
+  detachStmt.BindText(1, schemaName, schemaNameLen);
+  detachStmt.ExecuteUpdate();
+}
+
+static bool
+BackupRestoreCallback(int total, int remaining, wxSQLite3BackupProgress* progressCallback)
+{
+  return progressCallback->Progress(total, remaining);
+}
+
+void wxSQLite3Database::Backup(const wxString& targetFileName, const wxString& key, 
+                               const wxString& sourceDatabaseName)
+{
+  WXSQLITE3_PROFILE();
+  Backup(NULL, targetFileName, wxSQLite3Cipher(), key, sourceDatabaseName);
+}
+
+void wxSQLite3Database::Backup(const wxString& targetFileName, const wxSQLite3Cipher& cipher, 
+                               const wxString& key, const wxString& sourceDatabaseName)
+{
+  WXSQLITE3_PROFILE();
+  Backup(NULL, targetFileName, cipher, key, sourceDatabaseName);
+}
+
+void wxSQLite3Database::Backup(wxSQLite3BackupProgress* progressCallback,
+                               const wxString& targetFileName, const wxString& key,
+                               const wxString& sourceDatabaseName)
+{
+  WXSQLITE3_PROFILE();
+  Backup(progressCallback, targetFileName, wxSQLite3Cipher(), key, sourceDatabaseName);
+}
+
+void wxSQLite3Database::Backup(wxSQLite3BackupProgress* progressCallback, 
+                               const wxString& targetFileName, const wxSQLite3Cipher& cipher, 
+                               const wxString& key, const wxString& sourceDatabaseName)
+{
+  WXSQLITE3_PROFILE();
+  wxCharBuffer strLocalKey = key.ToUTF8();
+  const char* localKey = strLocalKey;
+  wxMemoryBuffer binaryKey;
+  if (key.Length() > 0)
+  {
+    binaryKey.AppendData((void*) localKey, strlen(localKey));
+  }
+  Backup(progressCallback, targetFileName, cipher, binaryKey, sourceDatabaseName);
+}
+
+void wxSQLite3Database::Backup(const wxString& targetFileName, const wxMemoryBuffer& key, 
+                               const wxString& sourceDatabaseName)
+{
+  WXSQLITE3_PROFILE();
+  Backup(NULL, targetFileName, wxSQLite3Cipher(), key, sourceDatabaseName);
+}
+
+void wxSQLite3Database::Backup(const wxString& targetFileName, const wxSQLite3Cipher& cipher, 
+                               const wxMemoryBuffer& key, const wxString& sourceDatabaseName)
+{
+  WXSQLITE3_PROFILE();
+  Backup(NULL, targetFileName, cipher, key, sourceDatabaseName);
+}
+
+void wxSQLite3Database::Backup(wxSQLite3BackupProgress* progressCallback, const wxString& targetFileName,
+                               const wxMemoryBuffer& key, const wxString& sourceDatabaseName)
+{
+  WXSQLITE3_PROFILE();
+  Backup(progressCallback, targetFileName, wxSQLite3Cipher(), key, sourceDatabaseName);
+}
+
+void wxSQLite3Database::Backup(wxSQLite3BackupProgress* progressCallback,
+                               const wxString& targetFileName, const wxSQLite3Cipher& cipher, 
+                               const wxMemoryBuffer& key, const wxString& sourceDatabaseName)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+
+  wxCharBuffer strFileName = targetFileName.ToUTF8();
+  const char* localTargetFileName = strFileName;
+  wxCharBuffer strDatabaseName = sourceDatabaseName.ToUTF8();
+  const char* localSourceDatabaseName = strDatabaseName;
+
+  sqlite3* pDest;
+  sqlite3_backup* pBackup;
+  int rc;
+  rc = sqlite3_open(localTargetFileName, &pDest);
+  if (rc != SQLITE_OK)
+  {
+    sqlite3_close(pDest);
+    throw wxSQLite3Exception(rc, wxERRMSG_DBOPEN_FAILED);
+  }
+
+  if (key.GetDataLen() > 0)
+  {
+    if (cipher.IsOk())
+    {
+      if (!cipher.Apply(pDest))
+      {
+        throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_CIPHER_APPLY_FAILED);
+      }
+    }
+    rc = sqlite3_key(pDest, key.GetData(), (int) key.GetDataLen());
+    if (rc != SQLITE_OK)
+    {
+      const char* localError = sqlite3_errmsg(pDest);
+      sqlite3_close(pDest);
+      throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+    }
+  }
+
+  pBackup = sqlite3_backup_init(pDest, "main", m_db->m_db, localSourceDatabaseName);
+  if (pBackup == 0)
+  {
+    const char* localError = sqlite3_errmsg(pDest);
+    sqlite3_close(pDest);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
+
+  wxSQLite3EventRecorder* recorder = m_db->GetActiveRecorder();
+  do
+  {
+    wxUint64 stepStart = (recorder != NULL) ? wxSQLite3EventRecorder::GetTimestamp() : 0;
+    rc = sqlite3_backup_step(pBackup, m_backupPageCount);
+    if (recorder != NULL)
+    {
+      recorder->Record("backup", "backup_step", stepStart, wxSQLite3EventRecorder::GetTimestamp(),
+                       NULL, NULL, "remaining", sqlite3_backup_remaining(pBackup));
+    }
+    if (progressCallback != NULL)
+    {
+      if (!BackupRestoreCallback(sqlite3_backup_pagecount(pBackup),
+                                 sqlite3_backup_remaining(pBackup),
+                                 progressCallback))
+      {
+        rc = SQLITE_DONE;
+      }
+    }
+    if (rc == SQLITE_BUSY || rc == SQLITE_LOCKED)
+    {
+      wxSQLite3RecorderScope wait(recorder, "lock", "busy_wait");
+      wait.SetArg("rc", rc);
+      sqlite3_sleep(250);
+    }
+  }
+  while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
+
+  sqlite3_backup_finish(pBackup);
+  if (rc == SQLITE_DONE)
+  {
+    sqlite3_close(pDest);
+  }
+  else
+  {
+    const char* localError = sqlite3_errmsg(pDest);
+    sqlite3_close(pDest);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
+}
+
+void wxSQLite3Database::Restore(const wxString& sourceFileName, const wxString& key, 
+                                const wxString& targetDatabaseName)
+{
+  WXSQLITE3_PROFILE();
+  Restore(NULL, sourceFileName, wxSQLite3Cipher(), key, targetDatabaseName);
+}
+
+void wxSQLite3Database::Restore(const wxString& sourceFileName, const wxSQLite3Cipher& cipher,
+                                const wxString& key, const wxString& targetDatabaseName)
+{
+  WXSQLITE3_PROFILE();
+  Restore(NULL, sourceFileName, cipher, key, targetDatabaseName);
+}
+
+void wxSQLite3Database::Restore(wxSQLite3BackupProgress* progressCallback,
+                                const wxString& sourceFileName, const wxString& key,
+                                const wxString& targetDatabaseName)
+{
+  WXSQLITE3_PROFILE();
+  Restore(progressCallback, sourceFileName, wxSQLite3Cipher(), key, targetDatabaseName);
+}
+
+void wxSQLite3Database::Restore(wxSQLite3BackupProgress* progressCallback,
+                                const wxString& sourceFileName, const wxSQLite3Cipher& cipher,
+                                const wxString& key, const wxString& targetDatabaseName)
+{
+  WXSQLITE3_PROFILE();
+  wxCharBuffer strLocalKey = key.ToUTF8();
+  const char* localKey = strLocalKey;
+  wxMemoryBuffer binaryKey;
+  if (key.Length() > 0)
+  {
+    binaryKey.AppendData((void*) localKey, strlen(localKey));
+  }
+  Restore(progressCallback, sourceFileName, cipher, binaryKey, targetDatabaseName);
+}
+
+void wxSQLite3Database::Restore(const wxString& sourceFileName, const wxMemoryBuffer& key, 
+                                const wxString& targetDatabaseName)
+{
+  WXSQLITE3_PROFILE();
+  Restore(NULL, sourceFileName, wxSQLite3Cipher(), key, targetDatabaseName);
+}
+
+void wxSQLite3Database::Restore(wxSQLite3BackupProgress* progressCallback, const wxString& sourceFileName,
+                                const wxMemoryBuffer& key, const wxString& targetDatabaseName)
+{
+  WXSQLITE3_PROFILE();
+  Restore(progressCallback, sourceFileName, wxSQLite3Cipher(), key, targetDatabaseName);
+}
+
+void wxSQLite3Database::Restore(const wxString& sourceFileName, const wxSQLite3Cipher& cipher,
+                                const wxMemoryBuffer& key, const wxString& targetDatabaseName)
+{
+  WXSQLITE3_PROFILE();
+    Restore(NULL, sourceFileName, cipher, key, targetDatabaseName);
+}
+
+void wxSQLite3Database::Restore(wxSQLite3BackupProgress* progressCallback,
+                                const wxString& sourceFileName, const wxSQLite3Cipher& cipher,
+                                const wxMemoryBuffer& key, const wxString& targetDatabaseName)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+
+  wxCharBuffer strFileName = sourceFileName.ToUTF8();
+  const char* localSourceFileName = strFileName;
+  wxCharBuffer strDatabaseName = targetDatabaseName.ToUTF8();
+  const char* localTargetDatabaseName = strDatabaseName;
+
+  sqlite3* pSrc;
+  sqlite3_backup* pBackup;
+  int rc;
+  int nTimeout = 0;
+
+  rc = sqlite3_open(localSourceFileName, &pSrc);
+  if (rc != SQLITE_OK)
+  {
+    sqlite3_close(pSrc);
+    throw wxSQLite3Exception(rc, wxERRMSG_DBOPEN_FAILED);
+  }
+
+  if (key.GetDataLen() > 0)
+  {
+    if (cipher.IsOk())
+    {
+      if (!cipher.Apply(pSrc))
+      {
+        throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_CIPHER_APPLY_FAILED);
+      }
+    }
+    rc = sqlite3_key(pSrc, key.GetData(), (int) key.GetDataLen());
+    if (rc != SQLITE_OK)
+    {
+      const char* localError = sqlite3_errmsg(pSrc);
+      sqlite3_close(pSrc);
+      throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+    }
+  }
+
+  pBackup = sqlite3_backup_init(m_db->m_db, localTargetDatabaseName, pSrc, "main");
+  if (pBackup == 0)
+  {
+    const char* localError = sqlite3_errmsg(m_db->m_db);
+    sqlite3_close(pSrc);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
+
+  wxSQLite3EventRecorder* recorder = m_db->GetActiveRecorder();
+  do
+  {
+    wxUint64 stepStart = (recorder != NULL) ? wxSQLite3EventRecorder::GetTimestamp() : 0;
+    rc = sqlite3_backup_step(pBackup, m_backupPageCount);
+    if (recorder != NULL)
+    {
+      recorder->Record("backup", "restore_step", stepStart, wxSQLite3EventRecorder::GetTimestamp(),
+                       NULL, NULL, "remaining", sqlite3_backup_remaining(pBackup));
+    }
+    if (progressCallback != NULL)
+    {
+      if (!BackupRestoreCallback(sqlite3_backup_pagecount(pBackup),
+                                 sqlite3_backup_remaining(pBackup), progressCallback))
+      {
+        rc = SQLITE_DONE;
+      }
+    }
+    if (rc == SQLITE_BUSY || rc == SQLITE_LOCKED)
+    {
+      if (nTimeout++ >= 20) break;
+      wxSQLite3RecorderScope wait(recorder, "lock", "busy_wait");
+      wait.SetArg("rc", rc);
+      sqlite3_sleep(250);
+    }
+    else
+    {
+      nTimeout = 0;
+    }
+  }
+  while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
+
+  sqlite3_backup_finish(pBackup);
+  if (rc == SQLITE_DONE)
+  {
+    sqlite3_close(pSrc);
+  }
+  else if (rc == SQLITE_BUSY || rc == SQLITE_LOCKED)
+  {
+    sqlite3_close(pSrc);
+    throw wxSQLite3Exception(rc, wxERRMSG_SOURCEDB_BUSY);
+  }
+  else
+  {
+    const char* localError = sqlite3_errmsg(pSrc);
+    sqlite3_close(pSrc);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
+}
+
+void wxSQLite3Database::SetBackupRestorePageCount(int pageCount)
+{
+  WXSQLITE3_PROFILE();
+  m_backupPageCount = pageCount;
+}
+
+void wxSQLite3Database::Vacuum()
+{
+  WXSQLITE3_PROFILE();
+  ExecuteUpdate("vacuum");
+}
+
+void wxSQLite3Database::Begin(wxSQLite3TransactionType transactionType)
+{
+  WXSQLITE3_PROFILE();
+  wxString sql;
+  switch (transactionType)
+  {
+    case WXSQLITE_TRANSACTION_DEFERRED:
+      sql << wxS("begin deferred transaction");
+      break;
+    case WXSQLITE_TRANSACTION_IMMEDIATE:
+      sql << wxS("begin immediate transaction");
+      break;
+    case WXSQLITE_TRANSACTION_EXCLUSIVE:
+      sql << wxS("begin exclusive transaction");
+      break;
+    default:
+      sql << wxS("begin transaction");
+      break;
+  }
+  wxSQLite3RecorderScope scope(GetEventRecorder(), "transaction", "begin");
+  ExecuteUpdate(sql);
+}
+
+void wxSQLite3Database::Commit()
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3RecorderScope scope(GetEventRecorder(), "transaction", "commit");
+  ExecuteUpdate("commit transaction");
+}
+
+void wxSQLite3Database::Rollback(const wxString& savepointName)
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3RecorderScope scope(GetEventRecorder(), "transaction", "rollback");
+#if SQLITE_VERSION_NUMBER >= 3006008
+  if (savepointName.IsEmpty())
+  {
+#endif
+    ExecuteUpdate("rollback transaction");
+#if SQLITE_VERSION_NUMBER >= 3006008
+  }
+  else
+  {
+    wxString localSavepointName = savepointName;
+    localSavepointName.Replace(wxString(wxS("\"")), wxString(wxS("\"\"")));
+    ExecuteUpdate(wxString(wxS("rollback transaction to savepoint \""))+localSavepointName+wxString(wxS("\"")));
+  }
+#endif
+}
+
+bool wxSQLite3Database::GetAutoCommit() const
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  return sqlite3_get_autocommit(m_db->m_db) != 0;
+}
+
+int wxSQLite3Database::QueryRollbackState() const
+{
+  WXSQLITE3_PROFILE();
+  return m_lastRollbackRC;
+}
+
+wxSQLite3TransactionState wxSQLite3Database::QueryTransactionState(const wxString& schemaName) const
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3TransactionState state = WXSQLITE_TRANSACTION_NONE;
+  int txnState;
+  CheckDatabase();
+  if (schemaName.IsEmpty())
+  {
+    txnState = sqlite3_txn_state(m_db->m_db, NULL);
+  }
+  else
+  {
+    wxCharBuffer strSchema = schemaName.ToUTF8();
+    const char* localSchema = strSchema;
+    txnState = sqlite3_txn_state(m_db->m_db, localSchema);
+  }
+  if (txnState < 0)
+  {
+    throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_SCHEMANAME_UNKNOWN);
+  }
+  else
+  {
+    switch (txnState)
+    {
+      case SQLITE_TXN_READ:
+        state = WXSQLITE_TRANSACTION_READ;
+        break;
+      case SQLITE_TXN_WRITE:
+        state = WXSQLITE_TRANSACTION_WRITE;
+        break;
+      case SQLITE_TXN_NONE:
+      default:
+        state = WXSQLITE_TRANSACTION_NONE;
+        break;
+    }
+  }
+  return state;
+}
+
+void wxSQLite3Database::Savepoint(const wxString& savepointName)
+{
+  WXSQLITE3_PROFILE();
+#if SQLITE_VERSION_NUMBER >= 3006008
+  wxString localSavepointName = savepointName;
+  localSavepointName.Replace(wxString(wxS("\"")), wxString(wxS("\"\"")));
+  ExecuteUpdate(wxString(wxS("savepoint \"")) + localSavepointName + wxString(wxS("\"")));
+#else
+  wxUnusedVar(savepointName);
+  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOSAVEPOINT);
+#endif
+}
+
+void wxSQLite3Database::ReleaseSavepoint(const wxString& savepointName)
+{
+  WXSQLITE3_PROFILE();
+#if SQLITE_VERSION_NUMBER >= 3006008
+  wxString localSavepointName = savepointName;
+  localSavepointName.Replace(wxString(wxS("\"")), wxString(wxS("\"\"")));
+  ExecuteUpdate(wxString(wxS("release savepoint \"")) + localSavepointName + wxString(wxS("\"")));
+#else
+  wxUnusedVar(savepointName);
+  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOSAVEPOINT);
+#endif
+}
+
+static bool wxSQLite3IsIdentifierChar(unsigned char c);
+
+static size_t wxSQLite3SkipBlanks(const char* sql, size_t len, size_t i)
+{
+  while (i < len && (sql[i] == ' ' || sql[i] == '\t' || sql[i] == '\n' || sql[i] == '\r' || sql[i] == '\f' || sql[i] == '\v'))
+  {
+    ++i;
+  }
+  return i;
+}
+
+wxString wxSQLite3Database::RewriteArrayParams(const wxString& sql)
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3Utf8Buffer strSql = sql.ToUTF8();
+  const char* localSql = strSql;
+  size_t len = strlen(localSql);
+
+  sqlite3_str* out = sqlite3_str_new(NULL);
+  size_t copied = 0;
+  size_t i = 0;
+  while (i < len)
+  {
+    unsigned char c = (unsigned char) localSql[i];
+    unsigned char next = (i + 1 < len) ? (unsigned char) localSql[i + 1] : 0;
+    if (c == '-' && next == '-')
+    {
+      while (i < len && localSql[i] != '\n') ++i;
+    }
+    else if (c == '/' && next == '*')
+    {
+      i += 2;
+      while (i < len && !(localSql[i] == '*' && i + 1 < len && localSql[i + 1] == '/')) ++i;
+      i = (i + 2 < len) ? i + 2 : len;
+    }
+    else if (c == '\'' || c == '"' || c == '`' || c == '[')
+    {
+      // String literal or quoted identifier; doubled quotes just reopen it
+      char quote = (c == '[') ? ']' : (char) c;
+      ++i;
+      while (i < len && localSql[i] != quote) ++i;
+      if (i < len) ++i;
+    }
+    else if (wxSQLite3IsIdentifierChar(c))
+    {
+      size_t start = i;
+      while (i < len && wxSQLite3IsIdentifierChar((unsigned char) localSql[i])) ++i;
+      if (i - start != 2 || (localSql[start] != 'i' && localSql[start] != 'I') ||
+                            (localSql[start + 1] != 'n' && localSql[start + 1] != 'N'))
+      {
+        continue;
+      }
+
+      // Keyword IN: check for a list consisting of a single parameter
+      size_t pos = wxSQLite3SkipBlanks(localSql, len, i);
+      if (pos >= len || localSql[pos] != '(')
+      {
+        continue;
+      }
+      size_t paramStart = wxSQLite3SkipBlanks(localSql, len, pos + 1);
+      size_t paramEnd = paramStart;
+      if (paramEnd < len && (localSql[paramEnd] == '?' || localSql[paramEnd] == ':' ||
+                             localSql[paramEnd] == '@' || localSql[paramEnd] == '$'))
+      {
+        ++paramEnd;
+        while (paramEnd < len && wxSQLite3IsIdentifierChar((unsigned char) localSql[paramEnd])) ++paramEnd;
+      }
+      if (paramEnd == paramStart || (localSql[paramStart] != '?' && paramEnd == paramStart + 1))
+      {
+        continue;
+      }
+      size_t close = wxSQLite3SkipBlanks(localSql, len, paramEnd);
+      if (close >= len || localSql[close] != ')')
+      {
+        continue;
+      }
+      sqlite3_str_append(out, localSql + copied, (int) (i - copied));
+      sqlite3_str_appendf(out, " carray(%.*s)", (int) (paramEnd - paramStart), localSql + paramStart);
+      i = close + 1;
+      copied = i;
+    }
+    else
+    {
+      ++i;
+    }
+  }
+  sqlite3_str_append(out, localSql + copied, (int) (len - copied));
+  return wxSQLite3FinishString(out);
+}
+
+wxSQLite3Statement wxSQLite3Database::PrepareStatement(const wxString& sql)
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3Utf8Buffer strSql = sql.ToUTF8();
+  const char* localSql = strSql;
+  return PrepareStatement(localSql);
+}
+
+wxSQLite3Statement wxSQLite3Database::PrepareStatement(const wxSQLite3StatementBuffer& sql)
+{
+  WXSQLITE3_PROFILE();
+  return PrepareStatement((const char*) sql);
+}
+
+wxSQLite3Statement wxSQLite3Database::PrepareStatement(const char* sql)
+{
+  WXSQLITE3_PROFILE();
+  return PrepareStatementUtf8(sql, -1, false, false);
+}
+
+wxSQLite3Statement wxSQLite3Database::PreparePersistentStatement(const wxString& sql, bool capturePlan)
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3Utf8Buffer strSql = sql.ToUTF8();
+  const char* localSql = strSql;
+  return PreparePersistentStatement(localSql, capturePlan);
+}
+
+wxSQLite3Statement wxSQLite3Database::PreparePersistentStatement(const wxSQLite3StatementBuffer& sql, bool capturePlan)
+{
+  WXSQLITE3_PROFILE();
+  return PreparePersistentStatement((const char*) sql, capturePlan);
+}
+
+wxSQLite3Statement wxSQLite3Database::PreparePersistentStatement(const char* sql, bool capturePlan)
+{
+  WXSQLITE3_PROFILE();
+  return PrepareStatementUtf8(sql, -1, true, capturePlan);
+}
+
+wxSQLite3Statement wxSQLite3Database::PrepareStatementUtf8(const char* sql, int sqlLen, bool persistent, bool capturePlan)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+#if SQLITE_VERSION_NUMBER >= 3020000
+  sqlite3_stmt* stmt = (sqlite3_stmt*) (persistent ? PreparePersistent(sql, sqlLen) : Prepare(sql, sqlLen));
+#else
+  wxUnusedVar(persistent);
+  sqlite3_stmt* stmt = (sqlite3_stmt*) Prepare(sql, sqlLen);
+#endif
+  wxSQLite3StatementReference* stmtRef = new wxSQLite3StatementReference(stmt);
+  if (capturePlan)
+  {
+    int rc = wxSQLite3ExplainQueryPlan(m_db->m_db, sqlite3_sql(stmt), stmtRef->m_plan);
+    if (rc != SQLITE_OK)
+    {
+      const char* localError = sqlite3_errmsg(m_db->m_db);
+      wxString errmsg = wxString::FromUTF8(localError);
+      sqlite3_finalize(stmt);
+      delete stmtRef;
+      throw wxSQLite3Exception(rc, errmsg);
+    }
+    stmtRef->m_capturePlan = true;
+    stmtRef->m_prepareCount = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_REPREPARE, 0);
+  }
+  return wxSQLite3Statement(m_db, stmtRef);
+}
+
+void wxSQLite3Database::SetPlanChangeListener(wxSQLite3PlanChangeListener* listener)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  m_db->m_planListener = listener;
+}
+
+wxString wxSQLite3Database::GetQueryPlanFingerprint(const wxString& sql)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  wxSQLite3Utf8Buffer strSql = sql.ToUTF8();
+  const char* localSql = strSql;
+  wxString plan;
+  int rc = wxSQLite3ExplainQueryPlan(m_db->m_db, localSql, plan);
+  if (rc != SQLITE_OK)
+  {
+    const char* localError = sqlite3_errmsg(m_db->m_db);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
+  return plan;
+}
+
+bool wxSQLite3Database::TableExists(const wxString& tableName, const wxString& databaseName)
+{
+  WXSQLITE3_PROFILE();
+  wxString sql;
+  if (databaseName.IsEmpty())
+  {
+    sql = wxS("select count(*) from sqlite_master where type='table' and name like ?");
+  }
+  else
+  {
+    sql = wxString(wxS("select count(*) from ")) + databaseName + wxString(wxS(".sqlite_master where type='table' and name like ?"));
+  }
+  wxSQLite3Statement stmt = PrepareStatement(sql);
+  stmt.Bind(1, tableName);
+  wxSQLite3ResultSet resultSet = stmt.ExecuteQuery();
+  long value = 0;
+  resultSet.GetAsString(0).ToLong(&value);
+  return (value > 0);
+}
+
+bool wxSQLite3Database::TableExistsUtf8(const char* tableName, int tableNameLen, const char* databaseName, int databaseNameLen)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  char* sql;
+  if (databaseNameLen <= 0)
+  {
+    sql = sqlite3_mprintf("select count(*) from sqlite_master where type='table' and name like ?");
+  }
+  else
+  {
+    sql = sqlite3_mprintf("select count(*) from %.*s.sqlite_master where type='table' and name like ?", databaseNameLen, databaseName);
+  }
+  if (sql == NULL)
+  {
+    throw wxSQLite3Exception(SQLITE_NOMEM, wxERRMSG_NOMEM);
+  }
+  sqlite3_stmt* stmt;
+  try
+  {
+    stmt = (sqlite3_stmt*) Prepare(sql);
+  }
+  catch (...)
+  {
+    sqlite3_free(sql);
+    throw;
+  }
+  sqlite3_free(sql);
+  sqlite3_bind_text(stmt, 1, tableName, tableNameLen, SQLITE_STATIC);
+  sqlite3_int64 value = 0;
+  int rc = wxSQLite3StepStatement(m_db, stmt);
+  if (rc == SQLITE_ROW)
+  {
+    value = sqlite3_column_int64(stmt, 0);
+    rc = SQLITE_DONE;
+  }
+  if (rc != SQLITE_DONE)
+  {
+    rc = sqlite3_finalize(stmt);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(sqlite3_errmsg(m_db->m_db)));
+  }
+  sqlite3_finalize(stmt);
+  return (value > 0);
+}
+
+bool wxSQLite3Database::TableExists(const wxString& tableName, wxArrayString& databaseNames)
+{
+  WXSQLITE3_PROFILE();
+  wxArrayString databaseList;
+  GetDatabaseList(databaseList);
+
+  bool found = false;
+  size_t count = databaseList.GetCount();
+  if (count > 0)
+  {
+    size_t j;
+    for (j = 0; j < count; j++)
+    {
+      if (TableExists(tableName, databaseList.Item(j)))
+      {
+        found = true;
+        databaseNames.Add(databaseList.Item(j));
+      }
+    }
+  }
+  return found;
+}
+
+void wxSQLite3Database::GetDatabaseList(wxArrayString& databaseNames)
+{
+  WXSQLITE3_PROFILE();
+  databaseNames.Empty();
+  wxSQLite3ResultSet resultSet = ExecuteQuery("PRAGMA database_list;");
+  while (resultSet.NextRow())
+  {
+    databaseNames.Add(resultSet.GetString(1));
+  }
+}
+
+void wxSQLite3Database::GetDatabaseList(wxArrayString& databaseNames, wxArrayString& databaseFiles)
+{
+  WXSQLITE3_PROFILE();
+  databaseNames.Empty();
+  databaseFiles.Empty();
+  wxSQLite3ResultSet resultSet = ExecuteQuery("PRAGMA database_list;");
+  while (resultSet.NextRow())
+  {
+    databaseNames.Add(resultSet.GetString(1));
+    databaseFiles.Add(resultSet.GetString(2));
+  }
+}
+
+wxString wxSQLite3Database::GetDatabaseFilename(const wxString& databaseName)
+{
+  WXSQLITE3_PROFILE();
+#if SQLITE_VERSION_NUMBER >= 3007010
+  CheckDatabase();
+  wxCharBuffer strDatabaseName = databaseName.ToUTF8();
+  const char* localDatabaseName = strDatabaseName;
+  const char* localFilename = sqlite3_db_filename(m_db->m_db, localDatabaseName);
+  return wxString::FromUTF8(localFilename);
+#else
+  wxUnusedVar(databaseName);
+  return wxEmptyString;
+#endif
+}
+
+bool wxSQLite3Database::EnableForeignKeySupport(bool enable)
+{
+  WXSQLITE3_PROFILE();
+  if (enable)
+  {
+    ExecuteUpdate("PRAGMA foreign_keys=ON;");
+  }
+  else
+  {
+    ExecuteUpdate("PRAGMA foreign_keys=OFF;");
+  }
+  bool enabled = IsForeignKeySupportEnabled();
+  return (enable && enabled) || (!enable && !enabled);
+}
+
+bool wxSQLite3Database::IsForeignKeySupportEnabled()
+{
+  WXSQLITE3_PROFILE();
+  bool enabled = false;
+  wxSQLite3ResultSet resultSet = ExecuteQuery("PRAGMA foreign_keys;");
+  if (resultSet.NextRow())
+  {
+    enabled = (resultSet.GetInt(0) == 1);
+  }
+  return enabled;
+}
+
+wxSQLite3JournalMode
+wxSQLite3Database::SetJournalMode(wxSQLite3JournalMode journalMode, const wxString& database)
+{
+  WXSQLITE3_PROFILE();
+  wxString mode = ConvertJournalMode(journalMode);
+  wxString query = wxS("PRAGMA ");
+  if (!database.IsEmpty())
+  {
+    query += database;
+    query += wxS(".");
+  }
+  query += wxS("journal_mode=");
+  query += mode;
+  query += wxS(";");
+  wxSQLite3ResultSet resultSet = ExecuteQuery(query);
+  if (resultSet.NextRow())
+  {
+    mode = resultSet.GetString(0);
+  }
+  return ConvertJournalMode(mode);
+}
+
+wxSQLite3JournalMode
+wxSQLite3Database::GetJournalMode(const wxString& database)
+{
+  WXSQLITE3_PROFILE();
+  wxString mode = wxS("DELETE");
+  wxString query = wxS("PRAGMA ");
+  if (!database.IsEmpty())
+  {
+    query += database;
+    query += wxS(".");
+  }
+  query += wxS("journal_mode;");
+  wxSQLite3ResultSet resultSet = ExecuteQuery(query);
+  if (resultSet.NextRow())
+  {
+    mode = resultSet.GetString(0);
+  }
+  return ConvertJournalMode(mode);
+}
+
+/* static */
+wxString wxSQLite3Database::ConvertJournalMode(wxSQLite3JournalMode mode)
+{
+  WXSQLITE3_PROFILE();
+  wxString journalMode;
+  if      (mode == WXSQLITE_JOURNALMODE_DELETE)   journalMode = wxS("DELETE");
+  else if (mode == WXSQLITE_JOURNALMODE_PERSIST)  journalMode = wxS("PERSIST");
+  else if (mode == WXSQLITE_JOURNALMODE_OFF)      journalMode = wxS("OFF");
+  else if (mode == WXSQLITE_JOURNALMODE_TRUNCATE) journalMode = wxS("TRUNCATE");
+  else if (mode == WXSQLITE_JOURNALMODE_MEMORY)   journalMode = wxS("MEMORY");
+  else if (mode == WXSQLITE_JOURNALMODE_WAL)      journalMode = wxS("WAL");
+  else                                            journalMode = wxS("DELETE");
+  return journalMode;
+}
+
+/* static */
+wxSQLite3JournalMode wxSQLite3Database::ConvertJournalMode(const wxString& mode)
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3JournalMode journalMode;
+  if      (mode.IsSameAs(wxS("DELETE"), false))   journalMode = WXSQLITE_JOURNALMODE_DELETE;
+  else if (mode.IsSameAs(wxS("PERSIST"), false))  journalMode = WXSQLITE_JOURNALMODE_PERSIST;
+  else if (mode.IsSameAs(wxS("OFF"), false))      journalMode = WXSQLITE_JOURNALMODE_OFF;
+  else if (mode.IsSameAs(wxS("TRUNCATE"), false)) journalMode = WXSQLITE_JOURNALMODE_TRUNCATE;
+  else if (mode.IsSameAs(wxS("MEMORY"), false))   journalMode = WXSQLITE_JOURNALMODE_MEMORY;
+  else if (mode.IsSameAs(wxS("WAL"), false))      journalMode = WXSQLITE_JOURNALMODE_WAL;
+  else                                            journalMode = WXSQLITE_JOURNALMODE_DELETE;
+  return journalMode;
+}
+
+bool wxSQLite3Database::CheckSyntax(const wxString& sql) const
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3Utf8Buffer strSql = sql.ToUTF8();
+  const char* localSql = strSql;
+  return CheckSyntax(localSql);
+}
+
+bool wxSQLite3Database::CheckSyntax(const wxSQLite3StatementBuffer& sql) const
+{
+  WXSQLITE3_PROFILE();
+  return CheckSyntax((const char*) sql);
+}
+
+bool wxSQLite3Database::CheckSyntax(const char* sql) const
+{
+  WXSQLITE3_PROFILE();
+  return sqlite3_complete(sql) != 0;
+}
+
+int wxSQLite3Database::ExecuteUpdate(const wxString& sql)
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3Utf8Buffer strSql = sql.ToUTF8();
+  const char* localSql = strSql;
+  return ExecuteUpdate(localSql);
+}
+
+int wxSQLite3Database::ExecuteUpdate(const wxSQLite3StatementBuffer& sql)
+{
+  WXSQLITE3_PROFILE();
+  return ExecuteUpdate((const char*) sql);
+}
+
+int wxSQLite3Database::ExecuteUpdate(const char* sql, bool saveRC)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+
+  char* localError = 0;
+
+  wxSQLite3RecorderScope scope(m_db->m_recorder, "statement", "exec");
+  scope.SetDetail("sql", sql);
+  int rc = wxSQLite3ExecuteUpdate(m_db, sql, &localError);
+  scope.SetArg("rc", rc);
+  if (saveRC)
+  {
+    if (strncmp(sql, "rollback transaction", 20) == 0)
+    {
+      m_lastRollbackRC = rc;
+    }
+  }
+
+  if (rc == SQLITE_OK)
+  {
+    return sqlite3_changes(m_db->m_db);
+  }
+  else
+  {
+    wxString errmsg = wxString::FromUTF8(localError);
+    sqlite3_free(localError);
+    throw wxSQLite3Exception(rc, errmsg);
+  }
+}
+
+wxSQLite3Result wxSQLite3Database::TryExecuteUpdate(const wxString& sql)
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3Utf8Buffer strSql = sql.ToUTF8();
+  const char* localSql = strSql;
+  return TryExecuteUpdate(localSql);
+}
+
+wxSQLite3Result wxSQLite3Database::TryExecuteUpdate(const char* sql)
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3Result result;
+  if (m_db == NULL || m_db->m_db == NULL || !m_db->m_isValid || !m_isOpen)
+  {
+    result.SetError(WXSQLITE_ERROR, wxString(wxERRMSG_NODB).ToUTF8());
+    return result;
+  }
+
+  char* localError = 0;
+
+  wxSQLite3RecorderScope scope(m_db->m_recorder, "statement", "exec");
+  scope.SetDetail("sql", sql);
+  int rc = wxSQLite3ExecuteUpdate(m_db, sql, &localError);
+  scope.SetArg("rc", rc);
+
+  if (rc == SQLITE_OK)
+  {
+    result.m_changes = sqlite3_changes(m_db->m_db);
+  }
+  else
+  {
+    result.SetError(rc, localError);
+    sqlite3_free(localError);
+  }
+  return result;
+}
+
+int wxSQLite3Database::ExecuteUpdateUtf8(const char* sql, int sqlLen)
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3Result result = TryExecuteUpdateUtf8(sql, sqlLen);
+  result.ThrowIfFailed();
+  return result.GetChanges();
+}
+
+wxSQLite3Result wxSQLite3Database::TryExecuteUpdateUtf8(const char* sql, int sqlLen)
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3Result result;
+  if (m_db == NULL || m_db->m_db == NULL || !m_db->m_isValid || !m_isOpen)
+  {
+    result.SetError(WXSQLITE_ERROR, wxString(wxERRMSG_NODB).ToUTF8());
+    return result;
+  }
+
+  // Same as sqlite3_exec, but for SQL text that need not be NUL terminated
+  wxSQLite3RecorderScope scope(m_db->m_recorder, "statement", "exec");
+  int rc = wxSQLite3ExecuteStatements(m_db, sql, sqlLen);
+  scope.SetArg("rc", rc);
+
+  if (rc == SQLITE_OK)
+  {
+    result.m_changes = sqlite3_changes(m_db->m_db);
+  }
+  else
+  {
+    result.SetError(rc, sqlite3_errmsg(m_db->m_db));
+  }
+  return result;
+}
+
+wxSQLite3ResultSet wxSQLite3Database::ExecuteQuery(const wxString& sql)
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3Utf8Buffer strSql = sql.ToUTF8();
+  const char* localSql = strSql;
+  return ExecuteQuery(localSql);
+}
+
+wxSQLite3ResultSet wxSQLite3Database::ExecuteQuery(const wxSQLite3StatementBuffer& sql)
+{
+  WXSQLITE3_PROFILE();
+  return ExecuteQuery((const char*) sql);
+}
+
+wxSQLite3ResultSet wxSQLite3Database::ExecuteQuery(const char* sql)
+{
+  WXSQLITE3_PROFILE();
+  return ExecuteQueryUtf8(sql, -1);
+}
+
+wxSQLite3ResultSet wxSQLite3Database::ExecuteQueryUtf8(const char* sql, int sqlLen)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+
+  sqlite3_stmt* stmt = (sqlite3_stmt*) Prepare(sql, sqlLen);
+
+  int rc = wxSQLite3StepStatement(m_db, stmt);
+
+  if (rc == SQLITE_DONE) // no rows
+  {
+    wxSQLite3StatementReference* stmtRef = new wxSQLite3StatementReference(stmt);
+    return wxSQLite3ResultSet(m_db, stmtRef, true /* eof */);
+  }
+  else if (rc == SQLITE_ROW) // one or more rows
+  {
+    wxSQLite3StatementReference* stmtRef = new wxSQLite3StatementReference(stmt);
+    return wxSQLite3ResultSet(m_db, stmtRef, false /* eof */);
+  }
+  else
+  {
+    rc = sqlite3_finalize(stmt);
+    const char* localError= sqlite3_errmsg(m_db->m_db);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
+}
+
+int wxSQLite3Database::ExecuteScalar(const wxString& sql)
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3Utf8Buffer strSql = sql.ToUTF8();
+  const char* localSql = strSql;
+  return ExecuteScalar(localSql);
+}
+
+int wxSQLite3Database::ExecuteScalar(const wxSQLite3StatementBuffer& sql)
+{
+  WXSQLITE3_PROFILE();
+  return ExecuteScalar((const char*) sql);
+}
+
+int wxSQLite3Database::ExecuteScalar(const char* sql)
+{
+  WXSQLITE3_PROFILE();
+  return ExecuteScalarUtf8(sql, -1);
+}
+
+int wxSQLite3Database::ExecuteScalarUtf8(const char* sql, int sqlLen)
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3ResultSet resultSet = ExecuteQueryUtf8(sql, sqlLen);
+
+  if (resultSet.Eof() || resultSet.GetColumnCount() < 1)
+  {
+    throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_INVALID_QUERY);
+  }
+
+  long value = 0;
+  resultSet.GetAsString(0).ToLong(&value);
+  return (int) value;
+}
+
+wxSQLite3Table wxSQLite3Database::GetTable(const wxString& sql)
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3Utf8Buffer strSql = sql.ToUTF8();
+  const char* localSql = strSql;
+  return GetTable(localSql);
+}
+
+wxSQLite3Table wxSQLite3Database::GetTable(const wxSQLite3StatementBuffer& sql)
+{
+  WXSQLITE3_PROFILE();
+  return GetTable((const char*) sql);
+}
+
+wxSQLite3Table wxSQLite3Database::GetTable(const char* sql)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+
+  char* localError=0;
+  char** results=0;
+  int rc;
+  int rows(0);
+  int cols(0);
+
+  wxSQLite3RecorderScope scope(m_db->m_recorder, "statement", "get_table");
+  scope.SetDetail("sql", sql);
+  rc = sqlite3_get_table(m_db->m_db, sql, &results, &rows, &cols, &localError);
+  scope.SetArg("rows", rows);
+
+  if (rc == SQLITE_OK)
+  {
+    return wxSQLite3Table(results, rows, cols);
+  }
+  else
+  {
+    wxString errmsg = wxString::FromUTF8(localError);
+    sqlite3_free(localError);
+    throw wxSQLite3Exception(rc, errmsg);
+  }
+}
+
+wxLongLong wxSQLite3Database::GetLastRowId() const
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  return wxLongLong(sqlite3_last_insert_rowid(m_db->m_db));
+}
+
+wxSQLite3Blob wxSQLite3Database::GetReadOnlyBlob(wxLongLong rowId,
+                                                 const wxString& columnName,
+                                                 const wxString& tableName,
+                                                 const wxString& dbName)
+{
+  WXSQLITE3_PROFILE();
+  return GetBlob(rowId, columnName, tableName, dbName, false);
+}
+
+wxSQLite3Blob wxSQLite3Database::GetWritableBlob(wxLongLong rowId,
+                                                 const wxString& columnName,
+                                                 const wxString& tableName,
+                                                 const wxString& dbName)
+{
+  WXSQLITE3_PROFILE();
+  return GetBlob(rowId, columnName, tableName, dbName, true);
+}
+
+wxSQLite3Blob wxSQLite3Database::GetBlob(wxLongLong rowId,
+                                         const wxString& columnName,
+                                         const wxString& tableName,
+                                         const wxString& dbName,
+                                         bool writable)
+{
+  WXSQLITE3_PROFILE();
+#if SQLITE_VERSION_NUMBER >= 3004000
+  wxCharBuffer strColumnName = columnName.ToUTF8();
+  const char* localColumnName = strColumnName;
+  wxCharBuffer strTableName = tableName.ToUTF8();
+  const char* localTableName = strTableName;
+  wxCharBuffer strDbName = dbName.ToUTF8();
+  const char* localDbName = (!dbName.IsEmpty()) ? (const char*) strDbName : (const char*) NULL;
+  int flags = (writable) ? 1 : 0;
+  sqlite3_blob* blobHandle;
+  CheckDatabase();
+  int rc = sqlite3_blob_open(m_db->m_db, localDbName, localTableName, localColumnName, rowId.GetValue(), flags, &blobHandle);
+  if (rc != SQLITE_OK)
+  {
+    const char* localError = sqlite3_errmsg(m_db->m_db);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
+  wxSQLite3BlobReference* blobRef = new wxSQLite3BlobReference(blobHandle);
+  return wxSQLite3Blob(m_db, blobRef, writable);
+#else
+  wxUnusedVar(rowId);
+  wxUnusedVar(columnName);
+  wxUnusedVar(tableName);
+  wxUnusedVar(dbName);
+  wxUnusedVar(writable);
+  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOINCBLOB);
+  return NULL;
+#endif
+}
+
+void wxSQLite3Database::Interrupt()
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  sqlite3_interrupt(m_db->m_db);
+}
+
+bool wxSQLite3Database::IsInterrupted()
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  return (sqlite3_is_interrupted(m_db->m_db) != 0);
+}
+
+void wxSQLite3Database::SetBusyTimeout(int nMillisecs)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  m_busyTimeoutMs = nMillisecs;
+  if (m_db->m_recorder != NULL)
+  {
+    // The recording busy handler replaces the built-in busy timeout handler
+    m_db->m_busyTimeoutMs = m_busyTimeoutMs;
+    sqlite3_busy_handler(m_db->m_db, wxSQLite3DatabaseReference::ExecBusyHandler, m_db);
+  }
+  else
+  {
+    sqlite3_busy_timeout(m_db->m_db, m_busyTimeoutMs);
+  }
+}
+
+void wxSQLite3Database::SetLockTimeout(int nMillisecs, bool blockOnConnect)
+{
+  WXSQLITE3_PROFILE();
+#if SQLITE_VERSION_NUMBER >= 3050000
+  CheckDatabase();
+  int rc = sqlite3_setlk_timeout(m_db->m_db, nMillisecs, (blockOnConnect) ? 1 : 0);
+  if (rc != SQLITE_OK)
+  {
+    const char* localError = sqlite3_errmsg(m_db->m_db);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
+#else
+  wxUnusedVar(nMillisecs);
+  wxUnusedVar(blockOnConnect);
+#endif
+}
+
+void wxSQLite3Database::Configure(wxSQLite3DbConfig cfgType, int cfgValue, int& cfgResult)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  int rc = SQLITE_ERROR;
+  int localCfgType = static_cast<int>(cfgType);
+  if (localCfgType >= SQLITE_DBCONFIG_ENABLE_FKEY && localCfgType <= SQLITE_DBCONFIG_ENABLE_COMMENTS)
+  {
+    rc = sqlite3_db_config(m_db->m_db, cfgType, cfgValue, &cfgResult);
+    if (rc != SQLITE_OK)
+    {
+        const char* localError = sqlite3_errmsg(m_db->m_db);
+        throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+    }
+  }
+  else
+  {
+    throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_DBCONFIG_OPTION_UNKNOWN);
+  }
+}
+
+wxString wxSQLite3Database::GetWrapperVersion()
+{
+  return wxString(wxSQLITE3_VERSION_STRING);
+}
+
+wxString wxSQLite3Database::GetMCVersion()
+{
+  WXSQLITE3_PROFILE();
+    return wxString::FromUTF8(sqlite3mc_version());
+}
+
+wxString wxSQLite3Database::GetVersion()
+{
+  WXSQLITE3_PROFILE();
+  return wxString::FromUTF8(sqlite3_libversion());
+}
+
+wxString wxSQLite3Database::GetSourceId()
+{
+  WXSQLITE3_PROFILE();
+#if SQLITE_VERSION_NUMBER >= 3006018
+  return wxString::FromUTF8(sqlite3_sourceid());
+#else
+  return wxEmptyString;
+#endif
+}
+
+bool wxSQLite3Database::CompileOptionUsed(const wxString& optionName)
+{
+  WXSQLITE3_PROFILE();
+#if SQLITE_VERSION_NUMBER >= 3006023
+  wxCharBuffer strOption = optionName.ToUTF8();
+  const char* localOption = strOption;
+  return sqlite3_compileoption_used(localOption) == 1;
+#else
+  return false;
+#endif
+}
+
+wxString wxSQLite3Database::GetCompileOptionName(int optionIndex)
+{
+  WXSQLITE3_PROFILE();
+#if SQLITE_VERSION_NUMBER >= 3006023
+  const char* unknownOption = "";
+  const char* optionName = sqlite3_compileoption_get(optionIndex);
+  if (optionName == NULL)
+  {
+    optionName = unknownOption;
+  }
+  return wxString::FromUTF8(optionName);
+#else
+  return wxEmptyString;
+#endif
+}
+
+bool wxSQLite3Database::CreateFunction(const wxString& funcName, int argCount, wxSQLite3ScalarFunction& function, int functionFlags)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  wxCharBuffer strFuncName = funcName.ToUTF8();
+  const char* localFuncName = strFuncName;
+  int flags = SQLITE_UTF8;
+#if SQLITE_VERSION_NUMBER >= 3008003
+  flags |= functionFlags;
+#endif
+  int rc = sqlite3_create_function(m_db->m_db, localFuncName, argCount,
+                                   flags, &function,
+                                   (void (*)(sqlite3_context*,int,sqlite3_value**)) wxSQLite3FunctionContext::ExecScalarFunction, NULL, NULL);
+  return rc == SQLITE_OK;
+}
+
+bool wxSQLite3Database::CreateFunction(const wxString& funcName, int argCount, wxSQLite3AggregateFunction& function, int functionFlags)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  wxCharBuffer strFuncName = funcName.ToUTF8();
+  const char* localFuncName = strFuncName;
+  int flags = SQLITE_UTF8;
+#if SQLITE_VERSION_NUMBER >= 3008003
+  flags |= functionFlags;
+#endif
+  int rc = sqlite3_create_function(m_db->m_db, localFuncName, argCount,
+                                   flags, &function,
+                                   NULL,
+                                   (void (*)(sqlite3_context*,int,sqlite3_value**)) wxSQLite3FunctionContext::ExecAggregateStep,
+                                   (void (*)(sqlite3_context*)) wxSQLite3FunctionContext::ExecAggregateFinalize);
+  return rc == SQLITE_OK;
+}
+
+bool wxSQLite3Database::CreateFunction(const wxString& funcName, int argCount, wxSQLite3WindowFunction& function, int functionFlags)
+{
+  WXSQLITE3_PROFILE();
+#if SQLITE_VERSION_NUMBER >= 3025000
+  CheckDatabase();
+  wxCharBuffer strFuncName = funcName.ToUTF8();
+  const char* localFuncName = strFuncName;
+  int flags = SQLITE_UTF8 | functionFlags;
+  int rc = sqlite3_create_window_function(m_db->m_db, localFuncName, argCount,
+                                          flags, &function,
+                                          (void(*)(sqlite3_context*, int, sqlite3_value**)) wxSQLite3FunctionContext::ExecWindowStep,
+                                          (void(*)(sqlite3_context*)) wxSQLite3FunctionContext::ExecWindowFinalize,
+                                          (void(*)(sqlite3_context*)) wxSQLite3FunctionContext::ExecWindowValue,
+                                          (void(*)(sqlite3_context*, int, sqlite3_value**)) wxSQLite3FunctionContext::ExecWindowInverse,
+                                          NULL);
+  return rc == SQLITE_OK;
+#else
+  return false;
+#endif
+}
+
+bool wxSQLite3Database::CreateNativeFunction(const wxString& funcName, int argCount, int functionFlags, void* userData,
+                                             void (*xFunc)(void*, int, void**),
+                                             void (*xStep)(void*, int, void**),
+                                             void (*xFinal)(void*),
+                                             void (*xDestroy)(void*))
+{
+  WXSQLITE3_PROFILE();
+  if (m_db == NULL || !m_db->m_isValid)
+  {
+    // SQLite takes ownership of the user data only if the database is valid
+    if (xDestroy != NULL)
+    {
+      xDestroy(userData);
+    }
+    throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NODB);
+  }
+  wxCharBuffer strFuncName = funcName.ToUTF8();
+  const char* localFuncName = strFuncName;
+  int flags = SQLITE_UTF8 | functionFlags;
+  int rc = sqlite3_create_function_v2(m_db->m_db, localFuncName, argCount,
+                                      flags, userData,
+                                      (void (*)(sqlite3_context*,int,sqlite3_value**)) xFunc,
+                                      (void (*)(sqlite3_context*,int,sqlite3_value**)) xStep,
+                                      (void (*)(sqlite3_context*)) xFinal,
+                                      xDestroy);
+  return rc == SQLITE_OK;
+}
+
+bool wxSQLite3Database::SetAuthorizer(wxSQLite3Authorizer& authorizer)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  int rc = sqlite3_set_authorizer(m_db->m_db, (sqlite3_xauth) wxSQLite3FunctionContextExecAuthorizer, &authorizer);
+  return rc == SQLITE_OK;
+}
+
+bool wxSQLite3Database::RemoveAuthorizer()
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  int rc = sqlite3_set_authorizer(m_db->m_db, (sqlite3_xauth) NULL, NULL);
+  return rc == SQLITE_OK;
+}
+
+void wxSQLite3Database::SetCommitHook(wxSQLite3Hook* commitHook)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  m_db->m_commitHook = commitHook;
+  if (m_db->m_changeFeed != NULL)
+  {
+    // The change data capture feed occupies the hook and chains to the user defined hook
+  }
+  else if (commitHook)
+  {
+    sqlite3_commit_hook(m_db->m_db, wxSQLite3DatabaseReference::ExecCommitHook, m_db);
+  }
+  else
+  {
+    sqlite3_commit_hook(m_db->m_db, (int(*)(void*)) NULL, NULL);
+  }
+}
+
+void wxSQLite3Database::SetRollbackHook(wxSQLite3Hook* rollbackHook)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  m_db->m_rollbackHook = rollbackHook;
+  if (m_db->m_changeFeed != NULL)
+  {
+    // The change data capture feed occupies the hook and chains to the user defined hook
+  }
+  else if (rollbackHook)
+  {
+    sqlite3_rollback_hook(m_db->m_db, wxSQLite3DatabaseReference::ExecRollbackHook, m_db);
+  }
+  else
+  {
+    sqlite3_rollback_hook(m_db->m_db, (void(*)(void*)) NULL, NULL);
+  }
+}
+
+void wxSQLite3Database::SetUpdateHook(wxSQLite3Hook* updateHook)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  m_db->m_updateHook = updateHook;
+  if (updateHook)
+  {
+    sqlite3_update_hook(m_db->m_db, wxSQLite3DatabaseReference::ExecUpdateHook, m_db);
+  }
+  else
+  {
+    sqlite3_update_hook(m_db->m_db, (void(*)(void*,int,const char*,const char*, wxsqlite_int64)) NULL, NULL);
+  }
+}
+
+void wxSQLite3Database::SetWriteAheadLogHook(wxSQLite3Hook* walHook)
+{
+  WXSQLITE3_PROFILE();
+#if SQLITE_VERSION_NUMBER >= 3007000
+  CheckDatabase();
+  m_db->m_walHook = walHook;
+  if (walHook)
+  {
+    walHook->SetDatabase(this);
+    sqlite3_wal_hook(m_db->m_db, wxSQLite3DatabaseReference::ExecWriteAheadLogHook, m_db);
+  }
+  else
+  {
+    sqlite3_wal_hook(m_db->m_db, (int(*)(void *,sqlite3*,const char*,int)) NULL, NULL);
+  }
+#else
+  wxUnusedVar(walHook);
+  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOWAL);
+#endif
+}
+
+void wxSQLite3Database::WriteAheadLogCheckpoint(const wxString& database, int mode, 
+                                                int* logFrameCount, int* ckptFrameCount)
+{
+  WXSQLITE3_PROFILE();
+#if SQLITE_VERSION_NUMBER >= 3007000
+  CheckDatabase();
+  wxCharBuffer strDatabase = database.ToUTF8();
+  const char* localDatabase = strDatabase;
+  wxSQLite3RecorderScope scope(m_db->m_recorder, "wal", "checkpoint");
+  scope.SetDetail("database", localDatabase);
+#if SQLITE_VERSION_NUMBER >= 3007006
+  int rc = sqlite3_wal_checkpoint_v2(m_db->m_db, localDatabase, mode, logFrameCount, ckptFrameCount);
+#else
+  int rc = sqlite3_wal_checkpoint(m_db->m_db, localDatabase);
+  if (logFrameCount  != NULL) *logFrameCount  = 0;
+  if (ckptFrameCount != NULL) *ckptFrameCount = 0;
+#endif
+  scope.SetArg("rc", rc);
+
+  if (rc != SQLITE_OK)
+  {
+    const char* localError = sqlite3_errmsg(m_db->m_db);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
+#else
+  wxUnusedVar(database);
+  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOWAL);
+#endif
+}
+
+void wxSQLite3Database::AutoWriteAheadLogCheckpoint(int frameCount)
+{
+  WXSQLITE3_PROFILE();
+#if SQLITE_VERSION_NUMBER >= 3007000
+  CheckDatabase();
+  int rc = sqlite3_wal_autocheckpoint(m_db->m_db, frameCount);
+
+  if (rc != SQLITE_OK)
+  {
+    const char* localError = sqlite3_errmsg(m_db->m_db);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
+#else
+  wxUnusedVar(frameCount);
+  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOWAL);
+#endif
+}
+
+void wxSQLite3Database::SetCollation(const wxString& collationName, wxSQLite3Collation* collation)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  wxCharBuffer strCollationName = collationName.ToUTF8();
+  const char* localCollationName = strCollationName;
+  int rc;
+  if (collation)
+  {
+    rc = sqlite3_create_collation(m_db->m_db, localCollationName, SQLITE_UTF8, collation, (int(*)(void*,int,const void*,int,const void*)) wxSQLite3Database::ExecComparisonWithCollation);
+  }
+  else
+  {
+    rc = sqlite3_create_collation(m_db->m_db, localCollationName, SQLITE_UTF8, NULL, (int(*)(void*,int,const void*,int,const void*)) NULL);
+  }
+}
+
+void wxSQLite3Database::SetUtf8Collation(const wxString& collationName, wxSQLite3Utf8Collation* collation)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  wxCharBuffer strCollationName = collationName.ToUTF8();
+  const char* localCollationName = strCollationName;
+  int rc;
+  if (collation)
+  {
+    rc = sqlite3_create_collation(m_db->m_db, localCollationName, SQLITE_UTF8, collation, (int(*)(void*,int,const void*,int,const void*)) wxSQLite3Database::ExecUtf8Comparison);
+  }
+  else
+  {
+    rc = sqlite3_create_collation(m_db->m_db, localCollationName, SQLITE_UTF8, NULL, (int(*)(void*,int,const void*,int,const void*)) NULL);
+  }
+  if (rc != SQLITE_OK)
+  {
+    const char* localError = sqlite3_errmsg(m_db->m_db);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
+}
+
+bool wxSQLite3Database::CreateSortKeyFunction(const wxString& funcName, wxSQLite3SortKeyCollation* collation)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  return CreateNativeFunction(funcName, 1, WXSQLITE_DETERMINISTIC, collation,
+                              wxSQLite3Database::ExecSortKeyFunction, NULL, NULL, NULL);
+}
+
+void* wxSQLite3Database::GetDatabaseHandle() const
+{
+  WXSQLITE3_PROFILE();
+  return (m_db != NULL) ? m_db->m_db : NULL;
+}
+
+void wxSQLite3Database::SetCollationNeededCallback()
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  int rc = sqlite3_collation_needed(m_db->m_db, this, (void(*)(void*,sqlite3*,int,const char*)) wxSQLite3Database::ExecCollationNeeded);
+  if (rc != SQLITE_OK)
+  {
+    const char* localError = sqlite3_errmsg(m_db->m_db);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
+}
+
+void wxSQLite3Database::CheckDatabase() const
+{
+  WXSQLITE3_PROFILE();
+  if (m_db == NULL || m_db->m_db == NULL || !m_db->m_isValid || !m_isOpen)
+  {
+    throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NODB);
+  }
+}
+
+void* wxSQLite3Database::Prepare(const char* sql, int sqlLen)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+
+  const char* tail=0;
+  sqlite3_stmt* stmt = NULL;
+
+  wxSQLite3RecorderScope scope(m_db->m_recorder, "statement", "prepare");
+  if (sqlLen < 0)
+  {
+    scope.SetDetail("sql", sql);
+  }
+  int rc = sqlite3_prepare_v2(m_db->m_db, sql, sqlLen, &stmt, &tail);
+  scope.SetArg("rc", rc);
+  if (sqlLen >= 0 && stmt != NULL)
+  {
+    // The text of known length need not be NUL terminated
+    scope.SetDetail("sql", sqlite3_sql(stmt));
+  }
+
+  if (rc != SQLITE_OK)
+  {
+    const char* localError = sqlite3_errmsg(m_db->m_db);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
+
+  return stmt;
+}
+
+void* wxSQLite3Database::PreparePersistent(const char* sql, int sqlLen)
+{
+  WXSQLITE3_PROFILE();
+#if SQLITE_VERSION_NUMBER >= 3020000
+  CheckDatabase();
+
+  const char* tail = 0;
+  sqlite3_stmt* stmt = NULL;
+
+  wxSQLite3RecorderScope scope(m_db->m_recorder, "statement", "prepare");
+  if (sqlLen < 0)
+  {
+    scope.SetDetail("sql", sql);
+  }
+  int rc = sqlite3_prepare_v3(m_db->m_db, sql, sqlLen, SQLITE_PREPARE_PERSISTENT, &stmt, &tail);
+  scope.SetArg("rc", rc);
+  if (sqlLen >= 0 && stmt != NULL)
+  {
+    // The text of known length need not be NUL terminated
+    scope.SetDetail("sql", sqlite3_sql(stmt));
+  }
+
+  if (rc != SQLITE_OK)
+  {
+    const char* localError = sqlite3_errmsg(m_db->m_db);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
+
+  return stmt;
+#else
+  return Prepare(sql, sqlLen);
+#endif
+}
+
+/* static */
+int wxSQLite3Database::ExecComparisonWithCollation(void* collation,
+                                                   int len1, const void* text1,
+                                                   int len2, const void* text2)
+{
+  WXSQLITE3_PROFILE();
+  wxString locText1 = wxString::FromUTF8((const char*) text1, (size_t) len1);
+  wxString locText2 = wxString::FromUTF8((const char*) text2, (size_t) len2);
+  return ((wxSQLite3Collation*) collation)->Compare(locText1, locText2);
+}
+
+/* static */
+int wxSQLite3Database::ExecUtf8Comparison(void* collation,
+                                          int len1, const void* text1,
+                                          int len2, const void* text2)
+{
+  WXSQLITE3_PROFILE();
+  return ((wxSQLite3Utf8Collation*) collation)->Compare((const char*) text1, (size_t) len1, (const char*) text2, (size_t) len2);
+}
+
+/* static */
+void wxSQLite3Database::ExecSortKeyFunction(void* ctx, int WXUNUSED(argc), void** argv)
+{
+  WXSQLITE3_PROFILE();
+  sqlite3_context* context = (sqlite3_context*) ctx;
+  sqlite3_value* arg = ((sqlite3_value**) argv)[0];
+  if (sqlite3_value_type(arg) == SQLITE_NULL)
+  {
+    sqlite3_result_null(context);
+    return;
+  }
+  const char* text = (const char*) sqlite3_value_text(arg);
+  size_t len = (size_t) sqlite3_value_bytes(arg);
+  wxSQLite3SortKeyCollation* collation = (wxSQLite3SortKeyCollation*) sqlite3_user_data(context);
+  wxMemoryBuffer sortKey;
+  collation->GenerateSortKey((text != NULL) ? text : "", len, sortKey);
+  sqlite3_result_blob(context, sortKey.GetData(), (int) sortKey.GetDataLen(), SQLITE_TRANSIENT);
+}
+
+void wxSQLite3Database::ExecCollationNeeded(void* db, void*, int, const char* collationName)
+{
+  WXSQLITE3_PROFILE();
+  wxString locCollation = wxString::FromUTF8((const char*) collationName);
+  ((wxSQLite3Database*) db)->SetNeededCollation(locCollation);
+}
+
+void wxSQLite3Database::GetMetaData(const wxString& databaseName, const wxString& tableName, const wxString& columnName,
+                                    wxString* dataType, wxString* collation, bool* notNull, bool* primaryKey, bool* autoIncrement)
+{
+  WXSQLITE3_PROFILE();
+#if SQLITE_ENABLE_COLUMN_METADATA
+  CheckDatabase();
+  wxCharBuffer strDatabaseName = databaseName.ToUTF8();
+  const char* localDatabaseName = strDatabaseName;
+  if (databaseName == wxEmptyString) localDatabaseName = NULL;
+  wxCharBuffer strTableName = tableName.ToUTF8();
+  const char* localTableName = strTableName;
+  wxCharBuffer strColumnName = columnName.ToUTF8();
+  const char* localColumnName = strColumnName;
+  const char* localDataType;
+  const char* localCollation;
+  int localNotNull;
+  int localPrimaryKey;
+  int localAutoIncrement;
+  int rc = sqlite3_table_column_metadata(m_db->m_db, localDatabaseName, localTableName, localColumnName,
+                                         &localDataType, &localCollation, &localNotNull, &localPrimaryKey, &localAutoIncrement);
+
+  if (rc != SQLITE_OK)
+  {
+    const char* localError = sqlite3_errmsg(m_db->m_db);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
+
+  if (dataType      != NULL) *dataType      = wxString::FromUTF8(localDataType);
+  if (collation     != NULL) *collation     = wxString::FromUTF8(localCollation);
+
+  if (notNull       != NULL) *notNull       = (localNotNull       != 0);
+  if (primaryKey    != NULL) *primaryKey    = (localPrimaryKey    != 0);
+  if (autoIncrement != NULL) *autoIncrement = (localAutoIncrement != 0);
+#else
+  wxUnusedVar(databaseName);
+  wxUnusedVar(tableName);
+  wxUnusedVar(columnName);
+  wxUnusedVar(dataType);
+  wxUnusedVar(collation);
+  wxUnusedVar(notNull);
+  wxUnusedVar(primaryKey);
+  wxUnusedVar(autoIncrement);
+  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOMETADATA);
+#endif
+}
+
+void wxSQLite3Database::LoadExtension(const wxString& fileName, const wxString& entryPoint)
+{
+  WXSQLITE3_PROFILE();
+#if WXSQLITE3_HAVE_LOAD_EXTENSION
+  CheckDatabase();
+  wxCharBuffer strFileName = fileName.ToUTF8();
+  const char* localFileName = strFileName;
+  wxCharBuffer strEntryPoint = entryPoint.ToUTF8();
+  const char* localEntryPoint = strEntryPoint;
+
+  int rc = sqlite3_load_extension(m_db->m_db, localFileName, localEntryPoint, NULL);
+  if (rc != SQLITE_OK)
+  {
+    const char* localError = sqlite3_errmsg(m_db->m_db);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
+#else
+  wxUnusedVar(fileName);
+  wxUnusedVar(entryPoint);
+  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOLOADEXT);
+#endif
+}
+
+void wxSQLite3Database::EnableLoadExtension(bool enable)
+{
+  WXSQLITE3_PROFILE();
+#if WXSQLITE3_HAVE_LOAD_EXTENSION
+  CheckDatabase();
+  int onoff = (enable) ? 1 : 0;
+  int rc = sqlite3_enable_load_extension(m_db->m_db, onoff);
+  if (rc != SQLITE_OK)
+  {
+    const char* localError = sqlite3_errmsg(m_db->m_db);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
+#else
+  wxUnusedVar(enable);
+  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOLOADEXT);
+#endif
+}
+
+void wxSQLite3Database::ReKey(const wxString& newKey)
+{
+  WXSQLITE3_PROFILE();
+  ReKey(wxSQLite3Cipher(), newKey);
+}
+
+void wxSQLite3Database::ReKey(const wxSQLite3Cipher& cipher, const wxString& newKey)
+{
+  WXSQLITE3_PROFILE();
+  wxCharBuffer strLocalNewKey = newKey.ToUTF8();
+  const char* localNewKey = strLocalNewKey;
+  wxMemoryBuffer binaryNewKey;
+  if (newKey.Length() > 0)
+  {
+    binaryNewKey.AppendData((void*) localNewKey, strlen(localNewKey));
+  }
+  ReKey(cipher, binaryNewKey);
+}
+
+void wxSQLite3Database::ReKey(const wxMemoryBuffer& newKey)
+{
+  WXSQLITE3_PROFILE();
+  ReKey(wxSQLite3Cipher(), newKey);
+}
+
+void wxSQLite3Database::ReKey(const wxSQLite3Cipher& cipher, const wxMemoryBuffer& newKey)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  if (cipher.IsOk())
+  {
+    if (!cipher.Apply(m_db->m_db))
+    {
+      throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_CIPHER_APPLY_FAILED);
+    }
+  }
+  int rc = sqlite3_rekey(m_db->m_db, newKey.GetData(), (int) newKey.GetDataLen());
+  if (rc != SQLITE_OK)
+  {
+    const char* localError = sqlite3_errmsg(m_db->m_db);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
+}
+
+wxString wxSQLite3Database::GetKeySalt(const wxString& schemaName) const
+{
+  WXSQLITE3_PROFILE();
+  wxString keySalt = wxEmptyString;
+  if (IsOpen())
+  {
+    const char* localSchemaName = NULL;
+    wxCharBuffer strSchema = schemaName.ToUTF8();
+    if (!schemaName.IsEmpty())
+    {
+      localSchemaName = strSchema;
+    }
+    char* localKeySalt = (char*) sqlite3mc_codec_data(m_db->m_db, localSchemaName, "cipher_salt");
+    if (localKeySalt != NULL)
+    {
+      keySalt = wxString::FromUTF8(localKeySalt);
+      sqlite3_free(localKeySalt);
+    }
+  }
+  return keySalt;
+}
+
+bool wxSQLite3Database::UserLogin(const wxString& username, const wxString& password)
+{
+  WXSQLITE3_PROFILE();
+  wxUnusedVar(username);
+  wxUnusedVar(password);
+  return true;
+}
+
+bool wxSQLite3Database::UserAdd(const wxString& username, const wxString& password, bool isAdmin)
+{
+  WXSQLITE3_PROFILE();
+  wxUnusedVar(username);
+  wxUnusedVar(password);
+  wxUnusedVar(isAdmin);
+  return true;
+}
+
+bool wxSQLite3Database::UserChange(const wxString& username, const wxString& password, bool isAdmin)
+{
+  WXSQLITE3_PROFILE();
+  wxUnusedVar(username);
+  wxUnusedVar(password);
+  wxUnusedVar(isAdmin);
+  return false;
+}
+
+bool wxSQLite3Database::UserDelete(const wxString& username)
+{
+  WXSQLITE3_PROFILE();
+  wxUnusedVar(username);
+  return false;
+}
+
+bool wxSQLite3Database::UserIsPrivileged(const wxString& username)
+{
+  WXSQLITE3_PROFILE();
+  wxUnusedVar(username);
+  return false;
+}
+
+void wxSQLite3Database::GetUserList(wxArrayString& userList)
+{
+  WXSQLITE3_PROFILE();
+  userList.Empty();
+}
+
+int wxSQLite3Database::GetLimit(wxSQLite3LimitType id) const
+{
+  WXSQLITE3_PROFILE();
+  int value = -1;
+  CheckDatabase();
+  if (id >= WXSQLITE_LIMIT_LENGTH && id <= WXSQLITE_LIMIT_WORKER_THREADS)
+  {
+    value = sqlite3_limit(m_db->m_db, id, -1);
+  }
+  return value;
+}
+
+int wxSQLite3Database::SetLimit(wxSQLite3LimitType id, int newValue)
+{
+  WXSQLITE3_PROFILE();
+  int value = -1;
+  CheckDatabase();
+  if (id >= WXSQLITE_LIMIT_LENGTH && id <= WXSQLITE_LIMIT_WORKER_THREADS)
+  {
+    value = sqlite3_limit(m_db->m_db, id, newValue);
+  }
+  return value;
+}
+
+void wxSQLite3Database::ReleaseMemory()
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  int rc = sqlite3_db_release_memory(m_db->m_db);
+  if (rc != SQLITE_OK)
+  {
+    const char* localError = sqlite3_errmsg(m_db->m_db);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
+}
+
+int wxSQLite3Database::GetSystemErrorCode() const
+{
+  WXSQLITE3_PROFILE();
+  int rc = 0;
+  if (m_db != NULL)
+  {
+    rc = sqlite3_system_errno(m_db->m_db);
+  }
+  return rc;
+}
+
+#if wxCHECK_VERSION(2,9,0)
+static const wxStringCharType* limitCodeString[] =
+#else
+static const wxChar* limitCodeString[] =
+#endif
+{ wxS("SQLITE_LIMIT_LENGTH"),              wxS("SQLITE_LIMIT_SQL_LENGTH"),
+  wxS("SQLITE_LIMIT_COLUMN"),              wxS("SQLITE_LIMIT_EXPR_DEPTH"),
+  wxS("SQLITE_LIMIT_COMPOUND_SELECT"),     wxS("SQLITE_LIMIT_VDBE_OP"),
+  wxS("SQLITE_LIMIT_FUNCTION_ARG"),        wxS("SQLITE_LIMIT_ATTACHED"),
+  wxS("SQLITE_LIMIT_LIKE_PATTERN_LENGTH"), wxS("SQLITE_LIMIT_VARIABLE_NUMBER"),
+  wxS("SQLITE_LIMIT_TRIGGER_DEPTH"),       wxS("SQLITE_LIMIT_WORKER_THREADS")
+};
+
+
+/* static */
+wxString wxSQLite3Database::LimitTypeToString(wxSQLite3LimitType type)
+{
+  WXSQLITE3_PROFILE();
+  wxString limitString(wxS("Unknown"));
+  if (type >= WXSQLITE_LIMIT_LENGTH && type <= WXSQLITE_LIMIT_WORKER_THREADS)
+  {
+    limitString = limitCodeString[type];
+  }
+  return limitString;
+}
+
+/* static */
+void wxSQLite3Database::InitializeSQLite()
+{
+  WXSQLITE3_PROFILE();
+  int rc = sqlite3_initialize();
+  if (rc != SQLITE_OK)
+  {
+    throw wxSQLite3Exception(rc, wxERRMSG_INITIALIZE);
+  }
+}
+
+/* static */
+void wxSQLite3Database::InitializeSQLite(const wxSQLite3Logger& logger)
+{
+  WXSQLITE3_PROFILE();
+  int rc = sqlite3_config(SQLITE_CONFIG_LOG, wxSQLite3Logger::ExecLoggerHook, &logger);
+  if (rc == SQLITE_OK)
+  {
+    InitializeSQLite();
+  }
+  else
+  {
+    throw wxSQLite3Exception(rc, wxERRMSG_INITIALIZE);
+  }
+}
+
+/* static */
+void wxSQLite3Database::ShutdownSQLite()
+{
+  WXSQLITE3_PROFILE();
+  int rc = sqlite3_shutdown();
+  if (rc != SQLITE_OK)
+  {
+    throw wxSQLite3Exception(rc, wxERRMSG_SHUTDOWN);
+  }
+}
+
+/* static */
+bool wxSQLite3Database::SetTemporaryDirectory(const wxString& tempDirectory)
+{
+  WXSQLITE3_PROFILE();
+  bool ok = false;
+#if defined(__WXMSW__)
+#if wxUSE_UNICODE
+  const wxChar* zValue = tempDirectory.wc_str();
+#else
+  const wxWCharBuffer zValue = tempDirectory.wc_str(wxConvLocal);
+#endif
+  int rc = sqlite3_win32_set_directory(SQLITE_WIN32_TEMP_DIRECTORY_TYPE, (void*) zValue);
+  ok = (rc == SQLITE_OK);
+#endif
+  return ok;
+}
+
+/* static */
+bool wxSQLite3Database::Randomness(int n, wxMemoryBuffer& random)
+{
+  WXSQLITE3_PROFILE();
+  bool ok = false;
+  if (n > 0)
+  {
+    void* buffer = random.GetWriteBuf(n);
+    sqlite3_randomness(n, buffer);
+    random.UngetWriteBuf(n);
+    ok = true;
+  }
+  return ok;
+}
+
+// ----------------------------------------------------------------------------
+// wxSQLite3FunctionContext: class providing the function context
+//                           for user defined functions
+// ----------------------------------------------------------------------------
+
+int wxSQLite3FunctionContext::GetArgCount() const
+{
+  WXSQLITE3_PROFILE();
+  return m_argc;
+}
+
+int wxSQLite3FunctionContext::GetArgType(int argIndex) const
+{
+  WXSQLITE3_PROFILE();
+  if (argIndex >= 0 && argIndex < m_argc)
+  {
+    return sqlite3_value_type((sqlite3_value*) m_argv[argIndex]);
+  }
+  else
+  {
+    return SQLITE_NULL;
+  }
+}
+
+bool wxSQLite3FunctionContext::IsNull(int argIndex) const
+{
+  WXSQLITE3_PROFILE();
+  if (argIndex >= 0 && argIndex < m_argc)
+  {
+    return sqlite3_value_type((sqlite3_value*) m_argv[argIndex]) == SQLITE_NULL;
+  }
+  else
+  {
+    return true;
+  }
+}
+
+int wxSQLite3FunctionContext::GetInt(int argIndex, int nullValue) const
+{
+  WXSQLITE3_PROFILE();
+  if (argIndex >= 0 && argIndex < m_argc)
+  {
+    if (!IsNull(argIndex))
+    {
+      return sqlite3_value_int((sqlite3_value*) m_argv[argIndex]);
+    }
+    else
+    {
+      return nullValue;
+    }
+  }
+  else
+  {
+    return nullValue;
+  }
+}
+
+wxLongLong wxSQLite3FunctionContext::GetInt64(int argIndex, wxLongLong nullValue) const
+{
+  WXSQLITE3_PROFILE();
+  if (argIndex >= 0 && argIndex < m_argc)
+  {
+    if (!IsNull(argIndex))
+    {
+      return wxLongLong(sqlite3_value_int64((sqlite3_value*) m_argv[argIndex]));
+    }
+    else
+    {
+      return nullValue;
+    }
+  }
+  else
+  {
+    return nullValue;
+  }
+}
+
+double wxSQLite3FunctionContext::GetDouble(int argIndex, double nullValue) const
+{
+  WXSQLITE3_PROFILE();
+  if (argIndex >= 0 && argIndex < m_argc)
+  {
+    if (!IsNull(argIndex))
+    {
+      return sqlite3_value_double((sqlite3_value*) m_argv[argIndex]);
+    }
+    else
+    {
+      return nullValue;
+    }
+  }
+  else
+  {
+    return nullValue;
+  }
+}
+
+wxString wxSQLite3FunctionContext::GetString(int argIndex, const wxString& nullValue) const
+{
+  WXSQLITE3_PROFILE();
+  if (argIndex >= 0 && argIndex < m_argc)
+  {
+    if (!IsNull(argIndex))
+    {
+      const char* localValue = (const char*) sqlite3_value_text((sqlite3_value*) m_argv[argIndex]);
+      return wxString::FromUTF8(localValue);
+    }
+    else
+    {
+      return nullValue;
+    }
+  }
+  else
+  {
+    return nullValue;
+  }
+}
+
+const unsigned char* wxSQLite3FunctionContext::GetBlob(int argIndex, int& len) const
+{
+  WXSQLITE3_PROFILE();
+  const unsigned char* buffer = NULL;
+  if (argIndex >= 0 && argIndex < m_argc)
+  {
+    if (!IsNull(argIndex))
+    {
+      len = sqlite3_value_bytes((sqlite3_value*) m_argv[argIndex]);
+      buffer = (const unsigned char*) sqlite3_value_blob((sqlite3_value*) m_argv[argIndex]);
+    }
+  }
+  return buffer;
+}
+
+wxMemoryBuffer& wxSQLite3FunctionContext::GetBlob(int argIndex, wxMemoryBuffer& buffer) const
+{
+  WXSQLITE3_PROFILE();
+  if (argIndex >= 0 && argIndex < m_argc)
+  {
+    if (!IsNull(argIndex))
+    {
+      int len = sqlite3_value_bytes((sqlite3_value*) m_argv[argIndex]);
+      const void* blob = sqlite3_value_blob((sqlite3_value*) m_argv[argIndex]);
+      buffer.AppendData((void*) blob, (size_t) len);
+    }
+  }
+  return buffer;
+}
+
+const char* wxSQLite3FunctionContext::GetText(int argIndex, int& len) const
+{
+  WXSQLITE3_PROFILE();
+  const char* text = NULL;
+  len = 0;
+  if (argIndex >= 0 && argIndex < m_argc)
+  {
+    if (!IsNull(argIndex))
+    {
+      // sqlite3_value_text must be called before sqlite3_value_bytes
+      text = (const char*) sqlite3_value_text((sqlite3_value*) m_argv[argIndex]);
+      len = sqlite3_value_bytes((sqlite3_value*) m_argv[argIndex]);
+    }
+  }
+  return text;
+}
+
+void* wxSQLite3FunctionContext::GetAuxData(int argIndex) const
+{
+  WXSQLITE3_PROFILE();
+  return sqlite3_get_auxdata((sqlite3_context*) m_ctx, argIndex);
+}
+
+void wxSQLite3FunctionContext::SetAuxData(int argIndex, void* auxData, void(*DeleteAuxData)(void*))
+{
+  WXSQLITE3_PROFILE();
+  sqlite3_set_auxdata((sqlite3_context*) m_ctx, argIndex, auxData, DeleteAuxData);
+}
+
+void* wxSQLite3FunctionContext::GetPointer(int argIndex, const wxString& pointerType) const
+{
+  WXSQLITE3_PROFILE();
+  void* pointer = NULL;
+#if SQLITE_VERSION_NUMBER >= 3020000
+  if (argIndex >= 0 && argIndex < m_argc)
+  {
+    if (!IsNull(argIndex))
+    {
+      wxCharBuffer strPointerType = pointerType.ToUTF8();
+      const char* localPointerType = strPointerType;
+
+      pointer = sqlite3_value_pointer((sqlite3_value*) m_argv[argIndex], localPointerType);
+    }
+  }
+#endif
+  return pointer;
+}
+
+void wxSQLite3FunctionContext::SetResult(int value)
+{
+  WXSQLITE3_PROFILE();
+  sqlite3_result_int((sqlite3_context*) m_ctx, value);
+}
+
+void wxSQLite3FunctionContext::SetResult(wxLongLong value)
+{
+  WXSQLITE3_PROFILE();
+  sqlite3_result_int64((sqlite3_context*) m_ctx, value.GetValue());
+}
+
+void wxSQLite3FunctionContext::SetResult(double value)
+{
+  WXSQLITE3_PROFILE();
+  sqlite3_result_double((sqlite3_context*) m_ctx, value);
+}
+
+void wxSQLite3FunctionContext::SetResult(const wxString& value)
+{
+  WXSQLITE3_PROFILE();
+  wxCharBuffer strValue = value.ToUTF8();
+  const char* localValue = strValue;
+  sqlite3_result_text((sqlite3_context*) m_ctx, localValue, -1, SQLITE_TRANSIENT);
+}
+
+void wxSQLite3FunctionContext::SetResult(unsigned char* value, int len)
+{
+  WXSQLITE3_PROFILE();
+  sqlite3_result_blob((sqlite3_context*) m_ctx, value, len, SQLITE_TRANSIENT);
+}
+
+void wxSQLite3FunctionContext::SetResult(const wxMemoryBuffer& buffer)
+{
+  WXSQLITE3_PROFILE();
+  sqlite3_result_blob((sqlite3_context*) m_ctx, buffer.GetData(), (int) buffer.GetDataLen(), SQLITE_TRANSIENT);
+}
+
+void wxSQLite3FunctionContext::SetResult(void* pointer, const wxString& pointerType, void(*DeletePointer)(void*))
+{
+  WXSQLITE3_PROFILE();
+#if SQLITE_VERSION_NUMBER >= 3020000
+  const char* localPointerType = MakePointerTypeCopy(pointerType);
+  sqlite3_result_pointer((sqlite3_context*) m_ctx, pointer, localPointerType, DeletePointer);
+#endif
+}
+
+void wxSQLite3FunctionContext::SetResultNull()
+{
+  WXSQLITE3_PROFILE();
+  sqlite3_result_null((sqlite3_context*) m_ctx);
+}
+
+void wxSQLite3FunctionContext::SetResultZeroBlob(int blobSize)
+{
+  WXSQLITE3_PROFILE();
+#if SQLITE_VERSION_NUMBER >= 3004000
+  sqlite3_result_zeroblob((sqlite3_context*) m_ctx, blobSize);
+#endif
+}
+
+void wxSQLite3FunctionContext::SetResultArg(int argIndex)
+{
+  WXSQLITE3_PROFILE();
+  if (argIndex >= 0 && argIndex < m_argc) {
+    sqlite3_result_value((sqlite3_context*) m_ctx, (sqlite3_value*) m_argv[argIndex]);
+  } else {
+    sqlite3_result_null((sqlite3_context*) m_ctx);
+  }
+}
+
+void wxSQLite3FunctionContext::SetResultError(const wxString& errmsg)
+{
+  WXSQLITE3_PROFILE();
+  wxCharBuffer strErrmsg = errmsg.ToUTF8();
+  const char* localErrmsg = strErrmsg;
+  sqlite3_result_error((sqlite3_context*) m_ctx, localErrmsg, -1);
+}
+
+int wxSQLite3FunctionContext::GetAggregateCount() const
+{
+  WXSQLITE3_PROFILE();
+  if (m_isAggregate)
+  {
+    return m_count;
+  }
+  else
+  {
+    return 0;
+  }
+}
+
+void* wxSQLite3FunctionContext::GetAggregateStruct(int len) const
+{
+  WXSQLITE3_PROFILE();
+  if (m_isAggregate)
+  {
+    return sqlite3_aggregate_context((sqlite3_context*) m_ctx, len);
+  }
+  else
+  {
+    return NULL;
+  }
+}
+
+/* static */
+void wxSQLite3FunctionContext::ExecScalarFunction(void* ctx, int argc, void** argv)
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3FunctionContext context(ctx, false, argc, argv);
+  wxSQLite3ScalarFunction* func = (wxSQLite3ScalarFunction*) sqlite3_user_data((sqlite3_context*) ctx);
+  func->Execute(context);
+}
+
+/* static */
+void wxSQLite3FunctionContext::ExecAggregateStep(void* ctx, int argc, void** argv)
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3FunctionContext context(ctx, true, argc, argv);
+  wxSQLite3AggregateFunction* func = (wxSQLite3AggregateFunction*) sqlite3_user_data((sqlite3_context*) ctx);
+  func->m_count++;
+  context.m_count = func->m_count;
+  func->Aggregate(context);
+}
+
+/* static */
+void wxSQLite3FunctionContext::ExecAggregateFinalize(void* ctx)
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3FunctionContext context(ctx, true, 0, NULL);
+  wxSQLite3AggregateFunction* func = (wxSQLite3AggregateFunction*) sqlite3_user_data((sqlite3_context*) ctx);
+  context.m_count = func->m_count;
+  func->Finalize(context);
+}
+
+/* static */
+void wxSQLite3FunctionContext::ExecWindowStep(void* ctx, int argc, void** argv)
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3FunctionContext context(ctx, true, argc, argv);
+  wxSQLite3WindowFunction* func = (wxSQLite3WindowFunction*) sqlite3_user_data((sqlite3_context*) ctx);
+  func->m_count++;
+  context.m_count = func->m_count;
+  func->Aggregate(context);
+}
+
+/* static */
+void wxSQLite3FunctionContext::ExecWindowFinalize(void* ctx)
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3FunctionContext context(ctx, true, 0, NULL);
+  wxSQLite3WindowFunction* func = (wxSQLite3WindowFunction*) sqlite3_user_data((sqlite3_context*) ctx);
+  context.m_count = func->m_count;
+  func->Finalize(context);
+}
+
+/* static */
+void wxSQLite3FunctionContext::ExecWindowValue(void* ctx)
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3FunctionContext context(ctx, true, 0, NULL);
+  wxSQLite3WindowFunction* func = (wxSQLite3WindowFunction*) sqlite3_user_data((sqlite3_context*) ctx);
+  context.m_count = func->m_count;
+  func->CurrentValue(context);
+}
+
+/* static */
+void wxSQLite3FunctionContext::ExecWindowInverse(void* ctx, int argc, void** argv)
+{
+  WXSQLITE3_PROFILE();
+  wxSQLite3FunctionContext context(ctx, true, argc, argv);
+  wxSQLite3WindowFunction* func = (wxSQLite3WindowFunction*) sqlite3_user_data((sqlite3_context*) ctx);
+  func->m_count--;
+  context.m_count = func->m_count;
+  func->Reverse(context);
+}
+
+// ----------------------------------------------------------------------------
+// wxSQLite3NativeValue: low level access to values and function results
+// ----------------------------------------------------------------------------
+
+/* static */
+int wxSQLite3NativeValue::GetType(void* value)
+{
+  return sqlite3_value_type((sqlite3_value*) value);
+}
+
+/* static */
+wxsqlite_int64 wxSQLite3NativeValue::GetInt64(void* value)
+{
+  return sqlite3_value_int64((sqlite3_value*) value);
+}
+
+/* static */
+double wxSQLite3NativeValue::GetDouble(void* value)
+{
+  return sqlite3_value_double((sqlite3_value*) value);
+}
+
+/* static */
+const char* wxSQLite3NativeValue::GetText(void* value, int& len)
+{
+  // sqlite3_value_text must be called before sqlite3_value_bytes
+  const char* localValue = (const char*) sqlite3_value_text((sqlite3_value*) value);
+  len = sqlite3_value_bytes((sqlite3_value*) value);
+  return localValue;
+}
+
+/* static */
+const unsigned char* wxSQLite3NativeValue::GetBlob(void* value, int& len)
+{
+  const unsigned char* localValue = (const unsigned char*) sqlite3_value_blob((sqlite3_value*) value);
+  len = sqlite3_value_bytes((sqlite3_value*) value);
+  return localValue;
+}
+
+/* static */
+void wxSQLite3NativeValue::SetResultNull(void* ctx)
+{
+  sqlite3_result_null((sqlite3_context*) ctx);
+}
+
+/* static */
+void wxSQLite3NativeValue::SetResultInt64(void* ctx, wxsqlite_int64 value)
+{
+  sqlite3_result_int64((sqlite3_context*) ctx, value);
+}
+
+/* static */
+void wxSQLite3NativeValue::SetResultDouble(void* ctx, double value)
+{
+  sqlite3_result_double((sqlite3_context*) ctx, value);
+}
+
+/* static */
+void wxSQLite3NativeValue::SetResultText(void* ctx, const char* value, int len)
+{
+  sqlite3_result_text((sqlite3_context*) ctx, value, len, SQLITE_TRANSIENT);
+}
+
+/* static */
+void wxSQLite3NativeValue::SetResultBlob(void* ctx, const void* value, int len)
+{
+  if (value != NULL)
+  {
+    sqlite3_result_blob((sqlite3_context*) ctx, value, len, SQLITE_TRANSIENT);
+  }
+  else
+  {
+    sqlite3_result_zeroblob((sqlite3_context*) ctx, 0);
+  }
+}
+
+/* static */
+void wxSQLite3NativeValue::SetResultError(void* ctx, const char* errmsg)
+{
+  sqlite3_result_error((sqlite3_context*) ctx, errmsg, -1);
+}
+
+/* static */
+void* wxSQLite3NativeValue::GetUserData(void* ctx)
+{
+  return sqlite3_user_data((sqlite3_context*) ctx);
+}
+
+/* static */
+void* wxSQLite3NativeValue::GetAggregateContext(void* ctx, int len)
+{
+  return sqlite3_aggregate_context((sqlite3_context*) ctx, len);
+}
+
+/* static */
+void wxSQLite3NativeValue::ThrowInt64Range()
+{
+  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_INT64_RANGE);
+}
+
+// 
+static int wxSQLite3FunctionContextExecAuthorizer(void* func, int type,
+                                           const char* arg1, const char* arg2,
+                                           const char* arg3, const char* arg4
+                                          )
+{
+  wxString locArg1 = wxString::FromUTF8(arg1);
+  wxString locArg2 = wxString::FromUTF8(arg2);
+  wxString locArg3 = wxString::FromUTF8(arg3);
+  wxString locArg4 = wxString::FromUTF8(arg4);
+  wxString locArg5 = wxEmptyString;
+  wxSQLite3Authorizer::wxAuthorizationCode localType = (wxSQLite3Authorizer::wxAuthorizationCode) type;
+  return (int) ((wxSQLite3Authorizer*) func)->Authorize(localType, locArg1, locArg2, locArg3, locArg4, locArg5);
+}
+
+/* static */
+int wxSQLite3FunctionContext::ExecCommitHook(void* hook)
+{
+  WXSQLITE3_PROFILE();
+  return (int) ((wxSQLite3Hook*) hook)->CommitCallback();
+}
+
+/* static */
+void wxSQLite3FunctionContext::ExecRollbackHook(void* hook)
+{
+  WXSQLITE3_PROFILE();
+  ((wxSQLite3Hook*) hook)->RollbackCallback();
+}
+
+/* static */
+void wxSQLite3FunctionContext::ExecUpdateHook(void* hook, int type,
+                                              const char* database, const char* table,
+                                              wxsqlite_int64 rowid)
+{
+  WXSQLITE3_PROFILE();
+  wxString locDatabase = wxString::FromUTF8(database);
+  wxString locTable = wxString::FromUTF8(table);
+  wxSQLite3Hook::wxUpdateType locType = (wxSQLite3Hook::wxUpdateType) type;
+  wxLongLong locRowid = rowid;
+  ((wxSQLite3Hook*) hook)->UpdateCallback(locType, locDatabase, locTable, locRowid);
+}
+
+wxSQLite3FunctionContext::wxSQLite3FunctionContext(void* ctx, bool isAggregate, int argc, void** argv)
+  : m_ctx(ctx), m_isAggregate(isAggregate), m_count(0), m_argc(argc), m_argv(argv), m_ptrTypes(NULL)
+{
+}
+
+wxSQLite3FunctionContext::~wxSQLite3FunctionContext()
+{
+  if (m_ptrTypes != NULL)
+  {
+    size_t n = m_ptrTypes->GetCount();
+    for (size_t j = 0; j < n; ++j)
+    {
+      sqlite3_free((*m_ptrTypes)[j]);
+    }
+    delete m_ptrTypes;
+  }
+}
+
+const char* wxSQLite3FunctionContext::MakePointerTypeCopy(const wxString& pointerType)
+{
+  WXSQLITE3_PROFILE();
+  // Allocate pointer type array if necessary
+  if (m_ptrTypes == NULL)
+  {
+    m_ptrTypes = new wxArrayPtrVoid();
+  }
+
+  // Convert pointer type to char*
+  return LocalMakePointerTypeCopy(*m_ptrTypes, pointerType);
+}
+
+/* static */
+int wxSQLite3FunctionContext::ExecWriteAheadLogHook(void* hook, void* dbHandle,
+                                                    const char* database, int numPages)
+{
+  WXSQLITE3_PROFILE();
+  wxString locDatabase = wxString::FromUTF8(database);
+  wxUnusedVar(dbHandle);
+  return (int) ((wxSQLite3Hook*) hook)->WriteAheadLogCallback(locDatabase, numPages);
+}
+
+// The hooks are registered with the reference counted database object, which lives as long
+// as the connection, since the wxSQLite3Database instance may be a temporary or a copy.
+
+/* static */
+int wxSQLite3DatabaseReference::ExecCommitHook(void* dbRef)
+{
+  wxSQLite3DatabaseReference* db = (wxSQLite3DatabaseReference*) dbRef;
+  if (db->m_commitHook == NULL)
+  {
+    return 0;
+  }
+  wxSQLite3RecorderScope scope(db->m_recorder, "hook", "commit_hook");
+  return wxSQLite3FunctionContext::ExecCommitHook(db->m_commitHook);
+}
+
+/* static */
+void wxSQLite3DatabaseReference::ExecRollbackHook(void* dbRef)
+{
+  wxSQLite3DatabaseReference* db = (wxSQLite3DatabaseReference*) dbRef;
+  if (db->m_rollbackHook != NULL)
+  {
+    wxSQLite3RecorderScope scope(db->m_recorder, "hook", "rollback_hook");
+    wxSQLite3FunctionContext::ExecRollbackHook(db->m_rollbackHook);
+  }
+}
+
+/* static */
+void wxSQLite3DatabaseReference::ExecUpdateHook(void* dbRef, int type, const char* database, const char* table, sqlite3_int64 rowid)
+{
+  wxSQLite3DatabaseReference* db = (wxSQLite3DatabaseReference*) dbRef;
+  wxSQLite3RecorderScope scope(db->m_recorder, "hook", "update_hook");
+  scope.SetDetail("table", table);
+  scope.SetArg("rowid", rowid);
+  wxSQLite3FunctionContext::ExecUpdateHook(db->m_updateHook, type, database, table, rowid);
+}
+
+/* static */
+int wxSQLite3DatabaseReference::ExecWriteAheadLogHook(void* dbRef, sqlite3* dbHandle, const char* database, int numPages)
+{
+  wxSQLite3DatabaseReference* db = (wxSQLite3DatabaseReference*) dbRef;
+  wxSQLite3RecorderScope scope(db->m_recorder, "hook", "wal_hook");
+  scope.SetDetail("database", database);
+  scope.SetArg("pages", numPages);
+  return wxSQLite3FunctionContext::ExecWriteAheadLogHook(db->m_walHook, dbHandle, database, numPages);
+}
+
+#if wxCHECK_VERSION(2,9,0)
+static const wxStringCharType* authCodeString[] =
+#else
+static const wxChar* authCodeString[] =
+#endif
+{ wxS("SQLITE_COPY"),              wxS("SQLITE_CREATE_INDEX"),      wxS("SQLITE_CREATE_TABLE"),
+  wxS("SQLITE_CREATE_TEMP_INDEX"), wxS("SQLITE_CREATE_TEMP_TABLE"), wxS("SQLITE_CREATE_TEMP_TRIGGER"),
+  wxS("SQLITE_CREATE_TEMP_VIEW"),  wxS("SQLITE_CREATE_TRIGGER"),    wxS("SQLITE_CREATE_VIEW"),
+  wxS("SQLITE_DELETE"),            wxS("SQLITE_DROP_INDEX"),        wxS("SQLITE_DROP_TABLE"),
+  wxS("SQLITE_DROP_TEMP_INDEX"),   wxS("SQLITE_DROP_TEMP_TABLE"),   wxS("SQLITE_DROP_TEMP_TRIGGER"),
+  wxS("SQLITE_DROP_TEMP_VIEW"),    wxS("SQLITE_DROP_TRIGGER"),      wxS("SQLITE_DROP_VIEW"),
+  wxS("SQLITE_INSERT"),            wxS("SQLITE_PRAGMA"),            wxS("SQLITE_READ"),
+  wxS("SQLITE_SELECT"),            wxS("SQLITE_TRANSACTION"),       wxS("SQLITE_UPDATE"),
+  wxS("SQLITE_ATTACH"),            wxS("SQLITE_DETACH"),            wxS("SQLITE_ALTER_TABLE"),
+  wxS("SQLITE_REINDEX"),           wxS("SQLITE_ANALYZE"),           wxS("SQLITE_CREATE_VTABLE"),
+  wxS("SQLITE_DROP_VTABLE"),       wxS("SQLITE_FUNCTION"),          wxS("SQLITE_SAVEPOINT"),
+  wxS("SQLITE_RECURSIVE")
+};
+
+
+/* static */
+wxString wxSQLite3Authorizer::AuthorizationCodeToString(wxSQLite3Authorizer::wxAuthorizationCode type)
+{
+  wxString authString(wxS("Unknown"));
+  if (type >= SQLITE_COPY && type <= SQLITE_MAX_CODE)
+  {
+    authString = authCodeString[type];
+  }
+  return authString;
+}
+
+// ----------------------------------------------------------------------------
+// wxSQLite3Transaction
+// ----------------------------------------------------------------------------
+
+wxSQLite3Transaction::wxSQLite3Transaction(wxSQLite3Database* db, wxSQLite3TransactionType transactionType)
+{
+  wxASSERT(db != NULL);
+  m_database = db;
+  try
+  {
+    m_database->Begin(transactionType);
+  }
+  catch (...)
+  {
+    m_database = NULL; // Flag that transaction is not active
+  }
+}
+
+wxSQLite3Transaction::~wxSQLite3Transaction()
+{
+  if (m_database != NULL)
+  {
+    try
+    {
+      m_database->Rollback();
+    }
+    catch (...)
+    {
+      // Intentionally do nothing
+    }
+  }
+}
+
+void wxSQLite3Transaction::Commit()
+{
+  WXSQLITE3_PROFILE();
+  m_database->Commit();
+  m_database = NULL;
+}
+
+void wxSQLite3Transaction::Rollback()
+{
+  WXSQLITE3_PROFILE();
+  m_database->Rollback();
+  m_database = NULL;
+}
+
+// --- SQLite logging
+
+wxSQLite3Logger::wxSQLite3Logger()
+  : m_isActive(false)
+{
+}
+
+wxSQLite3Logger::~wxSQLite3Logger()
+{
+}
+
+void
+wxSQLite3Logger::HandleLogMessage(int errorCode, const wxString& errorMessage)
+{
+  if (m_isActive)
+  {
+#if wxCHECK_VERSION(2,9,0)
+    wxLogInfo(wxS("SQLite3 %s (%d): %s"), wxSQLite3Exception::ErrorCodeAsString(errorCode), errorCode, errorMessage);
+#else
+    wxLogInfo(wxS("SQLite3 %s (%d): %s"), wxSQLite3Exception::ErrorCodeAsString(errorCode).c_str(), errorCode, errorMessage.c_str());
+#endif
+  }
+}
+
+void
+wxSQLite3Logger::DispatchLogMessage(int errorCode, const char* errorMessage)
+{
+  HandleLogMessage(errorCode, wxString::FromUTF8(errorMessage));
+}
+
+/* static */
+void
+wxSQLite3Logger::ExecLoggerHook(void* logger, int errorCode, const char* errorMsg)
+{
+  ((wxSQLite3Logger*) logger)->DispatchLogMessage(errorCode, errorMsg);
+}
+
+// --- Change data capture
+
+void* wxSQLite3RowChange::GetOldValue(int column) const
+{
+  return (column >= 0 && column < m_columnCount) ? m_values[column] : NULL;
+}
+
+void* wxSQLite3RowChange::GetNewValue(int column) const
+{
+  return (column >= 0 && column < m_columnCount) ? m_values[m_columnCount + column] : NULL;
+}
+
+bool wxSQLite3RowChange::IsColumnChanged(int column) const
+{
+  if (m_operation != (wxSQLite3Hook::wxUpdateType) SQLITE_UPDATE)
+  {
+    return true;
+  }
+  sqlite3_value* oldValue = (sqlite3_value*) GetOldValue(column);
+  sqlite3_value* newValue = (sqlite3_value*) GetNewValue(column);
+  if (oldValue == NULL || newValue == NULL)
+  {
+    // Values not captured or not known (incremental BLOB write)
+    return true;
+  }
+  int type = sqlite3_value_type(oldValue);
+  if (type != sqlite3_value_type(newValue))
+  {
+    return true;
+  }
+  bool changed = false;
+  switch (type)
+  {
+    case SQLITE_INTEGER:
+      changed = sqlite3_value_int64(oldValue) != sqlite3_value_int64(newValue);
+      break;
+    case SQLITE_FLOAT:
+      changed = sqlite3_value_double(oldValue) != sqlite3_value_double(newValue);
+      break;
+    case SQLITE_TEXT:
+    case SQLITE_BLOB:
+      {
+        const void* oldData = sqlite3_value_blob(oldValue);
+        int oldLen = sqlite3_value_bytes(oldValue);
+        const void* newData = sqlite3_value_blob(newValue);
+        int newLen = sqlite3_value_bytes(newValue);
+        changed = oldLen != newLen || (oldLen > 0 && memcmp(oldData, newData, oldLen) != 0);
+      }
+      break;
+    default:
+      break;
+  }
+  return changed;
+}
+
+wxSQLite3ChangeFeed::wxSQLite3ChangeFeed(wxSQLite3DatabaseReference* db, wxSQLite3ChangeListener* listener, bool captureValues)
+  : m_db(db), m_listener(listener), m_captureValues(captureValues), m_failed(false),
+    m_tables(NULL), m_tableCount(0), m_tableAlloc(0), m_lastTable(-1),
+    m_changes(NULL), m_changeCount(0), m_changeAlloc(0),
+    m_values(NULL), m_valueCount(0), m_valueAlloc(0),
+    m_savepoints(NULL), m_savepointCount(0), m_savepointAlloc(0)
+{
+}
+
+wxSQLite3ChangeFeed::~wxSQLite3ChangeFeed()
+{
+  Clear();
+  int j;
+  for (j = 0; j < m_tableCount; ++j)
+  {
+    sqlite3_free(m_tables[j].m_databaseName);
+    sqlite3_free(m_tables[j].m_tableName);
+    delete m_tables[j].m_database;
+    delete m_tables[j].m_table;
+  }
+  sqlite3_free(m_tables);
+  sqlite3_free(m_changes);
+  sqlite3_free(m_values);
+  sqlite3_free(m_savepoints);
+}
+
+void wxSQLite3ChangeFeed::SetListener(wxSQLite3ChangeListener* listener, bool captureValues)
+{
+  m_captureValues = captureValues;
+  if (listener != m_listener)
+  {
+    // Tables are kept, since buffered changes refer to them, but the capture decision is renewed
+    m_listener = listener;
+    int j;
+    for (j = 0; j < m_tableCount; ++j)
+    {
+      m_tables[j].m_capture = CaptureTable(m_tables[j]);
+    }
+  }
+}
+
+void wxSQLite3ChangeFeed::Clear()
+{
+  Truncate(0);
+  PopSavepoints(0);
+  m_failed = false;
+
+  // Release the buffers after exceptionally large transactions
+  if (m_changeAlloc > 16384)
+  {
+    sqlite3_free(m_changes);
+    m_changes = NULL;
+    m_changeAlloc = 0;
+  }
+  if (m_valueAlloc > 262144)
+  {
+    sqlite3_free(m_values);
+    m_values = NULL;
+    m_valueAlloc = 0;
+  }
+}
+
+void wxSQLite3ChangeFeed::Truncate(size_t changeCount)
+{
+  if (changeCount < m_changeCount)
+  {
+    size_t valueCount = m_changes[changeCount].m_valueIndex;
+    size_t j;
+    for (j = valueCount; j < m_valueCount; ++j)
+    {
+      sqlite3_value_free((sqlite3_value*) m_values[j]);
+    }
+    m_valueCount = valueCount;
+    m_changeCount = changeCount;
+  }
+}
+
+int wxSQLite3ChangeFeed::FindSavepoint(const char* name) const
+{
+  int j;
+  for (j = m_savepointCount - 1; j >= 0; --j)
+  {
+    if (sqlite3_stricmp(m_savepoints[j].m_name, name) == 0)
+    {
+      break;
+    }
+  }
+  return j;
+}
+
+void wxSQLite3ChangeFeed::PopSavepoints(int savepointCount)
+{
+  while (m_savepointCount > savepointCount)
+  {
+    sqlite3_free(m_savepoints[--m_savepointCount].m_name);
+  }
+}
+
+static bool wxSQLite3IsIdentifierChar(unsigned char c);
+
+// Get the next token of a SQL statement, skipping white space and comments
+static const char* wxSQLite3NextSQLToken(const char* sql, int& len)
+{
+  for (;;)
+  {
+    while (*sql == ' ' || *sql == '\t' || *sql == '\n' || *sql == '\r' || *sql == '\f' || *sql == '\v')
+    {
+      ++sql;
+    }
+    if (sql[0] == '-' && sql[1] == '-')
+    {
+      while (*sql != '\0' && *sql != '\n') ++sql;
+    }
+    else if (sql[0] == '/' && sql[1] == '*')
+    {
+      const char* end = strstr(sql + 2, "*/");
+      sql = (end != NULL) ? end + 2 : sql + strlen(sql);
+    }
+    else
+    {
+      break;
+    }
+  }
+
+  const char* p = sql;
+  if (*p == '"' || *p == '`' || *p == '\'' || *p == '[')
+  {
+    // Quoted identifier
+    char quote = (*p == '[') ? ']' : *p;
+    ++p;
+    while (*p != '\0')
+    {
+      if (*p == quote)
+      {
+        if (quote != ']' && p[1] == quote)
+        {
+          p += 2;
+          continue;
+        }
+        ++p;
+        break;
+      }
+      ++p;
+    }
+  }
+  else
+  {
+    while (wxSQLite3IsIdentifierChar((unsigned char) *p)) ++p;
+    if (p == sql && *p != '\0')
+    {
+      ++p;
+    }
+  }
+  len = (int) (p - sql);
+  return sql;
+}
+
+// Check whether a token is the given keyword
+static bool wxSQLite3IsSQLKeyword(const char* token, int len, const char* keyword)
+{
+  return len == (int) strlen(keyword) && sqlite3_strnicmp(token, keyword, len) == 0;
+}
+
+// Copy an identifier token, removing the quotes
+static char* wxSQLite3CopySQLIdentifier(const char* token, int len)
+{
+  if (len < 2 || (*token != '"' && *token != '`' && *token != '\'' && *token != '['))
+  {
+    return sqlite3_mprintf("%.*s", len, token);
+  }
+  char quote = (*token == '[') ? ']' : *token;
+  char* name = (char*) sqlite3_malloc(len);
+  if (name != NULL)
+  {
+    int n = 0;
+    int j;
+    for (j = 1; j < len - 1; ++j)
+    {
+      name[n++] = token[j];
+      if (token[j] == quote && quote != ']')
+      {
+        // Skip the second quote of an escaped quote
+        ++j;
+      }
+    }
+    name[n] = '\0';
+  }
+  return name;
+}
+
+void wxSQLite3ChangeFeed::ProcessSavepoint(const char* sql)
+{
+  int len;
+  const char* token = wxSQLite3NextSQLToken(sql, len);
+  int kind;
+  if (wxSQLite3IsSQLKeyword(token, len, "SAVEPOINT"))
+  {
+    kind = SAVEPOINT_BEGIN;
+  }
+  else if (wxSQLite3IsSQLKeyword(token, len, "RELEASE"))
+  {
+    kind = SAVEPOINT_RELEASE;
+  }
+  else if (wxSQLite3IsSQLKeyword(token, len, "ROLLBACK"))
+  {
+    // ROLLBACK [TRANSACTION] TO [SAVEPOINT] name, a plain ROLLBACK is handled by the rollback hook
+    token = wxSQLite3NextSQLToken(token + len, len);
+    if (wxSQLite3IsSQLKeyword(token, len, "TRANSACTION"))
+    {
+      token = wxSQLite3NextSQLToken(token + len, len);
+    }
+    if (!wxSQLite3IsSQLKeyword(token, len, "TO"))
+    {
+      return;
+    }
+    kind = SAVEPOINT_ROLLBACK;
+  }
+  else
+  {
+    return;
+  }
+
+  token = wxSQLite3NextSQLToken(token + len, len);
+  if (kind != SAVEPOINT_BEGIN && wxSQLite3IsSQLKeyword(token, len, "SAVEPOINT"))
+  {
+    token = wxSQLite3NextSQLToken(token + len, len);
+  }
+  char* name = wxSQLite3CopySQLIdentifier(token, len);
+  if (name == NULL)
+  {
+    m_failed = true;
+    return;
+  }
+
+  if (kind == SAVEPOINT_BEGIN)
+  {
+    if (m_savepointCount == m_savepointAlloc)
+    {
+      int newAlloc = (m_savepointAlloc > 0) ? 2 * m_savepointAlloc : 8;
+      SavepointEntry* newSavepoints = (SavepointEntry*) sqlite3_realloc64(m_savepoints, newAlloc * sizeof(SavepointEntry));
+      if (newSavepoints == NULL)
+      {
+        sqlite3_free(name);
+        m_failed = true;
+        return;
+      }
+      m_savepoints = newSavepoints;
+      m_savepointAlloc = newAlloc;
+    }
+    m_savepoints[m_savepointCount].m_name = name;
+    m_savepoints[m_savepointCount].m_changeCount = m_changeCount;
+    ++m_savepointCount;
+    return;
+  }
+
+  int index = FindSavepoint(name);
+  sqlite3_free(name);
+  if (index >= 0)
+  {
+    if (kind == SAVEPOINT_RELEASE)
+    {
+      // The changes become part of the enclosing savepoint resp. transaction
+      PopSavepoints(index);
+    }
+    else
+    {
+      // The savepoint itself remains active after ROLLBACK TO
+      Truncate(m_savepoints[index].m_changeCount);
+      PopSavepoints(index + 1);
+    }
+  }
+}
+
+void wxSQLite3ChangeFeed::EndStatement(sqlite3* db, sqlite3_stmt* stmt, int rc, size_t changeCount, int totalChanges)
+{
+  if (rc == SQLITE_DONE)
+  {
+    if (m_changeCount == changeCount)
+    {
+      // Savepoint statements don't change rows
+      ProcessSavepoint(sqlite3_sql(stmt));
+    }
+  }
+  else if (rc != SQLITE_ROW)
+  {
+    // A failed statement is rolled back, unless the conflict resolution FAIL keeps the
+    // changes made so far; only in that case the total number of changes was increased.
+    // If the whole transaction was rolled back, the rollback hook discarded all changes.
+    if (sqlite3_total_changes(db) == totalChanges)
+    {
+      Truncate(changeCount);
+    }
+  }
+}
+
+bool wxSQLite3ChangeFeed::CaptureTable(const TableEntry& entry)
+{
+  bool capture = true;
+  try
+  {
+    capture = m_listener->CaptureTable(*entry.m_database, *entry.m_table);
+  }
+  catch (...)
+  {
+    // Capture the table, if the listener fails to decide
+  }
+  return capture;
+}
+
+int wxSQLite3ChangeFeed::FindTable(const char* database, const char* table)
+{
+  // Bulk operations usually modify the same table over and over again
+  if (m_lastTable >= 0 &&
+      strcmp(m_tables[m_lastTable].m_tableName, table) == 0 &&
+      strcmp(m_tables[m_lastTable].m_databaseName, database) == 0)
+  {
+    return m_lastTable;
+  }
+
+  int j;
+  for (j = 0; j < m_tableCount; ++j)
+  {
+    if (strcmp(m_tables[j].m_tableName, table) == 0 &&
+        strcmp(m_tables[j].m_databaseName, database) == 0)
+    {
+      m_lastTable = j;
+      return j;
+    }
+  }
+
+  if (m_tableCount == m_tableAlloc)
+  {
+    int newAlloc = (m_tableAlloc > 0) ? 2 * m_tableAlloc : 8;
+    TableEntry* newTables = (TableEntry*) sqlite3_realloc64(m_tables, newAlloc * sizeof(TableEntry));
+    if (newTables == NULL)
+    {
+      return -1;
+    }
+    m_tables = newTables;
+    m_tableAlloc = newAlloc;
+  }
+  char* databaseName = sqlite3_mprintf("%s", database);
+  char* tableName = sqlite3_mprintf("%s", table);
+  if (databaseName == NULL || tableName == NULL)
+  {
+    sqlite3_free(databaseName);
+    sqlite3_free(tableName);
+    return -1;
+  }
+  TableEntry& entry = m_tables[m_tableCount];
+  entry.m_databaseName = databaseName;
+  entry.m_tableName = tableName;
+  entry.m_database = new wxString(wxString::FromUTF8(database));
+  entry.m_table = new wxString(wxString::FromUTF8(table));
+  entry.m_capture = CaptureTable(entry);
+  m_lastTable = m_tableCount++;
+  return m_lastTable;
+}
+
+bool wxSQLite3ChangeFeed::AddChange(sqlite3* db, int op, const TableEntry& entry,
+                                    sqlite3_int64 oldRowId, sqlite3_int64 newRowId)
+{
+#if defined(SQLITE_ENABLE_PREUPDATE_HOOK)
+  if (m_changeCount == m_changeAlloc)
+  {
+    size_t newAlloc = (m_changeAlloc > 0) ? 2 * m_changeAlloc : 64;
+    wxSQLite3RowChange* newChanges = (wxSQLite3RowChange*) sqlite3_realloc64(m_changes, newAlloc * sizeof(wxSQLite3RowChange));
+    if (newChanges == NULL)
+    {
+      return false;
+    }
+    m_changes = newChanges;
+    m_changeAlloc = newAlloc;
+  }
+
+  // An incremental BLOB write is reported as a delete without the new values being available
+  int blobColumn = -1;
+#if SQLITE_VERSION_NUMBER >= 3036000
+  if (op == SQLITE_DELETE)
+  {
+    blobColumn = sqlite3_preupdate_blobwrite(db);
+  }
+#endif
+  int columnCount = (m_captureValues) ? sqlite3_preupdate_count(db) : 0;
+  size_t valueCount = 2 * (size_t) columnCount;
+  if (m_valueCount + valueCount > m_valueAlloc)
+  {
+    size_t newAlloc = (m_valueAlloc > 0) ? 2 * m_valueAlloc : 512;
+    while (newAlloc < m_valueCount + valueCount)
+    {
+      newAlloc *= 2;
+    }
+    void** newValues = (void**) sqlite3_realloc64(m_values, newAlloc * sizeof(void*));
+    if (newValues == NULL)
+    {
+      return false;
+    }
+    m_values = newValues;
+    m_valueAlloc = newAlloc;
+  }
+
+  wxSQLite3RowChange& change = m_changes[m_changeCount];
+  change.m_operation = (wxSQLite3Hook::wxUpdateType) ((blobColumn >= 0) ? SQLITE_UPDATE : op);
+  change.m_database = entry.m_database;
+  change.m_table = entry.m_table;
+  change.m_oldRowId = oldRowId;
+  change.m_newRowId = (blobColumn >= 0) ? oldRowId : newRowId;
+  change.m_depth = sqlite3_preupdate_depth(db);
+  change.m_columnCount = columnCount;
+  change.m_valueIndex = m_valueCount;
+  change.m_values = NULL;
+
+  // Column values are only valid during the hook, therefore they are duplicated
+  bool ok = true;
+  void** oldValues = m_values + m_valueCount;
+  void** newValues = oldValues + columnCount;
+  int j;
+  for (j = 0; j < columnCount; ++j)
+  {
+    sqlite3_value* value;
+    oldValues[j] = NULL;
+    if (op != SQLITE_INSERT && sqlite3_preupdate_old(db, j, &value) == SQLITE_OK)
+    {
+      oldValues[j] = sqlite3_value_dup(value);
+      ok = ok && oldValues[j] != NULL;
+    }
+    newValues[j] = NULL;
+    if (op != SQLITE_DELETE && sqlite3_preupdate_new(db, j, &value) == SQLITE_OK)
+    {
+      newValues[j] = sqlite3_value_dup(value);
+      ok = ok && newValues[j] != NULL;
+    }
+  }
+  m_valueCount += valueCount;
+  ++m_changeCount;
+  return ok;
+#else
+  wxUnusedVar(db);
+  wxUnusedVar(op);
+  wxUnusedVar(entry);
+  wxUnusedVar(oldRowId);
+  wxUnusedVar(newRowId);
+  return false;
+#endif
+}
+
+/* static */
+void wxSQLite3ChangeFeed::ExecPreUpdateHook(void* feedPtr, sqlite3* db, int op,
+                                            const char* database, const char* table,
+                                            sqlite3_int64 oldRowId, sqlite3_int64 newRowId)
+{
+  wxSQLite3ChangeFeed* feed = (wxSQLite3ChangeFeed*) feedPtr;
+  if (feed->m_failed)
+  {
+    // The transaction will be rolled back on commit anyway
+    return;
+  }
+  int tableIndex = feed->FindTable(database, table);
+  if (tableIndex < 0)
+  {
+    feed->m_failed = true;
+  }
+  else if (feed->m_tables[tableIndex].m_capture)
+  {
+    feed->m_failed = !feed->AddChange(db, op, feed->m_tables[tableIndex], oldRowId, newRowId);
+  }
+}
+
+/* static */
+int wxSQLite3ChangeFeed::ExecCommitHook(void* feedPtr)
+{
+  wxSQLite3ChangeFeed* feed = (wxSQLite3ChangeFeed*) feedPtr;
+  if (wxSQLite3DatabaseReference::ExecCommitHook(feed->m_db) != 0)
+  {
+    // The rollback hook discards the buffered changes
+    return 1;
+  }
+
+  // Changes that could not be captured completely must not be committed silently
+  int rc = (feed->m_failed) ? 1 : 0;
+  if (rc == 0 && feed->m_changeCount > 0)
+  {
+    size_t j;
+    for (j = 0; j < feed->m_changeCount; ++j)
+    {
+      feed->m_changes[j].m_values = feed->m_values + feed->m_changes[j].m_valueIndex;
+    }
+    wxSQLite3ChangeBatch changes(feed->m_changes, feed->m_changeCount);
+    try
+    {
+      rc = (feed->m_listener->CommitCallback(changes)) ? 1 : 0;
+    }
+    catch (...)
+    {
+      rc = 1;
+    }
+  }
+  feed->Clear();
+  return rc;
+}
+
+/* static */
+void wxSQLite3ChangeFeed::ExecRollbackHook(void* feedPtr)
+{
+  wxSQLite3ChangeFeed* feed = (wxSQLite3ChangeFeed*) feedPtr;
+  wxSQLite3DatabaseReference::ExecRollbackHook(feed->m_db);
+  feed->Clear();
+}
+
+void wxSQLite3Database::SetChangeListener(wxSQLite3ChangeListener* listener, bool captureValues)
+{
+  WXSQLITE3_PROFILE();
+#if defined(SQLITE_ENABLE_PREUPDATE_HOOK)
+  CheckDatabase();
+  wxSQLite3ChangeFeed* feed = m_db->m_changeFeed;
+  if (listener != NULL)
+  {
+    if (feed == NULL)
+    {
+      feed = new wxSQLite3ChangeFeed(m_db, listener, captureValues);
+      m_db->m_changeFeed = feed;
+      // Hooks registered before are chained by the feed
+      sqlite3_commit_hook(m_db->m_db, wxSQLite3ChangeFeed::ExecCommitHook, feed);
+      sqlite3_rollback_hook(m_db->m_db, wxSQLite3ChangeFeed::ExecRollbackHook, feed);
+      sqlite3_preupdate_hook(m_db->m_db, wxSQLite3ChangeFeed::ExecPreUpdateHook, feed);
+    }
+    else
+    {
+      feed->SetListener(listener, captureValues);
+    }
+  }
+  else if (feed != NULL)
+  {
+    sqlite3_preupdate_hook(m_db->m_db, NULL, NULL);
+    m_db->m_changeFeed = NULL;
+    SetCommitHook(m_db->m_commitHook);
+    SetRollbackHook(m_db->m_rollbackHook);
+    delete feed;
+  }
+#else
+  wxUnusedVar(listener);
+  wxUnusedVar(captureValues);
+  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOPREUPDATEHOOK);
+#endif
+}
+
+// --- User defined collation classes
+
+int wxSQLite3Utf8Collation::Compare(const char* text1, size_t len1, const char* text2, size_t len2)
+{
+  int rc = memcmp(text1, text2, (len1 < len2) ? len1 : len2);
+  if (rc == 0)
+  {
+    rc = (len1 < len2) ? -1 : ((len1 > len2) ? 1 : 0);
+  }
+  return rc;
+}
+
+/// Direct-mapped cache of sort keys (internal)
+class wxSQLite3SortKeyCache
+{
+public:
+  /// Cache slot
+  struct Entry
+  {
+    Entry() : m_used(false) {}
+    bool           m_used; ///< Flag whether the slot is occupied
+    wxMemoryBuffer m_text; ///< Text of the cached value
+    wxMemoryBuffer m_key;  ///< Sort key of the cached value
+  };
+
+  wxSQLite3SortKeyCache(size_t size)
+    : m_entries(NULL), m_size(size)
+  {
+    if (m_size > 0)
+    {
+      m_entries = new Entry[m_size];
+    }
+  }
+
+  ~wxSQLite3SortKeyCache()
+  {
+    delete [] m_entries;
+  }
+
+  size_t GetSize() const { return m_size; }
+
+  size_t GetSlot(const char* text, size_t len) const
+  {
+    // FNV-1a hash
+    wxUint32 hash = 2166136261U;
+    size_t j;
+    for (j = 0; j < len; ++j)
+    {
+      hash = (hash ^ (unsigned char) text[j]) * 16777619U;
+    }
+    return hash % m_size;
+  }
+
+  const wxMemoryBuffer& GetKey(wxSQLite3SortKeyCollation* collation, size_t slot, const char* text, size_t len)
+  {
+    Entry& entry = m_entries[slot];
+    if (!entry.m_used || entry.m_text.GetDataLen() != len ||
+        (len > 0 && memcmp(entry.m_text.GetData(), text, len) != 0))
+    {
+      entry.m_used = false;
+      entry.m_text.SetDataLen(0);
+      entry.m_text.AppendData(text, len);
+      entry.m_key.SetDataLen(0);
+      collation->GenerateSortKey(text, len, entry.m_key);
+      entry.m_used = true;
+    }
+    return entry.m_key;
+  }
+
+  void Clear()
+  {
+    size_t j;
+    for (j = 0; j < m_size; ++j)
+    {
+      m_entries[j].m_used = false;
+    }
+  }
+
+  wxMemoryBuffer m_scratch1; ///< Sort key buffer for uncached values
+  wxMemoryBuffer m_scratch2; ///< Sort key buffer for uncached values
+
+private:
+  Entry* m_entries; ///< Cache slots
+  size_t m_size;    ///< Number of cache slots
+};
+
+static int CompareSortKeys(const wxMemoryBuffer& key1, const wxMemoryBuffer& key2)
+{
+  size_t len1 = key1.GetDataLen();
+  size_t len2 = key2.GetDataLen();
+  int rc = (len1 > 0 && len2 > 0) ? memcmp(key1.GetData(), key2.GetData(), (len1 < len2) ? len1 : len2) : 0;
+  if (rc == 0)
+  {
+    rc = (len1 < len2) ? -1 : ((len1 > len2) ? 1 : 0);
+  }
+  return rc;
+}
+
+wxSQLite3SortKeyCollation::wxSQLite3SortKeyCollation(size_t cacheSize)
+{
+  m_cache = new wxSQLite3SortKeyCache(cacheSize);
+}
+
+wxSQLite3SortKeyCollation::~wxSQLite3SortKeyCollation()
+{
+  delete m_cache;
+}
+
+int wxSQLite3SortKeyCollation::Compare(const char* text1, size_t len1, const char* text2, size_t len2)
+{
+  if (len1 == len2 && (len1 == 0 || memcmp(text1, text2, len1) == 0))
+  {
+    return 0;
+  }
+  if (m_cache->GetSize() > 0)
+  {
+    size_t slot1 = m_cache->GetSlot(text1, len1);
+    size_t slot2 = m_cache->GetSlot(text2, len2);
+    if (slot1 != slot2)
+    {
+      // Both sort keys stay valid, since they are held in different slots
+      const wxMemoryBuffer& key1 = m_cache->GetKey(this, slot1, text1, len1);
+      const wxMemoryBuffer& key2 = m_cache->GetKey(this, slot2, text2, len2);
+      return CompareSortKeys(key1, key2);
+    }
+  }
+  m_cache->m_scratch1.SetDataLen(0);
+  m_cache->m_scratch2.SetDataLen(0);
+  GenerateSortKey(text1, len1, m_cache->m_scratch1);
+  GenerateSortKey(text2, len2, m_cache->m_scratch2);
+  return CompareSortKeys(m_cache->m_scratch1, m_cache->m_scratch2);
+}
+
+void wxSQLite3SortKeyCollation::ClearCache()
+{
+  m_cache->Clear();
+}
+
+// --- Unicode case folding, case-insensitive collation and LIKE/GLOB functions
+
+/// Range of code points sharing the same case folding offset (internal)
+struct wxSQLite3CaseFoldRange
+{
+  unsigned int   m_first;  ///< First code point of the range
+  unsigned short m_count;  ///< Number of code points in the range
+  unsigned char  m_stride; ///< Distance between the code points (2 for alternating upper/lower case pairs)
+  int            m_delta;  ///< Offset from a code point to its folded code point
+};
+
+// Simple case folding of non-ASCII code points (Unicode 14.0)
+static const wxSQLite3CaseFoldRange gs_caseFoldRanges[] =
+{
+  { 0x000B5,   1, 1,    775 },
+  { 0x000C0,  23, 1,     32 },
+  { 0x000D8,   7, 1,     32 },
+  { 0x00100,  24, 2,      1 },
+  { 0x00132,   3, 2,      1 },
+  { 0x00139,   8, 2,      1 },
+  { 0x0014A,  23, 2,      1 },
+  { 0x00178,   1, 1,   -121 },
+  { 0x00179,   3, 2,      1 },
+  { 0x0017F,   1, 1,   -268 },
+  { 0x00181,   1, 1,    210 },
+  { 0x00182,   2, 2,      1 },
+  { 0x00186,   1, 1,    206 },
+  { 0x00187,   1, 1,      1 },
+  { 0x00189,   2, 1,    205 },
+  { 0x0018B,   1, 1,      1 },
+  { 0x0018E,   1, 1,     79 },
+  { 0x0018F,   1, 1,    202 },
+  { 0x00190,   1, 1,    203 },
+  { 0x00191,   1, 1,      1 },
+  { 0x00193,   1, 1,    205 },
+  { 0x00194,   1, 1,    207 },
+  { 0x00196,   1, 1,    211 },
+  { 0x00197,   1, 1,    209 },
+  { 0x00198,   1, 1,      1 },
+  { 0x0019C,   1, 1,    211 },
+  { 0x0019D,   1, 1,    213 },
+  { 0x0019F,   1, 1,    214 },
+  { 0x001A0,   3, 2,      1 },
+  { 0x001A6,   1, 1,    218 },
+  { 0x001A7,   1, 1,      1 },
+  { 0x001A9,   1, 1,    218 },
+  { 0x001AC,   1, 1,      1 },
+  { 0x001AE,   1, 1,    218 },
+  { 0x001AF,   1, 1,      1 },
+  { 0x001B1,   2, 1,    217 },
+  { 0x001B3,   2, 2,      1 },
+  { 0x001B7,   1, 1,    219 },
+  { 0x001B8,   1, 1,      1 },
+  { 0x001BC,   1, 1,      1 },
+  { 0x001C4,   1, 1,      2 },
+  { 0x001C5,   1, 1,      1 },
+  { 0x001C7,   1, 1,      2 },
+  { 0x001C8,   1, 1,      1 },
+  { 0x001CA,   1, 1,      2 },
+  { 0x001CB,   9, 2,      1 },
+  { 0x001DE,   9, 2,      1 },
+  { 0x001F1,   1, 1,      2 },
+  { 0x001F2,   2, 2,      1 },
+  { 0x001F6,   1, 1,    -97 },
+  { 0x001F7,   1, 1,    -56 },
+  { 0x001F8,  20, 2,      1 },
+  { 0x00220,   1, 1,   -130 },
+  { 0x00222,   9, 2,      1 },
+  { 0x0023A,   1, 1,  10795 },
+  { 0x0023B,   1, 1,      1 },
+  { 0x0023D,   1, 1,   -163 },
+  { 0x0023E,   1, 1,  10792 },
+  { 0x00241,   1, 1,      1 },
+  { 0x00243,   1, 1,   -195 },
+  { 0x00244,   1, 1,     69 },
+  { 0x00245,   1, 1,     71 },
+  { 0x00246,   5, 2,      1 },
+  { 0x00345,   1, 1,    116 },
+  { 0x00370,   2, 2,      1 },
+  { 0x00376,   1, 1,      1 },
+  { 0x0037F,   1, 1,    116 },
+  { 0x00386,   1, 1,     38 },
+  { 0x00388,   3, 1,     37 },
+  { 0x0038C,   1, 1,     64 },
+  { 0x0038E,   2, 1,     63 },
+  { 0x00391,  17, 1,     32 },
+  { 0x003A3,   9, 1,     32 },
+  { 0x003C2,   1, 1,      1 },
+  { 0x003CF,   1, 1,      8 },
+  { 0x003D0,   1, 1,    -30 },
+  { 0x003D1,   1, 1,    -25 },
+  { 0x003D5,   1, 1,    -15 },
+  { 0x003D6,   1, 1,    -22 },
+  { 0x003D8,  12, 2,      1 },
+  { 0x003F0,   1, 1,    -54 },
+  { 0x003F1,   1, 1,    -48 },
+  { 0x003F4,   1, 1,    -60 },
+  { 0x003F5,   1, 1,    -64 },
+  { 0x003F7,   1, 1,      1 },
+  { 0x003F9,   1, 1,     -7 },
+  { 0x003FA,   1, 1,      1 },
+  { 0x003FD,   3, 1,   -130 },
+  { 0x00400,  16, 1,     80 },
+  { 0x00410,  32, 1,     32 },
+  { 0x00460,  17, 2,      1 },
+  { 0x0048A,  27, 2,      1 },
+  { 0x004C0,   1, 1,     15 },
+  { 0x004C1,   7, 2,      1 },
+  { 0x004D0,  48, 2,      1 },
+  { 0x00531,  38, 1,     48 },
+  { 0x010A0,  38, 1,   7264 },
+  { 0x010C7,   1, 1,   7264 },
+  { 0x010CD,   1, 1,   7264 },
+  { 0x013F8,   6, 1,     -8 },
+  { 0x01C80,   1, 1,  -6222 },
+  { 0x01C81,   1, 1,  -6221 },
+  { 0x01C82,   1, 1,  -6212 },
+  { 0x01C83,   2, 1,  -6210 },
+  { 0x01C85,   1, 1,  -6211 },
+  { 0x01C86,   1, 1,  -6204 },
+  { 0x01C87,   1, 1,  -6180 },
+  { 0x01C88,   1, 1,  35267 },
+  { 0x01C90,  43, 1,  -3008 },
+  { 0x01CBD,   3, 1,  -3008 },
+  { 0x01E00,  75, 2,      1 },
+  { 0x01E9B,   1, 1,    -58 },
+  { 0x01E9E,   1, 1,  -7615 },
+  { 0x01EA0,  48, 2,      1 },
+  { 0x01F08,   8, 1,     -8 },
+  { 0x01F18,   6, 1,     -8 },
+  { 0x01F28,   8, 1,     -8 },
+  { 0x01F38,   8, 1,     -8 },
+  { 0x01F48,   6, 1,     -8 },
+  { 0x01F59,   4, 2,     -8 },
+  { 0x01F68,   8, 1,     -8 },
+  { 0x01F88,   8, 1,     -8 },
+  { 0x01F98,   8, 1,     -8 },
+  { 0x01FA8,   8, 1,     -8 },
+  { 0x01FB8,   2, 1,     -8 },
+  { 0x01FBA,   2, 1,    -74 },
+  { 0x01FBC,   1, 1,     -9 },
+  { 0x01FBE,   1, 1,  -7173 },
+  { 0x01FC8,   4, 1,    -86 },
+  { 0x01FCC,   1, 1,     -9 },
+  { 0x01FD8,   2, 1,     -8 },
+  { 0x01FDA,   2, 1,   -100 },
+  { 0x01FE8,   2, 1,     -8 },
+  { 0x01FEA,   2, 1,   -112 },
+  { 0x01FEC,   1, 1,     -7 },
+  { 0x01FF8,   2, 1,   -128 },
+  { 0x01FFA,   2, 1,   -126 },
+  { 0x01FFC,   1, 1,     -9 },
+  { 0x02126,   1, 1,  -7517 },
+  { 0x0212A,   1, 1,  -8383 },
+  { 0x0212B,   1, 1,  -8262 },
+  { 0x02132,   1, 1,     28 },
+  { 0x02160,  16, 1,     16 },
+  { 0x02183,   1, 1,      1 },
+  { 0x024B6,  26, 1,     26 },
+  { 0x02C00,  48, 1,     48 },
+  { 0x02C60,   1, 1,      1 },
+  { 0x02C62,   1, 1, -10743 },
+  { 0x02C63,   1, 1,  -3814 },
+  { 0x02C64,   1, 1, -10727 },
+  { 0x02C67,   3, 2,      1 },
+  { 0x02C6D,   1, 1, -10780 },
+  { 0x02C6E,   1, 1, -10749 },
+  { 0x02C6F,   1, 1, -10783 },
+  { 0x02C70,   1, 1, -10782 },
+  { 0x02C72,   1, 1,      1 },
+  { 0x02C75,   1, 1,      1 },
+  { 0x02C7E,   2, 1, -10815 },
+  { 0x02C80,  50, 2,      1 },
+  { 0x02CEB,   2, 2,      1 },
+  { 0x02CF2,   1, 1,      1 },
+  { 0x0A640,  23, 2,      1 },
+  { 0x0A680,  14, 2,      1 },
+  { 0x0A722,   7, 2,      1 },
+  { 0x0A732,  31, 2,      1 },
+  { 0x0A779,   2, 2,      1 },
+  { 0x0A77D,   1, 1, -35332 },
+  { 0x0A77E,   5, 2,      1 },
+  { 0x0A78B,   1, 1,      1 },
+  { 0x0A78D,   1, 1, -42280 },
+  { 0x0A790,   2, 2,      1 },
+  { 0x0A796,  10, 2,      1 },
+  { 0x0A7AA,   1, 1, -42308 },
+  { 0x0A7AB,   1, 1, -42319 },
+  { 0x0A7AC,   1, 1, -42315 },
+  { 0x0A7AD,   1, 1, -42305 },
+  { 0x0A7AE,   1, 1, -42308 },
+  { 0x0A7B0,   1, 1, -42258 },
+  { 0x0A7B1,   1, 1, -42282 },
+  { 0x0A7B2,   1, 1, -42261 },
+  { 0x0A7B3,   1, 1,    928 },
+  { 0x0A7B4,   8, 2,      1 },
+  { 0x0A7C4,   1, 1,    -48 },
+  { 0x0A7C5,   1, 1, -42307 },
+  { 0x0A7C6,   1, 1, -35384 },
+  { 0x0A7C7,   2, 2,      1 },
+  { 0x0A7D0,   1, 1,      1 },
+  { 0x0A7D6,   2, 2,      1 },
+  { 0x0A7F5,   1, 1,      1 },
+  { 0x0AB70,  80, 1, -38864 },
+  { 0x0FF21,  26, 1,     32 },
+  { 0x10400,  40, 1,     40 },
+  { 0x104B0,  36, 1,     40 },
+  { 0x10570,  11, 1,     39 },
+  { 0x1057C,  15, 1,     39 },
+  { 0x1058C,   7, 1,     39 },
+  { 0x10594,   2, 1,     39 },
+  { 0x10C80,  51, 1,     64 },
+  { 0x118A0,  32, 1,     32 },
+  { 0x16E40,  32, 1,     32 },
+  { 0x1E900,  34, 1,     34 }
+
+};
+
+static inline wxUint32 wxSQLite3FoldAscii(wxUint32 c)
+{
+  return (c >= 'A' && c <= 'Z') ? c + 0x20 : c;
+}
+
+static wxUint32 wxSQLite3FoldCase(wxUint32 c)
+{
+  if (c < 0x80)
+  {
+    return wxSQLite3FoldAscii(c);
+  }
+  // Binary search for the last range starting at or before c
+  size_t lo = 0;
+  size_t hi = sizeof(gs_caseFoldRanges) / sizeof(gs_caseFoldRanges[0]);
+  while (lo < hi)
+  {
+    size_t mid = (lo + hi) / 2;
+    if (gs_caseFoldRanges[mid].m_first <= c)
+    {
+      lo = mid + 1;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+  if (lo > 0)
+  {
+    const wxSQLite3CaseFoldRange& range = gs_caseFoldRanges[lo-1];
+    wxUint32 offset = c - range.m_first;
+    if (offset < (wxUint32) range.m_count * range.m_stride && offset % range.m_stride == 0)
+    {
+      return (wxUint32) ((int) c + range.m_delta);
+    }
+  }
+  return c;
+}
+
+// Decode a UTF-8 character from a NUL terminated string
+static inline wxUint32 wxSQLite3ReadUtf8(const unsigned char*& p)
+{
+  wxUint32 c = *p++;
+  if (c >= 0xC0)
+  {
+    c &= (c >= 0xF0) ? 0x07 : ((c >= 0xE0) ? 0x0F : 0x1F);
+    while ((*p & 0xC0) == 0x80)
+    {
+      c = (c << 6) + (*p++ & 0x3F);
+    }
+  }
+  return c;
+}
+
+// Decode a UTF-8 character from a string of given length (p < end)
+static inline wxUint32 wxSQLite3ReadUtf8(const unsigned char*& p, const unsigned char* end)
+{
+  wxUint32 c = *p++;
+  if (c >= 0xC0)
+  {
+    c &= (c >= 0xF0) ? 0x07 : ((c >= 0xE0) ? 0x0F : 0x1F);
+    while (p < end && (*p & 0xC0) == 0x80)
+    {
+      c = (c << 6) + (*p++ & 0x3F);
+    }
+  }
+  return c;
+}
+
+static inline int wxSQLite3CountTrailingZeros(unsigned int x)
+{
+#if defined(__GNUC__)
+  return __builtin_ctz(x);
+#elif defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, x);
+  return (int) index;
+#else
+  int n = 0;
+  while ((x & 1) == 0)
+  {
+    x >>= 1;
+    ++n;
+  }
+  return n;
+#endif
+}
+
+#if WXSQLITE3_HAVE_SSE2
+static inline __m128i wxSQLite3FoldAscii128(__m128i x)
+{
+  __m128i isUpper = _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8('A' - 1)),
+                                  _mm_cmplt_epi8(x, _mm_set1_epi8('Z' + 1)));
+  return _mm_add_epi8(x, _mm_and_si128(isUpper, _mm_set1_epi8(0x20)));
+}
+#endif
+
+#if WXSQLITE3_HAVE_AVX2
+static inline __m256i wxSQLite3FoldAscii256(__m256i x)
+{
+  __m256i isUpper = _mm256_and_si256(_mm256_cmpgt_epi8(x, _mm256_set1_epi8('A' - 1)),
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), x));
+  return _mm256_add_epi8(x, _mm256_and_si256(isUpper, _mm256_set1_epi8(0x20)));
+}
+#endif
+
+// Collation function comparing texts after Unicode case folding
+static int wxSQLite3UnicodeNoCaseCompare(void* WXUNUSED(collation), int len1, const void* text1, int len2, const void* text2)
+{
+  const unsigned char* p1 = (const unsigned char*) text1;
+  const unsigned char* p2 = (const unsigned char*) text2;
+  const unsigned char* end1 = p1 + len1;
+  const unsigned char* end2 = p2 + len2;
+  while (p1 < end1 && p2 < end2)
+  {
+    // Process blocks of ASCII characters in parallel
+#if WXSQLITE3_HAVE_AVX2
+    while (end1 - p1 >= 32 && end2 - p2 >= 32)
+    {
+      __m256i a = _mm256_loadu_si256((const __m256i*) p1);
+      __m256i b = _mm256_loadu_si256((const __m256i*) p2);
+      if (_mm256_movemask_epi8(_mm256_or_si256(a, b)) != 0)
+      {
+        break;
+      }
+      unsigned int diff = ~((unsigned int) _mm256_movemask_epi8(_mm256_cmpeq_epi8(wxSQLite3FoldAscii256(a), wxSQLite3FoldAscii256(b))));
+      if (diff != 0)
+      {
+        int k = wxSQLite3CountTrailingZeros(diff);
+        return (int) wxSQLite3FoldAscii(p1[k]) - (int) wxSQLite3FoldAscii(p2[k]);
+      }
+      p1 += 32;
+      p2 += 32;
+    }
+#endif
+#if WXSQLITE3_HAVE_SSE2
+    while (end1 - p1 >= 16 && end2 - p2 >= 16)
+    {
+      __m128i a = _mm_loadu_si128((const __m128i*) p1);
+      __m128i b = _mm_loadu_si128((const __m128i*) p2);
+      if (_mm_movemask_epi8(_mm_or_si128(a, b)) != 0)
+      {
+        break;
+      }
+      unsigned int diff = 0xFFFFu & ~((unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(wxSQLite3FoldAscii128(a), wxSQLite3FoldAscii128(b))));
+      if (diff != 0)
+      {
+        int k = wxSQLite3CountTrailingZeros(diff);
+        return (int) wxSQLite3FoldAscii(p1[k]) - (int) wxSQLite3FoldAscii(p2[k]);
+      }
+      p1 += 16;
+      p2 += 16;
+    }
+#endif
+    if (p1 >= end1 || p2 >= end2)
+    {
+      break;
+    }
+    wxUint32 c1;
+    wxUint32 c2;
+    if (*p1 < 0x80 && *p2 < 0x80)
+    {
+      c1 = wxSQLite3FoldAscii(*p1++);
+      c2 = wxSQLite3FoldAscii(*p2++);
+    }
+    else
+    {
+      c1 = wxSQLite3FoldCase(wxSQLite3ReadUtf8(p1, end1));
+      c2 = wxSQLite3FoldCase(wxSQLite3ReadUtf8(p2, end2));
+    }
+    if (c1 != c2)
+    {
+      return (c1 < c2) ? -1 : 1;
+    }
+  }
+  return (p1 < end1) ? 1 : ((p2 < end2) ? -1 : 0);
+}
+
+// Find the first byte equal to c1, c2 or NUL in [p, end); returns end if there is none
+static const unsigned char* wxSQLite3FindAsciiStop(const unsigned char* p, const unsigned char* end, unsigned char c1, unsigned char c2)
+{
+#if WXSQLITE3_HAVE_AVX2
+  const __m256i v1 = _mm256_set1_epi8((char) c1);
+  const __m256i v2 = _mm256_set1_epi8((char) c2);
+  const __m256i zero = _mm256_setzero_si256();
+  while (end - p >= 32)
+  {
+    __m256i x = _mm256_loadu_si256((const __m256i*) p);
+    __m256i hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, v1), _mm256_cmpeq_epi8(x, v2)), _mm256_cmpeq_epi8(x, zero));
+    unsigned int mask = (unsigned int) _mm256_movemask_epi8(hit);
+    if (mask != 0)
+    {
+      return p + wxSQLite3CountTrailingZeros(mask);
+    }
+    p += 32;
+  }
+#endif
+#if WXSQLITE3_HAVE_SSE2
+  const __m128i w1 = _mm_set1_epi8((char) c1);
+  const __m128i w2 = _mm_set1_epi8((char) c2);
+  const __m128i wzero = _mm_setzero_si128();
+  while (end - p >= 16)
+  {
+    __m128i x = _mm_loadu_si128((const __m128i*) p);
+    __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, w1), _mm_cmpeq_epi8(x, w2)), _mm_cmpeq_epi8(x, wzero));
+    unsigned int mask = (unsigned int) _mm_movemask_epi8(hit);
+    if (mask != 0)
+    {
+      return p + wxSQLite3CountTrailingZeros(mask);
+    }
+    p += 16;
+  }
+#endif
+  while (p < end && *p != c1 && *p != c2 && *p != 0)
+  {
+    ++p;
+  }
+  return p;
+}
+
+/// Pattern syntax of LIKE and GLOB (internal)
+struct wxSQLite3PatternInfo
+{
+  wxUint32 m_matchAll; ///< Wildcard matching any sequence of characters
+  wxUint32 m_matchOne; ///< Wildcard matching a single character
+  wxUint32 m_matchSet; ///< Start of a character set, or 0 for LIKE
+  bool     m_noCase;   ///< Flag whether the comparison is case-insensitive
+};
+
+static const wxSQLite3PatternInfo gs_likeInfo      = { '%', '_',   0, true  };
+static const wxSQLite3PatternInfo gs_globInfo      = { '*', '?', '[', false };
+static const wxSQLite3PatternInfo gs_globNoCaseInfo = { '*', '?', '[', true  };
+
+enum
+{
+  WXSQLITE3_PATTERN_MATCH = 0,
+  WXSQLITE3_PATTERN_NOMATCH = 1,
+  WXSQLITE3_PATTERN_NOWILDCARDMATCH = 2
+};
+
+// Match a UTF-8 string against a LIKE or GLOB pattern
+// (same semantics as the SQLite built-in functions, but with Unicode case folding)
+static int wxSQLite3PatternCompare(const unsigned char* pattern, const unsigned char* text, const unsigned char* textEnd,
+                                   const wxSQLite3PatternInfo* info, wxUint32 matchOther)
+{
+  wxUint32 c;
+  wxUint32 c2;
+  wxUint32 matchOne = info->m_matchOne;
+  wxUint32 matchAll = info->m_matchAll;
+  bool noCase = info->m_noCase;
+  const unsigned char* escaped = NULL;
+  while ((c = wxSQLite3ReadUtf8(pattern)) != 0)
+  {
+    if (c == matchAll)
+    {
+      // Skip further wildcards; each single character wildcard consumes one character
+      while ((c = wxSQLite3ReadUtf8(pattern)) == matchAll || (c == matchOne && matchOne != 0))
+      {
+        if (c == matchOne && wxSQLite3ReadUtf8(text) == 0)
+        {
+          return WXSQLITE3_PATTERN_NOWILDCARDMATCH;
+        }
+      }
+      if (c == 0)
+      {
+        return WXSQLITE3_PATTERN_MATCH;
+      }
+      else if (c == matchOther)
+      {
+        if (info->m_matchSet == 0)
+        {
+          c = wxSQLite3ReadUtf8(pattern);
+          if (c == 0)
+          {
+            return WXSQLITE3_PATTERN_NOWILDCARDMATCH;
+          }
+        }
+        else
+        {
+          while (*text != 0)
+          {
+            int match = wxSQLite3PatternCompare(pattern - 1, text, textEnd, info, matchOther);
+            if (match != WXSQLITE3_PATTERN_NOMATCH)
+            {
+              return match;
+            }
+            wxSQLite3ReadUtf8(text);
+          }
+          return WXSQLITE3_PATTERN_NOWILDCARDMATCH;
+        }
+      }
+      // The characters KELVIN SIGN and LATIN SMALL LETTER LONG S fold to ASCII letters
+      if (c < 0x80 && !(noCase && (c == 'k' || c == 'K' || c == 's' || c == 'S')))
+      {
+        // Scan for candidate positions of the next literal character
+        unsigned char stop1 = (unsigned char) c;
+        unsigned char stop2 = (unsigned char) c;
+        if (noCase && wxSQLite3FoldAscii(c) != c)
+        {
+          stop1 = (unsigned char) (c + 0x20);
+        }
+        else if (noCase && c >= 'a' && c <= 'z')
+        {
+          stop2 = (unsigned char) (c - 0x20);
+        }
+        for (;;)
+        {
+          text = wxSQLite3FindAsciiStop(text, textEnd, stop1, stop2);
+          if (text >= textEnd || *text == 0)
+          {
+            break;
+          }
+          ++text;
+          int match = wxSQLite3PatternCompare(pattern, text, textEnd, info, matchOther);
+          if (match != WXSQLITE3_PATTERN_NOMATCH)
+          {
+            return match;
+          }
+        }
+      }
+      else
+      {
+        wxUint32 folded = (noCase) ? wxSQLite3FoldCase(c) : c;
+        while ((c2 = wxSQLite3ReadUtf8(text)) != 0)
+        {
+          if (c2 != c && (!noCase || wxSQLite3FoldCase(c2) != folded))
+          {
+            continue;
+          }
+          int match = wxSQLite3PatternCompare(pattern, text, textEnd, info, matchOther);
+          if (match != WXSQLITE3_PATTERN_NOMATCH)
+          {
+            return match;
+          }
+        }
+      }
+      return WXSQLITE3_PATTERN_NOWILDCARDMATCH;
+    }
+    if (c == matchOther)
+    {
+      if (info->m_matchSet == 0)
+      {
+        c = wxSQLite3ReadUtf8(pattern);
+        if (c == 0)
+        {
+          return WXSQLITE3_PATTERN_NOMATCH;
+        }
+        escaped = pattern;
+      }
+      else
+      {
+        // Character set like [a-z] or [^0-9]
+        wxUint32 prior = 0;
+        bool seen = false;
+        bool invert = false;
+        c = wxSQLite3ReadUtf8(text);
+        if (c == 0)
+        {
+          return WXSQLITE3_PATTERN_NOMATCH;
+        }
+        wxUint32 folded = (noCase) ? wxSQLite3FoldCase(c) : c;
+        c2 = wxSQLite3ReadUtf8(pattern);
+        if (c2 == '^')
+        {
+          invert = true;
+          c2 = wxSQLite3ReadUtf8(pattern);
+        }
+        if (c2 == ']')
+        {
+          if (c == ']')
+          {
+            seen = true;
+          }
+          c2 = wxSQLite3ReadUtf8(pattern);
+        }
+        while (c2 != 0 && c2 != ']')
+        {
+          if (c2 == '-' && pattern[0] != ']' && pattern[0] != 0 && prior > 0)
+          {
+            c2 = wxSQLite3ReadUtf8(pattern);
+            if ((c >= prior && c <= c2) ||
+                (noCase && folded >= wxSQLite3FoldCase(prior) && folded <= wxSQLite3FoldCase(c2)))
+            {
+              seen = true;
+            }
+            prior = 0;
+          }
+          else
+          {
+            if (c == c2 || (noCase && folded == wxSQLite3FoldCase(c2)))
+            {
+              seen = true;
+            }
+            prior = c2;
+          }
+          c2 = wxSQLite3ReadUtf8(pattern);
+        }
+        if (c2 == 0 || seen == invert)
+        {
+          return WXSQLITE3_PATTERN_NOMATCH;
+        }
+        continue;
+      }
+    }
+    c2 = wxSQLite3ReadUtf8(text);
+    if (c == c2)
+    {
+      continue;
+    }
+    if (noCase && c2 != 0 && wxSQLite3FoldCase(c) == wxSQLite3FoldCase(c2))
+    {
+      continue;
+    }
+    if (c == matchOne && pattern != escaped && c2 != 0)
+    {
+      continue;
+    }
+    return WXSQLITE3_PATTERN_NOMATCH;
+  }
+  return (*text == 0) ? WXSQLITE3_PATTERN_MATCH : WXSQLITE3_PATTERN_NOMATCH;
+}
+
+// Implementation of the SQL functions like(pattern, text [, escape]) and glob(pattern, text)
+static void wxSQLite3UnicodeLikeFunction(sqlite3_context* ctx, int argc, sqlite3_value** argv)
+{
+  const wxSQLite3PatternInfo* info = (const wxSQLite3PatternInfo*) sqlite3_user_data(ctx);
+  wxSQLite3PatternInfo escapeInfo;
+  const unsigned char* pattern = sqlite3_value_text(argv[0]);
+  int patternLen = sqlite3_value_bytes(argv[0]);
+  if (patternLen > sqlite3_limit(sqlite3_context_db_handle(ctx), SQLITE_LIMIT_LIKE_PATTERN_LENGTH, -1))
+  {
+    sqlite3_result_error(ctx, "LIKE or GLOB pattern too complex", -1);
+    return;
+  }
+  wxUint32 escape = info->m_matchSet;
+  if (argc == 3)
+  {
+    const unsigned char* escapeText = sqlite3_value_text(argv[2]);
+    if (escapeText == NULL)
+    {
+      return;
+    }
+    escape = wxSQLite3ReadUtf8(escapeText);
+    if (escape == 0 || *escapeText != 0)
+    {
+      sqlite3_result_error(ctx, "ESCAPE expression must be a single character", -1);
+      return;
+    }
+    if (escape == info->m_matchAll || escape == info->m_matchOne)
+    {
+      // The escape character disables the wildcard it coincides with
+      escapeInfo = *info;
+      if (escape == info->m_matchAll) escapeInfo.m_matchAll = 0;
+      if (escape == info->m_matchOne) escapeInfo.m_matchOne = 0;
+      info = &escapeInfo;
+    }
+  }
+  const unsigned char* text = sqlite3_value_text(argv[1]);
+  if (pattern == NULL || text == NULL)
+  {
+    return;
+  }
+  const unsigned char* textEnd = text + sqlite3_value_bytes(argv[1]);
+  sqlite3_result_int(ctx, wxSQLite3PatternCompare(pattern, text, textEnd, info, escape) == WXSQLITE3_PATTERN_MATCH);
+}
+
+void wxSQLite3Database::SetUnicodeNoCaseCollation(const wxString& collationName)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  wxCharBuffer strCollationName = collationName.ToUTF8();
+  const char* localCollationName = strCollationName;
+  int rc = sqlite3_create_collation(m_db->m_db, localCollationName, SQLITE_UTF8, NULL, wxSQLite3UnicodeNoCaseCompare);
+  if (rc != SQLITE_OK)
+  {
+    const char* localError = sqlite3_errmsg(m_db->m_db);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
+}
+
+void wxSQLite3Database::SetUnicodeLikeFunctions(bool caseInsensitiveGlob)
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  int flags = SQLITE_UTF8 | SQLITE_DETERMINISTIC | SQLITE_INNOCUOUS;
+  void* globInfo = (void*) ((caseInsensitiveGlob) ? &gs_globNoCaseInfo : &gs_globInfo);
+  int rc = sqlite3_create_function(m_db->m_db, "like", 2, flags, (void*) &gs_likeInfo, wxSQLite3UnicodeLikeFunction, NULL, NULL);
+  if (rc == SQLITE_OK)
+  {
+    rc = sqlite3_create_function(m_db->m_db, "like", 3, flags, (void*) &gs_likeInfo, wxSQLite3UnicodeLikeFunction, NULL, NULL);
+  }
+  if (rc == SQLITE_OK)
+  {
+    rc = sqlite3_create_function(m_db->m_db, "glob", 2, flags, globInfo, wxSQLite3UnicodeLikeFunction, NULL, NULL);
+  }
+  if (rc != SQLITE_OK)
+  {
+    const char* localError = sqlite3_errmsg(m_db->m_db);
+    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+  }
+}
+
+// --- Statistical aggregate and window functions
+
+static const double gs_pi = 3.14159265358979323846;
+
+// Get a numeric function argument; NULL and non-numeric values are ignored
+static bool wxSQLite3StatGetDouble(sqlite3_value* value, double& x)
+{
+  int type = sqlite3_value_numeric_type(value);
+  if (type == SQLITE_INTEGER || type == SQLITE_FLOAT)
+  {
+    x = sqlite3_value_double(value);
+    return true;
+  }
+  return false;
+}
+
+// Get the fraction argument of a percentile function, which must be the same for all rows
+static bool wxSQLite3StatGetFraction(sqlite3_context* ctx, sqlite3_value* value, double& fraction, bool& hasFraction)
+{
+  double f;
+  if (!wxSQLite3StatGetDouble(value, f) || f < 0.0 || f > 1.0)
+  {
+    sqlite3_result_error(ctx, "fraction must be a number between 0.0 and 1.0", -1);
+    return false;
+  }
+  if (hasFraction && f != fraction)
+  {
+    sqlite3_result_error(ctx, "fraction must be the same for all rows", -1);
+    return false;
+  }
+  fraction = f;
+  hasFraction = true;
+  return true;
+}
+
+/// State of the variance and standard deviation functions (internal)
+struct wxSQLite3VarianceState
+{
+  sqlite3_int64 m_count; ///< Number of values
+  double        m_mean;  ///< Running mean
+  double        m_m2;    ///< Sum of squared deviations from the mean
+};
+
+/// Kind of variance function (internal)
+struct wxSQLite3VarianceInfo
+{
+  bool m_sample; ///< Flag whether the sample (or the population) variance is calculated
+  bool m_stddev; ///< Flag whether the standard deviation (or the variance) is returned
+};
+
+static const wxSQLite3VarianceInfo gs_varSampInfo    = { true,  false };
+static const wxSQLite3VarianceInfo gs_varPopInfo     = { false, false };
+static const wxSQLite3VarianceInfo gs_stddevSampInfo = { true,  true  };
+static const wxSQLite3VarianceInfo gs_stddevPopInfo  = { false, true  };
+
+// Welford's online algorithm
+static void wxSQLite3VarianceStep(sqlite3_context* ctx, int WXUNUSED(argc), sqlite3_value** argv)
+{
+  double x;
+  if (wxSQLite3StatGetDouble(argv[0], x))
+  {
+    wxSQLite3VarianceState* state = (wxSQLite3VarianceState*) sqlite3_aggregate_context(ctx, sizeof(wxSQLite3VarianceState));
+    if (state == NULL)
+    {
+      sqlite3_result_error_nomem(ctx);
+      return;
+    }
+    state->m_count++;
+    double delta = x - state->m_mean;
+    state->m_mean += delta / (double) state->m_count;
+    state->m_m2 += delta * (x - state->m_mean);
+  }
+}
+
+static void wxSQLite3VarianceInverse(sqlite3_context* ctx, int WXUNUSED(argc), sqlite3_value** argv)
+{
+  double x;
+  if (wxSQLite3StatGetDouble(argv[0], x))
+  {
+    wxSQLite3VarianceState* state = (wxSQLite3VarianceState*) sqlite3_aggregate_context(ctx, sizeof(wxSQLite3VarianceState));
+    if (state == NULL)
+    {
+      sqlite3_result_error_nomem(ctx);
+      return;
+    }
+    if (state->m_count <= 1)
+    {
+      state->m_count = 0;
+      state->m_mean = 0.0;
+      state->m_m2 = 0.0;
+    }
+    else
+    {
+      state->m_count--;
+      double delta = x - state->m_mean;
+      state->m_mean -= delta / (double) state->m_count;
+      state->m_m2 -= delta * (x - state->m_mean);
+      if (state->m_m2 < 0.0)
+      {
+        state->m_m2 = 0.0;
+      }
+    }
+  }
+}
+
+static void wxSQLite3VarianceValue(sqlite3_context* ctx)
+{
+  const wxSQLite3VarianceInfo* info = (const wxSQLite3VarianceInfo*) sqlite3_user_data(ctx);
+  wxSQLite3VarianceState* state = (wxSQLite3VarianceState*) sqlite3_aggregate_context(ctx, 0);
+  sqlite3_int64 count = (state != NULL) ? state->m_count : 0;
+  if (count == 0 || (info->m_sample && count < 2))
+  {
+    sqlite3_result_null(ctx);
+  }
+  else
+  {
+    double variance = state->m_m2 / (double) ((info->m_sample) ? count - 1 : count);
+    sqlite3_result_double(ctx, (info->m_stddev) ? sqrt(variance) : variance);
+  }
+}
+
+/// State of the exact percentile functions (internal)
+/**
+* Values are appended unsorted and sorted once for the aggregate result. Used as
+* a window function, the values are kept in ascending order from the first
+* intermediate result or removal on, since the frame is evaluated for every row.
+*/
+struct wxSQLite3PercentileState
+{
+  double* m_values;      ///< Values, in ascending order unless m_unsorted is set
+  int     m_count;       ///< Number of values
+  int     m_capacity;    ///< Capacity of the value array
+  double  m_fraction;    ///< Requested fraction
+  bool    m_hasFraction; ///< Flag whether the fraction is known
+  bool    m_unsorted;    ///< Flag whether values were appended since the last sort
+  bool    m_window;      ///< Flag whether values are kept sorted (window function usage)
+};
+
+/// Kind of percentile function (internal)
+struct wxSQLite3PercentileInfo
+{
+  bool m_median;   ///< Flag whether the function is the median (no fraction argument)
+  bool m_discrete; ///< Flag whether the function returns one of the values
+};
+
+static const wxSQLite3PercentileInfo gs_medianInfo         = { true,  false };
+static const wxSQLite3PercentileInfo gs_percentileContInfo = { false, false };
+static const wxSQLite3PercentileInfo gs_percentileDiscInfo = { false, true  };
+
+// Index of the first value greater than (upper) or not less than (lower) x
+static int wxSQLite3PercentileSearch(const wxSQLite3PercentileState* state, double x, bool upper)
+{
+  int lo = 0;
+  int hi = state->m_count;
+  while (lo < hi)
+  {
+    int mid = lo + (hi - lo) / 2;
+    if ((upper) ? (state->m_values[mid] <= x) : (state->m_values[mid] < x))
+    {
+      lo = mid + 1;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+static int wxSQLite3PercentileCompare(const void* p1, const void* p2)
+{
+  double x1 = *(const double*) p1;
+  double x2 = *(const double*) p2;
+  return (x1 < x2) ? -1 : ((x1 > x2) ? 1 : 0);
+}
+
+static void wxSQLite3PercentileSort(wxSQLite3PercentileState* state)
+{
+  if (state->m_unsorted)
+  {
+    qsort(state->m_values, (size_t) state->m_count, sizeof(double), wxSQLite3PercentileCompare);
+    state->m_unsorted = false;
+  }
+}
+
+static wxSQLite3PercentileState* wxSQLite3PercentileGetState(sqlite3_context* ctx, int argc, sqlite3_value** argv, double& x)
+{
+  const wxSQLite3PercentileInfo* info = (const wxSQLite3PercentileInfo*) sqlite3_user_data(ctx);
+  wxSQLite3PercentileState* state = (wxSQLite3PercentileState*) sqlite3_aggregate_context(ctx, sizeof(wxSQLite3PercentileState));
+  if (state == NULL)
+  {
+    sqlite3_result_error_nomem(ctx);
+    return NULL;
+  }
+  if (info->m_median)
+  {
+    state->m_fraction = 0.5;
+    state->m_hasFraction = true;
+  }
+  else if (argc < 2 || !wxSQLite3StatGetFraction(ctx, argv[1], state->m_fraction, state->m_hasFraction))
+  {
+    return NULL;
+  }
+  return (wxSQLite3StatGetDouble(argv[0], x)) ? state : NULL;
+}
+
+static void wxSQLite3PercentileStep(sqlite3_context* ctx, int argc, sqlite3_value** argv)
+{
+  double x;
+  wxSQLite3PercentileState* state = wxSQLite3PercentileGetState(ctx, argc, argv, x);
+  if (state != NULL)
+  {
+    if (state->m_count == state->m_capacity)
+    {
+      int capacity = (state->m_capacity > 0) ? 2 * state->m_capacity : 16;
+      double* values = (double*) sqlite3_realloc64(state->m_values, (sqlite3_uint64) capacity * sizeof(double));
+      if (values == NULL)
+      {
+        sqlite3_result_error_nomem(ctx);
+        return;
+      }
+      state->m_values = values;
+      state->m_capacity = capacity;
+    }
+    if (state->m_window)
+    {
+      // Window frame: keep the values sorted for the next result or removal
+      int pos = wxSQLite3PercentileSearch(state, x, true);
+      memmove(&state->m_values[pos+1], &state->m_values[pos], (size_t) (state->m_count - pos) * sizeof(double));
+      state->m_values[pos] = x;
+    }
+    else
+    {
+      if (state->m_count > 0 && x < state->m_values[state->m_count-1])
+      {
+        state->m_unsorted = true;
+      }
+      state->m_values[state->m_count] = x;
+    }
+    state->m_count++;
+  }
+}
+
+static void wxSQLite3PercentileInverse(sqlite3_context* ctx, int argc, sqlite3_value** argv)
+{
+  double x;
+  wxSQLite3PercentileState* state = wxSQLite3PercentileGetState(ctx, argc, argv, x);
+  if (state != NULL)
+  {
+    wxSQLite3PercentileSort(state);
+    state->m_window = true;
+    int pos = wxSQLite3PercentileSearch(state, x, false);
+    if (pos < state->m_count && state->m_values[pos] == x)
+    {
+      state->m_count--;
+      memmove(&state->m_values[pos], &state->m_values[pos+1], (size_t) (state->m_count - pos) * sizeof(double));
+    }
+  }
+}
+
+static void wxSQLite3PercentileResult(sqlite3_context* ctx, wxSQLite3PercentileState* state)
+{
+  const wxSQLite3PercentileInfo* info = (const wxSQLite3PercentileInfo*) sqlite3_user_data(ctx);
+  if (state == NULL || state->m_count == 0)
+  {
+    sqlite3_result_null(ctx);
+    return;
+  }
+  wxSQLite3PercentileSort(state);
+  if (info->m_discrete)
+  {
+    // Smallest value whose cumulative distribution is not less than the fraction
+    int index = (int) ceil(state->m_fraction * state->m_count) - 1;
+    if (index < 0) index = 0;
+    if (index >= state->m_count) index = state->m_count - 1;
+    sqlite3_result_double(ctx, state->m_values[index]);
+  }
+  else
+  {
+    // Linear interpolation between the adjacent values
+    double position = state->m_fraction * (state->m_count - 1);
+    int index = (int) floor(position);
+    double value = state->m_values[index];
+    if (index + 1 < state->m_count)
+    {
+      value += (position - index) * (state->m_values[index+1] - value);
+    }
+    sqlite3_result_double(ctx, value);
+  }
+}
+
+static void wxSQLite3PercentileValue(sqlite3_context* ctx)
+{
+  wxSQLite3PercentileState* state = (wxSQLite3PercentileState*) sqlite3_aggregate_context(ctx, 0);
+  wxSQLite3PercentileResult(ctx, state);
+  if (state != NULL)
+  {
+    // A growing frame would otherwise be sorted again for every row
+    state->m_window = true;
+  }
+}
+
+static void wxSQLite3PercentileFinal(sqlite3_context* ctx)
+{
+  wxSQLite3PercentileState* state = (wxSQLite3PercentileState*) sqlite3_aggregate_context(ctx, 0);
+  wxSQLite3PercentileResult(ctx, state);
+  if (state != NULL)
+  {
+    sqlite3_free(state->m_values);
+    state->m_values = NULL;
+  }
+}
+
+/// Merging t-digest for the estimation of quantiles (internal)
+/**
+* The digest consists of centroids (mean and weight), whose size is limited by the
+* scale function k1(q) = compression / (2 pi) * asin(2q - 1), so that the centroids
+* near the extreme quantiles are small. New values are buffered and merged in batches.
+*/
+class wxSQLite3TDigest
+{
+public:
+  /// Centroid of the digest
+  struct Centroid
+  {
+    double m_mean;   ///< Mean of the values represented by the centroid
+    double m_weight; ///< Number of values represented by the centroid
+  };
+
+  wxSQLite3TDigest(double compression)
+    : m_centroids(NULL), m_count(0), m_merged(0), m_capacity(0),
+      m_compression(compression), m_totalWeight(0.0), m_min(0.0), m_max(0.0)
+  {
+  }
+
+  ~wxSQLite3TDigest()
+  {
+    sqlite3_free(m_centroids);
+  }
+
+  double GetCompression() const { return m_compression; }
+  double GetTotalWeight() const { return m_totalWeight; }
+  double GetMin() const { return m_min; }
+  double GetMax() const { return m_max; }
+  int GetCentroidCount() { Compress(); return m_count; }
+  const Centroid* GetCentroids() { Compress(); return m_centroids; }
+
+  /// Add a value with the given weight
+  bool Add(double value, double weight = 1.0)
+  {
+    if (m_capacity == 0)
+    {
+      // Room for the merged centroids plus a buffer of unmerged values
+      int capacity = 6 * (int) ceil(m_compression) + 10;
+      m_centroids = (Centroid*) sqlite3_malloc64((sqlite3_uint64) capacity * sizeof(Centroid));
+      if (m_centroids == NULL)
+      {
+        return false;
+      }
+      m_capacity = capacity;
+    }
+    if (m_count == m_capacity)
+    {
+      Compress();
+    }
+    if (m_totalWeight == 0.0 || value < m_min) m_min = value;
+    if (m_totalWeight == 0.0 || value > m_max) m_max = value;
+    m_centroids[m_count].m_mean = value;
+    m_centroids[m_count].m_weight = weight;
+    m_count++;
+    m_totalWeight += weight;
+    return true;
+  }
+
+  /// Merge the centroids of another digest into this digest
+  bool Merge(wxSQLite3TDigest& other)
+  {
+    int count = other.GetCentroidCount();
+    const Centroid* centroids = other.GetCentroids();
+    double minValue = other.m_min;
+    double maxValue = other.m_max;
+    bool empty = (m_totalWeight == 0.0);
+    int j;
+    for (j = 0; j < count; ++j)
+    {
+      if (!Add(centroids[j].m_mean, centroids[j].m_weight))
+      {
+        return false;
+      }
+    }
+    if (count > 0)
+    {
+      if (empty || minValue < m_min) m_min = minValue;
+      if (empty || maxValue > m_max) m_max = maxValue;
+    }
+    return true;
+  }
+
+  /// Extend the value range, after restoring centroids whose extreme values are known
+  void ExtendRange(double minValue, double maxValue)
+  {
+    if (m_totalWeight > 0.0)
+    {
+      if (minValue < m_min) m_min = minValue;
+      if (maxValue > m_max) m_max = maxValue;
+    }
+  }
+
+  /// Estimate the quantile q (0 <= q <= 1)
+  double Quantile(double q)
+  {
+    Compress();
+    if (m_count == 1)
+    {
+      return m_centroids[0].m_mean;
+    }
+    double index = q * m_totalWeight;
+    const Centroid& first = m_centroids[0];
+    const Centroid& last = m_centroids[m_count-1];
+    if (index <= first.m_weight / 2.0)
+    {
+      return m_min + ((first.m_weight > 0.0) ? 2.0 * index / first.m_weight : 0.0) * (first.m_mean - m_min);
+    }
+    if (index >= m_totalWeight - last.m_weight / 2.0)
+    {
+      double tail = m_totalWeight - index;
+      return m_max - ((last.m_weight > 0.0) ? 2.0 * tail / last.m_weight : 0.0) * (m_max - last.m_mean);
+    }
+    double cumulative = first.m_weight / 2.0;
+    int j;
+    for (j = 0; j + 1 < m_count; ++j)
+    {
+      double next = cumulative + (m_centroids[j].m_weight + m_centroids[j+1].m_weight) / 2.0;
+      if (index < next)
+      {
+        double t = (index - cumulative) / (next - cumulative);
+        return m_centroids[j].m_mean + t * (m_centroids[j+1].m_mean - m_centroids[j].m_mean);
+      }
+      cumulative = next;
+    }
+    return m_max;
+  }
+
+private:
+  static int CompareCentroids(const void* p1, const void* p2)
+  {
+    double m1 = ((const Centroid*) p1)->m_mean;
+    double m2 = ((const Centroid*) p2)->m_mean;
+    return (m1 < m2) ? -1 : ((m1 > m2) ? 1 : 0);
+  }
+
+  // Inverse of the scale function
+  double GetQuantileLimit(double k) const
+  {
+    double x = 2.0 * gs_pi * k / m_compression;
+    return (x >= gs_pi / 2.0) ? 1.0 : (sin(x) + 1.0) / 2.0;
+  }
+
+  void Compress()
+  {
+    if (m_merged == m_count)
+    {
+      return;
+    }
+    qsort(m_centroids, (size_t) m_count, sizeof(Centroid), CompareCentroids);
+    int out = 0;
+    double weightSoFar = 0.0;
+    double limit = m_totalWeight * GetQuantileLimit(-m_compression / 4.0 + 1.0);
+    Centroid current = m_centroids[0];
+    int j;
+    for (j = 1; j < m_count; ++j)
+    {
+      const Centroid& next = m_centroids[j];
+      if (weightSoFar + current.m_weight + next.m_weight <= limit)
+      {
+        current.m_weight += next.m_weight;
+        current.m_mean += (next.m_mean - current.m_mean) * next.m_weight / current.m_weight;
+      }
+      else
+      {
+        weightSoFar += current.m_weight;
+        m_centroids[out++] = current;
+        double q = weightSoFar / m_totalWeight;
+        double k = m_compression / (2.0 * gs_pi) * asin(2.0 * q - 1.0);
+        limit = m_totalWeight * GetQuantileLimit(k + 1.0);
+        current = next;
+      }
+    }
+    m_centroids[out++] = current;
+    m_count = out;
+    m_merged = out;
+  }
+
+  Centroid* m_centroids;   ///< Merged centroids followed by unmerged values
+  int       m_count;       ///< Number of centroids
+  int       m_merged;      ///< Number of merged centroids
+  int       m_capacity;    ///< Capacity of the centroid array
+  double    m_compression; ///< Compression parameter
+  double    m_totalWeight; ///< Total weight of all centroids
+  double    m_min;         ///< Minimal value
+  double    m_max;         ///< Maximal value
+};
+
+/// State of the approximate percentile function (internal)
+struct wxSQLite3TDigestState
+{
+  wxSQLite3TDigest* m_digest;      ///< Digest of the values
+  double            m_fraction;    ///< Requested fraction
+  bool              m_hasFraction; ///< Flag whether the fraction is known
+};
+
+static void wxSQLite3PercentileApproxStep(sqlite3_context* ctx, int argc, sqlite3_value** argv)
+{
+  wxSQLite3TDigestState* state = (wxSQLite3TDigestState*) sqlite3_aggregate_context(ctx, sizeof(wxSQLite3TDigestState));
+  if (state == NULL)
+  {
+    sqlite3_result_error_nomem(ctx);
+    return;
+  }
+  if (!wxSQLite3StatGetFraction(ctx, argv[1], state->m_fraction, state->m_hasFraction))
+  {
+    return;
+  }
+  double x;
+  if (wxSQLite3StatGetDouble(argv[0], x))
+  {
+    if (state->m_digest == NULL)
+    {
+      double compression = 100.0;
+      if (argc == 3 && (!wxSQLite3StatGetDouble(argv[2], compression) || compression < 10.0 || compression > 10000.0))
+      {
+        sqlite3_result_error(ctx, "compression must be a number between 10 and 10000", -1);
+        return;
+      }
+      state->m_digest = new wxSQLite3TDigest(compression);
+    }
+    if (!state->m_digest->Add(x))
+    {
+      sqlite3_result_error_nomem(ctx);
+    }
+  }
+}
+
+static void wxSQLite3PercentileApproxFinal(sqlite3_context* ctx)
+{
+  wxSQLite3TDigestState* state = (wxSQLite3TDigestState*) sqlite3_aggregate_context(ctx, 0);
+  if (state != NULL && state->m_digest != NULL && state->m_digest->GetTotalWeight() > 0.0)
+  {
+    sqlite3_result_double(ctx, state->m_digest->Quantile(state->m_fraction));
+  }
+  else
+  {
+    sqlite3_result_null(ctx);
+  }
+  if (state != NULL)
+  {
+    delete state->m_digest;
+    state->m_digest = NULL;
+  }
+}
+
+static sqlite3_uint64 wxSQLite3XXH64(const void* data, size_t len, sqlite3_uint64 seed);
+
+/// Distinct value with its number of occurrences for the mode function (internal)
+struct wxSQLite3ModeEntry
+{
+  int           m_type;    ///< SQLite data type of the value
+  sqlite3_int64 m_integer; ///< Integer value
+  double        m_number;  ///< Numeric value
+  char*         m_data;    ///< Copy of text or blob value
+  int           m_len;     ///< Length of text or blob value
+  sqlite3_int64 m_count;   ///< Number of occurrences (0 after removal from the window frame)
+  sqlite3_uint64 m_hash;   ///< Hash of the value
+};
+
+/// State of the mode function: distinct values in a hash table (internal)
+/**
+* The entries are kept in insertion order; the open addressing table m_slots
+* refers to them by index plus one. Entries are not removed when their count
+* drops to zero, so that the indices stay valid.
+*/
+struct wxSQLite3ModeState
+{
+  wxSQLite3ModeEntry* m_entries;   ///< Distinct values
+  int                 m_count;     ///< Number of distinct values
+  int                 m_capacity;  ///< Capacity of the entry array
+  int*                m_slots;     ///< Hash table of entry indices plus one (0 = empty slot)
+  int                 m_slotCount; ///< Number of hash table slots (power of 2)
+};
+
+static int wxSQLite3ModeTypeClass(int type)
+{
+  return (type == SQLITE_INTEGER || type == SQLITE_FLOAT) ? 0 : ((type == SQLITE_TEXT) ? 1 : 2);
+}
+
+static int wxSQLite3ModeCompare(const wxSQLite3ModeEntry& entry, const wxSQLite3ModeEntry& key)
+{
+  int class1 = wxSQLite3ModeTypeClass(entry.m_type);
+  int class2 = wxSQLite3ModeTypeClass(key.m_type);
+  if (class1 != class2)
+  {
+    return class1 - class2;
+  }
+  if (class1 == 0)
+  {
+    if (entry.m_type == SQLITE_INTEGER && key.m_type == SQLITE_INTEGER)
+    {
+      return (entry.m_integer < key.m_integer) ? -1 : ((entry.m_integer > key.m_integer) ? 1 : 0);
+    }
+    return (entry.m_number < key.m_number) ? -1 : ((entry.m_number > key.m_number) ? 1 : 0);
+  }
+  int len = (entry.m_len < key.m_len) ? entry.m_len : key.m_len;
+  int rc = (len > 0) ? memcmp(entry.m_data, key.m_data, (size_t) len) : 0;
+  return (rc != 0) ? rc : entry.m_len - key.m_len;
+}
+
+// Numbers are hashed by their double value, since integers and reals compare equal
+static sqlite3_uint64 wxSQLite3ModeHash(const wxSQLite3ModeEntry& key)
+{
+  int typeClass = wxSQLite3ModeTypeClass(key.m_type);
+  if (typeClass == 0)
+  {
+    double number = (key.m_number == 0.0) ? 0.0 : key.m_number;
+    return wxSQLite3XXH64(&number, sizeof(number), 0);
+  }
+  return wxSQLite3XXH64(key.m_data, (size_t) key.m_len, (sqlite3_uint64) typeClass);
+}
+
+// Find the hash table slot of a value; returns true if the value is present
+static bool wxSQLite3ModeFind(const wxSQLite3ModeState* state, const wxSQLite3ModeEntry& key, int& slot)
+{
+  if (state->m_slotCount == 0)
+  {
+    slot = -1;
+    return false;
+  }
+  int mask = state->m_slotCount - 1;
+  slot = (int) (key.m_hash & (sqlite3_uint64) mask);
+  while (state->m_slots[slot] != 0)
+  {
+    const wxSQLite3ModeEntry& entry = state->m_entries[state->m_slots[slot] - 1];
+    if (entry.m_hash == key.m_hash && wxSQLite3ModeCompare(entry, key) == 0)
+    {
+      return true;
+    }
+    slot = (slot + 1) & mask;
+  }
+  return false;
+}
+
+// Double the hash table size, keeping the load factor at most 1/2
+static bool wxSQLite3ModeGrow(wxSQLite3ModeState* state)
+{
+  int slotCount = (state->m_slotCount > 0) ? 2 * state->m_slotCount : 32;
+  int* slots = (int*) sqlite3_malloc64((sqlite3_uint64) slotCount * sizeof(int));
+  wxSQLite3ModeEntry* entries = (wxSQLite3ModeEntry*) sqlite3_realloc64(state->m_entries, (sqlite3_uint64) (slotCount / 2) * sizeof(wxSQLite3ModeEntry));
+  if (slots == NULL || entries == NULL)
+  {
+    sqlite3_free(slots);
+    if (entries != NULL)
+    {
+      state->m_entries = entries;
+    }
+    return false;
+  }
+  memset(slots, 0, (size_t) slotCount * sizeof(int));
+  int j;
+  for (j = 0; j < state->m_count; ++j)
+  {
+    int slot = (int) (entries[j].m_hash & (sqlite3_uint64) (slotCount - 1));
+    while (slots[slot] != 0)
+    {
+      slot = (slot + 1) & (slotCount - 1);
+    }
+    slots[slot] = j + 1;
+  }
+  sqlite3_free(state->m_slots);
+  state->m_slots = slots;
+  state->m_slotCount = slotCount;
+  state->m_entries = entries;
+  state->m_capacity = slotCount / 2;
+  return true;
+}
+
+static wxSQLite3ModeState* wxSQLite3ModeGetKey(sqlite3_context* ctx, sqlite3_value* value, wxSQLite3ModeEntry& key)
+{
+  key.m_type = sqlite3_value_type(value);
+  if (key.m_type == SQLITE_NULL)
+  {
+    return NULL;
+  }
+  key.m_integer = sqlite3_value_int64(value);
+  key.m_number = sqlite3_value_double(value);
+  key.m_data = (key.m_type == SQLITE_TEXT) ? (char*) sqlite3_value_text(value) :
+               ((key.m_type == SQLITE_BLOB) ? (char*) sqlite3_value_blob(value) : NULL);
+  key.m_len = (key.m_type == SQLITE_TEXT || key.m_type == SQLITE_BLOB) ? sqlite3_value_bytes(value) : 0;
+  key.m_count = 1;
+  key.m_hash = wxSQLite3ModeHash(key);
+  wxSQLite3ModeState* state = (wxSQLite3ModeState*) sqlite3_aggregate_context(ctx, sizeof(wxSQLite3ModeState));
+  if (state == NULL)
+  {
+    sqlite3_result_error_nomem(ctx);
+  }
+  return state;
+}
+
+static void wxSQLite3ModeStep(sqlite3_context* ctx, int WXUNUSED(argc), sqlite3_value** argv)
+{
+  wxSQLite3ModeEntry key;
+  wxSQLite3ModeState* state = wxSQLite3ModeGetKey(ctx, argv[0], key);
+  int slot;
+  if (state == NULL)
+  {
+    return;
+  }
+  if (wxSQLite3ModeFind(state, key, slot))
+  {
+    state->m_entries[state->m_slots[slot] - 1].m_count++;
+    return;
+  }
+  if (state->m_count == state->m_capacity)
+  {
+    if (!wxSQLite3ModeGrow(state))
+    {
+      sqlite3_result_error_nomem(ctx);
+      return;
+    }
+    wxSQLite3ModeFind(state, key, slot);
+  }
+  if (key.m_data != NULL)
+  {
+    char* data = (char*) sqlite3_malloc((key.m_len > 0) ? key.m_len : 1);
+    if (data == NULL)
+    {
+      sqlite3_result_error_nomem(ctx);
+      return;
+    }
+    memcpy(data, key.m_data, (size_t) key.m_len);
+    key.m_data = data;
+  }
+  state->m_entries[state->m_count] = key;
+  state->m_count++;
+  state->m_slots[slot] = state->m_count;
+}
+
+static void wxSQLite3ModeInverse(sqlite3_context* ctx, int WXUNUSED(argc), sqlite3_value** argv)
+{
+  wxSQLite3ModeEntry key;
+  wxSQLite3ModeState* state = wxSQLite3ModeGetKey(ctx, argv[0], key);
+  int slot;
+  if (state != NULL && wxSQLite3ModeFind(state, key, slot))
+  {
+    wxSQLite3ModeEntry& entry = state->m_entries[state->m_slots[slot] - 1];
+    if (entry.m_count > 0)
+    {
+      entry.m_count--;
+    }
+  }
+}
+
+static void wxSQLite3ModeValue(sqlite3_context* ctx)
+{
+  wxSQLite3ModeState* state = (wxSQLite3ModeState*) sqlite3_aggregate_context(ctx, 0);
+  const wxSQLite3ModeEntry* mode = NULL;
+  int j;
+  for (j = 0; state != NULL && j < state->m_count; ++j)
+  {
+    // On ties the smallest value wins
+    const wxSQLite3ModeEntry& entry = state->m_entries[j];
+    if (entry.m_count > 0 &&
+        (mode == NULL || entry.m_count > mode->m_count ||
+         (entry.m_count == mode->m_count && wxSQLite3ModeCompare(entry, *mode) < 0)))
+    {
+      mode = &state->m_entries[j];
+    }
+  }
+  if (mode == NULL)
+  {
+    sqlite3_result_null(ctx);
+    return;
+  }
+  switch (mode->m_type)
+  {
+    case SQLITE_INTEGER: sqlite3_result_int64(ctx, mode->m_integer); break;
+    case SQLITE_FLOAT:   sqlite3_result_double(ctx, mode->m_number); break;
+    case SQLITE_TEXT:    sqlite3_result_text(ctx, mode->m_data, mode->m_len, SQLITE_TRANSIENT); break;
+    default:             sqlite3_result_blob(ctx, mode->m_data, mode->m_len, SQLITE_TRANSIENT); break;
+  }
+}
+
+static void wxSQLite3ModeFinal(sqlite3_context* ctx)
+{
+  wxSQLite3ModeValue(ctx);
+  wxSQLite3ModeState* state = (wxSQLite3ModeState*) sqlite3_aggregate_context(ctx, 0);
+  if (state != NULL)
+  {
+    int j;
+    for (j = 0; j < state->m_count; ++j)
+    {
+      sqlite3_free(state->m_entries[j].m_data);
+    }
+    sqlite3_free(state->m_entries);
+    sqlite3_free(state->m_slots);
+    state->m_entries = NULL;
+    state->m_slots = NULL;
+    state->m_count = 0;
+  }
+}
+
+/// State of the linearly weighted moving average (internal)
+struct wxSQLite3WmaState
+{
+  sqlite3_int64 m_count;       ///< Number of values in the frame
+  double        m_sum;         ///< Sum of the values
+  double        m_weightedSum; ///< Sum of the values weighted by their position in the frame
+};
+
+// The newest value has weight n, the oldest value weight 1
+static void wxSQLite3WmaStep(sqlite3_context* ctx, int WXUNUSED(argc), sqlite3_value** argv)
+{
+  double x;
+  if (wxSQLite3StatGetDouble(argv[0], x))
+  {
+    wxSQLite3WmaState* state = (wxSQLite3WmaState*) sqlite3_aggregate_context(ctx, sizeof(wxSQLite3WmaState));
+    if (state == NULL)
+    {
+      sqlite3_result_error_nomem(ctx);
+      return;
+    }
+    state->m_count++;
+    state->m_sum += x;
+    state->m_weightedSum += (double) state->m_count * x;
+  }
+}
+
+// Removing the oldest value decrements the weights of all values in the frame
+static void wxSQLite3WmaInverse(sqlite3_context* ctx, int WXUNUSED(argc), sqlite3_value** argv)
+{
+  double x;
+  if (wxSQLite3StatGetDouble(argv[0], x))
+  {
+    wxSQLite3WmaState* state = (wxSQLite3WmaState*) sqlite3_aggregate_context(ctx, sizeof(wxSQLite3WmaState));
+    if (state == NULL)
+    {
+      sqlite3_result_error_nomem(ctx);
+      return;
+    }
+    state->m_weightedSum -= state->m_sum;
+    state->m_sum -= x;
+    if (--state->m_count <= 0)
+    {
+      state->m_count = 0;
+      state->m_sum = 0.0;
+      state->m_weightedSum = 0.0;
+    }
+  }
+}
+
+static void wxSQLite3WmaValue(sqlite3_context* ctx)
+{
+  wxSQLite3WmaState* state = (wxSQLite3WmaState*) sqlite3_aggregate_context(ctx, 0);
+  if (state == NULL || state->m_count == 0)
+  {
+    sqlite3_result_null(ctx);
+  }
+  else
+  {
+    double n = (double) state->m_count;
+    sqlite3_result_double(ctx, state->m_weightedSum / (n * (n + 1.0) / 2.0));
+  }
+}
+
+/// State of the exponential moving average (internal)
+struct wxSQLite3EmaState
+{
+  sqlite3_int64 m_count;       ///< Number of values in the frame
+  double        m_alpha;       ///< Smoothing factor
+  bool          m_hasAlpha;    ///< Flag whether the smoothing factor is known
+  double        m_weightedSum; ///< Sum of the values weighted by (1-alpha)^age
+  double        m_weight;      ///< Sum of the weights
+};
+
+static wxSQLite3EmaState* wxSQLite3EmaGetState(sqlite3_context* ctx, sqlite3_value** argv, double& x)
+{
+  wxSQLite3EmaState* state = (wxSQLite3EmaState*) sqlite3_aggregate_context(ctx, sizeof(wxSQLite3EmaState));
+  if (state == NULL)
+  {
+    sqlite3_result_error_nomem(ctx);
+    return NULL;
+  }
+  double alpha;
+  if (!wxSQLite3StatGetDouble(argv[1], alpha) || alpha <= 0.0 || alpha > 1.0)
+  {
+    sqlite3_result_error(ctx, "smoothing factor must be a number greater than 0.0 and not greater than 1.0", -1);
+    return NULL;
+  }
+  if (state->m_hasAlpha && alpha != state->m_alpha)
+  {
+    sqlite3_result_error(ctx, "smoothing factor must be the same for all rows", -1);
+    return NULL;
+  }
+  state->m_alpha = alpha;
+  state->m_hasAlpha = true;
+  return (wxSQLite3StatGetDouble(argv[0], x)) ? state : NULL;
+}
+
+static void wxSQLite3EmaStep(sqlite3_context* ctx, int WXUNUSED(argc), sqlite3_value** argv)
+{
+  double x;
+  wxSQLite3EmaState* state = wxSQLite3EmaGetState(ctx, argv, x);
+  if (state != NULL)
+  {
+    double decay = 1.0 - state->m_alpha;
+    state->m_weightedSum = state->m_weightedSum * decay + x;
+    state->m_weight = state->m_weight * decay + 1.0;
+    state->m_count++;
+  }
+}
+
+static void wxSQLite3EmaInverse(sqlite3_context* ctx, int WXUNUSED(argc), sqlite3_value** argv)
+{
+  double x;
+  wxSQLite3EmaState* state = wxSQLite3EmaGetState(ctx, argv, x);
+  if (state != NULL && state->m_count > 0)
+  {
+    // The oldest value in the frame has the weight (1-alpha)^(n-1)
+    double weight = pow(1.0 - state->m_alpha, (double) (state->m_count - 1));
+    state->m_weightedSum -= weight * x;
+    state->m_weight -= weight;
+    if (--state->m_count == 0)
+    {
+      state->m_weightedSum = 0.0;
+      state->m_weight = 0.0;
+    }
+  }
+}
+
+static void wxSQLite3EmaValue(sqlite3_context* ctx)
+{
+  wxSQLite3EmaState* state = (wxSQLite3EmaState*) sqlite3_aggregate_context(ctx, 0);
+  if (state == NULL || state->m_count == 0 || state->m_weight <= 0.0)
+  {
+    sqlite3_result_null(ctx);
+  }
+  else
+  {
+    sqlite3_result_double(ctx, state->m_weightedSum / state->m_weight);
+  }
+}
+
+/// Definition of a native aggregate or window function (internal)
+struct wxSQLite3NativeFunctionDef
+{
+  const char* m_name;
+  int         m_argCount;
+  const void* m_userData;
+  void (*m_xStep)(sqlite3_context*, int, sqlite3_value**);
+  void (*m_xFinal)(sqlite3_context*);
+  void (*m_xValue)(sqlite3_context*);
+  void (*m_xInverse)(sqlite3_context*, int, sqlite3_value**);
+};
+
+static const wxSQLite3NativeFunctionDef gs_statisticsFunctions[] =
+{
+  { "var_samp",          1, &gs_varSampInfo,        wxSQLite3VarianceStep,         wxSQLite3VarianceValue,         wxSQLite3VarianceValue,   wxSQLite3VarianceInverse   },
+  { "variance",          1, &gs_varSampInfo,        wxSQLite3VarianceStep,         wxSQLite3VarianceValue,         wxSQLite3VarianceValue,   wxSQLite3VarianceInverse   },
+  { "var_pop",           1, &gs_varPopInfo,         wxSQLite3VarianceStep,         wxSQLite3VarianceValue,         wxSQLite3VarianceValue,   wxSQLite3VarianceInverse   },
+  { "stddev_samp",       1, &gs_stddevSampInfo,     wxSQLite3VarianceStep,         wxSQLite3VarianceValue,         wxSQLite3VarianceValue,   wxSQLite3VarianceInverse   },
+  { "stddev",            1, &gs_stddevSampInfo,     wxSQLite3VarianceStep,         wxSQLite3VarianceValue,         wxSQLite3VarianceValue,   wxSQLite3VarianceInverse   },
+  { "stddev_pop",        1, &gs_stddevPopInfo,      wxSQLite3VarianceStep,         wxSQLite3VarianceValue,         wxSQLite3VarianceValue,   wxSQLite3VarianceInverse   },
+  { "median",            1, &gs_medianInfo,         wxSQLite3PercentileStep,       wxSQLite3PercentileFinal,       wxSQLite3PercentileValue, wxSQLite3PercentileInverse },
+  { "percentile_cont",   2, &gs_percentileContInfo, wxSQLite3PercentileStep,       wxSQLite3PercentileFinal,       wxSQLite3PercentileValue, wxSQLite3PercentileInverse },
+  { "percentile_disc",   2, &gs_percentileDiscInfo, wxSQLite3PercentileStep,       wxSQLite3PercentileFinal,       wxSQLite3PercentileValue, wxSQLite3PercentileInverse },
+  { "percentile_approx", 2, NULL,                   wxSQLite3PercentileApproxStep, wxSQLite3PercentileApproxFinal, NULL,                     NULL                       },
+  { "percentile_approx", 3, NULL,                   wxSQLite3PercentileApproxStep, wxSQLite3PercentileApproxFinal, NULL,                     NULL                       },
+  { "mode",              1, NULL,                   wxSQLite3ModeStep,             wxSQLite3ModeFinal,             wxSQLite3ModeValue,       wxSQLite3ModeInverse       },
+  { "wma",               1, NULL,                   wxSQLite3WmaStep,              wxSQLite3WmaValue,              wxSQLite3WmaValue,        wxSQLite3WmaInverse        },
+  { "ema",               2, NULL,                   wxSQLite3EmaStep,              wxSQLite3EmaValue,              wxSQLite3EmaValue,        wxSQLite3EmaInverse        }
+};
+
+void wxSQLite3Database::CreateStatisticsFunctions()
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  int flags = SQLITE_UTF8 | SQLITE_DETERMINISTIC | SQLITE_INNOCUOUS;
+  size_t j;
+  for (j = 0; j < sizeof(gs_statisticsFunctions) / sizeof(gs_statisticsFunctions[0]); ++j)
+  {
+    const wxSQLite3NativeFunctionDef& def = gs_statisticsFunctions[j];
+    int rc = sqlite3_create_window_function(m_db->m_db, def.m_name, def.m_argCount, flags, (void*) def.m_userData,
+                                            def.m_xStep, def.m_xFinal, def.m_xValue, def.m_xInverse, NULL);
+    if (rc != SQLITE_OK)
+    {
+      const char* localError = sqlite3_errmsg(m_db->m_db);
+      throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+    }
+  }
+}
+
+// --- Hash functions
+
+static const sqlite3_uint64 gs_xxhPrime1 = wxULL(0x9E3779B185EBCA87);
+static const sqlite3_uint64 gs_xxhPrime2 = wxULL(0xC2B2AE3D27D4EB4F);
+static const sqlite3_uint64 gs_xxhPrime3 = wxULL(0x165667B19E3779F9);
+static const sqlite3_uint64 gs_xxhPrime4 = wxULL(0x85EBCA77C2B2AE63);
+static const sqlite3_uint64 gs_xxhPrime5 = wxULL(0x27D4EB2F165667C5);
+
+static inline sqlite3_uint64 wxSQLite3RotateLeft64(sqlite3_uint64 x, int r)
+{
+  return (x << r) | (x >> (64 - r));
+}
+
+static inline wxUint32 wxSQLite3ReadLE32(const unsigned char* p)
+{
+  return (wxUint32) p[0] | ((wxUint32) p[1] << 8) | ((wxUint32) p[2] << 16) | ((wxUint32) p[3] << 24);
+}
+
+static inline sqlite3_uint64 wxSQLite3ReadLE64(const unsigned char* p)
+{
+  return (sqlite3_uint64) wxSQLite3ReadLE32(p) | ((sqlite3_uint64) wxSQLite3ReadLE32(p + 4) << 32);
+}
+
+static inline void wxSQLite3WriteLE32(unsigned char* p, wxUint32 value)
+{
+  p[0] = (unsigned char) value;
+  p[1] = (unsigned char) (value >> 8);
+  p[2] = (unsigned char) (value >> 16);
+  p[3] = (unsigned char) (value >> 24);
+}
+
+static inline void wxSQLite3WriteLE64(unsigned char* p, sqlite3_uint64 value)
+{
+  wxSQLite3WriteLE32(p, (wxUint32) value);
+  wxSQLite3WriteLE32(p + 4, (wxUint32) (value >> 32));
+}
+
+static inline double wxSQLite3ReadLEDouble(const unsigned char* p)
+{
+  sqlite3_uint64 bits = wxSQLite3ReadLE64(p);
+  double value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+static inline void wxSQLite3WriteLEDouble(unsigned char* p, double value)
+{
+  sqlite3_uint64 bits;
+  memcpy(&bits, &value, sizeof(bits));
+  wxSQLite3WriteLE64(p, bits);
+}
+
+static inline sqlite3_uint64 wxSQLite3XXH64Round(sqlite3_uint64 acc, sqlite3_uint64 input)
+{
+  acc += input * gs_xxhPrime2;
+  return wxSQLite3RotateLeft64(acc, 31) * gs_xxhPrime1;
+}
+
+static inline sqlite3_uint64 wxSQLite3XXH64MergeRound(sqlite3_uint64 acc, sqlite3_uint64 value)
+{
+  acc ^= wxSQLite3XXH64Round(0, value);
+  return acc * gs_xxhPrime1 + gs_xxhPrime4;
+}
+
+static inline sqlite3_uint64 wxSQLite3XXH64Avalanche(sqlite3_uint64 h)
+{
+  h ^= h >> 33;
+  h *= gs_xxhPrime2;
+  h ^= h >> 29;
+  h *= gs_xxhPrime3;
+  h ^= h >> 32;
+  return h;
+}
+
+/// Compute the 64-bit xxHash (XXH64) of a memory block (internal)
+static sqlite3_uint64 wxSQLite3XXH64(const void* data, size_t len, sqlite3_uint64 seed)
+{
+  const unsigned char* p = (const unsigned char*) data;
+  size_t remaining = len;
+  sqlite3_uint64 h;
+  if (remaining >= 32)
+  {
+    sqlite3_uint64 v1 = seed + gs_xxhPrime1 + gs_xxhPrime2;
+    sqlite3_uint64 v2 = seed + gs_xxhPrime2;
+    sqlite3_uint64 v3 = seed;
+    sqlite3_uint64 v4 = seed - gs_xxhPrime1;
+    do
+    {
+      v1 = wxSQLite3XXH64Round(v1, wxSQLite3ReadLE64(p));
+      v2 = wxSQLite3XXH64Round(v2, wxSQLite3ReadLE64(p + 8));
+      v3 = wxSQLite3XXH64Round(v3, wxSQLite3ReadLE64(p + 16));
+      v4 = wxSQLite3XXH64Round(v4, wxSQLite3ReadLE64(p + 24));
+      p += 32;
+      remaining -= 32;
+    }
+    while (remaining >= 32);
+    h = wxSQLite3RotateLeft64(v1, 1) + wxSQLite3RotateLeft64(v2, 7) +
+        wxSQLite3RotateLeft64(v3, 12) + wxSQLite3RotateLeft64(v4, 18);
+    h = wxSQLite3XXH64MergeRound(h, v1);
+    h = wxSQLite3XXH64MergeRound(h, v2);
+    h = wxSQLite3XXH64MergeRound(h, v3);
+    h = wxSQLite3XXH64MergeRound(h, v4);
+  }
+  else
+  {
+    h = seed + gs_xxhPrime5;
+  }
+  h += (sqlite3_uint64) len;
+  while (remaining >= 8)
+  {
+    h ^= wxSQLite3XXH64Round(0, wxSQLite3ReadLE64(p));
+    h = wxSQLite3RotateLeft64(h, 27) * gs_xxhPrime1 + gs_xxhPrime4;
+    p += 8;
+    remaining -= 8;
+  }
+  if (remaining >= 4)
+  {
+    h ^= (sqlite3_uint64) wxSQLite3ReadLE32(p) * gs_xxhPrime1;
+    h = wxSQLite3RotateLeft64(h, 23) * gs_xxhPrime2 + gs_xxhPrime3;
+    p += 4;
+    remaining -= 4;
+  }
+  while (remaining > 0)
+  {
+    h ^= (sqlite3_uint64) (*p) * gs_xxhPrime5;
+    h = wxSQLite3RotateLeft64(h, 11) * gs_xxhPrime1;
+    ++p;
+    --remaining;
+  }
+  return wxSQLite3XXH64Avalanche(h);
+}
+
+static const sqlite3_uint64 gs_xxhPrime32_1 = 0x9E3779B1U;
+static const sqlite3_uint64 gs_xxhPrime32_2 = 0x85EBCA77U;
+static const sqlite3_uint64 gs_xxhPrime32_3 = 0xC2B2AE3DU;
+
+static const int gs_xxh3SecretSize = 192;
+static const int gs_xxh3StripeLen = 64;
+
+static const unsigned char gs_xxh3Secret[gs_xxh3SecretSize] =
+{
+  0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+  0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+  0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+  0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+  0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+  0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+  0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+  0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+  0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+  0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+  0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+  0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e
+};
+
+static inline wxUint32 wxSQLite3ByteSwap32(wxUint32 x)
+{
+  return (x >> 24) | ((x >> 8) & 0x0000FF00U) | ((x << 8) & 0x00FF0000U) | (x << 24);
+}
+
+static inline sqlite3_uint64 wxSQLite3ByteSwap64(sqlite3_uint64 x)
+{
+  return ((sqlite3_uint64) wxSQLite3ByteSwap32((wxUint32) x) << 32) | wxSQLite3ByteSwap32((wxUint32) (x >> 32));
+}
+
+// Multiply two 64-bit values and fold the 128-bit product by xor-ing its halves
+static inline sqlite3_uint64 wxSQLite3Mul128Fold64(sqlite3_uint64 lhs, sqlite3_uint64 rhs)
+{
+#if defined(__SIZEOF_INT128__)
+  unsigned __int128 product = (unsigned __int128) lhs * rhs;
+  return (sqlite3_uint64) product ^ (sqlite3_uint64) (product >> 64);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_AMD64))
+  sqlite3_uint64 high;
+  sqlite3_uint64 low = _umul128(lhs, rhs, &high);
+  return low ^ high;
+#else
+  sqlite3_uint64 loLo = (lhs & 0xFFFFFFFFU) * (rhs & 0xFFFFFFFFU);
+  sqlite3_uint64 hiLo = (lhs >> 32) * (rhs & 0xFFFFFFFFU);
+  sqlite3_uint64 loHi = (lhs & 0xFFFFFFFFU) * (rhs >> 32);
+  sqlite3_uint64 hiHi = (lhs >> 32) * (rhs >> 32);
+  sqlite3_uint64 cross = (loLo >> 32) + (hiLo & 0xFFFFFFFFU) + loHi;
+  sqlite3_uint64 upper = (hiLo >> 32) + (cross >> 32) + hiHi;
+  sqlite3_uint64 lower = (cross << 32) | (loLo & 0xFFFFFFFFU);
+  return lower ^ upper;
+#endif
+}
+
+static inline sqlite3_uint64 wxSQLite3XXH3Avalanche(sqlite3_uint64 h)
+{
+  h ^= h >> 37;
+  h *= wxULL(0x165667919E3779F9);
+  h ^= h >> 32;
+  return h;
+}
+
+static inline sqlite3_uint64 wxSQLite3XXH3Rrmxmx(sqlite3_uint64 h, sqlite3_uint64 len)
+{
+  h ^= wxSQLite3RotateLeft64(h, 49) ^ wxSQLite3RotateLeft64(h, 24);
+  h *= wxULL(0x9FB21C651E98DF25);
+  h ^= (h >> 35) + len;
+  h *= wxULL(0x9FB21C651E98DF25);
+  h ^= h >> 28;
+  return h;
+}
+
+static inline sqlite3_uint64 wxSQLite3XXH3Mix16(const unsigned char* p, const unsigned char* secret, sqlite3_uint64 seed)
+{
+  return wxSQLite3Mul128Fold64(wxSQLite3ReadLE64(p) ^ (wxSQLite3ReadLE64(secret) + seed),
+                               wxSQLite3ReadLE64(p + 8) ^ (wxSQLite3ReadLE64(secret + 8) - seed));
+}
+
+static sqlite3_uint64 wxSQLite3XXH3Len0To16(const unsigned char* p, size_t len, const unsigned char* secret, sqlite3_uint64 seed)
+{
+  if (len > 8)
+  {
+    sqlite3_uint64 flipLo = (wxSQLite3ReadLE64(secret + 24) ^ wxSQLite3ReadLE64(secret + 32)) + seed;
+    sqlite3_uint64 flipHi = (wxSQLite3ReadLE64(secret + 40) ^ wxSQLite3ReadLE64(secret + 48)) - seed;
+    sqlite3_uint64 inputLo = wxSQLite3ReadLE64(p) ^ flipLo;
+    sqlite3_uint64 inputHi = wxSQLite3ReadLE64(p + len - 8) ^ flipHi;
+    sqlite3_uint64 acc = (sqlite3_uint64) len + wxSQLite3ByteSwap64(inputLo) + inputHi +
+                         wxSQLite3Mul128Fold64(inputLo, inputHi);
+    return wxSQLite3XXH3Avalanche(acc);
+  }
+  if (len >= 4)
+  {
+    seed ^= (sqlite3_uint64) wxSQLite3ByteSwap32((wxUint32) seed) << 32;
+    sqlite3_uint64 input1 = wxSQLite3ReadLE32(p);
+    sqlite3_uint64 input2 = wxSQLite3ReadLE32(p + len - 4);
+    sqlite3_uint64 flip = (wxSQLite3ReadLE64(secret + 8) ^ wxSQLite3ReadLE64(secret + 16)) - seed;
+    return wxSQLite3XXH3Rrmxmx((input2 + (input1 << 32)) ^ flip, len);
+  }
+  if (len > 0)
+  {
+    wxUint32 combined = ((wxUint32) p[0] << 16) | ((wxUint32) p[len >> 1] << 24) |
+                        (wxUint32) p[len - 1] | ((wxUint32) len << 8);
+    sqlite3_uint64 flip = (sqlite3_uint64) (wxSQLite3ReadLE32(secret) ^ wxSQLite3ReadLE32(secret + 4)) + seed;
+    return wxSQLite3XXH64Avalanche((sqlite3_uint64) combined ^ flip);
+  }
+  return wxSQLite3XXH64Avalanche(seed ^ wxSQLite3ReadLE64(secret + 56) ^ wxSQLite3ReadLE64(secret + 64));
+}
+
+static sqlite3_uint64 wxSQLite3XXH3Len17To128(const unsigned char* p, size_t len, const unsigned char* secret, sqlite3_uint64 seed)
+{
+  sqlite3_uint64 acc = (sqlite3_uint64) len * gs_xxhPrime1;
+  if (len > 32)
+  {
+    if (len > 64)
+    {
+      if (len > 96)
+      {
+        acc += wxSQLite3XXH3Mix16(p + 48, secret + 96, seed);
+        acc += wxSQLite3XXH3Mix16(p + len - 64, secret + 112, seed);
+      }
+      acc += wxSQLite3XXH3Mix16(p + 32, secret + 64, seed);
+      acc += wxSQLite3XXH3Mix16(p + len - 48, secret + 80, seed);
+    }
+    acc += wxSQLite3XXH3Mix16(p + 16, secret + 32, seed);
+    acc += wxSQLite3XXH3Mix16(p + len - 32, secret + 48, seed);
+  }
+  acc += wxSQLite3XXH3Mix16(p, secret, seed);
+  acc += wxSQLite3XXH3Mix16(p + len - 16, secret + 16, seed);
+  return wxSQLite3XXH3Avalanche(acc);
+}
+
+static sqlite3_uint64 wxSQLite3XXH3Len129To240(const unsigned char* p, size_t len, const unsigned char* secret, sqlite3_uint64 seed)
+{
+  sqlite3_uint64 acc = (sqlite3_uint64) len * gs_xxhPrime1;
+  size_t rounds = len / 16;
+  size_t j;
+  for (j = 0; j < 8; ++j)
+  {
+    acc += wxSQLite3XXH3Mix16(p + 16 * j, secret + 16 * j, seed);
+  }
+  acc = wxSQLite3XXH3Avalanche(acc);
+  for (j = 8; j < rounds; ++j)
+  {
+    acc += wxSQLite3XXH3Mix16(p + 16 * j, secret + 16 * (j - 8) + 3, seed);
+  }
+  acc += wxSQLite3XXH3Mix16(p + len - 16, secret + 136 - 17, seed);
+  return wxSQLite3XXH3Avalanche(acc);
+}
+
+// Accumulate one stripe of 64 bytes into the 8 accumulators
+static inline void wxSQLite3XXH3Accumulate512(sqlite3_uint64* acc, const unsigned char* p, const unsigned char* secret)
+{
+#if WXSQLITE3_HAVE_SSE2
+  int j;
+  for (j = 0; j < 4; ++j)
+  {
+    __m128i accVec = _mm_loadu_si128((const __m128i*) (acc + 2 * j));
+    __m128i dataVec = _mm_loadu_si128((const __m128i*) (p + 16 * j));
+    __m128i keyVec = _mm_loadu_si128((const __m128i*) (secret + 16 * j));
+    __m128i dataKey = _mm_xor_si128(dataVec, keyVec);
+    __m128i dataKeyHi = _mm_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1));
+    __m128i product = _mm_mul_epu32(dataKey, dataKeyHi);
+    __m128i dataSwap = _mm_shuffle_epi32(dataVec, _MM_SHUFFLE(1, 0, 3, 2));
+    accVec = _mm_add_epi64(_mm_add_epi64(accVec, dataSwap), product);
+    _mm_storeu_si128((__m128i*) (acc + 2 * j), accVec);
+  }
+#else
+  int j;
+  for (j = 0; j < 8; ++j)
+  {
+    sqlite3_uint64 dataVal = wxSQLite3ReadLE64(p + 8 * j);
+    sqlite3_uint64 dataKey = dataVal ^ wxSQLite3ReadLE64(secret + 8 * j);
+    acc[j ^ 1] += dataVal;
+    acc[j] += (dataKey & 0xFFFFFFFFU) * (dataKey >> 32);
+  }
+#endif
+}
+
+static inline void wxSQLite3XXH3ScrambleAcc(sqlite3_uint64* acc, const unsigned char* secret)
+{
+#if WXSQLITE3_HAVE_SSE2
+  const __m128i prime = _mm_set1_epi32((int) gs_xxhPrime32_1);
+  int j;
+  for (j = 0; j < 4; ++j)
+  {
+    __m128i accVec = _mm_loadu_si128((const __m128i*) (acc + 2 * j));
+    __m128i keyVec = _mm_loadu_si128((const __m128i*) (secret + 16 * j));
+    __m128i dataKey = _mm_xor_si128(_mm_xor_si128(accVec, _mm_srli_epi64(accVec, 47)), keyVec);
+    __m128i dataKeyHi = _mm_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1));
+    __m128i productLo = _mm_mul_epu32(dataKey, prime);
+    __m128i productHi = _mm_mul_epu32(dataKeyHi, prime);
+    _mm_storeu_si128((__m128i*) (acc + 2 * j), _mm_add_epi64(productLo, _mm_slli_epi64(productHi, 32)));
+  }
+#else
+  int j;
+  for (j = 0; j < 8; ++j)
+  {
+    sqlite3_uint64 value = acc[j] ^ (acc[j] >> 47) ^ wxSQLite3ReadLE64(secret + 8 * j);
+    acc[j] = value * gs_xxhPrime32_1;
+  }
+#endif
+}
+
+static sqlite3_uint64 wxSQLite3XXH3HashLong(const unsigned char* p, size_t len, const unsigned char* secret)
+{
+  sqlite3_uint64 acc[8] = { gs_xxhPrime32_3, gs_xxhPrime1, gs_xxhPrime2, gs_xxhPrime3,
+                            gs_xxhPrime4, gs_xxhPrime32_2, gs_xxhPrime5, gs_xxhPrime32_1 };
+  const size_t stripesPerBlock = (gs_xxh3SecretSize - gs_xxh3StripeLen) / 8;
+  const size_t blockLen = gs_xxh3StripeLen * stripesPerBlock;
+  size_t blocks = (len - 1) / blockLen;
+  size_t n, s;
+  for (n = 0; n < blocks; ++n)
+  {
+    for (s = 0; s < stripesPerBlock; ++s)
+    {
+      wxSQLite3XXH3Accumulate512(acc, p + n * blockLen + s * gs_xxh3StripeLen, secret + s * 8);
+    }
+    wxSQLite3XXH3ScrambleAcc(acc, secret + gs_xxh3SecretSize - gs_xxh3StripeLen);
+  }
+  size_t stripes = ((len - 1) - blocks * blockLen) / gs_xxh3StripeLen;
+  for (s = 0; s < stripes; ++s)
+  {
+    wxSQLite3XXH3Accumulate512(acc, p + blocks * blockLen + s * gs_xxh3StripeLen, secret + s * 8);
+  }
+  wxSQLite3XXH3Accumulate512(acc, p + len - gs_xxh3StripeLen, secret + gs_xxh3SecretSize - gs_xxh3StripeLen - 7);
+
+  sqlite3_uint64 result = (sqlite3_uint64) len * gs_xxhPrime1;
+  for (n = 0; n < 4; ++n)
+  {
+    result += wxSQLite3Mul128Fold64(acc[2 * n] ^ wxSQLite3ReadLE64(secret + 11 + 16 * n),
+                                    acc[2 * n + 1] ^ wxSQLite3ReadLE64(secret + 11 + 16 * n + 8));
+  }
+  return wxSQLite3XXH3Avalanche(result);
+}
+
+/// Compute the 64-bit XXH3 hash of a memory block (internal)
+static sqlite3_uint64 wxSQLite3XXH3(const void* data, size_t len, sqlite3_uint64 seed)
+{
+  const unsigned char* p = (const unsigned char*) data;
+  if (len <= 16)
+  {
+    return wxSQLite3XXH3Len0To16(p, len, gs_xxh3Secret, seed);
+  }
+  if (len <= 128)
+  {
+    return wxSQLite3XXH3Len17To128(p, len, gs_xxh3Secret, seed);
+  }
+  if (len <= 240)
+  {
+    return wxSQLite3XXH3Len129To240(p, len, gs_xxh3Secret, seed);
+  }
+  if (seed == 0)
+  {
+    return wxSQLite3XXH3HashLong(p, len, gs_xxh3Secret);
+  }
+  // Long inputs are hashed with a secret derived from the seed
+  unsigned char secret[gs_xxh3SecretSize];
+  int j;
+  for (j = 0; j < gs_xxh3SecretSize; j += 16)
+  {
+    wxSQLite3WriteLE64(secret + j, wxSQLite3ReadLE64(gs_xxh3Secret + j) + seed);
+    wxSQLite3WriteLE64(secret + j + 8, wxSQLite3ReadLE64(gs_xxh3Secret + j + 8) - seed);
+  }
+  return wxSQLite3XXH3HashLong(p, len, secret);
+}
+
+static const wxUint32 gs_crc32cTable[256] =
+{
+  0x00000000, 0xF26B8303, 0xE13B70F7, 0x1350F3F4, 0xC79A971F, 0x35F1141C, 0x26A1E7E8, 0xD4CA64EB,
+  0x8AD958CF, 0x78B2DBCC, 0x6BE22838, 0x9989AB3B, 0x4D43CFD0, 0xBF284CD3, 0xAC78BF27, 0x5E133C24,
+  0x105EC76F, 0xE235446C, 0xF165B798, 0x030E349B, 0xD7C45070, 0x25AFD373, 0x36FF2087, 0xC494A384,
+  0x9A879FA0, 0x68EC1CA3, 0x7BBCEF57, 0x89D76C54, 0x5D1D08BF, 0xAF768BBC, 0xBC267848, 0x4E4DFB4B,
+  0x20BD8EDE, 0xD2D60DDD, 0xC186FE29, 0x33ED7D2A, 0xE72719C1, 0x154C9AC2, 0x061C6936, 0xF477EA35,
+  0xAA64D611, 0x580F5512, 0x4B5FA6E6, 0xB93425E5, 0x6DFE410E, 0x9F95C20D, 0x8CC531F9, 0x7EAEB2FA,
+  0x30E349B1, 0xC288CAB2, 0xD1D83946, 0x23B3BA45, 0xF779DEAE, 0x05125DAD, 0x1642AE59, 0xE4292D5A,
+  0xBA3A117E, 0x4851927D, 0x5B016189, 0xA96AE28A, 0x7DA08661, 0x8FCB0562, 0x9C9BF696, 0x6EF07595,
+  0x417B1DBC, 0xB3109EBF, 0xA0406D4B, 0x522BEE48, 0x86E18AA3, 0x748A09A0, 0x67DAFA54, 0x95B17957,
+  0xCBA24573, 0x39C9C670, 0x2A993584, 0xD8F2B687, 0x0C38D26C, 0xFE53516F, 0xED03A29B, 0x1F682198,
+  0x5125DAD3, 0xA34E59D0, 0xB01EAA24, 0x42752927, 0x96BF4DCC, 0x64D4CECF, 0x77843D3B, 0x85EFBE38,
+  0xDBFC821C, 0x2997011F, 0x3AC7F2EB, 0xC8AC71E8, 0x1C661503, 0xEE0D9600, 0xFD5D65F4, 0x0F36E6F7,
+  0x61C69362, 0x93AD1061, 0x80FDE395, 0x72966096, 0xA65C047D, 0x5437877E, 0x4767748A, 0xB50CF789,
+  0xEB1FCBAD, 0x197448AE, 0x0A24BB5A, 0xF84F3859, 0x2C855CB2, 0xDEEEDFB1, 0xCDBE2C45, 0x3FD5AF46,
+  0x7198540D, 0x83F3D70E, 0x90A324FA, 0x62C8A7F9, 0xB602C312, 0x44694011, 0x5739B3E5, 0xA55230E6,
+  0xFB410CC2, 0x092A8FC1, 0x1A7A7C35, 0xE811FF36, 0x3CDB9BDD, 0xCEB018DE, 0xDDE0EB2A, 0x2F8B6829,
+  0x82F63B78, 0x709DB87B, 0x63CD4B8F, 0x91A6C88C, 0x456CAC67, 0xB7072F64, 0xA457DC90, 0x563C5F93,
+  0x082F63B7, 0xFA44E0B4, 0xE9141340, 0x1B7F9043, 0xCFB5F4A8, 0x3DDE77AB, 0x2E8E845F, 0xDCE5075C,
+  0x92A8FC17, 0x60C37F14, 0x73938CE0, 0x81F80FE3, 0x55326B08, 0xA759E80B, 0xB4091BFF, 0x466298FC,
+  0x1871A4D8, 0xEA1A27DB, 0xF94AD42F, 0x0B21572C, 0xDFEB33C7, 0x2D80B0C4, 0x3ED04330, 0xCCBBC033,
+  0xA24BB5A6, 0x502036A5, 0x4370C551, 0xB11B4652, 0x65D122B9, 0x97BAA1BA, 0x84EA524E, 0x7681D14D,
+  0x2892ED69, 0xDAF96E6A, 0xC9A99D9E, 0x3BC21E9D, 0xEF087A76, 0x1D63F975, 0x0E330A81, 0xFC588982,
+  0xB21572C9, 0x407EF1CA, 0x532E023E, 0xA145813D, 0x758FE5D6, 0x87E466D5, 0x94B49521, 0x66DF1622,
+  0x38CC2A06, 0xCAA7A905, 0xD9F75AF1, 0x2B9CD9F2, 0xFF56BD19, 0x0D3D3E1A, 0x1E6DCDEE, 0xEC064EED,
+  0xC38D26C4, 0x31E6A5C7, 0x22B65633, 0xD0DDD530, 0x0417B1DB, 0xF67C32D8, 0xE52CC12C, 0x1747422F,
+  0x49547E0B, 0xBB3FFD08, 0xA86F0EFC, 0x5A048DFF, 0x8ECEE914, 0x7CA56A17, 0x6FF599E3, 0x9D9E1AE0,
+  0xD3D3E1AB, 0x21B862A8, 0x32E8915C, 0xC083125F, 0x144976B4, 0xE622F5B7, 0xF5720643, 0x07198540,
+  0x590AB964, 0xAB613A67, 0xB831C993, 0x4A5A4A90, 0x9E902E7B, 0x6CFBAD78, 0x7FAB5E8C, 0x8DC0DD8F,
+  0xE330A81A, 0x115B2B19, 0x020BD8ED, 0xF0605BEE, 0x24AA3F05, 0xD6C1BC06, 0xC5914FF2, 0x37FACCF1,
+  0x69E9F0D5, 0x9B8273D6, 0x88D28022, 0x7AB90321, 0xAE7367CA, 0x5C18E4C9, 0x4F48173D, 0xBD23943E,
+  0xF36E6F75, 0x0105EC76, 0x12551F82, 0xE03E9C81, 0x34F4F86A, 0xC69F7B69, 0xD5CF889D, 0x27A40B9E,
+  0x79B737BA, 0x8BDCB4B9, 0x988C474D, 0x6AE7C44E, 0xBE2DA0A5, 0x4C4623A6, 0x5F16D052, 0xAD7D5351
+};
+
+/// Compute the CRC-32C checksum of a memory block in software (internal)
+static wxUint32 wxSQLite3Crc32cSoftware(wxUint32 crc, const unsigned char* p, size_t len)
+{
+  crc = ~crc;
+  while (len-- > 0)
+  {
+    crc = gs_crc32cTable[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+#if WXSQLITE3_HAVE_CRC32C_SSE42
+#if defined(__GNUC__)
+__attribute__((target("sse4.2")))
+#endif
+static wxUint32 wxSQLite3Crc32cHardware(wxUint32 crc, const unsigned char* p, size_t len)
+{
+  sqlite3_uint64 crc64 = ~crc;
+  while (len >= 8)
+  {
+    sqlite3_uint64 value;
+    memcpy(&value, p, 8);
+    crc64 = _mm_crc32_u64(crc64, value);
+    p += 8;
+    len -= 8;
+  }
+  wxUint32 crc32 = (wxUint32) crc64;
+  while (len-- > 0)
+  {
+    crc32 = _mm_crc32_u8(crc32, *p++);
+  }
+  return ~crc32;
+}
+
+static bool wxSQLite3HasCrc32cHardware()
+{
+#if defined(__GNUC__)
+  return __builtin_cpu_supports("sse4.2") != 0;
+#else
+  int info[4];
+  __cpuid(info, 1);
+  return (info[2] & (1 << 20)) != 0;
+#endif
+}
+#elif WXSQLITE3_HAVE_CRC32C_ARM
+static wxUint32 wxSQLite3Crc32cHardware(wxUint32 crc, const unsigned char* p, size_t len)
+{
+  crc = ~crc;
+  while (len >= 8)
+  {
+    sqlite3_uint64 value;
+    memcpy(&value, p, 8);
+    crc = __crc32cd(crc, value);
+    p += 8;
+    len -= 8;
+  }
+  while (len-- > 0)
+  {
+    crc = __crc32cb(crc, *p++);
+  }
+  return ~crc;
+}
+
+static bool wxSQLite3HasCrc32cHardware()
+{
+  return true;
+}
+#endif
+
+typedef wxUint32 (*wxSQLite3Crc32cImpl)(wxUint32 crc, const unsigned char* p, size_t len);
+
+static const wxUint32 gs_sha256K[64] =
+{
+  0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+  0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+  0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+  0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+  0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+  0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+  0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+  0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+};
+
+static inline wxUint32 wxSQLite3RotateRight32(wxUint32 x, int r)
+{
+  return (x >> r) | (x << (32 - r));
+}
+
+static inline wxUint32 wxSQLite3ReadBE32(const unsigned char* p)
+{
+  return ((wxUint32) p[0] << 24) | ((wxUint32) p[1] << 16) | ((wxUint32) p[2] << 8) | (wxUint32) p[3];
+}
+
+static void wxSQLite3Sha256Block(wxUint32* state, const unsigned char* block)
+{
+  wxUint32 w[64];
+  int j;
+  for (j = 0; j < 16; ++j)
+  {
+    w[j] = wxSQLite3ReadBE32(block + 4 * j);
+  }
+  for (j = 16; j < 64; ++j)
+  {
+    wxUint32 s0 = wxSQLite3RotateRight32(w[j-15], 7) ^ wxSQLite3RotateRight32(w[j-15], 18) ^ (w[j-15] >> 3);
+    wxUint32 s1 = wxSQLite3RotateRight32(w[j-2], 17) ^ wxSQLite3RotateRight32(w[j-2], 19) ^ (w[j-2] >> 10);
+    w[j] = w[j-16] + s0 + w[j-7] + s1;
+  }
+  wxUint32 a = state[0], b = state[1], c = state[2], d = state[3];
+  wxUint32 e = state[4], f = state[5], g = state[6], h = state[7];
+  for (j = 0; j < 64; ++j)
+  {
+    wxUint32 s1 = wxSQLite3RotateRight32(e, 6) ^ wxSQLite3RotateRight32(e, 11) ^ wxSQLite3RotateRight32(e, 25);
+    wxUint32 ch = (e & f) ^ (~e & g);
+    wxUint32 t1 = h + s1 + ch + gs_sha256K[j] + w[j];
+    wxUint32 s0 = wxSQLite3RotateRight32(a, 2) ^ wxSQLite3RotateRight32(a, 13) ^ wxSQLite3RotateRight32(a, 22);
+    wxUint32 maj = (a & b) ^ (a & c) ^ (b & c);
+    wxUint32 t2 = s0 + maj;
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+  state[5] += f;
+  state[6] += g;
+  state[7] += h;
+}
+
+/// Compute the SHA-256 digest of a memory block (internal)
+static void wxSQLite3Sha256(const unsigned char* p, size_t len, unsigned char* digest)
+{
+  wxUint32 state[8] = { 0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+                        0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19 };
+  size_t remaining = len;
+  while (remaining >= 64)
+  {
+    wxSQLite3Sha256Block(state, p);
+    p += 64;
+    remaining -= 64;
+  }
+  // Final block(s) with padding and the message length in bits
+  unsigned char block[128];
+  memset(block, 0, sizeof(block));
+  if (remaining > 0)
+  {
+    memcpy(block, p, remaining);
+  }
+  block[remaining] = 0x80;
+  size_t blockLen = (remaining < 56) ? 64 : 128;
+  sqlite3_uint64 bits = (sqlite3_uint64) len * 8;
+  int j;
+  for (j = 0; j < 8; ++j)
+  {
+    block[blockLen - 1 - j] = (unsigned char) (bits >> (8 * j));
+  }
+  wxSQLite3Sha256Block(state, block);
+  if (blockLen == 128)
+  {
+    wxSQLite3Sha256Block(state, block + 64);
+  }
+  for (j = 0; j < 8; ++j)
+  {
+    digest[4 * j]     = (unsigned char) (state[j] >> 24);
+    digest[4 * j + 1] = (unsigned char) (state[j] >> 16);
+    digest[4 * j + 2] = (unsigned char) (state[j] >> 8);
+    digest[4 * j + 3] = (unsigned char) state[j];
+  }
+}
+
+static const char* gs_hexDigits = "0123456789abcdef";
+
+#if WXSQLITE3_HAVE_SSE2
+// Convert the nibbles (0..15) of a vector to lower case hexadecimal digits
+static inline __m128i wxSQLite3HexDigits128(__m128i nibbles)
+{
+  __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)), _mm_set1_epi8('a' - '0' - 10));
+  return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letter);
+}
+
+// Convert hexadecimal digits to their values, clearing the valid mask for other characters
+static inline __m128i wxSQLite3HexValues128(__m128i chars, __m128i& valid)
+{
+  __m128i digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+  __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+  __m128i letter = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+  __m128i isLetter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+  valid = _mm_and_si128(valid, _mm_or_si128(isDigit, isLetter));
+  return _mm_or_si128(_mm_and_si128(digit, isDigit),
+                      _mm_and_si128(_mm_add_epi8(letter, _mm_set1_epi8(10)), isLetter));
+}
+
+// Combine pairs of nibbles (high nibble first) to bytes
+static inline __m128i wxSQLite3HexCombine128(__m128i values)
+{
+  return _mm_or_si128(_mm_slli_epi16(_mm_and_si128(values, _mm_set1_epi16(0x00FF)), 4), _mm_srli_epi16(values, 8));
+}
+#endif
+
+/// Encode binary data as hexadecimal text; out must have room for 2*len characters (internal)
+static void wxSQLite3HexEncode(const unsigned char* in, size_t len, char* out)
+{
+  size_t j = 0;
+#if WXSQLITE3_HAVE_SSE2
+  const __m128i mask = _mm_set1_epi8(0x0F);
+  for (; j + 16 <= len; j += 16)
+  {
+    __m128i value = _mm_loadu_si128((const __m128i*) (in + j));
+    __m128i hi = wxSQLite3HexDigits128(_mm_and_si128(_mm_srli_epi16(value, 4), mask));
+    __m128i lo = wxSQLite3HexDigits128(_mm_and_si128(value, mask));
+    _mm_storeu_si128((__m128i*) (out + 2 * j), _mm_unpacklo_epi8(hi, lo));
+    _mm_storeu_si128((__m128i*) (out + 2 * j + 16), _mm_unpackhi_epi8(hi, lo));
+  }
+#endif
+  for (; j < len; ++j)
+  {
+    out[2 * j] = gs_hexDigits[in[j] >> 4];
+    out[2 * j + 1] = gs_hexDigits[in[j] & 0x0F];
+  }
+}
+
+static inline int wxSQLite3HexValue(unsigned char c)
+{
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+/// Decode hexadecimal text of even length; out must have room for len/2 bytes (internal)
+static bool wxSQLite3HexDecode(const unsigned char* in, size_t len, unsigned char* out)
+{
+  size_t j = 0;
+  size_t outLen = len / 2;
+#if WXSQLITE3_HAVE_SSE2
+  for (; j + 16 <= outLen; j += 16)
+  {
+    __m128i valid = _mm_set1_epi8((char) 0xFF);
+    __m128i lo = wxSQLite3HexValues128(_mm_loadu_si128((const __m128i*) (in + 2 * j)), valid);
+    __m128i hi = wxSQLite3HexValues128(_mm_loadu_si128((const __m128i*) (in + 2 * j + 16)), valid);
+    if (_mm_movemask_epi8(valid) != 0xFFFF)
+    {
+      return false;
+    }
+    _mm_storeu_si128((__m128i*) (out + j), _mm_packus_epi16(wxSQLite3HexCombine128(lo), wxSQLite3HexCombine128(hi)));
+  }
+#endif
+  for (; j < outLen; ++j)
+  {
+    int hi = wxSQLite3HexValue(in[2 * j]);
+    int lo = wxSQLite3HexValue(in[2 * j + 1]);
+    if (hi < 0 || lo < 0)
+    {
+      return false;
+    }
+    out[j] = (unsigned char) ((hi << 4) | lo);
+  }
+  return true;
+}
+
+static const char* gs_base64Alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static const unsigned char gs_base64Values[256] =
+{
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x3E, 0xFF, 0xFF, 0xFF, 0x3F,
+  0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+  0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+  0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+/// Encode binary data as Base64 text; out must have room for 4*((len+2)/3) characters (internal)
+static void wxSQLite3Base64Encode(const unsigned char* in, size_t len, char* out)
+{
+  size_t j = 0;
+#if WXSQLITE3_HAVE_SSSE3
+  // Encode 12 input bytes to 16 characters per iteration (16 bytes are read)
+  const __m128i shuffle = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+  const __m128i shiftLut = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                         '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                         '/' - 63, 'A', 0, 0);
+  for (; j + 16 <= len; j += 12, out += 16)
+  {
+    __m128i value = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (in + j)), shuffle);
+    __m128i t0 = _mm_mulhi_epu16(_mm_and_si128(value, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+    __m128i t1 = _mm_mullo_epi16(_mm_and_si128(value, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+    __m128i indices = _mm_or_si128(t0, t1);
+    __m128i lut = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    lut = _mm_or_si128(lut, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices), _mm_set1_epi8(13)));
+    _mm_storeu_si128((__m128i*) out, _mm_add_epi8(_mm_shuffle_epi8(shiftLut, lut), indices));
+  }
+#endif
+  for (; j + 3 <= len; j += 3, out += 4)
+  {
+    wxUint32 value = ((wxUint32) in[j] << 16) | ((wxUint32) in[j + 1] << 8) | in[j + 2];
+    out[0] = gs_base64Alphabet[(value >> 18) & 0x3F];
+    out[1] = gs_base64Alphabet[(value >> 12) & 0x3F];
+    out[2] = gs_base64Alphabet[(value >> 6) & 0x3F];
+    out[3] = gs_base64Alphabet[value & 0x3F];
+  }
+  if (j < len)
+  {
+    wxUint32 value = (wxUint32) in[j] << 16;
+    if (j + 1 < len)
+    {
+      value |= (wxUint32) in[j + 1] << 8;
+    }
+    out[0] = gs_base64Alphabet[(value >> 18) & 0x3F];
+    out[1] = gs_base64Alphabet[(value >> 12) & 0x3F];
+    out[2] = (j + 1 < len) ? gs_base64Alphabet[(value >> 6) & 0x3F] : '=';
+    out[3] = '=';
+  }
+}
+
+/// Decode Base64 text; out must have room for 3*(len/4)+2 bytes plus 4 bytes of slack (internal)
+/**
+* Returns the number of decoded bytes, or -1 if the text is malformed.
+*/
+static sqlite3_int64 wxSQLite3Base64Decode(const unsigned char* in, size_t len, unsigned char* out)
+{
+  if (len % 4 == 0 && len > 0 && in[len - 1] == '=')
+  {
+    len -= (in[len - 2] == '=') ? 2 : 1;
+  }
+  if (len % 4 == 1)
+  {
+    return -1;
+  }
+  unsigned char* start = out;
+  size_t j = 0;
+#if WXSQLITE3_HAVE_SSSE3
+  // Decode 16 characters to 12 bytes per iteration (16 bytes are written)
+  const __m128i lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                      0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+  const __m128i lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                      0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i mask = _mm_set1_epi8(0x0F);
+  const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+  for (; j + 16 <= len; j += 16, out += 12)
+  {
+    __m128i chars = _mm_loadu_si128((const __m128i*) (in + j));
+    __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(chars, 4), mask);
+    __m128i lo = _mm_shuffle_epi8(lutLo, _mm_and_si128(chars, mask));
+    __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0xFFFF)
+    {
+      // Let the scalar loop handle (and reject) the invalid characters
+      break;
+    }
+    __m128i eqSlash = _mm_cmpeq_epi8(chars, _mm_set1_epi8('/'));
+    __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(eqSlash, hiNibbles));
+    __m128i values = _mm_add_epi8(chars, roll);
+    __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    merged = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+    _mm_storeu_si128((__m128i*) out, _mm_shuffle_epi8(merged, pack));
+  }
+#endif
+  for (; j + 4 <= len; j += 4, out += 3)
+  {
+    unsigned char a = gs_base64Values[in[j]];
+    unsigned char b = gs_base64Values[in[j + 1]];
+    unsigned char c = gs_base64Values[in[j + 2]];
+    unsigned char d = gs_base64Values[in[j + 3]];
+    if ((a | b | c | d) & 0x80)
+    {
+      return -1;
+    }
+    wxUint32 value = ((wxUint32) a << 18) | ((wxUint32) b << 12) | ((wxUint32) c << 6) | d;
+    out[0] = (unsigned char) (value >> 16);
+    out[1] = (unsigned char) (value >> 8);
+    out[2] = (unsigned char) value;
+  }
+  if (j < len)
+  {
+    unsigned char a = gs_base64Values[in[j]];
+    unsigned char b = gs_base64Values[in[j + 1]];
+    unsigned char c = (j + 2 < len) ? gs_base64Values[in[j + 2]] : 0;
+    if ((a | b | c) & 0x80)
+    {
+      return -1;
+    }
+    wxUint32 value = ((wxUint32) a << 18) | ((wxUint32) b << 12) | ((wxUint32) c << 6);
+    *out++ = (unsigned char) (value >> 16);
+    if (j + 2 < len)
+    {
+      *out++ = (unsigned char) (value >> 8);
+    }
+  }
+  return out - start;
+}
+
+// --- Hash, checksum and encoding functions
+
+// Get a function argument as bytes without copying: BLOBs as is, other values as UTF-8 text
+static const unsigned char* wxSQLite3GetArgBytes(sqlite3_context* ctx, sqlite3_value* value, size_t& len)
+{
+  static const unsigned char empty[1] = { 0 };
+  len = 0;
+  int type = sqlite3_value_type(value);
+  if (type == SQLITE_NULL)
+  {
+    sqlite3_result_null(ctx);
+    return NULL;
+  }
+  const unsigned char* data = (type == SQLITE_BLOB) ? (const unsigned char*) sqlite3_value_blob(value)
+                                                    : sqlite3_value_text(value);
+  len = (size_t) sqlite3_value_bytes(value);
+  if (data == NULL)
+  {
+    if (type == SQLITE_BLOB || len > 0)
+    {
+      return empty;
+    }
+    sqlite3_result_error_nomem(ctx);
+  }
+  return data;
+}
+
+static void wxSQLite3XXH64Function(sqlite3_context* ctx, int argc, sqlite3_value** argv)
+{
+  size_t len;
+  const unsigned char* data = wxSQLite3GetArgBytes(ctx, argv[0], len);
+  if (data != NULL)
+  {
+    sqlite3_uint64 seed = (argc > 1) ? (sqlite3_uint64) sqlite3_value_int64(argv[1]) : 0;
+    sqlite3_result_int64(ctx, (sqlite3_int64) wxSQLite3XXH64(data, len, seed));
+  }
+}
+
+static void wxSQLite3XXH3Function(sqlite3_context* ctx, int argc, sqlite3_value** argv)
+{
+  size_t len;
+  const unsigned char* data = wxSQLite3GetArgBytes(ctx, argv[0], len);
+  if (data != NULL)
+  {
+    sqlite3_uint64 seed = (argc > 1) ? (sqlite3_uint64) sqlite3_value_int64(argv[1]) : 0;
+    sqlite3_result_int64(ctx, (sqlite3_int64) wxSQLite3XXH3(data, len, seed));
+  }
+}
+
+static void wxSQLite3Crc32cFunction(sqlite3_context* ctx, int argc, sqlite3_value** argv)
+{
+  size_t len;
+  const unsigned char* data = wxSQLite3GetArgBytes(ctx, argv[0], len);
+  if (data != NULL)
+  {
+    wxSQLite3Crc32cImpl crc32c = (wxSQLite3Crc32cImpl) sqlite3_user_data(ctx);
+    wxUint32 crc = (argc > 1) ? (wxUint32) sqlite3_value_int64(argv[1]) : 0;
+    sqlite3_result_int64(ctx, (sqlite3_int64) crc32c(crc, data, len));
+  }
+}
+
+static void wxSQLite3Sha256Function(sqlite3_context* ctx, int WXUNUSED(argc), sqlite3_value** argv)
+{
+  size_t len;
+  const unsigned char* data = wxSQLite3GetArgBytes(ctx, argv[0], len);
+  if (data != NULL)
+  {
+    unsigned char digest[32];
+    wxSQLite3Sha256(data, len, digest);
+    sqlite3_result_blob(ctx, digest, 32, SQLITE_TRANSIENT);
+  }
+}
+
+static void wxSQLite3HexEncodeFunction(sqlite3_context* ctx, int WXUNUSED(argc), sqlite3_value** argv)
+{
+  size_t len;
+  const unsigned char* data = wxSQLite3GetArgBytes(ctx, argv[0], len);
+  if (data != NULL)
+  {
+    char* text = (char*) sqlite3_malloc64(2 * (sqlite3_uint64) len + 1);
+    if (text == NULL)
+    {
+      sqlite3_result_error_nomem(ctx);
+      return;
+    }
+    wxSQLite3HexEncode(data, len, text);
+    sqlite3_result_text64(ctx, text, 2 * (sqlite3_uint64) len, sqlite3_free, SQLITE_UTF8);
+  }
+}
+
+static void wxSQLite3HexDecodeFunction(sqlite3_context* ctx, int WXUNUSED(argc), sqlite3_value** argv)
+{
+  size_t len;
+  const unsigned char* data = wxSQLite3GetArgBytes(ctx, argv[0], len);
+  if (data != NULL)
+  {
+    if (len % 2 != 0)
+    {
+      sqlite3_result_null(ctx);
+      return;
+    }
+    unsigned char* blob = (unsigned char*) sqlite3_malloc64(len / 2 + 1);
+    if (blob == NULL)
+    {
+      sqlite3_result_error_nomem(ctx);
+      return;
+    }
+    if (wxSQLite3HexDecode(data, len, blob))
+    {
+      sqlite3_result_blob64(ctx, blob, len / 2, sqlite3_free);
+    }
+    else
+    {
+      sqlite3_free(blob);
+      sqlite3_result_null(ctx);
+    }
+  }
+}
+
+static void wxSQLite3Base64EncodeFunction(sqlite3_context* ctx, int WXUNUSED(argc), sqlite3_value** argv)
+{
+  size_t len;
+  const unsigned char* data = wxSQLite3GetArgBytes(ctx, argv[0], len);
+  if (data != NULL)
+  {
+    sqlite3_uint64 textLen = 4 * (((sqlite3_uint64) len + 2) / 3);
+    char* text = (char*) sqlite3_malloc64(textLen + 1);
+    if (text == NULL)
+    {
+      sqlite3_result_error_nomem(ctx);
+      return;
+    }
+    wxSQLite3Base64Encode(data, len, text);
+    sqlite3_result_text64(ctx, text, textLen, sqlite3_free, SQLITE_UTF8);
+  }
+}
+
+static void wxSQLite3Base64DecodeFunction(sqlite3_context* ctx, int WXUNUSED(argc), sqlite3_value** argv)
+{
+  size_t len;
+  const unsigned char* data = wxSQLite3GetArgBytes(ctx, argv[0], len);
+  if (data != NULL)
+  {
+    unsigned char* blob = (unsigned char*) sqlite3_malloc64(3 * ((sqlite3_uint64) len / 4) + 6);
+    if (blob == NULL)
+    {
+      sqlite3_result_error_nomem(ctx);
+      return;
+    }
+    sqlite3_int64 blobLen = wxSQLite3Base64Decode(data, len, blob);
+    if (blobLen >= 0)
+    {
+      sqlite3_result_blob64(ctx, blob, (sqlite3_uint64) blobLen, sqlite3_free);
+    }
+    else
+    {
+      sqlite3_free(blob);
+      sqlite3_result_null(ctx);
+    }
+  }
+}
+
+/// Definition of a native scalar function (internal)
+struct wxSQLite3NativeScalarFunctionDef
+{
+  const char* m_name;
+  int         m_argCount;
+  void (*m_xFunc)(sqlite3_context*, int, sqlite3_value**);
+};
+
+static const wxSQLite3NativeScalarFunctionDef gs_hashFunctions[] =
+{
+  { "xxh64",         1, wxSQLite3XXH64Function        },
+  { "xxh64",         2, wxSQLite3XXH64Function        },
+  { "xxh3",          1, wxSQLite3XXH3Function         },
+  { "xxh3",          2, wxSQLite3XXH3Function         },
+  { "crc32c",        1, wxSQLite3Crc32cFunction       },
+  { "crc32c",        2, wxSQLite3Crc32cFunction       },
+  { "sha256",        1, wxSQLite3Sha256Function       },
+  { "hex_encode",    1, wxSQLite3HexEncodeFunction    },
+  { "hex_decode",    1, wxSQLite3HexDecodeFunction    },
+  { "base64_encode", 1, wxSQLite3Base64EncodeFunction },
+  { "base64_decode", 1, wxSQLite3Base64DecodeFunction }
+};
+
+void wxSQLite3Database::CreateHashFunctions()
+{
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  // The CRC-32C implementation is selected once and passed as user data
+  wxSQLite3Crc32cImpl crc32c = wxSQLite3Crc32cSoftware;
+#if WXSQLITE3_HAVE_CRC32C_SSE42 || WXSQLITE3_HAVE_CRC32C_ARM
+  if (wxSQLite3HasCrc32cHardware())
+  {
+    crc32c = wxSQLite3Crc32cHardware;
+  }
+#endif
+  int flags = SQLITE_UTF8 | SQLITE_DETERMINISTIC | SQLITE_INNOCUOUS;
+  size_t j;
+  for (j = 0; j < sizeof(gs_hashFunctions) / sizeof(gs_hashFunctions[0]); ++j)
+  {
+    const wxSQLite3NativeScalarFunctionDef& def = gs_hashFunctions[j];
+    int rc = sqlite3_create_function_v2(m_db->m_db, def.m_name, def.m_argCount, flags, (void*) crc32c,
+                                        def.m_xFunc, NULL, NULL, NULL);
+    if (rc != SQLITE_OK)
+    {
+      const char* localError = sqlite3_errmsg(m_db->m_db);
+      throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+    }
+  }
+}
+
+#if wxUSE_ZLIB && wxUSE_STREAMS
 
-bool wxSQLite3Database::ms_hasIncrementalBlobSupport = true;
+/// Output stream writing into a memory block of fixed size (internal)
+class wxSQLite3FixedOutputStream : public wxOutputStream
+{
+public:
+  wxSQLite3FixedOutputStream(unsigned char* buffer, size_t size)
+    : m_buffer(buffer), m_size(size), m_position(0)
+  {
+  }
 
-bool wxSQLite3Database::ms_hasSavepointSupport = true;
+  size_t GetPosition() const { return m_position; }
 
-bool wxSQLite3Database::ms_hasBackupSupport = true;
+protected:
+  virtual size_t OnSysWrite(const void* buffer, size_t size)
+  {
+    size_t length = (size < m_size - m_position) ? size : m_size - m_position;
+    memcpy(m_buffer + m_position, buffer, length);
+    m_position += length;
+    if (length < size)
+    {
+      m_lasterror = wxSTREAM_WRITE_ERROR;
+    }
+    return length;
+  }
 
-bool wxSQLite3Database::ms_hasWriteAheadLogSupport = true;
+  virtual wxFileOffset OnSysTell() const
+  {
+    return (wxFileOffset) m_position;
+  }
 
-bool wxSQLite3Database::ms_hasPointerParamsSupport = true;
+private:
+  unsigned char* m_buffer;   ///< Memory block
+  size_t         m_size;     ///< Size of the memory block
+  size_t         m_position; ///< Current write position
+};
 
-bool
-wxSQLite3Database::HasEncryptionSupport()
+static void wxSQLite3CompressFunction(sqlite3_context* ctx, int argc, sqlite3_value** argv)
 {
-  return ms_hasEncryptionSupport;
+  size_t len;
+  const unsigned char* data = wxSQLite3GetArgBytes(ctx, argv[0], len);
+  if (data == NULL)
+  {
+    return;
+  }
+  int level = -1;
+  if (argc > 1)
+  {
+    level = sqlite3_value_int(argv[1]);
+    if (sqlite3_value_type(argv[1]) != SQLITE_INTEGER || level < -1 || level > 9)
+    {
+      sqlite3_result_error(ctx, "compression level must be an integer between -1 and 9", -1);
+      return;
+    }
+  }
+  bool isText = sqlite3_value_type(argv[0]) != SQLITE_BLOB;
+  sqlite3_uint64 frameSize = gs_compressHeaderSize + wxSQLite3CompressBound(len);
+  unsigned char* frame = (unsigned char*) sqlite3_malloc64(frameSize);
+  if (frame == NULL)
+  {
+    sqlite3_result_error_nomem(ctx);
+    return;
+  }
+  int codec = gs_compressCodecStored;
+  size_t payloadLen = len;
+  if (level != 0 && len > 0)
+  {
+    wxLogNull logNo;
+    wxSQLite3FixedOutputStream out(frame + gs_compressHeaderSize, (size_t) (frameSize - gs_compressHeaderSize));
+    wxZlibOutputStream zlibStream(out, level, wxZLIB_ZLIB);
+    bool ok = zlibStream.Write(data, len).LastWrite() == len;
+    ok = zlibStream.Close() && ok && out.IsOk();
+    if (ok && out.GetPosition() < len)
+    {
+      codec = gs_compressCodecZlib;
+      payloadLen = out.GetPosition();
+    }
+  }
+  if (codec == gs_compressCodecStored && len > 0)
+  {
+    memcpy(frame + gs_compressHeaderSize, data, len);
+  }
+  wxSQLite3WriteCompressHeader(frame, codec, isText, len);
+  sqlite3_result_blob64(ctx, frame, gs_compressHeaderSize + (sqlite3_uint64) payloadLen, sqlite3_free);
 }
 
-bool
-wxSQLite3Database::HasMetaDataSupport()
+static void wxSQLite3UncompressFunction(sqlite3_context* ctx, int WXUNUSED(argc), sqlite3_value** argv)
 {
-  return ms_hasMetaDataSupport;
+  int codec;
+  bool isText;
+  sqlite3_uint64 originalSize;
+  const unsigned char* data = NULL;
+  size_t len = 0;
+  if (sqlite3_value_type(argv[0]) == SQLITE_BLOB)
+  {
+    data = (const unsigned char*) sqlite3_value_blob(argv[0]);
+    len = (size_t) sqlite3_value_bytes(argv[0]);
+  }
+  if (!wxSQLite3ReadCompressHeader(data, len, codec, isText, originalSize))
+  {
+    // Values not in the frame format are returned unchanged
+    sqlite3_result_value(ctx, argv[0]);
+    return;
+  }
+  if (originalSize > (sqlite3_uint64) sqlite3_limit(sqlite3_context_db_handle(ctx), SQLITE_LIMIT_LENGTH, -1))
+  {
+    sqlite3_result_error_toobig(ctx);
+    return;
+  }
+  const unsigned char* payload = data + gs_compressHeaderSize;
+  if (codec == gs_compressCodecStored)
+  {
+    if (isText)
+    {
+      sqlite3_result_text64(ctx, (const char*) payload, originalSize, SQLITE_TRANSIENT, SQLITE_UTF8);
+    }
+    else
+    {
+      sqlite3_result_blob64(ctx, payload, originalSize, SQLITE_TRANSIENT);
+    }
+    return;
+  }
+  // The original size comes from the frame header, don't trust it beyond what the payload can hold
+  if (originalSize > gs_compressMaxRatio * (sqlite3_uint64) (len - gs_compressHeaderSize))
+  {
+    sqlite3_result_error(ctx, "corrupt compressed data", -1);
+    return;
+  }
+  unsigned char* buffer = (unsigned char*) sqlite3_malloc64(originalSize + 1);
+  if (buffer == NULL)
+  {
+    sqlite3_result_error_nomem(ctx);
+    return;
+  }
+  if (originalSize > 0)
+  {
+    wxLogNull logNo;
+    wxMemoryInputStream in(payload, len - gs_compressHeaderSize);
+    wxZlibInputStream zlibStream(in, wxZLIB_ZLIB);
+    if (zlibStream.Read(buffer, (size_t) originalSize).LastRead() != originalSize)
+    {
+      sqlite3_free(buffer);
+      sqlite3_result_error(ctx, "corrupt compressed data", -1);
+      return;
+    }
+  }
+  if (isText)
+  {
+    sqlite3_result_text64(ctx, (const char*) buffer, originalSize, sqlite3_free, SQLITE_UTF8);
+  }
+  else
+  {
+    sqlite3_result_blob64(ctx, buffer, originalSize, sqlite3_free);
+  }
 }
 
-bool
-wxSQLite3Database::HasUserAuthenticationSupport()
+static const wxSQLite3NativeScalarFunctionDef gs_compressionFunctions[] =
 {
-  return ms_hasUserAuthentication;
-}
+  { "compress",   1, wxSQLite3CompressFunction   },
+  { "compress",   2, wxSQLite3CompressFunction   },
+  { "uncompress", 1, wxSQLite3UncompressFunction }
+};
 
-bool
-wxSQLite3Database::HasLoadExtSupport()
-{
-  return ms_hasLoadExtSupport;
-}
+#endif // wxUSE_ZLIB && wxUSE_STREAMS
 
-bool
-wxSQLite3Database::HasNamedCollectionSupport()
+void wxSQLite3Database::CreateCompressionFunctions()
 {
-  return ms_hasNamedCollectionSupport;
+  WXSQLITE3_PROFILE();
+#if wxUSE_ZLIB && wxUSE_STREAMS
+  CheckDatabase();
+  int flags = SQLITE_UTF8 | SQLITE_DETERMINISTIC | SQLITE_INNOCUOUS;
+  size_t j;
+  for (j = 0; j < sizeof(gs_compressionFunctions) / sizeof(gs_compressionFunctions[0]); ++j)
+  {
+    const wxSQLite3NativeScalarFunctionDef& def = gs_compressionFunctions[j];
+    int rc = sqlite3_create_function_v2(m_db->m_db, def.m_name, def.m_argCount, flags, NULL,
+                                        def.m_xFunc, NULL, NULL, NULL);
+    if (rc != SQLITE_OK)
+    {
+      const char* localError = sqlite3_errmsg(m_db->m_db);
+      throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+    }
+  }
+#else
+  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOZLIB);
+#endif
 }
 
-bool
-wxSQLite3Database::HasIncrementalBlobSupport()
+// --- Statement tracing
+
+#if WXSQLITE3_HAVE_CXX11
+
+/// Statistics counter written by a single thread and read by any thread (internal)
+class wxSQLite3TraceCounter
 {
-  return ms_hasIncrementalBlobSupport;
-}
+public:
+  wxSQLite3TraceCounter() : m_value(0) {}
+  wxUint64 Get() const { return m_value.load(std::memory_order_relaxed); }
+  wxUint64 GetAcquire() const { return m_value.load(std::memory_order_acquire); }
+  void Set(wxUint64 value) { m_value.store(value, std::memory_order_relaxed); }
+  void SetRelease(wxUint64 value) { m_value.store(value, std::memory_order_release); }
+  void Add(wxUint64 value) { Set(Get() + value); }
 
-bool
-wxSQLite3Database::HasSavepointSupport()
+private:
+  std::atomic<wxUint64> m_value;
+};
+
+static inline void wxSQLite3TraceFenceRelease() { std::atomic_thread_fence(std::memory_order_release); }
+static inline void wxSQLite3TraceFenceAcquire() { std::atomic_thread_fence(std::memory_order_acquire); }
+
+#else
+
+/// Statistics counter written by a single thread and read by any thread (internal)
+class wxSQLite3TraceCounter
 {
-  return ms_hasSavepointSupport;
-}
+public:
+  wxSQLite3TraceCounter() : m_value(0) {}
+  wxUint64 Get() const { return m_value; }
+  wxUint64 GetAcquire() const { return m_value; }
+  void Set(wxUint64 value) { m_value = value; }
+  void SetRelease(wxUint64 value) { m_value = value; }
+  void Add(wxUint64 value) { m_value += value; }
 
-bool
-wxSQLite3Database::HasBackupSupport()
+private:
+  volatile wxUint64 m_value;
+};
+
+static inline void wxSQLite3TraceFenceRelease() {}
+static inline void wxSQLite3TraceFenceAcquire() {}
+
+#endif
+
+// Monotonic clock in nanoseconds
+static wxUint64 wxSQLite3TraceClock()
 {
-  return ms_hasBackupSupport;
+#if WXSQLITE3_HAVE_CXX11
+  return (wxUint64) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#elif wxCHECK_VERSION(2,9,3)
+  return (wxUint64) wxGetUTCTimeUSec().GetValue() * 1000;
+#else
+  return (wxUint64) wxGetLocalTimeMillis().GetValue() * 1000000;
+#endif
 }
 
-bool
-wxSQLite3Database::HasWriteAheadLogSupport()
+static const sqlite3_uint64 gs_traceHistogramMaxValue = (wxULL(1) << 42) - 1;
+
+wxSQLite3LatencyHistogram::wxSQLite3LatencyHistogram()
 {
-  return ms_hasWriteAheadLogSupport;
+  Reset();
 }
 
-bool
-wxSQLite3Database::HasPointerParamsSupport()
+void wxSQLite3LatencyHistogram::Reset()
 {
-  return ms_hasPointerParamsSupport;
+  memset(m_buckets, 0, sizeof(m_buckets));
+  m_count = 0;
+  m_total = 0;
+  m_min = ~((wxUint64) 0);
+  m_max = 0;
 }
 
-wxSQLite3Database::wxSQLite3Database()
+void wxSQLite3LatencyHistogram::Record(wxUint64 nanoseconds)
 {
-  m_db = 0;
-  m_isOpen = false;
-  m_busyTimeoutMs = 60000; // 60 seconds
-  m_isEncrypted = false;
-  m_lastRollbackRC = 0;
-  m_backupPageCount = 10;
+  ++m_buckets[GetBucketIndex(nanoseconds)];
+  ++m_count;
+  m_total += nanoseconds;
+  if (nanoseconds < m_min) m_min = nanoseconds;
+  if (nanoseconds > m_max) m_max = nanoseconds;
 }
 
-wxSQLite3Database::wxSQLite3Database(const wxSQLite3Database& db)
+void wxSQLite3LatencyHistogram::Merge(const wxSQLite3LatencyHistogram& histogram)
 {
-  m_db = db.m_db;
-  if (m_db != NULL)
+  int j;
+  for (j = 0; j < BUCKET_COUNT; ++j)
   {
-    m_db->IncrementRefCount();
+    m_buckets[j] += histogram.m_buckets[j];
   }
-  m_isOpen = db.m_isOpen;
-  m_busyTimeoutMs = 60000; // 60 seconds
-  m_isEncrypted = db.m_isEncrypted;
-  m_lastRollbackRC = db.m_lastRollbackRC;
-  m_backupPageCount = db.m_backupPageCount;
+  m_count += histogram.m_count;
+  m_total += histogram.m_total;
+  if (histogram.m_min < m_min) m_min = histogram.m_min;
+  if (histogram.m_max > m_max) m_max = histogram.m_max;
 }
 
-wxSQLite3Database::~wxSQLite3Database()
+wxUint64 wxSQLite3LatencyHistogram::GetPercentile(double percentile) const
 {
-  if (m_db != NULL && m_db->DecrementRefCount() == 0)
+  if (m_count == 0)
   {
-    if (m_db->m_isValid)
+    return 0;
+  }
+  if (percentile < 0) percentile = 0;
+  if (percentile > 100) percentile = 100;
+  wxUint64 rank = (wxUint64) ceil(percentile / 100.0 * (double) m_count);
+  if (rank < 1) rank = 1;
+  if (rank >= m_count)
+  {
+    return m_max;
+  }
+  wxUint64 cumulated = 0;
+  int j;
+  for (j = 0; j < BUCKET_COUNT; ++j)
+  {
+    cumulated += m_buckets[j];
+    if (cumulated >= rank)
     {
-      Close(m_db);
+      break;
     }
-    delete m_db;
   }
+  if (j == BUCKET_COUNT)
+  {
+    return m_max;
+  }
+  wxUint64 lower = GetBucketLowerBound(j);
+  wxUint64 value = lower + (GetBucketUpperBound(j) - lower) / 2;
+  if (value < m_min) value = m_min;
+  if (value > m_max) value = m_max;
+  return value;
 }
 
-wxSQLite3Database& wxSQLite3Database::operator=(const wxSQLite3Database& db)
+/* static */
+int wxSQLite3LatencyHistogram::GetBucketIndex(wxUint64 nanoseconds)
 {
-  if (this != &db)
+  // Values below 32 have buckets of their own,
+  // above each power of two is divided into 16 sub-buckets
+  if (nanoseconds < 32)
   {
-    wxSQLite3DatabaseReference* dbPrev = m_db;
-    m_db = db.m_db;
-    if (m_db != NULL)
-    {
-      m_db->IncrementRefCount();
-      m_isOpen = db.m_isOpen;
-      m_busyTimeoutMs = 60000; // 60 seconds
-      m_isEncrypted = db.m_isEncrypted;
-      m_lastRollbackRC = db.m_lastRollbackRC;
-      m_backupPageCount = db.m_backupPageCount;
-    }
-    if (dbPrev != NULL && dbPrev->DecrementRefCount() == 0)
-    {
-      Close(dbPrev);
-      delete dbPrev;
-    }
-
-    if (m_db == NULL)
-    {
-      throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_DBASSIGN_FAILED);
-    }
+    return (int) nanoseconds;
   }
-  return *this;
+  if (nanoseconds > gs_traceHistogramMaxValue)
+  {
+    nanoseconds = gs_traceHistogramMaxValue;
+  }
+  int exponent = 5;
+  while ((nanoseconds >> (exponent + 1)) != 0)
+  {
+    ++exponent;
+  }
+  int shift = exponent - 4;
+  return 32 + (exponent - 5) * 16 + (int) (nanoseconds >> shift) - 16;
 }
 
-void wxSQLite3Database::Open(const wxString& fileName, const wxString& key, int flags, const wxString& vfs)
+/* static */
+wxUint64 wxSQLite3LatencyHistogram::GetBucketLowerBound(int bucket)
 {
-  wxCharBuffer strLocalKey = key.ToUTF8();
-  const char* localKey = strLocalKey;
-  wxMemoryBuffer binaryKey;
-  if (key.Length() > 0)
+  if (bucket < 32)
   {
-    binaryKey.AppendData((void*) localKey, strlen(localKey));
+    return (bucket > 0) ? (wxUint64) bucket : 0;
   }
-  Open(fileName, binaryKey, flags, vfs);
+  if (bucket >= BUCKET_COUNT)
+  {
+    bucket = BUCKET_COUNT - 1;
+  }
+  int shift = (bucket - 32) / 16 + 1;
+  wxUint64 mantissa = 16 + (bucket - 32) % 16;
+  return mantissa << shift;
 }
 
-void wxSQLite3Database::Open(const wxString& fileName, const wxMemoryBuffer& key, int flags, const wxString& vfs)
+/* static */
+wxUint64 wxSQLite3LatencyHistogram::GetBucketUpperBound(int bucket)
 {
-  wxCharBuffer strFileName = fileName.ToUTF8();
-  const char* localFileName = strFileName;
-  wxCharBuffer strVfs = vfs.ToUTF8();
-  const char* localVfs = (!vfs.IsEmpty()) ? (const char*) strVfs : (const char*) NULL;
-  sqlite3* db;
+  if (bucket < 32)
+  {
+    return (bucket > 0) ? (wxUint64) bucket : 0;
+  }
+  if (bucket >= BUCKET_COUNT)
+  {
+    bucket = BUCKET_COUNT - 1;
+  }
+  int shift = (bucket - 32) / 16 + 1;
+  wxUint64 mantissa = 16 + (bucket - 32) % 16;
+  return ((mantissa + 1) << shift) - 1;
+}
 
-  int rc = sqlite3_open_v2((const char*) localFileName, &db, flags, localVfs);
+static bool wxSQLite3IsIdentifierChar(unsigned char c)
+{
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '$' || c >= 0x80;
+}
 
-  if (rc != SQLITE_OK)
+// Normalize SQL text into its fingerprint
+// The buffer must be able to hold 2*len+1 bytes, since a blank may be inserted between tokens.
+static size_t wxSQLite3NormalizeSQL(const char* sql, size_t len, char* out)
+{
+  enum { TOKEN_NONE, TOKEN_WORD, TOKEN_LITERAL, TOKEN_COMMA, TOKEN_OPEN, TOKEN_CLOSE, TOKEN_DOT, TOKEN_OTHER };
+  size_t n = 0;
+  size_t listStart = 0;
+  bool listActive = false;
+  int prevToken = TOKEN_NONE;
+  int prevPrevToken = TOKEN_NONE;
+  size_t i = 0;
+  while (i < len)
   {
-    const char* localError = "Out of memory";
-    if (db != NULL)
+    unsigned char c = (unsigned char) sql[i];
+    unsigned char next = (i + 1 < len) ? (unsigned char) sql[i + 1] : 0;
+    if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v')
     {
-      localError = sqlite3_errmsg(db);
-      sqlite3_close(db);
+      ++i;
+      continue;
+    }
+    if (c == '-' && next == '-')
+    {
+      while (i < len && sql[i] != '\n') ++i;
+      continue;
+    }
+    if (c == '/' && next == '*')
+    {
+      i += 2;
+      while (i < len && !(sql[i] == '*' && i + 1 < len && sql[i + 1] == '/')) ++i;
+      i = (i + 2 < len) ? i + 2 : len;
+      continue;
     }
-    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
-  }
 
-  rc = sqlite3_extended_result_codes(db, 1);
-  if (rc != SQLITE_OK)
-  {
-    const char* localError = sqlite3_errmsg(db);
-    sqlite3_close(db);
-    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
-  }
+    size_t start = i;
+    int token;
+    if (c == '\'' || ((c == 'x' || c == 'X') && next == '\''))
+    {
+      // String or BLOB literal
+      i += (c == '\'') ? 1 : 2;
+      while (i < len)
+      {
+        if (sql[i] == '\'')
+        {
+          if (i + 1 < len && sql[i + 1] == '\'')
+          {
+            i += 2;
+            continue;
+          }
+          ++i;
+          break;
+        }
+        ++i;
+      }
+      token = TOKEN_LITERAL;
+    }
+    else if ((c >= '0' && c <= '9') || (c == '.' && next >= '0' && next <= '9'))
+    {
+      // Numeric literal (decimal, hexadecimal or with exponent)
+      bool isHex = (c == '0' && (next == 'x' || next == 'X'));
+      ++i;
+      while (i < len)
+      {
+        unsigned char d = (unsigned char) sql[i];
+        if ((d == '+' || d == '-') && !isHex && (sql[i - 1] == 'e' || sql[i - 1] == 'E'))
+        {
+          ++i;
+        }
+        else if (wxSQLite3IsIdentifierChar(d) || d == '.')
+        {
+          ++i;
+        }
+        else
+        {
+          break;
+        }
+      }
+      token = TOKEN_LITERAL;
+    }
+    else if (c == '?' || ((c == ':' || c == '@' || c == '$') && wxSQLite3IsIdentifierChar(next)))
+    {
+      // Parameter
+      ++i;
+      while (i < len && wxSQLite3IsIdentifierChar((unsigned char) sql[i])) ++i;
+      token = TOKEN_LITERAL;
+    }
+    else if (c == '"' || c == '`' || c == '[')
+    {
+      // Quoted identifier, kept verbatim
+      char quote = (c == '[') ? ']' : (char) c;
+      ++i;
+      while (i < len)
+      {
+        if (sql[i] == quote)
+        {
+          if (quote != ']' && i + 1 < len && sql[i + 1] == quote)
+          {
+            i += 2;
+            continue;
+          }
+          ++i;
+          break;
+        }
+        ++i;
+      }
+      token = TOKEN_WORD;
+    }
+    else if (wxSQLite3IsIdentifierChar(c))
+    {
+      // Keyword or identifier
+      while (i < len && wxSQLite3IsIdentifierChar((unsigned char) sql[i])) ++i;
+      token = TOKEN_WORD;
+    }
+    else
+    {
+      ++i;
+      switch (c)
+      {
+        case ',': token = TOKEN_COMMA; break;
+        case '(': token = TOKEN_OPEN;  break;
+        case ')': token = TOKEN_CLOSE; break;
+        case '.': token = TOKEN_DOT;   break;
+        default:
+          // Operators consisting of two or three characters
+          token = TOKEN_OTHER;
+          if ((c == '<' && (next == '=' || next == '>' || next == '<')) ||
+              (c == '>' && (next == '=' || next == '>')) ||
+              ((c == '!' || c == '=') && next == '=') ||
+              (c == '|' && next == '|') ||
+              (c == '-' && next == '>'))
+          {
+            ++i;
+            if (c == '-' && i < len && sql[i] == '>') ++i;
+          }
+          break;
+      }
+    }
 
-  if (key.GetDataLen() > 0)
-  {
-    rc = sqlite3_key(db, key.GetData(), (int) key.GetDataLen());
-    if (rc != SQLITE_OK)
+    if (token == TOKEN_LITERAL && listActive && prevToken == TOKEN_COMMA && prevPrevToken == TOKEN_LITERAL)
+    {
+      // Collapse a list of literals or parameters
+      n = listStart;
+      out[n++] = '.';
+      out[n++] = '.';
+      out[n++] = '.';
+      prevPrevToken = TOKEN_OTHER;
+      prevToken = TOKEN_LITERAL;
+      continue;
+    }
+    if (prevToken != TOKEN_NONE && prevToken != TOKEN_OPEN && prevToken != TOKEN_DOT &&
+        token != TOKEN_COMMA && token != TOKEN_OPEN && token != TOKEN_CLOSE && token != TOKEN_DOT &&
+        !(c == ';' && token == TOKEN_OTHER))
+    {
+      out[n++] = ' ';
+    }
+    if (token == TOKEN_LITERAL)
+    {
+      listStart = n;
+      listActive = true;
+      out[n++] = '?';
+    }
+    else
     {
-      const char* localError = sqlite3_errmsg(db);
-      sqlite3_close(db);
-      throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+      if (token != TOKEN_COMMA)
+      {
+        listActive = false;
+      }
+      if (token == TOKEN_WORD && c != '"' && c != '`' && c != '[')
+      {
+        for (; start < i; ++start)
+        {
+          unsigned char d = (unsigned char) sql[start];
+          out[n++] = (d >= 'A' && d <= 'Z') ? (char) (d + ('a' - 'A')) : (char) d;
+        }
+      }
+      else
+      {
+        memcpy(out + n, sql + start, i - start);
+        n += i - start;
+      }
     }
-    m_isEncrypted = true;
+    prevPrevToken = prevToken;
+    prevToken = token;
   }
-
-  wxSQLite3DatabaseReference* dbPrev = m_db;
-  m_db = new wxSQLite3DatabaseReference(db);
-  m_isOpen = true;
-  SetBusyTimeout(m_busyTimeoutMs);
-  if (dbPrev != NULL && dbPrev->DecrementRefCount() == 0)
+  while (n > 0 && (out[n - 1] == ';' || out[n - 1] == ' '))
   {
-    delete dbPrev;
+    --n;
   }
+  out[n] = 0;
+  return n;
 }
 
-void wxSQLite3Database::Open(const wxString& fileName, const wxSQLite3Cipher& cipher, const wxString& key, int flags, const wxString& vfs)
+static const size_t gs_traceSlowQuerySize = 1024;
+
+/// Live statistics of a fingerprint (internal)
+struct wxSQLite3TraceProfile
 {
-  wxCharBuffer strLocalKey = key.ToUTF8();
-  const char* localKey = strLocalKey;
-  wxMemoryBuffer binaryKey;
-  if (key.Length() > 0)
-  {
-    binaryKey.AppendData((void*)localKey, strlen(localKey));
-  }
-  Open(fileName, cipher, binaryKey, flags, vfs);
-}
+  wxString              m_fingerprint;  ///< Normalized SQL text
+  sqlite3_uint64        m_hash;         ///< Hash of the normalized SQL text
+  wxSQLite3TraceCounter m_executions;   ///< Number of executions
+  wxSQLite3TraceCounter m_rows;         ///< Number of result rows
+  wxSQLite3TraceCounter m_total;        ///< Sum of execution times
+  wxSQLite3TraceCounter m_min;          ///< Shortest execution time
+  wxSQLite3TraceCounter m_max;          ///< Longest execution time
+  wxSQLite3TraceCounter m_buckets[wxSQLite3LatencyHistogram::BUCKET_COUNT]; ///< Histogram of execution times
+};
 
-void wxSQLite3Database::Open(const wxString& fileName, const wxSQLite3Cipher& cipher, const wxMemoryBuffer& key, int flags, const wxString& vfs)
+/// Entry of the slow query log (internal)
+struct wxSQLite3TraceSlowQuery
 {
-  wxCharBuffer strFileName = fileName.ToUTF8();
-  const char* localFileName = strFileName;
-  wxCharBuffer strVfs = vfs.ToUTF8();
-  const char* localVfs = (!vfs.IsEmpty()) ? (const char*) strVfs : (const char*) NULL;
-  sqlite3* db;
+  wxSQLite3TraceCounter m_sequence;  ///< Sequence number, odd while the entry is written
+  size_t                m_profile;   ///< Index of the fingerprint
+  wxUint64              m_duration;  ///< Execution time in nanoseconds
+  wxUint64              m_rows;      ///< Number of result rows
+  wxLongLong_t          m_timestamp; ///< Time of completion in milliseconds since the epoch
+  size_t                m_length;    ///< Length of the SQL text
+  char                  m_sql[gs_traceSlowQuerySize]; ///< Expanded SQL text (truncated)
+};
 
-  int rc = sqlite3_open_v2((const char*) localFileName, &db, flags, localVfs);
+/// Statement in progress (internal)
+struct wxSQLite3TraceActive
+{
+  sqlite3_stmt* m_stmt;  ///< Statement
+  wxUint64      m_start; ///< Start of execution
+  wxUint64      m_rows;  ///< Number of result rows so far
+};
 
-  if (rc != SQLITE_OK)
+/// Mapping of SQL text to fingerprint (internal)
+struct wxSQLite3TraceSqlEntry
+{
+  sqlite3_uint64 m_hash;    ///< Hash of the SQL text (0 for an empty entry)
+  size_t         m_profile; ///< Index of the fingerprint
+};
+
+/// Hash table mapping SQL text to fingerprints (internal)
+class wxSQLite3TraceSqlCache
+{
+public:
+  explicit wxSQLite3TraceSqlCache(size_t maxProfiles)
+    : m_count(0)
   {
-    const char* localError = "Out of memory";
-    if (db != NULL)
+    m_size = 64;
+    while (m_size < 4 * maxProfiles)
     {
-      localError = sqlite3_errmsg(db);
-      sqlite3_close(db);
+      m_size *= 2;
     }
-    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+    m_entries = new wxSQLite3TraceSqlEntry[m_size];
+    memset(m_entries, 0, m_size * sizeof(wxSQLite3TraceSqlEntry));
   }
 
-  rc = sqlite3_extended_result_codes(db, 1);
-  if (rc != SQLITE_OK)
+  ~wxSQLite3TraceSqlCache()
   {
-    const char* localError = sqlite3_errmsg(db);
-    sqlite3_close(db);
-    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+    delete [] m_entries;
   }
 
-  if (cipher.IsOk())
+  /// Look up the fingerprint of SQL text with the given hash
+  bool Find(sqlite3_uint64 hash, size_t& profile) const
   {
-    if (!cipher.Apply(db))
+    size_t mask = m_size - 1;
+    size_t slot = (size_t) hash & mask;
+    while (m_entries[slot].m_hash != 0)
     {
-      throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_CIPHER_APPLY_FAILED);
+      if (m_entries[slot].m_hash == hash)
+      {
+        profile = m_entries[slot].m_profile;
+        return true;
+      }
+      slot = (slot + 1) & mask;
     }
+    return false;
   }
 
-  if (key.GetDataLen() > 0)
+  /// Remember the fingerprint of SQL text; start over if the table gets crowded
+  void Insert(sqlite3_uint64 hash, size_t profile)
   {
-    rc = sqlite3_key(db, key.GetData(), (int)key.GetDataLen());
-    if (rc != SQLITE_OK)
+    if (4 * (m_count + 1) > 3 * m_size)
     {
-      const char* localError = sqlite3_errmsg(db);
-      sqlite3_close(db);
-      throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+      memset(m_entries, 0, m_size * sizeof(wxSQLite3TraceSqlEntry));
+      m_count = 0;
     }
-    m_isEncrypted = true;
-  }
-
-  wxSQLite3DatabaseReference* dbPrev = m_db;
-  m_db = new wxSQLite3DatabaseReference(db);
-  m_isOpen = true;
-  SetBusyTimeout(m_busyTimeoutMs);
-  if (dbPrev != NULL && dbPrev->DecrementRefCount() == 0)
-  {
-    delete dbPrev;
+    size_t mask = m_size - 1;
+    size_t slot = (size_t) hash & mask;
+    while (m_entries[slot].m_hash != 0)
+    {
+      slot = (slot + 1) & mask;
+    }
+    m_entries[slot].m_hash = hash;
+    m_entries[slot].m_profile = profile;
+    ++m_count;
   }
-}
-
-bool wxSQLite3Database::IsOpen() const
-{
-  return (m_db != NULL && m_db->m_isValid && m_isOpen);
-}
 
-bool wxSQLite3Database::IsReadOnly(const wxString& databaseName) const
-{
-#if SQLITE_VERSION_NUMBER >= 3007011
-  CheckDatabase();
-  wxCharBuffer strDatabaseName = databaseName.ToUTF8();
-  const char* localDatabaseName = strDatabaseName;
-  return sqlite3_db_readonly(m_db->m_db, localDatabaseName) > 0;
-#else
-  return false;
-#endif
-}
+private:
+  wxSQLite3TraceSqlEntry* m_entries; ///< Hash table (open addressing)
+  size_t                  m_size;    ///< Size of the hash table (power of 2)
+  size_t                  m_count;   ///< Number of entries in the hash table
+};
 
-void wxSQLite3Database::Close()
+/// Find or create the fingerprint of a statement (internal)
+/**
+* Shared by the statement tracer and the sampling profiler. P must provide the
+* members m_fingerprint and m_hash. The profile array holds maxProfiles fingerprints
+* plus the fingerprint "(other)", which accounts for all statements exceeding
+* the maximum. New fingerprints, including "(other)" as the last one, are published
+* to readers by a release store of profileCount.
+*/
+template <class P>
+static size_t wxSQLite3FindFingerprint(sqlite3_stmt* stmt, wxSQLite3TraceSqlCache& sqlCache,
+                                       P** profiles, wxSQLite3TraceCounter& profileCount, size_t maxProfiles,
+                                       void (*InitProfile)(P*))
 {
-  CheckDatabase();
-  Close(m_db);
-}
+  const char* sql = sqlite3_sql(stmt);
+  if (sql == NULL)
+  {
+    sql = "";
+  }
+  size_t len = strlen(sql);
+  sqlite3_uint64 hash = wxSQLite3XXH64(sql, len, 0);
+  if (hash == 0)
+  {
+    hash = 1;
+  }
+  size_t profile;
+  if (sqlCache.Find(hash, profile))
+  {
+    return profile;
+  }
 
-void wxSQLite3Database::Close(wxSQLite3DatabaseReference* db)
-{
-  if (db != NULL && db->m_isValid)
+  // Unknown SQL text: normalize it and look up the fingerprint
+  profile = maxProfiles;
+  char* normalized = (char*) sqlite3_malloc64(2 * len + 1);
+  if (normalized != NULL)
   {
-#if SQLITE_VERSION_NUMBER >= 3006000
-// Unfortunately the following code leads to a crash if the RTree module is used
-// therefore it is disabled for now
-#if 0
-    // Finalize all unfinalized prepared statements
-    sqlite3_stmt *pStmt;
-    while( (pStmt = sqlite3_next_stmt(db->m_db, 0))!=0 )
+    size_t normalizedLength = wxSQLite3NormalizeSQL(sql, len, normalized);
+    sqlite3_uint64 normalizedHash = wxSQLite3XXH64(normalized, normalizedLength, 0);
+    size_t count = (size_t) profileCount.Get();
+    if (count > maxProfiles)
     {
-      sqlite3_finalize(pStmt);
+      // Skip the fingerprint "(other)"
+      count = maxProfiles;
     }
-#endif
-#endif
-    if (db->m_refCount <= 1)
+    size_t j;
+    for (j = 0; j < count; ++j)
     {
-      sqlite3_close(db->m_db);
-      db->Invalidate();
-      m_isEncrypted = false;
+      if (profiles[j]->m_hash == normalizedHash)
+      {
+        profile = j;
+        break;
+      }
     }
-    m_isOpen = false;
+    if (j == count && count < maxProfiles)
+    {
+      P* newProfile = new P();
+      newProfile->m_fingerprint = wxString::FromUTF8(normalized, normalizedLength);
+      newProfile->m_hash = normalizedHash;
+      if (InitProfile != NULL)
+      {
+        InitProfile(newProfile);
+      }
+      profiles[count] = newProfile;
+      // Publish the fingerprint to readers
+      profileCount.SetRelease(count + 1);
+      profile = count;
+    }
+    sqlite3_free(normalized);
   }
-}
-
-void wxSQLite3Database::AttachDatabase(const wxString& fileName, const wxString& schemaName)
-{
-  CheckDatabase();
-  wxSQLite3Statement attachStmt = PrepareStatement("ATTACH DATABASE ? AS ?");
-  attachStmt.Bind(1, fileName);
-  attachStmt.Bind(2, schemaName);
-  int rc = attachStmt.ExecuteUpdate();
-}
-
-void wxSQLite3Database::AttachDatabase(const wxString& fileName, const wxString& schemaName, const wxString& key)
-{
-  CheckDatabase();
-  wxSQLite3Statement attachStmt = PrepareStatement("ATTACH DATABASE ? AS ? KEY ?");
-  attachStmt.Bind(1, fileName);
-  attachStmt.Bind(2, schemaName);
-  attachStmt.Bind(3, key);
-  int rc = attachStmt.ExecuteUpdate();
-}
-
-void wxSQLite3Database::AttachDatabase(const wxString& fileName, const wxString& schemaName, const wxSQLite3Cipher& cipher, const wxString& key)
-{
-  CheckDatabase();
-  if (cipher.IsOk())
+  if (profile == maxProfiles && profileCount.Get() == maxProfiles)
   {
-    if (!cipher.Apply(m_db->m_db))
+    P* otherProfile = new P();
+    otherProfile->m_fingerprint = wxS("(other)");
+    otherProfile->m_hash = 0;
+    if (InitProfile != NULL)
     {
-      throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_CIPHER_APPLY_FAILED);
+      InitProfile(otherProfile);
     }
+    profiles[profile] = otherProfile;
+    // Publish the fingerprint to readers
+    profileCount.SetRelease(maxProfiles + 1);
   }
-
-  wxSQLite3Statement attachStmt = PrepareStatement("ATTACH DATABASE ? AS ? KEY ?");
-  attachStmt.Bind(1, fileName);
-  attachStmt.Bind(2, schemaName);
-  attachStmt.Bind(3, key);
-  int rc = attachStmt.ExecuteUpdate();
+  sqlCache.Insert(hash, profile);
+  return profile;
 }
 
-void wxSQLite3Database::DetachDatabase(const wxString& schemaName)
+/// Internal state of a statement tracer (internal)
+class wxSQLite3TracerState
 {
-  wxSQLite3Statement detachStmt = PrepareStatement("DETACH DATABASE ?");
-  detachStmt.Bind(1, schemaName);
-  int rc = detachStmt.ExecuteUpdate();
-}
+public:
+  wxSQLite3TracerState(wxUint64 slowQueryThreshold, size_t slowQueryCapacity, size_t maxFingerprints, bool countRows);
+  ~wxSQLite3TracerState();
 
-static bool
-BackupRestoreCallback(int total, int remaining, wxSQLite3BackupProgress* progressCallback)
-{
-  return progressCallback->Progress(total, remaining);
-}
+  /// Handle the start of a statement execution
+  void BeginStatement(sqlite3_stmt* stmt);
 
-void wxSQLite3Database::Backup(const wxString& targetFileName, const wxString& key, 
-                               const wxString& sourceDatabaseName)
-{
-  Backup(NULL, targetFileName, wxSQLite3Cipher(), key, sourceDatabaseName);
-}
+  /// Count a result row
+  void CountRow(sqlite3_stmt* stmt);
 
-void wxSQLite3Database::Backup(const wxString& targetFileName, const wxSQLite3Cipher& cipher, 
-                               const wxString& key, const wxString& sourceDatabaseName)
-{
-  Backup(NULL, targetFileName, cipher, key, sourceDatabaseName);
-}
+  /// Handle the completion of a statement execution, returning true for a slow query
+  bool EndStatement(sqlite3_stmt* stmt, wxUint64 estimate);
 
-void wxSQLite3Database::Backup(wxSQLite3BackupProgress* progressCallback,
-                               const wxString& targetFileName, const wxString& key,
-                               const wxString& sourceDatabaseName)
-{
-  Backup(progressCallback, targetFileName, wxSQLite3Cipher(), key, sourceDatabaseName);
-}
+  /// Forget all statements in progress
+  void ClearActive() { m_activeCount = 0; }
 
-void wxSQLite3Database::Backup(wxSQLite3BackupProgress* progressCallback, 
-                               const wxString& targetFileName, const wxSQLite3Cipher& cipher, 
-                               const wxString& key, const wxString& sourceDatabaseName)
-{
-  wxCharBuffer strLocalKey = key.ToUTF8();
-  const char* localKey = strLocalKey;
-  wxMemoryBuffer binaryKey;
-  if (key.Length() > 0)
-  {
-    binaryKey.AppendData((void*) localKey, strlen(localKey));
-  }
-  Backup(progressCallback, targetFileName, cipher, binaryKey, sourceDatabaseName);
-}
+  /// Find or create the fingerprint of a statement
+  size_t FindProfile(sqlite3_stmt* stmt);
 
-void wxSQLite3Database::Backup(const wxString& targetFileName, const wxMemoryBuffer& key, 
-                               const wxString& sourceDatabaseName)
+  /// Perform a requested reset
+  void PerformReset();
+
+  wxSQLite3TraceCounter    m_slowQueryThreshold; ///< Slow query threshold in nanoseconds
+  wxSQLite3TraceCounter    m_resetRequested;     ///< Flag whether a reset was requested
+  bool                     m_countRows;          ///< Flag whether rows are counted
+  wxSQLite3TraceProfile**  m_profiles;           ///< Fingerprints
+  wxSQLite3TraceCounter    m_profileCount;       ///< Number of published fingerprints, including "(other)"
+  size_t                   m_maxProfiles;        ///< Maximum number of fingerprints
+  wxSQLite3TraceSlowQuery* m_slowQueries;        ///< Ring buffer of slow queries
+  size_t                   m_slowQueryCapacity;  ///< Capacity of the ring buffer
+  wxSQLite3TraceCounter    m_slowQueryHead;      ///< Number of slow queries written
+  wxSQLite3TraceCounter    m_slowQueryBase;      ///< Number of slow queries written before the last reset
+
+private:
+  wxSQLite3TraceActive*    m_active;      ///< Statements in progress
+  size_t                   m_activeCount; ///< Number of statements in progress
+  size_t                   m_activeAlloc; ///< Capacity of the array of statements in progress
+  wxSQLite3TraceSqlCache*  m_sqlCache;    ///< Hash table mapping SQL text to fingerprints
+};
+
+wxSQLite3TracerState::wxSQLite3TracerState(wxUint64 slowQueryThreshold, size_t slowQueryCapacity, size_t maxFingerprints, bool countRows)
+  : m_countRows(countRows), m_active(NULL), m_activeCount(0), m_activeAlloc(0)
 {
-  Backup(NULL, targetFileName, wxSQLite3Cipher(), key, sourceDatabaseName);
+  m_slowQueryThreshold.Set(slowQueryThreshold * 1000);
+  // One additional fingerprint accounts for all statements exceeding the maximum
+  m_maxProfiles = (maxFingerprints > 0) ? maxFingerprints : 1;
+  m_profiles = new wxSQLite3TraceProfile*[m_maxProfiles + 1];
+  memset(m_profiles, 0, (m_maxProfiles + 1) * sizeof(wxSQLite3TraceProfile*));
+  m_slowQueryCapacity = slowQueryCapacity;
+  m_slowQueries = (m_slowQueryCapacity > 0) ? new wxSQLite3TraceSlowQuery[m_slowQueryCapacity] : NULL;
+  m_sqlCache = new wxSQLite3TraceSqlCache(m_maxProfiles);
 }
 
-void wxSQLite3Database::Backup(const wxString& targetFileName, const wxSQLite3Cipher& cipher, 
-                               const wxMemoryBuffer& key, const wxString& sourceDatabaseName)
+wxSQLite3TracerState::~wxSQLite3TracerState()
 {
-  Backup(NULL, targetFileName, cipher, key, sourceDatabaseName);
+  size_t j;
+  for (j = 0; j <= m_maxProfiles; ++j)
+  {
+    delete m_profiles[j];
+  }
+  delete [] m_profiles;
+  delete [] m_slowQueries;
+  delete m_sqlCache;
+  sqlite3_free(m_active);
 }
 
-void wxSQLite3Database::Backup(wxSQLite3BackupProgress* progressCallback, const wxString& targetFileName,
-                               const wxMemoryBuffer& key, const wxString& sourceDatabaseName)
+void wxSQLite3TracerState::BeginStatement(sqlite3_stmt* stmt)
 {
-  Backup(progressCallback, targetFileName, wxSQLite3Cipher(), key, sourceDatabaseName);
+  // The event is repeated for each trigger program; only the first one starts the clock
+  size_t j;
+  for (j = 0; j < m_activeCount; ++j)
+  {
+    if (m_active[j].m_stmt == stmt)
+    {
+      return;
+    }
+  }
+  if (m_activeCount == m_activeAlloc)
+  {
+    size_t newAlloc = (m_activeAlloc > 0) ? 2 * m_activeAlloc : 8;
+    wxSQLite3TraceActive* newActive = (wxSQLite3TraceActive*) sqlite3_realloc64(m_active, newAlloc * sizeof(wxSQLite3TraceActive));
+    if (newActive == NULL)
+    {
+      // The execution time estimated by SQLite will be used
+      return;
+    }
+    m_active = newActive;
+    m_activeAlloc = newAlloc;
+  }
+  m_active[m_activeCount].m_stmt = stmt;
+  m_active[m_activeCount].m_rows = 0;
+  m_active[m_activeCount].m_start = wxSQLite3TraceClock();
+  ++m_activeCount;
 }
 
-void wxSQLite3Database::Backup(wxSQLite3BackupProgress* progressCallback,
-                               const wxString& targetFileName, const wxSQLite3Cipher& cipher, 
-                               const wxMemoryBuffer& key, const wxString& sourceDatabaseName)
+void wxSQLite3TracerState::CountRow(sqlite3_stmt* stmt)
 {
-  CheckDatabase();
-
-  wxCharBuffer strFileName = targetFileName.ToUTF8();
-  const char* localTargetFileName = strFileName;
-  wxCharBuffer strDatabaseName = sourceDatabaseName.ToUTF8();
-  const char* localSourceDatabaseName = strDatabaseName;
-
-  sqlite3* pDest;
-  sqlite3_backup* pBackup;
-  int rc;
-  rc = sqlite3_open(localTargetFileName, &pDest);
-  if (rc != SQLITE_OK)
+  size_t j;
+  for (j = m_activeCount; j > 0; --j)
   {
-    sqlite3_close(pDest);
-    throw wxSQLite3Exception(rc, wxERRMSG_DBOPEN_FAILED);
+    if (m_active[j - 1].m_stmt == stmt)
+    {
+      ++m_active[j - 1].m_rows;
+      break;
+    }
   }
+}
+
+static void wxSQLite3InitTraceProfile(wxSQLite3TraceProfile* profile)
+{
+  profile->m_min.Set(~((wxUint64) 0));
+}
 
-  if (key.GetDataLen() > 0)
+size_t wxSQLite3TracerState::FindProfile(sqlite3_stmt* stmt)
+{
+  return wxSQLite3FindFingerprint(stmt, *m_sqlCache, m_profiles, m_profileCount, m_maxProfiles, wxSQLite3InitTraceProfile);
+}
+
+void wxSQLite3TracerState::PerformReset()
+{
+  size_t j;
+  for (j = 0; j <= m_maxProfiles; ++j)
   {
-    if (cipher.IsOk())
+    wxSQLite3TraceProfile* profile = m_profiles[j];
+    if (profile != NULL)
     {
-      if (!cipher.Apply(pDest))
+      profile->m_executions.Set(0);
+      profile->m_rows.Set(0);
+      profile->m_total.Set(0);
+      profile->m_min.Set(~((wxUint64) 0));
+      profile->m_max.Set(0);
+      int k;
+      for (k = 0; k < wxSQLite3LatencyHistogram::BUCKET_COUNT; ++k)
       {
-        throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_CIPHER_APPLY_FAILED);
+        profile->m_buckets[k].Set(0);
       }
     }
-    rc = sqlite3_key(pDest, key.GetData(), (int) key.GetDataLen());
-    if (rc != SQLITE_OK)
-    {
-      const char* localError = sqlite3_errmsg(pDest);
-      sqlite3_close(pDest);
-      throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
-    }
   }
+  m_slowQueryBase.SetRelease(m_slowQueryHead.Get());
+  m_resetRequested.Set(0);
+}
 
-  pBackup = sqlite3_backup_init(pDest, "main", m_db->m_db, localSourceDatabaseName);
-  if (pBackup == 0)
+bool wxSQLite3TracerState::EndStatement(sqlite3_stmt* stmt, wxUint64 estimate)
+{
+  if (m_resetRequested.Get() != 0)
   {
-    const char* localError = sqlite3_errmsg(pDest);
-    sqlite3_close(pDest);
-    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+    PerformReset();
   }
 
-  do
+  // Prefer the own measurement, SQLite's estimate has only millisecond resolution
+  wxUint64 duration = estimate;
+  wxUint64 rows = 0;
+  size_t j;
+  for (j = m_activeCount; j > 0; --j)
   {
-    rc = sqlite3_backup_step(pBackup, m_backupPageCount);
-    if (progressCallback != NULL)
-    {
-      if (!BackupRestoreCallback(sqlite3_backup_pagecount(pBackup),
-                                 sqlite3_backup_remaining(pBackup),
-                                 progressCallback))
-      {
-        rc = SQLITE_DONE;
-      }
-    }
-    if (rc == SQLITE_BUSY || rc == SQLITE_LOCKED)
+    if (m_active[j - 1].m_stmt == stmt)
     {
-      sqlite3_sleep(250);
+      duration = wxSQLite3TraceClock() - m_active[j - 1].m_start;
+      rows = m_active[j - 1].m_rows;
+      m_active[j - 1] = m_active[--m_activeCount];
+      break;
     }
   }
-  while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
 
-  sqlite3_backup_finish(pBackup);
-  if (rc == SQLITE_DONE)
+  size_t profileIndex = FindProfile(stmt);
+  wxSQLite3TraceProfile* profile = m_profiles[profileIndex];
+  profile->m_executions.Add(1);
+  profile->m_rows.Add(rows);
+  profile->m_total.Add(duration);
+  if (duration < profile->m_min.Get()) profile->m_min.Set(duration);
+  if (duration > profile->m_max.Get()) profile->m_max.Set(duration);
+  profile->m_buckets[wxSQLite3LatencyHistogram::GetBucketIndex(duration)].Add(1);
+
+  if (m_slowQueryCapacity == 0 || duration < m_slowQueryThreshold.Get())
   {
-    sqlite3_close(pDest);
+    return false;
   }
-  else
+
+  // Write the entry of the ring buffer guarded by its sequence number
+  wxUint64 ticket = m_slowQueryHead.Get();
+  wxSQLite3TraceSlowQuery& entry = m_slowQueries[ticket % m_slowQueryCapacity];
+  entry.m_sequence.Set(2 * ticket + 1);
+  wxSQLite3TraceFenceRelease();
+  entry.m_profile = profileIndex;
+  entry.m_duration = duration;
+  entry.m_rows = rows;
+  entry.m_timestamp = wxGetUTCTimeMillis().GetValue();
+  char* sql = sqlite3_expanded_sql(stmt);
+  const char* text = (sql != NULL) ? sql : sqlite3_sql(stmt);
+  size_t length = (text != NULL) ? strlen(text) : 0;
+  if (length >= gs_traceSlowQuerySize)
+  {
+    // Truncate without splitting a UTF-8 sequence
+    length = gs_traceSlowQuerySize - 1;
+    while (length > 0 && (((unsigned char) text[length]) & 0xC0) == 0x80)
+    {
+      --length;
+    }
+  }
+  if (length > 0)
   {
-    const char* localError = sqlite3_errmsg(pDest);
-    sqlite3_close(pDest);
-    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+    memcpy(entry.m_sql, text, length);
   }
+  entry.m_length = length;
+  sqlite3_free(sql);
+  entry.m_sequence.SetRelease(2 * ticket + 2);
+  m_slowQueryHead.SetRelease(ticket + 1);
+  return true;
 }
 
-void wxSQLite3Database::Restore(const wxString& sourceFileName, const wxString& key, 
-                                const wxString& targetDatabaseName)
-{
-  Restore(NULL, sourceFileName, wxSQLite3Cipher(), key, targetDatabaseName);
-}
-
-void wxSQLite3Database::Restore(const wxString& sourceFileName, const wxSQLite3Cipher& cipher,
-                                const wxString& key, const wxString& targetDatabaseName)
+wxSQLite3StatementTracer::wxSQLite3StatementTracer(wxUint64 slowQueryThreshold, size_t slowQueryCapacity,
+                                                   size_t maxFingerprints, bool countRows)
 {
-  Restore(NULL, sourceFileName, cipher, key, targetDatabaseName);
+  m_state = new wxSQLite3TracerState(slowQueryThreshold, slowQueryCapacity, maxFingerprints, countRows);
 }
 
-void wxSQLite3Database::Restore(wxSQLite3BackupProgress* progressCallback,
-                                const wxString& sourceFileName, const wxString& key,
-                                const wxString& targetDatabaseName)
+wxSQLite3StatementTracer::~wxSQLite3StatementTracer()
 {
-  Restore(progressCallback, sourceFileName, wxSQLite3Cipher(), key, targetDatabaseName);
+  delete m_state;
 }
 
-void wxSQLite3Database::Restore(wxSQLite3BackupProgress* progressCallback,
-                                const wxString& sourceFileName, const wxSQLite3Cipher& cipher,
-                                const wxString& key, const wxString& targetDatabaseName)
+void wxSQLite3StatementTracer::SetSlowQueryThreshold(wxUint64 slowQueryThreshold)
 {
-  wxCharBuffer strLocalKey = key.ToUTF8();
-  const char* localKey = strLocalKey;
-  wxMemoryBuffer binaryKey;
-  if (key.Length() > 0)
-  {
-    binaryKey.AppendData((void*) localKey, strlen(localKey));
-  }
-  Restore(progressCallback, sourceFileName, cipher, binaryKey, targetDatabaseName);
+  m_state->m_slowQueryThreshold.Set(slowQueryThreshold * 1000);
 }
 
-void wxSQLite3Database::Restore(const wxString& sourceFileName, const wxMemoryBuffer& key, 
-                                const wxString& targetDatabaseName)
+wxUint64 wxSQLite3StatementTracer::GetSlowQueryThreshold() const
 {
-  Restore(NULL, sourceFileName, wxSQLite3Cipher(), key, targetDatabaseName);
+  return m_state->m_slowQueryThreshold.Get() / 1000;
 }
 
-void wxSQLite3Database::Restore(wxSQLite3BackupProgress* progressCallback, const wxString& sourceFileName,
-                                const wxMemoryBuffer& key, const wxString& targetDatabaseName)
+bool wxSQLite3StatementTracer::IsCountingRows() const
 {
-  Restore(progressCallback, sourceFileName, wxSQLite3Cipher(), key, targetDatabaseName);
+  return m_state->m_countRows;
 }
 
-void wxSQLite3Database::Restore(const wxString& sourceFileName, const wxSQLite3Cipher& cipher,
-                                const wxMemoryBuffer& key, const wxString& targetDatabaseName)
+size_t wxSQLite3StatementTracer::GetProfileCount() const
 {
-    Restore(NULL, sourceFileName, cipher, key, targetDatabaseName);
+  // The fingerprint "(other)" is reported last, once it is in use
+  return (size_t) m_state->m_profileCount.GetAcquire();
 }
 
-void wxSQLite3Database::Restore(wxSQLite3BackupProgress* progressCallback,
-                                const wxString& sourceFileName, const wxSQLite3Cipher& cipher,
-                                const wxMemoryBuffer& key, const wxString& targetDatabaseName)
+bool wxSQLite3StatementTracer::GetProfile(size_t index, wxSQLite3StatementProfile& profile) const
 {
-  CheckDatabase();
-
-  wxCharBuffer strFileName = sourceFileName.ToUTF8();
-  const char* localSourceFileName = strFileName;
-  wxCharBuffer strDatabaseName = targetDatabaseName.ToUTF8();
-  const char* localTargetDatabaseName = strDatabaseName;
-
-  sqlite3* pSrc;
-  sqlite3_backup* pBackup;
-  int rc;
-  int nTimeout = 0;
-
-  rc = sqlite3_open(localSourceFileName, &pSrc);
-  if (rc != SQLITE_OK)
+  if (index >= GetProfileCount())
   {
-    sqlite3_close(pSrc);
-    throw wxSQLite3Exception(rc, wxERRMSG_DBOPEN_FAILED);
+    return false;
   }
+  const wxSQLite3TraceProfile* source = m_state->m_profiles[index];
+  profile.m_fingerprint = source->m_fingerprint;
+  profile.m_executions = source->m_executions.Get();
+  profile.m_rows = source->m_rows.Get();
+  wxSQLite3LatencyHistogram& latency = profile.m_latency;
+  wxUint64 count = 0;
+  int j;
+  for (j = 0; j < wxSQLite3LatencyHistogram::BUCKET_COUNT; ++j)
+  {
+    latency.m_buckets[j] = source->m_buckets[j].Get();
+    count += latency.m_buckets[j];
+  }
+  latency.m_count = count;
+  latency.m_total = source->m_total.Get();
+  latency.m_min = source->m_min.Get();
+  latency.m_max = source->m_max.Get();
+  return true;
+}
 
-  if (key.GetDataLen() > 0)
-  {
-    if (cipher.IsOk())
-    {
-      if (!cipher.Apply(pSrc))
-      {
-        throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_CIPHER_APPLY_FAILED);
-      }
-    }
-    rc = sqlite3_key(pSrc, key.GetData(), (int) key.GetDataLen());
-    if (rc != SQLITE_OK)
-    {
-      const char* localError = sqlite3_errmsg(pSrc);
-      sqlite3_close(pSrc);
-      throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
-    }
-  }
+size_t wxSQLite3StatementTracer::GetSlowQueryCount() const
+{
+  wxUint64 head = m_state->m_slowQueryHead.GetAcquire();
+  wxUint64 count = head - m_state->m_slowQueryBase.GetAcquire();
+  return (size_t) ((count < m_state->m_slowQueryCapacity) ? count : m_state->m_slowQueryCapacity);
+}
 
-  pBackup = sqlite3_backup_init(m_db->m_db, localTargetDatabaseName, pSrc, "main");
-  if (pBackup == 0)
+bool wxSQLite3StatementTracer::GetSlowQuery(size_t index, wxSQLite3SlowQuery& query) const
+{
+  wxUint64 head = m_state->m_slowQueryHead.GetAcquire();
+  wxUint64 count = head - m_state->m_slowQueryBase.GetAcquire();
+  if (count > m_state->m_slowQueryCapacity)
   {
-    const char* localError = sqlite3_errmsg(m_db->m_db);
-    sqlite3_close(pSrc);
-    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+    count = m_state->m_slowQueryCapacity;
   }
-
-  do
+  if (index >= count)
   {
-    rc = sqlite3_backup_step(pBackup, m_backupPageCount);
-    if (progressCallback != NULL)
-    {
-      if (!BackupRestoreCallback(sqlite3_backup_pagecount(pBackup),
-                                 sqlite3_backup_remaining(pBackup), progressCallback))
-      {
-        rc = SQLITE_DONE;
-      }
-    }
-    if (rc == SQLITE_BUSY || rc == SQLITE_LOCKED)
-    {
-      if (nTimeout++ >= 20) break;
-      sqlite3_sleep(250);
-    }
-    else
-    {
-      nTimeout = 0;
-    }
+    return false;
   }
-  while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
-
-  sqlite3_backup_finish(pBackup);
-  if (rc == SQLITE_DONE)
+  wxUint64 ticket = head - 1 - index;
+  const wxSQLite3TraceSlowQuery& entry = m_state->m_slowQueries[ticket % m_state->m_slowQueryCapacity];
+  wxUint64 sequence = entry.m_sequence.GetAcquire();
+  if (sequence != 2 * ticket + 2)
   {
-    sqlite3_close(pSrc);
+    return false;
   }
-  else if (rc == SQLITE_BUSY || rc == SQLITE_LOCKED)
+  char sql[gs_traceSlowQuerySize];
+  size_t profileIndex = entry.m_profile;
+  wxUint64 duration = entry.m_duration;
+  wxUint64 rows = entry.m_rows;
+  wxLongLong_t timestamp = entry.m_timestamp;
+  size_t length = entry.m_length;
+  if (length >= gs_traceSlowQuerySize)
   {
-    sqlite3_close(pSrc);
-    throw wxSQLite3Exception(rc, wxERRMSG_SOURCEDB_BUSY);
+    length = 0;
   }
-  else
+  memcpy(sql, entry.m_sql, length);
+  wxSQLite3TraceFenceAcquire();
+  if (entry.m_sequence.Get() != sequence)
   {
-    const char* localError = sqlite3_errmsg(pSrc);
-    sqlite3_close(pSrc);
-    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+    // The entry was overwritten while being read
+    return false;
   }
+  query.m_sql = wxString::FromUTF8(sql, length);
+  query.m_fingerprint = (profileIndex < GetProfileCount()) ? m_state->m_profiles[profileIndex]->m_fingerprint : wxString();
+  query.m_duration = duration;
+  query.m_rows = rows;
+  query.m_timestamp = wxDateTime(wxLongLong(timestamp));
+  return true;
 }
 
-void wxSQLite3Database::SetBackupRestorePageCount(int pageCount)
+void wxSQLite3StatementTracer::Reset()
 {
-  m_backupPageCount = pageCount;
+  m_state->m_resetRequested.Set(1);
 }
 
-void wxSQLite3Database::Vacuum()
+/* static */
+wxString wxSQLite3StatementTracer::GetFingerprint(const wxString& sql)
 {
-  ExecuteUpdate("vacuum");
+  wxSQLite3Utf8Buffer strSql = sql.ToUTF8();
+  const char* localSql = strSql;
+  size_t len = strlen(localSql);
+  wxCharBuffer normalized(2 * len);
+  size_t normalizedLength = wxSQLite3NormalizeSQL(localSql, len, normalized.data());
+  return wxString::FromUTF8(normalized.data(), normalizedLength);
 }
 
-void wxSQLite3Database::Begin(wxSQLite3TransactionType transactionType)
+/* static */
+int wxSQLite3StatementTracer::ExecTraceCallback(unsigned int type, void* tracerPtr, void* p, void* x)
 {
-  wxString sql;
-  switch (transactionType)
+  wxSQLite3StatementTracer* tracer = (wxSQLite3StatementTracer*) tracerPtr;
+  wxSQLite3TracerState* state = tracer->m_state;
+  switch (type)
   {
-    case WXSQLITE_TRANSACTION_DEFERRED:
-      sql << wxS("begin deferred transaction");
+    case SQLITE_TRACE_STMT:
+      state->BeginStatement((sqlite3_stmt*) p);
       break;
-    case WXSQLITE_TRANSACTION_IMMEDIATE:
-      sql << wxS("begin immediate transaction");
+    case SQLITE_TRACE_ROW:
+      state->CountRow((sqlite3_stmt*) p);
       break;
-    case WXSQLITE_TRANSACTION_EXCLUSIVE:
-      sql << wxS("begin exclusive transaction");
+    case SQLITE_TRACE_PROFILE:
+      if (state->EndStatement((sqlite3_stmt*) p, (wxUint64) *((sqlite3_int64*) x)))
+      {
+        wxSQLite3SlowQuery query;
+        if (tracer->GetSlowQuery(0, query))
+        {
+          try
+          {
+            tracer->OnSlowQuery(query);
+          }
+          catch (...)
+          {
+            // Exceptions must not propagate into SQLite
+          }
+        }
+      }
+      break;
+    case SQLITE_TRACE_CLOSE:
+      state->ClearActive();
       break;
     default:
-      sql << wxS("begin transaction");
       break;
   }
-  ExecuteUpdate(sql);
-}
-
-void wxSQLite3Database::Commit()
-{
-  ExecuteUpdate("commit transaction");
+  return 0;
 }
 
-void wxSQLite3Database::Rollback(const wxString& savepointName)
+void wxSQLite3Database::SetStatementTracer(wxSQLite3StatementTracer* tracer)
 {
-#if SQLITE_VERSION_NUMBER >= 3006008
-  if (savepointName.IsEmpty())
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  if (tracer != NULL)
   {
-#endif
-    ExecuteUpdate("rollback transaction");
-#if SQLITE_VERSION_NUMBER >= 3006008
+    unsigned int mask = SQLITE_TRACE_STMT | SQLITE_TRACE_PROFILE | SQLITE_TRACE_CLOSE;
+    if (tracer->IsCountingRows())
+    {
+      mask |= SQLITE_TRACE_ROW;
+    }
+    sqlite3_trace_v2(m_db->m_db, mask, wxSQLite3StatementTracer::ExecTraceCallback, tracer);
   }
   else
   {
-    wxString localSavepointName = savepointName;
-    localSavepointName.Replace(wxString(wxS("\"")), wxString(wxS("\"\"")));
-    ExecuteUpdate(wxString(wxS("rollback transaction to savepoint \""))+localSavepointName+wxString(wxS("\"")));
+    sqlite3_trace_v2(m_db->m_db, 0, NULL, NULL);
   }
-#endif
 }
 
-bool wxSQLite3Database::GetAutoCommit() const
+// --- Event recording
+
+/// Event of the activity timeline (internal)
+struct wxSQLite3RecordedEvent
 {
-  CheckDatabase();
-  return sqlite3_get_autocommit(m_db->m_db) != 0;
-}
+  enum { DETAIL_SIZE = 96 };
 
-int wxSQLite3Database::QueryRollbackState() const
+  const char* m_category;   ///< Category of the event
+  const char* m_name;       ///< Name of the event
+  const char* m_detailName; ///< Name of the detail argument
+  const char* m_argName;    ///< Name of the numeric argument
+  wxUint64    m_start;      ///< Start time in nanoseconds
+  wxUint64    m_duration;   ///< Duration in nanoseconds
+  wxInt64     m_argValue;   ///< Value of the numeric argument
+  bool        m_instant;    ///< Flag whether the event has no duration
+  char        m_detail[DETAIL_SIZE]; ///< Detail text (truncated UTF-8)
+};
+
+/// Event buffer written by a single thread (internal)
+class wxSQLite3RecorderBuffer
 {
-  return m_lastRollbackRC;
-}
+public:
+  wxSQLite3RecorderBuffer(wxUint64 threadId, bool isMain, size_t capacity)
+    : m_threadId(threadId), m_isMain(isMain), m_capacity(capacity), m_next(NULL)
+  {
+    m_events = new wxSQLite3RecordedEvent[capacity];
+  }
 
-wxSQLite3TransactionState wxSQLite3Database::QueryTransactionState(const wxString& schemaName) const
+  ~wxSQLite3RecorderBuffer()
+  {
+    delete [] m_events;
+  }
+
+  wxUint64                 m_threadId; ///< Id of the writing thread
+  bool                     m_isMain;   ///< Flag whether the writing thread is the main thread
+  size_t                   m_capacity; ///< Number of event slots
+  wxSQLite3RecordedEvent*  m_events;   ///< Ring of event slots
+  wxSQLite3TraceCounter    m_written;  ///< Number of events written since the last reset
+  wxSQLite3RecorderBuffer* m_next;     ///< Buffer of the next thread
+};
+
+#if WXSQLITE3_HAVE_CXX11
+// Source of the ids of the buffer lists of all event recorders
+static std::atomic<wxUint64> gs_recorderListId(0);
+
+// Buffer list id and buffer of the event recorder the current thread recorded to last
+static thread_local wxUint64 gs_recorderCachedListId = 0;
+static thread_local wxSQLite3RecorderBuffer* gs_recorderCachedBuffer = NULL;
+#endif
+
+/// Internal state of an event recorder (internal)
+class wxSQLite3RecorderState
 {
-  wxSQLite3TransactionState state = WXSQLITE_TRANSACTION_NONE;
-  int txnState;
-  CheckDatabase();
-  if (schemaName.IsEmpty())
+public:
+  wxSQLite3RecorderState(size_t capacity)
+    : m_capacity((capacity > 0) ? capacity : 1), m_buffers(NULL)
   {
-    txnState = sqlite3_txn_state(m_db->m_db, NULL);
+    m_origin = wxSQLite3TraceClock();
+#if WXSQLITE3_HAVE_CXX11
+    m_listId = ++gs_recorderListId;
+#endif
   }
-  else
+
+  ~wxSQLite3RecorderState()
   {
-    wxCharBuffer strSchema = schemaName.ToUTF8();
-    const char* localSchema = strSchema;
-    txnState = sqlite3_txn_state(m_db->m_db, localSchema);
+    FreeBuffers();
   }
-  if (txnState < 0)
+
+  /// Release the buffers of all threads
+  /**
+  * Must not be called while events are being recorded.
+  */
+  void FreeBuffers()
   {
-    throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_SCHEMANAME_UNKNOWN);
+    wxSQLite3RecorderBuffer* buffer = GetFirstBuffer();
+    while (buffer != NULL)
+    {
+      wxSQLite3RecorderBuffer* next = buffer->m_next;
+      delete buffer;
+      buffer = next;
+    }
+#if WXSQLITE3_HAVE_CXX11
+    m_buffers.store(NULL, std::memory_order_release);
+    // Ids are never reused, so buffers cached by other threads are not found any longer
+    m_listId = ++gs_recorderListId;
+#else
+    m_buffers = NULL;
+#endif
   }
-  else
+
+  /// Get the first buffer of the list of thread buffers
+  wxSQLite3RecorderBuffer* GetFirstBuffer() const
+  {
+#if WXSQLITE3_HAVE_CXX11
+    return m_buffers.load(std::memory_order_acquire);
+#else
+    return m_buffers;
+#endif
+  }
+
+  /// Get the buffer of the current thread, creating it on first use
+  wxSQLite3RecorderBuffer* GetBuffer()
   {
-    switch (txnState)
+#if WXSQLITE3_HAVE_CXX11
+    if (gs_recorderCachedListId == m_listId)
     {
-      case SQLITE_TXN_READ:
-        state = WXSQLITE_TRANSACTION_READ;
-        break;
-      case SQLITE_TXN_WRITE:
-        state = WXSQLITE_TRANSACTION_WRITE;
-        break;
-      case SQLITE_TXN_NONE:
-      default:
-        state = WXSQLITE_TRANSACTION_NONE;
+      return gs_recorderCachedBuffer;
+    }
+#endif
+#if wxUSE_THREADS
+    wxUint64 threadId = (wxUint64) wxThread::GetCurrentId();
+    bool isMain = wxThread::IsMain();
+#else
+    wxUint64 threadId = 0;
+    bool isMain = true;
+#endif
+    wxSQLite3RecorderBuffer* buffer;
+    for (buffer = GetFirstBuffer(); buffer != NULL; buffer = buffer->m_next)
+    {
+      if (buffer->m_threadId == threadId)
+      {
         break;
+      }
     }
-  }
-  return state;
-}
 
-void wxSQLite3Database::Savepoint(const wxString& savepointName)
-{
-#if SQLITE_VERSION_NUMBER >= 3006008
-  wxString localSavepointName = savepointName;
-  localSavepointName.Replace(wxString(wxS("\"")), wxString(wxS("\"\"")));
-  ExecuteUpdate(wxString(wxS("savepoint \"")) + localSavepointName + wxString(wxS("\"")));
+    if (buffer == NULL)
+    {
+      // Only the current thread creates a buffer for its id, so the buffer can't exist yet
+      buffer = new wxSQLite3RecorderBuffer(threadId, isMain, m_capacity);
+#if WXSQLITE3_HAVE_CXX11
+      buffer->m_next = m_buffers.load(std::memory_order_relaxed);
+      while (!m_buffers.compare_exchange_weak(buffer->m_next, buffer, std::memory_order_release, std::memory_order_relaxed))
+      {
+      }
 #else
-  wxUnusedVar(savepointName);
-  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOSAVEPOINT);
+#if wxUSE_THREADS
+      wxCriticalSectionLocker locker(m_csBuffers);
 #endif
-}
+      buffer->m_next = m_buffers;
+      wxSQLite3TraceFenceRelease();
+      m_buffers = buffer;
+#endif
+    }
+#if WXSQLITE3_HAVE_CXX11
+    gs_recorderCachedListId = m_listId;
+    gs_recorderCachedBuffer = buffer;
+#endif
+    return buffer;
+  }
 
-void wxSQLite3Database::ReleaseSavepoint(const wxString& savepointName)
-{
-#if SQLITE_VERSION_NUMBER >= 3006008
-  wxString localSavepointName = savepointName;
-  localSavepointName.Replace(wxString(wxS("\"")), wxString(wxS("\"\"")));
-  ExecuteUpdate(wxString(wxS("release savepoint \"")) + localSavepointName + wxString(wxS("\"")));
+  size_t                m_capacity;  ///< Capacity of each thread buffer
+  wxUint64              m_origin;    ///< Time of creation, origin of the exported time stamps
+  wxSQLite3TraceCounter m_recording; ///< Flag whether events are recorded
+
+private:
+#if WXSQLITE3_HAVE_CXX11
+  std::atomic<wxSQLite3RecorderBuffer*> m_buffers; ///< List of thread buffers
+  wxUint64 m_listId;                               ///< Id of the list of thread buffers, changed when the buffers are released
 #else
-  wxUnusedVar(savepointName);
-  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOSAVEPOINT);
+  wxSQLite3RecorderBuffer* volatile m_buffers;     ///< List of thread buffers
+#if wxUSE_THREADS
+  wxCriticalSection m_csBuffers;                   ///< Serializes adding thread buffers
 #endif
-}
+#endif
+};
 
-wxSQLite3Statement wxSQLite3Database::PrepareStatement(const wxString& sql)
+wxSQLite3EventRecorder::wxSQLite3EventRecorder(size_t eventsPerThread)
 {
-  wxCharBuffer strSql = sql.ToUTF8();
-  const char* localSql = strSql;
-  return PrepareStatement(localSql);
+  m_state = new wxSQLite3RecorderState(eventsPerThread);
 }
 
-wxSQLite3Statement wxSQLite3Database::PrepareStatement(const wxSQLite3StatementBuffer& sql)
+wxSQLite3EventRecorder::~wxSQLite3EventRecorder()
 {
-  return PrepareStatement((const char*) sql);
+  delete m_state;
 }
 
-wxSQLite3Statement wxSQLite3Database::PrepareStatement(const char* sql)
+void wxSQLite3EventRecorder::Start()
 {
-  CheckDatabase();
-  sqlite3_stmt* stmt = (sqlite3_stmt*) Prepare(sql);
-  wxSQLite3StatementReference* stmtRef = new wxSQLite3StatementReference(stmt);
-  return wxSQLite3Statement(m_db, stmtRef);
+  m_state->m_recording.SetRelease(1);
 }
 
-wxSQLite3Statement wxSQLite3Database::PreparePersistentStatement(const wxString& sql)
+void wxSQLite3EventRecorder::Stop()
 {
-  wxCharBuffer strSql = sql.ToUTF8();
-  const char* localSql = strSql;
-#if SQLITE_VERSION_NUMBER >= 3020000
-  return PreparePersistentStatement(localSql);
-#else
-  return PrepareStatement(localSql);
-#endif
+  m_state->m_recording.SetRelease(0);
 }
 
-wxSQLite3Statement wxSQLite3Database::PreparePersistentStatement(const wxSQLite3StatementBuffer& sql)
+bool wxSQLite3EventRecorder::IsRecording() const
 {
-#if SQLITE_VERSION_NUMBER >= 3020000
-  return PreparePersistentStatement((const char*) sql);
-#else
-  return PrepareStatement((const char*)sql);
-#endif
+  return m_state->m_recording.Get() != 0;
 }
 
-wxSQLite3Statement wxSQLite3Database::PreparePersistentStatement(const char* sql)
+void wxSQLite3EventRecorder::Clear()
 {
-  CheckDatabase();
-#if SQLITE_VERSION_NUMBER >= 3020000
-  sqlite3_stmt* stmt = (sqlite3_stmt*) PreparePersistent(sql);
-#else
-  sqlite3_stmt* stmt = (sqlite3_stmt*)Prepare(sql);
-#endif
-  wxSQLite3StatementReference* stmtRef = new wxSQLite3StatementReference(stmt);
-  return wxSQLite3Statement(m_db, stmtRef);
+  m_state->FreeBuffers();
 }
 
-bool wxSQLite3Database::TableExists(const wxString& tableName, const wxString& databaseName)
+size_t wxSQLite3EventRecorder::GetEventCount() const
 {
-  wxString sql;
-  if (databaseName.IsEmpty())
-  {
-    sql = wxS("select count(*) from sqlite_master where type='table' and name like ?");
-  }
-  else
+  size_t count = 0;
+  wxSQLite3RecorderBuffer* buffer;
+  for (buffer = m_state->GetFirstBuffer(); buffer != NULL; buffer = buffer->m_next)
   {
-    sql = wxString(wxS("select count(*) from ")) + databaseName + wxString(wxS(".sqlite_master where type='table' and name like ?"));
+    wxUint64 written = buffer->m_written.GetAcquire();
+    count += (written < buffer->m_capacity) ? (size_t) written : buffer->m_capacity;
   }
-  wxSQLite3Statement stmt = PrepareStatement(sql);
-  stmt.Bind(1, tableName);
-  wxSQLite3ResultSet resultSet = stmt.ExecuteQuery();
-  long value = 0;
-  resultSet.GetAsString(0).ToLong(&value);
-  return (value > 0);
+  return count;
 }
 
-bool wxSQLite3Database::TableExists(const wxString& tableName, wxArrayString& databaseNames)
+wxUint64 wxSQLite3EventRecorder::GetDroppedEventCount() const
 {
-  wxArrayString databaseList;
-  GetDatabaseList(databaseList);
-
-  bool found = false;
-  size_t count = databaseList.GetCount();
-  if (count > 0)
+  wxUint64 count = 0;
+  wxSQLite3RecorderBuffer* buffer;
+  for (buffer = m_state->GetFirstBuffer(); buffer != NULL; buffer = buffer->m_next)
   {
-    size_t j;
-    for (j = 0; j < count; j++)
+    wxUint64 written = buffer->m_written.GetAcquire();
+    if (written > buffer->m_capacity)
     {
-      if (TableExists(tableName, databaseList.Item(j)))
+      count += written - buffer->m_capacity;
+    }
+  }
+  return count;
+}
+
+// Append an event to the buffer of the current thread
+static void wxSQLite3RecordEvent(wxSQLite3RecorderState* state, bool instant,
+                                 const char* category, const char* name, wxUint64 start, wxUint64 end,
+                                 const char* detailName, const char* detail,
+                                 const char* argName, wxInt64 argValue)
+{
+  wxSQLite3RecorderBuffer* buffer = state->GetBuffer();
+  wxUint64 written = buffer->m_written.Get();
+  wxSQLite3RecordedEvent& event = buffer->m_events[(size_t) (written % buffer->m_capacity)];
+  event.m_category = category;
+  event.m_name = name;
+  event.m_detailName = (detail != NULL) ? detailName : NULL;
+  event.m_argName = argName;
+  event.m_start = start;
+  event.m_duration = (end > start) ? end - start : 0;
+  event.m_argValue = argValue;
+  event.m_instant = instant;
+  event.m_detail[0] = '\0';
+  if (event.m_detailName != NULL)
+  {
+    size_t len = strlen(detail);
+    if (len >= (size_t) wxSQLite3RecordedEvent::DETAIL_SIZE)
+    {
+      // Truncate at a character boundary
+      len = wxSQLite3RecordedEvent::DETAIL_SIZE - 1;
+      while (len > 0 && (((unsigned char) detail[len]) & 0xC0) == 0x80)
       {
-        found = true;
-        databaseNames.Add(databaseList.Item(j));
+        --len;
       }
     }
+    memcpy(event.m_detail, detail, len);
+    event.m_detail[len] = '\0';
   }
-  return found;
+  buffer->m_written.SetRelease(written + 1);
 }
 
-void wxSQLite3Database::GetDatabaseList(wxArrayString& databaseNames)
+void wxSQLite3EventRecorder::Record(const char* category, const char* name, wxUint64 start, wxUint64 end,
+                                    const char* detailName, const char* detail,
+                                    const char* argName, wxInt64 argValue)
 {
-  databaseNames.Empty();
-  wxSQLite3ResultSet resultSet = ExecuteQuery("PRAGMA database_list;");
-  while (resultSet.NextRow())
+  if (IsRecording())
   {
-    databaseNames.Add(resultSet.GetString(1));
+    wxSQLite3RecordEvent(m_state, false, category, name, start, end, detailName, detail, argName, argValue);
   }
 }
 
-void wxSQLite3Database::GetDatabaseList(wxArrayString& databaseNames, wxArrayString& databaseFiles)
+void wxSQLite3EventRecorder::RecordInstant(const char* category, const char* name,
+                                           const char* detailName, const char* detail)
 {
-  databaseNames.Empty();
-  databaseFiles.Empty();
-  wxSQLite3ResultSet resultSet = ExecuteQuery("PRAGMA database_list;");
-  while (resultSet.NextRow())
+  if (IsRecording())
   {
-    databaseNames.Add(resultSet.GetString(1));
-    databaseFiles.Add(resultSet.GetString(2));
+    wxUint64 now = GetTimestamp();
+    wxSQLite3RecordEvent(m_state, true, category, name, now, now, detailName, detail, NULL, 0);
   }
 }
 
-wxString wxSQLite3Database::GetDatabaseFilename(const wxString& databaseName)
+wxString wxSQLite3EventRecorder::GetTraceJSON() const
 {
-#if SQLITE_VERSION_NUMBER >= 3007010
-  CheckDatabase();
-  wxCharBuffer strDatabaseName = databaseName.ToUTF8();
-  const char* localDatabaseName = strDatabaseName;
-  const char* localFilename = sqlite3_db_filename(m_db->m_db, localDatabaseName);
-  return wxString::FromUTF8(localFilename);
-#else
-  wxUnusedVar(databaseName);
-  return wxEmptyString;
-#endif
+  sqlite3_str* out = sqlite3_str_new(NULL);
+  unsigned long pid = wxGetProcessId();
+  int tid = 0;
+  sqlite3_str_appendall(out, "{\"traceEvents\":[");
+  wxSQLite3RecorderBuffer* buffer;
+  for (buffer = m_state->GetFirstBuffer(); buffer != NULL; buffer = buffer->m_next)
+  {
+    ++tid;
+    sqlite3_str_appendf(out, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%lu,\"tid\":%d,\"args\":{\"name\":",
+                        (tid > 1) ? "," : "", pid, tid);
+    if (buffer->m_isMain)
+    {
+      sqlite3_str_appendall(out, "\"main thread\"}}");
+    }
+    else
+    {
+      sqlite3_str_appendf(out, "\"thread %llu\"}}", (sqlite3_uint64) buffer->m_threadId);
+    }
+
+    wxUint64 written = buffer->m_written.GetAcquire();
+    wxUint64 first = (written > buffer->m_capacity) ? written - buffer->m_capacity : 0;
+    wxUint64 j;
+    for (j = first; j < written; ++j)
+    {
+      const wxSQLite3RecordedEvent& event = buffer->m_events[(size_t) (j % buffer->m_capacity)];
+      wxUint64 start = (event.m_start > m_state->m_origin) ? event.m_start - m_state->m_origin : 0;
+      sqlite3_str_appendall(out, ",\n{\"name\":");
+      wxSQLite3AppendJSONString(out, event.m_name);
+      sqlite3_str_appendall(out, ",\"cat\":");
+      wxSQLite3AppendJSONString(out, event.m_category);
+      if (event.m_instant)
+      {
+        sqlite3_str_appendf(out, ",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f", (double) start / 1000.0);
+      }
+      else
+      {
+        sqlite3_str_appendf(out, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f",
+                            (double) start / 1000.0, (double) event.m_duration / 1000.0);
+      }
+      sqlite3_str_appendf(out, ",\"pid\":%lu,\"tid\":%d", pid, tid);
+      if (event.m_detailName != NULL || event.m_argName != NULL)
+      {
+        sqlite3_str_appendall(out, ",\"args\":{");
+        if (event.m_detailName != NULL)
+        {
+          wxSQLite3AppendJSONString(out, event.m_detailName);
+          sqlite3_str_appendchar(out, 1, ':');
+          wxSQLite3AppendJSONString(out, event.m_detail);
+        }
+        if (event.m_argName != NULL)
+        {
+          if (event.m_detailName != NULL)
+          {
+            sqlite3_str_appendchar(out, 1, ',');
+          }
+          wxSQLite3AppendJSONString(out, event.m_argName);
+          sqlite3_str_appendf(out, ":%lld", (sqlite3_int64) event.m_argValue);
+        }
+        sqlite3_str_appendchar(out, 1, '}');
+      }
+      sqlite3_str_appendchar(out, 1, '}');
+    }
+  }
+  sqlite3_str_appendall(out, "\n],\"displayTimeUnit\":\"ns\"}\n");
+  return wxSQLite3FinishString(out);
 }
 
-bool wxSQLite3Database::EnableForeignKeySupport(bool enable)
+bool wxSQLite3EventRecorder::WriteTrace(const wxString& fileName) const
 {
-  if (enable)
-  {
-    ExecuteUpdate("PRAGMA foreign_keys=ON;");
-  }
-  else
-  {
-    ExecuteUpdate("PRAGMA foreign_keys=OFF;");
-  }
-  bool enabled = IsForeignKeySupportEnabled();
-  return (enable && enabled) || (!enable && !enabled);
+  wxFFile file(fileName, wxS("w"));
+  return file.IsOpened() && file.Write(GetTraceJSON(), wxConvUTF8) && file.Close();
 }
 
-bool wxSQLite3Database::IsForeignKeySupportEnabled()
+/* static */
+wxUint64 wxSQLite3EventRecorder::GetTimestamp()
 {
-  bool enabled = false;
-  wxSQLite3ResultSet resultSet = ExecuteQuery("PRAGMA foreign_keys;");
-  if (resultSet.NextRow())
-  {
-    enabled = (resultSet.GetInt(0) == 1);
-  }
-  return enabled;
+  return wxSQLite3TraceClock();
 }
 
-wxSQLite3JournalMode
-wxSQLite3Database::SetJournalMode(wxSQLite3JournalMode journalMode, const wxString& database)
+/* static */
+int wxSQLite3DatabaseReference::ExecBusyHandler(void* dbRef, int count)
 {
-  wxString mode = ConvertJournalMode(journalMode);
-  wxString query = wxS("PRAGMA ");
-  if (!database.IsEmpty())
+  // Same waiting scheme as the busy timeout handler of SQLite
+  static const int delays[] = { 1, 2, 5, 10, 15, 20, 25, 25, 25, 50, 50, 100 };
+  static const int totals[] = { 0, 1, 3, 8, 18, 33, 53, 78, 103, 128, 178, 228 };
+  static const int numDelays = (int) (sizeof(delays) / sizeof(delays[0]));
+
+  wxSQLite3DatabaseReference* db = (wxSQLite3DatabaseReference*) dbRef;
+  int delay;
+  int prior;
+  if (count < numDelays)
   {
-    query += database;
-    query += wxS(".");
+    delay = delays[count];
+    prior = totals[count];
   }
-  query += wxS("journal_mode=");
-  query += mode;
-  query += wxS(";");
-  wxSQLite3ResultSet resultSet = ExecuteQuery(query);
-  if (resultSet.NextRow())
+  else
   {
-    mode = resultSet.GetString(0);
+    delay = delays[numDelays - 1];
+    prior = totals[numDelays - 1] + delay * (count - (numDelays - 1));
   }
-  return ConvertJournalMode(mode);
+  if (prior + delay > db->m_busyTimeoutMs)
+  {
+    delay = db->m_busyTimeoutMs - prior;
+    if (delay <= 0)
+    {
+      return 0;
+    }
+  }
+  wxSQLite3RecorderScope scope(db->GetActiveRecorder(), "lock", "busy_wait");
+  scope.SetArg("attempt", count);
+  sqlite3_sleep(delay);
+  return 1;
 }
 
-wxSQLite3JournalMode
-wxSQLite3Database::GetJournalMode(const wxString& database)
+void wxSQLite3Database::SetEventRecorder(wxSQLite3EventRecorder* recorder)
 {
-  wxString mode = wxS("DELETE");
-  wxString query = wxS("PRAGMA ");
-  if (!database.IsEmpty())
+  WXSQLITE3_PROFILE();
+  CheckDatabase();
+  m_db->m_recorder = recorder;
+  if (recorder != NULL)
   {
-    query += database;
-    query += wxS(".");
+    m_db->m_busyTimeoutMs = m_busyTimeoutMs;
+    sqlite3_busy_handler(m_db->m_db, wxSQLite3DatabaseReference::ExecBusyHandler, m_db);
   }
-  query += wxS("journal_mode;");
-  wxSQLite3ResultSet resultSet = ExecuteQuery(query);
-  if (resultSet.NextRow())
+  else
   {
-    mode = resultSet.GetString(0);
+    sqlite3_busy_timeout(m_db->m_db, m_busyTimeoutMs);
   }
-  return ConvertJournalMode(mode);
 }
 
-/* static */
-wxString wxSQLite3Database::ConvertJournalMode(wxSQLite3JournalMode mode)
+wxSQLite3EventRecorder* wxSQLite3Database::GetEventRecorder() const
 {
-  wxString journalMode;
-  if      (mode == WXSQLITE_JOURNALMODE_DELETE)   journalMode = wxS("DELETE");
-  else if (mode == WXSQLITE_JOURNALMODE_PERSIST)  journalMode = wxS("PERSIST");
-  else if (mode == WXSQLITE_JOURNALMODE_OFF)      journalMode = wxS("OFF");
-  else if (mode == WXSQLITE_JOURNALMODE_TRUNCATE) journalMode = wxS("TRUNCATE");
-  else if (mode == WXSQLITE_JOURNALMODE_MEMORY)   journalMode = wxS("MEMORY");
-  else if (mode == WXSQLITE_JOURNALMODE_WAL)      journalMode = wxS("WAL");
-  else                                            journalMode = wxS("DELETE");
-  return journalMode;
+  WXSQLITE3_PROFILE();
+  return (m_db != NULL) ? m_db->m_recorder : NULL;
 }
 
-/* static */
-wxSQLite3JournalMode wxSQLite3Database::ConvertJournalMode(const wxString& mode)
+// --- Sampling profiler
+
+/// Samples of a query plan loop (internal)
+struct wxSQLite3SampleLoopEntry
 {
-  wxSQLite3JournalMode journalMode;
-  if      (mode.IsSameAs(wxS("DELETE"), false))   journalMode = WXSQLITE_JOURNALMODE_DELETE;
-  else if (mode.IsSameAs(wxS("PERSIST"), false))  journalMode = WXSQLITE_JOURNALMODE_PERSIST;
-  else if (mode.IsSameAs(wxS("OFF"), false))      journalMode = WXSQLITE_JOURNALMODE_OFF;
-  else if (mode.IsSameAs(wxS("TRUNCATE"), false)) journalMode = WXSQLITE_JOURNALMODE_TRUNCATE;
-  else if (mode.IsSameAs(wxS("MEMORY"), false))   journalMode = WXSQLITE_JOURNALMODE_MEMORY;
-  else if (mode.IsSameAs(wxS("WAL"), false))      journalMode = WXSQLITE_JOURNALMODE_WAL;
-  else                                            journalMode = WXSQLITE_JOURNALMODE_DELETE;
-  return journalMode;
-}
+  sqlite3_uint64        m_hash;    ///< Hash of the query plan text
+  wxString              m_detail;  ///< Query plan text
+  wxSQLite3TraceCounter m_samples; ///< Number of samples
+};
 
-bool wxSQLite3Database::CheckSyntax(const wxString& sql) const
+/// Samples of a fingerprint (internal)
+struct wxSQLite3SampleEntry
 {
-  wxCharBuffer strSql = sql.ToUTF8();
-  const char* localSql = strSql;
-  return CheckSyntax(localSql);
-}
+  wxString                 m_fingerprint; ///< Normalized SQL text
+  sqlite3_uint64           m_hash;        ///< Hash of the normalized SQL text
+  wxSQLite3TraceCounter    m_samples;     ///< Number of samples
+  wxSQLite3TraceCounter    m_loopCount;   ///< Number of loops
+  wxSQLite3SampleLoopEntry m_loops[wxSQLite3SampleProfile::MAX_LOOPS]; ///< Loops of the query plan
+};
 
-bool wxSQLite3Database::CheckSyntax(const wxSQLite3StatementBuffer& sql) const
+/// Loop counters of a statement at the time of its previous sample (internal)
+struct wxSQLite3SampleScan
 {
-  return CheckSyntax((const char*) sql);
-}
+  sqlite3_stmt* m_stmt;  ///< Statement
+  int           m_count; ///< Number of loops
+  sqlite3_int64 m_visits[wxSQLite3SampleProfile::MAX_LOOPS]; ///< Rows visited by the loops
+};
 
-bool wxSQLite3Database::CheckSyntax(const char* sql) const
+/// Internal state of a sampling profiler (internal)
+class wxSQLite3SamplerState
 {
-  return sqlite3_complete(sql) != 0;
-}
+public:
+  enum { SCAN_CACHE_SIZE = 8 };
 
-int wxSQLite3Database::ExecuteUpdate(const wxString& sql)
+  wxSQLite3SamplerState(int interval, size_t maxFingerprints);
+  ~wxSQLite3SamplerState();
+
+  /// Take a sample of the statement currently running on the connection
+  void TakeSample();
+
+  /// Find or create the fingerprint of a statement
+  size_t FindProfile(sqlite3_stmt* stmt);
+
+  /// Find the loop of the query plan that advanced most since the previous sample
+  const char* FindLoop(sqlite3_stmt* stmt);
+
+  /// Account a sample to a loop of a fingerprint
+  void AddLoopSample(wxSQLite3SampleEntry* profile, const char* detail);
+
+  /// Perform a requested reset
+  void PerformReset();
+
+  int                     m_interval;       ///< Number of VM instructions between samples
+  wxSQLite3DatabaseReference* m_db;         ///< Database connection being sampled
+  wxSQLite3TraceCounter   m_resetRequested; ///< Flag whether a reset was requested
+  wxSQLite3TraceCounter   m_sampleCount;    ///< Total number of samples
+  wxSQLite3SampleEntry**  m_profiles;       ///< Fingerprints
+  wxSQLite3TraceCounter   m_profileCount;   ///< Number of published fingerprints, including "(other)"
+  size_t                  m_maxProfiles;    ///< Maximum number of fingerprints
+
+private:
+  wxSQLite3TraceSqlCache  m_sqlCache;       ///< Hash table mapping SQL text to fingerprints
+  wxSQLite3SampleScan     m_scans[SCAN_CACHE_SIZE]; ///< Loop counters of recently sampled statements
+  size_t                  m_scanNext;       ///< Next entry of the loop counter cache to replace
+};
+
+wxSQLite3SamplerState::wxSQLite3SamplerState(int interval, size_t maxFingerprints)
+  : m_interval((interval > 0) ? interval : 1), m_db(NULL),
+    m_maxProfiles((maxFingerprints > 0) ? maxFingerprints : 1), m_sqlCache(m_maxProfiles), m_scanNext(0)
 {
-  wxCharBuffer strSql = sql.ToUTF8();
-  const char* localSql = strSql;
-  return ExecuteUpdate(localSql);
+  // One additional fingerprint accounts for all statements exceeding the maximum
+  m_profiles = new wxSQLite3SampleEntry*[m_maxProfiles + 1];
+  memset(m_profiles, 0, (m_maxProfiles + 1) * sizeof(wxSQLite3SampleEntry*));
+  memset(m_scans, 0, sizeof(m_scans));
 }
 
-int wxSQLite3Database::ExecuteUpdate(const wxSQLite3StatementBuffer& sql)
+wxSQLite3SamplerState::~wxSQLite3SamplerState()
 {
-  return ExecuteUpdate((const char*) sql);
+  size_t j;
+  for (j = 0; j <= m_maxProfiles; ++j)
+  {
+    delete m_profiles[j];
+  }
+  delete [] m_profiles;
 }
 
-int wxSQLite3Database::ExecuteUpdate(const char* sql, bool saveRC)
+size_t wxSQLite3SamplerState::FindProfile(sqlite3_stmt* stmt)
 {
-  CheckDatabase();
-
-  char* localError = 0;
+  return wxSQLite3FindFingerprint<wxSQLite3SampleEntry>(stmt, m_sqlCache, m_profiles, m_profileCount, m_maxProfiles, NULL);
+}
 
-  int rc = sqlite3_exec(m_db->m_db, sql, 0, 0, &localError);
-  if (saveRC)
+const char* wxSQLite3SamplerState::FindLoop(sqlite3_stmt* stmt)
+{
+#if defined(SQLITE_ENABLE_STMT_SCANSTATUS)
+  wxSQLite3SampleScan* scan = NULL;
+  size_t j;
+  for (j = 0; j < SCAN_CACHE_SIZE; ++j)
   {
-    if (strncmp(sql, "rollback transaction", 20) == 0)
+    if (m_scans[j].m_stmt == stmt)
     {
-      m_lastRollbackRC = rc;
+      scan = &m_scans[j];
+      break;
     }
   }
-
-  if (rc == SQLITE_OK)
+  bool known = (scan != NULL);
+  if (!known)
   {
-    return sqlite3_changes(m_db->m_db);
+    scan = &m_scans[m_scanNext];
+    m_scanNext = (m_scanNext + 1) % SCAN_CACHE_SIZE;
+    scan->m_stmt = stmt;
+    scan->m_count = 0;
   }
-  else
+
+  // Rows visited since the previous sample; a new statement counts from zero
+  const char* loop = NULL;
+  sqlite3_int64 maxDelta = 0;
+  int count = 0;
+  int k;
+  for (k = 0; k < wxSQLite3SampleProfile::MAX_LOOPS; ++k)
   {
-    wxString errmsg = wxString::FromUTF8(localError);
-    sqlite3_free(localError);
-    throw wxSQLite3Exception(rc, errmsg);
+    sqlite3_int64 loops = -1;
+    if (sqlite3_stmt_scanstatus_v2(stmt, k, SQLITE_SCANSTAT_NLOOP, SQLITE_SCANSTAT_COMPLEX, &loops) != 0)
+    {
+      break;
+    }
+    sqlite3_int64 visits = 0;
+    if (loops >= 0)
+    {
+      sqlite3_stmt_scanstatus_v2(stmt, k, SQLITE_SCANSTAT_NVISIT, SQLITE_SCANSTAT_COMPLEX, &visits);
+    }
+    sqlite3_int64 previous = (known && k < scan->m_count) ? scan->m_visits[k] : 0;
+    // The counters go backwards if the address was reused by another statement
+    sqlite3_int64 delta = (visits >= previous) ? visits - previous : visits;
+    if (delta > maxDelta)
+    {
+      const char* detail = NULL;
+      sqlite3_stmt_scanstatus_v2(stmt, k, SQLITE_SCANSTAT_EXPLAIN, SQLITE_SCANSTAT_COMPLEX, (void*) &detail);
+      if (detail != NULL)
+      {
+        maxDelta = delta;
+        loop = detail;
+      }
+    }
+    scan->m_visits[k] = visits;
+    ++count;
   }
+  scan->m_count = count;
+  return loop;
+#else
+  wxUnusedVar(stmt);
+  return NULL;
+#endif
 }
 
-wxSQLite3ResultSet wxSQLite3Database::ExecuteQuery(const wxString& sql)
+void wxSQLite3SamplerState::AddLoopSample(wxSQLite3SampleEntry* profile, const char* detail)
 {
-  wxCharBuffer strSql = sql.ToUTF8();
-  const char* localSql = strSql;
-  return ExecuteQuery(localSql);
+  size_t len = strlen(detail);
+  sqlite3_uint64 hash = wxSQLite3XXH64(detail, len, 0);
+  size_t count = (size_t) profile->m_loopCount.Get();
+  size_t j;
+  for (j = 0; j < count; ++j)
+  {
+    if (profile->m_loops[j].m_hash == hash)
+    {
+      profile->m_loops[j].m_samples.Add(1);
+      return;
+    }
+  }
+  if (count < wxSQLite3SampleProfile::MAX_LOOPS)
+  {
+    wxSQLite3SampleLoopEntry& loop = profile->m_loops[count];
+    loop.m_hash = hash;
+    loop.m_detail = wxString::FromUTF8(detail, len);
+    loop.m_samples.Set(1);
+    // Publish the loop to readers
+    profile->m_loopCount.SetRelease(count + 1);
+  }
 }
 
-wxSQLite3ResultSet wxSQLite3Database::ExecuteQuery(const wxSQLite3StatementBuffer& sql)
+void wxSQLite3SamplerState::PerformReset()
 {
-  return ExecuteQuery((const char*) sql);
+  size_t j;
+  for (j = 0; j <= m_maxProfiles; ++j)
+  {
+    wxSQLite3SampleEntry* profile = m_profiles[j];
+    if (profile != NULL)
+    {
+      profile->m_samples.Set(0);
+      size_t count = (size_t) profile->m_loopCount.Get();
+      size_t k;
+      for (k = 0; k < count; ++k)
+      {
+        profile->m_loops[k].m_samples.Set(0);
+      }
+    }
+  }
+  m_sampleCount.Set(0);
+  m_resetRequested.Set(0);
 }
 
-wxSQLite3ResultSet wxSQLite3Database::ExecuteQuery(const char* sql)
+void wxSQLite3SamplerState::TakeSample()
 {
-  CheckDatabase();
-
-  sqlite3_stmt* stmt = (sqlite3_stmt*) Prepare(sql);
-
-  int rc = sqlite3_step(stmt);
+  if (m_resetRequested.Get() != 0)
+  {
+    PerformReset();
+  }
 
-  if (rc == SQLITE_DONE) // no rows
+  // Statements stepped by the wrapper are known exactly; otherwise the first
+  // statement in progress is taken, which is exact for sqlite3_exec and sqlite3_get_table
+  sqlite3_stmt* stmt = m_db->m_currentStmt;
+  if (stmt == NULL)
   {
-    wxSQLite3StatementReference* stmtRef = new wxSQLite3StatementReference(stmt);
-    return wxSQLite3ResultSet(m_db, stmtRef, true /* eof */);
+    for (stmt = sqlite3_next_stmt(m_db->m_db, NULL); stmt != NULL; stmt = sqlite3_next_stmt(m_db->m_db, stmt))
+    {
+      if (sqlite3_stmt_busy(stmt))
+      {
+        break;
+      }
+    }
   }
-  else if (rc == SQLITE_ROW) // one or more rows
+  m_sampleCount.Add(1);
+  if (stmt == NULL)
   {
-    wxSQLite3StatementReference* stmtRef = new wxSQLite3StatementReference(stmt);
-    return wxSQLite3ResultSet(m_db, stmtRef, false /* eof */);
+    return;
   }
-  else
+  wxSQLite3SampleEntry* profile = m_profiles[FindProfile(stmt)];
+  profile->m_samples.Add(1);
+  const char* loop = FindLoop(stmt);
+  if (loop != NULL)
   {
-    rc = sqlite3_finalize(stmt);
-    const char* localError= sqlite3_errmsg(m_db->m_db);
-    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+    AddLoopSample(profile, loop);
   }
 }
 
-int wxSQLite3Database::ExecuteScalar(const wxString& sql)
-{
-  wxCharBuffer strSql = sql.ToUTF8();
-  const char* localSql = strSql;
-  return ExecuteScalar(localSql);
-}
-
-int wxSQLite3Database::ExecuteScalar(const wxSQLite3StatementBuffer& sql)
+wxSQLite3SamplingProfiler::wxSQLite3SamplingProfiler(int interval, size_t maxFingerprints)
 {
-  return ExecuteScalar((const char*) sql);
+  m_state = new wxSQLite3SamplerState(interval, maxFingerprints);
 }
 
-int wxSQLite3Database::ExecuteScalar(const char* sql)
+wxSQLite3SamplingProfiler::~wxSQLite3SamplingProfiler()
 {
-  wxSQLite3ResultSet resultSet = ExecuteQuery(sql);
-
-  if (resultSet.Eof() || resultSet.GetColumnCount() < 1)
+  wxSQLite3DatabaseReference* db = m_state->m_db;
+  if (db != NULL)
   {
-    throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_INVALID_QUERY);
+    // The connection is still open, since closing it detaches the profiler
+    sqlite3_progress_handler(db->GetHandle(), 0, NULL, NULL);
+    db->DetachSamplingProfiler();
   }
-
-  long value = 0;
-  resultSet.GetAsString(0).ToLong(&value);
-  return (int) value;
+  delete m_state;
 }
 
-wxSQLite3Table wxSQLite3Database::GetTable(const wxString& sql)
+int wxSQLite3SamplingProfiler::GetInterval() const
 {
-  wxCharBuffer strSql = sql.ToUTF8();
-  const char* localSql = strSql;
-  return GetTable(localSql);
+  return m_state->m_interval;
 }
 
-wxSQLite3Table wxSQLite3Database::GetTable(const wxSQLite3StatementBuffer& sql)
+wxUint64 wxSQLite3SamplingProfiler::GetSampleCount() const
 {
-  return GetTable((const char*) sql);
+  return m_state->m_sampleCount.Get();
 }
 
-wxSQLite3Table wxSQLite3Database::GetTable(const char* sql)
+size_t wxSQLite3SamplingProfiler::GetProfileCount() const
 {
-  CheckDatabase();
-
-  char* localError=0;
-  char** results=0;
-  int rc;
-  int rows(0);
-  int cols(0);
-
-  rc = sqlite3_get_table(m_db->m_db, sql, &results, &rows, &cols, &localError);
+  // The fingerprint "(other)" is reported last, once it is in use
+  return (size_t) m_state->m_profileCount.GetAcquire();
+}
 
-  if (rc == SQLITE_OK)
+bool wxSQLite3SamplingProfiler::GetProfile(size_t index, wxSQLite3SampleProfile& profile) const
+{
+  if (index >= GetProfileCount())
   {
-    return wxSQLite3Table(results, rows, cols);
+    return false;
   }
-  else
+  const wxSQLite3SampleEntry* source = m_state->m_profiles[index];
+  profile.m_fingerprint = source->m_fingerprint;
+  profile.m_samples = source->m_samples.Get();
+  profile.m_loopCount = (size_t) source->m_loopCount.GetAcquire();
+  size_t j;
+  for (j = 0; j < profile.m_loopCount; ++j)
   {
-    wxString errmsg = wxString::FromUTF8(localError);
-    sqlite3_free(localError);
-    throw wxSQLite3Exception(rc, errmsg);
+    profile.m_loopDetails[j] = source->m_loops[j].m_detail;
+    profile.m_loopSamples[j] = source->m_loops[j].m_samples.Get();
   }
+  return true;
 }
 
-wxLongLong wxSQLite3Database::GetLastRowId() const
+wxString wxSQLite3SamplingProfiler::GetReport() const
 {
-  CheckDatabase();
-  return wxLongLong(sqlite3_last_insert_rowid(m_db->m_db));
+  size_t count = GetProfileCount();
+  wxSQLite3SampleProfile* profiles = new wxSQLite3SampleProfile[(count > 0) ? count : 1];
+  size_t* order = new size_t[(count > 0) ? count : 1];
+  wxUint64 total = 0;
+  size_t j;
+  for (j = 0; j < count; ++j)
+  {
+    GetProfile(j, profiles[j]);
+    total += profiles[j].m_samples;
+    // Insertion sort by descending number of samples
+    size_t k = j;
+    while (k > 0 && profiles[order[k - 1]].m_samples < profiles[j].m_samples)
+    {
+      order[k] = order[k - 1];
+      --k;
+    }
+    order[k] = j;
+  }
+
+  sqlite3_str* out = sqlite3_str_new(NULL);
+  sqlite3_str_appendf(out, "Sampling profile (%llu samples, every %d instructions)\n",
+                      (sqlite3_uint64) GetSampleCount(), GetInterval());
+  sqlite3_str_appendf(out, "%12s %7s  %s\n", "Samples", "Share", "Statement");
+  for (j = 0; j < count; ++j)
+  {
+    const wxSQLite3SampleProfile& profile = profiles[order[j]];
+    if (profile.m_samples == 0)
+    {
+      continue;
+    }
+    wxCharBuffer fingerprint = profile.m_fingerprint.ToUTF8();
+    sqlite3_str_appendf(out, "%12llu %6.1f%%  %s\n", (sqlite3_uint64) profile.m_samples,
+                        100.0 * (double) profile.m_samples / (double) total, (const char*) fingerprint);
+    size_t k;
+    for (k = 0; k < profile.m_loopCount; ++k)
+    {
+      if (profile.m_loopSamples[k] > 0)
+      {
+        wxCharBuffer detail = profile.m_loopDetails[k].ToUTF8();
+        sqlite3_str_appendf(out, "%12llu %6.1f%%    %s\n", (sqlite3_uint64) profile.m_loopSamples[k],
+                            100.0 * (double) profile.m_loopSamples[k] / (double) profile.m_samples, (const char*) detail);
+      }
+    }
+  }
+  delete [] order;
+  delete [] profiles;
+  return wxSQLite3FinishString(out);
 }
 
-wxSQLite3Blob wxSQLite3Database::GetReadOnlyBlob(wxLongLong rowId,
-                                                 const wxString& columnName,
-                                                 const wxString& tableName,
-                                                 const wxString& dbName)
+void wxSQLite3SamplingProfiler::Reset()
 {
-  return GetBlob(rowId, columnName, tableName, dbName, false);
+  m_state->m_resetRequested.Set(1);
 }
 
-wxSQLite3Blob wxSQLite3Database::GetWritableBlob(wxLongLong rowId,
-                                                 const wxString& columnName,
-                                                 const wxString& tableName,
-                                                 const wxString& dbName)
+/* static */
+int wxSQLite3SamplingProfiler::ExecProgressHandler(void* profiler)
 {
-  return GetBlob(rowId, columnName, tableName, dbName, true);
+  wxSQLite3SamplerState* state = ((wxSQLite3SamplingProfiler*) profiler)->m_state;
+  if (state->m_db != NULL)
+  {
+    state->TakeSample();
+  }
+  // Never interrupt the statement
+  return 0;
 }
 
-wxSQLite3Blob wxSQLite3Database::GetBlob(wxLongLong rowId,
-                                         const wxString& columnName,
-                                         const wxString& tableName,
-                                         const wxString& dbName,
-                                         bool writable)
+void wxSQLite3DatabaseReference::DetachSamplingProfiler()
 {
-#if SQLITE_VERSION_NUMBER >= 3004000
-  wxCharBuffer strColumnName = columnName.ToUTF8();
-  const char* localColumnName = strColumnName;
-  wxCharBuffer strTableName = tableName.ToUTF8();
-  const char* localTableName = strTableName;
-  wxCharBuffer strDbName = dbName.ToUTF8();
-  const char* localDbName = (!dbName.IsEmpty()) ? (const char*) strDbName : (const char*) NULL;
-  int flags = (writable) ? 1 : 0;
-  sqlite3_blob* blobHandle;
-  CheckDatabase();
-  int rc = sqlite3_blob_open(m_db->m_db, localDbName, localTableName, localColumnName, rowId.GetValue(), flags, &blobHandle);
-  if (rc != SQLITE_OK)
+  if (m_samplingProfiler != NULL)
   {
-    const char* localError = sqlite3_errmsg(m_db->m_db);
-    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+    m_samplingProfiler->m_state->m_db = NULL;
+    m_samplingProfiler = NULL;
   }
-  wxSQLite3BlobReference* blobRef = new wxSQLite3BlobReference(blobHandle);
-  return wxSQLite3Blob(m_db, blobRef, writable);
-#else
-  wxUnusedVar(rowId);
-  wxUnusedVar(columnName);
-  wxUnusedVar(tableName);
-  wxUnusedVar(dbName);
-  wxUnusedVar(writable);
-  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOINCBLOB);
-  return NULL;
-#endif
 }
 
-void wxSQLite3Database::Interrupt()
+void wxSQLite3Database::SetSamplingProfiler(wxSQLite3SamplingProfiler* profiler)
 {
+  WXSQLITE3_PROFILE();
   CheckDatabase();
-  sqlite3_interrupt(m_db->m_db);
+  // The profile state is updated without locking, so it must not be shared by connections
+  if (profiler != NULL && profiler->m_state->m_db != NULL && profiler->m_state->m_db != m_db)
+  {
+    throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_PROFILER_ATTACHED);
+  }
+  m_db->DetachSamplingProfiler();
+  if (profiler != NULL)
+  {
+    profiler->m_state->m_db = m_db;
+    m_db->m_samplingProfiler = profiler;
+    sqlite3_progress_handler(m_db->m_db, profiler->m_state->m_interval, wxSQLite3SamplingProfiler::ExecProgressHandler, profiler);
+  }
+  else
+  {
+    sqlite3_progress_handler(m_db->m_db, 0, NULL, NULL);
+  }
 }
 
-bool wxSQLite3Database::IsInterrupted()
+// --- Asynchronous logging
+
+/// Slot of the log message ring buffer (internal)
+struct wxSQLite3LogSlot
 {
-  CheckDatabase();
-  return (sqlite3_is_interrupted(m_db->m_db) != 0);
-}
+  // SQLite truncates log messages to about 200 bytes
+  enum { MESSAGE_SIZE = 256 };
 
-void wxSQLite3Database::SetBusyTimeout(int nMillisecs)
+  wxSQLite3TraceCounter m_sequence; ///< Sequence number guarding the slot
+  int                   m_errorCode; ///< SQLite error code
+  size_t                m_length;    ///< Length of the message
+  char                  m_message[MESSAGE_SIZE]; ///< Message text (truncated UTF-8)
+};
+
+class wxSQLite3AsyncLoggerThread;
+
+/// Internal state of an asynchronous logger (internal)
+/**
+* The ring buffer is a bounded multi-producer single-consumer queue: a producer claims
+* a position by advancing the head and publishes the slot by setting its sequence number
+* to position + 1; the consumer releases the slot for the next round by setting it to
+* position + capacity.
+*/
+class wxSQLite3AsyncLoggerState
 {
-  CheckDatabase();
-  m_busyTimeoutMs = nMillisecs;
-  sqlite3_busy_timeout(m_db->m_db, m_busyTimeoutMs);
-}
+public:
+  wxSQLite3AsyncLoggerState(size_t capacity)
+    : m_head(0), m_dropped(0), m_tail(0), m_thread(NULL)
+  {
+    m_capacity = 2;
+    while (m_capacity < capacity)
+    {
+      m_capacity *= 2;
+    }
+    m_slots = new wxSQLite3LogSlot[m_capacity];
+    size_t j;
+    for (j = 0; j < m_capacity; ++j)
+    {
+      m_slots[j].m_sequence.Set(j);
+    }
+  }
 
-void wxSQLite3Database::SetLockTimeout(int nMillisecs, bool blockOnConnect)
+  ~wxSQLite3AsyncLoggerState()
+  {
+    delete [] m_slots;
+  }
+
+  /// Queue a message, returns false if the ring buffer is full (any thread)
+  bool Push(int errorCode, const char* message);
+
+  /// Take the oldest message, returns false if the ring buffer is empty (consumer thread only)
+  bool Pop(int& errorCode, wxString& message);
+
+  /// Get the number of dropped messages
+  wxUint64 GetDropped() const
+  {
+#if WXSQLITE3_HAVE_CXX11
+    return m_dropped.load(std::memory_order_relaxed);
+#else
+    return m_dropped;
+#endif
+  }
+
+  size_t                      m_capacity; ///< Number of slots (power of 2)
+  wxSQLite3LogSlot*           m_slots;    ///< Ring of message slots
+#if WXSQLITE3_HAVE_CXX11
+  std::atomic<wxUint64>       m_head;     ///< Next position to be claimed by a producer
+  std::atomic<wxUint64>       m_dropped;  ///< Number of dropped messages
+#else
+  wxUint64                    m_head;     ///< Next position to be claimed by a producer
+  wxUint64                    m_dropped;  ///< Number of dropped messages
+#if wxUSE_THREADS
+  wxCriticalSection           m_csRing;   ///< Serializes the access to the ring buffer
+#endif
+#endif
+  wxUint64                    m_tail;     ///< Next position to be taken by the consumer
+  wxSQLite3AsyncLoggerThread* m_thread;   ///< Thread dispatching the messages
+};
+
+bool wxSQLite3AsyncLoggerState::Push(int errorCode, const char* message)
 {
-#if SQLITE_VERSION_NUMBER >= 3050000
-  CheckDatabase();
-  int rc = sqlite3_setlk_timeout(m_db->m_db, nMillisecs, (blockOnConnect) ? 1 : 0);
-  if (rc != SQLITE_OK)
+  wxSQLite3LogSlot* slot;
+#if WXSQLITE3_HAVE_CXX11
+  wxUint64 position = m_head.load(std::memory_order_relaxed);
+  for (;;)
   {
-    const char* localError = sqlite3_errmsg(m_db->m_db);
-    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+    slot = &m_slots[position & (m_capacity - 1)];
+    wxUint64 sequence = slot->m_sequence.GetAcquire();
+    if (sequence == position)
+    {
+      if (m_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+      {
+        break;
+      }
+    }
+    else if (sequence < position)
+    {
+      // The consumer has not yet released the slot of the previous round
+      m_dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    else
+    {
+      position = m_head.load(std::memory_order_relaxed);
+    }
   }
 #else
-  wxUnusedVar(nMillisecs);
-  wxUnusedVar(blockOnConnect);
+  // Without C++11 atomics the sequence numbers are plain volatile variables, which
+  // provide no memory ordering; the critical section acts as the memory barrier
+#if wxUSE_THREADS
+  wxCriticalSectionLocker locker(m_csRing);
 #endif
+  wxUint64 position = m_head;
+  slot = &m_slots[position & (m_capacity - 1)];
+  if (slot->m_sequence.GetAcquire() != position)
+  {
+    ++m_dropped;
+    return false;
+  }
+  ++m_head;
+#endif
+
+  size_t length = (message != NULL) ? strlen(message) : 0;
+  if (length >= (size_t) wxSQLite3LogSlot::MESSAGE_SIZE)
+  {
+    // Truncate at a character boundary
+    length = wxSQLite3LogSlot::MESSAGE_SIZE - 1;
+    while (length > 0 && (((unsigned char) message[length]) & 0xC0) == 0x80)
+    {
+      --length;
+    }
+  }
+  slot->m_errorCode = errorCode;
+  slot->m_length = length;
+  memcpy(slot->m_message, message, length);
+  slot->m_sequence.SetRelease(position + 1);
+  return true;
+}
+
+bool wxSQLite3AsyncLoggerState::Pop(int& errorCode, wxString& message)
+{
+#if !WXSQLITE3_HAVE_CXX11 && wxUSE_THREADS
+  wxCriticalSectionLocker locker(m_csRing);
+#endif
+  wxSQLite3LogSlot& slot = m_slots[m_tail & (m_capacity - 1)];
+  if (slot.m_sequence.GetAcquire() != m_tail + 1)
+  {
+    return false;
+  }
+  errorCode = slot.m_errorCode;
+  message = wxString::FromUTF8(slot.m_message, slot.m_length);
+  slot.m_sequence.SetRelease(m_tail + m_capacity);
+  ++m_tail;
+  return true;
 }
 
-void wxSQLite3Database::Configure(wxSQLite3DbConfig cfgType, int cfgValue, int& cfgResult)
+#if wxUSE_THREADS
+
+// Interval in milliseconds at which the logger thread polls the ring buffer
+static const unsigned long gs_asyncLoggerPollInterval = 10;
+
+/// Thread dispatching the messages of an asynchronous logger (internal)
+class wxSQLite3AsyncLoggerThread : public wxThread
 {
-  CheckDatabase();
-  int rc = SQLITE_ERROR;
-  int localCfgType = static_cast<int>(cfgType);
-  if (localCfgType >= SQLITE_DBCONFIG_ENABLE_FKEY && localCfgType <= SQLITE_DBCONFIG_ENABLE_COMMENTS)
+public:
+  wxSQLite3AsyncLoggerThread(wxSQLite3AsyncLogger* logger, wxSQLite3AsyncLoggerState* state)
+    : wxThread(wxTHREAD_JOINABLE), m_logger(logger), m_state(state), m_stop(false), m_condition(m_mutex)
   {
-    rc = sqlite3_db_config(m_db->m_db, cfgType, cfgValue, &cfgResult);
-    if (rc != SQLITE_OK)
+  }
+
+  /// Request the thread to terminate
+  void RequestStop()
+  {
+    wxMutexLocker lock(m_mutex);
+    m_stop = true;
+    m_condition.Signal();
+  }
+
+  /// Dispatch all queued messages
+  void Drain()
+  {
+    int errorCode;
+    wxString message;
+    while (m_state->Pop(errorCode, message))
     {
-        const char* localError = sqlite3_errmsg(m_db->m_db);
-        throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+      try
+      {
+        m_logger->HandleLogMessage(errorCode, message);
+      }
+      catch (...)
+      {
+        // Exceptions must not terminate the logger thread
+      }
     }
   }
-  else
+
+  virtual ExitCode Entry()
   {
-    throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_DBCONFIG_OPTION_UNKNOWN);
+    // Producers never block on the thread, therefore the ring buffer is polled
+    bool stop = false;
+    while (!stop)
+    {
+      Drain();
+      wxMutexLocker lock(m_mutex);
+      if (!m_stop)
+      {
+        m_condition.WaitTimeout(gs_asyncLoggerPollInterval);
+      }
+      stop = m_stop;
+    }
+    Drain();
+    return 0;
   }
-}
 
-wxString wxSQLite3Database::GetWrapperVersion()
-{
-  return wxString(wxSQLITE3_VERSION_STRING);
-}
+private:
+  wxSQLite3AsyncLogger*      m_logger;    ///< Logger handling the messages
+  wxSQLite3AsyncLoggerState* m_state;     ///< Internal state of the logger
+  bool                       m_stop;      ///< Flag whether the thread should terminate
+  wxMutex                    m_mutex;     ///< Mutex guarding the stop flag
+  wxCondition                m_condition; ///< Condition signalling a stop request
+};
 
-wxString wxSQLite3Database::GetMCVersion()
-{
-    return wxString::FromUTF8(sqlite3mc_version());
-}
+#endif
 
-wxString wxSQLite3Database::GetVersion()
+wxSQLite3AsyncLogger::wxSQLite3AsyncLogger(size_t capacity)
 {
-  return wxString::FromUTF8(sqlite3_libversion());
+  m_state = new wxSQLite3AsyncLoggerState(capacity);
 }
 
-wxString wxSQLite3Database::GetSourceId()
+wxSQLite3AsyncLogger::~wxSQLite3AsyncLogger()
 {
-#if SQLITE_VERSION_NUMBER >= 3006018
-  return wxString::FromUTF8(sqlite3_sourceid());
-#else
-  return wxEmptyString;
-#endif
+  Stop();
+  delete m_state;
 }
 
-bool wxSQLite3Database::CompileOptionUsed(const wxString& optionName)
+bool wxSQLite3AsyncLogger::Start()
 {
-#if SQLITE_VERSION_NUMBER >= 3006023
-  wxCharBuffer strOption = optionName.ToUTF8();
-  const char* localOption = strOption;
-  return sqlite3_compileoption_used(localOption) == 1;
+#if wxUSE_THREADS
+  if (m_state->m_thread != NULL)
+  {
+    return false;
+  }
+  m_state->m_thread = new wxSQLite3AsyncLoggerThread(this, m_state);
+  if (m_state->m_thread->Run() != wxTHREAD_NO_ERROR)
+  {
+    delete m_state->m_thread;
+    m_state->m_thread = NULL;
+    return false;
+  }
+  return true;
 #else
   return false;
 #endif
 }
 
-wxString wxSQLite3Database::GetCompileOptionName(int optionIndex)
+void wxSQLite3AsyncLogger::Stop()
 {
-#if SQLITE_VERSION_NUMBER >= 3006023
-  const char* unknownOption = "";
-  const char* optionName = sqlite3_compileoption_get(optionIndex);
-  if (optionName == NULL)
+#if wxUSE_THREADS
+  if (m_state->m_thread == NULL)
   {
-    optionName = unknownOption;
+    return;
   }
-  return wxString::FromUTF8(optionName);
-#else
-  return wxEmptyString;
+  m_state->m_thread->RequestStop();
+  m_state->m_thread->Wait();
+  delete m_state->m_thread;
+  m_state->m_thread = NULL;
 #endif
 }
 
-bool wxSQLite3Database::CreateFunction(const wxString& funcName, int argCount, wxSQLite3ScalarFunction& function, int functionFlags)
+bool wxSQLite3AsyncLogger::IsRunning() const
 {
-  CheckDatabase();
-  wxCharBuffer strFuncName = funcName.ToUTF8();
-  const char* localFuncName = strFuncName;
-  int flags = SQLITE_UTF8;
-#if SQLITE_VERSION_NUMBER >= 3008003
-  flags |= functionFlags;
-#endif
-  int rc = sqlite3_create_function(m_db->m_db, localFuncName, argCount,
-                                   flags, &function,
-                                   (void (*)(sqlite3_context*,int,sqlite3_value**)) wxSQLite3FunctionContext::ExecScalarFunction, NULL, NULL);
-  return rc == SQLITE_OK;
+  return m_state->m_thread != NULL;
 }
 
-bool wxSQLite3Database::CreateFunction(const wxString& funcName, int argCount, wxSQLite3AggregateFunction& function, int functionFlags)
+size_t wxSQLite3AsyncLogger::GetCapacity() const
 {
-  CheckDatabase();
-  wxCharBuffer strFuncName = funcName.ToUTF8();
-  const char* localFuncName = strFuncName;
-  int flags = SQLITE_UTF8;
-#if SQLITE_VERSION_NUMBER >= 3008003
-  flags |= functionFlags;
-#endif
-  int rc = sqlite3_create_function(m_db->m_db, localFuncName, argCount,
-                                   flags, &function,
-                                   NULL,
-                                   (void (*)(sqlite3_context*,int,sqlite3_value**)) wxSQLite3FunctionContext::ExecAggregateStep,
-                                   (void (*)(sqlite3_context*)) wxSQLite3FunctionContext::ExecAggregateFinalize);
-  return rc == SQLITE_OK;
+  return m_state->m_capacity;
 }
 
-bool wxSQLite3Database::CreateFunction(const wxString& funcName, int argCount, wxSQLite3WindowFunction& function, int functionFlags)
+wxUint64 wxSQLite3AsyncLogger::GetDroppedMessageCount() const
 {
-#if SQLITE_VERSION_NUMBER >= 3025000
-  CheckDatabase();
-  wxCharBuffer strFuncName = funcName.ToUTF8();
-  const char* localFuncName = strFuncName;
-  int flags = SQLITE_UTF8 | functionFlags;
-  int rc = sqlite3_create_window_function(m_db->m_db, localFuncName, argCount,
-                                          flags, &function,
-                                          (void(*)(sqlite3_context*, int, sqlite3_value**)) wxSQLite3FunctionContext::ExecWindowStep,
-                                          (void(*)(sqlite3_context*)) wxSQLite3FunctionContext::ExecWindowFinalize,
-                                          (void(*)(sqlite3_context*)) wxSQLite3FunctionContext::ExecWindowValue,
-                                          (void(*)(sqlite3_context*, int, sqlite3_value**)) wxSQLite3FunctionContext::ExecWindowInverse,
-                                          NULL);
-  return rc == SQLITE_OK;
+  return m_state->GetDropped();
+}
+
+void wxSQLite3AsyncLogger::DispatchLogMessage(int errorCode, const char* errorMessage)
+{
+#if wxUSE_THREADS
+  m_state->Push(errorCode, errorMessage);
 #else
-  return false;
+  wxSQLite3Logger::DispatchLogMessage(errorCode, errorMessage);
 #endif
 }
 
-bool wxSQLite3Database::SetAuthorizer(wxSQLite3Authorizer& authorizer)
+// --- Status snapshots and sampling
+
+wxSQLite3DatabaseStatus::wxSQLite3DatabaseStatus()
+  : timestamp(0), lookasideHit(0), lookasideMissSize(0), lookasideMissFull(0),
+    cacheUsed(0), cacheUsedShared(0), cacheHit(0), cacheMiss(0), cacheWrite(0), cacheSpill(0),
+    tempBufferSpill(0), schemaUsed(0), stmtUsed(0), deferredForeignKeys(0)
 {
-  CheckDatabase();
-  int rc = sqlite3_set_authorizer(m_db->m_db, (sqlite3_xauth) wxSQLite3FunctionContextExecAuthorizer, &authorizer);
-  return rc == SQLITE_OK;
 }
 
-bool wxSQLite3Database::RemoveAuthorizer()
+wxSQLite3DatabaseStatus wxSQLite3DatabaseStatus::Delta(const wxSQLite3DatabaseStatus& previous) const
 {
-  CheckDatabase();
-  int rc = sqlite3_set_authorizer(m_db->m_db, (sqlite3_xauth) NULL, NULL);
-  return rc == SQLITE_OK;
+  wxSQLite3DatabaseStatus delta(*this);
+  delta.timestamp = timestamp - previous.timestamp;
+  delta.lookasideUsed.current = lookasideUsed.current - previous.lookasideUsed.current;
+  delta.lookasideHit = lookasideHit - previous.lookasideHit;
+  delta.lookasideMissSize = lookasideMissSize - previous.lookasideMissSize;
+  delta.lookasideMissFull = lookasideMissFull - previous.lookasideMissFull;
+  delta.cacheUsed = cacheUsed - previous.cacheUsed;
+  delta.cacheUsedShared = cacheUsedShared - previous.cacheUsedShared;
+  delta.cacheHit = cacheHit - previous.cacheHit;
+  delta.cacheMiss = cacheMiss - previous.cacheMiss;
+  delta.cacheWrite = cacheWrite - previous.cacheWrite;
+  delta.cacheSpill = cacheSpill - previous.cacheSpill;
+  delta.tempBufferSpill = tempBufferSpill - previous.tempBufferSpill;
+  delta.schemaUsed = schemaUsed - previous.schemaUsed;
+  delta.stmtUsed = stmtUsed - previous.stmtUsed;
+  delta.deferredForeignKeys = deferredForeignKeys - previous.deferredForeignKeys;
+  return delta;
 }
 
-void wxSQLite3Database::SetCommitHook(wxSQLite3Hook* commitHook)
+double wxSQLite3DatabaseStatus::GetCacheHitRatio() const
 {
-  CheckDatabase();
-  if (commitHook)
-  {
-    sqlite3_commit_hook(m_db->m_db, (int(*)(void*)) wxSQLite3FunctionContext::ExecCommitHook, commitHook);
-  }
-  else
-  {
-    sqlite3_commit_hook(m_db->m_db, (int(*)(void*)) NULL, NULL);
-  }
+  wxsqlite_int64 lookups = cacheHit + cacheMiss;
+  return (lookups > 0) ? (double) cacheHit / (double) lookups : 0.0;
 }
 
-void wxSQLite3Database::SetRollbackHook(wxSQLite3Hook* rollbackHook)
+double wxSQLite3DatabaseStatus::GetLookasideHitRatio() const
 {
-  CheckDatabase();
-  if (rollbackHook)
-  {
-    sqlite3_rollback_hook(m_db->m_db, (void(*)(void*)) wxSQLite3FunctionContext::ExecRollbackHook, rollbackHook);
-  }
-  else
-  {
-    sqlite3_rollback_hook(m_db->m_db, (void(*)(void*)) NULL, NULL);
-  }
+  wxsqlite_int64 attempts = lookasideHit + lookasideMissSize + lookasideMissFull;
+  return (attempts > 0) ? (double) lookasideHit / (double) attempts : 0.0;
 }
 
-void wxSQLite3Database::SetUpdateHook(wxSQLite3Hook* updateHook)
+wxSQLite3GlobalStatus::wxSQLite3GlobalStatus()
+  : timestamp(0)
 {
-  CheckDatabase();
-  if (updateHook)
-  {
-    sqlite3_update_hook(m_db->m_db, (void(*)(void*,int,const char*,const char*, wxsqlite_int64)) wxSQLite3FunctionContext::ExecUpdateHook, updateHook);
-  }
-  else
-  {
-    sqlite3_update_hook(m_db->m_db, (void(*)(void*,int,const char*,const char*, wxsqlite_int64)) NULL, NULL);
-  }
 }
 
-void wxSQLite3Database::SetWriteAheadLogHook(wxSQLite3Hook* walHook)
+static void wxSQLite3StatusDelta(wxSQLite3StatusValue& delta, const wxSQLite3StatusValue& current, const wxSQLite3StatusValue& previous)
 {
-#if SQLITE_VERSION_NUMBER >= 3007000
-  CheckDatabase();
-  if (walHook)
-  {
-    walHook->SetDatabase(this);
-    sqlite3_wal_hook(m_db->m_db, (int(*)(void *,sqlite3*,const char*,int)) wxSQLite3FunctionContext::ExecWriteAheadLogHook, walHook);
-  }
-  else
-  {
-    sqlite3_wal_hook(m_db->m_db, (int(*)(void *,sqlite3*,const char*,int)) NULL, NULL);
-  }
-#else
-  wxUnusedVar(walHook);
-  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOWAL);
-#endif
+  delta.current = current.current - previous.current;
+  delta.highwater = current.highwater;
 }
 
-void wxSQLite3Database::WriteAheadLogCheckpoint(const wxString& database, int mode, 
-                                                int* logFrameCount, int* ckptFrameCount)
+wxSQLite3GlobalStatus wxSQLite3GlobalStatus::Delta(const wxSQLite3GlobalStatus& previous) const
 {
-#if SQLITE_VERSION_NUMBER >= 3007000
-  CheckDatabase();
-  wxCharBuffer strDatabase = database.ToUTF8();
-  const char* localDatabase = strDatabase;
-#if SQLITE_VERSION_NUMBER >= 3007006
-  int rc = sqlite3_wal_checkpoint_v2(m_db->m_db, localDatabase, mode, logFrameCount, ckptFrameCount);
-#else
-  int rc = sqlite3_wal_checkpoint(m_db->m_db, localDatabase);
-  if (logFrameCount  != NULL) *logFrameCount  = 0;
-  if (ckptFrameCount != NULL) *ckptFrameCount = 0;
-#endif
-
-  if (rc != SQLITE_OK)
-  {
-    const char* localError = sqlite3_errmsg(m_db->m_db);
-    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
-  }
-#else
-  wxUnusedVar(database);
-  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOWAL);
-#endif
+  wxSQLite3GlobalStatus delta;
+  delta.timestamp = timestamp - previous.timestamp;
+  wxSQLite3StatusDelta(delta.memoryUsed, memoryUsed, previous.memoryUsed);
+  wxSQLite3StatusDelta(delta.mallocCount, mallocCount, previous.mallocCount);
+  wxSQLite3StatusDelta(delta.mallocSize, mallocSize, previous.mallocSize);
+  wxSQLite3StatusDelta(delta.pageCacheUsed, pageCacheUsed, previous.pageCacheUsed);
+  wxSQLite3StatusDelta(delta.pageCacheOverflow, pageCacheOverflow, previous.pageCacheOverflow);
+  wxSQLite3StatusDelta(delta.pageCacheSize, pageCacheSize, previous.pageCacheSize);
+  wxSQLite3StatusDelta(delta.parserStack, parserStack, previous.parserStack);
+  return delta;
 }
 
-void wxSQLite3Database::AutoWriteAheadLogCheckpoint(int frameCount)
+// Query a status value of a database connection
+static void wxSQLite3GetDbStatus(sqlite3* db, int op, int resetFlag, wxsqlite_int64* current, wxsqlite_int64* highwater)
 {
-#if SQLITE_VERSION_NUMBER >= 3007000
-  CheckDatabase();
-  int rc = sqlite3_wal_autocheckpoint(m_db->m_db, frameCount);
-
-  if (rc != SQLITE_OK)
-  {
-    const char* localError = sqlite3_errmsg(m_db->m_db);
-    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
-  }
+#if SQLITE_VERSION_NUMBER >= 3051000
+  sqlite3_int64 localCurrent = 0;
+  sqlite3_int64 localHighwater = 0;
+  sqlite3_db_status64(db, op, &localCurrent, &localHighwater, resetFlag);
 #else
-  wxUnusedVar(frameCount);
-  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOWAL);
+  int localCurrent = 0;
+  int localHighwater = 0;
+  sqlite3_db_status(db, op, &localCurrent, &localHighwater, resetFlag);
 #endif
+  if (current != NULL) *current = localCurrent;
+  if (highwater != NULL) *highwater = localHighwater;
+}
+
+static void wxSQLite3GetDatabaseStatus(sqlite3* db, bool resetFlag, wxSQLite3DatabaseStatus& status)
+{
+  int reset = (resetFlag) ? 1 : 0;
+  status.timestamp = wxGetUTCTimeMillis();
+  wxSQLite3GetDbStatus(db, SQLITE_DBSTATUS_LOOKASIDE_USED, reset, &status.lookasideUsed.current, &status.lookasideUsed.highwater);
+  // The following counters report their values as high-water mark
+  wxSQLite3GetDbStatus(db, SQLITE_DBSTATUS_LOOKASIDE_HIT, reset, NULL, &status.lookasideHit);
+  wxSQLite3GetDbStatus(db, SQLITE_DBSTATUS_LOOKASIDE_MISS_SIZE, reset, NULL, &status.lookasideMissSize);
+  wxSQLite3GetDbStatus(db, SQLITE_DBSTATUS_LOOKASIDE_MISS_FULL, reset, NULL, &status.lookasideMissFull);
+  wxSQLite3GetDbStatus(db, SQLITE_DBSTATUS_CACHE_USED, 0, &status.cacheUsed, NULL);
+  wxSQLite3GetDbStatus(db, SQLITE_DBSTATUS_CACHE_USED_SHARED, 0, &status.cacheUsedShared, NULL);
+  wxSQLite3GetDbStatus(db, SQLITE_DBSTATUS_CACHE_HIT, reset, &status.cacheHit, NULL);
+  wxSQLite3GetDbStatus(db, SQLITE_DBSTATUS_CACHE_MISS, reset, &status.cacheMiss, NULL);
+  wxSQLite3GetDbStatus(db, SQLITE_DBSTATUS_CACHE_WRITE, reset, &status.cacheWrite, NULL);
+  wxSQLite3GetDbStatus(db, SQLITE_DBSTATUS_CACHE_SPILL, reset, &status.cacheSpill, NULL);
+#if defined(SQLITE_DBSTATUS_TEMPBUF_SPILL)
+  wxSQLite3GetDbStatus(db, SQLITE_DBSTATUS_TEMPBUF_SPILL, reset, &status.tempBufferSpill, NULL);
+#endif
+  wxSQLite3GetDbStatus(db, SQLITE_DBSTATUS_SCHEMA_USED, 0, &status.schemaUsed, NULL);
+  wxSQLite3GetDbStatus(db, SQLITE_DBSTATUS_STMT_USED, 0, &status.stmtUsed, NULL);
+  wxSQLite3GetDbStatus(db, SQLITE_DBSTATUS_DEFERRED_FKS, 0, &status.deferredForeignKeys, NULL);
 }
 
-void wxSQLite3Database::SetCollation(const wxString& collationName, wxSQLite3Collation* collation)
-{
-  CheckDatabase();
-  wxCharBuffer strCollationName = collationName.ToUTF8();
-  const char* localCollationName = strCollationName;
-  int rc;
-  if (collation)
-  {
-    rc = sqlite3_create_collation(m_db->m_db, localCollationName, SQLITE_UTF8, collation, (int(*)(void*,int,const void*,int,const void*)) wxSQLite3Database::ExecComparisonWithCollation);
-  }
-  else
-  {
-    rc = sqlite3_create_collation(m_db->m_db, localCollationName, SQLITE_UTF8, NULL, (int(*)(void*,int,const void*,int,const void*)) NULL);
-  }
-}
-
-void* wxSQLite3Database::GetDatabaseHandle() const
+static void wxSQLite3GetStatus(int op, int resetFlag, wxSQLite3StatusValue& value)
 {
-  return (m_db != NULL) ? m_db->m_db : NULL;
+  sqlite3_int64 current = 0;
+  sqlite3_int64 highwater = 0;
+  sqlite3_status64(op, &current, &highwater, resetFlag);
+  value.current = current;
+  value.highwater = highwater;
 }
 
-void wxSQLite3Database::SetCollationNeededCallback()
+wxSQLite3DatabaseStatus wxSQLite3Database::GetStatus(bool resetFlag)
 {
+  WXSQLITE3_PROFILE();
   CheckDatabase();
-  int rc = sqlite3_collation_needed(m_db->m_db, this, (void(*)(void*,sqlite3*,int,const char*)) wxSQLite3Database::ExecCollationNeeded);
-  if (rc != SQLITE_OK)
-  {
-    const char* localError = sqlite3_errmsg(m_db->m_db);
-    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
-  }
+  wxSQLite3DatabaseStatus status;
+  wxSQLite3GetDatabaseStatus(m_db->m_db, resetFlag, status);
+  return status;
 }
 
-void wxSQLite3Database::CheckDatabase() const
+/* static */
+wxSQLite3GlobalStatus wxSQLite3Database::GetGlobalStatus(bool resetFlag)
+{
+  WXSQLITE3_PROFILE();
+  int reset = (resetFlag) ? 1 : 0;
+  wxSQLite3GlobalStatus status;
+  status.timestamp = wxGetUTCTimeMillis();
+  wxSQLite3GetStatus(SQLITE_STATUS_MEMORY_USED, reset, status.memoryUsed);
+  wxSQLite3GetStatus(SQLITE_STATUS_MALLOC_COUNT, reset, status.mallocCount);
+  wxSQLite3GetStatus(SQLITE_STATUS_MALLOC_SIZE, reset, status.mallocSize);
+  wxSQLite3GetStatus(SQLITE_STATUS_PAGECACHE_USED, reset, status.pageCacheUsed);
+  wxSQLite3GetStatus(SQLITE_STATUS_PAGECACHE_OVERFLOW, reset, status.pageCacheOverflow);
+  wxSQLite3GetStatus(SQLITE_STATUS_PAGECACHE_SIZE, reset, status.pageCacheSize);
+  wxSQLite3GetStatus(SQLITE_STATUS_PARSER_STACK, reset, status.parserStack);
+  return status;
+}
+
+#if WXSQLITE3_PROFILE_WRAPPER
+
+/// Snapshot of the counters of a wrapper entry point (internal)
+struct wxSQLite3ProfileRow
+{
+  const char* name;
+  wxUint64    calls;
+  wxUint64    inclusive;
+  wxUint64    sqlite;
+
+  wxUint64 Wrapper() const { return (inclusive > sqlite) ? inclusive - sqlite : 0; }
+  bool operator<(const wxSQLite3ProfileRow& other) const { return Wrapper() > other.Wrapper(); }
+};
+
+// Strip the return type (and calling convention) from a function signature
+static const char* wxSQLite3ProfileName(const char* signature)
 {
-  if (m_db == NULL || m_db->m_db == NULL || !m_db->m_isValid || !m_isOpen)
+  const char* paren = strchr(signature, '(');
+  const char* name = signature;
+  for (const char* p = signature; p != paren && *p != '\0'; ++p)
   {
-    throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NODB);
+    if (*p == ' ')
+    {
+      name = p + 1;
+    }
   }
+  return name;
 }
 
-void* wxSQLite3Database::Prepare(const char* sql)
-{
-  CheckDatabase();
-
-  const char* tail=0;
-  sqlite3_stmt* stmt;
+#endif
 
-  int rc = sqlite3_prepare_v2(m_db->m_db, sql, -1, &stmt, &tail);
+/* static */
+wxString wxSQLite3Database::GetWrapperProfile(bool resetFlag)
+{
+#if WXSQLITE3_PROFILE_WRAPPER
+  std::vector<wxSQLite3ProfileRow> rows;
+  for (wxSQLite3ProfileEntry* entry = gs_profileEntries.load(); entry != NULL; entry = entry->m_next)
+  {
+    wxSQLite3ProfileRow row;
+    row.name = entry->m_name;
+    if (resetFlag)
+    {
+      row.calls = entry->m_calls.exchange(0);
+      row.inclusive = entry->m_inclusive.exchange(0);
+      row.sqlite = entry->m_sqlite.exchange(0);
+    }
+    else
+    {
+      row.calls = entry->m_calls.load();
+      row.inclusive = entry->m_inclusive.load();
+      row.sqlite = entry->m_sqlite.load();
+    }
+    if (row.calls > 0)
+    {
+      rows.push_back(row);
+    }
+  }
+  std::stable_sort(rows.begin(), rows.end());
 
-  if (rc != SQLITE_OK)
+  sqlite3_str* out = sqlite3_str_new(NULL);
+  sqlite3_str_appendf(out, "wxSQLite3 wrapper profile (time in %s)\n", wxSQLite3ProfileUnit());
+  sqlite3_str_appendf(out, "%12s %16s %16s %16s %12s  %s\n",
+                      "Calls", "Inclusive", "SQLite", "Wrapper", "Wrapper/call", "Entry point");
+  for (size_t j = 0; j < rows.size(); ++j)
   {
-    const char* localError = sqlite3_errmsg(m_db->m_db);
-    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+    const wxSQLite3ProfileRow& row = rows[j];
+    sqlite3_str_appendf(out, "%12llu %16llu %16llu %16llu %12.1f  %s\n",
+                        (sqlite3_uint64) row.calls, (sqlite3_uint64) row.inclusive,
+                        (sqlite3_uint64) row.sqlite, (sqlite3_uint64) row.Wrapper(),
+                        (double) row.Wrapper() / (double) row.calls, wxSQLite3ProfileName(row.name));
   }
-
-  return stmt;
+  return wxSQLite3FinishString(out);
+#else
+  wxUnusedVar(resetFlag);
+  return wxEmptyString;
+#endif
 }
 
-void* wxSQLite3Database::PreparePersistent(const char* sql)
+#if wxUSE_THREADS
+
+/// Thread taking the samples of a status sampler (internal)
+class wxSQLite3StatusSamplerThread : public wxThread
 {
-#if SQLITE_VERSION_NUMBER >= 3020000
-  CheckDatabase();
+public:
+  wxSQLite3StatusSamplerThread(wxSQLite3StatusSink* sink, wxSQLite3DatabaseReference* db, unsigned int interval)
+    : wxThread(wxTHREAD_JOINABLE), m_sink(sink), m_db(db), m_interval(interval), m_stop(false), m_condition(m_mutex)
+  {
+  }
 
-  const char* tail = 0;
-  sqlite3_stmt* stmt;
+  /// Request the thread to terminate
+  void RequestStop()
+  {
+    wxMutexLocker lock(m_mutex);
+    m_stop = true;
+    m_condition.Signal();
+  }
 
-  int rc = sqlite3_prepare_v3(m_db->m_db, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, &tail);
+  /// Take a sample
+  void TakeSample(wxSQLite3StatusSample& sample)
+  {
+    sample.hasDatabase = (m_db != NULL && m_db->m_isValid);
+    if (sample.hasDatabase)
+    {
+      wxSQLite3GetDatabaseStatus(m_db->m_db, false, sample.database);
+    }
+    sample.global = wxSQLite3Database::GetGlobalStatus(false);
+  }
 
-  if (rc != SQLITE_OK)
+  virtual ExitCode Entry()
   {
-    const char* localError = sqlite3_errmsg(m_db->m_db);
-    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+    wxSQLite3StatusSample previous;
+    TakeSample(previous);
+    m_mutex.Lock();
+    while (!m_stop)
+    {
+      // Wait for the end of the interval, ignoring spurious wakeups
+      wxLongLong deadline = wxGetUTCTimeMillis() + (long) m_interval;
+      wxLongLong now = wxGetUTCTimeMillis();
+      while (!m_stop && now < deadline)
+      {
+        m_condition.WaitTimeout((unsigned long) (deadline - now).GetValue());
+        now = wxGetUTCTimeMillis();
+      }
+      if (m_stop)
+      {
+        break;
+      }
+      m_mutex.Unlock();
+
+      wxSQLite3StatusSample sample;
+      TakeSample(sample);
+      if (sample.hasDatabase && previous.hasDatabase)
+      {
+        sample.databaseDelta = sample.database.Delta(previous.database);
+      }
+      sample.globalDelta = sample.global.Delta(previous.global);
+      try
+      {
+        m_sink->OnStatusSample(sample);
+      }
+      catch (...)
+      {
+        // Exceptions must not terminate the sampler thread
+      }
+      previous = sample;
+
+      m_mutex.Lock();
+    }
+    m_mutex.Unlock();
+    return 0;
   }
 
-  return stmt;
-#else
-  return Prepare(sql);
+private:
+  friend class wxSQLite3StatusSampler;
+
+  wxSQLite3StatusSink*        m_sink;      ///< Sink receiving the samples
+  wxSQLite3DatabaseReference* m_db;        ///< Sampled database connection
+  unsigned int                m_interval;  ///< Sampling interval in milliseconds
+  bool                        m_stop;      ///< Flag whether the thread should terminate
+  wxMutex                     m_mutex;     ///< Mutex guarding the stop flag
+  wxCondition                 m_condition; ///< Condition signalling a stop request
+};
+
 #endif
-}
 
-/* static */
-int wxSQLite3Database::ExecComparisonWithCollation(void* collation,
-                                                   int len1, const void* text1,
-                                                   int len2, const void* text2)
+wxSQLite3StatusSampler::wxSQLite3StatusSampler(wxSQLite3StatusSink* sink)
+  : m_sink(sink), m_thread(NULL)
 {
-  wxString locText1 = wxString::FromUTF8((const char*) text1, (size_t) len1);
-  wxString locText2 = wxString::FromUTF8((const char*) text2, (size_t) len2);
-  return ((wxSQLite3Collation*) collation)->Compare(locText1, locText2);
 }
 
-void wxSQLite3Database::ExecCollationNeeded(void* db, void*, int, const char* collationName)
+wxSQLite3StatusSampler::~wxSQLite3StatusSampler()
 {
-  wxString locCollation = wxString::FromUTF8((const char*) collationName);
-  ((wxSQLite3Database*) db)->SetNeededCollation(locCollation);
+  Stop();
 }
 
-void wxSQLite3Database::GetMetaData(const wxString& databaseName, const wxString& tableName, const wxString& columnName,
-                                    wxString* dataType, wxString* collation, bool* notNull, bool* primaryKey, bool* autoIncrement)
+bool wxSQLite3StatusSampler::Start(wxSQLite3Database* db, unsigned int interval)
 {
-#if SQLITE_ENABLE_COLUMN_METADATA
-  CheckDatabase();
-  wxCharBuffer strDatabaseName = databaseName.ToUTF8();
-  const char* localDatabaseName = strDatabaseName;
-  if (databaseName == wxEmptyString) localDatabaseName = NULL;
-  wxCharBuffer strTableName = tableName.ToUTF8();
-  const char* localTableName = strTableName;
-  wxCharBuffer strColumnName = columnName.ToUTF8();
-  const char* localColumnName = strColumnName;
-  const char* localDataType;
-  const char* localCollation;
-  int localNotNull;
-  int localPrimaryKey;
-  int localAutoIncrement;
-  int rc = sqlite3_table_column_metadata(m_db->m_db, localDatabaseName, localTableName, localColumnName,
-                                         &localDataType, &localCollation, &localNotNull, &localPrimaryKey, &localAutoIncrement);
-
-  if (rc != SQLITE_OK)
+#if wxUSE_THREADS
+  if (m_thread != NULL || m_sink == NULL)
   {
-    const char* localError = sqlite3_errmsg(m_db->m_db);
-    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+    return false;
   }
-
-  if (dataType      != NULL) *dataType      = wxString::FromUTF8(localDataType);
-  if (collation     != NULL) *collation     = wxString::FromUTF8(localCollation);
-
-  if (notNull       != NULL) *notNull       = (localNotNull       != 0);
-  if (primaryKey    != NULL) *primaryKey    = (localPrimaryKey    != 0);
-  if (autoIncrement != NULL) *autoIncrement = (localAutoIncrement != 0);
-#else
-  wxUnusedVar(databaseName);
-  wxUnusedVar(tableName);
-  wxUnusedVar(columnName);
-  wxUnusedVar(dataType);
-  wxUnusedVar(collation);
-  wxUnusedVar(notNull);
-  wxUnusedVar(primaryKey);
-  wxUnusedVar(autoIncrement);
-  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOMETADATA);
-#endif
-}
-
-void wxSQLite3Database::LoadExtension(const wxString& fileName, const wxString& entryPoint)
-{
-#if WXSQLITE3_HAVE_LOAD_EXTENSION
-  CheckDatabase();
-  wxCharBuffer strFileName = fileName.ToUTF8();
-  const char* localFileName = strFileName;
-  wxCharBuffer strEntryPoint = entryPoint.ToUTF8();
-  const char* localEntryPoint = strEntryPoint;
-
-  int rc = sqlite3_load_extension(m_db->m_db, localFileName, localEntryPoint, NULL);
-  if (rc != SQLITE_OK)
+  wxSQLite3DatabaseReference* dbRef = NULL;
+  if (db != NULL)
   {
-    const char* localError = sqlite3_errmsg(m_db->m_db);
-    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+    db->CheckDatabase();
+    dbRef = db->m_db;
+    // Keep the connection alive while the sampler is running
+    dbRef->IncrementRefCount();
+  }
+  m_thread = new wxSQLite3StatusSamplerThread(m_sink, dbRef, (interval > 0) ? interval : 1);
+  if (m_thread->Run() != wxTHREAD_NO_ERROR)
+  {
+    delete m_thread;
+    m_thread = NULL;
+    if (dbRef != NULL)
+    {
+      dbRef->DecrementRefCount();
+    }
+    return false;
   }
+  return true;
 #else
-  wxUnusedVar(fileName);
-  wxUnusedVar(entryPoint);
-  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOLOADEXT);
+  wxUnusedVar(db);
+  wxUnusedVar(interval);
+  return false;
 #endif
 }
 
-void wxSQLite3Database::EnableLoadExtension(bool enable)
+void wxSQLite3StatusSampler::Stop()
 {
-#if WXSQLITE3_HAVE_LOAD_EXTENSION
-  CheckDatabase();
-  int onoff = (enable) ? 1 : 0;
-  int rc = sqlite3_enable_load_extension(m_db->m_db, onoff);
-  if (rc != SQLITE_OK)
+#if wxUSE_THREADS
+  if (m_thread == NULL)
   {
-    const char* localError = sqlite3_errmsg(m_db->m_db);
-    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+    return;
+  }
+  m_thread->RequestStop();
+  m_thread->Wait();
+  wxSQLite3DatabaseReference* dbRef = m_thread->m_db;
+  delete m_thread;
+  m_thread = NULL;
+  if (dbRef != NULL && dbRef->DecrementRefCount() == 0)
+  {
+    if (dbRef->m_isValid)
+    {
+      sqlite3_close(dbRef->m_db);
+    }
+    delete dbRef;
   }
-#else
-  wxUnusedVar(enable);
-  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOLOADEXT);
 #endif
 }
 
-void wxSQLite3Database::ReKey(const wxString& newKey)
+bool wxSQLite3StatusSampler::IsRunning() const
 {
-  ReKey(wxSQLite3Cipher(), newKey);
+  return m_thread != NULL;
 }
 
-void wxSQLite3Database::ReKey(const wxSQLite3Cipher& cipher, const wxString& newKey)
+// --- Sketch aggregate functions
+
+/// Hash a function argument for the sketches, returns false for NULL (internal)
+/**
+* Integral floating point values are hashed like integers, so that values comparing
+* equal in SQL have the same hash. Text and blobs are hashed with different seeds.
+*/
+static bool wxSQLite3SketchHashValue(wxSQLite3FunctionContext& ctx, int argIndex, sqlite3_uint64& hash)
 {
-  wxCharBuffer strLocalNewKey = newKey.ToUTF8();
-  const char* localNewKey = strLocalNewKey;
-  wxMemoryBuffer binaryNewKey;
-  if (newKey.Length() > 0)
+  unsigned char buffer[8];
+  switch (ctx.GetArgType(argIndex))
   {
-    binaryNewKey.AppendData((void*) localNewKey, strlen(localNewKey));
+    case WXSQLITE_INTEGER:
+      wxSQLite3WriteLE64(buffer, (sqlite3_uint64) ctx.GetInt64(argIndex).GetValue());
+      hash = wxSQLite3XXH64(buffer, 8, 0);
+      return true;
+    case WXSQLITE_FLOAT:
+      {
+        double value = ctx.GetDouble(argIndex);
+        if (value == floor(value) && value >= -9223372036854775808.0 && value < 9223372036854775808.0)
+        {
+          wxSQLite3WriteLE64(buffer, (sqlite3_uint64) (sqlite3_int64) value);
+          hash = wxSQLite3XXH64(buffer, 8, 0);
+        }
+        else
+        {
+          wxSQLite3WriteLEDouble(buffer, value);
+          hash = wxSQLite3XXH64(buffer, 8, 1);
+        }
+      }
+      return true;
+    case WXSQLITE_TEXT:
+      {
+        int len;
+        const char* text = ctx.GetText(argIndex, len);
+        hash = wxSQLite3XXH64(text, (size_t) len, 2);
+      }
+      return true;
+    case WXSQLITE_BLOB:
+      {
+        int len;
+        const unsigned char* blob = ctx.GetBlob(argIndex, len);
+        hash = wxSQLite3XXH64(blob, (size_t) len, 3);
+      }
+      return true;
+    default:
+      return false;
   }
-  ReKey(cipher, binaryNewKey);
 }
 
-void wxSQLite3Database::ReKey(const wxMemoryBuffer& newKey)
+static inline int wxSQLite3CountLeadingZeros64(sqlite3_uint64 x)
 {
-  ReKey(wxSQLite3Cipher(), newKey);
+#if defined(__GNUC__)
+  return __builtin_clzll(x);
+#else
+  int n = 0;
+  while ((x & (((sqlite3_uint64) 1) << 63)) == 0)
+  {
+    x <<= 1;
+    ++n;
+  }
+  return n;
+#endif
 }
 
-void wxSQLite3Database::ReKey(const wxSQLite3Cipher& cipher, const wxMemoryBuffer& newKey)
+static const int gs_hllDefaultPrecision = 12;
+static const int gs_hllMinPrecision = 4;
+static const int gs_hllMaxPrecision = 18;
+static const int gs_hllHeaderSize = 4;
+
+/// HyperLogLog sketch for estimating the number of distinct values (internal)
+/**
+* The sketch is stored in its serialized form: 'H', 'L', version 1 and the precision p,
+* followed by 2^p registers of one byte each.
+*/
+class wxSQLite3HyperLogLog
 {
-  CheckDatabase();
-  if (cipher.IsOk())
+public:
+  wxSQLite3HyperLogLog()
+    : m_data(NULL), m_precision(0)
   {
-    if (!cipher.Apply(m_db->m_db))
+  }
+
+  ~wxSQLite3HyperLogLog()
+  {
+    sqlite3_free(m_data);
+  }
+
+  static bool IsValid(const unsigned char* data, int len)
+  {
+    return data != NULL && len > gs_hllHeaderSize &&
+           data[0] == 'H' && data[1] == 'L' && data[2] == 1 &&
+           data[3] >= gs_hllMinPrecision && data[3] <= gs_hllMaxPrecision &&
+           len == gs_hllHeaderSize + (1 << data[3]);
+  }
+
+  static int GetPrecision(const unsigned char* data) { return data[3]; }
+
+  bool IsEmpty() const { return m_data == NULL; }
+  int GetPrecision() const { return m_precision; }
+  unsigned char* GetData() const { return m_data; }
+  int GetSize() const { return gs_hllHeaderSize + (1 << m_precision); }
+
+  bool Create(int precision)
+  {
+    m_precision = precision;
+    m_data = (unsigned char*) sqlite3_malloc(GetSize());
+    if (m_data == NULL)
     {
-      throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_CIPHER_APPLY_FAILED);
+      return false;
     }
+    memset(m_data, 0, GetSize());
+    m_data[0] = 'H';
+    m_data[1] = 'L';
+    m_data[2] = 1;
+    m_data[3] = (unsigned char) precision;
+    return true;
   }
-  int rc = sqlite3_rekey(m_db->m_db, newKey.GetData(), (int) newKey.GetDataLen());
-  if (rc != SQLITE_OK)
+
+  void Add(sqlite3_uint64 hash)
   {
-    const char* localError = sqlite3_errmsg(m_db->m_db);
-    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+    // The first p bits select the register, the sentinel bit bounds the rank
+    unsigned int index = (unsigned int) (hash >> (64 - m_precision));
+    sqlite3_uint64 rest = (hash << m_precision) | (((sqlite3_uint64) 1) << (m_precision - 1));
+    unsigned char rank = (unsigned char) (wxSQLite3CountLeadingZeros64(rest) + 1);
+    unsigned char* registers = m_data + gs_hllHeaderSize;
+    if (rank > registers[index])
+    {
+      registers[index] = rank;
+    }
   }
-}
 
-wxString wxSQLite3Database::GetKeySalt(const wxString& schemaName) const
-{
-  wxString keySalt = wxEmptyString;
-  if (IsOpen())
+  /// Merge a valid serialized sketch of the same precision
+  bool Merge(const unsigned char* data)
   {
-    const char* localSchemaName = NULL;
-    wxCharBuffer strSchema = schemaName.ToUTF8();
-    if (!schemaName.IsEmpty())
+    if (m_data == NULL && !Create(GetPrecision(data)))
     {
-      localSchemaName = strSchema;
+      return false;
     }
-    char* localKeySalt = (char*) sqlite3mc_codec_data(m_db->m_db, localSchemaName, "cipher_salt");
-    if (localKeySalt != NULL)
+    int count = 1 << m_precision;
+    unsigned char* registers = m_data + gs_hllHeaderSize;
+    const unsigned char* otherRegisters = data + gs_hllHeaderSize;
+    int j;
+    for (j = 0; j < count; ++j)
     {
-      keySalt = wxString::FromUTF8(localKeySalt);
-      sqlite3_free(localKeySalt);
+      if (otherRegisters[j] > registers[j])
+      {
+        registers[j] = otherRegisters[j];
+      }
     }
+    return true;
   }
-  return keySalt;
-}
 
-bool wxSQLite3Database::UserLogin(const wxString& username, const wxString& password)
-{
-  wxUnusedVar(username);
-  wxUnusedVar(password);
-  return true;
-}
+  /// Estimate the number of distinct values of a valid serialized sketch
+  static double Estimate(const unsigned char* data)
+  {
+    int count = 1 << GetPrecision(data);
+    const unsigned char* registers = data + gs_hllHeaderSize;
+    double sum = 0.0;
+    int zeros = 0;
+    int j;
+    for (j = 0; j < count; ++j)
+    {
+      sum += ldexp(1.0, -(int) registers[j]);
+      if (registers[j] == 0)
+      {
+        ++zeros;
+      }
+    }
+    double m = (double) count;
+    double alpha = (count == 16) ? 0.673 : (count == 32) ? 0.697 : (count == 64) ? 0.709 : 0.7213 / (1.0 + 1.079 / m);
+    double estimate = alpha * m * m / sum;
+    if (estimate <= 2.5 * m && zeros > 0)
+    {
+      // Linear counting for small cardinalities
+      estimate = m * log(m / (double) zeros);
+    }
+    return estimate;
+  }
 
-bool wxSQLite3Database::UserAdd(const wxString& username, const wxString& password, bool isAdmin)
-{
-  wxUnusedVar(username);
-  wxUnusedVar(password);
-  wxUnusedVar(isAdmin);
-  return true;
-}
+private:
+  unsigned char* m_data;      ///< Serialized sketch
+  int            m_precision; ///< Precision (number of index bits)
+};
 
-bool wxSQLite3Database::UserChange(const wxString& username, const wxString& password, bool isAdmin)
+static const wxUint32 gs_cmsDefaultWidth = 1024;
+static const wxUint32 gs_cmsDefaultDepth = 4;
+static const wxUint32 gs_cmsMaxWidth = 1048576;
+static const wxUint32 gs_cmsMaxDepth = 32;
+static const int gs_cmsHeaderSize = 20;
+
+/// Count-min sketch for estimating value frequencies (internal)
+/**
+* Serialized as 'C', 'M', version 1, 0, width (4 bytes), depth (4 bytes), total count
+* (8 bytes), followed by depth rows of width counters (8 bytes each), all in little endian
+* byte order. The positions of a value in the rows are derived from one 64-bit hash
+* by double hashing.
+*/
+class wxSQLite3CountMinSketch
 {
-  wxUnusedVar(username);
-  wxUnusedVar(password);
-  wxUnusedVar(isAdmin);
-  return false;
-}
+public:
+  wxSQLite3CountMinSketch()
+    : m_counters(NULL), m_width(0), m_depth(0), m_total(0)
+  {
+  }
+
+  ~wxSQLite3CountMinSketch()
+  {
+    sqlite3_free(m_counters);
+  }
+
+  static bool IsValid(const unsigned char* data, int len)
+  {
+    if (data == NULL || len < gs_cmsHeaderSize ||
+        data[0] != 'C' || data[1] != 'M' || data[2] != 1 || data[3] != 0)
+    {
+      return false;
+    }
+    wxUint32 width = GetWidth(data);
+    wxUint32 depth = GetDepth(data);
+    return width >= 1 && width <= gs_cmsMaxWidth && depth >= 1 && depth <= gs_cmsMaxDepth &&
+           (sqlite3_uint64) len == gs_cmsHeaderSize + (sqlite3_uint64) width * depth * 8;
+  }
 
-bool wxSQLite3Database::UserDelete(const wxString& username)
-{
-  wxUnusedVar(username);
-  return false;
-}
+  static wxUint32 GetWidth(const unsigned char* data) { return wxSQLite3ReadLE32(data + 4); }
+  static wxUint32 GetDepth(const unsigned char* data) { return wxSQLite3ReadLE32(data + 8); }
 
-bool wxSQLite3Database::UserIsPrivileged(const wxString& username)
-{
-  wxUnusedVar(username);
-  return false;
-}
+  bool IsEmpty() const { return m_counters == NULL; }
+  wxUint32 GetWidth() const { return m_width; }
+  wxUint32 GetDepth() const { return m_depth; }
 
-void wxSQLite3Database::GetUserList(wxArrayString& userList)
-{
-  userList.Empty();
-}
+  bool Create(wxUint32 width, wxUint32 depth)
+  {
+    sqlite3_uint64 size = (sqlite3_uint64) width * depth * sizeof(sqlite3_uint64);
+    m_counters = (sqlite3_uint64*) sqlite3_malloc64(size);
+    if (m_counters == NULL)
+    {
+      return false;
+    }
+    memset(m_counters, 0, (size_t) size);
+    m_width = width;
+    m_depth = depth;
+    m_total = 0;
+    return true;
+  }
 
-int wxSQLite3Database::GetLimit(wxSQLite3LimitType id) const
-{
-  int value = -1;
-  CheckDatabase();
-  if (id >= WXSQLITE_LIMIT_LENGTH && id <= WXSQLITE_LIMIT_WORKER_THREADS)
+  static wxUint32 GetPosition(sqlite3_uint64 hash, wxUint32 row, wxUint32 width)
   {
-    value = sqlite3_limit(m_db->m_db, id, -1);
+    sqlite3_uint64 h1 = (wxUint32) hash;
+    sqlite3_uint64 h2 = (wxUint32) (hash >> 32);
+    return (wxUint32) ((h1 + row * h2) % width);
   }
-  return value;
-}
 
-int wxSQLite3Database::SetLimit(wxSQLite3LimitType id, int newValue)
-{
-  int value = -1;
-  CheckDatabase();
-  if (id >= WXSQLITE_LIMIT_LENGTH && id <= WXSQLITE_LIMIT_WORKER_THREADS)
+  void Add(sqlite3_uint64 hash)
   {
-    value = sqlite3_limit(m_db->m_db, id, newValue);
+    wxUint32 row;
+    for (row = 0; row < m_depth; ++row)
+    {
+      m_counters[(size_t) row * m_width + GetPosition(hash, row, m_width)]++;
+    }
+    m_total++;
   }
-  return value;
-}
 
-void wxSQLite3Database::ReleaseMemory()
-{
-  CheckDatabase();
-  int rc = sqlite3_db_release_memory(m_db->m_db);
-  if (rc != SQLITE_OK)
+  /// Merge a valid serialized sketch of the same dimensions
+  bool Merge(const unsigned char* data)
   {
-    const char* localError = sqlite3_errmsg(m_db->m_db);
-    throw wxSQLite3Exception(rc, wxString::FromUTF8(localError));
+    if (m_counters == NULL && !Create(GetWidth(data), GetDepth(data)))
+    {
+      return false;
+    }
+    size_t count = (size_t) m_width * m_depth;
+    const unsigned char* p = data + gs_cmsHeaderSize;
+    size_t j;
+    for (j = 0; j < count; ++j, p += 8)
+    {
+      m_counters[j] += wxSQLite3ReadLE64(p);
+    }
+    m_total += wxSQLite3ReadLE64(data + 12);
+    return true;
   }
-}
 
-int wxSQLite3Database::GetSystemErrorCode() const
-{
-  int rc = 0;
-  if (m_db != NULL)
+  void Serialize(wxMemoryBuffer& buffer) const
   {
-    rc = sqlite3_system_errno(m_db->m_db);
+    size_t count = (size_t) m_width * m_depth;
+    size_t len = gs_cmsHeaderSize + count * 8;
+    unsigned char* data = (unsigned char*) buffer.GetWriteBuf(len);
+    data[0] = 'C';
+    data[1] = 'M';
+    data[2] = 1;
+    data[3] = 0;
+    wxSQLite3WriteLE32(data + 4, m_width);
+    wxSQLite3WriteLE32(data + 8, m_depth);
+    wxSQLite3WriteLE64(data + 12, m_total);
+    unsigned char* p = data + gs_cmsHeaderSize;
+    size_t j;
+    for (j = 0; j < count; ++j, p += 8)
+    {
+      wxSQLite3WriteLE64(p, m_counters[j]);
+    }
+    buffer.UngetWriteBuf(len);
   }
-  return rc;
-}
 
-#if wxCHECK_VERSION(2,9,0)
-static const wxStringCharType* limitCodeString[] =
-#else
-static const wxChar* limitCodeString[] =
-#endif
-{ wxS("SQLITE_LIMIT_LENGTH"),              wxS("SQLITE_LIMIT_SQL_LENGTH"),
-  wxS("SQLITE_LIMIT_COLUMN"),              wxS("SQLITE_LIMIT_EXPR_DEPTH"),
-  wxS("SQLITE_LIMIT_COMPOUND_SELECT"),     wxS("SQLITE_LIMIT_VDBE_OP"),
-  wxS("SQLITE_LIMIT_FUNCTION_ARG"),        wxS("SQLITE_LIMIT_ATTACHED"),
-  wxS("SQLITE_LIMIT_LIKE_PATTERN_LENGTH"), wxS("SQLITE_LIMIT_VARIABLE_NUMBER"),
-  wxS("SQLITE_LIMIT_TRIGGER_DEPTH"),       wxS("SQLITE_LIMIT_WORKER_THREADS")
+  /// Estimate the frequency of a value in a valid serialized sketch
+  static sqlite3_uint64 Estimate(const unsigned char* data, sqlite3_uint64 hash)
+  {
+    wxUint32 width = GetWidth(data);
+    wxUint32 depth = GetDepth(data);
+    const unsigned char* counters = data + gs_cmsHeaderSize;
+    sqlite3_uint64 estimate = 0;
+    wxUint32 row;
+    for (row = 0; row < depth; ++row)
+    {
+      size_t index = (size_t) row * width + GetPosition(hash, row, width);
+      sqlite3_uint64 count = wxSQLite3ReadLE64(counters + 8 * index);
+      if (row == 0 || count < estimate)
+      {
+        estimate = count;
+      }
+    }
+    return estimate;
+  }
+
+private:
+  sqlite3_uint64* m_counters; ///< Counters, row by row
+  wxUint32        m_width;    ///< Number of counters per row
+  wxUint32        m_depth;    ///< Number of rows
+  sqlite3_uint64  m_total;    ///< Total number of counted values
 };
 
+static const double gs_tdigestDefaultCompression = 100.0;
+static const int gs_tdigestHeaderSize = 32;
 
-/* static */
-wxString wxSQLite3Database::LimitTypeToString(wxSQLite3LimitType type)
+/// Check a serialized t-digest (internal)
+/**
+* Serialized as 'T', 'D', version 1, 0, compression, minimum and maximum (8 byte doubles),
+* number of centroids (4 bytes), followed by mean and weight of each centroid (8 byte
+* doubles), all in little endian byte order.
+*/
+static bool wxSQLite3TDigestIsValid(const unsigned char* data, int len)
 {
-  wxString limitString(wxS("Unknown"));
-  if (type >= WXSQLITE_LIMIT_LENGTH && type <= WXSQLITE_LIMIT_WORKER_THREADS)
+  if (data == NULL || len < gs_tdigestHeaderSize ||
+      data[0] != 'T' || data[1] != 'D' || data[2] != 1 || data[3] != 0)
   {
-    limitString = limitCodeString[type];
+    return false;
   }
-  return limitString;
-}
-
-/* static */
-void wxSQLite3Database::InitializeSQLite()
-{
-  int rc = sqlite3_initialize();
-  if (rc != SQLITE_OK)
+  double compression = wxSQLite3ReadLEDouble(data + 4);
+  wxUint32 count = wxSQLite3ReadLE32(data + 28);
+  if (!(compression >= 10.0 && compression <= 10000.0) ||
+      (sqlite3_uint64) len != gs_tdigestHeaderSize + (sqlite3_uint64) count * 16)
   {
-    throw wxSQLite3Exception(rc, wxERRMSG_INITIALIZE);
+    return false;
+  }
+  const unsigned char* p = data + gs_tdigestHeaderSize;
+  wxUint32 j;
+  for (j = 0; j < count; ++j, p += 16)
+  {
+    if (!(wxSQLite3ReadLEDouble(p + 8) > 0.0))
+    {
+      return false;
+    }
   }
+  return true;
 }
 
-/* static */
-void wxSQLite3Database::InitializeSQLite(const wxSQLite3Logger& logger)
+/// Merge a valid serialized t-digest into a digest, which is created if necessary (internal)
+static bool wxSQLite3TDigestMergeData(wxSQLite3TDigest*& digest, const unsigned char* data)
 {
-  int rc = sqlite3_config(SQLITE_CONFIG_LOG, wxSQLite3Logger::ExecLoggerHook, &logger);
-  if (rc == SQLITE_OK)
+  if (digest == NULL)
   {
-    InitializeSQLite();
+    digest = new wxSQLite3TDigest(wxSQLite3ReadLEDouble(data + 4));
   }
-  else
+  wxUint32 count = wxSQLite3ReadLE32(data + 28);
+  const unsigned char* p = data + gs_tdigestHeaderSize;
+  wxUint32 j;
+  for (j = 0; j < count; ++j, p += 16)
   {
-    throw wxSQLite3Exception(rc, wxERRMSG_INITIALIZE);
+    if (!digest->Add(wxSQLite3ReadLEDouble(p), wxSQLite3ReadLEDouble(p + 8)))
+    {
+      return false;
+    }
   }
+  digest->ExtendRange(wxSQLite3ReadLEDouble(data + 12), wxSQLite3ReadLEDouble(data + 20));
+  return true;
 }
 
-/* static */
-void wxSQLite3Database::ShutdownSQLite()
-{
-  int rc = sqlite3_shutdown();
-  if (rc != SQLITE_OK)
+/// Serialize a t-digest (internal)
+static void wxSQLite3TDigestSerialize(wxSQLite3TDigest& digest, wxMemoryBuffer& buffer)
+{
+  int count = digest.GetCentroidCount();
+  const wxSQLite3TDigest::Centroid* centroids = digest.GetCentroids();
+  size_t len = gs_tdigestHeaderSize + (size_t) count * 16;
+  unsigned char* data = (unsigned char*) buffer.GetWriteBuf(len);
+  data[0] = 'T';
+  data[1] = 'D';
+  data[2] = 1;
+  data[3] = 0;
+  wxSQLite3WriteLEDouble(data + 4, digest.GetCompression());
+  wxSQLite3WriteLEDouble(data + 12, digest.GetMin());
+  wxSQLite3WriteLEDouble(data + 20, digest.GetMax());
+  wxSQLite3WriteLE32(data + 28, (wxUint32) count);
+  unsigned char* p = data + gs_tdigestHeaderSize;
+  int j;
+  for (j = 0; j < count; ++j, p += 16)
+  {
+    wxSQLite3WriteLEDouble(p, centroids[j].m_mean);
+    wxSQLite3WriteLEDouble(p + 8, centroids[j].m_weight);
+  }
+  buffer.UngetWriteBuf(len);
+}
+
+static const wxChar* gs_errHllInvalid = wxS("invalid HyperLogLog sketch");
+static const wxChar* gs_errHllIncompatible = wxS("HyperLogLog sketches of different precision can not be merged");
+static const wxChar* gs_errHllPrecision = wxS("HyperLogLog precision must be an integer between 4 and 18");
+static const wxChar* gs_errCmsInvalid = wxS("invalid count-min sketch");
+static const wxChar* gs_errCmsIncompatible = wxS("count-min sketches of different dimensions can not be merged");
+static const wxChar* gs_errCmsDimensions = wxS("count-min width must be between 1 and 1048576, depth between 1 and 32");
+static const wxChar* gs_errTDigestInvalid = wxS("invalid t-digest");
+static const wxChar* gs_errTDigestCompression = wxS("t-digest compression must be a number between 10 and 10000");
+static const wxChar* gs_errSketchNoMem = wxS("out of memory");
+
+static bool wxSQLite3HyperLogLogMerge(wxSQLite3FunctionContext& ctx, int argIndex, wxSQLite3HyperLogLog& sketch)
+{
+  int len;
+  const unsigned char* data = ctx.GetBlob(argIndex, len);
+  if (!wxSQLite3HyperLogLog::IsValid(data, len))
+  {
+    ctx.SetResultError(gs_errHllInvalid);
+    return false;
+  }
+  if (!sketch.IsEmpty() && sketch.GetPrecision() != wxSQLite3HyperLogLog::GetPrecision(data))
   {
-    throw wxSQLite3Exception(rc, wxERRMSG_SHUTDOWN);
+    ctx.SetResultError(gs_errHllIncompatible);
+    return false;
+  }
+  if (!sketch.Merge(data))
+  {
+    ctx.SetResultError(gs_errSketchNoMem);
+    return false;
   }
+  return true;
 }
 
-/* static */
-bool wxSQLite3Database::SetTemporaryDirectory(const wxString& tempDirectory)
+static bool wxSQLite3CountMinMerge(wxSQLite3FunctionContext& ctx, int argIndex, wxSQLite3CountMinSketch& sketch)
 {
-  bool ok = false;
-#if defined(__WXMSW__)
-#if wxUSE_UNICODE
-  const wxChar* zValue = tempDirectory.wc_str();
-#else
-  const wxWCharBuffer zValue = tempDirectory.wc_str(wxConvLocal);
-#endif
-  int rc = sqlite3_win32_set_directory(SQLITE_WIN32_TEMP_DIRECTORY_TYPE, (void*) zValue);
-  ok = (rc == SQLITE_OK);
-#endif
-  return ok;
+  int len;
+  const unsigned char* data = ctx.GetBlob(argIndex, len);
+  if (!wxSQLite3CountMinSketch::IsValid(data, len))
+  {
+    ctx.SetResultError(gs_errCmsInvalid);
+    return false;
+  }
+  if (!sketch.IsEmpty() && (sketch.GetWidth() != wxSQLite3CountMinSketch::GetWidth(data) ||
+                            sketch.GetDepth() != wxSQLite3CountMinSketch::GetDepth(data)))
+  {
+    ctx.SetResultError(gs_errCmsIncompatible);
+    return false;
+  }
+  if (!sketch.Merge(data))
+  {
+    ctx.SetResultError(gs_errSketchNoMem);
+    return false;
+  }
+  return true;
 }
 
-/* static */
-bool wxSQLite3Database::Randomness(int n, wxMemoryBuffer& random)
+static bool wxSQLite3TDigestMerge(wxSQLite3FunctionContext& ctx, int argIndex, wxSQLite3TDigest*& digest)
 {
-  bool ok = false;
-  if (n > 0)
+  int len;
+  const unsigned char* data = ctx.GetBlob(argIndex, len);
+  if (!wxSQLite3TDigestIsValid(data, len))
   {
-    void* buffer = random.GetWriteBuf(n);
-    sqlite3_randomness(n, buffer);
-    random.UngetWriteBuf(n);
-    ok = true;
+    ctx.SetResultError(gs_errTDigestInvalid);
+    return false;
   }
-  return ok;
+  if (!wxSQLite3TDigestMergeData(digest, data))
+  {
+    ctx.SetResultError(gs_errSketchNoMem);
+    return false;
+  }
+  return true;
 }
 
-// ----------------------------------------------------------------------------
-// wxSQLite3FunctionContext: class providing the function context
-//                           for user defined functions
-// ----------------------------------------------------------------------------
+static bool wxSQLite3IsNumericArg(wxSQLite3FunctionContext& ctx, int argIndex)
+{
+  int argType = ctx.GetArgType(argIndex);
+  return argType == WXSQLITE_INTEGER || argType == WXSQLITE_FLOAT;
+}
 
-int wxSQLite3FunctionContext::GetArgCount() const
+wxSQLite3HyperLogLogAggregate::wxSQLite3HyperLogLogAggregate(bool mergeSketches)
+  : m_mergeSketches(mergeSketches)
 {
-  return m_argc;
 }
 
-int wxSQLite3FunctionContext::GetArgType(int argIndex) const
+wxSQLite3HyperLogLogAggregate::~wxSQLite3HyperLogLogAggregate()
 {
-  if (argIndex >= 0 && argIndex < m_argc)
-  {
-    return sqlite3_value_type((sqlite3_value*) m_argv[argIndex]);
-  }
-  else
-  {
-    return SQLITE_NULL;
-  }
 }
 
-bool wxSQLite3FunctionContext::IsNull(int argIndex) const
+void wxSQLite3HyperLogLogAggregate::Aggregate(wxSQLite3FunctionContext& ctx)
 {
-  if (argIndex >= 0 && argIndex < m_argc)
+  wxSQLite3HyperLogLog** sketch = (wxSQLite3HyperLogLog**) ctx.GetAggregateStruct(sizeof(wxSQLite3HyperLogLog*));
+  if (sketch == NULL)
   {
-    return sqlite3_value_type((sqlite3_value*) m_argv[argIndex]) == SQLITE_NULL;
+    ctx.SetResultError(gs_errSketchNoMem);
+    return;
   }
-  else
+  if (*sketch == NULL)
   {
-    return true;
+    *sketch = new wxSQLite3HyperLogLog();
   }
-}
-
-int wxSQLite3FunctionContext::GetInt(int argIndex, int nullValue) const
-{
-  if (argIndex >= 0 && argIndex < m_argc)
+  if (m_mergeSketches)
   {
-    if (!IsNull(argIndex))
+    if (!ctx.IsNull(0))
     {
-      return sqlite3_value_int((sqlite3_value*) m_argv[argIndex]);
+      wxSQLite3HyperLogLogMerge(ctx, 0, **sketch);
     }
-    else
+    return;
+  }
+  if ((*sketch)->IsEmpty())
+  {
+    int precision = gs_hllDefaultPrecision;
+    if (ctx.GetArgCount() > 1)
     {
-      return nullValue;
+      precision = ctx.GetInt(1);
+      if (ctx.GetArgType(1) != WXSQLITE_INTEGER || precision < gs_hllMinPrecision || precision > gs_hllMaxPrecision)
+      {
+        ctx.SetResultError(gs_errHllPrecision);
+        return;
+      }
+    }
+    if (!(*sketch)->Create(precision))
+    {
+      ctx.SetResultError(gs_errSketchNoMem);
+      return;
     }
   }
-  else
+  sqlite3_uint64 hash;
+  if (wxSQLite3SketchHashValue(ctx, 0, hash))
   {
-    return nullValue;
+    (*sketch)->Add(hash);
   }
 }
 
-wxLongLong wxSQLite3FunctionContext::GetInt64(int argIndex, wxLongLong nullValue) const
+void wxSQLite3HyperLogLogAggregate::Finalize(wxSQLite3FunctionContext& ctx)
 {
-  if (argIndex >= 0 && argIndex < m_argc)
+  wxSQLite3HyperLogLog** sketch = (wxSQLite3HyperLogLog**) ctx.GetAggregateStruct(sizeof(wxSQLite3HyperLogLog*));
+  if (sketch != NULL && *sketch != NULL && !(*sketch)->IsEmpty())
   {
-    if (!IsNull(argIndex))
-    {
-      return wxLongLong(sqlite3_value_int64((sqlite3_value*) m_argv[argIndex]));
-    }
-    else
-    {
-      return nullValue;
-    }
+    ctx.SetResult((*sketch)->GetData(), (*sketch)->GetSize());
   }
   else
   {
-    return nullValue;
+    ctx.SetResultNull();
+  }
+  if (sketch != NULL)
+  {
+    delete *sketch;
+    *sketch = NULL;
   }
 }
 
-double wxSQLite3FunctionContext::GetDouble(int argIndex, double nullValue) const
+wxSQLite3CountMinAggregate::wxSQLite3CountMinAggregate(bool mergeSketches)
+  : m_mergeSketches(mergeSketches)
 {
-  if (argIndex >= 0 && argIndex < m_argc)
+}
+
+wxSQLite3CountMinAggregate::~wxSQLite3CountMinAggregate()
+{
+}
+
+void wxSQLite3CountMinAggregate::Aggregate(wxSQLite3FunctionContext& ctx)
+{
+  wxSQLite3CountMinSketch** sketch = (wxSQLite3CountMinSketch**) ctx.GetAggregateStruct(sizeof(wxSQLite3CountMinSketch*));
+  if (sketch == NULL)
   {
-    if (!IsNull(argIndex))
+    ctx.SetResultError(gs_errSketchNoMem);
+    return;
+  }
+  if (*sketch == NULL)
+  {
+    *sketch = new wxSQLite3CountMinSketch();
+  }
+  if (m_mergeSketches)
+  {
+    if (!ctx.IsNull(0))
     {
-      return sqlite3_value_double((sqlite3_value*) m_argv[argIndex]);
+      wxSQLite3CountMinMerge(ctx, 0, **sketch);
     }
-    else
+    return;
+  }
+  if ((*sketch)->IsEmpty())
+  {
+    wxLongLong width = gs_cmsDefaultWidth;
+    wxLongLong depth = gs_cmsDefaultDepth;
+    if (ctx.GetArgCount() > 1)
     {
-      return nullValue;
+      width = ctx.GetInt64(1);
+      if (ctx.GetArgType(1) != WXSQLITE_INTEGER || width < 1 || width > (long) gs_cmsMaxWidth)
+      {
+        ctx.SetResultError(gs_errCmsDimensions);
+        return;
+      }
+    }
+    if (ctx.GetArgCount() > 2)
+    {
+      depth = ctx.GetInt64(2);
+      if (ctx.GetArgType(2) != WXSQLITE_INTEGER || depth < 1 || depth > (long) gs_cmsMaxDepth)
+      {
+        ctx.SetResultError(gs_errCmsDimensions);
+        return;
+      }
+    }
+    if (!(*sketch)->Create((wxUint32) width.GetLo(), (wxUint32) depth.GetLo()))
+    {
+      ctx.SetResultError(gs_errSketchNoMem);
+      return;
     }
   }
-  else
+  sqlite3_uint64 hash;
+  if (wxSQLite3SketchHashValue(ctx, 0, hash))
   {
-    return nullValue;
+    (*sketch)->Add(hash);
   }
 }
 
-wxString wxSQLite3FunctionContext::GetString(int argIndex, const wxString& nullValue) const
-{
-  if (argIndex >= 0 && argIndex < m_argc)
-  {
-    if (!IsNull(argIndex))
-    {
-      const char* localValue = (const char*) sqlite3_value_text((sqlite3_value*) m_argv[argIndex]);
-      return wxString::FromUTF8(localValue);
-    }
-    else
-    {
-      return nullValue;
-    }
+void wxSQLite3CountMinAggregate::Finalize(wxSQLite3FunctionContext& ctx)
+{
+  wxSQLite3CountMinSketch** sketch = (wxSQLite3CountMinSketch**) ctx.GetAggregateStruct(sizeof(wxSQLite3CountMinSketch*));
+  if (sketch != NULL && *sketch != NULL && !(*sketch)->IsEmpty())
+  {
+    wxMemoryBuffer buffer;
+    (*sketch)->Serialize(buffer);
+    ctx.SetResult(buffer);
   }
   else
   {
-    return nullValue;
+    ctx.SetResultNull();
+  }
+  if (sketch != NULL)
+  {
+    delete *sketch;
+    *sketch = NULL;
   }
 }
 
-const unsigned char* wxSQLite3FunctionContext::GetBlob(int argIndex, int& len) const
+wxSQLite3TDigestAggregate::wxSQLite3TDigestAggregate(bool mergeSketches)
+  : m_mergeSketches(mergeSketches)
 {
-  const unsigned char* buffer = NULL;
-  if (argIndex >= 0 && argIndex < m_argc)
+}
+
+wxSQLite3TDigestAggregate::~wxSQLite3TDigestAggregate()
+{
+}
+
+void wxSQLite3TDigestAggregate::Aggregate(wxSQLite3FunctionContext& ctx)
+{
+  wxSQLite3TDigest** digest = (wxSQLite3TDigest**) ctx.GetAggregateStruct(sizeof(wxSQLite3TDigest*));
+  if (digest == NULL)
   {
-    if (!IsNull(argIndex))
+    ctx.SetResultError(gs_errSketchNoMem);
+    return;
+  }
+  if (m_mergeSketches)
+  {
+    if (!ctx.IsNull(0))
     {
-      len = sqlite3_value_bytes((sqlite3_value*) m_argv[argIndex]);
-      buffer = (const unsigned char*) sqlite3_value_blob((sqlite3_value*) m_argv[argIndex]);
+      wxSQLite3TDigestMerge(ctx, 0, *digest);
     }
+    return;
   }
-  return buffer;
-}
-
-wxMemoryBuffer& wxSQLite3FunctionContext::GetBlob(int argIndex, wxMemoryBuffer& buffer) const
-{
-  if (argIndex >= 0 && argIndex < m_argc)
+  if (*digest == NULL)
   {
-    if (!IsNull(argIndex))
+    double compression = gs_tdigestDefaultCompression;
+    if (ctx.GetArgCount() > 1)
     {
-      int len = sqlite3_value_bytes((sqlite3_value*) m_argv[argIndex]);
-      const void* blob = sqlite3_value_blob((sqlite3_value*) m_argv[argIndex]);
-      buffer.AppendData((void*) blob, (size_t) len);
+      compression = ctx.GetDouble(1);
+      if (!wxSQLite3IsNumericArg(ctx, 1) || compression < 10.0 || compression > 10000.0)
+      {
+        ctx.SetResultError(gs_errTDigestCompression);
+        return;
+      }
     }
+    *digest = new wxSQLite3TDigest(compression);
   }
-  return buffer;
-}
-
-void* wxSQLite3FunctionContext::GetPointer(int argIndex, const wxString& pointerType) const
-{
-  void* pointer = NULL;
-#if SQLITE_VERSION_NUMBER >= 3020000
-  if (argIndex >= 0 && argIndex < m_argc)
+  if (wxSQLite3IsNumericArg(ctx, 0))
   {
-    if (!IsNull(argIndex))
+    if (!(*digest)->Add(ctx.GetDouble(0)))
     {
-      wxCharBuffer strPointerType = pointerType.ToUTF8();
-      const char* localPointerType = strPointerType;
-
-      pointer = sqlite3_value_pointer((sqlite3_value*) m_argv[argIndex], localPointerType);
+      ctx.SetResultError(gs_errSketchNoMem);
     }
   }
-#endif
-  return pointer;
 }
 
-void wxSQLite3FunctionContext::SetResult(int value)
+void wxSQLite3TDigestAggregate::Finalize(wxSQLite3FunctionContext& ctx)
 {
-  sqlite3_result_int((sqlite3_context*) m_ctx, value);
+  wxSQLite3TDigest** digest = (wxSQLite3TDigest**) ctx.GetAggregateStruct(sizeof(wxSQLite3TDigest*));
+  if (digest != NULL && *digest != NULL && (*digest)->GetTotalWeight() > 0.0)
+  {
+    wxMemoryBuffer buffer;
+    wxSQLite3TDigestSerialize(**digest, buffer);
+    ctx.SetResult(buffer);
+  }
+  else
+  {
+    ctx.SetResultNull();
+  }
+  if (digest != NULL)
+  {
+    delete *digest;
+    *digest = NULL;
+  }
 }
 
-void wxSQLite3FunctionContext::SetResult(wxLongLong value)
+wxSQLite3SketchFunction::wxSQLite3SketchFunction(wxSQLite3SketchFunctionType type)
+  : m_type(type)
 {
-  sqlite3_result_int64((sqlite3_context*) m_ctx, value.GetValue());
 }
 
-void wxSQLite3FunctionContext::SetResult(double value)
+wxSQLite3SketchFunction::~wxSQLite3SketchFunction()
 {
-  sqlite3_result_double((sqlite3_context*) m_ctx, value);
 }
 
-void wxSQLite3FunctionContext::SetResult(const wxString& value)
+void wxSQLite3SketchFunction::Execute(wxSQLite3FunctionContext& ctx)
 {
-  wxCharBuffer strValue = value.ToUTF8();
-  const char* localValue = strValue;
-  sqlite3_result_text((sqlite3_context*) m_ctx, localValue, -1, SQLITE_TRANSIENT);
-}
+  int argCount = ctx.GetArgCount();
+  int j;
+  switch (m_type)
+  {
+    case WXSQLITE_SKETCH_HLL_COUNT:
+      if (!ctx.IsNull(0))
+      {
+        int len;
+        const unsigned char* data = ctx.GetBlob(0, len);
+        if (!wxSQLite3HyperLogLog::IsValid(data, len))
+        {
+          ctx.SetResultError(gs_errHllInvalid);
+          return;
+        }
+        ctx.SetResult(wxLongLong((wxLongLong_t) (wxSQLite3HyperLogLog::Estimate(data) + 0.5)));
+        return;
+      }
+      break;
 
-void wxSQLite3FunctionContext::SetResult(unsigned char* value, int len)
-{
-  sqlite3_result_blob((sqlite3_context*) m_ctx, value, len, SQLITE_TRANSIENT);
-}
+    case WXSQLITE_SKETCH_HLL_MERGE:
+      {
+        wxSQLite3HyperLogLog sketch;
+        for (j = 0; j < argCount; ++j)
+        {
+          if (!ctx.IsNull(j) && !wxSQLite3HyperLogLogMerge(ctx, j, sketch))
+          {
+            return;
+          }
+        }
+        if (!sketch.IsEmpty())
+        {
+          ctx.SetResult(sketch.GetData(), sketch.GetSize());
+          return;
+        }
+      }
+      break;
 
-void wxSQLite3FunctionContext::SetResult(const wxMemoryBuffer& buffer)
-{
-  sqlite3_result_blob((sqlite3_context*) m_ctx, buffer.GetData(), (int) buffer.GetDataLen(), SQLITE_TRANSIENT);
+    case WXSQLITE_SKETCH_CMS_ESTIMATE:
+      if (!ctx.IsNull(0))
+      {
+        int len;
+        const unsigned char* data = ctx.GetBlob(0, len);
+        if (!wxSQLite3CountMinSketch::IsValid(data, len))
+        {
+          ctx.SetResultError(gs_errCmsInvalid);
+          return;
+        }
+        sqlite3_uint64 hash;
+        if (wxSQLite3SketchHashValue(ctx, 1, hash))
+        {
+          ctx.SetResult(wxLongLong((wxLongLong_t) wxSQLite3CountMinSketch::Estimate(data, hash)));
+          return;
+        }
+      }
+      break;
+
+    case WXSQLITE_SKETCH_CMS_MERGE:
+      {
+        wxSQLite3CountMinSketch sketch;
+        for (j = 0; j < argCount; ++j)
+        {
+          if (!ctx.IsNull(j) && !wxSQLite3CountMinMerge(ctx, j, sketch))
+          {
+            return;
+          }
+        }
+        if (!sketch.IsEmpty())
+        {
+          wxMemoryBuffer buffer;
+          sketch.Serialize(buffer);
+          ctx.SetResult(buffer);
+          return;
+        }
+      }
+      break;
+
+    case WXSQLITE_SKETCH_TDIGEST_QUANTILE:
+      if (!ctx.IsNull(0) && !ctx.IsNull(1))
+      {
+        double fraction = ctx.GetDouble(1);
+        if (!wxSQLite3IsNumericArg(ctx, 1) || fraction < 0.0 || fraction > 1.0)
+        {
+          ctx.SetResultError(wxS("fraction must be a number between 0.0 and 1.0"));
+          return;
+        }
+        wxSQLite3TDigest* digest = NULL;
+        bool ok = wxSQLite3TDigestMerge(ctx, 0, digest);
+        if (ok && digest->GetTotalWeight() > 0.0)
+        {
+          ctx.SetResult(digest->Quantile(fraction));
+        }
+        else if (ok)
+        {
+          ctx.SetResultNull();
+        }
+        delete digest;
+        return;
+      }
+      break;
+
+    case WXSQLITE_SKETCH_TDIGEST_MERGE:
+      {
+        wxSQLite3TDigest* digest = NULL;
+        for (j = 0; j < argCount; ++j)
+        {
+          if (!ctx.IsNull(j) && !wxSQLite3TDigestMerge(ctx, j, digest))
+          {
+            delete digest;
+            return;
+          }
+        }
+        if (digest != NULL && digest->GetTotalWeight() > 0.0)
+        {
+          wxMemoryBuffer buffer;
+          wxSQLite3TDigestSerialize(*digest, buffer);
+          ctx.SetResult(buffer);
+          delete digest;
+          return;
+        }
+        delete digest;
+      }
+      break;
+  }
+  ctx.SetResultNull();
 }
 
-void wxSQLite3FunctionContext::SetResult(void* pointer, const wxString& pointerType, void(*DeletePointer)(void*))
+wxSQLite3SketchFunctions::wxSQLite3SketchFunctions()
+  : m_hllSketch(false), m_hllUnion(true),
+    m_hllCount(WXSQLITE_SKETCH_HLL_COUNT), m_hllMerge(WXSQLITE_SKETCH_HLL_MERGE),
+    m_cmsSketch(false), m_cmsUnion(true),
+    m_cmsEstimate(WXSQLITE_SKETCH_CMS_ESTIMATE), m_cmsMerge(WXSQLITE_SKETCH_CMS_MERGE),
+    m_tdigestSketch(false), m_tdigestUnion(true),
+    m_tdigestQuantile(WXSQLITE_SKETCH_TDIGEST_QUANTILE), m_tdigestMerge(WXSQLITE_SKETCH_TDIGEST_MERGE)
 {
-#if SQLITE_VERSION_NUMBER >= 3020000
-  const char* localPointerType = MakePointerTypeCopy(pointerType);
-  sqlite3_result_pointer((sqlite3_context*) m_ctx, pointer, localPointerType, DeletePointer);
-#endif
 }
 
-void wxSQLite3FunctionContext::SetResultNull()
+wxSQLite3SketchFunctions::~wxSQLite3SketchFunctions()
 {
-  sqlite3_result_null((sqlite3_context*) m_ctx);
 }
 
-void wxSQLite3FunctionContext::SetResultZeroBlob(int blobSize)
+bool wxSQLite3SketchFunctions::Register(wxSQLite3Database& db)
 {
-#if SQLITE_VERSION_NUMBER >= 3004000
-  sqlite3_result_zeroblob((sqlite3_context*) m_ctx, blobSize);
-#endif
+  int flags = WXSQLITE_DETERMINISTIC | WXSQLITE_INNOCUOUS;
+  return db.CreateFunction(wxS("hll_sketch"), 1, m_hllSketch, flags) &&
+         db.CreateFunction(wxS("hll_sketch"), 2, m_hllSketch, flags) &&
+         db.CreateFunction(wxS("hll_union"), 1, m_hllUnion, flags) &&
+         db.CreateFunction(wxS("hll_count"), 1, m_hllCount, flags) &&
+         db.CreateFunction(wxS("hll_merge"), -1, m_hllMerge, flags) &&
+         db.CreateFunction(wxS("cms_sketch"), 1, m_cmsSketch, flags) &&
+         db.CreateFunction(wxS("cms_sketch"), 2, m_cmsSketch, flags) &&
+         db.CreateFunction(wxS("cms_sketch"), 3, m_cmsSketch, flags) &&
+         db.CreateFunction(wxS("cms_union"), 1, m_cmsUnion, flags) &&
+         db.CreateFunction(wxS("cms_estimate"), 2, m_cmsEstimate, flags) &&
+         db.CreateFunction(wxS("cms_merge"), -1, m_cmsMerge, flags) &&
+         db.CreateFunction(wxS("tdigest_sketch"), 1, m_tdigestSketch, flags) &&
+         db.CreateFunction(wxS("tdigest_sketch"), 2, m_tdigestSketch, flags) &&
+         db.CreateFunction(wxS("tdigest_union"), 1, m_tdigestUnion, flags) &&
+         db.CreateFunction(wxS("tdigest_quantile"), 2, m_tdigestQuantile, flags) &&
+         db.CreateFunction(wxS("tdigest_merge"), -1, m_tdigestMerge, flags);
 }
 
-void wxSQLite3FunctionContext::SetResultArg(int argIndex)
+// --- User defined function classes
+
+#if wxUSE_REGEX
+
+/// Compiled regular expression, shared by the cache and the statement auxiliary data (internal)
+class wxSQLite3RegExpEntry
 {
-  if (argIndex >= 0 && argIndex < m_argc) {
-    sqlite3_result_value((sqlite3_context*) m_ctx, (sqlite3_value*) m_argv[argIndex]);
-  } else {
-    sqlite3_result_null((sqlite3_context*) m_ctx);
+public:
+  wxSQLite3RegExpEntry(const char* pattern, int patternLen, int flags)
+    : m_refCount(1), m_patternLen(patternLen)
+  {
+    m_pattern = new char[patternLen+1];
+    memcpy(m_pattern, pattern, patternLen);
+    m_pattern[patternLen] = '\0';
+    m_regEx.Compile(wxString::FromUTF8(m_pattern), flags);
   }
-}
 
-void wxSQLite3FunctionContext::SetResultError(const wxString& errmsg)
-{
-  wxCharBuffer strErrmsg = errmsg.ToUTF8();
-  const char* localErrmsg = strErrmsg;
-  sqlite3_result_error((sqlite3_context*) m_ctx, localErrmsg, -1);
-}
+  ~wxSQLite3RegExpEntry()
+  {
+    delete [] m_pattern;
+  }
 
-int wxSQLite3FunctionContext::GetAggregateCount() const
-{
-  if (m_isAggregate)
+  bool IsSamePattern(const char* pattern, int patternLen) const
   {
-    return m_count;
+    return (patternLen == m_patternLen) && (memcmp(pattern, m_pattern, patternLen) == 0);
   }
-  else
+
+  void IncrementRefCount()
   {
-    return 0;
+    ++m_refCount;
   }
-}
 
-void* wxSQLite3FunctionContext::GetAggregateStruct(int len) const
-{
-  if (m_isAggregate)
+  void Release()
   {
-    return sqlite3_aggregate_context((sqlite3_context*) m_ctx, len);
+    if (--m_refCount == 0)
+    {
+      delete this;
+    }
   }
-  else
+
+  static void ReleaseAuxData(void* entry)
   {
-    return NULL;
+    ((wxSQLite3RegExpEntry*) entry)->Release();
   }
-}
 
-/* static */
-void wxSQLite3FunctionContext::ExecScalarFunction(void* ctx, int argc, void** argv)
-{
-  wxSQLite3FunctionContext context(ctx, false, argc, argv);
-  wxSQLite3ScalarFunction* func = (wxSQLite3ScalarFunction*) sqlite3_user_data((sqlite3_context*) ctx);
-  func->Execute(context);
-}
+  wxRegEx  m_regEx;      ///< Compiled regular expression
+  int      m_refCount;   ///< Reference count
+  char*    m_pattern;    ///< Pattern (utf-8)
+  int      m_patternLen; ///< Length of the pattern in bytes
+};
 
-/* static */
-void wxSQLite3FunctionContext::ExecAggregateStep(void* ctx, int argc, void** argv)
+/// Bounded cache of recently used compiled regular expressions (internal)
+class wxSQLite3RegExpCache
 {
-  wxSQLite3FunctionContext context(ctx, true, argc, argv);
-  wxSQLite3AggregateFunction* func = (wxSQLite3AggregateFunction*) sqlite3_user_data((sqlite3_context*) ctx);
-  func->m_count++;
-  context.m_count = func->m_count;
-  func->Aggregate(context);
-}
+public:
+  wxSQLite3RegExpCache(int capacity)
+    : m_count(0), m_capacity((capacity > 0) ? capacity : 1), m_text(NULL), m_textSize(0)
+  {
+    m_entries = new wxSQLite3RegExpEntry*[m_capacity];
+  }
 
-/* static */
-void wxSQLite3FunctionContext::ExecAggregateFinalize(void* ctx)
+  ~wxSQLite3RegExpCache()
+  {
+    for (int j = 0; j < m_count; ++j)
+    {
+      m_entries[j]->Release();
+    }
+    delete [] m_entries;
+    delete [] m_text;
+  }
+
+  // Find compiled regular expression; the most recently used entry is kept in front
+  wxSQLite3RegExpEntry* Find(const char* pattern, int patternLen, int flags)
+  {
+    wxSQLite3RegExpEntry* entry = NULL;
+    int j;
+    for (j = 0; j < m_count; ++j)
+    {
+      if (m_entries[j]->IsSamePattern(pattern, patternLen))
+      {
+        entry = m_entries[j];
+        break;
+      }
+    }
+    if (entry == NULL)
+    {
+      entry = new wxSQLite3RegExpEntry(pattern, patternLen, flags);
+      if (m_count == m_capacity)
+      {
+        // Evict the least recently used entry
+        m_entries[--m_count]->Release();
+      }
+      j = m_count++;
+    }
+    if (j > 0)
+    {
+      memmove(&m_entries[1], &m_entries[0], j * sizeof(wxSQLite3RegExpEntry*));
+    }
+    m_entries[0] = entry;
+    return entry;
+  }
+
+  // Decode utf-8 text into the reusable text buffer
+  const wxChar* Decode(const char* text, int textLen, size_t& decodedLen)
+  {
+    size_t needed = (size_t) textLen + 1;
+    if (needed > m_textSize)
+    {
+      delete [] m_text;
+      m_textSize = (needed < 256) ? 256 : needed;
+      m_text = new wxChar[m_textSize];
+    }
+    int j = 0;
+    while (j < textLen && ((unsigned char) text[j]) < 0x80)
+    {
+      m_text[j] = (wxChar) text[j];
+      ++j;
+    }
+    if (j == textLen)
+    {
+      // Plain ASCII text
+      decodedLen = (size_t) textLen;
+    }
+    else
+    {
+#if wxUSE_UNICODE
+      decodedLen = wxConvUTF8.ToWChar(m_text, m_textSize, text, (size_t) textLen);
+      if (decodedLen == wxCONV_FAILED)
+      {
+        return NULL;
+      }
+#else
+      wxString localText = wxString::FromUTF8(text, (size_t) textLen);
+      decodedLen = localText.Len();
+      if (decodedLen + 1 > m_textSize)
+      {
+        return NULL;
+      }
+      memcpy(m_text, localText.c_str(), decodedLen * sizeof(wxChar));
+#endif
+    }
+    m_text[decodedLen] = 0;
+    return m_text;
+  }
+
+private:
+  wxSQLite3RegExpEntry** m_entries;  ///< Cache entries, most recently used first
+  int                    m_count;    ///< Number of cache entries
+  int                    m_capacity; ///< Maximum number of cache entries
+  wxChar*                m_text;     ///< Buffer for decoded text
+  size_t                 m_textSize; ///< Size of the text buffer in characters
+};
+
+wxSQLite3RegExpOperator::wxSQLite3RegExpOperator(int flags, int cacheSize)
+  : m_flags(flags)
 {
-  wxSQLite3FunctionContext context(ctx, true, 0, NULL);
-  wxSQLite3AggregateFunction* func = (wxSQLite3AggregateFunction*) sqlite3_user_data((sqlite3_context*) ctx);
-  context.m_count = func->m_count;
-  func->Finalize(context);
+  m_cache = new wxSQLite3RegExpCache(cacheSize);
 }
 
-/* static */
-void wxSQLite3FunctionContext::ExecWindowStep(void* ctx, int argc, void** argv)
+wxSQLite3RegExpOperator::~wxSQLite3RegExpOperator()
 {
-  wxSQLite3FunctionContext context(ctx, true, argc, argv);
-  wxSQLite3WindowFunction* func = (wxSQLite3WindowFunction*) sqlite3_user_data((sqlite3_context*) ctx);
-  func->m_count++;
-  context.m_count = func->m_count;
-  func->Aggregate(context);
+  delete m_cache;
 }
 
-/* static */
-void wxSQLite3FunctionContext::ExecWindowFinalize(void* ctx)
+wxRegEx* wxSQLite3RegExpOperator::GetRegExp(wxSQLite3FunctionContext& ctx, int argIndex)
 {
-  wxSQLite3FunctionContext context(ctx, true, 0, NULL);
-  wxSQLite3WindowFunction* func = (wxSQLite3WindowFunction*) sqlite3_user_data((sqlite3_context*) ctx);
-  context.m_count = func->m_count;
-  func->Finalize(context);
+  wxSQLite3RegExpEntry* entry = (wxSQLite3RegExpEntry*) ctx.GetAuxData(argIndex);
+  if (entry == NULL)
+  {
+    int patternLen = 0;
+    const char* pattern = ctx.GetText(argIndex, patternLen);
+    if (pattern == NULL)
+    {
+      pattern = "";
+      patternLen = 0;
+    }
+    entry = m_cache->Find(pattern, patternLen, m_flags);
+    // The auxiliary data holds its own reference; SQLite releases it
+    // after the current row, unless the pattern is a constant
+    entry->IncrementRefCount();
+    ctx.SetAuxData(argIndex, entry, wxSQLite3RegExpEntry::ReleaseAuxData);
+  }
+  if (!entry->m_regEx.IsValid())
+  {
+    ctx.SetResultError(wxString(_("Regular expression invalid: '"))+wxString::FromUTF8(entry->m_pattern)+_T("'."));
+    return NULL;
+  }
+  return &entry->m_regEx;
 }
 
-/* static */
-void wxSQLite3FunctionContext::ExecWindowValue(void* ctx)
+const wxChar* wxSQLite3RegExpOperator::GetDecodedText(wxSQLite3FunctionContext& ctx, int argIndex, size_t& textLen)
 {
-  wxSQLite3FunctionContext context(ctx, true, 0, NULL);
-  wxSQLite3WindowFunction* func = (wxSQLite3WindowFunction*) sqlite3_user_data((sqlite3_context*) ctx);
-  context.m_count = func->m_count;
-  func->CurrentValue(context);
+  int len = 0;
+  const char* text = ctx.GetText(argIndex, len);
+  if (text == NULL)
+  {
+    text = "";
+    len = 0;
+  }
+  const wxChar* decodedText = m_cache->Decode(text, len, textLen);
+  if (decodedText == NULL)
+  {
+    ctx.SetResultError(_("REGEXP text argument is not valid UTF-8."));
+  }
+  return decodedText;
 }
 
-/* static */
-void wxSQLite3FunctionContext::ExecWindowInverse(void* ctx, int argc, void** argv)
+void wxSQLite3RegExpOperator::Execute(wxSQLite3FunctionContext& ctx)
 {
-  wxSQLite3FunctionContext context(ctx, true, argc, argv);
-  wxSQLite3WindowFunction* func = (wxSQLite3WindowFunction*) sqlite3_user_data((sqlite3_context*) ctx);
-  func->m_count--;
-  context.m_count = func->m_count;
-  func->Reverse(context);
+  int argCount = ctx.GetArgCount();
+  if (argCount == 2)
+  {
+    wxRegEx* regEx = GetRegExp(ctx, 0);
+    if (regEx != NULL)
+    {
+      size_t textLen = 0;
+      const wxChar* text = GetDecodedText(ctx, 1, textLen);
+      if (text != NULL)
+      {
+        int rc = (regEx->Matches(text, 0, textLen)) ? 1 : 0;
+        ctx.SetResult(rc);
+      }
+    }
+  }
+  else
+  {
+    ctx.SetResultError(wxString::Format(_("REGEXP called with wrong number of arguments: %d instead of 2."), argCount));
+  }
 }
 
-// 
-static int wxSQLite3FunctionContextExecAuthorizer(void* func, int type,
-                                           const char* arg1, const char* arg2,
-                                           const char* arg3, const char* arg4
-                                          )
+wxSQLite3RegExpReplaceFunction::wxSQLite3RegExpReplaceFunction(int flags, int cacheSize)
+  : wxSQLite3RegExpOperator(flags, cacheSize)
 {
-  wxString locArg1 = wxString::FromUTF8(arg1);
-  wxString locArg2 = wxString::FromUTF8(arg2);
-  wxString locArg3 = wxString::FromUTF8(arg3);
-  wxString locArg4 = wxString::FromUTF8(arg4);
-  wxString locArg5 = wxEmptyString;
-  wxSQLite3Authorizer::wxAuthorizationCode localType = (wxSQLite3Authorizer::wxAuthorizationCode) type;
-  return (int) ((wxSQLite3Authorizer*) func)->Authorize(localType, locArg1, locArg2, locArg3, locArg4, locArg5);
 }
 
-/* static */
-int wxSQLite3FunctionContext::ExecCommitHook(void* hook)
+wxSQLite3RegExpReplaceFunction::~wxSQLite3RegExpReplaceFunction()
 {
-  return (int) ((wxSQLite3Hook*) hook)->CommitCallback();
 }
 
-/* static */
-void wxSQLite3FunctionContext::ExecRollbackHook(void* hook)
+void wxSQLite3RegExpReplaceFunction::Execute(wxSQLite3FunctionContext& ctx)
 {
-  ((wxSQLite3Hook*) hook)->RollbackCallback();
+  int argCount = ctx.GetArgCount();
+  if (argCount == 3 || argCount == 4)
+  {
+    wxRegEx* regEx = GetRegExp(ctx, 1);
+    if (regEx != NULL)
+    {
+      if (!ctx.IsNull(0))
+      {
+        wxString text = ctx.GetString(0);
+        wxString replacement = ctx.GetString(2);
+        int maxMatches = (argCount == 4) ? ctx.GetInt(3) : 0;
+        if (maxMatches >= 0 && regEx->Replace(&text, replacement, (size_t) maxMatches) >= 0)
+        {
+          ctx.SetResult(text);
+        }
+        else
+        {
+          ctx.SetResultError(_("REGEXP_REPLACE failed."));
+        }
+      }
+      else
+      {
+        ctx.SetResultNull();
+      }
+    }
+  }
+  else
+  {
+    ctx.SetResultError(wxString::Format(_("REGEXP_REPLACE called with wrong number of arguments: %d instead of 3 or 4."), argCount));
+  }
 }
 
-/* static */
-void wxSQLite3FunctionContext::ExecUpdateHook(void* hook, int type,
-                                              const char* database, const char* table,
-                                              wxsqlite_int64 rowid)
+wxSQLite3RegExpExtractFunction::wxSQLite3RegExpExtractFunction(int flags, int cacheSize)
+  : wxSQLite3RegExpOperator(flags, cacheSize)
 {
-  wxString locDatabase = wxString::FromUTF8(database);
-  wxString locTable = wxString::FromUTF8(table);
-  wxSQLite3Hook::wxUpdateType locType = (wxSQLite3Hook::wxUpdateType) type;
-  wxLongLong locRowid = rowid;
-  ((wxSQLite3Hook*) hook)->UpdateCallback(locType, locDatabase, locTable, locRowid);
 }
 
-wxSQLite3FunctionContext::wxSQLite3FunctionContext(void* ctx, bool isAggregate, int argc, void** argv)
-  : m_ctx(ctx), m_isAggregate(isAggregate), m_count(0), m_argc(argc), m_argv(argv), m_ptrTypes(NULL)
+wxSQLite3RegExpExtractFunction::~wxSQLite3RegExpExtractFunction()
 {
 }
 
-wxSQLite3FunctionContext::~wxSQLite3FunctionContext()
+void wxSQLite3RegExpExtractFunction::Execute(wxSQLite3FunctionContext& ctx)
 {
-  if (m_ptrTypes != NULL)
+  int argCount = ctx.GetArgCount();
+  if (argCount == 2 || argCount == 3)
   {
-    size_t n = m_ptrTypes->GetCount();
-    for (size_t j = 0; j < n; ++j)
+    wxRegEx* regEx = GetRegExp(ctx, 1);
+    if (regEx != NULL)
     {
-      sqlite3_free((*m_ptrTypes)[j]);
+      size_t textLen = 0;
+      const wxChar* text = (!ctx.IsNull(0)) ? GetDecodedText(ctx, 0, textLen) : NULL;
+      if (text != NULL)
+      {
+        int group = (argCount == 3) ? ctx.GetInt(2) : 0;
+        size_t matchStart = 0;
+        size_t matchLen = 0;
+        if (group < 0)
+        {
+          ctx.SetResultError(wxString::Format(_("REGEXP_EXTRACT group index invalid: %d."), group));
+        }
+        else if (!regEx->Matches(text, 0, textLen))
+        {
+          ctx.SetResultNull();
+        }
+        else if ((size_t) group >= regEx->GetMatchCount())
+        {
+          ctx.SetResultError(wxString::Format(_("REGEXP_EXTRACT group index invalid: %d."), group));
+        }
+        else if (regEx->GetMatch(&matchStart, &matchLen, (size_t) group))
+        {
+          ctx.SetResult(wxString(text + matchStart, matchLen));
+        }
+        else
+        {
+          // The group did not participate in the match
+          ctx.SetResultNull();
+        }
+      }
+      else if (ctx.IsNull(0))
+      {
+        ctx.SetResultNull();
+      }
     }
-    delete m_ptrTypes;
   }
-}
-
-const char* wxSQLite3FunctionContext::MakePointerTypeCopy(const wxString& pointerType)
-{
-  // Allocate pointer type array if necessary
-  if (m_ptrTypes == NULL)
+  else
   {
-    m_ptrTypes = new wxArrayPtrVoid();
+    ctx.SetResultError(wxString::Format(_("REGEXP_EXTRACT called with wrong number of arguments: %d instead of 2 or 3."), argCount));
   }
-
-  // Convert pointer type to char*
-  return LocalMakePointerTypeCopy(*m_ptrTypes, pointerType);
 }
 
-/* static */
-int wxSQLite3FunctionContext::ExecWriteAheadLogHook(void* hook, void* dbHandle,
-                                                    const char* database, int numPages)
+
+// ----------------------------------------------------------------------------
+// wxSQLite3TrigramIndex: trigram index for REGEXP searches
+// ----------------------------------------------------------------------------
+
+static wxString TrigramQuoteIdentifier(const wxString& name)
 {
-  wxString locDatabase = wxString::FromUTF8(database);
-  wxUnusedVar(dbHandle);
-  return (int) ((wxSQLite3Hook*) hook)->WriteAheadLogCallback(locDatabase, numPages);
+  wxString quoted = name;
+  quoted.Replace(wxS("\""), wxS("\"\""));
+  return wxS("\"") + quoted + wxS("\"");
 }
 
-#if wxCHECK_VERSION(2,9,0)
-static const wxStringCharType* authCodeString[] =
-#else
-static const wxChar* authCodeString[] =
-#endif
-{ wxS("SQLITE_COPY"),              wxS("SQLITE_CREATE_INDEX"),      wxS("SQLITE_CREATE_TABLE"),
-  wxS("SQLITE_CREATE_TEMP_INDEX"), wxS("SQLITE_CREATE_TEMP_TABLE"), wxS("SQLITE_CREATE_TEMP_TRIGGER"),
-  wxS("SQLITE_CREATE_TEMP_VIEW"),  wxS("SQLITE_CREATE_TRIGGER"),    wxS("SQLITE_CREATE_VIEW"),
-  wxS("SQLITE_DELETE"),            wxS("SQLITE_DROP_INDEX"),        wxS("SQLITE_DROP_TABLE"),
-  wxS("SQLITE_DROP_TEMP_INDEX"),   wxS("SQLITE_DROP_TEMP_TABLE"),   wxS("SQLITE_DROP_TEMP_TRIGGER"),
-  wxS("SQLITE_DROP_TEMP_VIEW"),    wxS("SQLITE_DROP_TRIGGER"),      wxS("SQLITE_DROP_VIEW"),
-  wxS("SQLITE_INSERT"),            wxS("SQLITE_PRAGMA"),            wxS("SQLITE_READ"),
-  wxS("SQLITE_SELECT"),            wxS("SQLITE_TRANSACTION"),       wxS("SQLITE_UPDATE"),
-  wxS("SQLITE_ATTACH"),            wxS("SQLITE_DETACH"),            wxS("SQLITE_ALTER_TABLE"),
-  wxS("SQLITE_REINDEX"),           wxS("SQLITE_ANALYZE"),           wxS("SQLITE_CREATE_VTABLE"),
-  wxS("SQLITE_DROP_VTABLE"),       wxS("SQLITE_FUNCTION"),          wxS("SQLITE_SAVEPOINT"),
-  wxS("SQLITE_RECURSIVE")
-};
+static wxString TrigramQuoteLiteral(const wxString& value)
+{
+  wxString quoted = value;
+  quoted.Replace(wxS("'"), wxS("''"));
+  return wxS("'") + quoted + wxS("'");
+}
 
+static size_t TrigramCharCount(const wxString& run)
+{
+  // Count code points, not UTF-16 code units
+  size_t count = 0;
+  size_t len = run.Len();
+  size_t j;
+  for (j = 0; j < len; ++j)
+  {
+    wxChar c = run[j];
+    if ((unsigned long) c < 0xDC00 || (unsigned long) c > 0xDFFF)
+    {
+      ++count;
+    }
+  }
+  return count;
+}
 
-/* static */
-wxString wxSQLite3Authorizer::AuthorizationCodeToString(wxSQLite3Authorizer::wxAuthorizationCode type)
+static void TrigramFlushRun(wxString& run, wxArrayString& literals)
 {
-  wxString authString(wxS("Unknown"));
-  if (type >= SQLITE_COPY && type <= SQLITE_MAX_CODE)
+  // Substrings with less than 3 characters can not be looked up in a trigram index
+  if (TrigramCharCount(run) >= 3)
   {
-    authString = authCodeString[type];
+    literals.Add(run);
   }
-  return authString;
+  run.Clear();
 }
 
-// ----------------------------------------------------------------------------
-// wxSQLite3Transaction
-// ----------------------------------------------------------------------------
+static size_t TrigramSkipQuantifier(const wxString& pattern, size_t pos)
+{
+  size_t len = pattern.Len();
+  if (pos < len)
+  {
+    wxChar c = pattern[pos];
+    if (c == wxS('*') || c == wxS('+') || c == wxS('?'))
+    {
+      ++pos;
+    }
+    else if (c == wxS('{'))
+    {
+      while (pos < len && pattern[pos] != wxS('}'))
+      {
+        ++pos;
+      }
+      if (pos < len)
+      {
+        ++pos;
+      }
+    }
+    else
+    {
+      return pos;
+    }
+    // Non-greedy quantifier
+    if (pos < len && pattern[pos] == wxS('?'))
+    {
+      ++pos;
+    }
+  }
+  return pos;
+}
 
-wxSQLite3Transaction::wxSQLite3Transaction(wxSQLite3Database* db, wxSQLite3TransactionType transactionType)
+static size_t TrigramSkipBracket(const wxString& pattern, size_t pos)
 {
-  wxASSERT(db != NULL);
-  m_database = db;
-  try
+  // pos points to the opening bracket
+  size_t len = pattern.Len();
+  ++pos;
+  if (pos < len && pattern[pos] == wxS('^'))
   {
-    m_database->Begin(transactionType);
+    ++pos;
   }
-  catch (...)
+  // A closing bracket directly after the opening bracket is a literal
+  if (pos < len && pattern[pos] == wxS(']'))
   {
-    m_database = NULL; // Flag that transaction is not active
+    ++pos;
+  }
+  while (pos < len && pattern[pos] != wxS(']'))
+  {
+    if (pattern[pos] == wxS('[') && pos + 1 < len &&
+        (pattern[pos+1] == wxS(':') || pattern[pos+1] == wxS('.') || pattern[pos+1] == wxS('=')))
+    {
+      // Character class, collating element or equivalence class like [:alpha:]
+      wxChar delim = pattern[pos+1];
+      pos += 2;
+      while (pos + 1 < len && !(pattern[pos] == delim && pattern[pos+1] == wxS(']')))
+      {
+        ++pos;
+      }
+      pos += 2;
+    }
+    else
+    {
+      if (pattern[pos] == wxS('\\'))
+      {
+        ++pos;
+      }
+      ++pos;
+    }
   }
+  return (pos < len) ? pos + 1 : len;
 }
 
-wxSQLite3Transaction::~wxSQLite3Transaction()
+/* static */
+bool wxSQLite3TrigramIndex::ExtractLiterals(const wxString& pattern, wxArrayString& literals, int flags)
 {
-  if (m_database != NULL)
+  literals.Clear();
+  // Basic regular expressions and directors or embedded options are not analyzed
+  if ((flags & wxRE_BASIC) != 0 || pattern.StartsWith(wxS("***")) || pattern.StartsWith(wxS("(?")))
   {
-    try
+    return false;
+  }
+
+  wxString run;
+  size_t len = pattern.Len();
+  size_t pos = 0;
+  while (pos < len)
+  {
+    wxChar c = pattern[pos];
+    if (c == wxS('|'))
     {
-      m_database->Rollback();
+      // Alternation at top level: no literal is required for a match
+      literals.Clear();
+      return false;
     }
-    catch (...)
+    else if (c == wxS('('))
     {
-      // Intentionally do nothing
+      // Groups are skipped as a whole
+      TrigramFlushRun(run, literals);
+      int depth = 0;
+      while (pos < len)
+      {
+        c = pattern[pos];
+        if (c == wxS('\\'))
+        {
+          pos += 2;
+          continue;
+        }
+        if (c == wxS('['))
+        {
+          pos = TrigramSkipBracket(pattern, pos);
+          continue;
+        }
+        if (c == wxS('('))
+        {
+          ++depth;
+        }
+        else if (c == wxS(')') && --depth == 0)
+        {
+          ++pos;
+          break;
+        }
+        ++pos;
+      }
+      pos = TrigramSkipQuantifier(pattern, pos);
+    }
+    else if (c == wxS('['))
+    {
+      TrigramFlushRun(run, literals);
+      pos = TrigramSkipQuantifier(pattern, TrigramSkipBracket(pattern, pos));
+    }
+    else if (c == wxS('*') || c == wxS('?') || c == wxS('{'))
+    {
+      // The preceding character is optional
+      if (!run.IsEmpty())
+      {
+        run.RemoveLast();
+      }
+      TrigramFlushRun(run, literals);
+      pos = TrigramSkipQuantifier(pattern, pos);
+    }
+    else if (c == wxS('+'))
+    {
+      // The preceding character is required at least once
+      TrigramFlushRun(run, literals);
+      pos = TrigramSkipQuantifier(pattern, pos);
+    }
+    else if (c == wxS('.') || c == wxS('^') || c == wxS('$') || c == wxS(')'))
+    {
+      TrigramFlushRun(run, literals);
+      pos = TrigramSkipQuantifier(pattern, pos + 1);
+    }
+    else if (c == wxS('\\'))
+    {
+      if (pos + 1 >= len)
+      {
+        break;
+      }
+      wxChar e = pattern[pos+1];
+      pos += 2;
+      if (wxIsalnum(e))
+      {
+        // Class shorthands, constraints, back references and character entry escapes
+        // are not treated as literals; skip their operands, too
+        TrigramFlushRun(run, literals);
+        while (pos < len && wxIsalnum(pattern[pos]))
+        {
+          ++pos;
+        }
+        pos = TrigramSkipQuantifier(pattern, pos);
+      }
+      else
+      {
+        // Escaped punctuation stands for itself; a following quantifier
+        // is handled in the next iteration
+        run += e;
+      }
+    }
+    else
+    {
+      run += c;
+      ++pos;
     }
   }
+  TrigramFlushRun(run, literals);
+  return !literals.IsEmpty();
 }
 
-void wxSQLite3Transaction::Commit()
+/* static */
+wxString wxSQLite3TrigramIndex::GetMatchExpression(const wxString& pattern, int flags)
 {
-  m_database->Commit();
-  m_database = NULL;
+  wxString expression;
+  wxArrayString literals;
+  if (ExtractLiterals(pattern, literals, flags))
+  {
+    size_t j;
+    for (j = 0; j < literals.GetCount(); ++j)
+    {
+      wxString literal = literals[j];
+      literal.Replace(wxS("\""), wxS("\"\""));
+      if (j > 0)
+      {
+        expression += wxS(" AND ");
+      }
+      expression += wxS("\"") + literal + wxS("\"");
+    }
+  }
+  return expression;
 }
 
-void wxSQLite3Transaction::Rollback()
+wxSQLite3TrigramIndex::wxSQLite3TrigramIndex(wxSQLite3Database* db, const wxString& tableName, const wxString& columnName)
+  : m_database(db), m_tableName(tableName), m_columnName(columnName)
 {
-  m_database->Rollback();
-  m_database = NULL;
+  wxASSERT(db != NULL);
+  m_indexName = tableName + wxS("_") + columnName + wxS("_trigram");
 }
 
-// --- SQLite logging
-
-wxSQLite3Logger::wxSQLite3Logger()
-  : m_isActive(false)
+wxSQLite3TrigramIndex::~wxSQLite3TrigramIndex()
 {
 }
 
-wxSQLite3Logger::~wxSQLite3Logger()
+bool wxSQLite3TrigramIndex::Exists()
 {
+  wxSQLite3Statement stmt = m_database->PrepareStatement(wxS("SELECT count(*) FROM sqlite_master WHERE type='table' AND name=?"));
+  stmt.Bind(1, m_indexName);
+  wxSQLite3ResultSet resultSet = stmt.ExecuteQuery();
+  return resultSet.GetInt(0) > 0;
 }
 
-void
-wxSQLite3Logger::HandleLogMessage(int errorCode, const wxString& errorMessage)
+void wxSQLite3TrigramIndex::Create(bool populate)
 {
-  if (m_isActive)
+#if SQLITE_VERSION_NUMBER >= 3034000
+  wxString table = TrigramQuoteIdentifier(m_tableName);
+  wxString column = TrigramQuoteIdentifier(m_columnName);
+  wxString index = TrigramQuoteIdentifier(m_indexName);
+  wxString insertRow = wxS("INSERT INTO ") + index + wxS("(rowid, ") + column + wxS(") VALUES (new.rowid, new.") + column + wxS(");");
+  wxString deleteRow = wxS("INSERT INTO ") + index + wxS("(") + index + wxS(", rowid, ") + column +
+                       wxS(") VALUES ('delete', old.rowid, old.") + column + wxS(");");
+
+  wxString savepointName = wxS("wxsqlite3_trigram");
+  m_database->Savepoint(savepointName);
+  try
   {
-#if wxCHECK_VERSION(2,9,0)
-    wxLogInfo(wxS("SQLite3 %s (%d): %s"), wxSQLite3Exception::ErrorCodeAsString(errorCode), errorCode, errorMessage);
+    m_database->ExecuteUpdate(wxS("CREATE VIRTUAL TABLE ") + index + wxS(" USING fts5(") + column +
+                              wxS(", content=") + TrigramQuoteLiteral(m_tableName) + wxS(", tokenize='trigram')"));
+    m_database->ExecuteUpdate(wxS("CREATE TRIGGER ") + TrigramQuoteIdentifier(m_indexName + wxS("_ai")) +
+                              wxS(" AFTER INSERT ON ") + table + wxS(" BEGIN ") + insertRow + wxS(" END"));
+    m_database->ExecuteUpdate(wxS("CREATE TRIGGER ") + TrigramQuoteIdentifier(m_indexName + wxS("_ad")) +
+                              wxS(" AFTER DELETE ON ") + table + wxS(" BEGIN ") + deleteRow + wxS(" END"));
+    m_database->ExecuteUpdate(wxS("CREATE TRIGGER ") + TrigramQuoteIdentifier(m_indexName + wxS("_au")) +
+                              wxS(" AFTER UPDATE ON ") + table +
+                              wxS(" WHEN old.rowid IS NOT new.rowid OR old.") + column + wxS(" IS NOT new.") + column +
+                              wxS(" BEGIN ") + deleteRow + wxS(" ") + insertRow + wxS(" END"));
+    if (populate)
+    {
+      m_database->ExecuteUpdate(wxS("INSERT INTO ") + index + wxS("(") + index + wxS(") VALUES ('rebuild')"));
+    }
+  }
+  catch (...)
+  {
+    m_database->Rollback(savepointName);
+    m_database->ReleaseSavepoint(savepointName);
+    throw;
+  }
+  m_database->ReleaseSavepoint(savepointName);
 #else
-    wxLogInfo(wxS("SQLite3 %s (%d): %s"), wxSQLite3Exception::ErrorCodeAsString(errorCode).c_str(), errorCode, errorMessage.c_str());
+  wxUnusedVar(populate);
+  throw wxSQLite3Exception(WXSQLITE_ERROR, wxERRMSG_NOTRIGRAM);
 #endif
-  }
-}
-
-/* static */
-void
-wxSQLite3Logger::ExecLoggerHook(void* logger, int errorCode, const char* errorMsg)
-{
-  ((wxSQLite3Logger*) logger)->HandleLogMessage(errorCode, wxString::FromUTF8(errorMsg));
 }
 
-// --- User defined function classes
-
-#if wxUSE_REGEX
-
-wxSQLite3RegExpOperator::wxSQLite3RegExpOperator(int flags) : m_flags(flags)
+void wxSQLite3TrigramIndex::Rebuild()
 {
+  wxString index = TrigramQuoteIdentifier(m_indexName);
+  m_database->ExecuteUpdate(wxS("INSERT INTO ") + index + wxS("(") + index + wxS(") VALUES ('rebuild')"));
 }
 
-wxSQLite3RegExpOperator::~wxSQLite3RegExpOperator()
+void wxSQLite3TrigramIndex::Drop()
 {
+  wxString savepointName = wxS("wxsqlite3_trigram");
+  m_database->Savepoint(savepointName);
+  try
+  {
+    m_database->ExecuteUpdate(wxS("DROP TRIGGER IF EXISTS ") + TrigramQuoteIdentifier(m_indexName + wxS("_ai")));
+    m_database->ExecuteUpdate(wxS("DROP TRIGGER IF EXISTS ") + TrigramQuoteIdentifier(m_indexName + wxS("_ad")));
+    m_database->ExecuteUpdate(wxS("DROP TRIGGER IF EXISTS ") + TrigramQuoteIdentifier(m_indexName + wxS("_au")));
+    m_database->ExecuteUpdate(wxS("DROP TABLE IF EXISTS ") + TrigramQuoteIdentifier(m_indexName));
+  }
+  catch (...)
+  {
+    m_database->Rollback(savepointName);
+    m_database->ReleaseSavepoint(savepointName);
+    throw;
+  }
+  m_database->ReleaseSavepoint(savepointName);
 }
 
-void wxSQLite3RegExpOperator::Execute(wxSQLite3FunctionContext& ctx)
+wxString wxSQLite3TrigramIndex::GetSearchSQL(const wxString& pattern, const wxString& resultColumns, int flags) const
 {
-  int argCount = ctx.GetArgCount();
-  if (argCount == 2)
+  wxString sql = wxS("SELECT ") + resultColumns + wxS(" FROM ") + TrigramQuoteIdentifier(m_tableName);
+  if (!GetMatchExpression(pattern, flags).IsEmpty())
   {
-    wxString exprStr = ctx.GetString(0);
-    wxString textStr = ctx.GetString(1);
-    if (!m_exprStr.IsSameAs(exprStr))
-    {
-      m_exprStr = exprStr;
-      m_regEx.Compile(m_exprStr, m_flags);
-    }
-    if (m_regEx.IsValid())
-    {
-      int rc = (m_regEx.Matches(textStr)) ? 1 : 0;
-      ctx.SetResult(rc);
-    }
-    else
-    {
-      ctx.SetResultError(wxString(_("Regular expression invalid: '"))+exprStr+_T("'."));
-    }
+    wxString index = TrigramQuoteIdentifier(m_indexName);
+    sql += wxS(" WHERE rowid IN (SELECT rowid FROM ") + index + wxS(" WHERE ") + index + wxS(" MATCH ?2) AND");
   }
   else
   {
-    ctx.SetResultError(wxString::Format(_("REGEXP called with wrong number of arguments: %d instead of 2."), argCount));
+    sql += wxS(" WHERE");
+  }
+  sql += wxS(" ") + TrigramQuoteIdentifier(m_columnName) + wxS(" REGEXP ?1");
+  return sql;
+}
+
+wxSQLite3ResultSet wxSQLite3TrigramIndex::Search(const wxString& pattern, const wxString& resultColumns, int flags)
+{
+  wxString matchExpression = GetMatchExpression(pattern, flags);
+  wxSQLite3Statement stmt = m_database->PrepareStatement(GetSearchSQL(pattern, resultColumns, flags));
+  stmt.Bind(1, pattern);
+  if (!matchExpression.IsEmpty())
+  {
+    stmt.Bind(2, matchExpression);
   }
+  return stmt.ExecuteQuery();
 }
 
 #endif
@@ -5425,6 +16102,7 @@ wxSQLite3IntegerCollection::Bind(int n, int* integerCollection)
 wxSQLite3IntegerCollection
 wxSQLite3Database::CreateIntegerCollection(const wxString& collectionName)
 {
+  WXSQLITE3_PROFILE();
 #if WXSQLITE3_USE_NAMED_COLLECTIONS
   CheckDatabase();
   int rc = SQLITE_OK;
@@ -5523,6 +16201,7 @@ wxSQLite3StringCollection::Bind(const wxArrayString& stringCollection)
 wxSQLite3StringCollection
 wxSQLite3Database::CreateStringCollection(const wxString& collectionName)
 {
+  WXSQLITE3_PROFILE();
 #if WXSQLITE3_USE_NAMED_COLLECTIONS
   CheckDatabase();
   int rc = SQLITE_OK;